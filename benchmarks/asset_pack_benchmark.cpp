@@ -0,0 +1,157 @@
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-07
+ *
+ * Time to load a set of assets into a staging-sized buffer:
+ *  - loose:       one file per asset, opened and read with std::ifstream
+ *  - pack raw:    uncompressed pack, memcpy out of the mapping
+ *  - pack lz4:    LZ4 pack, chunks decompressed on the calling thread
+ *  - pack lz4 mt: LZ4 pack, chunks decompressed on the job system
+ *
+ * The files are written once and then read warm from the OS file cache, so
+ * this measures per-file overhead and decompression, not the disk: on a cold
+ * cache the smaller LZ4 pack also reads fewer bytes.
+ *
+ * Usage: asset_pack_benchmark [--files N] [--size BYTES] [--repeat N] [--directory PATH]
+ */
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <random>
+#include <chrono>
+#include <filesystem>
+#include <algorithm>
+#include <functional>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+
+#include "../src/core/assets/asset_pack.hpp"
+#include "../src/core/jobs/job_system.hpp"
+
+using namespace VulkanGameEngine;
+
+static double measure(uint32_t repeat, const std::function<void()>& workload)
+{
+    workload();
+
+    std::vector<double> samples;
+    for (uint32_t i = 0; i < repeat; i++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        workload();
+        samples.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(samples.begin(), samples.end());
+
+    return samples[samples.size() / 2];
+}
+
+/**
+ * Half of the assets look like texture data (smooth gradients with sparse
+ * noise), the other half are incompressible.
+ */
+static std::vector<uint8_t> make_asset(std::mt19937& random, size_t size, bool compressible)
+{
+    std::vector<uint8_t> data(size);
+    for (size_t i = 0; i < size; i++)
+        data[i] = compressible
+            ? static_cast<uint8_t>((i / 256) * 7 + (random() % 64 == 0))
+            : static_cast<uint8_t>(random());
+    return data;
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t file_count = 2048;
+    size_t file_size = 64 * 1024;
+    uint32_t repeat = 10;
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "vge_asset_pack_benchmark";
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--files") && i + 1 < argc)
+            file_count = std::max(1u, static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10)));
+        else if (!strcmp(argv[i], "--size") && i + 1 < argc)
+            file_size = std::max<size_t>(1, strtoull(argv[++i], nullptr, 10));
+        else if (!strcmp(argv[i], "--repeat") && i + 1 < argc)
+            repeat = std::max(1u, static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10)));
+        else if (!strcmp(argv[i], "--directory") && i + 1 < argc)
+            directory = argv[++i];
+    }
+
+    std::filesystem::create_directories(directory / "loose");
+
+    std::mt19937 random(42);
+    std::vector<std::string> names;
+    Assets::AssetPackWriter raw_writer;
+    Assets::AssetPackWriter lz4_writer;
+
+    for (uint32_t i = 0; i < file_count; i++)
+    {
+        std::string name = "asset_" + std::to_string(i) + ".bin";
+        std::vector<uint8_t> data = make_asset(random, file_size, i % 2 == 0);
+
+        std::ofstream output(directory / "loose" / name, std::ios::binary | std::ios::trunc);
+        output.write(reinterpret_cast<const char*>(data.data()), data.size());
+
+        names.push_back(name);
+        raw_writer.add(name, data);
+        lz4_writer.add(name, std::move(data));
+    }
+
+    std::string raw_path = (directory / "raw.vgep").string();
+    std::string lz4_path = (directory / "lz4.vgep").string();
+    raw_writer.write(raw_path, Assets::Codec::None);
+    lz4_writer.write(lz4_path, Assets::Codec::LZ4);
+
+    const auto& lz4_statistics = lz4_writer.get_statistics();
+    printf("%u files of %zu bytes, lz4 pack is %.1f%% of the input, median of %u runs\n\n",
+        file_count, file_size, 100.0 * lz4_statistics.stored_bytes / lz4_statistics.bytes, repeat);
+
+    // Stands in for the staging ring.
+    std::vector<uint8_t> staging(file_size);
+
+    Jobs::JobSystem jobs;
+    jobs.init();
+
+    auto load_pack = [&](const std::string& path, Jobs::JobSystem* job_system) {
+        Assets::AssetPack pack;
+        pack.open(path);
+        for (const auto& name : names)
+        {
+            const Assets::PackEntry* entry = pack.find(name);
+            pack.read(*entry, staging.data(), job_system);
+        }
+    };
+
+    double loose_ms = measure(repeat, [&]() {
+        for (const auto& name : names)
+        {
+            std::ifstream input(directory / "loose" / name, std::ios::binary | std::ios::ate);
+            size_t size = static_cast<size_t>(input.tellg());
+            input.seekg(0);
+            input.read(reinterpret_cast<char*>(staging.data()), std::min(size, staging.size()));
+        }
+    });
+    double raw_ms = measure(repeat, [&]() { load_pack(raw_path, nullptr); });
+    double lz4_ms = measure(repeat, [&]() { load_pack(lz4_path, nullptr); });
+    double lz4_mt_ms = measure(repeat, [&]() { load_pack(lz4_path, &jobs); });
+
+    double total_mib = static_cast<double>(file_count) * file_size / (1024.0 * 1024.0);
+
+    printf("method            ms      MiB/s   vs loose\n");
+    printf("loose       %8.3f  %9.1f   %6.2fx\n", loose_ms, total_mib / (loose_ms / 1000.0), 1.0);
+    printf("pack raw    %8.3f  %9.1f   %6.2fx\n", raw_ms, total_mib / (raw_ms / 1000.0), loose_ms / raw_ms);
+    printf("pack lz4    %8.3f  %9.1f   %6.2fx\n", lz4_ms, total_mib / (lz4_ms / 1000.0), loose_ms / lz4_ms);
+    printf("pack lz4 mt %8.3f  %9.1f   %6.2fx  (%u workers)\n", lz4_mt_ms, total_mib / (lz4_mt_ms / 1000.0), loose_ms / lz4_mt_ms, jobs.get_worker_count());
+
+    jobs.cleanup();
+
+    std::error_code error;
+    std::filesystem::remove_all(directory, error);
+
+    return 0;
+}
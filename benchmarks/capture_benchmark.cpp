@@ -0,0 +1,125 @@
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-15
+ *
+ * Times what the frame capture writer thread does per frame: PNG encoding,
+ * Y4M conversion, and decoding plus comparing a golden image. The writer
+ * keeps up with the frame loop as long as one of these stays under the frame
+ * time; beyond that the readback ring fills and frames are dropped.
+ *
+ * Usage: capture_benchmark [--width N] [--height N] [--runs N] [--output DIR]
+ */
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+
+#include "../src/core/utils/image_file.hpp"
+
+using namespace VulkanGameEngine;
+
+template <typename F>
+static double median_ms(uint32_t runs, F function)
+{
+    std::vector<double> times;
+    for (uint32_t run = 0; run < runs; run++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        function(run);
+        times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+/**
+ * Gradients and a moving checkerboard, so consecutive frames differ everywhere.
+ */
+static void render_frame(Utils::ImageData& image, uint32_t frame)
+{
+    for (uint32_t y = 0; y < image.height; y++)
+        for (uint32_t x = 0; x < image.width; x++)
+        {
+            uint8_t* pixel = image.pixels.data() + (static_cast<size_t>(y) * image.width + x) * 4;
+            pixel[0] = static_cast<uint8_t>(x * 255 / image.width);
+            pixel[1] = static_cast<uint8_t>(y * 255 / image.height);
+            pixel[2] = ((((x + frame) >> 4) ^ (y >> 4)) & 1) ? 224 : 32;
+            pixel[3] = 255;
+        }
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t width = 1920;
+    uint32_t height = 1080;
+    uint32_t runs = 31;
+    std::string output = ".";
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--width") && i + 1 < argc)
+            width = std::max(1u, static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10)));
+        else if (!strcmp(argv[i], "--height") && i + 1 < argc)
+            height = std::max(1u, static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10)));
+        else if (!strcmp(argv[i], "--runs") && i + 1 < argc)
+            runs = std::max(1u, static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10)));
+        else if (!strcmp(argv[i], "--output") && i + 1 < argc)
+            output = argv[++i];
+    }
+
+    Utils::ImageData frame;
+    frame.resize(width, height);
+    render_frame(frame, 0);
+
+    double frame_mib = frame.pixels.size() / (1024.0 * 1024.0);
+    printf("Frame: %ux%u RGBA8, %.2f MiB, median of %u runs\n\n", width, height, frame_mib, runs);
+    printf("%-24s %10s %10s %10s\n", "stage", "ms/frame", "frames/s", "MiB/s");
+
+    auto report = [&](const char* stage, double ms) {
+        printf("%-24s %10.3f %10.1f %10.1f\n", stage, ms, 1000.0 / ms, frame_mib * 1000.0 / ms);
+    };
+
+    std::vector<uint8_t> png;
+    report("encode png", median_ms(runs, [&](uint32_t) { png = Utils::encode_png(frame); }));
+
+    std::string png_path = output + "/capture_benchmark.png";
+    report("write png", median_ms(runs, [&](uint32_t) { Utils::write_png(png_path, frame); }));
+
+    Utils::Y4mWriter y4m;
+    std::string y4m_path = output + "/capture_benchmark.y4m";
+    if (!y4m.open(y4m_path, width, height, 60))
+    {
+        std::cerr << "\nFailed to open " << y4m_path << ".";
+        return 1;
+    }
+    report("write y4m", median_ms(runs, [&](uint32_t) { y4m.write_frame(frame); }));
+    y4m.close();
+
+    Utils::ImageData decoded;
+    report("decode png", median_ms(runs, [&](uint32_t) { Utils::decode_png(png.data(), png.size(), decoded); }));
+
+    Utils::ImageData next;
+    next.resize(width, height);
+    render_frame(next, 1);
+
+    Utils::ImageComparison comparison;
+    report("compare", median_ms(runs, [&](uint32_t) { comparison = Utils::compare_images(frame, next, 2); }));
+
+    // The round trip must be exact, or goldens written by captures would never match.
+    Utils::ImageComparison round_trip = Utils::compare_images(frame, decoded, 0);
+    printf("\nPNG: %.2f MiB, round trip %s; next frame differs in %.1f%% of the pixels (PSNR %.2f dB)\n",
+        png.size() / (1024.0 * 1024.0),
+        round_trip.mismatched_pixels == 0 && !round_trip.size_mismatch ? "exact" : "FAILED",
+        comparison.mismatch_fraction() * 100.0,
+        comparison.psnr);
+
+    std::remove(png_path.c_str());
+    std::remove(y4m_path.c_str());
+
+    return round_trip.mismatched_pixels == 0 && !round_trip.size_mismatch ? 0 : 1;
+}
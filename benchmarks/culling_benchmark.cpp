@@ -0,0 +1,185 @@
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-10
+ *
+ * Frustum culls random bounding spheres with every cull kernel the CPU supports
+ * and reports objects culled per millisecond, on one core and across the job
+ * system, plus the cost of writing the visible objects' indirect draws.
+ * Every kernel's visible set is checked against the scalar one.
+ *
+ * Usage: culling_benchmark [--objects N] [--runs N] [--threads N]
+ */
+
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+
+#include "../src/core/graphics/visibility.hpp"
+#include "../src/core/jobs/job_system.hpp"
+
+using namespace VulkanGameEngine;
+
+/**
+ * out = a * b, column-major 4x4.
+ */
+static void multiply(float* out, const float* a, const float* b)
+{
+    for (int column = 0; column < 4; column++)
+        for (int row = 0; row < 4; row++)
+        {
+            float sum = 0.0f;
+            for (int k = 0; k < 4; k++)
+                sum += a[k * 4 + row] * b[column * 4 + k];
+            out[column * 4 + row] = sum;
+        }
+}
+
+/**
+ * Camera at the origin turned by yaw around +Y, right handed, looking down -Z
+ * at yaw 0, with a Vulkan (0..1 depth, y down) perspective projection.
+ */
+static Graphics::Frustum make_frustum(float yaw, float fov_y, float aspect, float near_plane, float far_plane)
+{
+    float c = std::cos(yaw);
+    float s = std::sin(yaw);
+    // Inverse of the camera rotation.
+    float view[16] = {
+        c, 0.0f, s, 0.0f,
+        0.0f, 1.0f, 0.0f, 0.0f,
+        -s, 0.0f, c, 0.0f,
+        0.0f, 0.0f, 0.0f, 1.0f};
+
+    float f = 1.0f / std::tan(fov_y * 0.5f);
+    float projection[16] = {};
+    projection[0] = f / aspect;
+    projection[5] = -f;
+    projection[10] = far_plane / (near_plane - far_plane);
+    projection[11] = -1.0f;
+    projection[14] = near_plane * far_plane / (near_plane - far_plane);
+
+    float view_projection[16];
+    multiply(view_projection, projection, view);
+    return Graphics::extract_frustum(view_projection);
+}
+
+template <typename F>
+static double median_ms(uint32_t runs, F function)
+{
+    std::vector<double> times;
+    for (uint32_t run = 0; run < runs; run++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        function(run);
+        times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t object_count = 100000;
+    uint32_t runs = 51;
+    uint32_t threads = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--objects") && i + 1 < argc)
+            object_count = std::max(1u, static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10)));
+        else if (!strcmp(argv[i], "--runs") && i + 1 < argc)
+            runs = std::max(1u, static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10)));
+        else if (!strcmp(argv[i], "--threads") && i + 1 < argc)
+            threads = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+    }
+
+    // Objects scattered in a 1000 unit cube around the camera, 0.5 to 5 units across.
+    Graphics::VisibilitySystem visibility;
+    std::mt19937 random(11);
+    std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+    std::uniform_real_distribution<float> size(0.5f, 5.0f);
+    for (uint32_t i = 0; i < object_count; i++)
+    {
+        float center[3] = {position(random), position(random), position(random)};
+        VkDrawIndexedIndirectCommand draw{};
+        draw.indexCount = 36 + (i % 8) * 3;
+        draw.instanceCount = 1;
+        draw.firstIndex = (i % 16) * 1024;
+        draw.firstInstance = i;
+        visibility.add(center, size(random), draw);
+    }
+
+    // A camera turning a full circle over the runs.
+    std::vector<Graphics::Frustum> frustums;
+    for (uint32_t run = 0; run < runs; run++)
+        frustums.push_back(make_frustum(6.2831853f * run / runs, 1.0471976f, 16.0f / 9.0f, 0.1f, 400.0f));
+
+    Jobs::JobSystem jobs;
+    jobs.init(threads);
+    uint32_t cores = jobs.get_worker_count();
+
+    std::vector<std::vector<uint32_t>> reference(runs);
+    visibility.set_kernel(Graphics::CullKernel::Scalar);
+    for (uint32_t run = 0; run < runs; run++)
+        visibility.cull(frustums[run], reference[run]);
+
+    size_t visible_total = 0;
+    for (const auto& visible : reference)
+        visible_total += visible.size();
+
+    printf("%u objects, %.1f%% visible on average, %u runs, %u worker threads\n\n",
+        object_count,
+        100.0 * visible_total / (static_cast<double>(object_count) * runs),
+        runs,
+        cores);
+    printf("kernel   cull ms  objects/ms  +draws ms   parallel ms  objects/ms/core\n");
+
+    std::vector<VkDrawIndexedIndirectCommand> commands(object_count);
+    std::vector<uint32_t> visible;
+    int status = 0;
+
+    for (Graphics::CullKernel kernel : {Graphics::CullKernel::Scalar, Graphics::CullKernel::SSE, Graphics::CullKernel::AVX2})
+    {
+        if (!Graphics::VisibilitySystem::is_kernel_supported(kernel))
+        {
+            printf("%-7s  not supported on this CPU or build\n", Graphics::cull_kernel_name(kernel));
+            continue;
+        }
+        visibility.set_kernel(kernel);
+
+        for (uint32_t run = 0; run < runs; run++)
+        {
+            visibility.cull(frustums[run], visible);
+            std::vector<uint32_t> parallel;
+            visibility.cull(frustums[run], parallel, &jobs);
+            if (visible != reference[run] || parallel != reference[run])
+            {
+                printf("%-7s  visible set differs from the scalar kernel\n", Graphics::cull_kernel_name(kernel));
+                status = 1;
+                break;
+            }
+        }
+
+        double cull_ms = median_ms(runs, [&](uint32_t run) { visibility.cull(frustums[run], visible); });
+        double draws_ms = median_ms(runs, [&](uint32_t run) {
+            visibility.build_draws(frustums[run], commands.data(), object_count, visible);
+        });
+        double parallel_ms = median_ms(runs, [&](uint32_t run) { visibility.cull(frustums[run], visible, &jobs); });
+
+        printf("%-7s %8.3f %11.0f %10.3f %13.3f %16.0f\n",
+            Graphics::cull_kernel_name(kernel),
+            cull_ms,
+            object_count / cull_ms,
+            draws_ms,
+            parallel_ms,
+            object_count / parallel_ms / cores);
+    }
+
+    jobs.cleanup();
+    return status;
+}
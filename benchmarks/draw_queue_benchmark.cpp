@@ -0,0 +1,175 @@
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-13
+ *
+ * Sorts draw keys of a synthetic scene (materials spread over a few dozen
+ * pipelines, meshes drawn in random order) with std::sort and the radix sort,
+ * serially and across the job system, and counts the state binds the draw
+ * queue records before and after sorting. Nothing is submitted to a device.
+ *
+ * Usage: draw_queue_benchmark [--draws N] [--runs N] [--threads N]
+ */
+
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+
+#include "../src/core/graphics/draw_queue.hpp"
+#include "../src/core/jobs/job_system.hpp"
+
+using namespace VulkanGameEngine;
+
+template <typename F>
+static double median_ms(uint32_t runs, F function)
+{
+    std::vector<double> times;
+    for (uint32_t run = 0; run < runs; run++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        function();
+        times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+/**
+ * Distinct non-null handles: the queue only compares them.
+ */
+template <typename Handle>
+static Handle fake_handle(uint64_t value)
+{
+    return (Handle)(uintptr_t)(value + 1);
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<uint32_t> draw_counts = {10000, 100000, 1000000};
+    uint32_t runs = 11;
+    uint32_t threads = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--draws") && i + 1 < argc)
+            draw_counts = {std::max(1u, static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10)))};
+        else if (!strcmp(argv[i], "--runs") && i + 1 < argc)
+            runs = std::max(1u, static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10)));
+        else if (!strcmp(argv[i], "--threads") && i + 1 < argc)
+            threads = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+    }
+
+    const uint32_t pipeline_count = 32;
+    const uint32_t pass_set_count = 8;
+    const uint32_t material_count = 1024;
+    const uint32_t mesh_count = 512;
+
+    Jobs::JobSystem jobs;
+    jobs.init(threads);
+
+    // Every material belongs to one pipeline and one pass set; a draw is a
+    // random material on a random mesh at a random depth, 10% of them blended.
+    Graphics::DrawQueue queue;
+    std::vector<uint32_t> pipelines, pass_sets, materials;
+    for (uint32_t i = 0; i < pipeline_count; i++)
+        pipelines.push_back(queue.add_pipeline(fake_handle<VkPipeline>(i), fake_handle<VkPipelineLayout>(i % 4)));
+    for (uint32_t i = 0; i < pass_set_count; i++)
+        pass_sets.push_back(queue.add_descriptor_set(fake_handle<VkDescriptorSet>(i)));
+    for (uint32_t i = 0; i < material_count; i++)
+        materials.push_back(queue.add_descriptor_set(fake_handle<VkDescriptorSet>(pass_set_count + i)));
+    queue.set_layer_order(1, Graphics::DepthOrder::BackToFront);
+
+    printf("%u pipelines, %u materials, %u meshes, %u runs, %u worker threads\n\n",
+        pipeline_count, material_count, mesh_count, runs, jobs.get_worker_count());
+    printf("   draws  std::sort ms  radix ms  parallel ms   binds unsorted  binds sorted  eliminated\n");
+
+    int status = 0;
+    for (uint32_t draw_count : draw_counts)
+    {
+        std::mt19937 random(draw_count);
+        std::vector<Graphics::DrawState> states(draw_count);
+        std::vector<Graphics::DrawCommand> commands(draw_count);
+        for (uint32_t i = 0; i < draw_count; i++)
+        {
+            uint32_t material = random() % material_count;
+            uint32_t mesh = random() % mesh_count;
+
+            states[i].layer = random() % 10 == 0 ? 1 : 0;
+            states[i].pipeline = pipelines[material % pipeline_count];
+            states[i].descriptor = pass_sets[material % pass_set_count];
+            states[i].material = materials[material];
+            states[i].depth = static_cast<float>(random() % 100000) / 100000.0f;
+
+            commands[i].vertex_buffer = fake_handle<VkBuffer>(mesh);
+            commands[i].index_buffer = fake_handle<VkBuffer>(mesh_count + mesh);
+            commands[i].count = 36;
+        }
+
+        queue.begin_frame();
+        for (uint32_t i = 0; i < draw_count; i++)
+            queue.submit(states[i], commands[i]);
+        queue.record(VK_NULL_HANDLE);
+        Graphics::DrawQueue::Statistics unsorted = queue.get_frame_statistics();
+        queue.sort(&jobs);
+        queue.record(VK_NULL_HANDLE);
+        Graphics::DrawQueue::Statistics sorted = queue.get_frame_statistics();
+
+        std::vector<Graphics::SortEntry> keys(draw_count);
+        for (uint32_t i = 0; i < draw_count; i++)
+            keys[i] = Graphics::SortEntry{Graphics::make_draw_key(states[i], states[i].layer ? Graphics::DepthOrder::BackToFront : Graphics::DepthOrder::FrontToBack), i, 0};
+
+        std::vector<Graphics::SortEntry> reference = keys;
+        std::stable_sort(reference.begin(), reference.end(), [](const Graphics::SortEntry& a, const Graphics::SortEntry& b) { return a.key < b.key; });
+
+        std::vector<Graphics::SortEntry> entries, scratch;
+        auto check = [&](const char* name) {
+            for (uint32_t i = 0; i < draw_count; i++)
+                if (entries[i].key != reference[i].key || entries[i].value != reference[i].value)
+                {
+                    printf("%s radix sort differs from std::stable_sort at %u\n", name, i);
+                    status = 1;
+                    return;
+                }
+        };
+        entries = keys;
+        Graphics::radix_sort(entries, scratch);
+        check("serial");
+        entries = keys;
+        Graphics::radix_sort(entries, scratch, &jobs);
+        check("parallel");
+
+        double std_sort_ms = median_ms(runs, [&]() {
+            entries = keys;
+            std::sort(entries.begin(), entries.end(), [](const Graphics::SortEntry& a, const Graphics::SortEntry& b) { return a.key < b.key; });
+        });
+        double copy_ms = median_ms(runs, [&]() { entries = keys; });
+        double radix_ms = median_ms(runs, [&]() {
+            entries = keys;
+            Graphics::radix_sort(entries, scratch);
+        });
+        double parallel_ms = median_ms(runs, [&]() {
+            entries = keys;
+            Graphics::radix_sort(entries, scratch, &jobs);
+        });
+
+        auto binds = [](const Graphics::DrawQueue::Statistics& statistics) {
+            return statistics.pipeline_binds + statistics.descriptor_binds + statistics.vertex_buffer_binds + statistics.index_buffer_binds;
+        };
+
+        printf("%8u %13.3f %9.3f %12.3f %16llu %13llu %10.1f%%\n",
+            draw_count,
+            std::max(0.0, std_sort_ms - copy_ms),
+            std::max(0.0, radix_ms - copy_ms),
+            std::max(0.0, parallel_ms - copy_ms),
+            static_cast<unsigned long long>(binds(unsorted)),
+            static_cast<unsigned long long>(binds(sorted)),
+            100.0 * sorted.binds_eliminated / (binds(sorted) + sorted.binds_eliminated));
+    }
+
+    jobs.cleanup();
+    return status;
+}
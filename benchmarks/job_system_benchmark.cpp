@@ -0,0 +1,177 @@
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-01
+ *
+ * Scaling of the job system with 1 to N workers on three workloads:
+ *  - uniform:  parallel_for over evenly priced items (transforming points)
+ *  - skewed:   parallel_for where the cost of an item grows with its index,
+ *              which only balances out through stealing
+ *  - tiny:     many independent jobs doing almost nothing, measuring the
+ *              scheduling overhead itself
+ *
+ * Usage: job_system_benchmark [--items N] [--jobs N] [--repeat N] [--max-workers N]
+ */
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+
+#include "../src/core/jobs/job_system.hpp"
+
+using namespace VulkanGameEngine;
+
+struct Result
+{
+    double ms;
+    uint64_t steals;
+    uint64_t steal_attempts;
+    double idle_fraction;
+};
+
+static Result measure(Jobs::JobSystem& jobs, uint32_t repeat, const std::function<void()>& workload)
+{
+    // Warm up: wakes the workers and grows the deques.
+    workload();
+    jobs.reset_statistics();
+
+    std::vector<double> samples;
+    for (uint32_t i = 0; i < repeat; i++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        workload();
+        samples.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(samples.begin(), samples.end());
+
+    Result result{samples[samples.size() / 2], 0, 0, 0.0};
+
+    double busy_ms = 0.0;
+    double idle_ms = 0.0;
+    for (const auto& worker : jobs.get_statistics())
+    {
+        result.steals += worker.steals;
+        result.steal_attempts += worker.steal_attempts;
+        busy_ms += worker.busy_ms;
+        idle_ms += worker.idle_ms;
+    }
+    if (busy_ms + idle_ms > 0.0)
+        result.idle_fraction = idle_ms / (busy_ms + idle_ms);
+
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t item_count = 1u << 22;
+    uint32_t job_count = 100000;
+    uint32_t repeat = 10;
+    uint32_t max_workers = std::max(1u, std::thread::hardware_concurrency());
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--items") && i + 1 < argc)
+            item_count = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        else if (!strcmp(argv[i], "--jobs") && i + 1 < argc)
+            job_count = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        else if (!strcmp(argv[i], "--repeat") && i + 1 < argc)
+            repeat = std::max(1u, static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10)));
+        else if (!strcmp(argv[i], "--max-workers") && i + 1 < argc)
+            max_workers = std::max(1u, static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10)));
+    }
+
+    std::vector<float> input(item_count * 4);
+    std::vector<float> output(item_count * 4);
+    for (size_t i = 0; i < input.size(); i++)
+        input[i] = static_cast<float>(i % 1024) * 0.001f;
+
+    const float matrix[16] = {
+        0.9f, 0.1f, 0.0f, 0.0f,
+        -0.1f, 0.9f, 0.0f, 0.0f,
+        0.0f, 0.0f, 1.0f, 0.0f,
+        1.0f, 2.0f, 3.0f, 1.0f,
+    };
+
+    auto transform = [&](uint32_t first, uint32_t last) {
+        for (uint32_t i = first; i < last; i++)
+        {
+            const float* p = &input[i * 4];
+            float* q = &output[i * 4];
+            for (int row = 0; row < 4; row++)
+                q[row] = matrix[row] * p[0] + matrix[4 + row] * p[1] + matrix[8 + row] * p[2] + matrix[12 + row] * p[3];
+        }
+    };
+
+    // Item i costs 1 + i * 512 / skewed_count iterations: the last chunks are far heavier than the first.
+    uint32_t skewed_count = std::max(1u, item_count / 64);
+    auto skewed = [&](uint32_t first, uint32_t last) {
+        for (uint32_t i = first; i < last; i++)
+        {
+            float value = input[(i * 4) % input.size()];
+            uint32_t iterations = 1 + static_cast<uint32_t>(static_cast<uint64_t>(i) * 512 / skewed_count);
+            for (uint32_t k = 0; k < iterations; k++)
+                value = std::sqrt(value * value + 1.0f);
+            output[(i * 4) % output.size()] = value;
+        }
+    };
+
+    printf("%u items (uniform), %u items (skewed), %u tiny jobs, median of %u runs\n\n",
+        item_count, skewed_count, job_count, repeat);
+    printf("workload  workers        ms   speedup      steals   attempts   idle\n");
+
+    const char* names[3] = {"uniform", "skewed", "tiny"};
+    double baseline_ms[3] = {0.0, 0.0, 0.0};
+
+    for (uint32_t workers = 1; workers <= max_workers; workers = workers < max_workers ? std::min(workers * 2, max_workers) : workers + 1)
+    {
+        Jobs::JobSystem jobs;
+        jobs.init(workers);
+
+        std::function<void()> workloads[3] = {
+            [&]() { jobs.parallel_for(item_count, 1024, transform); },
+            [&]() { jobs.parallel_for(skewed_count, 64, skewed); },
+            [&]() {
+                Jobs::JobCounter counter;
+                for (uint32_t i = 0; i < job_count; i++)
+                    jobs.run([&output, i]() { output[i % output.size()] += 1.0f; }, &counter);
+                jobs.wait(counter);
+            },
+        };
+
+        for (int w = 0; w < 3; w++)
+        {
+            Result result = measure(jobs, repeat, workloads[w]);
+            if (workers == 1)
+                baseline_ms[w] = result.ms;
+
+            printf("%-8s  %7u  %8.3f  %7.2fx  %10llu %10llu  %4.1f%%\n",
+                names[w], workers, result.ms, baseline_ms[w] / result.ms,
+                static_cast<unsigned long long>(result.steals),
+                static_cast<unsigned long long>(result.steal_attempts),
+                result.idle_fraction * 100.0);
+        }
+
+        if (workers == max_workers)
+        {
+            printf("\n");
+            jobs.print_statistics(std::cout);
+        }
+
+        jobs.cleanup();
+    }
+
+    // Keeps the optimizer from discarding the work.
+    double checksum = 0.0;
+    for (size_t i = 0; i < output.size(); i += 4096)
+        checksum += output[i];
+    printf("\nchecksum %.3f\n", checksum);
+
+    return 0;
+}
@@ -0,0 +1,146 @@
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-12
+ *
+ * Runs every batch math kernel with the scalar, 128-bit SIMD and AVX2
+ * implementations the build and CPU support, and reports millions of
+ * elements per second. Results are checked against the scalar kernels.
+ *
+ * Usage: math_benchmark [--count N] [--runs N]
+ */
+
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+
+#include "../src/core/math/batch.hpp"
+
+using namespace VulkanGameEngine;
+
+template <typename F>
+static double median_ms(uint32_t runs, F function)
+{
+    std::vector<double> times;
+    for (uint32_t run = 0; run < runs; run++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        function();
+        times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+static bool close(const float* a, const float* b, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        if (std::fabs(a[i] - b[i]) > 1e-4f * (1.0f + std::fabs(b[i])))
+            return false;
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t count = 16384;
+    uint32_t runs = 51;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--count") && i + 1 < argc)
+            count = std::max(1u, static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10)));
+        else if (!strcmp(argv[i], "--runs") && i + 1 < argc)
+            runs = std::max(1u, static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10)));
+    }
+
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> value(-10.0f, 10.0f);
+    std::uniform_real_distribution<float> size(0.1f, 4.0f);
+
+    std::vector<Math::Mat4> models(count), locals(count), matrices(count), reference(count);
+    std::vector<Math::Aabb> boxes(count), out_boxes(count), reference_boxes(count);
+    std::vector<Math::Sphere> spheres(count), out_spheres(count), reference_spheres(count);
+    std::vector<Math::Vec3> points(count * 4);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        Math::Quat rotation = Math::normalize(Math::Quat(value(random), value(random), value(random), value(random)));
+        models[i] = Math::Mat4::compose(Math::Vec3(value(random), value(random), value(random)), rotation, Math::Vec3(size(random), size(random), size(random)));
+        locals[i] = Math::Mat4::compose(Math::Vec3(value(random), value(random), value(random)), Math::Quat(), Math::Vec3(size(random)));
+        Math::Vec3 center(value(random), value(random), value(random));
+        Math::Vec3 extent(size(random), size(random), size(random));
+        boxes[i] = Math::Aabb{center - extent, center + extent};
+        spheres[i].center = center;
+        spheres[i].radius = size(random);
+    }
+    for (Math::Vec3& point : points)
+        point = Math::Vec3(value(random), value(random), value(random));
+    Math::Mat4 view_projection = Math::Mat4::compose(Math::Vec3(1.0f, 2.0f, 3.0f), Math::normalize(Math::Quat(0.1f, 0.2f, 0.3f, 0.9f)), Math::Vec3(1.0f));
+    view_projection.m[3] = 0.01f;
+    view_projection.m[11] = -1.0f;
+
+    printf("%u elements (%zu points), %u runs, 128-bit SIMD is %s\n\n", count, points.size(), runs, Math::float4_isa());
+    printf("kernel   mat*mat   vp*mat     aabbs   spheres  points aabb  points sphere   (M elements/s)\n");
+
+    int status = 0;
+    for (Math::BatchKernel kernel : {Math::BatchKernel::Scalar, Math::BatchKernel::SIMD, Math::BatchKernel::AVX2})
+    {
+        if (!Math::is_batch_kernel_supported(kernel))
+        {
+            printf("%-7s  not supported on this CPU or build\n", Math::batch_kernel_name(kernel));
+            continue;
+        }
+
+        // Correctness first, against the scalar kernels.
+        bool valid = true;
+        Math::multiply_matrices(models.data(), locals.data(), reference.data(), count, Math::BatchKernel::Scalar);
+        Math::multiply_matrices(models.data(), locals.data(), matrices.data(), count, kernel);
+        valid &= close(matrices[0].m, reference[0].m, count * 16);
+        Math::multiply_matrices(view_projection, models.data(), reference.data(), count, Math::BatchKernel::Scalar);
+        Math::multiply_matrices(view_projection, models.data(), matrices.data(), count, kernel);
+        valid &= close(matrices[0].m, reference[0].m, count * 16);
+        Math::transform_aabbs(models.data(), boxes.data(), reference_boxes.data(), count, Math::BatchKernel::Scalar);
+        Math::transform_aabbs(models.data(), boxes.data(), out_boxes.data(), count, kernel);
+        valid &= close(out_boxes[0].min.data(), reference_boxes[0].min.data(), count * 6);
+        Math::transform_spheres(models.data(), spheres.data(), reference_spheres.data(), count, Math::BatchKernel::Scalar);
+        Math::transform_spheres(models.data(), spheres.data(), out_spheres.data(), count, kernel);
+        valid &= close(out_spheres[0].center.data(), reference_spheres[0].center.data(), count * 4);
+        Math::Sphere bounds = Math::compute_bounding_sphere(points.data(), points.size(), kernel);
+        Math::Sphere reference_bounds = Math::compute_bounding_sphere(points.data(), points.size(), Math::BatchKernel::Scalar);
+        valid &= close(&bounds.center.x, &reference_bounds.center.x, 4);
+        if (!valid)
+        {
+            printf("%-7s  results differ from the scalar kernels\n", Math::batch_kernel_name(kernel));
+            status = 1;
+            continue;
+        }
+
+        Math::Aabb box;
+        double multiply_ms = median_ms(runs, [&]() { Math::multiply_matrices(models.data(), locals.data(), matrices.data(), count, kernel); });
+        double view_projection_ms = median_ms(runs, [&]() { Math::multiply_matrices(view_projection, models.data(), matrices.data(), count, kernel); });
+        double boxes_ms = median_ms(runs, [&]() { Math::transform_aabbs(models.data(), boxes.data(), out_boxes.data(), count, kernel); });
+        double spheres_ms = median_ms(runs, [&]() { Math::transform_spheres(models.data(), spheres.data(), out_spheres.data(), count, kernel); });
+        double points_box_ms = median_ms(runs, [&]() { box = Math::compute_aabb(points.data(), points.size(), kernel); });
+        double points_sphere_ms = median_ms(runs, [&]() { bounds = Math::compute_bounding_sphere(points.data(), points.size(), kernel); });
+
+        // Keeps the point results alive.
+        if (box.min.x > box.max.x || bounds.radius < 0.0f)
+            status = 1;
+
+        printf("%-7s %8.1f %8.1f %9.1f %9.1f %12.1f %14.1f\n",
+            Math::batch_kernel_name(kernel),
+            count / multiply_ms / 1000.0,
+            count / view_projection_ms / 1000.0,
+            count / boxes_ms / 1000.0,
+            count / spheres_ms / 1000.0,
+            points.size() / points_box_ms / 1000.0,
+            points.size() / points_sphere_ms / 1000.0);
+    }
+
+    return status;
+}
@@ -0,0 +1,236 @@
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-09-26
+ *
+ * CPU microbenchmark of the buddy sub-allocator against a first-fit free list,
+ * on a churn of resource sizes resembling a level streaming in and out.
+ *
+ * Usage: memory_allocator_benchmark [--iterations N] [--seed S]
+ */
+
+#include <iostream>
+#include <vector>
+#include <map>
+#include <random>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+
+#include "../src/core/memory/buddy.hpp"
+
+using namespace VulkanGameEngine::Memory;
+
+static const uint64_t block_size = 256ull << 20;
+static const uint64_t min_block_size = 256;
+
+/**
+ * Reference first-fit allocator over an ordered free list.
+ */
+class FirstFitAllocator
+{
+    private:
+        std::map<uint64_t, uint64_t> free_ranges;
+        std::map<uint64_t, uint64_t> allocations;
+        uint64_t size;
+
+    public:
+        FirstFitAllocator(uint64_t size) : size(size) { free_ranges[0] = size; }
+
+        uint64_t allocate(uint64_t request, uint64_t alignment)
+        {
+            for (auto it = free_ranges.begin(); it != free_ranges.end(); ++it)
+            {
+                uint64_t offset = (it->first + alignment - 1) / alignment * alignment;
+                uint64_t end = it->first + it->second;
+                if (offset + request > end)
+                    continue;
+
+                uint64_t start = it->first;
+                free_ranges.erase(it);
+                if (offset > start)
+                    free_ranges[start] = offset - start;
+                if (offset + request < end)
+                    free_ranges[offset + request] = end - offset - request;
+
+                allocations[offset] = request;
+                return offset;
+            }
+            return BuddyAllocator::invalid_offset;
+        }
+
+        void free(uint64_t offset)
+        {
+            auto found = allocations.find(offset);
+            uint64_t end = offset + found->second;
+            allocations.erase(found);
+
+            auto next = free_ranges.lower_bound(offset);
+            if (next != free_ranges.end() && next->first == end)
+            {
+                end += next->second;
+                next = free_ranges.erase(next);
+            }
+            if (next != free_ranges.begin())
+            {
+                auto previous = std::prev(next);
+                if (previous->first + previous->second == offset)
+                {
+                    offset = previous->first;
+                    free_ranges.erase(previous);
+                }
+            }
+            free_ranges[offset] = end - offset;
+        }
+
+        uint64_t largest_free_block() const
+        {
+            uint64_t largest = 0;
+            for (const auto& range : free_ranges)
+                largest = std::max(largest, range.second);
+            return largest;
+        }
+
+        uint64_t free_bytes() const
+        {
+            uint64_t total = 0;
+            for (const auto& range : free_ranges)
+                total += range.second;
+            return total;
+        }
+};
+
+struct Request
+{
+    uint64_t size;
+    uint64_t alignment;
+};
+
+/**
+ * 70% small uniform / staging buffers, 25% meshes, 5% textures.
+ */
+static Request random_request(std::mt19937_64& rng)
+{
+    uint32_t roll = rng() % 100;
+    if (roll < 70)
+        return {256 + rng() % (64 << 10), 256};
+    if (roll < 95)
+        return {(64 << 10) + rng() % (4 << 20), 16};
+    return {(256 << 10) + rng() % (16 << 20), 4096};
+}
+
+struct Result
+{
+    double allocate_ns;
+    double free_ns;
+    uint64_t failures;
+    uint64_t used_bytes;
+    uint64_t requested_bytes;
+    double fragmentation;
+};
+
+template <typename Allocator, typename UsedBytes, typename Fragmentation>
+static Result run(Allocator& allocator, uint32_t iterations, uint64_t seed, UsedBytes used_bytes, Fragmentation fragmentation)
+{
+    std::mt19937_64 rng(seed);
+    std::vector<std::pair<uint64_t, uint64_t>> live;
+
+    double allocate_ns = 0.0, free_ns = 0.0;
+    uint64_t allocations = 0, frees = 0, failures = 0, requested = 0;
+
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        // Grow towards ~75% occupancy, then churn.
+        bool do_free = !live.empty() && (rng() % 100) < (used_bytes() > block_size * 3 / 4 ? 60u : 35u);
+
+        if (do_free)
+        {
+            size_t index = rng() % live.size();
+            uint64_t offset = live[index].first;
+            requested -= live[index].second;
+            live[index] = live.back();
+            live.pop_back();
+
+            auto start = std::chrono::steady_clock::now();
+            allocator.free(offset);
+            free_ns += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            frees++;
+        }
+        else
+        {
+            Request request = random_request(rng);
+
+            auto start = std::chrono::steady_clock::now();
+            uint64_t offset = allocator.allocate(request.size, request.alignment);
+            allocate_ns += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            allocations++;
+
+            if (offset == BuddyAllocator::invalid_offset)
+                failures++;
+            else
+            {
+                live.push_back({offset, request.size});
+                requested += request.size;
+            }
+        }
+    }
+
+    Result result;
+    result.allocate_ns = allocations ? allocate_ns / allocations : 0.0;
+    result.free_ns = frees ? free_ns / frees : 0.0;
+    result.failures = failures;
+    result.used_bytes = used_bytes();
+    result.requested_bytes = requested;
+    result.fragmentation = fragmentation();
+
+    for (const auto& allocation : live)
+        allocator.free(allocation.first);
+
+    return result;
+}
+
+static void print_result(const char* name, const Result& result)
+{
+    printf("%-10s alloc %8.1f ns  free %8.1f ns  failures %6llu  used %7.1f MiB  requested %7.1f MiB  fragmentation %5.1f%%\n",
+        name, result.allocate_ns, result.free_ns,
+        static_cast<unsigned long long>(result.failures),
+        result.used_bytes / 1048576.0, result.requested_bytes / 1048576.0,
+        result.fragmentation * 100.0);
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t iterations = 200000;
+    uint64_t seed = 42;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--iterations") && i + 1 < argc)
+            iterations = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        else if (!strcmp(argv[i], "--seed") && i + 1 < argc)
+            seed = strtoull(argv[++i], nullptr, 10);
+    }
+
+    printf("%u operations on a %llu MiB block, seed %llu\n",
+        iterations, static_cast<unsigned long long>(block_size >> 20), static_cast<unsigned long long>(seed));
+
+    BuddyAllocator buddy(block_size, min_block_size);
+    Result buddy_result = run(buddy, iterations, seed,
+        [&]() { return buddy.get_used_bytes(); },
+        [&]() {
+            BuddyAllocator::Statistics statistics = buddy.get_statistics();
+            return statistics.free_bytes ? 1.0 - static_cast<double>(statistics.largest_free_block) / statistics.free_bytes : 0.0;
+        });
+    print_result("buddy", buddy_result);
+
+    FirstFitAllocator first_fit(block_size);
+    Result first_fit_result = run(first_fit, iterations, seed,
+        [&]() { return block_size - first_fit.free_bytes(); },
+        [&]() {
+            uint64_t free_bytes = first_fit.free_bytes();
+            return free_bytes ? 1.0 - static_cast<double>(first_fit.largest_free_block()) / free_bytes : 0.0;
+        });
+    print_result("first-fit", first_fit_result);
+
+    return 0;
+}
@@ -0,0 +1,329 @@
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-09-30
+ *
+ * Command recording time with 1 to N job system workers on a headless device.
+ * Each draw is stand-in work that needs no shaders: dynamic viewport and
+ * scissor, a push constant block and a small vkCmdClearAttachments.
+ *
+ * Usage: parallel_recording_benchmark [--draws N] [--frames N] [--max-threads N] [--device NAME]
+ */
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+
+#include "../src/core/utils/platform.hpp"
+#include "../src/core/utils/device_selector.hpp"
+#include "../src/core/utils/image.hpp"
+#include "../src/core/graphics/parallel_recorder.hpp"
+
+using namespace VulkanGameEngine;
+
+struct Context
+{
+    VkInstance instance = VK_NULL_HANDLE;
+    VkPhysicalDevice physical_device = VK_NULL_HANDLE;
+    VkDevice device = VK_NULL_HANDLE;
+    VkQueue queue = VK_NULL_HANDLE;
+    uint32_t queue_family = 0;
+
+    VkExtent2D extent = {256, 256};
+    VkImage color_image = VK_NULL_HANDLE;
+    VkDeviceMemory color_memory = VK_NULL_HANDLE;
+    VkImageView color_view = VK_NULL_HANDLE;
+    VkRenderPass render_pass = VK_NULL_HANDLE;
+    VkFramebuffer framebuffer = VK_NULL_HANDLE;
+    VkPipelineLayout pipeline_layout = VK_NULL_HANDLE;
+
+    VkCommandPool primary_pool = VK_NULL_HANDLE;
+    VkCommandBuffer primary = VK_NULL_HANDLE;
+    VkFence fence = VK_NULL_HANDLE;
+};
+
+static void create_context(Context& context, const std::string& preferred_device)
+{
+    VkApplicationInfo app_info{};
+    app_info.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+    app_info.pApplicationName = "parallel_recording_benchmark";
+    app_info.apiVersion = VK_API_VERSION_1_1;
+
+    VkInstanceCreateInfo instance_info{};
+    instance_info.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+    instance_info.pApplicationInfo = &app_info;
+
+    if (vkCreateInstance(&instance_info, nullptr, &context.instance) != VK_SUCCESS)
+        throw std::runtime_error("\nFailed to create instance.");
+
+    Utils::DeviceRequirements requirements;
+    requirements.require_surface = false;
+    requirements.allow_cpu = true;
+
+    VkSurfaceKHR surface = VK_NULL_HANDLE;
+    Utils::DeviceCandidate selected = Utils::select_physical_device(context.instance, surface, requirements, preferred_device);
+    printf("\nDevice: %s\n", selected.name.c_str());
+
+    context.physical_device = selected.device;
+    context.queue_family = selected.queues.graphics_family.value();
+
+    float priority = 1.0f;
+    VkDeviceQueueCreateInfo queue_info{};
+    queue_info.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+    queue_info.queueFamilyIndex = context.queue_family;
+    queue_info.queueCount = 1;
+    queue_info.pQueuePriorities = &priority;
+
+    VkPhysicalDeviceFeatures features{};
+    VkDeviceCreateInfo device_info{};
+    device_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    device_info.queueCreateInfoCount = 1;
+    device_info.pQueueCreateInfos = &queue_info;
+    device_info.pEnabledFeatures = &features;
+
+    if (vkCreateDevice(context.physical_device, &device_info, nullptr, &context.device) != VK_SUCCESS)
+        throw std::runtime_error("\nFailed to create logical device.");
+    vkGetDeviceQueue(context.device, context.queue_family, 0, &context.queue);
+
+    VkFormat format = VK_FORMAT_R8G8B8A8_UNORM;
+    Utils::create_image(
+        context.device, context.physical_device, context.extent, format, VK_IMAGE_TILING_OPTIMAL,
+        VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        context.color_image, context.color_memory);
+    context.color_view = Utils::create_image_view(context.device, context.color_image, format, VK_IMAGE_ASPECT_COLOR_BIT);
+
+    VkAttachmentDescription attachment{};
+    attachment.format = format;
+    attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+    attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    attachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+    VkAttachmentReference reference{0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+
+    VkSubpassDescription subpass{};
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.colorAttachmentCount = 1;
+    subpass.pColorAttachments = &reference;
+
+    VkRenderPassCreateInfo render_pass_info{};
+    render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    render_pass_info.attachmentCount = 1;
+    render_pass_info.pAttachments = &attachment;
+    render_pass_info.subpassCount = 1;
+    render_pass_info.pSubpasses = &subpass;
+
+    if (vkCreateRenderPass(context.device, &render_pass_info, nullptr, &context.render_pass) != VK_SUCCESS)
+        throw std::runtime_error("\nFailed to create render pass.");
+
+    VkFramebufferCreateInfo framebuffer_info{};
+    framebuffer_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+    framebuffer_info.renderPass = context.render_pass;
+    framebuffer_info.attachmentCount = 1;
+    framebuffer_info.pAttachments = &context.color_view;
+    framebuffer_info.width = context.extent.width;
+    framebuffer_info.height = context.extent.height;
+    framebuffer_info.layers = 1;
+
+    if (vkCreateFramebuffer(context.device, &framebuffer_info, nullptr, &context.framebuffer) != VK_SUCCESS)
+        throw std::runtime_error("\nFailed to create framebuffer.");
+
+    VkPushConstantRange push_constant_range{VK_SHADER_STAGE_VERTEX_BIT, 0, 64};
+
+    VkPipelineLayoutCreateInfo layout_info{};
+    layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    layout_info.pushConstantRangeCount = 1;
+    layout_info.pPushConstantRanges = &push_constant_range;
+
+    if (vkCreatePipelineLayout(context.device, &layout_info, nullptr, &context.pipeline_layout) != VK_SUCCESS)
+        throw std::runtime_error("\nFailed to create pipeline layout.");
+
+    VkCommandPoolCreateInfo pool_info{};
+    pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    pool_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    pool_info.queueFamilyIndex = context.queue_family;
+
+    if (vkCreateCommandPool(context.device, &pool_info, nullptr, &context.primary_pool) != VK_SUCCESS)
+        throw std::runtime_error("\nFailed to create command pool.");
+
+    VkCommandBufferAllocateInfo allocate_info{};
+    allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocate_info.commandPool = context.primary_pool;
+    allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocate_info.commandBufferCount = 1;
+
+    if (vkAllocateCommandBuffers(context.device, &allocate_info, &context.primary) != VK_SUCCESS)
+        throw std::runtime_error("\nFailed to allocate command buffer.");
+
+    VkFenceCreateInfo fence_info{};
+    fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    if (vkCreateFence(context.device, &fence_info, nullptr, &context.fence) != VK_SUCCESS)
+        throw std::runtime_error("\nFailed to create fence.");
+}
+
+static void destroy_context(Context& context)
+{
+    vkDestroyFence(context.device, context.fence, nullptr);
+    vkDestroyCommandPool(context.device, context.primary_pool, nullptr);
+    vkDestroyPipelineLayout(context.device, context.pipeline_layout, nullptr);
+    vkDestroyFramebuffer(context.device, context.framebuffer, nullptr);
+    vkDestroyRenderPass(context.device, context.render_pass, nullptr);
+    vkDestroyImageView(context.device, context.color_view, nullptr);
+    vkDestroyImage(context.device, context.color_image, nullptr);
+    vkFreeMemory(context.device, context.color_memory, nullptr);
+    vkDestroyDevice(context.device, nullptr);
+    vkDestroyInstance(context.instance, nullptr);
+}
+
+/**
+ * Time to record one frame of draw_count draws, in milliseconds. The frame is
+ * then submitted and waited on (not timed) so the pools can be reset.
+ */
+static double record_frame(Context& context, Graphics::ParallelRecorder& recorder, uint32_t draw_count)
+{
+    const Context& c = context;
+    Graphics::RecordFunction record_draws = [&c](VkCommandBuffer command_buffer, uint32_t first, uint32_t count) {
+        for (uint32_t i = first; i < first + count; i++)
+        {
+            float x = static_cast<float>(i % c.extent.width);
+            float y = static_cast<float>((i / c.extent.width) % c.extent.height);
+
+            VkViewport viewport{0.0f, 0.0f, static_cast<float>(c.extent.width), static_cast<float>(c.extent.height), 0.0f, 1.0f};
+            VkRect2D scissor{{0, 0}, c.extent};
+            vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+            vkCmdSetScissor(command_buffer, 0, 1, &scissor);
+
+            float constants[16] = {x, y, static_cast<float>(i), 1.0f};
+            vkCmdPushConstants(command_buffer, c.pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(constants), constants);
+
+            VkClearAttachment clear{};
+            clear.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            clear.colorAttachment = 0;
+            clear.clearValue.color = {{x / c.extent.width, y / c.extent.height, 0.5f, 1.0f}};
+
+            VkClearRect rect{};
+            rect.rect = {{static_cast<int32_t>(x), static_cast<int32_t>(y)}, {1, 1}};
+            rect.baseArrayLayer = 0;
+            rect.layerCount = 1;
+            vkCmdClearAttachments(command_buffer, 1, &clear, 1, &rect);
+        }
+    };
+
+    vkResetCommandPool(context.device, context.primary_pool, 0);
+    recorder.begin_frame(0);
+
+    auto start = std::chrono::steady_clock::now();
+
+    VkCommandBufferBeginInfo begin_info{};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(context.primary, &begin_info);
+
+    VkClearValue clear_value{};
+    VkRenderPassBeginInfo render_pass_begin{};
+    render_pass_begin.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    render_pass_begin.renderPass = context.render_pass;
+    render_pass_begin.framebuffer = context.framebuffer;
+    render_pass_begin.renderArea = {{0, 0}, context.extent};
+    render_pass_begin.clearValueCount = 1;
+    render_pass_begin.pClearValues = &clear_value;
+    vkCmdBeginRenderPass(context.primary, &render_pass_begin, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+
+    VkCommandBufferInheritanceInfo inheritance{};
+    inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritance.renderPass = context.render_pass;
+    inheritance.subpass = 0;
+    inheritance.framebuffer = context.framebuffer;
+
+    Graphics::ParallelRecorder::execute(context.primary, recorder.record(0, inheritance, draw_count, record_draws));
+
+    vkCmdEndRenderPass(context.primary);
+    vkEndCommandBuffer(context.primary);
+
+    double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    VkSubmitInfo submit_info{};
+    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers = &context.primary;
+
+    if (vkQueueSubmit(context.queue, 1, &submit_info, context.fence) != VK_SUCCESS)
+        throw std::runtime_error("\nFailed to submit benchmark frame.");
+    vkWaitForFences(context.device, 1, &context.fence, VK_TRUE, UINT64_MAX);
+    vkResetFences(context.device, 1, &context.fence);
+
+    return elapsed_ms;
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t draw_count = 20000;
+    uint32_t frame_count = 30;
+    uint32_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+    std::string preferred_device;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--draws") && i + 1 < argc)
+            draw_count = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        else if (!strcmp(argv[i], "--frames") && i + 1 < argc)
+            frame_count = std::max(1u, static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10)));
+        else if (!strcmp(argv[i], "--max-threads") && i + 1 < argc)
+            max_threads = std::max(1u, static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10)));
+        else if (!strcmp(argv[i], "--device") && i + 1 < argc)
+            preferred_device = argv[++i];
+    }
+
+    try
+    {
+        Context context;
+        create_context(context, preferred_device);
+
+        printf("%u draws per frame, median of %u frames\n\n", draw_count, frame_count);
+        printf("threads   record ms   speedup\n");
+
+        double single_thread_ms = 0.0;
+        for (uint32_t threads = 1; threads <= max_threads; threads = threads < max_threads ? std::min(threads * 2, max_threads) : threads + 1)
+        {
+            Jobs::JobSystem jobs;
+            jobs.init(threads);
+
+            Graphics::ParallelRecorder recorder;
+            recorder.init(context.device, context.queue_family, 1, jobs);
+
+            // Warm up: the first frame allocates the secondary command buffers.
+            record_frame(context, recorder, draw_count);
+
+            std::vector<double> samples;
+            for (uint32_t frame = 0; frame < frame_count; frame++)
+                samples.push_back(record_frame(context, recorder, draw_count));
+
+            std::sort(samples.begin(), samples.end());
+            double median_ms = samples[samples.size() / 2];
+            if (threads == 1)
+                single_thread_ms = median_ms;
+
+            printf("%7u   %9.3f   %6.2fx\n", threads, median_ms, single_thread_ms / median_ms);
+
+            recorder.cleanup();
+            jobs.cleanup();
+        }
+
+        destroy_context(context);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,104 @@
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-14
+ *
+ * Steps the CPU reference of the compute particle simulation serially and
+ * across the job system: the per-frame CPU time the compute queue takes off
+ * the workers. The parallel result is checked bit for bit against the serial
+ * one, since the GPU comparison relies on the reference being deterministic.
+ *
+ * Usage: particle_benchmark [--particles N] [--steps N] [--runs N] [--threads N]
+ */
+
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+
+#include "../src/core/graphics/particles.hpp"
+#include "../src/core/jobs/job_system.hpp"
+
+using namespace VulkanGameEngine;
+
+template <typename F>
+static double median_ms(uint32_t runs, F function)
+{
+    std::vector<double> times;
+    for (uint32_t run = 0; run < runs; run++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        function(run);
+        times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t particle_count = 1u << 20;
+    uint32_t steps = 600;
+    uint32_t runs = 31;
+    uint32_t threads = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--particles") && i + 1 < argc)
+            particle_count = std::max(1u, static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10)));
+        else if (!strcmp(argv[i], "--steps") && i + 1 < argc)
+            steps = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        else if (!strcmp(argv[i], "--runs") && i + 1 < argc)
+            runs = std::max(1u, static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10)));
+        else if (!strcmp(argv[i], "--threads") && i + 1 < argc)
+            threads = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+    }
+
+    Jobs::JobSystem jobs;
+    jobs.init(threads);
+
+    Graphics::ParticleSettings settings;
+    settings.count = particle_count;
+
+    printf("%u particles, %u runs, %u worker threads\n\n", particle_count, runs, jobs.get_worker_count());
+
+    // One step of an already running simulation, the steady state cost per frame.
+    std::vector<Graphics::Particle> source = Graphics::run_particle_reference(settings, 120);
+    std::vector<Graphics::Particle> destination(particle_count);
+    Graphics::ParticleConstants constants = Graphics::make_particle_constants(settings, Graphics::ParticleMode::Step);
+
+    double serial_ms = median_ms(runs, [&](uint32_t) {
+        Graphics::simulate_particles(constants, source.data(), destination.data(), 0, particle_count);
+    });
+    double parallel_ms = median_ms(runs, [&](uint32_t) {
+        jobs.parallel_for(particle_count, 4096, [&](uint32_t first, uint32_t last) {
+            Graphics::simulate_particles(constants, source.data(), destination.data(), first, last);
+        });
+    });
+
+    printf("step           serial ms  parallel ms  ns/particle\n");
+    printf("%-12s %11.3f %12.3f %12.2f\n\n", "1 step", serial_ms, parallel_ms, serial_ms * 1e6 / particle_count);
+
+    // Whole runs, as the GPU verification computes them.
+    std::vector<Graphics::Particle> serial;
+    std::vector<Graphics::Particle> parallel;
+    double serial_run_ms = median_ms(1, [&](uint32_t) { serial = Graphics::run_particle_reference(settings, steps); });
+    double parallel_run_ms = median_ms(1, [&](uint32_t) { parallel = Graphics::run_particle_reference(settings, steps, &jobs); });
+
+    printf("%u steps: serial %.1f ms, parallel %.1f ms\n", steps, serial_run_ms, parallel_run_ms);
+
+    if (memcmp(serial.data(), parallel.data(), serial.size() * sizeof(Graphics::Particle)) != 0)
+    {
+        printf("parallel reference differs from the serial one\n");
+        return 1;
+    }
+
+    uint32_t respawned = 0;
+    for (const auto& particle : serial)
+        respawned += particle.generation > 0;
+    printf("parallel reference matches the serial one; %u of %u particles respawned at least once\n", respawned, particle_count);
+
+    return 0;
+}
@@ -0,0 +1,152 @@
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-08
+ *
+ * Drives the texture residency policy with synthetic access patterns, without
+ * a device, and reports how well it keeps up under a VRAM budget:
+ *  - sweep:   textures laid out along a line, a camera moving over them; the
+ *             requested mip grows with the distance to the camera
+ *  - random:  a skewed random subset of textures requested every frame
+ *  - thrash:  every texture requested at full resolution every frame, with a
+ *             working set far above the budget
+ *
+ * Usage: texture_streaming_benchmark [--textures N] [--size N] [--budget-mb N] [--frames N]
+ */
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+
+#include "../src/core/graphics/texture_residency.hpp"
+
+using namespace VulkanGameEngine;
+
+// Levels of at most this size are never streamed out.
+static const VkDeviceSize tail_bytes = 64 * 1024;
+
+struct Pattern
+{
+    const char* name;
+    std::function<void(Graphics::TextureResidency&, const std::vector<Graphics::StreamedTexture>&, uint64_t)> requests;
+};
+
+static void run(const Pattern& pattern, uint32_t texture_count, uint32_t size, VkDeviceSize budget, uint32_t frames)
+{
+    std::vector<VkDeviceSize> mip_sizes;
+    uint32_t tail_mip = 0;
+    for (uint32_t extent = size; ; extent = std::max(1u, extent / 2))
+    {
+        mip_sizes.push_back(static_cast<VkDeviceSize>(extent) * extent * 4);
+        if (mip_sizes.back() > tail_bytes)
+            tail_mip = static_cast<uint32_t>(mip_sizes.size());
+        if (extent == 1)
+            break;
+    }
+
+    Graphics::TextureResidency::Settings settings;
+    settings.budget = budget;
+
+    Graphics::TextureResidency residency;
+    residency.init(settings);
+
+    std::vector<Graphics::StreamedTexture> textures;
+    for (uint32_t i = 0; i < texture_count; i++)
+        textures.push_back(residency.add(mip_sizes, tail_mip));
+
+    std::vector<Graphics::TextureResidency::Change> changes;
+    VkDeviceSize peak_bytes = 0;
+    double update_ms = 0.0;
+    size_t change_count = 0;
+
+    for (uint64_t frame = 0; frame < frames; frame++)
+    {
+        pattern.requests(residency, textures, frame);
+
+        auto start = std::chrono::steady_clock::now();
+        changes.clear();
+        residency.update(frame, changes);
+        update_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        change_count += changes.size();
+        peak_bytes = std::max(peak_bytes, residency.get_resident_bytes());
+    }
+
+    const auto& statistics = residency.get_statistics();
+    printf("%-7s %9.1f%% %8llu %10llu %10.1f %8llu %9.1f / %-7.1f %8.2f\n",
+        pattern.name,
+        statistics.requests ? 100.0 * statistics.satisfied_requests / statistics.requests : 100.0,
+        static_cast<unsigned long long>(statistics.loads),
+        static_cast<unsigned long long>(statistics.evictions),
+        statistics.loaded_bytes / (1024.0 * 1024.0),
+        static_cast<unsigned long long>(statistics.budget_misses),
+        peak_bytes / (1024.0 * 1024.0),
+        budget / (1024.0 * 1024.0),
+        update_ms * 1000.0 / frames);
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t texture_count = 2048;
+    uint32_t size = 2048;
+    uint32_t budget_mb = 512;
+    uint32_t frames = 2000;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--textures") && i + 1 < argc)
+            texture_count = std::max(1u, static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10)));
+        else if (!strcmp(argv[i], "--size") && i + 1 < argc)
+            size = std::max(1u, static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10)));
+        else if (!strcmp(argv[i], "--budget-mb") && i + 1 < argc)
+            budget_mb = std::max(1u, static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10)));
+        else if (!strcmp(argv[i], "--frames") && i + 1 < argc)
+            frames = std::max(1u, static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10)));
+    }
+
+    VkDeviceSize budget = static_cast<VkDeviceSize>(budget_mb) << 20;
+
+    std::mt19937 random(7);
+    std::vector<Pattern> patterns = {
+        {"sweep", [&](Graphics::TextureResidency& residency, const std::vector<Graphics::StreamedTexture>& textures, uint64_t frame) {
+            // The camera crosses every texture once over the run; about 64 are in view.
+            double camera = static_cast<double>(frame) * textures.size() / frames;
+            int first = std::max(0, static_cast<int>(camera) - 32);
+            int last = std::min(static_cast<int>(textures.size()), static_cast<int>(camera) + 32);
+            for (int i = first; i < last; i++)
+            {
+                double distance = std::abs(i - camera);
+                residency.request(textures[i], static_cast<uint32_t>(std::log2(1.0 + distance)), frame);
+            }
+        }},
+        {"random", [&](Graphics::TextureResidency& residency, const std::vector<Graphics::StreamedTexture>& textures, uint64_t frame) {
+            // Squaring a uniform sample favours the first textures, like popular materials.
+            std::uniform_real_distribution<double> uniform(0.0, 1.0);
+            for (int i = 0; i < 64; i++)
+            {
+                double u = uniform(random);
+                size_t index = static_cast<size_t>(u * u * textures.size());
+                residency.request(textures[index], static_cast<uint32_t>(random() % 4), frame);
+            }
+        }},
+        {"thrash", [&](Graphics::TextureResidency& residency, const std::vector<Graphics::StreamedTexture>& textures, uint64_t frame) {
+            for (auto texture : textures)
+                residency.request(texture, 0, frame);
+        }},
+    };
+
+    printf("%u textures of %ux%u RGBA8, %u MiB budget, %u frames\n\n", texture_count, size, size, budget_mb, frames);
+    printf("pattern   resident    loads  evictions  MiB loaded  misses  peak / budget MiB  update us\n");
+
+    for (const auto& pattern : patterns)
+        run(pattern, texture_count, size, budget, frames);
+
+    return 0;
+}
@@ -0,0 +1,215 @@
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-11
+ *
+ * Propagates transforms through a forest of hierarchies stored in the
+ * archetype chunked World, with every root moving, 1% of the roots moving
+ * and nothing moving, serially and across the job system. A heap allocated
+ * node graph updated recursively is timed alongside as the baseline, and
+ * its matrices are checked against the World's.
+ *
+ * Usage: transform_benchmark [--entities N] [--depth N] [--children N] [--runs N] [--threads N]
+ */
+
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+
+#include "../src/core/scene/world.hpp"
+#include "../src/core/scene/transform.hpp"
+#include "../src/core/jobs/job_system.hpp"
+
+using namespace VulkanGameEngine;
+
+/**
+ * What the World replaces: every node its own allocation, children reached through pointers.
+ */
+struct Node
+{
+    Scene::LocalTransform local;
+    Math::Mat4 world;
+    bool dirty = true;
+    std::vector<Node*> children;
+
+    explicit Node(const Scene::LocalTransform& local) : local(local) {}
+};
+
+static void update_node(Node* node, const Math::Mat4* parent, bool parent_changed)
+{
+    bool changed = node->dirty || parent_changed;
+    if (changed)
+    {
+        if (parent)
+            node->world = Math::multiply_affine(*parent, Scene::compose_matrix(node->local));
+        else
+            node->world = Scene::compose_matrix(node->local);
+        node->dirty = false;
+    }
+    for (Node* child : node->children)
+        update_node(child, &node->world, changed);
+}
+
+template <typename F>
+static double median_ms(uint32_t runs, F function)
+{
+    std::vector<double> times;
+    for (uint32_t run = 0; run < runs; run++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        function(run);
+        times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t entity_count = 100000;
+    uint32_t depth = 5;
+    uint32_t children = 4;
+    uint32_t runs = 31;
+    uint32_t threads = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--entities") && i + 1 < argc)
+            entity_count = std::max(1u, static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10)));
+        else if (!strcmp(argv[i], "--depth") && i + 1 < argc)
+            depth = std::max(1u, static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10)));
+        else if (!strcmp(argv[i], "--children") && i + 1 < argc)
+            children = std::max(1u, static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10)));
+        else if (!strcmp(argv[i], "--runs") && i + 1 < argc)
+            runs = std::max(1u, static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10)));
+        else if (!strcmp(argv[i], "--threads") && i + 1 < argc)
+            threads = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+    }
+
+    // Trees of the given depth and fan out, built breadth first until entity_count.
+    // Both representations are created in the same interleaved order so neither
+    // gets a more favorable allocation pattern.
+    Scene::World world;
+    Scene::TransformSystem transforms;
+    std::vector<std::unique_ptr<Node>> nodes;
+    std::vector<Scene::Entity> entities;
+    std::vector<uint32_t> roots;
+
+    for (uint32_t created = 0; created < entity_count; )
+    {
+        Scene::LocalTransform local;
+        local.position[0] = static_cast<float>(roots.size() % 1024);
+        local.position[2] = static_cast<float>(roots.size() / 1024);
+        roots.push_back(created);
+        entities.push_back(transforms.create(world, local));
+        nodes.emplace_back(new Node(local));
+        created++;
+
+        std::vector<uint32_t> level = {created - 1};
+        for (uint32_t d = 1; d < depth && created < entity_count; d++)
+        {
+            std::vector<uint32_t> next;
+            for (uint32_t parent : level)
+                for (uint32_t c = 0; c < children && created < entity_count; c++, created++)
+                {
+                    Scene::LocalTransform offset;
+                    offset.position[0] = static_cast<float>(c) - children * 0.5f;
+                    offset.position[1] = 1.0f;
+                    offset.rotation[1] = std::sin(0.05f * c);
+                    offset.rotation[3] = std::cos(0.05f * c);
+                    offset.scale[0] = offset.scale[1] = offset.scale[2] = 0.8f;
+                    entities.push_back(transforms.create(world, offset, entities[parent]));
+                    nodes.emplace_back(new Node(offset));
+                    nodes[parent]->children.push_back(nodes.back().get());
+                    next.push_back(created);
+                }
+            level = std::move(next);
+        }
+    }
+
+    Jobs::JobSystem jobs;
+    jobs.init(threads);
+
+    transforms.update(world);
+    for (uint32_t root : roots)
+        update_node(nodes[root].get(), nullptr, false);
+
+    const Scene::World::Statistics scene_statistics = world.get_statistics();
+    printf("%u entities in %zu trees (depth %u, %u children), %u chunks, %u runs, %u worker threads\n\n",
+        entity_count, roots.size(), depth, children,
+        scene_statistics.chunks, runs, jobs.get_worker_count());
+    printf("moving roots   graph ms   world ms  parallel ms  recomputed  chunks skipped\n");
+
+    int status = 0;
+    for (uint32_t percent : {100u, 1u, 0u})
+    {
+        // Roots moved per run: every 100 / percent-th one.
+        std::vector<uint32_t> moving;
+        for (size_t r = 0; percent > 0 && r < roots.size(); r += 100 / percent)
+            moving.push_back(roots[r]);
+
+        auto move_roots = [&](uint32_t run, bool graph) {
+            for (uint32_t root : moving)
+            {
+                Scene::LocalTransform local = nodes[root]->local;
+                local.rotation[1] = std::sin(run * 0.01f);
+                local.rotation[3] = std::cos(run * 0.01f);
+                if (graph)
+                {
+                    nodes[root]->local = local;
+                    nodes[root]->dirty = true;
+                }
+                else
+                    transforms.set_local(world, entities[root], local);
+            }
+        };
+
+        double graph_ms = median_ms(runs, [&](uint32_t run) {
+            move_roots(run, true);
+            for (uint32_t root : roots)
+                update_node(nodes[root].get(), nullptr, false);
+        });
+
+        Scene::TransformSystem::Statistics before = transforms.get_statistics();
+        double world_ms = median_ms(runs, [&](uint32_t run) {
+            move_roots(run, false);
+            transforms.update(world);
+        });
+        Scene::TransformSystem::Statistics after = transforms.get_statistics();
+
+        double parallel_ms = median_ms(runs, [&](uint32_t run) {
+            move_roots(run, false);
+            transforms.update(world, &jobs);
+        });
+
+        // Both sides last ran with the same run index, so the matrices must agree.
+        for (uint32_t i = 0; i < entity_count; i++)
+        {
+            const float* matrix = transforms.get_world_matrix(world, entities[i]);
+            for (int k = 0; k < 16; k++)
+                if (std::fabs(matrix[k] - nodes[i]->world.m[k]) > 1e-3f * (1.0f + std::fabs(nodes[i]->world.m[k])))
+                {
+                    printf("entity %u: world matrix differs from the node graph\n", i);
+                    status = 1;
+                    i = entity_count;
+                    break;
+                }
+        }
+
+        printf("%11u%% %10.3f %10.3f %12.3f %11.0f %15.1f\n",
+            percent,
+            graph_ms,
+            world_ms,
+            parallel_ms,
+            static_cast<double>(after.entities_recomputed - before.entities_recomputed) / runs,
+            static_cast<double>(after.chunks_skipped - before.chunks_skipped) / runs);
+    }
+
+    jobs.cleanup();
+    return status;
+}
@@ -0,0 +1,55 @@
+# Offline SPIR-V compilation.
+#
+# vge_compile_shaders(<target> OUTPUT_DIR <dir> SOURCES <files...>)
+#
+# Compiles every GLSL (.vert .frag .comp .geom .tesc .tese) and HLSL
+# (<name>.<stage>.hlsl) source to <dir>/<file name>.spv with glslc, and makes
+# <target> depend on the results. glslc writes a depfile for each shader, so
+# editing an #include'd file recompiles the shaders using it.
+
+include(CMakeParseArguments)
+
+find_program(VGE_GLSLC glslc
+    HINTS "$ENV{VULKAN_SDK}/bin" "$ENV{VULKAN_SDK}/Bin" "${VULKAN_PATH}/Bin"
+)
+
+function(vge_compile_shaders target)
+    cmake_parse_arguments(SHADERS "" "OUTPUT_DIR" "SOURCES" ${ARGN})
+
+    if (NOT VGE_GLSLC)
+        message(WARNING "glslc not found: shaders are not compiled and pipelines using them are skipped.")
+        return()
+    endif()
+
+    file(MAKE_DIRECTORY ${SHADERS_OUTPUT_DIR})
+
+    set(outputs)
+    foreach(source ${SHADERS_SOURCES})
+        get_filename_component(source_path ${source} ABSOLUTE)
+        get_filename_component(source_name ${source} NAME)
+        set(output "${SHADERS_OUTPUT_DIR}/${source_name}.spv")
+
+        set(language_flags)
+        if (source_name MATCHES "\\.([a-z]+)\\.hlsl$")
+            set(language_flags -x hlsl -fshader-stage=${CMAKE_MATCH_1})
+        endif()
+
+        set(depfile_arguments)
+        if (NOT CMAKE_VERSION VERSION_LESS 3.20 OR CMAKE_GENERATOR MATCHES "Ninja")
+            set(depfile_arguments DEPFILE "${output}.d")
+        endif()
+
+        add_custom_command(
+            OUTPUT ${output}
+            COMMAND ${VGE_GLSLC} ${language_flags} --target-env=vulkan1.1 -O -MD -MF "${output}.d" -o ${output} ${source_path}
+            MAIN_DEPENDENCY ${source_path}
+            ${depfile_arguments}
+            COMMENT "Compiling shader ${source_name}"
+            VERBATIM
+        )
+        list(APPEND outputs ${output})
+    endforeach()
+
+    add_custom_target(${target}_shaders ALL DEPENDS ${outputs})
+    add_dependencies(${target} ${target}_shaders)
+endfunction()
@@ -1,18 +1,149 @@
 #include <iostream>
+#include <string>
+#include <stdexcept>
+#include <cstdint>
+#include <cstring>
 #include "src/core/graphics/window.hpp"
 
 // #include "VulkanApplication.hpp"
 
 
 
-int main(int, char**) {
+static std::runtime_error invalid_value(const std::string& flag, const char* value)
+{
+    return std::runtime_error("\nInvalid value '" + std::string(value) + "' for " + flag + ".");
+}
+
+// The whole value must be a number of at least minimum; base 0 also takes hexadecimal.
+static uint32_t parse_count(const std::string& flag, const char* value, uint32_t minimum = 0, int base = 10)
+{
+    size_t parsed = 0;
+    unsigned long long number = 0;
     try
     {
-        VulkanGameEngine::Graphics::Window window;
+        number = std::stoull(value, &parsed, base);
+    }
+    catch (const std::exception&)
+    {
+        throw invalid_value(flag, value);
+    }
+
+    if (value[parsed] != '\0' || strchr(value, '-') || number > UINT32_MAX || number < minimum)
+        throw invalid_value(flag, value);
+    return static_cast<uint32_t>(number);
+}
+
+static double parse_number(const std::string& flag, const char* value)
+{
+    size_t parsed = 0;
+    double number = 0.0;
+    try
+    {
+        number = std::stod(value, &parsed);
+    }
+    catch (const std::exception&)
+    {
+        throw invalid_value(flag, value);
+    }
+
+    if (value[parsed] != '\0')
+        throw invalid_value(flag, value);
+    return number;
+}
+
+int main(int argc, char** argv) {
+    VulkanGameEngine::Graphics::WindowSettings settings;
+
+    try
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            std::string arg = argv[i];
+
+            if (arg == "--headless")
+                settings.headless = true;
+            else if (arg == "--frames" && i + 1 < argc)
+                settings.headless_frame_count = parse_count(arg, argv[++i]);
+            else if (arg == "--frames-in-flight" && i + 1 < argc)
+                settings.frames_in_flight = parse_count(arg, argv[++i], 1);
+            else if (arg == "--workers" && i + 1 < argc)
+                settings.worker_threads = parse_count(arg, argv[++i]);
+            else if (arg == "--parallel-recording")
+                settings.parallel_recording = true;
+            else if (arg == "--present-policy" && i + 1 < argc)
+            {
+                std::string policy = argv[++i];
+                if (policy == "low-latency")
+                    settings.present_policy = VulkanGameEngine::Utils::PresentPolicy::LowLatency;
+                else if (policy == "power-saving")
+                    settings.present_policy = VulkanGameEngine::Utils::PresentPolicy::PowerSaving;
+                else
+                    settings.present_policy = VulkanGameEngine::Utils::PresentPolicy::MaxThroughput;
+            }
+            else if (arg == "--target-fps" && i + 1 < argc)
+                settings.target_fps = parse_number(arg, argv[++i]);
+            else if (arg == "--device" && i + 1 < argc)
+                settings.preferred_device = argv[++i];
+            else if (arg == "--width" && i + 1 < argc)
+                settings.width = parse_count(arg, argv[++i]);
+            else if (arg == "--height" && i + 1 < argc)
+                settings.height = parse_count(arg, argv[++i]);
+            else if (arg == "--pipeline-cache" && i + 1 < argc)
+                settings.pipeline_cache_path = argv[++i];
+            else if (arg == "--startup-report" && i + 1 < argc)
+                settings.startup_report_path = argv[++i];
+            else if (arg == "--hot-reload")
+                settings.shader_hot_reload = true;
+            else if (arg == "--texture-budget" && i + 1 < argc)
+                settings.texture_budget_mb = parse_count(arg, argv[++i]);
+            else if (arg == "--streaming-test" && i + 1 < argc)
+                settings.streaming_test_textures = parse_count(arg, argv[++i]);
+            else if (arg == "--mesh" && i + 1 < argc)
+                settings.mesh_path = argv[++i];
+            else if (arg == "--mesh-pack" && i + 1 < argc)
+                settings.mesh_pack_path = argv[++i];
+            else if (arg == "--scene-test" && i + 1 < argc)
+                settings.scene_test_entities = parse_count(arg, argv[++i]);
+            else if (arg == "--particles" && i + 1 < argc)
+                settings.particle_count = parse_count(arg, argv[++i]);
+            else if (arg == "--verify-particles")
+                settings.verify_particles = true;
+            else if (arg == "--capture" && i + 1 < argc)
+                settings.capture.path = argv[++i];
+            else if (arg == "--capture-every" && i + 1 < argc)
+                settings.capture.frame_step = parse_count(arg, argv[++i], 1);
+            else if (arg == "--capture-buffers" && i + 1 < argc)
+                settings.capture.ring_size = parse_count(arg, argv[++i], 1);
+            else if (arg == "--golden" && i + 1 < argc)
+                settings.capture.golden_dir = argv[++i];
+            else if (arg == "--golden-tolerance" && i + 1 < argc)
+                settings.capture.golden_tolerance = parse_count(arg, argv[++i]);
+            else if (arg == "--golden-mismatch" && i + 1 < argc)
+                settings.capture.allowed_mismatch_fraction = parse_number(arg, argv[++i]);
+            else if (arg == "--trace" && i + 1 < argc)
+                settings.trace_path = argv[++i];
+            else if (arg == "--debug-severity" && i + 1 < argc)
+            {
+                std::string severity = argv[++i];
+                if (severity == "verbose")
+                    settings.debug_severity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT;
+                else if (severity == "info")
+                    settings.debug_severity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT;
+                else if (severity == "error")
+                    settings.debug_severity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
+                else
+                    settings.debug_severity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT;
+            }
+            else if (arg == "--debug-mute" && i + 1 < argc)
+                settings.debug_muted_ids.push_back(static_cast<int32_t>(parse_count(arg, argv[++i], 0, 0)));
+        }
+
+        VulkanGameEngine::Graphics::Window window(settings);
     }
     catch(const std::exception& e)
     {
         std::cerr << e.what() << '\n';
+        return 1;
     }
     
     
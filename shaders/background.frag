@@ -0,0 +1,19 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "include/palette.glsl"
+
+layout(push_constant) uniform BackgroundConstants
+{
+    // Cycles with the frame number so consecutive frames differ in captures.
+    float time;
+} constants;
+
+layout(location = 0) in vec2 in_uv;
+
+layout(location = 0) out vec4 out_color;
+
+void main()
+{
+    out_color = vec4(palette(in_uv.y * 0.5 + constants.time), 1.0);
+}
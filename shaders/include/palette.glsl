@@ -0,0 +1,11 @@
+// Shared color helpers.
+
+vec3 palette(float t)
+{
+    // Cosine gradient: a + b * cos(2 pi (c t + d)).
+    vec3 a = vec3(0.5, 0.5, 0.5);
+    vec3 b = vec3(0.5, 0.5, 0.5);
+    vec3 c = vec3(1.0, 1.0, 1.0);
+    vec3 d = vec3(0.00, 0.33, 0.67);
+    return a + b * cos(6.28318 * (c * t + d));
+}
@@ -0,0 +1,14 @@
+#version 450
+
+// Without a bindless table; mesh_textured.frag otherwise.
+layout(location = 0) in vec3 in_normal;
+
+layout(location = 0) out vec4 out_color;
+
+void main()
+{
+    // One directional light and a little ambient.
+    vec3 light = normalize(vec3(0.4, 1.0, 0.3));
+    float diffuse = max(dot(normalize(in_normal), light), 0.0);
+    out_color = vec4(vec3(0.8, 0.75, 0.7) * (0.2 + 0.8 * diffuse), 1.0);
+}
@@ -0,0 +1,45 @@
+#version 450
+
+// Mesh instances that survived frustum culling, drawn indirectly: firstInstance
+// of each draw indexes the instance's world matrix.
+layout(location = 0) in vec3 in_position;
+layout(location = 1) in vec3 in_normal;
+layout(location = 2) in vec2 in_uv;
+
+layout(std430, set = 0, binding = 0) readonly buffer Instances
+{
+    mat4 view_projection;
+    mat4 world[];
+} instances;
+
+layout(push_constant) uniform MeshConstants
+{
+    // Normals are octahedral snorm16 pairs instead of float3.
+    uint quantized;
+    // Bindless texture index, or ~0 for none; read by the fragment shader.
+    uint texture_index;
+    // Undo the uv quantization; identity for float vertices.
+    vec2 uv_offset;
+    vec2 uv_scale;
+} constants;
+
+layout(location = 0) out vec3 out_normal;
+layout(location = 1) out vec2 out_uv;
+
+vec3 decode_octahedral(vec2 encoded)
+{
+    vec3 normal = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    float t = max(-normal.z, 0.0);
+    normal.xy += mix(vec2(t), vec2(-t), greaterThanEqual(normal.xy, vec2(0.0)));
+    return normalize(normal);
+}
+
+void main()
+{
+    mat4 world = instances.world[gl_InstanceIndex];
+    vec3 normal = constants.quantized != 0 ? decode_octahedral(in_normal.xy) : in_normal;
+
+    out_normal = normalize(mat3(world) * normal);
+    out_uv = constants.uv_offset + in_uv * constants.uv_scale;
+    gl_Position = instances.view_projection * world * vec4(in_position, 1.0);
+}
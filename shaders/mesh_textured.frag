@@ -0,0 +1,31 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+// The textures of the bindless table (BindlessTable::texture_binding), bound at set 1.
+layout(set = 1, binding = 0) uniform sampler2D bindless_textures[];
+
+layout(push_constant) uniform MeshConstants
+{
+    uint quantized;
+    uint texture_index;
+    vec2 uv_offset;
+    vec2 uv_scale;
+} constants;
+
+layout(location = 0) in vec3 in_normal;
+layout(location = 1) in vec2 in_uv;
+
+layout(location = 0) out vec4 out_color;
+
+void main()
+{
+    // Untextured until the streamed texture has been registered.
+    vec3 albedo = vec3(0.8, 0.75, 0.7);
+    if (constants.texture_index != 0xFFFFFFFFu)
+        albedo = texture(bindless_textures[constants.texture_index], in_uv).rgb;
+
+    // One directional light and a little ambient.
+    vec3 light = normalize(vec3(0.4, 1.0, 0.3));
+    float diffuse = max(dot(normalize(in_normal), light), 0.0);
+    out_color = vec4(albedo * (0.2 + 0.8 * diffuse), 1.0);
+}
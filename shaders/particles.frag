@@ -0,0 +1,13 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "include/palette.glsl"
+
+layout(location = 0) in float in_life;
+
+layout(location = 0) out vec4 out_color;
+
+void main()
+{
+    out_color = vec4(palette(in_life * 0.2), 1.0);
+}
@@ -0,0 +1,15 @@
+#version 450
+
+// Particles straight from the simulation's storage buffer, drawn as points.
+layout(location = 0) in vec4 in_position_life;
+
+layout(location = 0) out float out_life;
+
+void main()
+{
+    // Side view of the fountain: x across, y up, the emitter near the bottom.
+    vec3 position = in_position_life.xyz;
+    gl_Position = vec4(position.x * 0.15, 0.9 - position.y * 0.25, 0.5, 1.0);
+    gl_PointSize = 1.0;
+    out_life = in_position_life.w;
+}
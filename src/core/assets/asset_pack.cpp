@@ -0,0 +1,445 @@
+#include "asset_pack.hpp"
+#include "lz4.hpp"
+#include "../jobs/job_system.hpp"
+
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include <cstring>
+
+#ifdef VGE_HAVE_ZSTD
+    #include <zstd.h>
+#endif
+
+namespace VulkanGameEngine
+{
+    namespace Assets
+    {
+        uint64_t hash_asset_path(const std::string& path)
+        {
+            uint64_t hash = 14695981039346656037ull;
+            for (char c : path)
+            {
+                hash ^= static_cast<uint8_t>(c == '\\' ? '/' : c);
+                hash *= 1099511628211ull;
+            }
+            return hash;
+        }
+
+        bool is_codec_supported(Codec codec)
+        {
+            switch (codec)
+            {
+                case Codec::None:
+                case Codec::LZ4:
+                    return true;
+                case Codec::Zstd:
+                    #ifdef VGE_HAVE_ZSTD
+                        return true;
+                    #else
+                        return false;
+                    #endif
+            }
+            return false;
+        }
+
+        const char* codec_name(Codec codec)
+        {
+            switch (codec)
+            {
+                case Codec::None: return "none";
+                case Codec::LZ4: return "lz4";
+                case Codec::Zstd: return "zstd";
+            }
+            return "unknown";
+        }
+
+        static bool is_power_of_two(uint64_t value)
+        {
+            return value != 0 && (value & (value - 1)) == 0;
+        }
+
+        static bool in_file(uint64_t offset, uint64_t size, uint64_t file_size)
+        {
+            return offset <= file_size && size <= file_size - offset;
+        }
+
+        void AssetPack::open(const std::string& path)
+        {
+            close();
+
+            file.open(path);
+            this->path = path;
+
+            const uint8_t* data = file.get_data();
+            uint64_t size = file.get_size();
+
+            auto fail = [&](const char* reason) {
+                close();
+                throw std::runtime_error("\nInvalid asset pack " + path + ": " + reason + ".");
+            };
+
+            if (size < sizeof(PackHeader))
+                fail("truncated header");
+
+            const PackHeader* pack_header = reinterpret_cast<const PackHeader*>(data);
+            if (memcmp(pack_header->magic, pack_magic, sizeof(pack_magic)) != 0)
+                fail("bad magic");
+            if (pack_header->version != pack_version)
+                fail("unsupported version");
+            if (pack_header->file_size != size)
+                fail("truncated file");
+            if (!is_power_of_two(pack_header->chunk_size) || !is_power_of_two(pack_header->alignment))
+                fail("bad chunk size or alignment");
+            if (pack_header->entry_count > size / sizeof(PackEntry) ||
+                !in_file(pack_header->toc_offset, pack_header->entry_count * sizeof(PackEntry), size) ||
+                pack_header->chunk_count > size / sizeof(PackChunk) ||
+                !in_file(pack_header->chunk_table_offset, pack_header->chunk_count * sizeof(PackChunk), size) ||
+                !in_file(pack_header->names_offset, pack_header->names_size, size))
+                fail("table out of bounds");
+            if (pack_header->toc_offset % alignof(PackEntry) != 0 || pack_header->chunk_table_offset % alignof(PackChunk) != 0)
+                fail("misaligned table");
+
+            header = pack_header;
+            entries = reinterpret_cast<const PackEntry*>(data + header->toc_offset);
+            chunks = reinterpret_cast<const PackChunk*>(data + header->chunk_table_offset);
+            names = reinterpret_cast<const char*>(data + header->names_offset);
+
+            // Checked once here so reads never have to.
+            for (uint64_t i = 0; i < header->entry_count; i++)
+            {
+                const PackEntry& entry = entries[i];
+
+                if (i > 0 && entries[i - 1].path_hash >= entry.path_hash)
+                    fail("unsorted table of contents");
+                if (!in_file(entry.offset, entry.stored_size, size) ||
+                    static_cast<uint64_t>(entry.name_offset) + entry.name_length > header->names_size)
+                    fail("entry out of bounds");
+
+                if (entry.chunk_count == 0)
+                {
+                    if (entry.stored_size != entry.size)
+                        fail("bad stored size");
+                    continue;
+                }
+
+                if (static_cast<uint64_t>(entry.first_chunk) + entry.chunk_count > header->chunk_count ||
+                    (entry.size + header->chunk_size - 1) / header->chunk_size != entry.chunk_count)
+                    fail("bad chunk range");
+
+                for (uint32_t c = 0; c < entry.chunk_count; c++)
+                {
+                    const PackChunk& chunk = chunks[entry.first_chunk + c];
+                    if (!in_file(chunk.offset, chunk.stored_size, size) || !is_codec_supported(chunk.codec))
+                        fail("bad chunk");
+
+                    // Stored chunks are copied out as they are, by their uncompressed size.
+                    uint64_t chunk_bytes = std::min<uint64_t>(header->chunk_size, entry.size - static_cast<uint64_t>(c) * header->chunk_size);
+                    if (chunk.codec == Codec::None && chunk.stored_size != chunk_bytes)
+                        fail("bad stored chunk size");
+                }
+            }
+        }
+
+        void AssetPack::close()
+        {
+            file.close();
+            header = nullptr;
+            entries = nullptr;
+            chunks = nullptr;
+            names = nullptr;
+        }
+
+        const PackEntry* AssetPack::find(const std::string& asset_path) const
+        {
+            return find(hash_asset_path(asset_path));
+        }
+
+        const PackEntry* AssetPack::find(uint64_t path_hash) const
+        {
+            if (!header)
+                return nullptr;
+
+            const PackEntry* end = entries + header->entry_count;
+            const PackEntry* entry = std::lower_bound(entries, end, path_hash,
+                [](const PackEntry& a, uint64_t hash) { return a.path_hash < hash; });
+
+            return entry != end && entry->path_hash == path_hash ? entry : nullptr;
+        }
+
+        std::string AssetPack::get_name(const PackEntry& entry) const
+        {
+            return std::string(names + entry.name_offset, entry.name_length);
+        }
+
+        ByteSpan AssetPack::get_span(const PackEntry& entry) const
+        {
+            if (is_compressed(entry))
+                throw std::runtime_error("\nAsset " + get_name(entry) + " is compressed and has no span.");
+
+            return ByteSpan{file.get_data() + entry.offset, static_cast<size_t>(entry.size)};
+        }
+
+        void AssetPack::read(const PackEntry& entry, uint64_t offset, uint64_t size, uint8_t* destination, Jobs::JobSystem* jobs) const
+        {
+            if (offset > entry.size || size > entry.size - offset)
+                throw std::runtime_error("\nRead past the end of asset " + get_name(entry) + ".");
+            if (size == 0)
+                return;
+
+            if (!is_compressed(entry))
+            {
+                memcpy(destination, file.get_data() + entry.offset + offset, static_cast<size_t>(size));
+                return;
+            }
+
+            uint64_t chunk_size = header->chunk_size;
+            uint32_t first = static_cast<uint32_t>(offset / chunk_size);
+            uint32_t last = static_cast<uint32_t>((offset + size - 1) / chunk_size);
+
+            auto read_chunks = [&](uint32_t begin, uint32_t end) {
+                for (uint32_t c = first + begin; c < first + end; c++)
+                {
+                    uint64_t chunk_start = c * chunk_size;
+                    uint64_t start = std::max(offset, chunk_start);
+                    uint64_t stop = std::min(offset + size, chunk_start + chunk_size);
+                    read_chunk(entry, c, start - chunk_start, stop - start, destination + (start - offset));
+                }
+            };
+
+            uint32_t count = last - first + 1;
+            if (jobs && count > 1)
+                jobs->parallel_for(count, 1, read_chunks);
+            else
+                read_chunks(0, count);
+        }
+
+        void AssetPack::read_chunk(const PackEntry& entry, uint32_t chunk_index, uint64_t offset, uint64_t size, uint8_t* destination) const
+        {
+            const PackChunk& chunk = chunks[entry.first_chunk + chunk_index];
+            const uint8_t* source = file.get_data() + chunk.offset;
+
+            uint64_t chunk_start = static_cast<uint64_t>(chunk_index) * header->chunk_size;
+            size_t chunk_bytes = static_cast<size_t>(std::min<uint64_t>(header->chunk_size, entry.size - chunk_start));
+
+            if (chunk.codec == Codec::None)
+            {
+                memcpy(destination, source + offset, static_cast<size_t>(size));
+                return;
+            }
+
+            // A partial chunk is decompressed aside; whole chunks go straight to the destination.
+            static thread_local std::vector<uint8_t> scratch;
+            uint8_t* target = destination;
+            if (offset != 0 || size != chunk_bytes)
+            {
+                scratch.resize(chunk_bytes);
+                target = scratch.data();
+            }
+
+            bool ok = false;
+            if (chunk.codec == Codec::LZ4)
+                ok = lz4_decompress(source, chunk.stored_size, target, chunk_bytes);
+            #ifdef VGE_HAVE_ZSTD
+                else if (chunk.codec == Codec::Zstd)
+                    ok = ZSTD_decompress(target, chunk_bytes, source, chunk.stored_size) == chunk_bytes;
+            #endif
+
+            if (!ok)
+                throw std::runtime_error("\nCorrupt chunk in asset " + get_name(entry) + " of " + path + ".");
+
+            if (target != destination)
+                memcpy(destination, target + offset, static_cast<size_t>(size));
+        }
+
+        void AssetPack::prefetch(const PackEntry& entry) const
+        {
+            file.prefetch(static_cast<size_t>(entry.offset), static_cast<size_t>(entry.stored_size));
+        }
+
+        void AssetPackWriter::add(const std::string& asset_path, std::vector<uint8_t> data)
+        {
+            uint64_t hash = hash_asset_path(asset_path);
+            for (const auto& entry : pending)
+                if (entry.hash == hash)
+                    throw std::runtime_error("\nAsset " + asset_path + " collides with " + entry.name + ".");
+
+            pending.push_back({asset_path, hash, std::move(data)});
+        }
+
+        void AssetPackWriter::add_file(const std::string& asset_path, const std::string& file_path)
+        {
+            std::ifstream input(file_path, std::ios::binary | std::ios::ate);
+            if (!input.is_open())
+                throw std::runtime_error("\nFailed to open " + file_path + ".");
+
+            std::vector<uint8_t> data(static_cast<size_t>(input.tellg()));
+            input.seekg(0);
+            input.read(reinterpret_cast<char*>(data.data()), data.size());
+
+            add(asset_path, std::move(data));
+        }
+
+        static size_t compress_chunk(Codec codec, const uint8_t* source, size_t size, std::vector<uint8_t>& output)
+        {
+            switch (codec)
+            {
+                case Codec::LZ4:
+                    output.resize(lz4_compress_bound(size));
+                    return lz4_compress(source, size, output.data(), output.size());
+                case Codec::Zstd:
+                    #ifdef VGE_HAVE_ZSTD
+                    {
+                        output.resize(ZSTD_compressBound(size));
+                        size_t result = ZSTD_compress(output.data(), output.size(), source, size, 19);
+                        return ZSTD_isError(result) ? 0 : result;
+                    }
+                    #endif
+                default:
+                    return 0;
+            }
+        }
+
+        void AssetPackWriter::write(const std::string& output_path, Codec codec, uint32_t chunk_size, uint32_t alignment)
+        {
+            if (!is_codec_supported(codec))
+                throw std::runtime_error(std::string("\nCodec ") + codec_name(codec) + " is not available in this build.");
+            if (!is_power_of_two(chunk_size) || !is_power_of_two(alignment))
+                throw std::runtime_error("\nChunk size and alignment must be powers of two.");
+
+            std::sort(pending.begin(), pending.end(), [](const PendingEntry& a, const PendingEntry& b) { return a.hash < b.hash; });
+
+            std::string temporary_path = output_path + ".tmp";
+            std::ofstream output(temporary_path, std::ios::binary | std::ios::trunc);
+            if (!output.is_open())
+                throw std::runtime_error("\nFailed to create " + temporary_path + ".");
+
+            uint64_t position = 0;
+            auto write_bytes = [&](const void* data, size_t size) {
+                output.write(static_cast<const char*>(data), size);
+                position += size;
+            };
+            auto pad_to = [&](uint64_t boundary) {
+                static const char zeros[4096] = {};
+                while (position % boundary != 0)
+                    write_bytes(zeros, static_cast<size_t>(std::min<uint64_t>(boundary - position % boundary, sizeof(zeros))));
+            };
+
+            PackHeader header{};
+            memcpy(header.magic, pack_magic, sizeof(pack_magic));
+            header.version = pack_version;
+            header.alignment = alignment;
+            header.chunk_size = chunk_size;
+            write_bytes(&header, sizeof(header));
+
+            std::vector<PackEntry> entries;
+            std::vector<PackChunk> chunks;
+            std::string names;
+            std::vector<uint8_t> compressed;
+            std::vector<std::vector<uint8_t>> stored_chunks;
+
+            statistics = Statistics{};
+
+            for (const auto& pending_entry : pending)
+            {
+                const std::vector<uint8_t>& data = pending_entry.data;
+
+                PackEntry entry{};
+                entry.path_hash = pending_entry.hash;
+                entry.size = data.size();
+                entry.name_offset = static_cast<uint32_t>(names.size());
+                entry.name_length = static_cast<uint32_t>(pending_entry.name.size());
+                names += pending_entry.name;
+
+                pad_to(alignment);
+                entry.offset = position;
+
+                // Compress every chunk first: if none shrinks, the blob is stored as is
+                // and stays readable in place.
+                std::vector<PackChunk> entry_chunks;
+                stored_chunks.clear();
+                bool any_compressed = false;
+
+                if (codec != Codec::None)
+                {
+                    for (uint64_t start = 0; start < data.size(); start += chunk_size)
+                    {
+                        size_t length = static_cast<size_t>(std::min<uint64_t>(chunk_size, data.size() - start));
+                        size_t compressed_size = compress_chunk(codec, data.data() + start, length, compressed);
+
+                        PackChunk chunk{};
+                        if (compressed_size != 0 && compressed_size < length)
+                        {
+                            chunk.codec = codec;
+                            stored_chunks.emplace_back(compressed.begin(), compressed.begin() + compressed_size);
+                            any_compressed = true;
+                        }
+                        else
+                        {
+                            chunk.codec = Codec::None;
+                            stored_chunks.emplace_back(data.begin() + start, data.begin() + start + length);
+                        }
+                        chunk.stored_size = static_cast<uint32_t>(stored_chunks.back().size());
+                        entry_chunks.push_back(chunk);
+                    }
+                }
+
+                if (any_compressed)
+                {
+                    entry.first_chunk = static_cast<uint32_t>(chunks.size());
+                    entry.chunk_count = static_cast<uint32_t>(entry_chunks.size());
+
+                    for (size_t c = 0; c < entry_chunks.size(); c++)
+                    {
+                        entry_chunks[c].offset = position;
+                        write_bytes(stored_chunks[c].data(), stored_chunks[c].size());
+                        chunks.push_back(entry_chunks[c]);
+
+                        statistics.chunks++;
+                        if (entry_chunks[c].codec == Codec::None)
+                            statistics.raw_chunks++;
+                    }
+                }
+                else
+                    write_bytes(data.data(), data.size());
+
+                entry.stored_size = position - entry.offset;
+                entries.push_back(entry);
+
+                statistics.entries++;
+                statistics.bytes += entry.size;
+                statistics.stored_bytes += entry.stored_size;
+            }
+
+            pad_to(alignof(PackChunk));
+            header.chunk_count = chunks.size();
+            header.chunk_table_offset = position;
+            write_bytes(chunks.data(), chunks.size() * sizeof(PackChunk));
+
+            pad_to(alignof(PackEntry));
+            header.entry_count = entries.size();
+            header.toc_offset = position;
+            write_bytes(entries.data(), entries.size() * sizeof(PackEntry));
+
+            header.names_offset = position;
+            header.names_size = names.size();
+            write_bytes(names.data(), names.size());
+
+            header.file_size = position;
+            output.seekp(0);
+            output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            output.close();
+
+            if (!output)
+                throw std::runtime_error("\nFailed to write " + temporary_path + ".");
+
+            std::error_code error;
+            std::filesystem::rename(temporary_path, output_path, error);
+            if (error)
+            {
+                std::filesystem::remove(temporary_path, error);
+                throw std::runtime_error("\nFailed to replace " + output_path + ".");
+            }
+        }
+    };
+};
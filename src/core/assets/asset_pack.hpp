@@ -0,0 +1,219 @@
+#pragma once
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-07
+ *
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <stdexcept>
+
+#include "../utils/mapped_file.hpp"
+
+namespace VulkanGameEngine
+{
+    namespace Jobs
+    {
+        class JobSystem;
+    };
+
+    namespace Assets
+    {
+        enum class Codec : uint16_t
+        {
+            None = 0,
+            LZ4 = 1,
+            Zstd = 2
+        };
+
+        /**
+         * On-disk layout, little endian:
+         *
+         *   PackHeader
+         *   blobs, each starting on a header.alignment boundary
+         *   PackChunk[chunk_count]    compressed blobs only
+         *   PackEntry[entry_count]    sorted by path_hash
+         *   path names                for tools and error messages
+         *
+         * A blob is either stored as is (chunk_count == 0), and read in place
+         * from the mapping, or split into chunk_size pieces compressed
+         * independently, so a blob decompresses in parallel. A chunk that does not
+         * shrink is stored raw (Codec::None).
+         */
+        struct PackHeader
+        {
+            char magic[4];
+            uint32_t version;
+            uint32_t alignment;
+            uint32_t chunk_size;
+            uint64_t entry_count;
+            uint64_t toc_offset;
+            uint64_t chunk_count;
+            uint64_t chunk_table_offset;
+            uint64_t names_offset;
+            uint64_t names_size;
+            uint64_t file_size;
+        };
+
+        struct PackEntry
+        {
+            uint64_t path_hash;
+            // First byte of the stored blob.
+            uint64_t offset;
+            uint64_t size;
+            uint64_t stored_size;
+            uint32_t first_chunk;
+            uint32_t chunk_count;
+            uint32_t name_offset;
+            uint32_t name_length;
+        };
+
+        struct PackChunk
+        {
+            uint64_t offset;
+            uint32_t stored_size;
+            Codec codec;
+            uint16_t reserved;
+        };
+
+        static_assert(sizeof(PackHeader) == 72, "PackHeader layout changed");
+        static_assert(sizeof(PackEntry) == 48, "PackEntry layout changed");
+        static_assert(sizeof(PackChunk) == 16, "PackChunk layout changed");
+
+        static const char pack_magic[4] = {'V', 'G', 'E', 'P'};
+        static const uint32_t pack_version = 1;
+
+        /**
+         * FNV-1a of the path with '\' normalized to '/'.
+         */
+        uint64_t hash_asset_path(const std::string& path);
+
+        bool is_codec_supported(Codec codec);
+
+        const char* codec_name(Codec codec);
+
+        /**
+         * Read-only view of bytes owned by someone else (here, the mapping).
+         */
+        struct ByteSpan
+        {
+            const uint8_t* data = nullptr;
+            size_t size = 0;
+        };
+
+        /**
+         * Memory mapped asset pack.
+         *
+         * Lookups binary search the TOC. Uncompressed blobs are handed out as spans
+         * into the mapping (zero copy); compressed blobs are decompressed straight
+         * into the caller's memory, typically the uploader's staging ring, a chunk
+         * per job.
+         */
+        class AssetPack
+        {
+            private:
+                Utils::MappedFile file;
+                const PackHeader* header = nullptr;
+                const PackEntry* entries = nullptr;
+                const PackChunk* chunks = nullptr;
+                const char* names = nullptr;
+                std::string path;
+
+            public:
+                /**
+                 * Throws if the file is not a valid pack.
+                 */
+                void open(const std::string& path);
+
+                void close();
+
+                bool is_open() const { return header != nullptr; }
+
+                const PackHeader& get_header() const { return *header; }
+
+                size_t entry_count() const { return header ? static_cast<size_t>(header->entry_count) : 0; }
+
+                const PackEntry& get_entry(size_t index) const { return entries[index]; }
+
+                /**
+                 * nullptr when the path is not in the pack.
+                 */
+                const PackEntry* find(const std::string& asset_path) const;
+
+                const PackEntry* find(uint64_t path_hash) const;
+
+                std::string get_name(const PackEntry& entry) const;
+
+                bool is_compressed(const PackEntry& entry) const { return entry.chunk_count != 0; }
+
+                /**
+                 * The blob in place. Throws for compressed blobs.
+                 */
+                ByteSpan get_span(const PackEntry& entry) const;
+
+                /**
+                 * Copy or decompress bytes [offset, offset + size) of the blob into destination.
+                 * With a job system, the chunks are decompressed in parallel.
+                 */
+                void read(const PackEntry& entry, uint64_t offset, uint64_t size, uint8_t* destination, Jobs::JobSystem* jobs = nullptr) const;
+
+                void read(const PackEntry& entry, uint8_t* destination, Jobs::JobSystem* jobs = nullptr) const
+                {
+                    read(entry, 0, entry.size, destination, jobs);
+                }
+
+                /**
+                 * Ask the OS to start paging the blob in.
+                 */
+                void prefetch(const PackEntry& entry) const;
+
+            private:
+                void read_chunk(const PackEntry& entry, uint32_t chunk, uint64_t offset, uint64_t size, uint8_t* destination) const;
+        };
+
+        /**
+         * Builds a pack in memory and writes it out.
+         */
+        class AssetPackWriter
+        {
+            public:
+                struct Statistics
+                {
+                    uint64_t entries = 0;
+                    uint64_t bytes = 0;
+                    uint64_t stored_bytes = 0;
+                    uint64_t chunks = 0;
+                    uint64_t raw_chunks = 0;
+                };
+
+            private:
+                struct PendingEntry
+                {
+                    std::string name;
+                    uint64_t hash;
+                    std::vector<uint8_t> data;
+                };
+
+                std::vector<PendingEntry> pending;
+                Statistics statistics;
+
+            public:
+                /**
+                 * Throws when the path (or its hash) is already in the pack.
+                 */
+                void add(const std::string& asset_path, std::vector<uint8_t> data);
+
+                void add_file(const std::string& asset_path, const std::string& file_path);
+
+                /**
+                 * chunk_size and alignment must be powers of two.
+                 */
+                void write(const std::string& output_path, Codec codec, uint32_t chunk_size = 64 * 1024, uint32_t alignment = 4096);
+
+                const Statistics& get_statistics() const { return statistics; }
+        };
+    };
+};
@@ -0,0 +1,41 @@
+#include "asset_upload.hpp"
+
+namespace VulkanGameEngine
+{
+    namespace Assets
+    {
+        Graphics::UploadTicket upload_asset(
+            const AssetPack& pack,
+            const PackEntry& entry,
+            Graphics::Uploader& uploader,
+            VkBuffer buffer,
+            VkDeviceSize offset,
+            Jobs::JobSystem* jobs)
+        {
+            pack.prefetch(entry);
+
+            return upload_asset_range(pack, entry, 0, entry.size, uploader, buffer, offset, jobs);
+        }
+
+        Graphics::UploadTicket upload_asset_range(
+            const AssetPack& pack,
+            const PackEntry& entry,
+            uint64_t entry_offset,
+            uint64_t size,
+            Graphics::Uploader& uploader,
+            VkBuffer buffer,
+            VkDeviceSize offset,
+            Jobs::JobSystem* jobs,
+            const Graphics::Uploader::FillFunction& check)
+        {
+            if (entry_offset > entry.size || size > entry.size - entry_offset)
+                throw std::runtime_error("\nUploading past the end of " + pack.get_name(entry) + ".");
+
+            return uploader.upload_buffer(buffer, offset, size, [&](uint8_t* destination, VkDeviceSize source_offset, VkDeviceSize slice_size) {
+                pack.read(entry, entry_offset + source_offset, slice_size, destination, jobs);
+                if (check)
+                    check(destination, source_offset, slice_size);
+            });
+        }
+    };
+};
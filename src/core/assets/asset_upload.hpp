@@ -0,0 +1,45 @@
+#pragma once
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-07
+ *
+ */
+
+#include "asset_pack.hpp"
+#include "../graphics/uploader.hpp"
+
+namespace VulkanGameEngine
+{
+    namespace Assets
+    {
+        /**
+         * Upload a packed blob into buffer at offset. The blob is copied or
+         * decompressed straight into the uploader's staging ring, so it never
+         * exists in an intermediate heap buffer. With a job system, the chunks
+         * of each staging slice are decompressed in parallel.
+         */
+        Graphics::UploadTicket upload_asset(
+            const AssetPack& pack,
+            const PackEntry& entry,
+            Graphics::Uploader& uploader,
+            VkBuffer buffer,
+            VkDeviceSize offset = 0,
+            Jobs::JobSystem* jobs = nullptr);
+
+        /**
+         * Same as above for bytes [entry_offset, entry_offset + size) of the blob.
+         * check, if given, sees every staged slice once it is written, e.g. to
+         * validate it; it may throw.
+         */
+        Graphics::UploadTicket upload_asset_range(
+            const AssetPack& pack,
+            const PackEntry& entry,
+            uint64_t entry_offset,
+            uint64_t size,
+            Graphics::Uploader& uploader,
+            VkBuffer buffer,
+            VkDeviceSize offset = 0,
+            Jobs::JobSystem* jobs = nullptr,
+            const Graphics::Uploader::FillFunction& check = nullptr);
+    };
+};
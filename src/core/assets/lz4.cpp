@@ -0,0 +1,228 @@
+#include "lz4.hpp"
+
+#include <cstring>
+#include <vector>
+#include <algorithm>
+
+namespace VulkanGameEngine
+{
+    namespace Assets
+    {
+        static const size_t min_match = 4;
+        // The last 5 bytes are always literals, and the last match starts 12 bytes before the end.
+        static const size_t last_literals = 5;
+        static const size_t match_find_limit = 12;
+        static const size_t max_offset = 65535;
+        static const uint32_t hash_bits = 12;
+        static const size_t wild_copy = 16;
+
+        static uint32_t read32(const uint8_t* p)
+        {
+            uint32_t value;
+            memcpy(&value, p, sizeof(value));
+            return value;
+        }
+
+        static uint32_t hash_sequence(uint32_t sequence)
+        {
+            return (sequence * 2654435761u) >> (32 - hash_bits);
+        }
+
+        /**
+         * Writes a 4-bit length field's overflow as 255-continued bytes.
+         */
+        static bool write_length(uint8_t*& out, const uint8_t* end, size_t length)
+        {
+            for (; length >= 255; length -= 255)
+            {
+                if (out >= end)
+                    return false;
+                *out++ = 255;
+            }
+            if (out >= end)
+                return false;
+            *out++ = static_cast<uint8_t>(length);
+            return true;
+        }
+
+        static bool write_sequence(
+            uint8_t*& out, const uint8_t* end,
+            const uint8_t* literals, size_t literal_length,
+            size_t offset, size_t match_length)
+        {
+            if (out >= end)
+                return false;
+            uint8_t* token = out++;
+
+            size_t match_code = match_length ? match_length - min_match : 0;
+            *token = static_cast<uint8_t>((literal_length >= 15 ? 15 : literal_length) << 4);
+            if (match_length)
+                *token |= static_cast<uint8_t>(match_code >= 15 ? 15 : match_code);
+
+            if (literal_length >= 15 && !write_length(out, end, literal_length - 15))
+                return false;
+
+            if (static_cast<size_t>(end - out) < literal_length)
+                return false;
+            memcpy(out, literals, literal_length);
+            out += literal_length;
+
+            // The last sequence has literals only.
+            if (!match_length)
+                return true;
+
+            if (end - out < 2)
+                return false;
+            *out++ = static_cast<uint8_t>(offset & 0xff);
+            *out++ = static_cast<uint8_t>(offset >> 8);
+
+            if (match_code >= 15 && !write_length(out, end, match_code - 15))
+                return false;
+
+            return true;
+        }
+
+        size_t lz4_compress_bound(size_t size)
+        {
+            return size + size / 255 + 16;
+        }
+
+        size_t lz4_compress(const uint8_t* source, size_t size, uint8_t* destination, size_t capacity)
+        {
+            uint8_t* out = destination;
+            const uint8_t* end = destination + capacity;
+
+            size_t anchor = 0;
+
+            if (size > match_find_limit)
+            {
+                std::vector<uint32_t> table(size_t(1) << hash_bits, UINT32_MAX);
+                size_t limit = size - match_find_limit;
+                size_t match_end_limit = size - last_literals;
+
+                for (size_t position = 0; position < limit;)
+                {
+                    uint32_t sequence = read32(source + position);
+                    uint32_t hash = hash_sequence(sequence);
+                    uint32_t candidate = table[hash];
+                    table[hash] = static_cast<uint32_t>(position);
+
+                    if (candidate == UINT32_MAX || position - candidate > max_offset || read32(source + candidate) != sequence)
+                    {
+                        position++;
+                        continue;
+                    }
+
+                    size_t length = min_match;
+                    while (position + length < match_end_limit && source[candidate + length] == source[position + length])
+                        length++;
+
+                    if (!write_sequence(out, end, source + anchor, position - anchor, position - candidate, length))
+                        return 0;
+
+                    position += length;
+                    anchor = position;
+
+                    // Keep the table warm around the match end for the next search.
+                    if (position - 2 < limit)
+                        table[hash_sequence(read32(source + position - 2))] = static_cast<uint32_t>(position - 2);
+                }
+            }
+
+            if (!write_sequence(out, end, source + anchor, size - anchor, 0, 0))
+                return 0;
+
+            return static_cast<size_t>(out - destination);
+        }
+
+        bool lz4_decompress(const uint8_t* source, size_t size, uint8_t* destination, size_t destination_size)
+        {
+            size_t in = 0;
+            size_t out = 0;
+
+            while (in < size)
+            {
+                uint8_t token = source[in++];
+
+                size_t literal_length = token >> 4;
+                if (literal_length == 15)
+                {
+                    uint8_t byte;
+                    do
+                    {
+                        if (in >= size)
+                            return false;
+                        byte = source[in++];
+                        literal_length += byte;
+                    } while (byte == 255);
+                }
+
+                if (literal_length > size - in || literal_length > destination_size - out)
+                    return false;
+                // Short runs are the common case: a fixed size copy compiles to two moves.
+                if (literal_length <= wild_copy && size - in >= wild_copy && destination_size - out >= wild_copy)
+                    memcpy(destination + out, source + in, wild_copy);
+                else
+                    memcpy(destination + out, source + in, literal_length);
+                in += literal_length;
+                out += literal_length;
+
+                // The last sequence ends after its literals.
+                if (in == size)
+                    break;
+
+                if (size - in < 2)
+                    return false;
+                size_t offset = source[in] | (static_cast<size_t>(source[in + 1]) << 8);
+                in += 2;
+                if (offset == 0 || offset > out)
+                    return false;
+
+                size_t match_length = token & 15;
+                if (match_length == 15)
+                {
+                    uint8_t byte;
+                    do
+                    {
+                        if (in >= size)
+                            return false;
+                        byte = source[in++];
+                        match_length += byte;
+                    } while (byte == 255);
+                }
+                match_length += min_match;
+
+                if (match_length > destination_size - out)
+                    return false;
+
+                const uint8_t* match = destination + out - offset;
+                if (offset >= 8 && destination_size - out >= match_length + 8)
+                {
+                    // 8 byte steps never overlap their own source and may write past
+                    // the match, into room the next sequence overwrites anyway.
+                    for (size_t i = 0; i < match_length; i += 8)
+                        memcpy(destination + out + i, match + i, 8);
+                }
+                else if (offset >= match_length)
+                    memcpy(destination + out, match, match_length);
+                else if (offset == 1)
+                    memset(destination + out, *match, match_length);
+                else
+                {
+                    // An overlapping match repeats the last offset bytes. Every copy of
+                    // a multiple of offset keeps the period, so the step can double.
+                    size_t step = offset;
+                    for (size_t copied = 0; copied < match_length; step *= 2)
+                    {
+                        size_t length = std::min(step, match_length - copied);
+                        memcpy(destination + out + copied, match, length);
+                        copied += length;
+                    }
+                }
+                out += match_length;
+            }
+
+            return out == destination_size;
+        }
+    };
+};
@@ -0,0 +1,37 @@
+#pragma once
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-07
+ *
+ */
+
+#include <cstdint>
+#include <cstddef>
+
+namespace VulkanGameEngine
+{
+    namespace Assets
+    {
+        /**
+         * LZ4 block format (no frame header), compatible with LZ4_compress_default /
+         * LZ4_decompress_safe. The compressor is the single pass greedy variant:
+         * packing is an offline step, decompression speed is what matters.
+         */
+
+        /**
+         * Largest compressed size of size input bytes.
+         */
+        size_t lz4_compress_bound(size_t size);
+
+        /**
+         * Returns the compressed size, or 0 if it does not fit in capacity.
+         */
+        size_t lz4_compress(const uint8_t* source, size_t size, uint8_t* destination, size_t capacity);
+
+        /**
+         * Decompresses exactly destination_size bytes. Returns false on malformed
+         * input; never reads or writes out of bounds.
+         */
+        bool lz4_decompress(const uint8_t* source, size_t size, uint8_t* destination, size_t destination_size);
+    };
+};
@@ -0,0 +1,29 @@
+#include "deletion_queue.hpp"
+
+namespace VulkanGameEngine
+{
+    namespace Graphics
+    {
+        void DeletionQueue::push(uint64_t last_use_frame, std::function<void()> destroy)
+        {
+            entries.push_back({last_use_frame, std::move(destroy)});
+        }
+
+        void DeletionQueue::flush(uint64_t completed_frame)
+        {
+            // Entries are pushed in frame order, so the oldest are at the front.
+            while (!entries.empty() && entries.front().last_use_frame <= completed_frame)
+            {
+                entries.front().destroy();
+                entries.pop_front();
+            }
+        }
+
+        void DeletionQueue::flush_all()
+        {
+            for (auto& entry : entries)
+                entry.destroy();
+            entries.clear();
+        }
+    };
+};
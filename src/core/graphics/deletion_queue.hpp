@@ -0,0 +1,51 @@
+#pragma once
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-09-23
+ *
+ */
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+
+namespace VulkanGameEngine
+{
+    namespace Graphics
+    {
+        /**
+         * Defers destruction of GPU objects until the frames that may still
+         * reference them have completed, so nothing has to wait for the device
+         * to go idle.
+         */
+        class DeletionQueue
+        {
+            private:
+                struct Entry
+                {
+                    uint64_t last_use_frame;
+                    std::function<void()> destroy;
+                };
+
+                std::deque<Entry> entries;
+
+            public:
+                /**
+                 * Queue an object for destruction once last_use_frame has completed on the GPU.
+                 */
+                void push(uint64_t last_use_frame, std::function<void()> destroy);
+
+                /**
+                 * Destroy every object whose last use is at or before completed_frame.
+                 */
+                void flush(uint64_t completed_frame);
+
+                /**
+                 * Destroy everything. The device must be idle.
+                 */
+                void flush_all();
+
+                size_t size() const { return entries.size(); }
+        };
+    };
+};
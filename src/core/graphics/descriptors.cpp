@@ -0,0 +1,450 @@
+#include "descriptors.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+namespace VulkanGameEngine
+{
+    namespace Graphics
+    {
+        const uint32_t DescriptorAllocator::max_sets_per_pool;
+
+        static void hash_combine(uint64_t& hash, uint64_t value)
+        {
+            // FNV-1a over the 8 bytes of value.
+            for (int i = 0; i < 8; i++)
+            {
+                hash ^= (value >> (i * 8)) & 0xff;
+                hash *= 1099511628211ull;
+            }
+        }
+
+        DescriptorLayoutKey::DescriptorLayoutKey(
+            const std::vector<VkDescriptorSetLayoutBinding>& bindings,
+            VkDescriptorSetLayoutCreateFlags flags,
+            const std::vector<VkDescriptorBindingFlags>& binding_flags)
+            : flags(flags)
+        {
+            if (!binding_flags.empty() && binding_flags.size() != bindings.size())
+                throw std::runtime_error("\nDescriptor binding flags must match the bindings one to one.");
+
+            std::vector<size_t> order(bindings.size());
+            std::iota(order.begin(), order.end(), 0);
+            std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return bindings[a].binding < bindings[b].binding; });
+
+            for (size_t i : order)
+            {
+                this->bindings.push_back(bindings[i]);
+                if (!binding_flags.empty())
+                    this->binding_flags.push_back(binding_flags[i]);
+            }
+        }
+
+        bool DescriptorLayoutKey::operator==(const DescriptorLayoutKey& other) const
+        {
+            if (flags != other.flags || bindings.size() != other.bindings.size() || binding_flags != other.binding_flags)
+                return false;
+
+            for (size_t i = 0; i < bindings.size(); i++)
+            {
+                const VkDescriptorSetLayoutBinding& a = bindings[i];
+                const VkDescriptorSetLayoutBinding& b = other.bindings[i];
+                if (a.binding != b.binding || a.descriptorType != b.descriptorType || a.descriptorCount != b.descriptorCount ||
+                    a.stageFlags != b.stageFlags || a.pImmutableSamplers != b.pImmutableSamplers)
+                    return false;
+            }
+
+            return true;
+        }
+
+        size_t DescriptorLayoutKeyHash::operator()(const DescriptorLayoutKey& key) const
+        {
+            uint64_t hash = 14695981039346656037ull;
+            hash_combine(hash, key.flags);
+
+            for (const auto& binding : key.bindings)
+            {
+                hash_combine(hash, binding.binding);
+                hash_combine(hash, static_cast<uint64_t>(binding.descriptorType));
+                hash_combine(hash, binding.descriptorCount);
+                hash_combine(hash, binding.stageFlags);
+                hash_combine(hash, reinterpret_cast<uintptr_t>(binding.pImmutableSamplers));
+            }
+            for (auto flags : key.binding_flags)
+                hash_combine(hash, flags);
+
+            return static_cast<size_t>(hash);
+        }
+
+        void DescriptorLayoutCache::init(VkDevice device)
+        {
+            this->device = device;
+        }
+
+        void DescriptorLayoutCache::cleanup()
+        {
+            for (auto& entry : layouts)
+                vkDestroyDescriptorSetLayout(device, entry.second, nullptr);
+            layouts.clear();
+        }
+
+        VkDescriptorSetLayout DescriptorLayoutCache::get_layout(
+            const std::vector<VkDescriptorSetLayoutBinding>& bindings,
+            VkDescriptorSetLayoutCreateFlags flags,
+            const std::vector<VkDescriptorBindingFlags>& binding_flags)
+        {
+            DescriptorLayoutKey key(bindings, flags, binding_flags);
+
+            auto found = layouts.find(key);
+            if (found != layouts.end())
+            {
+                statistics.hits++;
+                return found->second;
+            }
+            statistics.misses++;
+
+            VkDescriptorSetLayoutBindingFlagsCreateInfoEXT flags_info{};
+            flags_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT;
+            flags_info.bindingCount = static_cast<uint32_t>(key.binding_flags.size());
+            flags_info.pBindingFlags = key.binding_flags.data();
+
+            VkDescriptorSetLayoutCreateInfo create_info{};
+            create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+            create_info.pNext = key.binding_flags.empty() ? nullptr : &flags_info;
+            create_info.flags = flags;
+            create_info.bindingCount = static_cast<uint32_t>(key.bindings.size());
+            create_info.pBindings = key.bindings.data();
+
+            VkDescriptorSetLayout layout;
+            if (vkCreateDescriptorSetLayout(device, &create_info, nullptr, &layout) != VK_SUCCESS)
+                throw std::runtime_error("\nFailed to create descriptor set layout.");
+
+            layouts.emplace(std::move(key), layout);
+            return layout;
+        }
+
+        std::vector<DescriptorAllocator::PoolRatio> DescriptorAllocator::default_ratios()
+        {
+            return {
+                {VK_DESCRIPTOR_TYPE_SAMPLER, 0.5f},
+                {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4.0f},
+                {VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 4.0f},
+                {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1.0f},
+                {VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER, 1.0f},
+                {VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER, 1.0f},
+                {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2.0f},
+                {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2.0f},
+                {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1.0f},
+                {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1.0f},
+                {VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, 0.5f},
+            };
+        }
+
+        void DescriptorAllocator::init(
+            VkDevice device,
+            uint32_t initial_sets_per_pool,
+            const std::vector<PoolRatio>& ratios,
+            VkDescriptorPoolCreateFlags pool_flags)
+        {
+            this->device = device;
+            this->ratios = ratios;
+            this->pool_flags = pool_flags;
+            this->sets_per_pool = std::max(1u, std::min(initial_sets_per_pool, max_sets_per_pool));
+        }
+
+        void DescriptorAllocator::cleanup()
+        {
+            for (auto pool : used_pools)
+                vkDestroyDescriptorPool(device, pool, nullptr);
+            for (auto pool : free_pools)
+                vkDestroyDescriptorPool(device, pool, nullptr);
+            if (current_pool != VK_NULL_HANDLE)
+                vkDestroyDescriptorPool(device, current_pool, nullptr);
+
+            used_pools.clear();
+            free_pools.clear();
+            current_pool = VK_NULL_HANDLE;
+        }
+
+        VkDescriptorSet DescriptorAllocator::allocate(VkDescriptorSetLayout layout, uint32_t variable_descriptor_count)
+        {
+            if (current_pool == VK_NULL_HANDLE)
+                current_pool = grab_pool();
+
+            VkDescriptorSet set;
+            if (try_allocate(current_pool, layout, variable_descriptor_count, set))
+                return set;
+
+            // The pool is full (or fragmented): retire it until the next reset and move on.
+            used_pools.push_back(current_pool);
+            current_pool = grab_pool();
+
+            if (try_allocate(current_pool, layout, variable_descriptor_count, set))
+                return set;
+
+            throw std::runtime_error("\nFailed to allocate descriptor set from a fresh pool.");
+        }
+
+        void DescriptorAllocator::reset()
+        {
+            if (current_pool != VK_NULL_HANDLE)
+                used_pools.push_back(current_pool);
+            current_pool = VK_NULL_HANDLE;
+
+            for (auto pool : used_pools)
+            {
+                vkResetDescriptorPool(device, pool, 0);
+                free_pools.push_back(pool);
+            }
+            used_pools.clear();
+
+            statistics.resets++;
+        }
+
+        VkDescriptorPool DescriptorAllocator::grab_pool()
+        {
+            if (!free_pools.empty())
+            {
+                VkDescriptorPool pool = free_pools.back();
+                free_pools.pop_back();
+                return pool;
+            }
+
+            std::vector<VkDescriptorPoolSize> sizes;
+            for (const auto& ratio : ratios)
+                sizes.push_back({ratio.type, std::max(1u, static_cast<uint32_t>(ratio.ratio * sets_per_pool))});
+
+            VkDescriptorPoolCreateInfo create_info{};
+            create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+            create_info.flags = pool_flags;
+            create_info.maxSets = sets_per_pool;
+            create_info.poolSizeCount = static_cast<uint32_t>(sizes.size());
+            create_info.pPoolSizes = sizes.data();
+
+            VkDescriptorPool pool;
+            if (vkCreateDescriptorPool(device, &create_info, nullptr, &pool) != VK_SUCCESS)
+                throw std::runtime_error("\nFailed to create descriptor pool.");
+
+            statistics.pools_created++;
+            sets_per_pool = std::min(sets_per_pool * 2, max_sets_per_pool);
+            return pool;
+        }
+
+        bool DescriptorAllocator::try_allocate(VkDescriptorPool pool, VkDescriptorSetLayout layout, uint32_t variable_descriptor_count, VkDescriptorSet& set)
+        {
+            VkDescriptorSetVariableDescriptorCountAllocateInfoEXT count_info{};
+            count_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_VARIABLE_DESCRIPTOR_COUNT_ALLOCATE_INFO_EXT;
+            count_info.descriptorSetCount = 1;
+            count_info.pDescriptorCounts = &variable_descriptor_count;
+
+            VkDescriptorSetAllocateInfo allocate_info{};
+            allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+            allocate_info.pNext = variable_descriptor_count ? &count_info : nullptr;
+            allocate_info.descriptorPool = pool;
+            allocate_info.descriptorSetCount = 1;
+            allocate_info.pSetLayouts = &layout;
+
+            VkResult result = vkAllocateDescriptorSets(device, &allocate_info, &set);
+            if (result == VK_SUCCESS)
+            {
+                statistics.sets_allocated++;
+                return true;
+            }
+            if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL)
+                return false;
+
+            throw std::runtime_error("\nFailed to allocate descriptor set.");
+        }
+
+        uint32_t BindlessTable::Slots::acquire()
+        {
+            if (!free.empty())
+            {
+                uint32_t index = free.back();
+                free.pop_back();
+                return index;
+            }
+
+            if (next == capacity)
+                return invalid_index;
+            return next++;
+        }
+
+        void BindlessTable::init(
+            VkDevice device,
+            const Utils::DeviceCapabilities& capabilities,
+            DescriptorLayoutCache& layout_cache,
+            uint32_t max_textures,
+            uint32_t max_buffers)
+        {
+            if (!capabilities.supports_bindless())
+                throw std::runtime_error("\nDevice does not support bindless descriptors.");
+
+            this->device = device;
+
+            const VkPhysicalDeviceDescriptorIndexingPropertiesEXT& limits = capabilities.descriptor_indexing_properties;
+            max_textures = std::min({max_textures,
+                limits.maxDescriptorSetUpdateAfterBindSampledImages,
+                limits.maxDescriptorSetUpdateAfterBindSamplers,
+                limits.maxPerStageDescriptorUpdateAfterBindSampledImages,
+                limits.maxPerStageDescriptorUpdateAfterBindSamplers});
+            max_buffers = std::min({max_buffers,
+                limits.maxDescriptorSetUpdateAfterBindStorageBuffers,
+                limits.maxPerStageDescriptorUpdateAfterBindStorageBuffers});
+            if (max_textures + max_buffers > limits.maxPerStageUpdateAfterBindResources)
+                max_textures = limits.maxPerStageUpdateAfterBindResources > max_buffers ? limits.maxPerStageUpdateAfterBindResources - max_buffers : 1;
+
+            textures.capacity = max_textures;
+            buffers.capacity = max_buffers;
+
+            std::vector<VkDescriptorSetLayoutBinding> bindings = {
+                {texture_binding, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, max_textures, VK_SHADER_STAGE_ALL, nullptr},
+                {buffer_binding, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, max_buffers, VK_SHADER_STAGE_ALL, nullptr},
+            };
+
+            // Slots not registered yet are never read, and registering one must not
+            // wait for the command buffers that have the set bound.
+            VkDescriptorBindingFlags flags =
+                VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT |
+                VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT |
+                VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT_EXT;
+
+            layout = layout_cache.get_layout(bindings, VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT, {flags, flags});
+
+            VkDescriptorPoolSize sizes[] = {
+                {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, max_textures},
+                {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, max_buffers},
+            };
+
+            VkDescriptorPoolCreateInfo pool_info{};
+            pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+            pool_info.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT;
+            pool_info.maxSets = 1;
+            pool_info.poolSizeCount = 2;
+            pool_info.pPoolSizes = sizes;
+
+            if (vkCreateDescriptorPool(device, &pool_info, nullptr, &pool) != VK_SUCCESS)
+                throw std::runtime_error("\nFailed to create bindless descriptor pool.");
+
+            VkDescriptorSetAllocateInfo allocate_info{};
+            allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+            allocate_info.descriptorPool = pool;
+            allocate_info.descriptorSetCount = 1;
+            allocate_info.pSetLayouts = &layout;
+
+            if (vkAllocateDescriptorSets(device, &allocate_info, &set) != VK_SUCCESS)
+                throw std::runtime_error("\nFailed to allocate bindless descriptor set.");
+        }
+
+        void BindlessTable::cleanup()
+        {
+            // The layout belongs to the layout cache.
+            if (pool != VK_NULL_HANDLE)
+                vkDestroyDescriptorPool(device, pool, nullptr);
+
+            pool = VK_NULL_HANDLE;
+            set = VK_NULL_HANDLE;
+            layout = VK_NULL_HANDLE;
+            textures = Slots{};
+            buffers = Slots{};
+        }
+
+        uint32_t BindlessTable::register_texture(VkImageView view, VkSampler sampler, VkImageLayout layout)
+        {
+            uint32_t index = textures.acquire();
+            if (index == invalid_index)
+                throw std::runtime_error("\nBindless texture table is full.");
+
+            pending_images.push_back({sampler, view, layout});
+            pending_image_indices.push_back(index);
+            return index;
+        }
+
+        uint32_t BindlessTable::register_buffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range)
+        {
+            uint32_t index = buffers.acquire();
+            if (index == invalid_index)
+                throw std::runtime_error("\nBindless buffer table is full.");
+
+            pending_buffers.push_back({buffer, offset, range});
+            pending_buffer_indices.push_back(index);
+            return index;
+        }
+
+        void BindlessTable::release_texture(uint32_t index, uint64_t frame_number)
+        {
+            textures.retiring.push_back({index, frame_number});
+        }
+
+        void BindlessTable::release_buffer(uint32_t index, uint64_t frame_number)
+        {
+            buffers.retiring.push_back({index, frame_number});
+        }
+
+        void BindlessTable::flush_updates()
+        {
+            if (pending_images.empty() && pending_buffers.empty())
+                return;
+
+            std::vector<VkWriteDescriptorSet> writes;
+            writes.reserve(pending_images.size() + pending_buffers.size());
+
+            for (size_t i = 0; i < pending_images.size(); i++)
+            {
+                VkWriteDescriptorSet write{};
+                write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                write.dstSet = set;
+                write.dstBinding = texture_binding;
+                write.dstArrayElement = pending_image_indices[i];
+                write.descriptorCount = 1;
+                write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+                write.pImageInfo = &pending_images[i];
+                writes.push_back(write);
+            }
+
+            for (size_t i = 0; i < pending_buffers.size(); i++)
+            {
+                VkWriteDescriptorSet write{};
+                write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                write.dstSet = set;
+                write.dstBinding = buffer_binding;
+                write.dstArrayElement = pending_buffer_indices[i];
+                write.descriptorCount = 1;
+                write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+                write.pBufferInfo = &pending_buffers[i];
+                writes.push_back(write);
+            }
+
+            vkUpdateDescriptorSets(device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+
+            pending_images.clear();
+            pending_image_indices.clear();
+            pending_buffers.clear();
+            pending_buffer_indices.clear();
+        }
+
+        void BindlessTable::retire_frames(uint64_t completed_frame)
+        {
+            for (Slots* slots : {&textures, &buffers})
+            {
+                auto& retiring = slots->retiring;
+                for (size_t i = 0; i < retiring.size();)
+                {
+                    if (retiring[i].second <= completed_frame)
+                    {
+                        slots->free.push_back(retiring[i].first);
+                        retiring[i] = retiring.back();
+                        retiring.pop_back();
+                    }
+                    else
+                        i++;
+                }
+            }
+        }
+
+        void BindlessTable::bind(VkCommandBuffer command_buffer, VkPipelineBindPoint bind_point, VkPipelineLayout pipeline_layout, uint32_t set_index) const
+        {
+            vkCmdBindDescriptorSets(command_buffer, bind_point, pipeline_layout, set_index, 1, &set, 0, nullptr);
+        }
+    };
+};
@@ -0,0 +1,242 @@
+#pragma once
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-03
+ *
+ */
+
+#include <iostream>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <stdexcept>
+
+#include "../utils/platform.hpp"
+#include "../utils/device_capabilities.hpp"
+
+namespace VulkanGameEngine
+{
+    namespace Graphics
+    {
+        /**
+         * What identifies a descriptor set layout in DescriptorLayoutCache: the
+         * bindings sorted by binding number, so declaration order does not matter.
+         * binding_flags is empty or has one entry per binding, in the order given.
+         */
+        struct DescriptorLayoutKey
+        {
+            VkDescriptorSetLayoutCreateFlags flags = 0;
+            std::vector<VkDescriptorSetLayoutBinding> bindings;
+            std::vector<VkDescriptorBindingFlags> binding_flags;
+
+            DescriptorLayoutKey(
+                const std::vector<VkDescriptorSetLayoutBinding>& bindings,
+                VkDescriptorSetLayoutCreateFlags flags = 0,
+                const std::vector<VkDescriptorBindingFlags>& binding_flags = {});
+
+            bool operator==(const DescriptorLayoutKey& other) const;
+
+            bool operator!=(const DescriptorLayoutKey& other) const { return !(*this == other); }
+        };
+
+        struct DescriptorLayoutKeyHash
+        {
+            size_t operator()(const DescriptorLayoutKey& key) const;
+        };
+
+        /**
+         * Descriptor set layouts deduplicated by their binding description.
+         * Identical descriptions always return the same VkDescriptorSetLayout,
+         * which also makes pipeline layouts built from them compatible.
+         */
+        class DescriptorLayoutCache
+        {
+            public:
+                struct Statistics
+                {
+                    uint64_t hits = 0;
+                    uint64_t misses = 0;
+                };
+
+            private:
+                VkDevice device = VK_NULL_HANDLE;
+                std::unordered_map<DescriptorLayoutKey, VkDescriptorSetLayout, DescriptorLayoutKeyHash> layouts;
+                Statistics statistics;
+
+            public:
+                void init(VkDevice device);
+
+                void cleanup();
+
+                /**
+                 * binding_flags is empty or has one entry per binding, in the order given.
+                 */
+                VkDescriptorSetLayout get_layout(
+                    const std::vector<VkDescriptorSetLayoutBinding>& bindings,
+                    VkDescriptorSetLayoutCreateFlags flags = 0,
+                    const std::vector<VkDescriptorBindingFlags>& binding_flags = {});
+
+                size_t size() const { return layouts.size(); }
+
+                const Statistics& get_statistics() const { return statistics; }
+        };
+
+        /**
+         * Allocates descriptor sets from pools created on demand.
+         *
+         * Sets are never freed one at a time: reset() recycles every pool at once.
+         * Keep one allocator per frame in flight and reset it once the frame's fence
+         * has been waited on, so per-draw sets cost a pointer bump in the driver.
+         */
+        class DescriptorAllocator
+        {
+            public:
+                /**
+                 * Descriptors of a type per set a pool is sized for.
+                 */
+                struct PoolRatio
+                {
+                    VkDescriptorType type;
+                    float ratio;
+                };
+
+                struct Statistics
+                {
+                    uint64_t sets_allocated = 0;
+                    uint32_t pools_created = 0;
+                    uint32_t resets = 0;
+                };
+
+            private:
+                VkDevice device = VK_NULL_HANDLE;
+                std::vector<PoolRatio> ratios;
+                VkDescriptorPoolCreateFlags pool_flags = 0;
+
+                VkDescriptorPool current_pool = VK_NULL_HANDLE;
+                std::vector<VkDescriptorPool> used_pools;
+                std::vector<VkDescriptorPool> free_pools;
+
+                // Each new pool holds more sets than the previous one, up to max_sets_per_pool.
+                uint32_t sets_per_pool = 0;
+
+                Statistics statistics;
+
+            public:
+                static const uint32_t max_sets_per_pool = 4096;
+
+                static std::vector<PoolRatio> default_ratios();
+
+                void init(
+                    VkDevice device,
+                    uint32_t initial_sets_per_pool = 256,
+                    const std::vector<PoolRatio>& ratios = default_ratios(),
+                    VkDescriptorPoolCreateFlags pool_flags = 0);
+
+                void cleanup();
+
+                VkDescriptorSet allocate(VkDescriptorSetLayout layout, uint32_t variable_descriptor_count = 0);
+
+                /**
+                 * Recycle every set allocated since the last reset.
+                 */
+                void reset();
+
+                const Statistics& get_statistics() const { return statistics; }
+
+            private:
+                VkDescriptorPool grab_pool();
+
+                bool try_allocate(VkDescriptorPool pool, VkDescriptorSetLayout layout, uint32_t variable_descriptor_count, VkDescriptorSet& set);
+        };
+
+        /**
+         * Global bindless descriptor table (VK_EXT_descriptor_indexing).
+         *
+         * One set holds every texture (binding 0, combined image samplers) and every
+         * storage buffer (binding 1). Draws push the indices they use instead of
+         * binding per-draw sets. The set is update-after-bind, so registering a
+         * resource never waits for the GPU; writes are batched until flush_updates().
+         *
+         * A released index is only reused once the frames that may still read it have
+         * completed (retire_frames), like the deletion queue.
+         */
+        class BindlessTable
+        {
+            public:
+                static const uint32_t texture_binding = 0;
+                static const uint32_t buffer_binding = 1;
+
+                static const uint32_t invalid_index = UINT32_MAX;
+
+            private:
+                struct Slots
+                {
+                    uint32_t capacity = 0;
+                    uint32_t next = 0;
+                    std::vector<uint32_t> free;
+                    // (index, frame it was released in)
+                    std::vector<std::pair<uint32_t, uint64_t>> retiring;
+
+                    uint32_t acquire();
+                };
+
+                VkDevice device = VK_NULL_HANDLE;
+                VkDescriptorSetLayout layout = VK_NULL_HANDLE;
+                VkDescriptorPool pool = VK_NULL_HANDLE;
+                VkDescriptorSet set = VK_NULL_HANDLE;
+
+                Slots textures;
+                Slots buffers;
+
+                std::vector<VkDescriptorImageInfo> pending_images;
+                std::vector<uint32_t> pending_image_indices;
+                std::vector<VkDescriptorBufferInfo> pending_buffers;
+                std::vector<uint32_t> pending_buffer_indices;
+
+            public:
+                /**
+                 * Needs DeviceCapabilities::supports_bindless() and the descriptor indexing
+                 * features enabled on the device. The capacities are clamped to the
+                 * device limits.
+                 */
+                void init(
+                    VkDevice device,
+                    const Utils::DeviceCapabilities& capabilities,
+                    DescriptorLayoutCache& layout_cache,
+                    uint32_t max_textures = 16384,
+                    uint32_t max_buffers = 4096);
+
+                void cleanup();
+
+                bool is_initialized() const { return set != VK_NULL_HANDLE; }
+
+                uint32_t register_texture(VkImageView view, VkSampler sampler, VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+                uint32_t register_buffer(VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
+
+                void release_texture(uint32_t index, uint64_t frame_number);
+
+                void release_buffer(uint32_t index, uint64_t frame_number);
+
+                /**
+                 * Write every registration since the last flush in one vkUpdateDescriptorSets.
+                 */
+                void flush_updates();
+
+                /**
+                 * Make indices released in frames up to completed_frame reusable.
+                 */
+                void retire_frames(uint64_t completed_frame);
+
+                void bind(VkCommandBuffer command_buffer, VkPipelineBindPoint bind_point, VkPipelineLayout pipeline_layout, uint32_t set_index) const;
+
+                VkDescriptorSetLayout get_layout() const { return layout; }
+
+                VkDescriptorSet get_set() const { return set; }
+
+                uint32_t get_texture_capacity() const { return textures.capacity; }
+
+                uint32_t get_buffer_capacity() const { return buffers.capacity; }
+        };
+    };
+};
@@ -0,0 +1,355 @@
+#include "draw_queue.hpp"
+#include "../jobs/job_system.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+
+namespace VulkanGameEngine
+{
+    namespace Graphics
+    {
+        const uint32_t DrawQueue::max_layers;
+        const uint32_t DrawQueue::max_ids;
+        const uint32_t DrawQueue::max_push_size;
+
+        // Smallest block of a parallel radix sort pass; smaller queues sort on the calling thread.
+        static const size_t radix_block_size = 16 * 1024;
+        static const uint32_t radix = 256;
+        static const uint32_t digits = 8;
+
+        static const uint64_t id_mask = 0xfff;
+        static const uint64_t depth_mask = 0xffffff;
+
+        uint64_t make_draw_key(const DrawState& state, DepthOrder order)
+        {
+            // NaN would pass the clamp and make the conversion undefined: anything
+            // non finite sorts as the far plane.
+            float depth = std::isfinite(state.depth) ? std::min(std::max(state.depth, 0.0f), 1.0f) : 1.0f;
+            uint64_t quantized = static_cast<uint64_t>(depth * static_cast<float>(depth_mask) + 0.5f) & depth_mask;
+
+            uint64_t key = static_cast<uint64_t>(state.layer & 0xf) << 60;
+            if (order == DepthOrder::BackToFront)
+                return key |
+                    (depth_mask - quantized) << 36 |
+                    (state.pipeline & id_mask) << 24 |
+                    (state.descriptor & id_mask) << 12 |
+                    (state.material & id_mask);
+
+            return key |
+                (state.pipeline & id_mask) << 48 |
+                (state.descriptor & id_mask) << 36 |
+                (state.material & id_mask) << 24 |
+                quantized;
+        }
+
+        void radix_sort(std::vector<SortEntry>& entries, std::vector<SortEntry>& scratch, Jobs::JobSystem* jobs)
+        {
+            size_t count = entries.size();
+            scratch.resize(count);
+            if (count < 2)
+                return;
+
+            uint32_t blocks = 1;
+            if (jobs && count >= 2 * radix_block_size)
+                blocks = static_cast<uint32_t>(std::min<size_t>(count / radix_block_size, jobs->get_worker_count() * 4));
+
+            auto run_blocks = [&](const std::function<void(uint32_t block, size_t first, size_t last)>& function) {
+                if (blocks == 1)
+                {
+                    function(0, 0, count);
+                    return;
+                }
+                jobs->parallel_for(blocks, 1, [&](uint32_t first, uint32_t last) {
+                    for (uint32_t block = first; block < last; block++)
+                        function(block, count * block / blocks, count * (block + 1) / blocks);
+                });
+            };
+
+            // One read for the histograms of every digit: the per-block ones serve
+            // the first pass, the totals tell which passes can be skipped.
+            std::vector<uint32_t> digit_counts(blocks * digits * radix, 0);
+            run_blocks([&](uint32_t block, size_t first, size_t last) {
+                uint32_t* histogram = &digit_counts[block * digits * radix];
+                for (size_t i = first; i < last; i++)
+                {
+                    uint64_t key = entries[i].key;
+                    for (uint32_t digit = 0; digit < digits; digit++)
+                        histogram[digit * radix + ((key >> (digit * 8)) & 0xff)]++;
+                }
+            });
+
+            std::vector<uint32_t> offsets(blocks * radix);
+            SortEntry* source = entries.data();
+            SortEntry* destination = scratch.data();
+            bool permuted = false;
+
+            for (uint32_t digit = 0; digit < digits; digit++)
+            {
+                uint32_t shift = digit * 8;
+
+                // Every key has the same digit: the pass would not move anything.
+                bool uniform = false;
+                for (uint32_t value = 0; value < radix && !uniform; value++)
+                {
+                    size_t total = 0;
+                    for (uint32_t block = 0; block < blocks; block++)
+                        total += digit_counts[(block * digits + digit) * radix + value];
+                    uniform = total == count;
+                }
+                if (uniform)
+                    continue;
+
+                if (!permuted)
+                {
+                    for (uint32_t block = 0; block < blocks; block++)
+                        memcpy(&offsets[block * radix], &digit_counts[(block * digits + digit) * radix], radix * sizeof(uint32_t));
+                }
+                else
+                {
+                    run_blocks([&](uint32_t block, size_t first, size_t last) {
+                        uint32_t* histogram = &offsets[block * radix];
+                        std::fill(histogram, histogram + radix, 0u);
+                        for (size_t i = first; i < last; i++)
+                            histogram[(source[i].key >> shift) & 0xff]++;
+                    });
+                }
+
+                // Digit-major, block-minor exclusive prefix sum: each block scatters
+                // its entries of a digit after the earlier blocks', which keeps the sort stable.
+                uint32_t sum = 0;
+                for (uint32_t value = 0; value < radix; value++)
+                    for (uint32_t block = 0; block < blocks; block++)
+                    {
+                        uint32_t bucket = offsets[block * radix + value];
+                        offsets[block * radix + value] = sum;
+                        sum += bucket;
+                    }
+
+                run_blocks([&](uint32_t block, size_t first, size_t last) {
+                    uint32_t* offset = &offsets[block * radix];
+                    for (size_t i = first; i < last; i++)
+                        destination[offset[(source[i].key >> shift) & 0xff]++] = source[i];
+                });
+
+                std::swap(source, destination);
+                permuted = true;
+            }
+
+            if (source != entries.data())
+                entries.swap(scratch);
+        }
+
+        uint32_t DrawQueue::add_pipeline(VkPipeline pipeline, VkPipelineLayout layout)
+        {
+            if (pipelines.size() >= max_ids)
+                throw std::runtime_error("\nFailed to add a draw queue pipeline: too many pipelines.");
+
+            pipelines.push_back(Pipeline{pipeline, layout});
+            return static_cast<uint32_t>(pipelines.size() - 1);
+        }
+
+        uint32_t DrawQueue::add_descriptor_set(VkDescriptorSet set)
+        {
+            if (descriptor_sets.size() >= max_ids)
+                throw std::runtime_error("\nFailed to add a draw queue descriptor set: too many descriptor sets.");
+
+            descriptor_sets.push_back(set);
+            return static_cast<uint32_t>(descriptor_sets.size() - 1);
+        }
+
+        void DrawQueue::begin_frame()
+        {
+            if (frame_statistics.draws > 0)
+            {
+                total_statistics.draws += frame_statistics.draws;
+                total_statistics.skipped += frame_statistics.skipped;
+                total_statistics.pipeline_binds += frame_statistics.pipeline_binds;
+                total_statistics.descriptor_binds += frame_statistics.descriptor_binds;
+                total_statistics.vertex_buffer_binds += frame_statistics.vertex_buffer_binds;
+                total_statistics.index_buffer_binds += frame_statistics.index_buffer_binds;
+                total_statistics.binds_eliminated += frame_statistics.binds_eliminated;
+                total_statistics.sort_ms += frame_statistics.sort_ms;
+                frames++;
+            }
+            frame_statistics = Statistics{};
+
+            draws.clear();
+            entries.clear();
+        }
+
+        void DrawQueue::submit(const DrawState& state, const DrawCommand& command)
+        {
+            if (state.pipeline >= pipelines.size() || state.descriptor >= descriptor_sets.size() || state.material >= descriptor_sets.size())
+                throw std::runtime_error("\nFailed to submit a draw: unknown pipeline or descriptor set id.");
+            if (command.push_size > max_push_size)
+                throw std::runtime_error("\nFailed to submit a draw: push constants too large.");
+
+            QueuedDraw draw;
+            draw.command = command;
+            draw.pipeline = static_cast<uint16_t>(state.pipeline);
+            draw.descriptor = static_cast<uint16_t>(state.descriptor);
+            draw.material = static_cast<uint16_t>(state.material);
+
+            entries.push_back(SortEntry{make_draw_key(state, layer_orders[state.layer % max_layers]), static_cast<uint32_t>(draws.size()), 0});
+            draws.push_back(draw);
+        }
+
+        void DrawQueue::sort(Jobs::JobSystem* jobs)
+        {
+            auto start = std::chrono::steady_clock::now();
+            radix_sort(entries, scratch, jobs);
+            frame_statistics.sort_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        void DrawQueue::record(VkCommandBuffer command_buffer)
+        {
+            frame_statistics.draws = 0;
+            frame_statistics.skipped = 0;
+            frame_statistics.pipeline_binds = 0;
+            frame_statistics.descriptor_binds = 0;
+            frame_statistics.vertex_buffer_binds = 0;
+            frame_statistics.index_buffer_binds = 0;
+            frame_statistics.binds_eliminated = 0;
+
+            record(command_buffer, 0, static_cast<uint32_t>(entries.size()));
+        }
+
+        void DrawQueue::record(VkCommandBuffer command_buffer, uint32_t first, uint32_t count)
+        {
+            Statistics statistics;
+
+            VkPipeline bound_pipeline = VK_NULL_HANDLE;
+            VkPipelineLayout bound_layout = VK_NULL_HANDLE;
+            VkDescriptorSet bound_sets[2] = {VK_NULL_HANDLE, VK_NULL_HANDLE};
+            VkBuffer bound_vertex_buffer = VK_NULL_HANDLE;
+            VkDeviceSize bound_vertex_offset = 0;
+            VkBuffer bound_index_buffer = VK_NULL_HANDLE;
+            VkDeviceSize bound_index_offset = 0;
+            VkIndexType bound_index_type = VK_INDEX_TYPE_UINT32;
+            uint64_t naive_binds = 0;
+
+            for (uint32_t i = first; i < first + count; i++)
+            {
+                const QueuedDraw& draw = draws[entries[i].value];
+                const DrawCommand& command = draw.command;
+                const Pipeline& pipeline = pipelines[draw.pipeline];
+                if (pipeline.pipeline == VK_NULL_HANDLE)
+                {
+                    statistics.skipped++;
+                    continue;
+                }
+
+                if (pipeline.pipeline != bound_pipeline)
+                {
+                    if (command_buffer != VK_NULL_HANDLE)
+                        vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.pipeline);
+                    bound_pipeline = pipeline.pipeline;
+                    statistics.pipeline_binds++;
+
+                    // Conservatively treat a different layout as disturbing every set.
+                    if (pipeline.layout != bound_layout)
+                    {
+                        bound_layout = pipeline.layout;
+                        bound_sets[0] = bound_sets[1] = VK_NULL_HANDLE;
+                    }
+                }
+                naive_binds++;
+
+                uint16_t set_ids[2] = {draw.descriptor, draw.material};
+                for (uint32_t set = 0; set < 2; set++)
+                {
+                    VkDescriptorSet descriptor_set = descriptor_sets[set_ids[set]];
+                    if (descriptor_set == VK_NULL_HANDLE)
+                        continue;
+                    naive_binds++;
+                    if (descriptor_set == bound_sets[set])
+                        continue;
+
+                    if (command_buffer != VK_NULL_HANDLE)
+                        vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.layout, set, 1, &descriptor_set, 0, nullptr);
+                    bound_sets[set] = descriptor_set;
+                    statistics.descriptor_binds++;
+                }
+
+                if (command.vertex_buffer != VK_NULL_HANDLE)
+                {
+                    naive_binds++;
+                    if (command.vertex_buffer != bound_vertex_buffer || command.vertex_buffer_offset != bound_vertex_offset)
+                    {
+                        if (command_buffer != VK_NULL_HANDLE)
+                            vkCmdBindVertexBuffers(command_buffer, 0, 1, &command.vertex_buffer, &command.vertex_buffer_offset);
+                        bound_vertex_buffer = command.vertex_buffer;
+                        bound_vertex_offset = command.vertex_buffer_offset;
+                        statistics.vertex_buffer_binds++;
+                    }
+                }
+
+                if (command.index_buffer != VK_NULL_HANDLE)
+                {
+                    naive_binds++;
+                    if (command.index_buffer != bound_index_buffer || command.index_buffer_offset != bound_index_offset || command.index_type != bound_index_type)
+                    {
+                        if (command_buffer != VK_NULL_HANDLE)
+                            vkCmdBindIndexBuffer(command_buffer, command.index_buffer, command.index_buffer_offset, command.index_type);
+                        bound_index_buffer = command.index_buffer;
+                        bound_index_offset = command.index_buffer_offset;
+                        bound_index_type = command.index_type;
+                        statistics.index_buffer_binds++;
+                    }
+                }
+
+                if (command_buffer != VK_NULL_HANDLE)
+                {
+                    if (command.push_size > 0)
+                        vkCmdPushConstants(command_buffer, pipeline.layout, command.push_stages, 0, command.push_size, command.push_constants);
+
+                    if (command.index_buffer != VK_NULL_HANDLE)
+                        vkCmdDrawIndexed(command_buffer, command.count, command.instance_count, command.first, command.vertex_offset, command.first_instance);
+                    else
+                        vkCmdDraw(command_buffer, command.count, command.instance_count, command.first, command.first_instance);
+                }
+                statistics.draws++;
+            }
+
+            statistics.binds_eliminated = naive_binds -
+                (statistics.pipeline_binds + statistics.descriptor_binds + statistics.vertex_buffer_binds + statistics.index_buffer_binds);
+
+            std::lock_guard<std::mutex> lock(statistics_mutex);
+            frame_statistics.draws += statistics.draws;
+            frame_statistics.skipped += statistics.skipped;
+            frame_statistics.pipeline_binds += statistics.pipeline_binds;
+            frame_statistics.descriptor_binds += statistics.descriptor_binds;
+            frame_statistics.vertex_buffer_binds += statistics.vertex_buffer_binds;
+            frame_statistics.index_buffer_binds += statistics.index_buffer_binds;
+            frame_statistics.binds_eliminated += statistics.binds_eliminated;
+        }
+
+        void DrawQueue::print_statistics(std::ostream& out) const
+        {
+            if (frames == 0)
+                return;
+
+            double n = static_cast<double>(frames);
+            uint64_t binds = total_statistics.pipeline_binds + total_statistics.descriptor_binds +
+                total_statistics.vertex_buffer_binds + total_statistics.index_buffer_binds;
+            char line[256];
+            snprintf(line, sizeof(line), "\nDraw queue: %.1f draws per frame (%.1f skipped), sorted in %.3f ms\n",
+                total_statistics.draws / n,
+                total_statistics.skipped / n,
+                total_statistics.sort_ms / n);
+            out << line;
+            snprintf(line, sizeof(line), "  binds per frame: %.1f pipeline, %.1f descriptor set, %.1f vertex buffer, %.1f index buffer; %.1f eliminated (%.1f%%)\n",
+                total_statistics.pipeline_binds / n,
+                total_statistics.descriptor_binds / n,
+                total_statistics.vertex_buffer_binds / n,
+                total_statistics.index_buffer_binds / n,
+                total_statistics.binds_eliminated / n,
+                binds + total_statistics.binds_eliminated > 0 ? 100.0 * total_statistics.binds_eliminated / (binds + total_statistics.binds_eliminated) : 0.0);
+            out << line;
+        }
+    };
+};
@@ -0,0 +1,205 @@
+#pragma once
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-13
+ *
+ */
+
+#include <iostream>
+#include <vector>
+#include <mutex>
+#include <cstdint>
+#include <stdexcept>
+
+#include "../utils/platform.hpp"
+
+namespace VulkanGameEngine
+{
+    namespace Jobs
+    {
+        class JobSystem;
+    };
+
+    namespace Graphics
+    {
+        enum class DepthOrder
+        {
+            // Opaque layers: state first, then near to far within a state.
+            FrontToBack = 0,
+            // Blended layers: far to near, state only breaks ties.
+            BackToFront = 1
+        };
+
+        /**
+         * Where a draw goes in the sort. pipeline, descriptor and material are ids
+         * from the DrawQueue (descriptor and material 0 for none); depth is the
+         * view depth normalized to [0, 1].
+         */
+        struct DrawState
+        {
+            uint32_t layer = 0;
+            uint32_t pipeline = 0;
+            uint32_t descriptor = 0;
+            uint32_t material = 0;
+            float depth = 0.0f;
+        };
+
+        /**
+         * The 64-bit key, most significant first:
+         *   front to back: layer 4 | pipeline 12 | descriptor 12 | material 12 | depth 24
+         *   back to front: layer 4 | ~depth 24 | pipeline 12 | descriptor 12 | material 12
+         * Depth is clamped to [0, 1]; a non finite depth counts as 1.
+         */
+        uint64_t make_draw_key(const DrawState& state, DepthOrder order);
+
+        struct SortEntry
+        {
+            uint64_t key;
+            uint32_t value;
+            uint32_t padding;
+        };
+
+        /**
+         * Stable LSD radix sort by key, 8 bits per pass; passes where every key
+         * has the same digit are skipped. scratch is resized to match. With jobs,
+         * each pass's histograms and scatter run in blocks across the workers.
+         */
+        void radix_sort(std::vector<SortEntry>& entries, std::vector<SortEntry>& scratch, Jobs::JobSystem* jobs = nullptr);
+
+        /**
+         * One draw. Indexed when index_buffer is set, count then being the index
+         * count; a vertex count otherwise.
+         */
+        struct DrawCommand
+        {
+            VkBuffer vertex_buffer = VK_NULL_HANDLE;
+            VkDeviceSize vertex_buffer_offset = 0;
+            VkBuffer index_buffer = VK_NULL_HANDLE;
+            VkDeviceSize index_buffer_offset = 0;
+            VkIndexType index_type = VK_INDEX_TYPE_UINT32;
+
+            uint32_t count = 0;
+            uint32_t instance_count = 1;
+            uint32_t first = 0;
+            int32_t vertex_offset = 0;
+            uint32_t first_instance = 0;
+
+            // Pushed through the pipeline's layout before the draw when push_size > 0.
+            VkShaderStageFlags push_stages = 0;
+            uint32_t push_size = 0;
+            uint8_t push_constants[16]{};
+        };
+
+        /**
+         * Per-frame draw submission: draws are queued with their state, sorted by
+         * a 64-bit key with an LSD radix sort (spread over the job system for
+         * large queues), and recorded in key order, skipping every pipeline,
+         * descriptor set, vertex buffer and index buffer bind that would not
+         * change the bound state.
+         *
+         * Descriptor ids bind at set 0 and material ids at set 1 of the
+         * pipeline's layout; bound sets are forgotten when the layout changes.
+         */
+        class DrawQueue
+        {
+            public:
+                static const uint32_t max_layers = 16;
+                static const uint32_t max_ids = 4096;
+                static const uint32_t max_push_size = 16;
+
+                struct Statistics
+                {
+                    uint64_t draws = 0;
+                    // Draws dropped because their pipeline has no handle (e.g. failed to build).
+                    uint64_t skipped = 0;
+                    uint64_t pipeline_binds = 0;
+                    uint64_t descriptor_binds = 0;
+                    uint64_t vertex_buffer_binds = 0;
+                    uint64_t index_buffer_binds = 0;
+                    // Binds a renderer setting the full state for every draw would have made on top.
+                    uint64_t binds_eliminated = 0;
+                    double sort_ms = 0.0;
+                };
+
+            private:
+                struct Pipeline
+                {
+                    VkPipeline pipeline = VK_NULL_HANDLE;
+                    VkPipelineLayout layout = VK_NULL_HANDLE;
+                };
+
+                struct QueuedDraw
+                {
+                    DrawCommand command;
+                    uint16_t pipeline;
+                    uint16_t descriptor;
+                    uint16_t material;
+                };
+
+                std::vector<Pipeline> pipelines;
+                // Index 0 is "no set".
+                std::vector<VkDescriptorSet> descriptor_sets = {VK_NULL_HANDLE};
+                DepthOrder layer_orders[max_layers]{};
+
+                std::vector<QueuedDraw> draws;
+                std::vector<SortEntry> entries;
+                std::vector<SortEntry> scratch;
+
+                // Guards frame_statistics while ranges are recorded concurrently.
+                std::mutex statistics_mutex;
+                Statistics frame_statistics;
+                Statistics total_statistics;
+                uint64_t frames = 0;
+
+            public:
+                uint32_t add_pipeline(VkPipeline pipeline, VkPipelineLayout layout);
+
+                /**
+                 * Swap the handle of a pipeline id, e.g. after a shader reload.
+                 */
+                void set_pipeline(uint32_t id, VkPipeline pipeline) { pipelines.at(id).pipeline = pipeline; }
+
+                uint32_t add_descriptor_set(VkDescriptorSet set);
+
+                void set_descriptor_set(uint32_t id, VkDescriptorSet set) { descriptor_sets.at(id) = set; }
+
+                void set_layer_order(uint32_t layer, DepthOrder order) { layer_orders[layer % max_layers] = order; }
+
+                /**
+                 * Drop the previous frame's draws and fold its statistics into the totals.
+                 */
+                void begin_frame();
+
+                void submit(const DrawState& state, const DrawCommand& command);
+
+                /**
+                 * Sort the queued draws by key. jobs may be null.
+                 */
+                void sort(Jobs::JobSystem* jobs = nullptr);
+
+                /**
+                 * Record the draws, in key order once sorted, submission order otherwise.
+                 * Viewport, scissor and render pass are the caller's. With a null
+                 * command buffer nothing is recorded and only the statistics are computed.
+                 */
+                void record(VkCommandBuffer command_buffer);
+
+                /**
+                 * Record draws [first, first + count) of the recording order, starting
+                 * from no bound state, and add them to the frame's statistics. Disjoint
+                 * ranges may be recorded concurrently, e.g. into the secondary command
+                 * buffers of a ParallelRecorder.
+                 */
+                void record(VkCommandBuffer command_buffer, uint32_t first, uint32_t count);
+
+                size_t size() const { return draws.size(); }
+
+                /**
+                 * The current frame's, once recorded.
+                 */
+                const Statistics& get_frame_statistics() const { return frame_statistics; }
+
+                void print_statistics(std::ostream& out) const;
+        };
+    };
+};
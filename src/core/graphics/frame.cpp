@@ -0,0 +1,164 @@
+#include "frame.hpp"
+
+#include <cstdio>
+#include <cmath>
+#include <algorithm>
+
+namespace VulkanGameEngine
+{
+    namespace Graphics
+    {
+        void FrameResources::create(VkDevice device, uint32_t queue_family)
+        {
+            VkCommandPoolCreateInfo pool_info{};
+            pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+            pool_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+            pool_info.queueFamilyIndex = queue_family;
+
+            if (vkCreateCommandPool(device, &pool_info, nullptr, &command_pool) != VK_SUCCESS)
+                throw std::runtime_error("\nFailed to create frame command pool.");
+
+            VkCommandBufferAllocateInfo allocate_info{};
+            allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocate_info.commandPool = command_pool;
+            allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            allocate_info.commandBufferCount = 1;
+
+            if (vkAllocateCommandBuffers(device, &allocate_info, &command_buffer) != VK_SUCCESS)
+                throw std::runtime_error("\nFailed to allocate frame command buffer.");
+
+            VkFenceCreateInfo fence_info{};
+            fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+            fence_info.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+            VkSemaphoreCreateInfo semaphore_info{};
+            semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+            if (vkCreateFence(device, &fence_info, nullptr, &in_flight_fence) != VK_SUCCESS ||
+                vkCreateSemaphore(device, &semaphore_info, nullptr, &image_available) != VK_SUCCESS ||
+                vkCreateSemaphore(device, &semaphore_info, nullptr, &render_finished) != VK_SUCCESS)
+                throw std::runtime_error("\nFailed to create frame synchronization objects.");
+
+            descriptors.init(device);
+        }
+
+        void FrameResources::destroy(VkDevice device)
+        {
+            descriptors.cleanup();
+
+            vkDestroySemaphore(device, render_finished, nullptr);
+            vkDestroySemaphore(device, image_available, nullptr);
+            vkDestroyFence(device, in_flight_fence, nullptr);
+
+            // Destroying the pool frees its command buffers.
+            vkDestroyCommandPool(device, command_pool, nullptr);
+
+            *this = FrameResources{};
+        }
+
+        void FrameMetrics::record(uint64_t frame_number, double fence_wait_ms, double frame_time_ms)
+        {
+            Sample sample{frame_number, fence_wait_ms, frame_time_ms};
+
+            if (history.size() < history_size)
+                history.push_back(sample);
+            else
+                history[history_head] = sample;
+            history_head = (history_head + 1) % history_size;
+
+            frame_count++;
+            total_fence_wait_ms += fence_wait_ms;
+            total_frame_time_ms += frame_time_ms;
+            if (fence_wait_ms > max_fence_wait_ms)
+                max_fence_wait_ms = fence_wait_ms;
+
+            double delta = frame_time_ms - frame_time_mean_ms;
+            frame_time_mean_ms += delta / frame_count;
+            frame_time_m2 += delta * (frame_time_ms - frame_time_mean_ms);
+        }
+
+        void FrameMetrics::reset()
+        {
+            *this = FrameMetrics{};
+        }
+
+        double FrameMetrics::average_fence_wait_ms() const
+        {
+            return frame_count ? total_fence_wait_ms / frame_count : 0.0;
+        }
+
+        double FrameMetrics::average_frame_time_ms() const
+        {
+            return frame_count ? total_frame_time_ms / frame_count : 0.0;
+        }
+
+        double FrameMetrics::frame_time_variance() const
+        {
+            return frame_count > 1 ? frame_time_m2 / (frame_count - 1) : 0.0;
+        }
+
+        double FrameMetrics::frame_time_stddev_ms() const
+        {
+            return std::sqrt(frame_time_variance());
+        }
+
+        double FrameMetrics::frame_time_percentile_ms(double percentile) const
+        {
+            if (history.empty())
+                return 0.0;
+
+            std::vector<double> frame_times;
+            frame_times.reserve(history.size());
+            for (const auto& sample : history)
+                frame_times.push_back(sample.frame_time_ms);
+
+            size_t rank = static_cast<size_t>(std::clamp(percentile, 0.0, 100.0) / 100.0 * (frame_times.size() - 1) + 0.5);
+            std::nth_element(frame_times.begin(), frame_times.begin() + rank, frame_times.end());
+            return frame_times[rank];
+        }
+
+        const FrameMetrics::Sample* FrameMetrics::last_sample() const
+        {
+            if (history.empty())
+                return nullptr;
+
+            return &history[(history_head + history_size - 1) % history_size];
+        }
+
+        std::vector<FrameMetrics::Sample> FrameMetrics::recent_samples() const
+        {
+            if (history.size() < history_size)
+                return history;
+
+            std::vector<Sample> samples(history.begin() + history_head, history.end());
+            samples.insert(samples.end(), history.begin(), history.begin() + history_head);
+            return samples;
+        }
+
+        bool FrameMetrics::is_gpu_bound() const
+        {
+            return total_frame_time_ms > 0.0 && total_fence_wait_ms > 0.5 * total_frame_time_ms;
+        }
+
+        void FrameMetrics::print_summary(std::ostream& out) const
+        {
+            char line[256];
+            snprintf(line, sizeof(line),
+                "Frames: %llu, frame time avg %.3f ms, fence wait avg %.3f ms / max %.3f ms (%s-bound)\n",
+                static_cast<unsigned long long>(frame_count),
+                average_frame_time_ms(),
+                average_fence_wait_ms(),
+                max_fence_wait_ms,
+                is_gpu_bound() ? "GPU" : "CPU");
+            out << line;
+
+            snprintf(line, sizeof(line),
+                "Frame time variance %.4f ms^2 (stddev %.3f ms), p50 %.3f ms, p99 %.3f ms\n",
+                frame_time_variance(),
+                frame_time_stddev_ms(),
+                frame_time_percentile_ms(50.0),
+                frame_time_percentile_ms(99.0));
+            out << line;
+        }
+    };
+};
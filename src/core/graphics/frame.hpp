@@ -0,0 +1,113 @@
+#pragma once
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-09-22
+ *
+ */
+
+#include <iostream>
+#include <vector>
+#include <cstdint>
+#include <stdexcept>
+
+#include "../utils/platform.hpp"
+#include "descriptors.hpp"
+
+namespace VulkanGameEngine
+{
+    namespace Graphics
+    {
+        /**
+         * Everything a single frame in flight owns.
+         * The CPU records into one FrameResources while the GPU consumes the others.
+         */
+        struct FrameResources
+        {
+            VkCommandPool command_pool = VK_NULL_HANDLE;
+            VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+
+            VkFence in_flight_fence = VK_NULL_HANDLE;
+            VkSemaphore image_available = VK_NULL_HANDLE;
+            VkSemaphore render_finished = VK_NULL_HANDLE;
+
+            // Per-frame descriptor sets, reset wholesale once the frame's fence is signaled.
+            DescriptorAllocator descriptors;
+
+            void create(VkDevice device, uint32_t queue_family);
+
+            void destroy(VkDevice device);
+        };
+
+        /**
+         * CPU side frame timings.
+         * fence_wait is the time the CPU spent blocked on the frame's fence
+         * (and on the fence of the image it acquired). A large fence wait
+         * relative to the frame time means the GPU is the bottleneck.
+         */
+        class FrameMetrics
+        {
+            public:
+                struct Sample
+                {
+                    uint64_t frame_number;
+                    double fence_wait_ms;
+                    double frame_time_ms;
+                };
+
+                static const size_t history_size = 256;
+
+            private:
+                std::vector<Sample> history;
+                size_t history_head = 0;
+
+                uint64_t frame_count = 0;
+                double total_fence_wait_ms = 0.0;
+                double total_frame_time_ms = 0.0;
+                double max_fence_wait_ms = 0.0;
+
+                // Running mean and sum of squared deviations of the frame time (Welford).
+                double frame_time_mean_ms = 0.0;
+                double frame_time_m2 = 0.0;
+
+            public:
+                void record(uint64_t frame_number, double fence_wait_ms, double frame_time_ms);
+
+                void reset();
+
+                uint64_t get_frame_count() const { return frame_count; }
+
+                double average_fence_wait_ms() const;
+
+                double average_frame_time_ms() const;
+
+                double get_max_fence_wait_ms() const { return max_fence_wait_ms; }
+
+                /**
+                 * Frame time variance over every recorded frame; low variance is what
+                 * makes motion look smooth, independently of the average.
+                 */
+                double frame_time_variance() const;
+
+                double frame_time_stddev_ms() const;
+
+                /**
+                 * Frame time percentile (0 - 100) over the recent samples.
+                 */
+                double frame_time_percentile_ms(double percentile) const;
+
+                const Sample* last_sample() const;
+
+                /**
+                 * Most recent samples, oldest first.
+                 */
+                std::vector<Sample> recent_samples() const;
+
+                /**
+                 * True when the CPU spends most of the frame waiting on the GPU.
+                 */
+                bool is_gpu_bound() const;
+
+                void print_summary(std::ostream& out) const;
+        };
+    };
+};
@@ -0,0 +1,382 @@
+#include "frame_capture.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <algorithm>
+
+namespace VulkanGameEngine
+{
+    namespace Graphics
+    {
+        namespace
+        {
+            bool is_bgra(VkFormat format)
+            {
+                return format == VK_FORMAT_B8G8R8A8_UNORM || format == VK_FORMAT_B8G8R8A8_SRGB;
+            }
+
+            bool ends_with(const std::string& text, const std::string& suffix)
+            {
+                return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+            }
+        };
+
+        CaptureFormat CaptureSettings::get_format() const
+        {
+            if (path.empty())
+                return CaptureFormat::None;
+            return ends_with(path, ".y4m") ? CaptureFormat::Y4m : CaptureFormat::Png;
+        }
+
+        bool FrameCapture::is_supported_format(VkFormat format)
+        {
+            return format == VK_FORMAT_R8G8B8A8_UNORM || format == VK_FORMAT_R8G8B8A8_SRGB || is_bgra(format);
+        }
+
+        void FrameCapture::init(VkDevice device, Memory::MemoryAllocator& allocator, const CaptureSettings& settings, uint32_t frames_in_flight)
+        {
+            this->device = device;
+            this->allocator = &allocator;
+            this->settings = settings;
+            this->settings.frame_step = std::max(1u, settings.frame_step);
+            format = settings.get_format();
+
+            // The host reads every byte of every copy: cached memory makes that a
+            // memcpy speed read instead of an uncached one.
+            const VkMemoryPropertyFlags cached = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+            memory_properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+            const VkPhysicalDeviceMemoryProperties& properties = allocator.get_memory_properties();
+            for (uint32_t i = 0; i < properties.memoryTypeCount; i++)
+                if ((properties.memoryTypes[i].propertyFlags & cached) == cached)
+                    memory_properties = cached;
+
+            if (format == CaptureFormat::Png)
+            {
+                std::error_code error;
+                std::filesystem::create_directories(settings.path, error);
+                if (error)
+                    throw std::runtime_error("\nFailed to create capture directory " + settings.path + ".");
+            }
+
+            // Buffers are allocated by the first frames that use them, at the backbuffer's size.
+            slots.resize(settings.ring_size > 0 ? settings.ring_size : frames_in_flight + 2);
+            statistics = Statistics{};
+            stopping = false;
+
+            writer_thread = std::thread(&FrameCapture::writer_loop, this);
+        }
+
+        void FrameCapture::cleanup()
+        {
+            if (!is_initialized())
+                return;
+
+            this->flush();
+            this->stop_writer();
+
+            y4m.close();
+
+            for (Slot& slot : slots)
+                if (slot.buffer != VK_NULL_HANDLE)
+                    allocator->destroy_buffer(slot.buffer, slot.allocation);
+
+            slots.clear();
+            pending.clear();
+        }
+
+        void FrameCapture::stop_writer()
+        {
+            if (!writer_thread.joinable())
+                return;
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            wake.notify_one();
+            writer_thread.join();
+        }
+
+        bool FrameCapture::record(VkCommandBuffer command_buffer, VkImage image, VkExtent2D extent, VkFormat format, uint64_t frame_number)
+        {
+            if (!is_supported_format(format))
+                throw std::runtime_error("\nFrame capture only supports 8-bit RGBA and BGRA images.");
+
+            uint32_t index = UINT32_MAX;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                for (uint32_t i = 0; i < slots.size() && index == UINT32_MAX; i++)
+                    if (slots[i].state == SlotState::Free)
+                        index = i;
+
+                if (index == UINT32_MAX)
+                {
+                    statistics.dropped++;
+                    return false;
+                }
+
+                slots[index].state = SlotState::Pending;
+                statistics.captured++;
+            }
+
+            Slot& slot = slots[index];
+            slot.frame_number = frame_number;
+            slot.extent = extent;
+            slot.format = format;
+
+            // A free buffer is not used by the GPU nor the writer, so it can be replaced
+            // right away when the backbuffer grew.
+            VkDeviceSize size = static_cast<VkDeviceSize>(extent.width) * extent.height * 4;
+            if (slot.capacity < size)
+                this->allocate_slot(slot, size);
+
+            VkBufferImageCopy region{};
+            region.bufferOffset = 0;
+            region.bufferRowLength = 0;
+            region.bufferImageHeight = 0;
+            region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            region.imageSubresource.mipLevel = 0;
+            region.imageSubresource.baseArrayLayer = 0;
+            region.imageSubresource.layerCount = 1;
+            region.imageOffset = {0, 0, 0};
+            region.imageExtent = {extent.width, extent.height, 1};
+
+            vkCmdCopyImageToBuffer(command_buffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, slot.buffer, 1, &region);
+
+            // The fence wait alone does not make the copy visible to host reads.
+            VkBufferMemoryBarrier barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+            barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.buffer = slot.buffer;
+            barrier.offset = 0;
+            barrier.size = size;
+
+            vkCmdPipelineBarrier(
+                command_buffer,
+                VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0,
+                0, nullptr, 1, &barrier, 0, nullptr);
+
+            pending.push_back(index);
+            return true;
+        }
+
+        void FrameCapture::collect(uint64_t completed_frame)
+        {
+            bool handed_over = false;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                while (!pending.empty() && slots[pending.front()].frame_number <= completed_frame)
+                {
+                    slots[pending.front()].state = SlotState::Writing;
+                    queue.push_back(pending.front());
+                    pending.pop_front();
+                    handed_over = true;
+                }
+            }
+
+            if (handed_over)
+                wake.notify_one();
+        }
+
+        void FrameCapture::flush()
+        {
+            this->collect(UINT64_MAX);
+
+            std::unique_lock<std::mutex> lock(mutex);
+            idle.wait(lock, [this]() { return queue.empty() && !writing; });
+        }
+
+        FrameCapture::Statistics FrameCapture::get_statistics()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            return statistics;
+        }
+
+        bool FrameCapture::passed()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (statistics.mismatched > 0)
+                return false;
+            // A frame without its golden image, or a run that compared nothing, is
+            // not a pass. Goldens are recorded with --capture into a directory.
+            if (!settings.golden_dir.empty() && (statistics.missing_goldens > 0 || statistics.compared == 0))
+                return false;
+            return true;
+        }
+
+        void FrameCapture::print_statistics(std::ostream& out)
+        {
+            Statistics statistics = this->get_statistics();
+
+            static const char* format_names[] = {"compare only", "PNG", "Y4M"};
+
+            char line[256];
+            snprintf(line, sizeof(line), "Frame capture (%s, every %u frames, %zu buffers): %llu captured, %llu dropped, %llu written (%.1f MiB, %.2f ms/frame), %llu write failures\n",
+                format_names[static_cast<int>(format)],
+                settings.frame_step,
+                slots.size(),
+                static_cast<unsigned long long>(statistics.captured),
+                static_cast<unsigned long long>(statistics.dropped),
+                static_cast<unsigned long long>(statistics.written),
+                statistics.bytes_written / (1024.0 * 1024.0),
+                statistics.written ? statistics.write_ms / statistics.written : 0.0,
+                static_cast<unsigned long long>(statistics.write_failures));
+            out << line;
+
+            if (!settings.golden_dir.empty())
+            {
+                snprintf(line, sizeof(line), "Golden images: %llu compared, %llu mismatched, %llu missing (tolerance %u, worst %.4f%% of pixels, lowest PSNR %.2f dB)\n",
+                    static_cast<unsigned long long>(statistics.compared),
+                    static_cast<unsigned long long>(statistics.mismatched),
+                    static_cast<unsigned long long>(statistics.missing_goldens),
+                    settings.golden_tolerance,
+                    statistics.worst_mismatch_fraction * 100.0,
+                    statistics.lowest_psnr);
+                out << line;
+            }
+        }
+
+        void FrameCapture::writer_loop()
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            for (;;)
+            {
+                wake.wait(lock, [this]() { return stopping || !queue.empty(); });
+                if (queue.empty())
+                    return;
+
+                uint32_t index = queue.front();
+                queue.pop_front();
+                writing = true;
+
+                lock.unlock();
+                this->write_slot(slots[index]);
+                lock.lock();
+
+                slots[index].state = SlotState::Free;
+                writing = false;
+                if (queue.empty())
+                    idle.notify_all();
+            }
+        }
+
+        void FrameCapture::write_slot(Slot& slot)
+        {
+            auto start = std::chrono::steady_clock::now();
+
+            // Swizzle to RGBA; the swapchain's alpha is meaningless once presented.
+            const uint8_t* source = static_cast<const uint8_t*>(slot.allocation.mapped);
+            size_t pixel_count = static_cast<size_t>(slot.extent.width) * slot.extent.height;
+            int red = is_bgra(slot.format) ? 2 : 0;
+            int blue = 2 - red;
+
+            image.resize(slot.extent.width, slot.extent.height);
+            uint8_t* pixels = image.pixels.data();
+            for (size_t i = 0; i < pixel_count; i++, source += 4, pixels += 4)
+            {
+                pixels[0] = source[red];
+                pixels[1] = source[1];
+                pixels[2] = source[blue];
+                pixels[3] = 255;
+            }
+
+            char name[32];
+            snprintf(name, sizeof(name), "frame_%06llu.png", static_cast<unsigned long long>(slot.frame_number));
+
+            bool written = true;
+            uint64_t bytes = 0;
+            if (format == CaptureFormat::Png)
+            {
+                std::vector<uint8_t> png = Utils::encode_png(image);
+                std::ofstream file(settings.path + "/" + name, std::ios::binary | std::ios::trunc);
+                file.write(reinterpret_cast<const char*>(png.data()), png.size());
+                written = static_cast<bool>(file);
+                bytes = png.size();
+            }
+            else if (format == CaptureFormat::Y4m)
+            {
+                // The stream takes the size of its first frame; frames after a resize are not written.
+                if (!y4m.is_open() && !y4m.open(settings.path, image.width, image.height, settings.fps))
+                    written = false;
+                else
+                    written = y4m.write_frame(image);
+                bytes = pixel_count * 3;
+            }
+
+            double write_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            bool compared = false;
+            bool missing = false;
+            bool mismatched = false;
+            Utils::ImageComparison comparison;
+            if (!settings.golden_dir.empty())
+            {
+                std::string golden_path = settings.golden_dir + "/" + name;
+                std::error_code error;
+                if (!std::filesystem::exists(golden_path, error))
+                    missing = true;
+                else if (!Utils::read_png(golden_path, golden))
+                {
+                    compared = true;
+                    mismatched = true;
+                    std::cerr << "\nFailed to decode golden image " << golden_path << ".";
+                }
+                else
+                {
+                    compared = true;
+                    comparison = Utils::compare_images(golden, image, settings.golden_tolerance);
+                    mismatched = comparison.size_mismatch || comparison.mismatch_fraction() > settings.allowed_mismatch_fraction;
+
+                    if (comparison.size_mismatch)
+                        fprintf(stderr, "\nFrame %llu is %ux%u, its golden image is %ux%u.",
+                            static_cast<unsigned long long>(slot.frame_number), image.width, image.height, golden.width, golden.height);
+                    else if (mismatched)
+                        fprintf(stderr, "\nFrame %llu differs from its golden image: %llu of %llu pixels (max difference %u, PSNR %.2f dB).",
+                            static_cast<unsigned long long>(slot.frame_number),
+                            static_cast<unsigned long long>(comparison.mismatched_pixels),
+                            static_cast<unsigned long long>(comparison.pixels),
+                            comparison.max_difference, comparison.psnr);
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (format != CaptureFormat::None)
+            {
+                if (written)
+                {
+                    statistics.written++;
+                    statistics.bytes_written += bytes;
+                    statistics.write_ms += write_ms;
+                }
+                else
+                    statistics.write_failures++;
+            }
+
+            if (missing)
+                statistics.missing_goldens++;
+            if (compared)
+            {
+                statistics.compared++;
+                if (mismatched)
+                    statistics.mismatched++;
+                statistics.worst_mismatch_fraction = std::max(statistics.worst_mismatch_fraction, mismatched && !comparison.pixels ? 1.0 : comparison.mismatch_fraction());
+                if (comparison.pixels)
+                    statistics.lowest_psnr = std::min(statistics.lowest_psnr, comparison.psnr);
+            }
+        }
+
+        void FrameCapture::allocate_slot(Slot& slot, VkDeviceSize size)
+        {
+            if (slot.buffer != VK_NULL_HANDLE)
+                allocator->destroy_buffer(slot.buffer, slot.allocation);
+
+            slot.allocation = allocator->create_buffer(size, VK_BUFFER_USAGE_TRANSFER_DST_BIT, memory_properties, slot.buffer);
+            slot.capacity = size;
+        }
+    };
+};
@@ -0,0 +1,209 @@
+#pragma once
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-15
+ *
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+
+#include "../utils/platform.hpp"
+#include "../utils/image_file.hpp"
+#include "../memory/allocator.hpp"
+
+namespace VulkanGameEngine
+{
+    namespace Graphics
+    {
+        enum class CaptureFormat
+        {
+            // Frames are only compared with the goldens.
+            None,
+            // One frame_NNNNNN.png per captured frame in a directory.
+            Png,
+            // A single raw video.
+            Y4m
+        };
+
+        struct CaptureSettings
+        {
+            // A .y4m file, or a directory of PNGs; empty writes nothing.
+            std::string path;
+
+            // Capture one frame out of this many.
+            uint32_t frame_step = 1;
+
+            // frame_NNNNNN.png files the captured frames are compared with; empty disables it.
+            std::string golden_dir;
+            // Largest color channel difference of a matching pixel.
+            uint32_t golden_tolerance = 2;
+            // Fraction of the pixels allowed to mismatch before the frame fails.
+            double allowed_mismatch_fraction = 0.0;
+
+            // Readback buffers; 0 uses frames in flight + 2.
+            uint32_t ring_size = 0;
+
+            // Frame rate written in the Y4M header.
+            uint32_t fps = 60;
+
+            bool is_enabled() const { return !path.empty() || !golden_dir.empty(); }
+
+            CaptureFormat get_format() const;
+        };
+
+        /**
+         * Streams rendered frames back to the host for recording and visual regression.
+         *
+         * record() copies the backbuffer into a free buffer of a ring of host visible
+         * buffers, from the frame's own command buffer. Once the frame's fence has
+         * been waited on, collect() hands the buffer to a writer thread, which encodes
+         * it (PNG or Y4M), compares it with its golden image and puts the buffer back
+         * in the ring. The frame loop never waits: when every buffer is still pending
+         * or being written the frame is dropped and counted.
+         *
+         * Only 8-bit RGBA and BGRA backbuffers are supported; alpha is written as opaque.
+         */
+        class FrameCapture
+        {
+            public:
+                struct Statistics
+                {
+                    uint64_t captured = 0;
+                    uint64_t dropped = 0;
+                    uint64_t written = 0;
+                    uint64_t write_failures = 0;
+                    uint64_t bytes_written = 0;
+                    double write_ms = 0.0;
+
+                    uint64_t compared = 0;
+                    uint64_t mismatched = 0;
+                    uint64_t missing_goldens = 0;
+                    // Over the compared frames.
+                    double worst_mismatch_fraction = 0.0;
+                    double lowest_psnr = std::numeric_limits<double>::infinity();
+                };
+
+            private:
+                enum class SlotState
+                {
+                    Free,
+                    // Copy recorded, the frame has not completed yet.
+                    Pending,
+                    // Owned by the writer thread.
+                    Writing
+                };
+
+                struct Slot
+                {
+                    VkBuffer buffer = VK_NULL_HANDLE;
+                    Memory::Allocation allocation;
+                    VkDeviceSize capacity = 0;
+                    SlotState state = SlotState::Free;
+
+                    uint64_t frame_number = 0;
+                    VkExtent2D extent{};
+                    VkFormat format = VK_FORMAT_UNDEFINED;
+                };
+
+                VkDevice device = VK_NULL_HANDLE;
+                Memory::MemoryAllocator* allocator = nullptr;
+                VkMemoryPropertyFlags memory_properties = 0;
+
+                CaptureSettings settings;
+                CaptureFormat format = CaptureFormat::None;
+
+                // Slot states are guarded by mutex; the rest of a slot belongs to its owner.
+                std::vector<Slot> slots;
+                // Pending slots, in frame order.
+                std::deque<uint32_t> pending;
+
+                std::thread writer_thread;
+                std::mutex mutex;
+                std::condition_variable wake;
+                std::condition_variable idle;
+                std::deque<uint32_t> queue;
+                bool writing = false;
+                bool stopping = false;
+
+                // Writer thread only.
+                Utils::Y4mWriter y4m;
+                Utils::ImageData image;
+                Utils::ImageData golden;
+
+                // Guarded by mutex.
+                Statistics statistics;
+
+            public:
+                /**
+                 * Only stops the writer thread, so that an exception thrown before
+                 * cleanup() does not destroy it while joinable.
+                 */
+                ~FrameCapture() { stop_writer(); }
+
+                void init(VkDevice device, Memory::MemoryAllocator& allocator, const CaptureSettings& settings, uint32_t frames_in_flight);
+
+                /**
+                 * Writes what is left and stops the writer thread. The device must be idle.
+                 */
+                void cleanup();
+
+                bool is_initialized() const { return !slots.empty(); }
+
+                bool should_capture(uint64_t frame_number) const { return frame_number % settings.frame_step == 0; }
+
+                static bool is_supported_format(VkFormat format);
+
+                /**
+                 * Records the copy of image, in TRANSFER_SRC_OPTIMAL layout, into a free
+                 * buffer. Returns false when the frame was dropped.
+                 */
+                bool record(VkCommandBuffer command_buffer, VkImage image, VkExtent2D extent, VkFormat format, uint64_t frame_number);
+
+                /**
+                 * Hands the copies of every frame up to completed_frame to the writer.
+                 */
+                void collect(uint64_t completed_frame);
+
+                /**
+                 * Hands every pending copy to the writer and waits until all are written.
+                 * The device must be idle.
+                 */
+                void flush();
+
+                Statistics get_statistics();
+
+                /**
+                 * No golden comparison failed and, with a golden directory, every
+                 * captured frame had a golden image and at least one was compared.
+                 */
+                bool passed();
+
+                void print_statistics(std::ostream& out);
+
+            private:
+                void writer_loop();
+
+                /**
+                 * Joins the writer once it has written what it was handed. Does nothing
+                 * when it is not running.
+                 */
+                void stop_writer();
+
+                void write_slot(Slot& slot);
+
+                /**
+                 * A host visible buffer of at least size bytes, cached when the device has such memory.
+                 */
+                void allocate_slot(Slot& slot, VkDeviceSize size);
+        };
+    };
+};
@@ -0,0 +1,111 @@
+#include "frame_pacer.hpp"
+
+#include <cstdio>
+#include <cmath>
+#include <thread>
+#include <algorithm>
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <windows.h>
+#endif
+
+namespace VulkanGameEngine
+{
+    namespace Graphics
+    {
+        constexpr double FramePacer::max_slack_ms;
+
+        void FramePacer::set_target_fps(double fps)
+        {
+            if (fps > 0.0)
+                interval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / fps));
+            else
+                interval = Clock::duration::zero();
+            started = false;
+        }
+
+        double FramePacer::get_target_fps() const
+        {
+            if (!is_enabled())
+                return 0.0;
+            return 1.0 / std::chrono::duration<double>(interval).count();
+        }
+
+        void FramePacer::wait()
+        {
+            if (!is_enabled())
+                return;
+
+            Clock::time_point now = Clock::now();
+            statistics.frames++;
+
+            if (!started || now >= next_deadline)
+            {
+                if (started)
+                    statistics.late_frames++;
+                started = true;
+                next_deadline = now + interval;
+                return;
+            }
+
+            sleep_until(next_deadline);
+            next_deadline += interval;
+        }
+
+        void FramePacer::sleep_until(Clock::time_point deadline)
+        {
+            Clock::time_point start = Clock::now();
+            Clock::time_point target = deadline - std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(slack_ms));
+
+            if (target > start)
+            {
+                #ifdef _WIN32
+                    // The default timer resolution is 15.6 ms; a high resolution waitable timer is not.
+                    static thread_local HANDLE timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+                    if (timer != nullptr)
+                    {
+                        LARGE_INTEGER due;
+                        due.QuadPart = -static_cast<LONGLONG>(std::chrono::duration_cast<std::chrono::nanoseconds>(target - start).count() / 100);
+                        SetWaitableTimerEx(timer, &due, 0, nullptr, nullptr, nullptr, 0);
+                        WaitForSingleObject(timer, INFINITE);
+                    }
+                    else
+                        std::this_thread::sleep_until(target);
+                #else
+                    std::this_thread::sleep_until(target);
+                #endif
+
+                Clock::time_point woke = Clock::now();
+                double overslept_ms = std::chrono::duration<double, std::milli>(woke - target).count();
+                slack_ms = std::clamp(0.9 * slack_ms + 0.1 * overslept_ms, 0.0, max_slack_ms);
+            }
+
+            Clock::time_point woke = Clock::now();
+            double wake_error_ms = std::fabs(std::chrono::duration<double, std::milli>(woke - deadline).count());
+
+            statistics.slept_ms += std::chrono::duration<double, std::milli>(woke - start).count();
+            statistics.total_wake_error_ms += wake_error_ms;
+            statistics.max_wake_error_ms = std::max(statistics.max_wake_error_ms, wake_error_ms);
+        }
+
+        void FramePacer::print_summary(std::ostream& out) const
+        {
+            if (!is_enabled())
+                return;
+
+            uint64_t paced = statistics.frames - statistics.late_frames;
+
+            char line[256];
+            snprintf(line, sizeof(line),
+                "Frame pacer: %.1f fps target, %.2f ms slept/frame, wake error avg %.3f ms / max %.3f ms, %llu late frames\n",
+                get_target_fps(),
+                statistics.frames ? statistics.slept_ms / statistics.frames : 0.0,
+                paced ? statistics.total_wake_error_ms / paced : 0.0,
+                statistics.max_wake_error_ms,
+                static_cast<unsigned long long>(statistics.late_frames));
+            out << line;
+        }
+    };
+};
@@ -0,0 +1,79 @@
+#pragma once
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-05
+ *
+ */
+
+#include <iostream>
+#include <chrono>
+#include <cstdint>
+
+namespace VulkanGameEngine
+{
+    namespace Graphics
+    {
+        /**
+         * CPU frame rate limiter.
+         *
+         * wait() is called once per frame, before input is polled, and sleeps until
+         * the frame's start time. The thread sleeps instead of spinning: the OS
+         * wake-up delay is learned and the sleep ends that much early, so frames
+         * start close to their deadline without burning a core.
+         *
+         * A frame that starts late moves the schedule instead of being followed by
+         * a burst of catch-up frames.
+         */
+        class FramePacer
+        {
+            public:
+                typedef std::chrono::steady_clock Clock;
+
+                struct Statistics
+                {
+                    uint64_t frames = 0;
+                    uint64_t late_frames = 0;
+                    double slept_ms = 0.0;
+                    // Distance between the wake-up and the deadline.
+                    double total_wake_error_ms = 0.0;
+                    double max_wake_error_ms = 0.0;
+                };
+
+                static constexpr double max_slack_ms = 2.0;
+
+            private:
+                Clock::duration interval = Clock::duration::zero();
+                Clock::time_point next_deadline;
+                bool started = false;
+
+                // How long before the deadline sleeping stops (learned OS wake-up delay).
+                double slack_ms = 0.5;
+
+                Statistics statistics;
+
+            public:
+                /**
+                 * 0 disables the limiter.
+                 */
+                void set_target_fps(double fps);
+
+                double get_target_fps() const;
+
+                bool is_enabled() const { return interval > Clock::duration::zero(); }
+
+                void wait();
+
+                /**
+                 * Restart the schedule, e.g. after a pause or a swapchain recreation.
+                 */
+                void reset() { started = false; }
+
+                const Statistics& get_statistics() const { return statistics; }
+
+                void print_summary(std::ostream& out) const;
+
+            private:
+                void sleep_until(Clock::time_point deadline);
+        };
+    };
+};
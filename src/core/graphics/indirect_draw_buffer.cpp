@@ -0,0 +1,56 @@
+#include "indirect_draw_buffer.hpp"
+
+#include <algorithm>
+
+namespace VulkanGameEngine
+{
+    namespace Graphics
+    {
+        void IndirectDrawBuffer::init(
+            Memory::MemoryAllocator& allocator,
+            const Utils::DeviceCapabilities& capabilities,
+            uint32_t frames_in_flight,
+            uint32_t capacity)
+        {
+            this->allocator = &allocator;
+            this->capacity = std::max(1u, capacity);
+
+            multi_draw = capabilities.features.multiDrawIndirect == VK_TRUE;
+            max_draw_count = multi_draw ? std::max(1u, capabilities.properties.limits.maxDrawIndirectCount) : 1;
+
+            frames.resize(frames_in_flight);
+            for (FrameBuffer& frame : frames)
+            {
+                frame.allocation = allocator.create_buffer(
+                    static_cast<VkDeviceSize>(this->capacity) * sizeof(VkDrawIndexedIndirectCommand),
+                    VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                    frame.buffer);
+
+                if (!frame.allocation.mapped)
+                    throw std::runtime_error("\nFailed to map an indirect draw buffer.");
+            }
+        }
+
+        void IndirectDrawBuffer::cleanup()
+        {
+            for (FrameBuffer& frame : frames)
+                if (frame.buffer != VK_NULL_HANDLE)
+                    allocator->destroy_buffer(frame.buffer, frame.allocation);
+            frames.clear();
+        }
+
+        void IndirectDrawBuffer::record(VkCommandBuffer command_buffer, uint32_t frame_index, uint32_t draw_count) const
+        {
+            const uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+            draw_count = std::min(draw_count, capacity);
+
+            // maxDrawIndirectCount is at least 2^16 - 1 on devices with multiDrawIndirect.
+            for (uint32_t first = 0; first < draw_count; first += max_draw_count)
+            {
+                uint32_t batch = std::min(max_draw_count, draw_count - first);
+                vkCmdDrawIndexedIndirect(command_buffer, frames[frame_index].buffer, static_cast<VkDeviceSize>(first) * stride, batch, stride);
+            }
+        }
+    };
+};
@@ -0,0 +1,74 @@
+#pragma once
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-10
+ *
+ */
+
+#include <vector>
+#include <cstdint>
+#include <stdexcept>
+
+#include "../utils/platform.hpp"
+#include "../utils/device_capabilities.hpp"
+#include "../memory/allocator.hpp"
+
+namespace VulkanGameEngine
+{
+    namespace Graphics
+    {
+        /**
+         * Persistently mapped VkDrawIndexedIndirectCommand arrays, one per frame
+         * in flight, filled by the CPU (VisibilitySystem::build_draws) and drawn
+         * with a single vkCmdDrawIndexedIndirect.
+         *
+         * Without multiDrawIndirect the draws are recorded one indirect call each,
+         * which still saves the CPU from touching every draw's parameters.
+         */
+        class IndirectDrawBuffer
+        {
+            private:
+                struct FrameBuffer
+                {
+                    VkBuffer buffer = VK_NULL_HANDLE;
+                    Memory::Allocation allocation;
+                };
+
+                Memory::MemoryAllocator* allocator = nullptr;
+                std::vector<FrameBuffer> frames;
+                uint32_t capacity = 0;
+
+                bool multi_draw = false;
+                uint32_t max_draw_count = 1;
+
+            public:
+                /**
+                 * multiDrawIndirect is used when the device supports it; the
+                 * feature must then be enabled on the logical device.
+                 */
+                void init(
+                    Memory::MemoryAllocator& allocator,
+                    const Utils::DeviceCapabilities& capabilities,
+                    uint32_t frames_in_flight,
+                    uint32_t capacity);
+
+                void cleanup();
+
+                uint32_t get_capacity() const { return capacity; }
+
+                /**
+                 * Commands of frame_index, to be written before the frame is submitted
+                 * and not after, until its fence has signaled.
+                 */
+                VkDrawIndexedIndirectCommand* get_commands(uint32_t frame_index)
+                {
+                    return static_cast<VkDrawIndexedIndirectCommand*>(frames[frame_index].allocation.mapped);
+                }
+
+                /**
+                 * Draw the first draw_count commands of frame_index.
+                 */
+                void record(VkCommandBuffer command_buffer, uint32_t frame_index, uint32_t draw_count) const;
+        };
+    };
+};
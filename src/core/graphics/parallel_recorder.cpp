@@ -0,0 +1,130 @@
+#include "parallel_recorder.hpp"
+#include "../profiling/profiler.hpp"
+
+#include <algorithm>
+
+namespace VulkanGameEngine
+{
+    namespace Graphics
+    {
+        void ParallelRecorder::init(VkDevice device, uint32_t queue_family, uint32_t frames_in_flight, Jobs::JobSystem& jobs)
+        {
+            this->device = device;
+            this->jobs = &jobs;
+
+            worker_frames.assign(jobs.get_worker_count(), std::vector<WorkerFrame>(frames_in_flight));
+
+            for (auto& frames : worker_frames)
+                for (auto& frame : frames)
+                {
+                    VkCommandPoolCreateInfo pool_info{};
+                    pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+                    pool_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+                    pool_info.queueFamilyIndex = queue_family;
+
+                    if (vkCreateCommandPool(device, &pool_info, nullptr, &frame.command_pool) != VK_SUCCESS)
+                        throw std::runtime_error("\nFailed to create recording command pool.");
+                }
+        }
+
+        void ParallelRecorder::cleanup()
+        {
+            // Destroying a pool frees its command buffers.
+            for (auto& frames : worker_frames)
+                for (auto& frame : frames)
+                    vkDestroyCommandPool(device, frame.command_pool, nullptr);
+            worker_frames.clear();
+
+            jobs = nullptr;
+        }
+
+        void ParallelRecorder::begin_frame(uint32_t slot)
+        {
+            for (auto& frames : worker_frames)
+            {
+                WorkerFrame& frame = frames[slot];
+                vkResetCommandPool(device, frame.command_pool, 0);
+                frame.used = 0;
+            }
+        }
+
+        std::vector<VkCommandBuffer> ParallelRecorder::record(
+            uint32_t slot,
+            const VkCommandBufferInheritanceInfo& inheritance,
+            uint32_t item_count,
+            const RecordFunction& function,
+            uint32_t chunk_count)
+        {
+            if (item_count == 0)
+                return {};
+
+            if (jobs->current_worker() < 0)
+                throw std::runtime_error("\nParallel recording must be started from a job system worker.");
+
+            if (chunk_count == 0)
+                chunk_count = jobs->get_worker_count();
+            chunk_count = std::min(chunk_count, std::max(1u, item_count / min_items_per_chunk));
+
+            std::vector<VkCommandBuffer> output(chunk_count, VK_NULL_HANDLE);
+
+            jobs->parallel_for(chunk_count, 1, [&](uint32_t first_chunk, uint32_t last_chunk) {
+                uint32_t worker = static_cast<uint32_t>(jobs->current_worker());
+
+                for (uint32_t chunk = first_chunk; chunk < last_chunk; chunk++)
+                {
+                    VGE_PROFILE_SCOPE("record_chunk");
+
+                    uint32_t first = static_cast<uint32_t>(static_cast<uint64_t>(item_count) * chunk / chunk_count);
+                    uint32_t last = static_cast<uint32_t>(static_cast<uint64_t>(item_count) * (chunk + 1) / chunk_count);
+
+                    VkCommandBuffer command_buffer = acquire_command_buffer(worker, slot);
+
+                    VkCommandBufferBeginInfo begin_info{};
+                    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+                    begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+                    begin_info.pInheritanceInfo = &inheritance;
+
+                    if (vkBeginCommandBuffer(command_buffer, &begin_info) != VK_SUCCESS)
+                        throw std::runtime_error("\nFailed to begin secondary command buffer.");
+
+                    function(command_buffer, first, last - first);
+
+                    if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS)
+                        throw std::runtime_error("\nFailed to record secondary command buffer.");
+
+                    output[chunk] = command_buffer;
+                }
+            });
+
+            return output;
+        }
+
+        void ParallelRecorder::execute(VkCommandBuffer primary, const std::vector<VkCommandBuffer>& secondaries)
+        {
+            if (!secondaries.empty())
+                vkCmdExecuteCommands(primary, static_cast<uint32_t>(secondaries.size()), secondaries.data());
+        }
+
+        VkCommandBuffer ParallelRecorder::acquire_command_buffer(uint32_t worker, uint32_t slot)
+        {
+            WorkerFrame& frame = worker_frames[worker][slot];
+
+            if (frame.used == frame.command_buffers.size())
+            {
+                VkCommandBufferAllocateInfo allocate_info{};
+                allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+                allocate_info.commandPool = frame.command_pool;
+                allocate_info.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+                allocate_info.commandBufferCount = 1;
+
+                VkCommandBuffer command_buffer;
+                if (vkAllocateCommandBuffers(device, &allocate_info, &command_buffer) != VK_SUCCESS)
+                    throw std::runtime_error("\nFailed to allocate secondary command buffer.");
+
+                frame.command_buffers.push_back(command_buffer);
+            }
+
+            return frame.command_buffers[frame.used++];
+        }
+    };
+};
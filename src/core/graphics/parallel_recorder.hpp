@@ -0,0 +1,95 @@
+#pragma once
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-09-30
+ *
+ */
+
+#include <iostream>
+#include <vector>
+#include <functional>
+#include <cstdint>
+#include <stdexcept>
+
+#include "../utils/platform.hpp"
+#include "../jobs/job_system.hpp"
+
+namespace VulkanGameEngine
+{
+    namespace Graphics
+    {
+        /**
+         * Records items [first, first + count) into a secondary command buffer that is
+         * already begun inside the inherited render pass.
+         */
+        typedef std::function<void(VkCommandBuffer command_buffer, uint32_t first, uint32_t count)> RecordFunction;
+
+        /**
+         * Records secondary command buffers across the workers of the job system.
+         *
+         * Every worker owns one VkCommandPool per frame in flight, so no pool is ever
+         * touched by two threads. Work is split in contiguous chunks, any worker may
+         * record any chunk, and the buffers come back in chunk order: the primary
+         * executes them in the same order every frame.
+         *
+         * record() must be called from a worker of the job system (usually the main thread).
+         */
+        class ParallelRecorder
+        {
+            private:
+                struct WorkerFrame
+                {
+                    VkCommandPool command_pool = VK_NULL_HANDLE;
+                    std::vector<VkCommandBuffer> command_buffers;
+                    uint32_t used = 0;
+                };
+
+                VkDevice device = VK_NULL_HANDLE;
+                Jobs::JobSystem* jobs = nullptr;
+
+                // worker_frames[worker][slot]
+                std::vector<std::vector<WorkerFrame>> worker_frames;
+
+            public:
+                // Chunks smaller than this cost more in command buffer overhead than they save.
+                uint32_t min_items_per_chunk = 64;
+
+                ParallelRecorder() = default;
+                ParallelRecorder(const ParallelRecorder&) = delete;
+                ParallelRecorder& operator=(const ParallelRecorder&) = delete;
+
+                ~ParallelRecorder() { cleanup(); }
+
+                void init(VkDevice device, uint32_t queue_family, uint32_t frames_in_flight, Jobs::JobSystem& jobs);
+
+                void cleanup();
+
+                bool is_initialized() const { return jobs != nullptr; }
+
+                /**
+                 * Reset the pools of a frame slot. Its fence must have been waited on.
+                 */
+                void begin_frame(uint32_t slot);
+
+                /**
+                 * Split item_count items in chunks (one per worker by default) and record
+                 * each chunk into its own secondary command buffer. Blocks until done.
+                 */
+                std::vector<VkCommandBuffer> record(
+                    uint32_t slot,
+                    const VkCommandBufferInheritanceInfo& inheritance,
+                    uint32_t item_count,
+                    const RecordFunction& function,
+                    uint32_t chunk_count = 0);
+
+                /**
+                 * The primary must be inside a render pass begun with
+                 * VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS.
+                 */
+                static void execute(VkCommandBuffer primary, const std::vector<VkCommandBuffer>& secondaries);
+
+            private:
+                VkCommandBuffer acquire_command_buffer(uint32_t worker, uint32_t slot);
+        };
+    };
+};
@@ -0,0 +1,375 @@
+#include "particle_simulation.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+namespace VulkanGameEngine
+{
+    namespace Graphics
+    {
+        void ParticleSimulation::init(
+            VkDevice device,
+            Memory::MemoryAllocator& allocator,
+            DescriptorLayoutCache& layout_cache,
+            VkQueue compute_queue,
+            uint32_t compute_family,
+            uint32_t graphics_family,
+            bool separate_queue,
+            uint32_t frames_in_flight,
+            const ParticleSettings& settings)
+        {
+            if (settings.count == 0)
+                throw std::runtime_error("\nFailed to create particle simulation: no particles.");
+
+            this->device = device;
+            this->allocator = &allocator;
+            this->compute_queue = compute_queue;
+            this->compute_family = compute_family;
+            this->separate_queue = separate_queue;
+            this->settings = settings;
+            statistics = Statistics{};
+
+            // Shared by both families rather than transferred every frame: the graphics
+            // queue only reads them as vertex buffers.
+            uint32_t families[2] = {compute_family, graphics_family};
+
+            VkBufferCreateInfo buffer_info{};
+            buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+            buffer_info.size = static_cast<VkDeviceSize>(settings.count) * sizeof(Particle);
+            buffer_info.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+            if (compute_family != graphics_family)
+            {
+                buffer_info.sharingMode = VK_SHARING_MODE_CONCURRENT;
+                buffer_info.queueFamilyIndexCount = 2;
+                buffer_info.pQueueFamilyIndices = families;
+            }
+            else
+                buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+            for (int i = 0; i < 2; i++)
+            {
+                if (vkCreateBuffer(device, &buffer_info, nullptr, &buffers[i]) != VK_SUCCESS)
+                    throw std::runtime_error("\nFailed to create particle buffer.");
+
+                VkMemoryRequirements requirements;
+                vkGetBufferMemoryRequirements(device, buffers[i], &requirements);
+
+                allocations[i] = allocator.allocate(requirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, Memory::ResourceKind::Linear);
+                vkBindBufferMemory(device, buffers[i], allocations[i].memory, allocations[i].offset);
+            }
+
+            VkDescriptorSetLayoutBinding bindings[2]{};
+            for (uint32_t i = 0; i < 2; i++)
+            {
+                bindings[i].binding = i;
+                bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+                bindings[i].descriptorCount = 1;
+                bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+            }
+            set_layout = layout_cache.get_layout({bindings[0], bindings[1]});
+
+            VkDescriptorPoolSize pool_size{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 4};
+
+            VkDescriptorPoolCreateInfo pool_info{};
+            pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+            pool_info.maxSets = 2;
+            pool_info.poolSizeCount = 1;
+            pool_info.pPoolSizes = &pool_size;
+
+            if (vkCreateDescriptorPool(device, &pool_info, nullptr, &descriptor_pool) != VK_SUCCESS)
+                throw std::runtime_error("\nFailed to create particle descriptor pool.");
+
+            VkDescriptorSetLayout set_layouts[2] = {set_layout, set_layout};
+
+            VkDescriptorSetAllocateInfo allocate_info{};
+            allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+            allocate_info.descriptorPool = descriptor_pool;
+            allocate_info.descriptorSetCount = 2;
+            allocate_info.pSetLayouts = set_layouts;
+
+            if (vkAllocateDescriptorSets(device, &allocate_info, sets) != VK_SUCCESS)
+                throw std::runtime_error("\nFailed to allocate particle descriptor sets.");
+
+            VkDescriptorBufferInfo buffer_infos[4];
+            VkWriteDescriptorSet writes[4]{};
+            for (uint32_t i = 0; i < 4; i++)
+            {
+                uint32_t set = i / 2;
+                uint32_t binding = i % 2;
+
+                buffer_infos[i] = {buffers[(set + binding) % 2], 0, VK_WHOLE_SIZE};
+
+                writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                writes[i].dstSet = sets[set];
+                writes[i].dstBinding = binding;
+                writes[i].descriptorCount = 1;
+                writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+                writes[i].pBufferInfo = &buffer_infos[i];
+            }
+            vkUpdateDescriptorSets(device, 4, writes, 0, nullptr);
+
+            VkPushConstantRange push_constant{VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(ParticleConstants)};
+
+            VkPipelineLayoutCreateInfo layout_info{};
+            layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+            layout_info.setLayoutCount = 1;
+            layout_info.pSetLayouts = &set_layout;
+            layout_info.pushConstantRangeCount = 1;
+            layout_info.pPushConstantRanges = &push_constant;
+
+            if (vkCreatePipelineLayout(device, &layout_info, nullptr, &pipeline_layout) != VK_SUCCESS)
+                throw std::runtime_error("\nFailed to create particle pipeline layout.");
+
+            VkCommandPoolCreateInfo command_pool_info{};
+            command_pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+            command_pool_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+            command_pool_info.queueFamilyIndex = compute_family;
+
+            VkSemaphoreCreateInfo semaphore_info{};
+            semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+            slots.resize(std::max(1u, frames_in_flight));
+            for (auto& slot : slots)
+            {
+                if (vkCreateCommandPool(device, &command_pool_info, nullptr, &slot.command_pool) != VK_SUCCESS)
+                    throw std::runtime_error("\nFailed to create particle command pool.");
+
+                VkCommandBufferAllocateInfo command_buffer_info{};
+                command_buffer_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+                command_buffer_info.commandPool = slot.command_pool;
+                command_buffer_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+                command_buffer_info.commandBufferCount = 1;
+
+                if (vkAllocateCommandBuffers(device, &command_buffer_info, &slot.command_buffer) != VK_SUCCESS)
+                    throw std::runtime_error("\nFailed to allocate particle command buffer.");
+
+                if (vkCreateSemaphore(device, &semaphore_info, nullptr, &slot.simulated) != VK_SUCCESS)
+                    throw std::runtime_error("\nFailed to create particle semaphore.");
+            }
+
+            for (auto& semaphore : released)
+                if (vkCreateSemaphore(device, &semaphore_info, nullptr, &semaphore) != VK_SUCCESS)
+                    throw std::runtime_error("\nFailed to create particle semaphore.");
+        }
+
+        void ParticleSimulation::cleanup()
+        {
+            if (device == VK_NULL_HANDLE)
+                return;
+
+            for (auto& slot : slots)
+            {
+                vkDestroySemaphore(device, slot.simulated, nullptr);
+                vkDestroyCommandPool(device, slot.command_pool, nullptr);
+            }
+            slots.clear();
+
+            for (auto& semaphore : released)
+            {
+                vkDestroySemaphore(device, semaphore, nullptr);
+                semaphore = VK_NULL_HANDLE;
+            }
+
+            vkDestroyPipelineLayout(device, pipeline_layout, nullptr);
+            vkDestroyDescriptorPool(device, descriptor_pool, nullptr);
+            pipeline_layout = VK_NULL_HANDLE;
+            descriptor_pool = VK_NULL_HANDLE;
+
+            for (int i = 0; i < 2; i++)
+            {
+                allocator->destroy_buffer(buffers[i], allocations[i]);
+                buffers[i] = VK_NULL_HANDLE;
+                allocations[i] = Memory::Allocation{};
+            }
+
+            device = VK_NULL_HANDLE;
+        }
+
+        VkPipeline ParticleSimulation::build_pipeline(const std::vector<uint32_t>& code, PipelineCache& cache) const
+        {
+            VkComputePipelineCreateInfo create_info{};
+            create_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+            create_info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+            create_info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+            create_info.stage.module = cache.get_shader_module(code);
+            create_info.stage.pName = "main";
+            create_info.layout = pipeline_layout;
+
+            return cache.create_compute_pipeline(create_info);
+        }
+
+        void ParticleSimulation::simulate(
+            VkPipeline pipeline,
+            uint64_t frame_number,
+            std::vector<VkSemaphore>& wait_semaphores,
+            std::vector<VkPipelineStageFlags>& wait_stages,
+            std::vector<VkSemaphore>& signal_semaphores)
+        {
+            Slot& slot = slots[frame_number % slots.size()];
+            uint64_t step = statistics.steps;
+
+            vkResetCommandPool(device, slot.command_pool, 0);
+
+            VkCommandBufferBeginInfo begin_info{};
+            begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+            begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+            if (vkBeginCommandBuffer(slot.command_buffer, &begin_info) != VK_SUCCESS)
+                throw std::runtime_error("\nFailed to begin recording particle command buffer.");
+
+            this->record_step(slot.command_buffer, pipeline, step);
+
+            if (vkEndCommandBuffer(slot.command_buffer) != VK_SUCCESS)
+                throw std::runtime_error("\nFailed to record particle command buffer.");
+
+            // The buffer this step writes was last drawn two frames ago.
+            VkPipelineStageFlags release_stage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+            VkSubmitInfo submit_info{};
+            submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+            if (step >= 2)
+            {
+                submit_info.waitSemaphoreCount = 1;
+                submit_info.pWaitSemaphores = &released[step % 2];
+                submit_info.pWaitDstStageMask = &release_stage;
+            }
+            submit_info.commandBufferCount = 1;
+            submit_info.pCommandBuffers = &slot.command_buffer;
+            submit_info.signalSemaphoreCount = 1;
+            submit_info.pSignalSemaphores = &slot.simulated;
+
+            if (vkQueueSubmit(compute_queue, 1, &submit_info, VK_NULL_HANDLE) != VK_SUCCESS)
+                throw std::runtime_error("\nFailed to submit particle command buffer.");
+
+            statistics.steps++;
+
+            // Only the vertex fetch waits: everything the frame records before it overlaps the step.
+            wait_semaphores.push_back(slot.simulated);
+            wait_stages.push_back(VK_PIPELINE_STAGE_VERTEX_INPUT_BIT);
+            signal_semaphores.push_back(released[step % 2]);
+        }
+
+        void ParticleSimulation::record_step(VkCommandBuffer command_buffer, VkPipeline pipeline, uint64_t step)
+        {
+            uint32_t group_count = (settings.count + 63) / 64;
+
+            // Earlier steps on this queue wrote what this one reads, and read what it writes.
+            VkMemoryBarrier barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+            vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+
+            if (step == 0)
+            {
+                // Seed buffers[0], the one the first step reads.
+                ParticleConstants seed = make_particle_constants(settings, ParticleMode::Seed);
+                vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline_layout, 0, 1, &sets[1], 0, nullptr);
+                vkCmdPushConstants(command_buffer, pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(seed), &seed);
+                vkCmdDispatch(command_buffer, group_count, 1, 1);
+                statistics.dispatches++;
+            }
+
+            vkCmdPipelineBarrier(command_buffer,
+                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+                1, &barrier, 0, nullptr, 0, nullptr);
+
+            ParticleConstants constants = make_particle_constants(settings, ParticleMode::Step);
+            vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline_layout, 0, 1, &sets[step % 2], 0, nullptr);
+            vkCmdPushConstants(command_buffer, pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+            vkCmdDispatch(command_buffer, group_count, 1, 1);
+            statistics.dispatches++;
+        }
+
+        std::vector<Particle> ParticleSimulation::read_back()
+        {
+            VkDeviceSize size = static_cast<VkDeviceSize>(settings.count) * sizeof(Particle);
+
+            VkBuffer staging;
+            Memory::Allocation staging_allocation = allocator->create_buffer(
+                size, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, staging);
+
+            VkCommandPoolCreateInfo pool_info{};
+            pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+            pool_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+            pool_info.queueFamilyIndex = compute_family;
+
+            VkCommandPool command_pool;
+            if (vkCreateCommandPool(device, &pool_info, nullptr, &command_pool) != VK_SUCCESS)
+                throw std::runtime_error("\nFailed to create readback command pool.");
+
+            VkCommandBufferAllocateInfo allocate_info{};
+            allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocate_info.commandPool = command_pool;
+            allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            allocate_info.commandBufferCount = 1;
+
+            VkCommandBuffer command_buffer;
+            vkAllocateCommandBuffers(device, &allocate_info, &command_buffer);
+
+            VkCommandBufferBeginInfo begin_info{};
+            begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+            begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+            vkBeginCommandBuffer(command_buffer, &begin_info);
+
+            VkBufferCopy region{0, 0, size};
+            // Written by the last step.
+            vkCmdCopyBuffer(command_buffer, buffers[statistics.steps % 2], staging, 1, &region);
+
+            VkMemoryBarrier barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+            vkCmdPipelineBarrier(command_buffer,
+                VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0,
+                1, &barrier, 0, nullptr, 0, nullptr);
+
+            vkEndCommandBuffer(command_buffer);
+
+            VkFenceCreateInfo fence_info{};
+            fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+            VkFence fence;
+            vkCreateFence(device, &fence_info, nullptr, &fence);
+
+            VkSubmitInfo submit_info{};
+            submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+            submit_info.commandBufferCount = 1;
+            submit_info.pCommandBuffers = &command_buffer;
+
+            if (vkQueueSubmit(compute_queue, 1, &submit_info, fence) != VK_SUCCESS)
+                throw std::runtime_error("\nFailed to submit particle readback.");
+            vkWaitForFences(device, 1, &fence, VK_TRUE, UINT64_MAX);
+
+            std::vector<Particle> particles(settings.count);
+            memcpy(particles.data(), staging_allocation.mapped, static_cast<size_t>(size));
+
+            vkDestroyFence(device, fence, nullptr);
+            vkDestroyCommandPool(device, command_pool, nullptr);
+            allocator->destroy_buffer(staging, staging_allocation);
+
+            return particles;
+        }
+
+        ParticleComparison ParticleSimulation::verify(Jobs::JobSystem* jobs)
+        {
+            std::vector<Particle> actual = this->read_back();
+            std::vector<Particle> expected = run_particle_reference(settings, statistics.steps, jobs);
+            return compare_particles(expected, actual);
+        }
+
+        void ParticleSimulation::print_statistics(std::ostream& out) const
+        {
+            char line[256];
+            snprintf(line, sizeof(line), "Particles: %u on the %s queue, %llu steps in %llu dispatches\n",
+                settings.count,
+                separate_queue ? "async compute" : "graphics",
+                static_cast<unsigned long long>(statistics.steps),
+                static_cast<unsigned long long>(statistics.dispatches));
+            out << line;
+        }
+    };
+};
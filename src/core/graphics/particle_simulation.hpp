@@ -0,0 +1,151 @@
+#pragma once
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-14
+ *
+ */
+
+#include <iostream>
+#include <vector>
+#include <cstdint>
+#include <stdexcept>
+
+#include "../utils/platform.hpp"
+#include "../memory/allocator.hpp"
+#include "descriptors.hpp"
+#include "particles.hpp"
+#include "pipeline_cache.hpp"
+
+namespace VulkanGameEngine
+{
+    namespace Graphics
+    {
+        /**
+         * Particle simulation on the compute queue, one fixed step per frame.
+         *
+         * The particles live in two device local buffers: step n reads buffer n % 2
+         * and writes the other, which frame n then draws. Step n + 1 therefore runs
+         * while frame n is still being drawn; it only waits for frame n - 1, the last
+         * one to draw the buffer it overwrites.
+         *
+         * Both directions are synchronized with binary semaphores: the graphics
+         * submission of a frame waits on its step, and signals the semaphore the
+         * step two frames later waits on. When the compute queue is in another
+         * family the buffers are shared concurrently, so no ownership transfer is
+         * recorded. Without a separate compute queue the steps go to the graphics
+         * queue with the same semaphores, which keeps the results identical.
+         *
+         * run_particle_reference() computes the same state on the CPU.
+         */
+        class ParticleSimulation
+        {
+            public:
+                struct Statistics
+                {
+                    uint64_t steps = 0;
+                    uint64_t dispatches = 0;
+                };
+
+            private:
+                struct Slot
+                {
+                    VkCommandPool command_pool = VK_NULL_HANDLE;
+                    VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+                    // Signaled by the step, waited on by the frame drawing it.
+                    VkSemaphore simulated = VK_NULL_HANDLE;
+                };
+
+                VkDevice device = VK_NULL_HANDLE;
+                Memory::MemoryAllocator* allocator = nullptr;
+                VkQueue compute_queue = VK_NULL_HANDLE;
+                uint32_t compute_family = 0;
+                bool separate_queue = false;
+
+                ParticleSettings settings;
+
+                VkBuffer buffers[2] = {VK_NULL_HANDLE, VK_NULL_HANDLE};
+                Memory::Allocation allocations[2];
+
+                VkDescriptorSetLayout set_layout = VK_NULL_HANDLE;
+                VkDescriptorPool descriptor_pool = VK_NULL_HANDLE;
+                // sets[i] reads buffers[i] and writes the other one.
+                VkDescriptorSet sets[2] = {VK_NULL_HANDLE, VK_NULL_HANDLE};
+                VkPipelineLayout pipeline_layout = VK_NULL_HANDLE;
+
+                std::vector<Slot> slots;
+                // Signaled by frame n, waited on by step n + 2.
+                VkSemaphore released[2] = {VK_NULL_HANDLE, VK_NULL_HANDLE};
+
+                Statistics statistics;
+
+            public:
+                /**
+                 * separate_queue tells whether compute_queue is another queue than the
+                 * graphics one; it is only reported.
+                 */
+                void init(
+                    VkDevice device,
+                    Memory::MemoryAllocator& allocator,
+                    DescriptorLayoutCache& layout_cache,
+                    VkQueue compute_queue,
+                    uint32_t compute_family,
+                    uint32_t graphics_family,
+                    bool separate_queue,
+                    uint32_t frames_in_flight,
+                    const ParticleSettings& settings);
+
+                /**
+                 * The device must be idle.
+                 */
+                void cleanup();
+
+                bool is_initialized() const { return pipeline_layout != VK_NULL_HANDLE; }
+
+                /**
+                 * Builds the pipeline of shaders/particles.comp through cache. Thread-safe
+                 * like the shader reloader's builders need.
+                 */
+                VkPipeline build_pipeline(const std::vector<uint32_t>& code, PipelineCache& cache) const;
+
+                /**
+                 * Submits the next step to the compute queue (the first one seeds the
+                 * particles too) and adds what the graphics submission of frame_number
+                 * must wait on and signal. Call once per frame, right before that
+                 * submission; the frame's fence must cover the slot's previous use.
+                 */
+                void simulate(
+                    VkPipeline pipeline,
+                    uint64_t frame_number,
+                    std::vector<VkSemaphore>& wait_semaphores,
+                    std::vector<VkPipelineStageFlags>& wait_stages,
+                    std::vector<VkSemaphore>& signal_semaphores);
+
+                /**
+                 * Buffer the next simulate() writes, i.e. the one the frame submitting it
+                 * draws, as a vertex buffer of Particles.
+                 */
+                VkBuffer get_next_buffer() const { return buffers[(statistics.steps + 1) % 2]; }
+
+                uint32_t get_count() const { return settings.count; }
+
+                const ParticleSettings& get_settings() const { return settings; }
+
+                const Statistics& get_statistics() const { return statistics; }
+
+                /**
+                 * Copies the current particles back through a staging buffer. The device must be idle.
+                 */
+                std::vector<Particle> read_back();
+
+                /**
+                 * Runs the CPU reference for as many steps and compares it with read_back().
+                 */
+                ParticleComparison verify(Jobs::JobSystem* jobs = nullptr);
+
+                void print_statistics(std::ostream& out) const;
+
+            private:
+                void record_step(VkCommandBuffer command_buffer, VkPipeline pipeline, uint64_t step);
+        };
+    };
+};
@@ -0,0 +1,174 @@
+#include "particles.hpp"
+#include "../jobs/job_system.hpp"
+
+#include <cmath>
+#include <algorithm>
+#include <limits>
+
+namespace VulkanGameEngine
+{
+    namespace Graphics
+    {
+        ParticleConstants make_particle_constants(const ParticleSettings& settings, ParticleMode mode)
+        {
+            ParticleConstants constants{};
+            constants.time_step = settings.time_step;
+            constants.gravity_step = settings.gravity * settings.time_step;
+            constants.drag_factor = std::max(0.0f, 1.0f - settings.drag * settings.time_step);
+            constants.floor_height = settings.floor_height;
+            constants.restitution = settings.restitution;
+            constants.emitter_height = settings.emitter_height;
+            constants.spread = settings.spread;
+            constants.min_speed = settings.min_speed;
+            constants.speed_range = settings.max_speed - settings.min_speed;
+            constants.min_life = settings.min_life;
+            constants.life_range = settings.max_life - settings.min_life;
+            constants.count = settings.count;
+            constants.seed = settings.seed;
+            constants.mode = static_cast<uint32_t>(mode);
+            return constants;
+        }
+
+        Particle spawn_particle(const ParticleConstants& constants, uint32_t index, uint32_t generation)
+        {
+            uint32_t base = particle_hash(particle_hash(index + constants.seed * 0x9e3779b9u) + generation);
+
+            float r0 = particle_random(particle_hash(base));
+            float r1 = particle_random(particle_hash(base + 1));
+            float r2 = particle_random(particle_hash(base + 2));
+            float r3 = particle_random(particle_hash(base + 3));
+
+            Particle particle;
+            particle.position[0] = 0.0f;
+            particle.position[1] = constants.emitter_height;
+            particle.position[2] = 0.0f;
+            particle.velocity[0] = (r0 * 2.0f - 1.0f) * constants.spread;
+            particle.velocity[1] = constants.min_speed + r2 * constants.speed_range;
+            particle.velocity[2] = (r1 * 2.0f - 1.0f) * constants.spread;
+            particle.life = constants.min_life + r3 * constants.life_range;
+            particle.generation = generation;
+
+            // The first generation is spread over a whole life, so the emitter is steady from the start.
+            if (generation == 0)
+                particle.life = particle.life * particle_random(particle_hash(base + 4));
+
+            return particle;
+        }
+
+        // Every operation must round like shaders/particles.comp, whose results are precise:
+        // the build compiles this file without floating point contraction, so no
+        // multiply-add becomes an FMA on either side.
+        void simulate_particles(const ParticleConstants& constants, const Particle* source, Particle* destination, uint32_t first, uint32_t last)
+        {
+            if (constants.mode == static_cast<uint32_t>(ParticleMode::Seed))
+            {
+                for (uint32_t i = first; i < last; i++)
+                    destination[i] = spawn_particle(constants, i, 0);
+                return;
+            }
+
+            for (uint32_t i = first; i < last; i++)
+            {
+                Particle particle = source[i];
+
+                particle.life = particle.life - constants.time_step;
+                if (particle.life <= 0.0f)
+                {
+                    destination[i] = spawn_particle(constants, i, particle.generation + 1);
+                    continue;
+                }
+
+                particle.velocity[1] = particle.velocity[1] - constants.gravity_step;
+                for (int axis = 0; axis < 3; axis++)
+                {
+                    particle.velocity[axis] = particle.velocity[axis] * constants.drag_factor;
+                    particle.position[axis] = particle.position[axis] + particle.velocity[axis] * constants.time_step;
+                }
+
+                // Reflect off the floor, losing some of the vertical speed.
+                if (particle.position[1] < constants.floor_height)
+                {
+                    particle.position[1] = constants.floor_height + (constants.floor_height - particle.position[1]);
+                    particle.velocity[1] = -particle.velocity[1] * constants.restitution;
+                }
+
+                destination[i] = particle;
+            }
+        }
+
+        std::vector<Particle> run_particle_reference(const ParticleSettings& settings, uint64_t steps, Jobs::JobSystem* jobs)
+        {
+            std::vector<Particle> current(settings.count);
+            std::vector<Particle> next(settings.count);
+
+            auto run = [&](const ParticleConstants& constants) {
+                const Particle* source = current.data();
+                Particle* destination = next.data();
+                if (jobs)
+                    jobs->parallel_for(settings.count, 4096, [&](uint32_t first, uint32_t last) {
+                        simulate_particles(constants, source, destination, first, last);
+                    });
+                else
+                    simulate_particles(constants, source, destination, 0, settings.count);
+                current.swap(next);
+            };
+
+            run(make_particle_constants(settings, ParticleMode::Seed));
+
+            ParticleConstants step = make_particle_constants(settings, ParticleMode::Step);
+            for (uint64_t i = 0; i < steps; i++)
+                run(step);
+
+            return current;
+        }
+
+        ParticleComparison compare_particles(const std::vector<Particle>& expected, const std::vector<Particle>& actual, float tolerance)
+        {
+            if (expected.size() != actual.size())
+                throw std::runtime_error("\nFailed to compare particles: the counts differ.");
+
+            // Relative above 1, absolute below. A NaN would vanish in std::max, so it
+            // becomes an infinite error.
+            auto error = [](float a, float b) {
+                float difference = std::fabs(a - b) / std::max(1.0f, std::fabs(a));
+                return std::isnan(difference) ? std::numeric_limits<float>::infinity() : difference;
+            };
+
+            ParticleComparison comparison;
+            comparison.count = static_cast<uint32_t>(expected.size());
+
+            for (size_t i = 0; i < expected.size(); i++)
+            {
+                const Particle& a = expected[i];
+                const Particle& b = actual[i];
+
+                float position_error = 0.0f;
+                float velocity_error = 0.0f;
+                for (int axis = 0; axis < 3; axis++)
+                {
+                    position_error = std::max(position_error, error(a.position[axis], b.position[axis]));
+                    velocity_error = std::max(velocity_error, error(a.velocity[axis], b.velocity[axis]));
+                }
+                float life_error = error(a.life, b.life);
+
+                // A different generation means one side respawned and the other did not:
+                // the errors of that particle say nothing about the arithmetic.
+                if (a.generation != b.generation)
+                {
+                    comparison.mismatches++;
+                    continue;
+                }
+
+                comparison.max_position_error = std::max(comparison.max_position_error, position_error);
+                comparison.max_velocity_error = std::max(comparison.max_velocity_error, velocity_error);
+                comparison.max_life_error = std::max(comparison.max_life_error, life_error);
+
+                // Written so that NaNs count as mismatches.
+                if (!(position_error <= tolerance && velocity_error <= tolerance && life_error <= tolerance))
+                    comparison.mismatches++;
+            }
+
+            return comparison;
+        }
+    };
+};
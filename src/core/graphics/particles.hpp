@@ -0,0 +1,144 @@
+#pragma once
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-14
+ *
+ */
+
+#include <iostream>
+#include <vector>
+#include <cstdint>
+#include <stdexcept>
+
+namespace VulkanGameEngine
+{
+    namespace Jobs
+    {
+        class JobSystem;
+    };
+
+    namespace Graphics
+    {
+        /**
+         * One particle, laid out as the std430 Particle of shaders/particles.comp.
+         * generation counts the respawns and seeds the next one.
+         */
+        struct Particle
+        {
+            float position[3];
+            float life;
+            float velocity[3];
+            uint32_t generation;
+        };
+
+        static_assert(sizeof(Particle) == 32, "Particle must match the std430 layout of the compute shader.");
+
+        struct ParticleSettings
+        {
+            uint32_t count = 65536;
+            uint32_t seed = 1;
+
+            // Fixed step: the simulation advances once per frame whatever the frame time,
+            // which keeps it reproducible.
+            float time_step = 1.0f / 60.0f;
+
+            float gravity = 9.81f;
+            // Fraction of the velocity lost per second.
+            float drag = 0.2f;
+            float floor_height = 0.0f;
+            float restitution = 0.6f;
+
+            float emitter_height = 0.5f;
+            // Horizontal velocity range, and the vertical speed range, of a new particle.
+            float spread = 1.5f;
+            float min_speed = 4.0f;
+            float max_speed = 7.0f;
+
+            // Seconds a particle lives before it respawns at the emitter.
+            float min_life = 2.0f;
+            float max_life = 5.0f;
+        };
+
+        enum class ParticleMode : uint32_t
+        {
+            // Spawn every particle, with lives staggered so respawns spread out.
+            Seed = 0,
+            Step = 1
+        };
+
+        /**
+         * Push constants of shaders/particles.comp, which the CPU reference reads too.
+         * Products of settings are folded in here so both sides do the same
+         * arithmetic on the same values.
+         */
+        struct ParticleConstants
+        {
+            float time_step;
+            float gravity_step;
+            float drag_factor;
+            float floor_height;
+            float restitution;
+            float emitter_height;
+            float spread;
+            float min_speed;
+            float speed_range;
+            float min_life;
+            float life_range;
+            uint32_t count;
+            uint32_t seed;
+            uint32_t mode;
+        };
+
+        ParticleConstants make_particle_constants(const ParticleSettings& settings, ParticleMode mode);
+
+        /**
+         * Integer hash both sides use for every random number (lowbias32).
+         */
+        inline uint32_t particle_hash(uint32_t x)
+        {
+            x ^= x >> 16;
+            x *= 0x7feb352du;
+            x ^= x >> 15;
+            x *= 0x846ca68bu;
+            x ^= x >> 16;
+            return x;
+        }
+
+        /**
+         * [0, 1) with 24 bits, exact in single precision.
+         */
+        inline float particle_random(uint32_t x)
+        {
+            return static_cast<float>(x >> 8) * (1.0f / 16777216.0f);
+        }
+
+        Particle spawn_particle(const ParticleConstants& constants, uint32_t index, uint32_t generation);
+
+        /**
+         * CPU reference of the compute shader: particles [first, last) of destination
+         * from source (unused when seeding).
+         */
+        void simulate_particles(const ParticleConstants& constants, const Particle* source, Particle* destination, uint32_t first, uint32_t last);
+
+        /**
+         * Seeds settings.count particles and advances them by steps, across the job
+         * system when jobs is given. Particles are independent, so the result does
+         * not depend on how the work is split.
+         */
+        std::vector<Particle> run_particle_reference(const ParticleSettings& settings, uint64_t steps, Jobs::JobSystem* jobs = nullptr);
+
+        struct ParticleComparison
+        {
+            uint32_t count = 0;
+            // Particles with a different generation or an error above the tolerance.
+            uint32_t mismatches = 0;
+            float max_position_error = 0.0f;
+            float max_velocity_error = 0.0f;
+            float max_life_error = 0.0f;
+
+            bool passed() const { return mismatches == 0; }
+        };
+
+        ParticleComparison compare_particles(const std::vector<Particle>& expected, const std::vector<Particle>& actual, float tolerance = 1e-4f);
+    };
+};
@@ -0,0 +1,227 @@
+#include "pipeline_cache.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <filesystem>
+
+namespace VulkanGameEngine
+{
+    namespace Graphics
+    {
+        void PipelineCache::init(VkDevice device, const Utils::DeviceCapabilities& capabilities, const std::string& path)
+        {
+            this->device = device;
+            this->path = path;
+            this->device_properties = capabilities.properties;
+
+            std::vector<char> data;
+            std::ifstream file(path, std::ios::binary | std::ios::ate);
+            if (file.is_open())
+            {
+                data.resize(static_cast<size_t>(file.tellg()));
+                file.seekg(0);
+                file.read(data.data(), data.size());
+                if (!file)
+                    data.clear();
+            }
+
+            if (data.empty())
+                statistics.rejection_reason = "no cache file";
+            else
+                statistics.rejection_reason = validate_header(data, device_properties);
+
+            // A stale or foreign blob is simply dropped; the driver would ignore it anyway.
+            if (!statistics.rejection_reason.empty())
+                data.clear();
+
+            VkPipelineCacheCreateInfo create_info{};
+            create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+            create_info.initialDataSize = data.size();
+            create_info.pInitialData = data.empty() ? nullptr : data.data();
+
+            if (vkCreatePipelineCache(device, &create_info, nullptr, &cache) != VK_SUCCESS)
+                throw std::runtime_error("\nFailed to create pipeline cache.");
+
+            statistics.warm_start = !data.empty();
+            statistics.loaded_bytes = data.size();
+        }
+
+        void PipelineCache::cleanup()
+        {
+            if (device == VK_NULL_HANDLE)
+                return;
+
+            if (!path.empty() && !save())
+                std::cerr << "\nFailed to write pipeline cache to " << path << ".";
+
+            clear_shader_modules();
+            vkDestroyPipelineCache(device, cache, nullptr);
+
+            cache = VK_NULL_HANDLE;
+            device = VK_NULL_HANDLE;
+        }
+
+        bool PipelineCache::save()
+        {
+            if (cache == VK_NULL_HANDLE || path.empty())
+                return false;
+
+            size_t size = 0;
+            if (vkGetPipelineCacheData(device, cache, &size, nullptr) != VK_SUCCESS)
+                return false;
+
+            std::vector<char> data(size);
+            if (vkGetPipelineCacheData(device, cache, &size, data.data()) != VK_SUCCESS)
+                return false;
+            data.resize(size);
+
+            std::string temporary_path = path + ".tmp";
+            {
+                std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+                if (!file.is_open())
+                    return false;
+                file.write(data.data(), data.size());
+                if (!file)
+                    return false;
+            }
+
+            // rename replaces the destination in one step, readers see the old or the new file.
+            std::error_code error;
+            std::filesystem::rename(temporary_path, path, error);
+            if (error)
+            {
+                std::filesystem::remove(temporary_path, error);
+                return false;
+            }
+
+            return true;
+        }
+
+        VkShaderModule PipelineCache::get_shader_module(const std::vector<uint32_t>& code)
+        {
+            uint64_t hash = hash_code(code);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            auto range = shader_modules.equal_range(hash);
+            for (auto it = range.first; it != range.second; ++it)
+                if (it->second.code == code)
+                {
+                    statistics.shader_module_hits++;
+                    return it->second.module;
+                }
+
+            VkShaderModuleCreateInfo create_info{};
+            create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+            create_info.codeSize = code.size() * sizeof(uint32_t);
+            create_info.pCode = code.data();
+
+            VkShaderModule module;
+            if (vkCreateShaderModule(device, &create_info, nullptr, &module) != VK_SUCCESS)
+                throw std::runtime_error("\nFailed to create shader module.");
+
+            shader_modules.insert({hash, {module, code}});
+            statistics.shader_modules_created++;
+
+            return module;
+        }
+
+        void PipelineCache::clear_shader_modules()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (auto& entry : shader_modules)
+                vkDestroyShaderModule(device, entry.second.module, nullptr);
+            shader_modules.clear();
+        }
+
+        VkPipeline PipelineCache::create_graphics_pipeline(const VkGraphicsPipelineCreateInfo& create_info)
+        {
+            auto start = std::chrono::steady_clock::now();
+
+            VkPipeline pipeline;
+            if (vkCreateGraphicsPipelines(device, cache, 1, &create_info, nullptr, &pipeline) != VK_SUCCESS)
+                throw std::runtime_error("\nFailed to create graphics pipeline.");
+
+            std::lock_guard<std::mutex> lock(mutex);
+            statistics.pipeline_creation_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            statistics.pipelines_created++;
+
+            return pipeline;
+        }
+
+        VkPipeline PipelineCache::create_compute_pipeline(const VkComputePipelineCreateInfo& create_info)
+        {
+            auto start = std::chrono::steady_clock::now();
+
+            VkPipeline pipeline;
+            if (vkCreateComputePipelines(device, cache, 1, &create_info, nullptr, &pipeline) != VK_SUCCESS)
+                throw std::runtime_error("\nFailed to create compute pipeline.");
+
+            std::lock_guard<std::mutex> lock(mutex);
+            statistics.pipeline_creation_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            statistics.pipelines_created++;
+
+            return pipeline;
+        }
+
+        PipelineCache::Statistics PipelineCache::get_statistics() const
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            return statistics;
+        }
+
+        void PipelineCache::print_report(std::ostream& out) const
+        {
+            Statistics snapshot = get_statistics();
+
+            char line[256];
+            if (snapshot.warm_start)
+                snprintf(line, sizeof(line), "Pipeline cache: warm start, %zu bytes loaded from %s\n", snapshot.loaded_bytes, path.c_str());
+            else
+                snprintf(line, sizeof(line), "Pipeline cache: cold start (%s)\n", snapshot.rejection_reason.c_str());
+            out << line;
+
+            snprintf(line, sizeof(line),
+                "Pipeline creation: %u pipelines in %.3f ms (%s), %u shader modules created, %u deduplicated\n",
+                snapshot.pipelines_created, snapshot.pipeline_creation_ms,
+                snapshot.warm_start ? "warm" : "cold",
+                snapshot.shader_modules_created, snapshot.shader_module_hits);
+            out << line;
+        }
+
+        std::string PipelineCache::validate_header(const std::vector<char>& data, const VkPhysicalDeviceProperties& properties)
+        {
+            VkPipelineCacheHeaderVersionOne header;
+            if (data.size() < sizeof(header))
+                return "cache file is truncated";
+
+            memcpy(&header, data.data(), sizeof(header));
+
+            if (header.headerSize < sizeof(header) || header.headerSize > data.size())
+                return "invalid header size";
+            if (header.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE)
+                return "unknown header version";
+            if (header.vendorID != properties.vendorID)
+                return "vendor mismatch";
+            if (header.deviceID != properties.deviceID)
+                return "device mismatch";
+            if (memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+                return "driver pipelineCacheUUID changed";
+
+            return "";
+        }
+
+        uint64_t PipelineCache::hash_code(const std::vector<uint32_t>& code)
+        {
+            // FNV-1a over the words.
+            uint64_t hash = 14695981039346656037ull;
+            for (uint32_t word : code)
+            {
+                hash ^= word;
+                hash *= 1099511628211ull;
+            }
+            return hash;
+        }
+    };
+};
@@ -0,0 +1,116 @@
+#pragma once
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-09-27
+ *
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <cstdint>
+#include <stdexcept>
+
+#include "../utils/platform.hpp"
+#include "../utils/device_capabilities.hpp"
+
+namespace VulkanGameEngine
+{
+    namespace Graphics
+    {
+        /**
+         * VkPipelineCache persisted on disk between runs, plus a VkShaderModule
+         * cache keyed by SPIR-V content so identical shaders are created once.
+         *
+         * The cache file is only used when its header matches the vendor, device
+         * and pipelineCacheUUID of the current physical device. It is written to a
+         * temporary file and renamed over the old one, so a crash never leaves a
+         * truncated cache behind.
+         *
+         * Every pipeline of the engine, including hot reload rebuilds on the shader
+         * watcher thread, is created through here: the module cache and the
+         * statistics are guarded by a mutex, and VkPipelineCache is internally
+         * synchronized so pipeline creation itself runs outside of it.
+         */
+        class PipelineCache
+        {
+            public:
+                struct Statistics
+                {
+                    // True when valid data was loaded from disk.
+                    bool warm_start = false;
+                    size_t loaded_bytes = 0;
+                    std::string rejection_reason;
+
+                    uint32_t pipelines_created = 0;
+                    double pipeline_creation_ms = 0.0;
+
+                    uint32_t shader_modules_created = 0;
+                    uint32_t shader_module_hits = 0;
+                };
+
+            private:
+                struct ShaderModuleEntry
+                {
+                    VkShaderModule module;
+                    std::vector<uint32_t> code;
+                };
+
+                VkDevice device = VK_NULL_HANDLE;
+                VkPhysicalDeviceProperties device_properties{};
+
+                std::string path;
+                VkPipelineCache cache = VK_NULL_HANDLE;
+
+                // Guards shader_modules and statistics.
+                mutable std::mutex mutex;
+                std::unordered_multimap<uint64_t, ShaderModuleEntry> shader_modules;
+
+                Statistics statistics;
+
+            public:
+                void init(VkDevice device, const Utils::DeviceCapabilities& capabilities, const std::string& path);
+
+                /**
+                 * Saves the cache, then destroys it and every cached shader module.
+                 */
+                void cleanup();
+
+                /**
+                 * Write the cache to disk. Returns false if it could not be written.
+                 */
+                bool save();
+
+                VkPipelineCache get_cache() const { return cache; }
+
+                /**
+                 * Returns the existing module when the same SPIR-V was seen before.
+                 * Modules are owned by the cache.
+                 */
+                VkShaderModule get_shader_module(const std::vector<uint32_t>& code);
+
+                /**
+                 * Destroy cached shader modules once the pipelines using them exist.
+                 * No pipeline may be being built meanwhile, e.g. by the shader watcher.
+                 */
+                void clear_shader_modules();
+
+                VkPipeline create_graphics_pipeline(const VkGraphicsPipelineCreateInfo& create_info);
+
+                VkPipeline create_compute_pipeline(const VkComputePipelineCreateInfo& create_info);
+
+                Statistics get_statistics() const;
+
+                void print_report(std::ostream& out) const;
+
+                /**
+                 * Check a cache blob against the device. Returns an empty string when it is usable.
+                 */
+                static std::string validate_header(const std::vector<char>& data, const VkPhysicalDeviceProperties& properties);
+
+                static uint64_t hash_code(const std::vector<uint32_t>& code);
+        };
+    };
+};
@@ -0,0 +1,748 @@
+#include "render_graph.hpp"
+#include "../profiling/profiler.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace VulkanGameEngine
+{
+    namespace Graphics
+    {
+        struct UsageInfo
+        {
+            VkPipelineStageFlags stages;
+            VkAccessFlags read_access;
+            VkAccessFlags write_access;
+            VkImageLayout layout;
+            VkImageUsageFlags image_usage;
+            bool image;
+            bool buffer;
+        };
+
+        static const VkAccessFlags write_access_mask =
+            VK_ACCESS_SHADER_WRITE_BIT |
+            VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+            VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+            VK_ACCESS_TRANSFER_WRITE_BIT |
+            VK_ACCESS_HOST_WRITE_BIT |
+            VK_ACCESS_MEMORY_WRITE_BIT;
+
+        static UsageInfo get_usage_info(ResourceUsage usage)
+        {
+            switch (usage)
+            {
+                case ResourceUsage::ColorAttachment:
+                    return {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                        VK_ACCESS_COLOR_ATTACHMENT_READ_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                        VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, true, false};
+                case ResourceUsage::DepthStencilAttachment:
+                    return {VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+                        VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                        VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, true, false};
+                case ResourceUsage::DepthStencilRead:
+                    return {VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                        VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_SHADER_READ_BIT, 0,
+                        VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+                        VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, true, false};
+                case ResourceUsage::SampledFragment:
+                    return {VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, 0,
+                        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_USAGE_SAMPLED_BIT, true, false};
+                case ResourceUsage::SampledCompute:
+                    return {VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, 0,
+                        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_USAGE_SAMPLED_BIT, true, false};
+                case ResourceUsage::StorageCompute:
+                    return {VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+                        VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_USAGE_STORAGE_BIT, true, true};
+                case ResourceUsage::TransferSource:
+                    return {VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT, 0,
+                        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT, true, true};
+                case ResourceUsage::TransferDestination:
+                    return {VK_PIPELINE_STAGE_TRANSFER_BIT, 0, VK_ACCESS_TRANSFER_WRITE_BIT,
+                        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT, true, true};
+                case ResourceUsage::VertexBuffer:
+                    return {VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT, 0,
+                        VK_IMAGE_LAYOUT_UNDEFINED, 0, false, true};
+                case ResourceUsage::IndexBuffer:
+                    return {VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_INDEX_READ_BIT, 0,
+                        VK_IMAGE_LAYOUT_UNDEFINED, 0, false, true};
+                case ResourceUsage::IndirectBuffer:
+                    return {VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT, 0,
+                        VK_IMAGE_LAYOUT_UNDEFINED, 0, false, true};
+                case ResourceUsage::UniformBuffer:
+                    return {VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                        VK_ACCESS_UNIFORM_READ_BIT, 0, VK_IMAGE_LAYOUT_UNDEFINED, 0, false, true};
+            }
+
+            throw std::runtime_error("\nUnknown render graph resource usage.");
+        }
+
+        std::vector<AliasedMemory> alias_transient_memory(const std::vector<TransientLifetime>& lifetimes)
+        {
+            std::vector<uint32_t> order(lifetimes.size());
+            for (uint32_t i = 0; i < order.size(); i++)
+                order[i] = i;
+            std::stable_sort(order.begin(), order.end(), [&lifetimes](uint32_t a, uint32_t b) {
+                return lifetimes[a].requirements.size > lifetimes[b].requirements.size;
+            });
+
+            std::vector<AliasedMemory> memories;
+            for (uint32_t image : order)
+            {
+                const TransientLifetime& lifetime = lifetimes[image];
+
+                uint32_t best = UINT32_MAX;
+                VkDeviceSize best_growth = 0;
+                for (uint32_t m = 0; m < memories.size(); m++)
+                {
+                    const AliasedMemory& memory = memories[m];
+                    if ((memory.memory_type_bits & lifetime.requirements.memoryTypeBits) == 0)
+                        continue;
+
+                    bool overlaps = false;
+                    for (uint32_t other : memory.images)
+                        if (!(lifetimes[other].last_pass < lifetime.first_pass || lifetime.last_pass < lifetimes[other].first_pass))
+                            overlaps = true;
+                    if (overlaps)
+                        continue;
+
+                    VkDeviceSize growth = lifetime.requirements.size > memory.size ? lifetime.requirements.size - memory.size : 0;
+                    if (best == UINT32_MAX || growth < best_growth)
+                    {
+                        best = m;
+                        best_growth = growth;
+                    }
+                }
+
+                if (best == UINT32_MAX)
+                {
+                    memories.emplace_back();
+                    best = static_cast<uint32_t>(memories.size() - 1);
+                }
+
+                AliasedMemory& memory = memories[best];
+                memory.size = std::max(memory.size, lifetime.requirements.size);
+                memory.alignment = std::max(memory.alignment, lifetime.requirements.alignment);
+                memory.memory_type_bits &= lifetime.requirements.memoryTypeBits;
+                memory.images.push_back(image);
+            }
+
+            return memories;
+        }
+
+        RenderGraph::PassBuilder& RenderGraph::PassBuilder::read(RenderResource resource, ResourceUsage usage)
+        {
+            graph.add_access(pass, resource, usage, true, false);
+            return *this;
+        }
+
+        RenderGraph::PassBuilder& RenderGraph::PassBuilder::write(RenderResource resource, ResourceUsage usage)
+        {
+            graph.add_access(pass, resource, usage, false, true);
+            return *this;
+        }
+
+        RenderGraph::PassBuilder& RenderGraph::PassBuilder::read_write(RenderResource resource, ResourceUsage usage)
+        {
+            graph.add_access(pass, resource, usage, true, true);
+            return *this;
+        }
+
+        RenderGraph::PassBuilder& RenderGraph::PassBuilder::side_effect()
+        {
+            graph.passes[pass].side_effect = true;
+            return *this;
+        }
+
+        void RenderGraph::init(VkDevice device, Memory::MemoryAllocator& allocator, uint32_t frames_in_flight)
+        {
+            this->device = device;
+            this->allocator = &allocator;
+            this->frames_in_flight = std::max(1u, frames_in_flight);
+        }
+
+        void RenderGraph::cleanup()
+        {
+            reset();
+        }
+
+        void RenderGraph::reset()
+        {
+            destroy_transient_images();
+
+            passes.clear();
+            resources.clear();
+            final_barriers = BarrierBatch{};
+            statistics = Statistics{};
+            compiled = false;
+        }
+
+        RenderResource RenderGraph::create_image(const std::string& name, const RenderImageDescription& description)
+        {
+            Resource resource;
+            resource.name = name;
+            resource.description = description;
+
+            resources.push_back(resource);
+            compiled = false;
+            return static_cast<RenderResource>(resources.size() - 1);
+        }
+
+        RenderResource RenderGraph::import_image(
+            const std::string& name,
+            VkImageAspectFlags aspect,
+            const ResourceState& initial_state,
+            const ResourceState& final_state)
+        {
+            Resource resource;
+            resource.name = name;
+            resource.imported = true;
+            resource.description.aspect = aspect;
+            resource.initial_state = initial_state;
+            resource.final_state = final_state;
+
+            resources.push_back(resource);
+            compiled = false;
+            return static_cast<RenderResource>(resources.size() - 1);
+        }
+
+        RenderResource RenderGraph::import_buffer(const std::string& name, const ResourceState& initial_state)
+        {
+            Resource resource;
+            resource.name = name;
+            resource.is_image = false;
+            resource.imported = true;
+            resource.initial_state = initial_state;
+            resource.initial_state.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+            resources.push_back(resource);
+            compiled = false;
+            return static_cast<RenderResource>(resources.size() - 1);
+        }
+
+        RenderGraph::PassBuilder RenderGraph::add_pass(const std::string& name, PassFunction function)
+        {
+            Pass pass;
+            pass.name = name;
+            pass.function = std::move(function);
+
+            passes.push_back(std::move(pass));
+            compiled = false;
+            return PassBuilder(*this, static_cast<uint32_t>(passes.size() - 1));
+        }
+
+        void RenderGraph::add_access(uint32_t pass, RenderResource resource, ResourceUsage usage, bool read, bool write)
+        {
+            if (resource >= resources.size())
+                throw std::runtime_error("\nInvalid render graph resource in pass " + passes[pass].name + ".");
+
+            const Resource& target = resources[resource];
+            UsageInfo info = get_usage_info(usage);
+
+            if ((target.is_image && !info.image) || (!target.is_image && !info.buffer))
+                throw std::runtime_error("\nUsage does not apply to " + target.name + " in pass " + passes[pass].name + ".");
+            if (write && info.write_access == 0)
+                throw std::runtime_error("\nRead-only usage written to " + target.name + " in pass " + passes[pass].name + ".");
+
+            passes[pass].accesses.push_back({resource, usage, read, write});
+        }
+
+        void RenderGraph::compile()
+        {
+            VGE_PROFILE_SCOPE("render_graph_compile");
+
+            destroy_transient_images();
+            final_barriers = BarrierBatch{};
+            statistics = Statistics{};
+
+            cull_passes();
+            compute_lifetimes();
+            create_transient_images();
+            compute_barriers();
+
+            statistics.passes = static_cast<uint32_t>(passes.size());
+            for (const auto& pass : passes)
+            {
+                if (pass.culled)
+                {
+                    statistics.culled_passes++;
+                    continue;
+                }
+
+                if (!pass.barriers.empty())
+                    statistics.barrier_batches++;
+                statistics.image_barriers += static_cast<uint32_t>(pass.barriers.images.size());
+                statistics.buffer_barriers += static_cast<uint32_t>(pass.barriers.buffers.size());
+            }
+            if (!final_barriers.empty())
+                statistics.barrier_batches++;
+            statistics.image_barriers += static_cast<uint32_t>(final_barriers.images.size());
+
+            compiled = true;
+        }
+
+        void RenderGraph::cull_passes()
+        {
+            // Walk backwards: a pass survives when it writes something a surviving later
+            // pass reads before it is overwritten, something imported, or has side effects.
+            std::vector<bool> needed(resources.size(), false);
+
+            for (size_t i = passes.size(); i-- > 0;)
+            {
+                Pass& pass = passes[i];
+
+                bool alive = pass.side_effect;
+                for (const auto& access : pass.accesses)
+                    if (access.write && (resources[access.resource].imported || needed[access.resource]))
+                        alive = true;
+
+                pass.culled = !alive;
+                if (!alive)
+                    continue;
+
+                // A full write ends the previous contents' lifetime; reads start one.
+                for (const auto& access : pass.accesses)
+                    if (access.write && !access.read)
+                        needed[access.resource] = false;
+                for (const auto& access : pass.accesses)
+                    if (access.read)
+                        needed[access.resource] = true;
+            }
+        }
+
+        void RenderGraph::compute_lifetimes()
+        {
+            for (auto& resource : resources)
+            {
+                resource.first_pass = -1;
+                resource.last_pass = -1;
+                resource.image_usage = 0;
+            }
+
+            for (size_t i = 0; i < passes.size(); i++)
+            {
+                if (passes[i].culled)
+                    continue;
+
+                for (const auto& access : passes[i].accesses)
+                {
+                    Resource& resource = resources[access.resource];
+                    if (resource.first_pass < 0)
+                        resource.first_pass = static_cast<int32_t>(i);
+                    resource.last_pass = static_cast<int32_t>(i);
+                    resource.image_usage |= get_usage_info(access.usage).image_usage;
+                }
+            }
+        }
+
+        void RenderGraph::create_transient_images()
+        {
+            std::vector<RenderResource> transients;
+            for (RenderResource i = 0; i < resources.size(); i++)
+                if (!resources[i].imported && resources[i].first_pass >= 0)
+                    transients.push_back(i);
+
+            auto create = [this](Resource& resource) {
+                VkImageCreateInfo create_info{};
+                create_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+                create_info.imageType = VK_IMAGE_TYPE_2D;
+                create_info.extent = {resource.description.extent.width, resource.description.extent.height, 1};
+                create_info.mipLevels = 1;
+                create_info.arrayLayers = 1;
+                create_info.format = resource.description.format;
+                create_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+                create_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+                create_info.usage = resource.image_usage;
+                create_info.samples = VK_SAMPLE_COUNT_1_BIT;
+                create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+                VkImage image;
+                if (vkCreateImage(device, &create_info, nullptr, &image) != VK_SUCCESS)
+                    throw std::runtime_error("\nFailed to create transient image " + resource.name + ".");
+
+                resource.images.push_back(image);
+            };
+
+            for (RenderResource id : transients)
+            {
+                Resource& resource = resources[id];
+                for (uint32_t frame = 0; frame < frames_in_flight; frame++)
+                    create(resource);
+
+                vkGetImageMemoryRequirements(device, resource.images[0], &resource.requirements);
+                statistics.transient_bytes_requested += resource.requirements.size * frames_in_flight;
+            }
+
+            std::vector<TransientLifetime> lifetimes;
+            for (RenderResource id : transients)
+                lifetimes.push_back({resources[id].first_pass, resources[id].last_pass, resources[id].requirements});
+
+            for (const AliasedMemory& aliased : alias_transient_memory(lifetimes))
+            {
+                MemorySlot slot;
+                slot.size = aliased.size;
+                slot.alignment = aliased.alignment;
+                slot.memory_type_bits = aliased.memory_type_bits;
+                for (uint32_t image : aliased.images)
+                {
+                    slot.resources.push_back(transients[image]);
+                    resources[transients[image]].memory_slot = static_cast<uint32_t>(memory_slots.size());
+                }
+
+                memory_slots.push_back(std::move(slot));
+            }
+
+            for (auto& slot : memory_slots)
+            {
+                VkMemoryRequirements requirements{};
+                requirements.size = slot.size;
+                requirements.alignment = slot.alignment;
+                requirements.memoryTypeBits = slot.memory_type_bits;
+
+                for (uint32_t frame = 0; frame < frames_in_flight; frame++)
+                    slot.allocations.push_back(allocator->allocate(requirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, Memory::ResourceKind::Optimal));
+
+                statistics.transient_bytes_allocated += slot.size * frames_in_flight;
+
+                for (RenderResource id : slot.resources)
+                {
+                    Resource& resource = resources[id];
+                    for (uint32_t frame = 0; frame < frames_in_flight; frame++)
+                    {
+                        const Memory::Allocation& allocation = slot.allocations[frame];
+                        vkBindImageMemory(device, resource.images[frame], allocation.memory, allocation.offset);
+
+                        VkImageViewCreateInfo view_info{};
+                        view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+                        view_info.image = resource.images[frame];
+                        view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+                        view_info.format = resource.description.format;
+                        view_info.subresourceRange = {resource.description.aspect, 0, 1, 0, 1};
+
+                        VkImageView view;
+                        if (vkCreateImageView(device, &view_info, nullptr, &view) != VK_SUCCESS)
+                            throw std::runtime_error("\nFailed to create transient image view " + resource.name + ".");
+                        resource.views.push_back(view);
+                    }
+                }
+            }
+
+            statistics.transient_images = static_cast<uint32_t>(transients.size());
+            statistics.memory_slots = static_cast<uint32_t>(memory_slots.size());
+        }
+
+        void RenderGraph::destroy_transient_images()
+        {
+            for (auto& resource : resources)
+            {
+                for (auto view : resource.views)
+                    vkDestroyImageView(device, view, nullptr);
+                for (auto image : resource.images)
+                    vkDestroyImage(device, image, nullptr);
+
+                resource.views.clear();
+                resource.images.clear();
+                resource.memory_slot = UINT32_MAX;
+            }
+
+            for (auto& slot : memory_slots)
+                for (auto& allocation : slot.allocations)
+                    allocator->free(allocation);
+            memory_slots.clear();
+        }
+
+        void RenderGraph::compute_barriers()
+        {
+            // What synchronization the next access of a resource has to wait on.
+            struct Tracker
+            {
+                VkImageLayout layout;
+                VkPipelineStageFlags write_stages;
+                VkAccessFlags write_access;
+                // Stages that read since the last write: a write must wait for them.
+                VkPipelineStageFlags read_stages;
+                // Stages / accesses the last write was already made visible to.
+                VkPipelineStageFlags visible_stages;
+                VkAccessFlags visible_access;
+            };
+
+            struct MergedAccess
+            {
+                RenderResource resource;
+                VkPipelineStageFlags stages;
+                VkAccessFlags access;
+                VkImageLayout layout;
+                bool read;
+                bool write;
+            };
+
+            std::vector<Tracker> trackers(resources.size());
+            for (size_t i = 0; i < resources.size(); i++)
+            {
+                const ResourceState& initial = resources[i].initial_state;
+                trackers[i] = {initial.layout, initial.stages, initial.access & write_access_mask, initial.stages, 0, 0};
+            }
+
+            auto add_barrier = [this](BarrierBatch& batch, RenderResource resource, VkPipelineStageFlags src_stages, VkAccessFlags src_access,
+                VkPipelineStageFlags dst_stages, VkAccessFlags dst_access, VkImageLayout old_layout, VkImageLayout new_layout) {
+                batch.src_stages |= src_stages ? src_stages : static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+                batch.dst_stages |= dst_stages;
+
+                if (resources[resource].is_image)
+                    batch.images.push_back({resource, old_layout, new_layout, src_access, dst_access});
+                else
+                    batch.buffers.push_back({resource, src_access, dst_access});
+            };
+
+            for (size_t p = 0; p < passes.size(); p++)
+            {
+                Pass& pass = passes[p];
+                pass.barriers = BarrierBatch{};
+                if (pass.culled)
+                    continue;
+
+                // Several usages of one resource in a pass share a single barrier.
+                std::vector<MergedAccess> merged;
+                for (const auto& access : pass.accesses)
+                {
+                    UsageInfo info = get_usage_info(access.usage);
+                    VkAccessFlags flags = (access.read ? info.read_access : 0) | (access.write ? info.write_access : 0);
+
+                    auto existing = std::find_if(merged.begin(), merged.end(), [&](const MergedAccess& entry) { return entry.resource == access.resource; });
+                    if (existing == merged.end())
+                        merged.push_back({access.resource, info.stages, flags, info.layout, access.read, access.write});
+                    else
+                    {
+                        if (resources[access.resource].is_image && existing->layout != info.layout)
+                            throw std::runtime_error("\nConflicting layouts for " + resources[access.resource].name + " in pass " + pass.name + ".");
+
+                        existing->stages |= info.stages;
+                        existing->access |= flags;
+                        existing->read |= access.read;
+                        existing->write |= access.write;
+                    }
+                }
+
+                for (const auto& access : merged)
+                {
+                    Resource& resource = resources[access.resource];
+                    Tracker& tracker = trackers[access.resource];
+
+                    // A transient image taking over aliased memory starts after the previous
+                    // occupant's last use; its contents are undefined either way.
+                    if (!resource.imported && resource.first_pass == static_cast<int32_t>(p))
+                    {
+                        tracker = {VK_IMAGE_LAYOUT_UNDEFINED, 0, 0, 0, 0, 0};
+
+                        int32_t previous_end = -1;
+                        for (RenderResource other : memory_slots[resource.memory_slot].resources)
+                        {
+                            const Resource& occupant = resources[other];
+                            if (other != access.resource && occupant.last_pass < resource.first_pass && occupant.last_pass > previous_end)
+                            {
+                                previous_end = occupant.last_pass;
+                                tracker.write_stages = trackers[other].write_stages | trackers[other].read_stages;
+                                tracker.write_access = trackers[other].write_access;
+                            }
+                        }
+                    }
+
+                    bool layout_change = resource.is_image && tracker.layout != access.layout;
+
+                    if (layout_change || access.write)
+                    {
+                        VkPipelineStageFlags src_stages = tracker.write_stages | tracker.read_stages;
+                        if (layout_change || src_stages != 0)
+                            add_barrier(pass.barriers, access.resource, src_stages, tracker.write_access,
+                                access.stages, access.access, tracker.layout, resource.is_image ? access.layout : VK_IMAGE_LAYOUT_UNDEFINED);
+
+                        if (access.write)
+                        {
+                            tracker.write_stages = access.stages;
+                            tracker.write_access = access.access & write_access_mask;
+                            tracker.read_stages = access.read ? access.stages : 0;
+                            tracker.visible_stages = 0;
+                            tracker.visible_access = 0;
+                        }
+                        else
+                        {
+                            // The transition is the last write; it is visible to this access.
+                            tracker.write_stages = access.stages;
+                            tracker.write_access = 0;
+                            tracker.read_stages = access.stages;
+                            tracker.visible_stages = access.stages;
+                            tracker.visible_access = access.access;
+                        }
+
+                        if (resource.is_image)
+                            tracker.layout = access.layout;
+                    }
+                    else
+                    {
+                        // Read after read needs nothing; a read after a write needs the write
+                        // made visible to its stages once.
+                        bool hidden = (access.stages & ~tracker.visible_stages) || (access.access & ~tracker.visible_access);
+                        if (tracker.write_stages != 0 && hidden)
+                        {
+                            add_barrier(pass.barriers, access.resource, tracker.write_stages, tracker.write_access,
+                                access.stages, access.access, tracker.layout, tracker.layout);
+                            tracker.visible_stages |= access.stages;
+                            tracker.visible_access |= access.access;
+                        }
+
+                        tracker.read_stages |= access.stages;
+                    }
+                }
+            }
+
+            for (RenderResource i = 0; i < resources.size(); i++)
+            {
+                const Resource& resource = resources[i];
+                const Tracker& tracker = trackers[i];
+
+                if (!resource.imported || !resource.is_image || resource.final_state.layout == VK_IMAGE_LAYOUT_UNDEFINED)
+                    continue;
+                if (tracker.layout == resource.final_state.layout)
+                    continue;
+
+                add_barrier(final_barriers, i, tracker.write_stages | tracker.read_stages, tracker.write_access,
+                    resource.final_state.stages ? resource.final_state.stages : static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT),
+                    resource.final_state.access, tracker.layout, resource.final_state.layout);
+            }
+        }
+
+        void RenderGraph::set_image(RenderResource resource, VkImage image, VkImageView view)
+        {
+            if (resource >= resources.size() || !resources[resource].imported || !resources[resource].is_image)
+                throw std::runtime_error("\nset_image() needs an imported render graph image.");
+
+            resources[resource].image = image;
+            resources[resource].view = view;
+        }
+
+        void RenderGraph::set_buffer(RenderResource resource, VkBuffer buffer)
+        {
+            if (resource >= resources.size() || !resources[resource].imported || resources[resource].is_image)
+                throw std::runtime_error("\nset_buffer() needs an imported render graph buffer.");
+
+            resources[resource].buffer = buffer;
+        }
+
+        void RenderGraph::execute(VkCommandBuffer command_buffer, uint32_t frame_slot)
+        {
+            VGE_PROFILE_SCOPE("render_graph_execute");
+
+            if (!compiled)
+                throw std::runtime_error("\nRender graph executed before compile().");
+
+            current_frame = frame_slot % frames_in_flight;
+
+            for (const auto& pass : passes)
+            {
+                if (pass.culled)
+                    continue;
+
+                record_barriers(command_buffer, pass.barriers);
+                if (pass.function)
+                    pass.function(command_buffer, *this);
+            }
+
+            record_barriers(command_buffer, final_barriers);
+        }
+
+        VkImage RenderGraph::get_image(RenderResource resource) const
+        {
+            const Resource& target = resources.at(resource);
+            if (target.imported)
+                return target.image;
+            return target.images.empty() ? VK_NULL_HANDLE : target.images[current_frame];
+        }
+
+        VkImageView RenderGraph::get_image_view(RenderResource resource) const
+        {
+            const Resource& target = resources.at(resource);
+            if (target.imported)
+                return target.view;
+            return target.views.empty() ? VK_NULL_HANDLE : target.views[current_frame];
+        }
+
+        VkBuffer RenderGraph::get_buffer(RenderResource resource) const
+        {
+            return resources.at(resource).buffer;
+        }
+
+        bool RenderGraph::is_culled(const std::string& pass_name) const
+        {
+            for (const auto& pass : passes)
+                if (pass.name == pass_name)
+                    return pass.culled;
+
+            return true;
+        }
+
+        void RenderGraph::print_report(std::ostream& out) const
+        {
+            char line[256];
+            snprintf(line, sizeof(line),
+                "Render graph: %u passes (%u culled), %u barrier batches (%u image, %u buffer barriers), "
+                "%u transient images in %u memory slots, %.2f MiB requested / %.2f MiB allocated\n",
+                statistics.passes, statistics.culled_passes,
+                statistics.barrier_batches, statistics.image_barriers, statistics.buffer_barriers,
+                statistics.transient_images, statistics.memory_slots,
+                statistics.transient_bytes_requested / (1024.0 * 1024.0),
+                statistics.transient_bytes_allocated / (1024.0 * 1024.0));
+            out << line;
+        }
+
+        void RenderGraph::record_barriers(VkCommandBuffer command_buffer, const BarrierBatch& batch)
+        {
+            if (batch.empty())
+                return;
+
+            image_barrier_scratch.clear();
+            buffer_barrier_scratch.clear();
+
+            for (const auto& barrier : batch.images)
+            {
+                VkImage image = get_image(barrier.resource);
+                if (image == VK_NULL_HANDLE)
+                    throw std::runtime_error("\nNo image bound to render graph resource " + resources[barrier.resource].name + ".");
+
+                VkImageMemoryBarrier image_barrier{};
+                image_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+                image_barrier.srcAccessMask = barrier.src_access;
+                image_barrier.dstAccessMask = barrier.dst_access;
+                image_barrier.oldLayout = barrier.old_layout;
+                image_barrier.newLayout = barrier.new_layout;
+                image_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                image_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                image_barrier.image = image;
+                image_barrier.subresourceRange = {resources[barrier.resource].description.aspect, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS};
+                image_barrier_scratch.push_back(image_barrier);
+            }
+
+            for (const auto& barrier : batch.buffers)
+            {
+                VkBuffer buffer = get_buffer(barrier.resource);
+                if (buffer == VK_NULL_HANDLE)
+                    throw std::runtime_error("\nNo buffer bound to render graph resource " + resources[barrier.resource].name + ".");
+
+                VkBufferMemoryBarrier buffer_barrier{};
+                buffer_barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+                buffer_barrier.srcAccessMask = barrier.src_access;
+                buffer_barrier.dstAccessMask = barrier.dst_access;
+                buffer_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                buffer_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                buffer_barrier.buffer = buffer;
+                buffer_barrier.offset = 0;
+                buffer_barrier.size = VK_WHOLE_SIZE;
+                buffer_barrier_scratch.push_back(buffer_barrier);
+            }
+
+            vkCmdPipelineBarrier(
+                command_buffer, batch.src_stages, batch.dst_stages, 0,
+                0, nullptr,
+                static_cast<uint32_t>(buffer_barrier_scratch.size()), buffer_barrier_scratch.data(),
+                static_cast<uint32_t>(image_barrier_scratch.size()), image_barrier_scratch.data());
+        }
+    };
+};
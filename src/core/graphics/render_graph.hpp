@@ -0,0 +1,343 @@
+#pragma once
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-02
+ *
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <functional>
+#include <cstdint>
+#include <stdexcept>
+
+#include "../utils/platform.hpp"
+#include "../memory/allocator.hpp"
+
+namespace VulkanGameEngine
+{
+    namespace Graphics
+    {
+        /**
+         * How a pass uses a resource. Each usage maps to the pipeline stages,
+         * access mask and (for images) layout the graph synchronizes with.
+         */
+        enum class ResourceUsage
+        {
+            ColorAttachment,
+            DepthStencilAttachment,
+            DepthStencilRead,
+            SampledFragment,
+            SampledCompute,
+            StorageCompute,
+            TransferSource,
+            TransferDestination,
+            VertexBuffer,
+            IndexBuffer,
+            IndirectBuffer,
+            UniformBuffer
+        };
+
+        typedef uint32_t RenderResource;
+
+        static const RenderResource invalid_render_resource = UINT32_MAX;
+
+        /**
+         * Where a resource is in the pipeline: the layout it is in and the stages
+         * and accesses that last touched it.
+         */
+        struct ResourceState
+        {
+            VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+            VkPipelineStageFlags stages = 0;
+            VkAccessFlags access = 0;
+        };
+
+        /**
+         * Transient image owned by the graph. Its usage flags are the union of
+         * the usages declared by the passes.
+         */
+        struct RenderImageDescription
+        {
+            VkExtent2D extent;
+            VkFormat format;
+            VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+        };
+
+        /**
+         * Passes [first_pass, last_pass] a transient image is alive in, and the
+         * memory it needs.
+         */
+        struct TransientLifetime
+        {
+            int32_t first_pass;
+            int32_t last_pass;
+            VkMemoryRequirements requirements;
+        };
+
+        /**
+         * Memory shared by transient images with disjoint lifetimes.
+         */
+        struct AliasedMemory
+        {
+            VkDeviceSize size = 0;
+            VkDeviceSize alignment = 1;
+            uint32_t memory_type_bits = UINT32_MAX;
+            // Indices in the lifetimes given to alias_transient_memory().
+            std::vector<uint32_t> images;
+        };
+
+        /**
+         * Largest image first, each into the memory it grows the least among those
+         * whose images are all dead before it starts or born after it ends.
+         */
+        std::vector<AliasedMemory> alias_transient_memory(const std::vector<TransientLifetime>& lifetimes);
+
+        /**
+         * Frame render graph.
+         *
+         * Passes are added in execution order and declare the resources they read
+         * and write. compile() then
+         *  - culls the passes whose results nobody consumes,
+         *  - computes the pipeline barriers and layout transitions between passes,
+         *    batched into one vkCmdPipelineBarrier per pass boundary and emitted
+         *    only for actual hazards (a read after a read in the same layout needs none),
+         *  - creates the transient images and aliases the memory of those whose
+         *    lifetimes do not overlap.
+         *
+         * The graph is compiled once and executed every frame. Transient images
+         * exist once per frame in flight. Imported images and buffers (swapchain
+         * images, persistent targets) are bound per frame with set_image() and
+         * set_buffer().
+         *
+         * Passes recording a VkRenderPass must use attachment layouts equal to the
+         * ones the graph transitions to (initialLayout == finalLayout ==
+         * *_ATTACHMENT_OPTIMAL): the graph owns every layout transition.
+         */
+        class RenderGraph
+        {
+            public:
+                typedef std::function<void(VkCommandBuffer command_buffer, const RenderGraph& graph)> PassFunction;
+
+                class PassBuilder
+                {
+                    friend class RenderGraph;
+
+                    private:
+                        RenderGraph& graph;
+                        uint32_t pass;
+
+                        PassBuilder(RenderGraph& graph, uint32_t pass) : graph(graph), pass(pass) {}
+
+                    public:
+                        PassBuilder& read(RenderResource resource, ResourceUsage usage);
+
+                        /**
+                         * The pass overwrites the whole resource; previous contents are discarded.
+                         */
+                        PassBuilder& write(RenderResource resource, ResourceUsage usage);
+
+                        /**
+                         * The pass reads and modifies the resource (blending, load ops, accumulation).
+                         */
+                        PassBuilder& read_write(RenderResource resource, ResourceUsage usage);
+
+                        /**
+                         * Never cull the pass, e.g. it writes to something outside the graph.
+                         */
+                        PassBuilder& side_effect();
+                };
+
+                struct Statistics
+                {
+                    uint32_t passes = 0;
+                    uint32_t culled_passes = 0;
+                    uint32_t barrier_batches = 0;
+                    uint32_t image_barriers = 0;
+                    uint32_t buffer_barriers = 0;
+                    uint32_t transient_images = 0;
+                    uint32_t memory_slots = 0;
+                    VkDeviceSize transient_bytes_requested = 0;
+                    VkDeviceSize transient_bytes_allocated = 0;
+                };
+
+            private:
+                struct Access
+                {
+                    RenderResource resource;
+                    ResourceUsage usage;
+                    bool read;
+                    bool write;
+                };
+
+                struct ImageBarrier
+                {
+                    RenderResource resource;
+                    VkImageLayout old_layout;
+                    VkImageLayout new_layout;
+                    VkAccessFlags src_access;
+                    VkAccessFlags dst_access;
+                };
+
+                struct BufferBarrier
+                {
+                    RenderResource resource;
+                    VkAccessFlags src_access;
+                    VkAccessFlags dst_access;
+                };
+
+                struct BarrierBatch
+                {
+                    VkPipelineStageFlags src_stages = 0;
+                    VkPipelineStageFlags dst_stages = 0;
+                    std::vector<ImageBarrier> images;
+                    std::vector<BufferBarrier> buffers;
+
+                    bool empty() const { return images.empty() && buffers.empty(); }
+                };
+
+                struct Pass
+                {
+                    std::string name;
+                    PassFunction function;
+                    std::vector<Access> accesses;
+                    bool side_effect = false;
+                    bool culled = false;
+
+                    // Emitted before the pass runs.
+                    BarrierBatch barriers;
+                };
+
+                struct Resource
+                {
+                    std::string name;
+                    bool is_image = true;
+                    bool imported = false;
+
+                    RenderImageDescription description{};
+                    VkImageUsageFlags image_usage = 0;
+
+                    ResourceState initial_state;
+                    ResourceState final_state;
+
+                    // Alive passes using the resource.
+                    int32_t first_pass = -1;
+                    int32_t last_pass = -1;
+
+                    // Transient images: one per frame in flight, bound into memory slot memory_slot.
+                    VkMemoryRequirements requirements{};
+                    uint32_t memory_slot = UINT32_MAX;
+                    std::vector<VkImage> images;
+                    std::vector<VkImageView> views;
+
+                    // Imported resources, bound per frame.
+                    VkImage image = VK_NULL_HANDLE;
+                    VkImageView view = VK_NULL_HANDLE;
+                    VkBuffer buffer = VK_NULL_HANDLE;
+                };
+
+                /**
+                 * Memory shared by transient images with disjoint lifetimes.
+                 */
+                struct MemorySlot
+                {
+                    VkDeviceSize size = 0;
+                    VkDeviceSize alignment = 1;
+                    uint32_t memory_type_bits = UINT32_MAX;
+                    std::vector<RenderResource> resources;
+                    std::vector<Memory::Allocation> allocations;
+                };
+
+                VkDevice device = VK_NULL_HANDLE;
+                Memory::MemoryAllocator* allocator = nullptr;
+                uint32_t frames_in_flight = 1;
+
+                std::vector<Pass> passes;
+                std::vector<Resource> resources;
+                std::vector<MemorySlot> memory_slots;
+
+                // Transitions of imported resources to their final state, after the last pass.
+                BarrierBatch final_barriers;
+
+                bool compiled = false;
+                uint32_t current_frame = 0;
+
+                Statistics statistics;
+
+                // Scratch storage reused by execute().
+                std::vector<VkImageMemoryBarrier> image_barrier_scratch;
+                std::vector<VkBufferMemoryBarrier> buffer_barrier_scratch;
+
+            public:
+                void init(VkDevice device, Memory::MemoryAllocator& allocator, uint32_t frames_in_flight);
+
+                /**
+                 * Destroys the transient images; the GPU must be done with them.
+                 */
+                void cleanup();
+
+                /**
+                 * Drop every pass and resource to build a new graph.
+                 */
+                void reset();
+
+                RenderResource create_image(const std::string& name, const RenderImageDescription& description);
+
+                /**
+                 * initial_state is where the image is when the frame starts. A final_state
+                 * layout other than UNDEFINED is transitioned to after the last pass.
+                 */
+                RenderResource import_image(
+                    const std::string& name,
+                    VkImageAspectFlags aspect,
+                    const ResourceState& initial_state,
+                    const ResourceState& final_state = ResourceState{});
+
+                RenderResource import_buffer(const std::string& name, const ResourceState& initial_state = ResourceState{});
+
+                PassBuilder add_pass(const std::string& name, PassFunction function);
+
+                void compile();
+
+                bool is_compiled() const { return compiled; }
+
+                void set_image(RenderResource resource, VkImage image, VkImageView view);
+
+                void set_buffer(RenderResource resource, VkBuffer buffer);
+
+                /**
+                 * Record every pass that was not culled, with its barriers.
+                 * frame_slot selects the transient images of a frame in flight.
+                 */
+                void execute(VkCommandBuffer command_buffer, uint32_t frame_slot);
+
+                VkImage get_image(RenderResource resource) const;
+
+                VkImageView get_image_view(RenderResource resource) const;
+
+                VkBuffer get_buffer(RenderResource resource) const;
+
+                bool is_culled(const std::string& pass_name) const;
+
+                const Statistics& get_statistics() const { return statistics; }
+
+                void print_report(std::ostream& out) const;
+
+            private:
+                void add_access(uint32_t pass, RenderResource resource, ResourceUsage usage, bool read, bool write);
+
+                void cull_passes();
+
+                void compute_lifetimes();
+
+                void create_transient_images();
+
+                void destroy_transient_images();
+
+                void compute_barriers();
+
+                void record_barriers(VkCommandBuffer command_buffer, const BarrierBatch& batch);
+        };
+    };
+};
@@ -0,0 +1,369 @@
+#include "shader_reloader.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <algorithm>
+
+namespace VulkanGameEngine
+{
+    namespace Graphics
+    {
+        static const uint32_t spirv_magic = 0x07230203;
+
+        std::vector<uint32_t> load_spirv(const std::string& path)
+        {
+            std::ifstream file(path, std::ios::binary | std::ios::ate);
+            if (!file.is_open())
+                throw std::runtime_error("\nFailed to open shader " + path + ".");
+
+            size_t size = static_cast<size_t>(file.tellg());
+            if (size == 0 || size % 4 != 0)
+                throw std::runtime_error("\nShader " + path + " is not SPIR-V.");
+
+            std::vector<uint32_t> code(size / 4);
+            file.seekg(0);
+            file.read(reinterpret_cast<char*>(code.data()), size);
+
+            if (!file || code[0] != spirv_magic)
+                throw std::runtime_error("\nShader " + path + " is not SPIR-V.");
+
+            return code;
+        }
+
+        void ShaderReloader::init(VkDevice device, const std::string& compiler, std::chrono::milliseconds poll_interval)
+        {
+            this->device = device;
+            this->compiler = compiler;
+            this->poll_interval = poll_interval;
+        }
+
+        void ShaderReloader::cleanup()
+        {
+            stop_watching();
+
+            for (auto& pipeline : pipelines)
+            {
+                if (pipeline.current != VK_NULL_HANDLE)
+                    vkDestroyPipeline(device, pipeline.current, nullptr);
+                if (pipeline.pending != VK_NULL_HANDLE)
+                    vkDestroyPipeline(device, pipeline.pending, nullptr);
+            }
+
+            pipelines.clear();
+            shaders.clear();
+        }
+
+        ShaderReloader::ShaderHandle ShaderReloader::add_shader(const std::string& source_path, const std::string& spirv_path)
+        {
+            if (is_watching())
+                throw std::runtime_error("\nShaders must be added before watching starts.");
+
+            Shader shader;
+            shader.source_path = source_path;
+            shader.spirv_path = spirv_path;
+            shader.code = load_spirv(spirv_path);
+
+            std::error_code error;
+            shader.spirv_time = std::filesystem::last_write_time(spirv_path, error);
+
+            // The build's depfile lists the includes as well as the source.
+            std::vector<std::string> dependencies = read_depfile(spirv_path + ".d");
+            if (!source_path.empty() && std::find(dependencies.begin(), dependencies.end(), source_path) == dependencies.end())
+                dependencies.push_back(source_path);
+
+            for (const auto& dependency : dependencies)
+            {
+                auto time = std::filesystem::last_write_time(dependency, error);
+                if (!error)
+                    shader.dependencies.push_back({dependency, time});
+            }
+
+            shaders.push_back(std::move(shader));
+            return static_cast<ShaderHandle>(shaders.size() - 1);
+        }
+
+        ShaderReloader::PipelineHandle ShaderReloader::add_pipeline(const std::vector<ShaderHandle>& shader_handles, PipelineBuilder builder)
+        {
+            if (is_watching())
+                throw std::runtime_error("\nPipelines must be added before watching starts.");
+
+            std::vector<std::vector<uint32_t>> code;
+            for (ShaderHandle handle : shader_handles)
+                code.push_back(shaders.at(handle).code);
+
+            Pipeline pipeline;
+            pipeline.shaders = shader_handles;
+            pipeline.builder = std::move(builder);
+            pipeline.current = pipeline.builder(code);
+
+            pipelines.push_back(std::move(pipeline));
+            return static_cast<PipelineHandle>(pipelines.size() - 1);
+        }
+
+        void ShaderReloader::start_watching()
+        {
+            if (running.exchange(true))
+                return;
+
+            watcher = std::thread(&ShaderReloader::watch_loop, this);
+        }
+
+        void ShaderReloader::stop_watching()
+        {
+            if (!running.exchange(false))
+                return;
+
+            wake.notify_one();
+            watcher.join();
+        }
+
+        VkPipeline ShaderReloader::get_pipeline(PipelineHandle handle) const
+        {
+            // Only apply() changes the current pipeline, on the same thread.
+            return handle < pipelines.size() ? pipelines[handle].current : VK_NULL_HANDLE;
+        }
+
+        uint32_t ShaderReloader::apply(const std::function<void(VkPipeline)>& retire)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            uint32_t swapped = 0;
+            for (auto& pipeline : pipelines)
+            {
+                if (pipeline.pending == VK_NULL_HANDLE)
+                    continue;
+
+                if (pipeline.current != VK_NULL_HANDLE)
+                    retire(pipeline.current);
+                pipeline.current = pipeline.pending;
+                pipeline.pending = VK_NULL_HANDLE;
+                swapped++;
+            }
+
+            statistics.pipelines_swapped += swapped;
+            return swapped;
+        }
+
+        ShaderReloader::Statistics ShaderReloader::get_statistics() const
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            return statistics;
+        }
+
+        void ShaderReloader::watch_loop()
+        {
+            while (running.load())
+            {
+                auto start = std::chrono::steady_clock::now();
+
+                std::vector<bool> changed(shaders.size(), false);
+                bool any_changed = false;
+                for (ShaderHandle handle = 0; handle < shaders.size(); handle++)
+                {
+                    changed[handle] = refresh_shader(handle);
+                    any_changed = any_changed || changed[handle];
+                }
+
+                if (any_changed)
+                {
+                    rebuild_pipelines(changed);
+
+                    std::lock_guard<std::mutex> lock(mutex);
+                    statistics.last_reload_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                }
+
+                std::unique_lock<std::mutex> lock(wake_mutex);
+                wake.wait_for(lock, poll_interval, [this]() { return !running.load(); });
+            }
+        }
+
+        bool ShaderReloader::refresh_shader(ShaderHandle handle)
+        {
+            Shader& shader = shaders[handle];
+            std::error_code error;
+
+            bool source_changed = false;
+            for (auto& dependency : shader.dependencies)
+            {
+                auto time = std::filesystem::last_write_time(dependency.first, error);
+                if (!error && time != dependency.second)
+                    source_changed = true;
+            }
+
+            if (source_changed && !compiler.empty() && !shader.source_path.empty())
+            {
+                std::vector<std::string> dependencies;
+                bool compiled = compile(shader, dependencies);
+
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (compiled)
+                        statistics.recompiles++;
+                    else
+                        statistics.failures++;
+                }
+
+                if (compiled && !dependencies.empty())
+                {
+                    shader.dependencies.clear();
+                    for (const auto& dependency : dependencies)
+                        shader.dependencies.push_back({dependency, std::filesystem::file_time_type{}});
+                }
+            }
+
+            // A failed compile is not retried until the files change again.
+            if (source_changed)
+            {
+                for (auto& dependency : shader.dependencies)
+                {
+                    auto time = std::filesystem::last_write_time(dependency.first, error);
+                    if (!error)
+                        dependency.second = time;
+                }
+            }
+
+            auto spirv_time = std::filesystem::last_write_time(shader.spirv_path, error);
+            if (error || spirv_time == shader.spirv_time)
+                return false;
+
+            try
+            {
+                shader.code = load_spirv(shader.spirv_path);
+                shader.spirv_time = spirv_time;
+                return true;
+            }
+            catch (const std::exception&)
+            {
+                // Possibly still being written; the next poll tries again.
+                return false;
+            }
+        }
+
+        bool ShaderReloader::compile(const Shader& shader, std::vector<std::string>& dependencies)
+        {
+            std::string output = shader.spirv_path + ".tmp";
+            std::string depfile = output + ".d";
+
+            std::string language;
+            std::string name = std::filesystem::path(shader.source_path).filename().string();
+            if (name.size() > 5 && name.compare(name.size() - 5, 5, ".hlsl") == 0)
+            {
+                // <name>.<stage>.hlsl, as in the CMake shader step.
+                std::string stem = name.substr(0, name.size() - 5);
+                language = " -x hlsl -fshader-stage=" + stem.substr(stem.find_last_of('.') + 1);
+            }
+
+            std::string command = "\"" + compiler + "\"" + language +
+                " --target-env=vulkan1.1 -O -MD -MF \"" + depfile + "\" -o \"" + output + "\" \"" + shader.source_path + "\"";
+            #ifdef _WIN32
+                // cmd.exe strips the outer quotes of the whole command line.
+                command = "\"" + command + "\"";
+            #endif
+
+            if (std::system(command.c_str()) != 0)
+            {
+                std::cerr << "\nShader reload failed: " << shader.source_path << "\n";
+                return false;
+            }
+
+            dependencies = read_depfile(depfile);
+
+            std::error_code error;
+            std::filesystem::rename(output, shader.spirv_path, error);
+            if (error)
+            {
+                std::cerr << "\nShader reload failed: could not replace " << shader.spirv_path << "\n";
+                return false;
+            }
+            std::filesystem::rename(depfile, shader.spirv_path + ".d", error);
+
+            std::cout << "Recompiled " << shader.source_path << "\n";
+            return true;
+        }
+
+        void ShaderReloader::rebuild_pipelines(const std::vector<bool>& changed)
+        {
+            for (auto& pipeline : pipelines)
+            {
+                bool affected = false;
+                for (ShaderHandle handle : pipeline.shaders)
+                    affected = affected || changed[handle];
+                if (!affected)
+                    continue;
+
+                std::vector<std::vector<uint32_t>> code;
+                for (ShaderHandle handle : pipeline.shaders)
+                    code.push_back(shaders[handle].code);
+
+                VkPipeline rebuilt = VK_NULL_HANDLE;
+                try
+                {
+                    rebuilt = pipeline.builder(code);
+                }
+                catch (const std::exception& e)
+                {
+                    std::cerr << "\nPipeline rebuild failed: " << e.what() << "\n";
+                }
+
+                std::lock_guard<std::mutex> lock(mutex);
+                if (rebuilt == VK_NULL_HANDLE)
+                {
+                    statistics.failures++;
+                    continue;
+                }
+
+                // Rebuilt twice between two frames: the first one was never bound.
+                if (pipeline.pending != VK_NULL_HANDLE)
+                    vkDestroyPipeline(device, pipeline.pending, nullptr);
+                pipeline.pending = rebuilt;
+                statistics.pipelines_rebuilt++;
+            }
+        }
+
+        std::vector<std::string> ShaderReloader::read_depfile(const std::string& path)
+        {
+            std::vector<std::string> dependencies;
+
+            std::ifstream file(path);
+            if (!file.is_open())
+                return dependencies;
+
+            std::stringstream buffer;
+            buffer << file.rdbuf();
+            std::string contents = buffer.str();
+
+            // Make syntax: "<output>: <dependency> <dependency>", lines continued with a
+            // trailing backslash and spaces in paths escaped with a backslash.
+            size_t separator = contents.find(": ");
+            if (separator == std::string::npos)
+                return dependencies;
+
+            std::string current;
+            for (size_t i = separator + 2; i < contents.size(); i++)
+            {
+                char c = contents[i];
+                if (c == '\\' && i + 1 < contents.size() && (contents[i + 1] == ' ' || contents[i + 1] == '\n' || contents[i + 1] == '\r'))
+                {
+                    if (contents[i + 1] == ' ')
+                        current += ' ';
+                    i++;
+                    continue;
+                }
+
+                if (c == ' ' || c == '\n' || c == '\r' || c == '\t')
+                {
+                    if (!current.empty())
+                        dependencies.push_back(current);
+                    current.clear();
+                }
+                else
+                    current += c;
+            }
+            if (!current.empty())
+                dependencies.push_back(current);
+
+            return dependencies;
+        }
+    };
+};
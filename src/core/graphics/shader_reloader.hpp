@@ -0,0 +1,167 @@
+#pragma once
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-06
+ *
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <functional>
+#include <filesystem>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+
+#include "../utils/platform.hpp"
+
+namespace VulkanGameEngine
+{
+    namespace Graphics
+    {
+        /**
+         * Reads a SPIR-V binary. Throws if it is missing or not SPIR-V.
+         */
+        std::vector<uint32_t> load_spirv(const std::string& path);
+
+        /**
+         * Shader hot reload.
+         *
+         * A background thread polls the shader sources and everything they #include
+         * (read back from glslc's depfile). An edited source is recompiled with glslc
+         * on that thread, then every pipeline using it is rebuilt there too, so the
+         * render loop never waits on the compiler or on pipeline creation. A rebuilt
+         * SPIR-V file (e.g. by the CMake build) is picked up the same way.
+         *
+         * The new pipelines are only swapped in by apply(), called at a frame
+         * boundary; the replaced ones are handed back for deferred destruction.
+         * A shader that fails to compile keeps the last good pipeline.
+         */
+        class ShaderReloader
+        {
+            public:
+                typedef uint32_t ShaderHandle;
+                typedef uint32_t PipelineHandle;
+
+                static const uint32_t invalid_handle = UINT32_MAX;
+
+                /**
+                 * Builds a pipeline from the SPIR-V of its shaders, in the order they were
+                 * given to add_pipeline(). Runs on the watcher thread after a reload, so it
+                 * may only use thread-safe Vulkan calls (shader module and pipeline creation
+                 * with an internally synchronized pipeline cache are).
+                 */
+                typedef std::function<VkPipeline(const std::vector<std::vector<uint32_t>>& code)> PipelineBuilder;
+
+                struct Statistics
+                {
+                    uint32_t recompiles = 0;
+                    uint32_t failures = 0;
+                    uint32_t pipelines_rebuilt = 0;
+                    uint32_t pipelines_swapped = 0;
+                    double last_reload_ms = 0.0;
+                };
+
+            private:
+                struct Shader
+                {
+                    std::string source_path;
+                    std::string spirv_path;
+                    std::vector<uint32_t> code;
+
+                    // The source and its includes, and the SPIR-V file.
+                    std::vector<std::pair<std::string, std::filesystem::file_time_type>> dependencies;
+                    std::filesystem::file_time_type spirv_time;
+                };
+
+                struct Pipeline
+                {
+                    std::vector<ShaderHandle> shaders;
+                    PipelineBuilder builder;
+                    VkPipeline current = VK_NULL_HANDLE;
+                    // Rebuilt on the watcher thread, waiting for apply().
+                    VkPipeline pending = VK_NULL_HANDLE;
+                };
+
+                VkDevice device = VK_NULL_HANDLE;
+                std::string compiler;
+                std::chrono::milliseconds poll_interval{250};
+
+                std::vector<Shader> shaders;
+                std::vector<Pipeline> pipelines;
+                mutable std::mutex mutex;
+
+                std::thread watcher;
+                std::atomic<bool> running{false};
+                std::mutex wake_mutex;
+                std::condition_variable wake;
+
+                Statistics statistics;
+
+            public:
+                /**
+                 * Only stops the watcher, so that an exception thrown before cleanup()
+                 * does not destroy it while joinable.
+                 */
+                ~ShaderReloader() { stop_watching(); }
+
+                /**
+                 * compiler is the glslc executable; empty only reloads rebuilt SPIR-V files.
+                 */
+                void init(VkDevice device, const std::string& compiler, std::chrono::milliseconds poll_interval = std::chrono::milliseconds(250));
+
+                /**
+                 * Stops watching and destroys every pipeline; the GPU must be done with them.
+                 */
+                void cleanup();
+
+                /**
+                 * Loads spirv_path now. source_path may be empty when there is no source to watch.
+                 */
+                ShaderHandle add_shader(const std::string& source_path, const std::string& spirv_path);
+
+                /**
+                 * Builds the pipeline now, on the calling thread.
+                 */
+                PipelineHandle add_pipeline(const std::vector<ShaderHandle>& shader_handles, PipelineBuilder builder);
+
+                void start_watching();
+
+                void stop_watching();
+
+                bool is_watching() const { return running.load(); }
+
+                /**
+                 * The pipeline to bind this frame.
+                 */
+                VkPipeline get_pipeline(PipelineHandle handle) const;
+
+                /**
+                 * Swap in the pipelines rebuilt since the last call. retire receives each
+                 * replaced pipeline; frames still in flight may be using it.
+                 */
+                uint32_t apply(const std::function<void(VkPipeline)>& retire);
+
+                Statistics get_statistics() const;
+
+            private:
+                void watch_loop();
+
+                /**
+                 * Returns true when the shader's SPIR-V changed.
+                 */
+                bool refresh_shader(ShaderHandle handle);
+
+                bool compile(const Shader& shader, std::vector<std::string>& dependencies);
+
+                void rebuild_pipelines(const std::vector<bool>& changed);
+
+                static std::vector<std::string> read_depfile(const std::string& path);
+        };
+    };
+};
@@ -0,0 +1,311 @@
+#include "texture_residency.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace VulkanGameEngine
+{
+    namespace Graphics
+    {
+        void TextureResidency::init(const Settings& settings)
+        {
+            this->settings = settings;
+            // A texture requested this frame must never be picked as a victim.
+            this->settings.protected_frames = std::max(1u, settings.protected_frames);
+            this->settings.max_loads_per_update = std::max(1u, settings.max_loads_per_update);
+
+            statistics = Statistics{};
+            statistics.budget = settings.budget;
+        }
+
+        StreamedTexture TextureResidency::add(const std::vector<VkDeviceSize>& mip_sizes, uint32_t tail_mip)
+        {
+            if (mip_sizes.empty())
+                throw std::runtime_error("\nA streamed texture needs at least one mip level.");
+
+            StreamedTexture id;
+            if (!free_ids.empty())
+            {
+                id = free_ids.back();
+                free_ids.pop_back();
+            }
+            else
+            {
+                id = static_cast<StreamedTexture>(textures.size());
+                textures.emplace_back();
+            }
+
+            Texture& texture = textures[id];
+            texture = Texture{};
+            texture.mip_sizes = mip_sizes;
+            texture.tail_mip = std::min(tail_mip, static_cast<uint32_t>(mip_sizes.size()) - 1);
+            texture.resident_mip = texture.tail_mip;
+            texture.desired_mip = texture.tail_mip;
+            texture.alive = true;
+
+            // Never requested: least recently used of all.
+            texture.previous = lru_tail;
+            if (lru_tail != UINT32_MAX)
+                textures[lru_tail].next = id;
+            else
+                lru_head = id;
+            lru_tail = id;
+
+            for (uint32_t mip = texture.tail_mip; mip < mip_sizes.size(); mip++)
+                statistics.resident_bytes += mip_sizes[mip];
+            statistics.textures++;
+
+            return id;
+        }
+
+        void TextureResidency::remove(StreamedTexture id)
+        {
+            Texture& texture = textures[id];
+            if (!texture.alive)
+                return;
+
+            for (uint32_t mip = texture.resident_mip; mip < texture.mip_sizes.size(); mip++)
+                statistics.resident_bytes -= texture.mip_sizes[mip];
+            statistics.textures--;
+
+            unlink(id);
+            texture = Texture{};
+            free_ids.push_back(id);
+
+            candidates.erase(std::remove(candidates.begin(), candidates.end(), id), candidates.end());
+        }
+
+        void TextureResidency::request(StreamedTexture id, uint32_t mip, uint64_t frame)
+        {
+            Texture& texture = textures[id];
+
+            statistics.requests++;
+            if (texture.resident_mip <= mip)
+                statistics.satisfied_requests++;
+
+            if (texture.requested_mip == UINT32_MAX)
+                candidates.push_back(id);
+            texture.requested_mip = std::min(texture.requested_mip, mip);
+
+            if (texture.last_request_frame != frame || lru_head != id)
+            {
+                texture.last_request_frame = frame;
+                touch(id);
+            }
+        }
+
+        void TextureResidency::set_budget(VkDeviceSize budget)
+        {
+            settings.budget = budget;
+            statistics.budget = budget;
+        }
+
+        void TextureResidency::update(uint64_t frame, std::vector<Change>& changes)
+        {
+            for (StreamedTexture id : changed)
+                textures[id].changed = false;
+            changed.clear();
+
+            // Fold this update's requests into demand. Textures that were not requested
+            // keep their demand; only budget pressure takes their levels away.
+            for (StreamedTexture id : candidates)
+            {
+                Texture& texture = textures[id];
+                texture.desired_mip = std::min(texture.requested_mip, texture.tail_mip);
+                texture.requested_mip = UINT32_MAX;
+            }
+
+            candidates.erase(std::remove_if(candidates.begin(), candidates.end(), [&](StreamedTexture id) {
+                const Texture& texture = textures[id];
+                return texture.busy || texture.desired_mip >= texture.resident_mip;
+            }), candidates.end());
+
+            // Blurriest first, then cheapest: one level per texture and update, so a
+            // texture converges coarse to fine and every visible texture makes progress.
+            std::sort(candidates.begin(), candidates.end(), [&](StreamedTexture a, StreamedTexture b) {
+                const Texture& ta = textures[a];
+                const Texture& tb = textures[b];
+                uint32_t gap_a = ta.resident_mip - ta.desired_mip;
+                uint32_t gap_b = tb.resident_mip - tb.desired_mip;
+                if (gap_a != gap_b)
+                    return gap_a > gap_b;
+                return ta.mip_sizes[ta.resident_mip - 1] < tb.mip_sizes[tb.resident_mip - 1];
+            });
+
+            uint32_t over_resident_cursor = lru_tail;
+            uint32_t lru_cursor = lru_tail;
+
+            uint32_t loads = 0;
+            VkDeviceSize load_bytes = 0;
+
+            for (StreamedTexture id : candidates)
+            {
+                Texture& texture = textures[id];
+                VkDeviceSize cost = texture.mip_sizes[texture.resident_mip - 1];
+
+                if (loads == settings.max_loads_per_update || (loads > 0 && load_bytes + cost > settings.max_load_bytes_per_update))
+                    break;
+
+                bool fits = true;
+                while (statistics.resident_bytes + cost > settings.budget)
+                {
+                    if (!evict_one(frame, over_resident_cursor, lru_cursor, changes))
+                    {
+                        fits = false;
+                        break;
+                    }
+                }
+                // Replaced images free their memory within a few frames: evicting more
+                // for them would only reload it later.
+                if (fits && statistics.resident_bytes + statistics.retiring_bytes + cost > settings.budget)
+                    fits = false;
+                if (!fits)
+                {
+                    statistics.budget_misses++;
+                    break;
+                }
+
+                uint32_t previous_mip = texture.resident_mip;
+                texture.resident_mip--;
+                statistics.resident_bytes += cost;
+                statistics.loads++;
+                statistics.loaded_bytes += cost;
+                loads++;
+                load_bytes += cost;
+
+                record_change(id, previous_mip, changes);
+            }
+            candidates.clear();
+
+            // The budget may have shrunk since the last update.
+            while (statistics.resident_bytes > settings.budget && evict_one(frame, over_resident_cursor, lru_cursor, changes))
+                ;
+        }
+
+        bool TextureResidency::evict_one(uint64_t frame, uint32_t& over_resident_cursor, uint32_t& lru_cursor, std::vector<Change>& changes)
+        {
+            // First, levels finer than the last demand, oldest first.
+            for (; over_resident_cursor != UINT32_MAX; over_resident_cursor = textures[over_resident_cursor].previous)
+            {
+                const Texture& texture = textures[over_resident_cursor];
+                if (!texture.busy && texture.resident_mip < texture.desired_mip)
+                {
+                    evict_level(over_resident_cursor, changes);
+                    return true;
+                }
+            }
+
+            // Then the finest level of the least recently requested textures. The list is
+            // ordered by request frame, so the first protected texture ends the search.
+            for (; lru_cursor != UINT32_MAX; lru_cursor = textures[lru_cursor].previous)
+            {
+                const Texture& texture = textures[lru_cursor];
+                if (texture.last_request_frame != never_requested && frame - texture.last_request_frame < settings.protected_frames)
+                    return false;
+
+                if (!texture.busy && texture.resident_mip < texture.tail_mip)
+                {
+                    evict_level(lru_cursor, changes);
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        void TextureResidency::evict_level(uint32_t index, std::vector<Change>& changes)
+        {
+            Texture& texture = textures[index];
+            VkDeviceSize bytes = texture.mip_sizes[texture.resident_mip];
+
+            uint32_t previous_mip = texture.resident_mip;
+            texture.resident_mip++;
+            statistics.resident_bytes -= bytes;
+            statistics.evictions++;
+            statistics.evicted_bytes += bytes;
+
+            record_change(index, previous_mip, changes);
+        }
+
+        void TextureResidency::record_change(uint32_t index, uint32_t previous_mip, std::vector<Change>& changes)
+        {
+            Texture& texture = textures[index];
+
+            // A texture changes at most once per update as far as the caller can tell.
+            if (texture.changed)
+            {
+                for (auto it = changes.rbegin(); it != changes.rend(); ++it)
+                {
+                    if (it->texture != index)
+                        continue;
+
+                    it->resident_mip = texture.resident_mip;
+                    if (it->resident_mip == it->previous_mip)
+                    {
+                        changes.erase(std::next(it).base());
+                        texture.changed = false;
+                    }
+                    return;
+                }
+            }
+
+            texture.changed = true;
+            changed.push_back(index);
+            changes.push_back({index, previous_mip, texture.resident_mip});
+        }
+
+        void TextureResidency::touch(uint32_t index)
+        {
+            unlink(index);
+
+            Texture& texture = textures[index];
+            texture.previous = UINT32_MAX;
+            texture.next = lru_head;
+            if (lru_head != UINT32_MAX)
+                textures[lru_head].previous = index;
+            else
+                lru_tail = index;
+            lru_head = index;
+        }
+
+        void TextureResidency::unlink(uint32_t index)
+        {
+            Texture& texture = textures[index];
+
+            if (texture.previous != UINT32_MAX)
+                textures[texture.previous].next = texture.next;
+            else if (lru_head == index)
+                lru_head = texture.next;
+
+            if (texture.next != UINT32_MAX)
+                textures[texture.next].previous = texture.previous;
+            else if (lru_tail == index)
+                lru_tail = texture.previous;
+
+            texture.previous = UINT32_MAX;
+            texture.next = UINT32_MAX;
+        }
+
+        void TextureResidency::print_statistics(std::ostream& out) const
+        {
+            char line[256];
+
+            snprintf(line, sizeof(line), "Texture residency: %u textures, %.1f / %.1f MiB resident, %.1f MiB retiring\n",
+                statistics.textures,
+                statistics.resident_bytes / (1024.0 * 1024.0),
+                statistics.budget / (1024.0 * 1024.0),
+                statistics.retiring_bytes / (1024.0 * 1024.0));
+            out << line;
+
+            snprintf(line, sizeof(line), "  requests %llu (%.1f%% already resident), loads %llu (%.1f MiB), evictions %llu (%.1f MiB), budget misses %llu\n",
+                static_cast<unsigned long long>(statistics.requests),
+                statistics.requests ? 100.0 * statistics.satisfied_requests / statistics.requests : 100.0,
+                static_cast<unsigned long long>(statistics.loads),
+                statistics.loaded_bytes / (1024.0 * 1024.0),
+                static_cast<unsigned long long>(statistics.evictions),
+                statistics.evicted_bytes / (1024.0 * 1024.0),
+                static_cast<unsigned long long>(statistics.budget_misses));
+            out << line;
+        }
+    };
+};
@@ -0,0 +1,181 @@
+#pragma once
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-08
+ *
+ */
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+
+#include "../utils/platform.hpp"
+
+namespace VulkanGameEngine
+{
+    namespace Graphics
+    {
+        typedef uint32_t StreamedTexture;
+
+        static const StreamedTexture invalid_streamed_texture = UINT32_MAX;
+
+        /**
+         * Decides which mip levels of which textures are resident, without
+         * touching the device: TextureStreamer applies the decisions, and the
+         * streaming benchmark drives it with synthetic access patterns.
+         *
+         * A texture is resident from its resident mip down to its smallest
+         * level. The tail (the smallest levels) is loaded on creation and never
+         * evicted; finer levels are streamed in one at a time, coarse first, as
+         * long as requests ask for them. Under budget pressure, textures holding
+         * finer levels than they were last asked for lose those first, then the
+         * least recently requested textures lose their finest level.
+         */
+        class TextureResidency
+        {
+            public:
+                struct Settings
+                {
+                    VkDeviceSize budget = 256ull << 20;
+                    // Caps the streaming work of one update.
+                    uint32_t max_loads_per_update = 16;
+                    VkDeviceSize max_load_bytes_per_update = 32ull << 20;
+                    // A texture requested in the last protected_frames frames is never
+                    // evicted to make room for another one, which would only thrash.
+                    uint32_t protected_frames = 4;
+                };
+
+                /**
+                 * New resident mip of a texture, finer or coarser than before.
+                 */
+                struct Change
+                {
+                    StreamedTexture texture;
+                    uint32_t previous_mip;
+                    uint32_t resident_mip;
+                };
+
+                struct Statistics
+                {
+                    uint64_t requests = 0;
+                    // Requests whose mip level was already resident.
+                    uint64_t satisfied_requests = 0;
+                    uint64_t loads = 0;
+                    uint64_t evictions = 0;
+                    VkDeviceSize loaded_bytes = 0;
+                    VkDeviceSize evicted_bytes = 0;
+                    // Loads deferred because nothing could be evicted.
+                    uint64_t budget_misses = 0;
+
+                    uint32_t textures = 0;
+                    VkDeviceSize resident_bytes = 0;
+                    // Replaced device images still alive until the frames using them complete.
+                    VkDeviceSize retiring_bytes = 0;
+                    VkDeviceSize budget = 0;
+                };
+
+            private:
+                static const uint64_t never_requested = UINT64_MAX;
+
+                struct Texture
+                {
+                    // Bytes of every mip level; index 0 is the full resolution.
+                    std::vector<VkDeviceSize> mip_sizes;
+                    uint32_t tail_mip = 0;
+                    uint32_t resident_mip = 0;
+                    // Finest level asked for since the last update, and the demand it left behind.
+                    uint32_t requested_mip = UINT32_MAX;
+                    uint32_t desired_mip = 0;
+                    uint64_t last_request_frame = never_requested;
+
+                    bool alive = false;
+                    // Set while the device side is still applying a change.
+                    bool busy = false;
+                    bool changed = false;
+
+                    // Least recently requested list, most recent at the head.
+                    uint32_t previous = UINT32_MAX;
+                    uint32_t next = UINT32_MAX;
+                };
+
+                std::vector<Texture> textures;
+                std::vector<StreamedTexture> free_ids;
+
+                uint32_t lru_head = UINT32_MAX;
+                uint32_t lru_tail = UINT32_MAX;
+
+                Settings settings;
+                Statistics statistics;
+
+                // Requested since the last update, then the loads to consider.
+                std::vector<StreamedTexture> candidates;
+                // Changed during the current update.
+                std::vector<StreamedTexture> changed;
+
+            public:
+                void init(const Settings& settings);
+
+                /**
+                 * Registers a texture with the byte size of each mip level. The levels
+                 * from tail_mip down are resident immediately, even over budget.
+                 */
+                StreamedTexture add(const std::vector<VkDeviceSize>& mip_sizes, uint32_t tail_mip);
+
+                void remove(StreamedTexture texture);
+
+                /**
+                 * Ask for mip level mip (or finer) of texture in frame. Several requests
+                 * in one update keep the finest.
+                 */
+                void request(StreamedTexture texture, uint32_t mip, uint64_t frame);
+
+                /**
+                 * Decide this update's loads and evictions, appending them to changes.
+                 * The bookkeeping assumes the changes are applied.
+                 */
+                void update(uint64_t frame, std::vector<Change>& changes);
+
+                void set_budget(VkDeviceSize budget);
+
+                /**
+                 * Memory of an image being replaced, charged against loads until it is
+                 * destroyed. Loads wait for it rather than evicting to make room.
+                 */
+                void charge_retiring(VkDeviceSize bytes) { statistics.retiring_bytes += bytes; }
+
+                void release_retiring(VkDeviceSize bytes) { statistics.retiring_bytes -= std::min(bytes, statistics.retiring_bytes); }
+
+                VkDeviceSize get_budget() const { return settings.budget; }
+
+                /**
+                 * A busy texture is left alone by update() until cleared.
+                 */
+                void set_busy(StreamedTexture texture, bool busy) { textures[texture].busy = busy; }
+
+                uint32_t get_resident_mip(StreamedTexture texture) const { return textures[texture].resident_mip; }
+
+                uint32_t get_desired_mip(StreamedTexture texture) const { return textures[texture].desired_mip; }
+
+                uint32_t get_mip_count(StreamedTexture texture) const { return static_cast<uint32_t>(textures[texture].mip_sizes.size()); }
+
+                VkDeviceSize get_resident_bytes() const { return statistics.resident_bytes; }
+
+                const Statistics& get_statistics() const { return statistics; }
+
+                void print_statistics(std::ostream& out) const;
+
+            private:
+                void touch(uint32_t index);
+
+                void unlink(uint32_t index);
+
+                bool evict_one(uint64_t frame, uint32_t& over_resident_cursor, uint32_t& lru_cursor, std::vector<Change>& changes);
+
+                void evict_level(uint32_t index, std::vector<Change>& changes);
+
+                void record_change(uint32_t index, uint32_t previous_mip, std::vector<Change>& changes);
+        };
+    };
+};
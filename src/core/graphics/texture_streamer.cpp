@@ -0,0 +1,499 @@
+#include "texture_streamer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace VulkanGameEngine
+{
+    namespace Graphics
+    {
+        VkDeviceSize texture_level_size(VkFormat format, uint32_t width, uint32_t height)
+        {
+            uint32_t block_extent = 1;
+            VkDeviceSize block_bytes = 0;
+
+            switch (format)
+            {
+                case VK_FORMAT_R8_UNORM:
+                    block_bytes = 1;
+                    break;
+                case VK_FORMAT_R8G8_UNORM:
+                    block_bytes = 2;
+                    break;
+                case VK_FORMAT_R8G8B8A8_UNORM:
+                case VK_FORMAT_R8G8B8A8_SRGB:
+                case VK_FORMAT_B8G8R8A8_UNORM:
+                case VK_FORMAT_B8G8R8A8_SRGB:
+                    block_bytes = 4;
+                    break;
+                case VK_FORMAT_R16G16B16A16_SFLOAT:
+                    block_bytes = 8;
+                    break;
+                case VK_FORMAT_R32G32B32A32_SFLOAT:
+                    block_bytes = 16;
+                    break;
+                case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+                case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+                case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+                case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+                case VK_FORMAT_BC4_UNORM_BLOCK:
+                    block_extent = 4;
+                    block_bytes = 8;
+                    break;
+                case VK_FORMAT_BC3_UNORM_BLOCK:
+                case VK_FORMAT_BC3_SRGB_BLOCK:
+                case VK_FORMAT_BC5_UNORM_BLOCK:
+                case VK_FORMAT_BC7_UNORM_BLOCK:
+                case VK_FORMAT_BC7_SRGB_BLOCK:
+                    block_extent = 4;
+                    block_bytes = 16;
+                    break;
+                default:
+                    throw std::runtime_error("\nUnsupported streamed texture format.");
+            }
+
+            VkDeviceSize blocks_wide = (width + block_extent - 1) / block_extent;
+            VkDeviceSize blocks_high = (height + block_extent - 1) / block_extent;
+            return blocks_wide * blocks_high * block_bytes;
+        }
+
+        void TextureStreamer::init(
+            VkDevice device,
+            const Utils::DeviceCapabilities& capabilities,
+            Memory::MemoryAllocator& allocator,
+            Uploader& uploader,
+            DeletionQueue& deletion_queue,
+            BindlessTable* bindless,
+            const Settings& settings)
+        {
+            this->device = device;
+            this->capabilities = &capabilities;
+            this->allocator = &allocator;
+            this->uploader = &uploader;
+            this->deletion_queue = &deletion_queue;
+            this->bindless = bindless;
+            this->settings = settings;
+
+            // Textures live in the largest device local heap.
+            const VkPhysicalDeviceMemoryProperties& memory = capabilities.memory_properties;
+            for (uint32_t i = 0; i < memory.memoryHeapCount; i++)
+            {
+                if ((memory.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) &&
+                    memory.memoryHeaps[i].size > memory.memoryHeaps[heap_index].size)
+                    heap_index = i;
+            }
+
+            TextureResidency::Settings residency_settings;
+            residency_settings.max_loads_per_update = settings.max_loads_per_update;
+            residency_settings.max_load_bytes_per_update = settings.max_load_bytes_per_update;
+            residency.init(residency_settings);
+            refresh_budget();
+
+            VkSamplerCreateInfo sampler_info{};
+            sampler_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+            sampler_info.magFilter = VK_FILTER_LINEAR;
+            sampler_info.minFilter = VK_FILTER_LINEAR;
+            sampler_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+            sampler_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+            sampler_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+            sampler_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+            sampler_info.minLod = 0.0f;
+            // The image only holds the resident levels; let the view decide.
+            sampler_info.maxLod = 1000.0f;
+
+            if (vkCreateSampler(device, &sampler_info, nullptr, &sampler) != VK_SUCCESS)
+                throw std::runtime_error("\nFailed to create the streamed texture sampler.");
+        }
+
+        void TextureStreamer::cleanup()
+        {
+            for (auto& texture : textures)
+            {
+                destroy_version(texture.current);
+                destroy_version(texture.pending);
+            }
+            textures.clear();
+            pending_textures.clear();
+            copy_textures.clear();
+
+            if (sampler != VK_NULL_HANDLE)
+                vkDestroySampler(device, sampler, nullptr);
+            sampler = VK_NULL_HANDLE;
+        }
+
+        StreamedTexture TextureStreamer::create_texture(uint32_t width, uint32_t height, VkFormat format, uint32_t mip_count, MipSource source)
+        {
+            uint32_t full_chain = 1;
+            for (uint32_t extent = std::max(width, height); extent > 1; extent /= 2)
+                full_chain++;
+            mip_count = mip_count == 0 ? full_chain : std::min(mip_count, full_chain);
+
+            std::vector<VkDeviceSize> mip_sizes(mip_count);
+            for (uint32_t mip = 0; mip < mip_count; mip++)
+                mip_sizes[mip] = texture_level_size(format, std::max(1u, width >> mip), std::max(1u, height >> mip));
+
+            uint32_t tail_mip = mip_count - 1;
+            while (tail_mip > 0 && mip_sizes[tail_mip - 1] <= settings.tail_bytes)
+                tail_mip--;
+
+            StreamedTexture id = residency.add(mip_sizes, tail_mip);
+            if (id >= textures.size())
+                textures.resize(id + 1);
+
+            Texture& texture = textures[id];
+            texture = Texture{};
+            texture.width = width;
+            texture.height = height;
+            texture.format = format;
+            texture.mip_count = mip_count;
+            texture.source = std::move(source);
+            texture.alive = true;
+
+            build_version(id, tail_mip);
+
+            return id;
+        }
+
+        void TextureStreamer::destroy_texture(StreamedTexture id, uint64_t frame_number)
+        {
+            Texture& texture = textures[id];
+            if (!texture.alive)
+                return;
+            texture.alive = false;
+
+            if (bindless && texture.bindless_index != BindlessTable::invalid_index)
+                bindless->release_texture(texture.bindless_index, frame_number);
+            texture.bindless_index = BindlessTable::invalid_index;
+
+            retire(texture.current, texture, frame_number);
+
+            // An upload in flight still writes the pending image: it is retired, and the
+            // id released, once the upload completes.
+            if (texture.pending.image != VK_NULL_HANDLE)
+                return;
+
+            residency.remove(id);
+            texture = Texture{};
+        }
+
+        void TextureStreamer::request_screen_space(StreamedTexture id, float screen_pixels, uint64_t frame)
+        {
+            const Texture& texture = textures[id];
+            float texels = static_cast<float>(std::max(texture.width, texture.height));
+
+            uint32_t mip = texture.mip_count - 1;
+            if (screen_pixels >= texels)
+                mip = 0;
+            else if (screen_pixels > 0.0f)
+                mip = std::min(mip, static_cast<uint32_t>(std::log2(texels / screen_pixels)));
+
+            residency.request(id, mip, frame);
+        }
+
+        void TextureStreamer::submit_feedback(const uint32_t* min_mips, size_t count, uint64_t frame)
+        {
+            count = std::min(count, textures.size());
+            for (size_t i = 0; i < count; i++)
+                if (min_mips[i] != UINT32_MAX && textures[i].alive)
+                    residency.request(static_cast<StreamedTexture>(i), min_mips[i], frame);
+        }
+
+        void TextureStreamer::update(uint64_t frame_number)
+        {
+            swap_completed(frame_number);
+            refresh_budget();
+
+            changes.clear();
+            residency.update(frame_number, changes);
+
+            for (const auto& change : changes)
+                build_version(change.texture, change.resident_mip);
+        }
+
+        void TextureStreamer::refresh_budget()
+        {
+            VkDeviceSize budget = settings.budget;
+            if (budget == 0)
+                budget = capabilities->memory_properties.memoryHeaps[heap_index].size / 2;
+
+            VkPhysicalDeviceMemoryBudgetPropertiesEXT heap_budget;
+            if (Utils::query_memory_budget(*capabilities, heap_budget))
+            {
+                statistics.heap_budget = heap_budget.heapBudget[heap_index];
+                statistics.heap_usage = heap_budget.heapUsage[heap_index];
+
+                // Everyone else's usage is not ours to take; ours can be reshuffled.
+                VkDeviceSize others = statistics.heap_usage > statistics.device_bytes ? statistics.heap_usage - statistics.device_bytes : 0;
+                VkDeviceSize allowed = static_cast<VkDeviceSize>(statistics.heap_budget * settings.heap_budget_fraction);
+                budget = std::min(budget, allowed > others ? allowed - others : 0);
+            }
+
+            residency.set_budget(budget);
+        }
+
+        void TextureStreamer::build_version(StreamedTexture id, uint32_t base_mip)
+        {
+            Texture& texture = textures[id];
+
+            Version version;
+            version.base_mip = base_mip;
+            uint32_t levels = texture.mip_count - base_mip;
+
+            VkExtent2D extent{std::max(1u, texture.width >> base_mip), std::max(1u, texture.height >> base_mip)};
+            version.allocation = allocator->create_image(
+                extent,
+                texture.format,
+                VK_IMAGE_TILING_OPTIMAL,
+                VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                version.image,
+                false,
+                levels);
+
+            // Levels the current image already holds are copied on the device by
+            // record_copies(); only the ones before them come from the source.
+            uint32_t first_kept = texture.mip_count;
+            if (texture.current.image != VK_NULL_HANDLE)
+                first_kept = std::max(base_mip, texture.current.base_mip);
+
+            UploadTicket ticket = 0;
+            for (uint32_t level = 0; level < first_kept - base_mip; level++)
+            {
+                uint32_t mip = base_mip + level;
+                uint32_t width = std::max(1u, texture.width >> mip);
+                uint32_t height = std::max(1u, texture.height >> mip);
+                VkDeviceSize level_size = texture_level_size(texture.format, width, height);
+
+                ticket = uploader->upload_image(version.image, {width, height, 1}, level, 0, level_size,
+                    [&texture, mip](uint8_t* destination, VkDeviceSize, VkDeviceSize size) {
+                        texture.source(mip, destination, size);
+                    });
+            }
+
+            VkImageViewCreateInfo view_info{};
+            view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+            view_info.image = version.image;
+            view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+            view_info.format = texture.format;
+            view_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            view_info.subresourceRange.baseMipLevel = 0;
+            view_info.subresourceRange.levelCount = levels;
+            view_info.subresourceRange.baseArrayLayer = 0;
+            view_info.subresourceRange.layerCount = 1;
+
+            if (vkCreateImageView(device, &view_info, nullptr, &version.view) != VK_SUCCESS)
+                throw std::runtime_error("\nFailed to create a streamed texture view.");
+
+            statistics.device_bytes += version.allocation.size;
+
+            texture.pending = version;
+            texture.pending_ticket = ticket;
+            pending_textures.push_back(id);
+            residency.set_busy(id, true);
+
+            if (first_kept < texture.mip_count)
+            {
+                // Both images are alive until the current one is retired after the swap.
+                charge_retiring(texture.current, texture);
+                texture.copy_pending = true;
+                copy_textures.push_back(id);
+            }
+        }
+
+        void TextureStreamer::swap_completed(uint64_t frame_number)
+        {
+            size_t kept = 0;
+            for (size_t i = 0; i < pending_textures.size(); i++)
+            {
+                StreamedTexture id = pending_textures[i];
+                Texture& texture = textures[id];
+
+                if (texture.copy_pending || !uploader->is_complete(texture.pending_ticket))
+                {
+                    pending_textures[kept++] = id;
+                    continue;
+                }
+
+                if (!texture.alive)
+                {
+                    retire(texture.pending, texture, frame_number);
+                    residency.remove(id);
+                    texture = Texture{};
+                    continue;
+                }
+
+                retire(texture.current, texture, frame_number);
+                texture.current = texture.pending;
+                texture.pending = Version{};
+                residency.set_busy(id, false);
+                statistics.swaps++;
+
+                if (bindless && bindless->is_initialized())
+                {
+                    if (texture.bindless_index != BindlessTable::invalid_index)
+                        bindless->release_texture(texture.bindless_index, frame_number);
+                    texture.bindless_index = bindless->register_texture(texture.current.view, sampler);
+                }
+            }
+            pending_textures.resize(kept);
+        }
+
+        void TextureStreamer::record_copies(VkCommandBuffer command_buffer)
+        {
+            copy_barriers.clear();
+            copy_regions.clear();
+
+            size_t kept = 0;
+            for (size_t i = 0; i < copy_textures.size(); i++)
+            {
+                Texture& texture = textures[copy_textures[i]];
+                texture.copy_pending = false;
+                if (!texture.alive || texture.current.image == VK_NULL_HANDLE || texture.pending.image == VK_NULL_HANDLE)
+                    continue;
+                copy_textures[kept++] = copy_textures[i];
+
+                uint32_t first_kept = std::max(texture.pending.base_mip, texture.current.base_mip);
+                uint32_t count = texture.mip_count - first_kept;
+
+                VkImageMemoryBarrier barrier{};
+                barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+                barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+
+                barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+                barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+                barrier.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+                barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+                barrier.image = texture.current.image;
+                barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, first_kept - texture.current.base_mip, count, 0, 1};
+                copy_barriers.push_back(barrier);
+
+                barrier.srcAccessMask = 0;
+                barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+                barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+                barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+                barrier.image = texture.pending.image;
+                barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, first_kept - texture.pending.base_mip, count, 0, 1};
+                copy_barriers.push_back(barrier);
+            }
+            copy_textures.resize(kept);
+
+            if (copy_textures.empty())
+                return;
+
+            const VkPipelineStageFlags shader_stages =
+                VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+            vkCmdPipelineBarrier(command_buffer, shader_stages, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                0, nullptr, 0, nullptr, static_cast<uint32_t>(copy_barriers.size()), copy_barriers.data());
+
+            for (StreamedTexture id : copy_textures)
+            {
+                const Texture& texture = textures[id];
+                uint32_t first_kept = std::max(texture.pending.base_mip, texture.current.base_mip);
+
+                copy_regions.clear();
+                for (uint32_t mip = first_kept; mip < texture.mip_count; mip++)
+                {
+                    VkImageCopy region{};
+                    region.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, mip - texture.current.base_mip, 0, 1};
+                    region.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, mip - texture.pending.base_mip, 0, 1};
+                    region.extent = {std::max(1u, texture.width >> mip), std::max(1u, texture.height >> mip), 1};
+                    copy_regions.push_back(region);
+                }
+
+                vkCmdCopyImage(command_buffer,
+                    texture.current.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                    texture.pending.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                    static_cast<uint32_t>(copy_regions.size()), copy_regions.data());
+
+                statistics.levels_copied += copy_regions.size();
+            }
+
+            // Both images end up sampled: the current one until the swap, the
+            // pending one after it, in a later frame on the same queue.
+            for (auto& barrier : copy_barriers)
+            {
+                barrier.srcAccessMask = barrier.dstAccessMask;
+                barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+                barrier.oldLayout = barrier.newLayout;
+                barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+            }
+
+            vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, shader_stages, 0,
+                0, nullptr, 0, nullptr, static_cast<uint32_t>(copy_barriers.size()), copy_barriers.data());
+
+            copy_textures.clear();
+        }
+
+        VkDeviceSize TextureStreamer::get_version_bytes(const Version& version, const Texture& texture) const
+        {
+            VkDeviceSize bytes = 0;
+            for (uint32_t mip = version.base_mip; mip < texture.mip_count; mip++)
+                bytes += texture_level_size(texture.format, std::max(1u, texture.width >> mip), std::max(1u, texture.height >> mip));
+            return bytes;
+        }
+
+        void TextureStreamer::charge_retiring(Version& version, const Texture& texture)
+        {
+            if (version.image == VK_NULL_HANDLE || version.retiring_bytes)
+                return;
+
+            version.retiring_bytes = get_version_bytes(version, texture);
+            residency.charge_retiring(version.retiring_bytes);
+        }
+
+        void TextureStreamer::retire(Version& version, const Texture& texture, uint64_t frame_number)
+        {
+            if (version.image == VK_NULL_HANDLE)
+                return;
+
+            statistics.device_bytes -= version.allocation.size;
+            charge_retiring(version, texture);
+
+            VkDevice device = this->device;
+            Memory::MemoryAllocator* allocator = this->allocator;
+            TextureResidency* residency = &this->residency;
+            Version retired = version;
+            deletion_queue->push(frame_number, [device, allocator, residency, retired]() {
+                vkDestroyImageView(device, retired.view, nullptr);
+                allocator->destroy_image(retired.image, retired.allocation);
+                residency->release_retiring(retired.retiring_bytes);
+            });
+
+            version = Version{};
+        }
+
+        void TextureStreamer::destroy_version(Version& version)
+        {
+            if (version.image == VK_NULL_HANDLE)
+                return;
+
+            vkDestroyImageView(device, version.view, nullptr);
+            allocator->destroy_image(version.image, version.allocation);
+            version = Version{};
+        }
+
+        void TextureStreamer::print_statistics(std::ostream& out) const
+        {
+            residency.print_statistics(out);
+
+            char line[256];
+            snprintf(line, sizeof(line), "  device %.1f MiB in streamed images, %llu swaps, %llu levels copied on the device",
+                statistics.device_bytes / (1024.0 * 1024.0),
+                static_cast<unsigned long long>(statistics.swaps),
+                static_cast<unsigned long long>(statistics.levels_copied));
+            out << line;
+
+            if (capabilities && capabilities->memory_budget)
+            {
+                snprintf(line, sizeof(line), ", heap %.1f / %.1f MiB used",
+                    statistics.heap_usage / (1024.0 * 1024.0),
+                    statistics.heap_budget / (1024.0 * 1024.0));
+                out << line;
+            }
+            out << "\n";
+        }
+    };
+};
@@ -0,0 +1,230 @@
+#pragma once
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-08
+ *
+ */
+
+#include <iostream>
+#include <vector>
+#include <functional>
+#include <cstdint>
+#include <stdexcept>
+
+#include "../utils/platform.hpp"
+#include "../utils/device_capabilities.hpp"
+#include "../memory/allocator.hpp"
+#include "texture_residency.hpp"
+#include "uploader.hpp"
+#include "deletion_queue.hpp"
+#include "descriptors.hpp"
+
+namespace VulkanGameEngine
+{
+    namespace Graphics
+    {
+        /**
+         * Byte size of a width x height level of format; block compressed formats
+         * round up to whole blocks. Throws for formats the streamer does not know.
+         */
+        VkDeviceSize texture_level_size(VkFormat format, uint32_t width, uint32_t height);
+
+        /**
+         * Streams textures in and out of device memory a mip level at a time,
+         * following TextureResidency's decisions.
+         *
+         * A texture's device image only holds its resident levels: level 0 of the
+         * image is the texture's resident mip. Changing residency builds a new image
+         * with the new chain: the levels both images hold are copied from the current
+         * one on the graphics queue (record_copies()), only the new levels are read
+         * from the texture's source and uploaded through the staging ring. The new
+         * image is swapped in once both are done; the old one is retired through the
+         * deletion queue, and its memory counts against the budget until then.
+         *
+         * The budget is the configured one, lowered to what VK_EXT_memory_budget
+         * says the device local heap still has room for.
+         */
+        class TextureStreamer
+        {
+            public:
+                /**
+                 * Writes the texels of mip level mip_level (of the full chain) into destination.
+                 */
+                typedef std::function<void(uint32_t mip_level, uint8_t* destination, VkDeviceSize size)> MipSource;
+
+                struct Settings
+                {
+                    // 0 uses half of the largest device local heap.
+                    VkDeviceSize budget = 0;
+                    // Fraction of the heap budget reported by the driver the streamer may fill.
+                    double heap_budget_fraction = 0.8;
+                    // Levels at most this large are loaded on creation and never evicted.
+                    VkDeviceSize tail_bytes = 64 * 1024;
+
+                    uint32_t max_loads_per_update = 16;
+                    VkDeviceSize max_load_bytes_per_update = 32ull << 20;
+                };
+
+                struct Statistics
+                {
+                    uint64_t swaps = 0;
+                    // Mip levels copied from a replaced image instead of uploaded.
+                    uint64_t levels_copied = 0;
+                    // Bytes of device memory held by streamed images, pending ones included.
+                    VkDeviceSize device_bytes = 0;
+                    // Budget and usage of the device local heap from VK_EXT_memory_budget, 0 without it.
+                    VkDeviceSize heap_budget = 0;
+                    VkDeviceSize heap_usage = 0;
+                };
+
+            private:
+                struct Version
+                {
+                    VkImage image = VK_NULL_HANDLE;
+                    Memory::Allocation allocation;
+                    VkImageView view = VK_NULL_HANDLE;
+                    uint32_t base_mip = 0;
+                    // Charged to the residency as retiring until the image is destroyed.
+                    VkDeviceSize retiring_bytes = 0;
+                };
+
+                struct Texture
+                {
+                    uint32_t width = 0;
+                    uint32_t height = 0;
+                    VkFormat format = VK_FORMAT_UNDEFINED;
+                    uint32_t mip_count = 0;
+                    MipSource source;
+
+                    Version current;
+                    Version pending;
+                    UploadTicket pending_ticket = 0;
+                    // The levels kept from current have not been copied into pending yet.
+                    bool copy_pending = false;
+
+                    uint32_t bindless_index = BindlessTable::invalid_index;
+                    bool alive = false;
+                };
+
+                VkDevice device = VK_NULL_HANDLE;
+                const Utils::DeviceCapabilities* capabilities = nullptr;
+                Memory::MemoryAllocator* allocator = nullptr;
+                Uploader* uploader = nullptr;
+                DeletionQueue* deletion_queue = nullptr;
+                BindlessTable* bindless = nullptr;
+
+                VkSampler sampler = VK_NULL_HANDLE;
+                uint32_t heap_index = 0;
+
+                Settings settings;
+                TextureResidency residency;
+                std::vector<Texture> textures;
+                // Textures with an upload in flight.
+                std::vector<StreamedTexture> pending_textures;
+                // Textures whose kept levels the next record_copies() copies.
+                std::vector<StreamedTexture> copy_textures;
+                std::vector<VkImageMemoryBarrier> copy_barriers;
+                std::vector<VkImageCopy> copy_regions;
+                std::vector<TextureResidency::Change> changes;
+
+                Statistics statistics;
+
+            public:
+                /**
+                 * bindless may be null or uninitialized; textures then only expose their views.
+                 */
+                void init(
+                    VkDevice device,
+                    const Utils::DeviceCapabilities& capabilities,
+                    Memory::MemoryAllocator& allocator,
+                    Uploader& uploader,
+                    DeletionQueue& deletion_queue,
+                    BindlessTable* bindless,
+                    const Settings& settings);
+
+                /**
+                 * Destroys every texture immediately. The device must be idle.
+                 */
+                void cleanup();
+
+                /**
+                 * mip_count 0 is the full chain. The tail levels are uploaded right away;
+                 * the texture has a view once they have landed.
+                 */
+                StreamedTexture create_texture(uint32_t width, uint32_t height, VkFormat format, uint32_t mip_count, MipSource source);
+
+                /**
+                 * frame_number is the last frame that may use the texture.
+                 */
+                void destroy_texture(StreamedTexture texture, uint64_t frame_number);
+
+                /**
+                 * Ask for mip level mip or finer in frame.
+                 */
+                void request(StreamedTexture texture, uint32_t mip, uint64_t frame) { residency.request(texture, mip, frame); }
+
+                /**
+                 * Ask for the level matching a texture drawn screen_pixels wide (along its larger axis).
+                 */
+                void request_screen_space(StreamedTexture texture, float screen_pixels, uint64_t frame);
+
+                /**
+                 * Feedback read back from the GPU: the finest level sampled per texture,
+                 * indexed by StreamedTexture, UINT32_MAX for textures not sampled.
+                 */
+                void submit_feedback(const uint32_t* min_mips, size_t count, uint64_t frame);
+
+                /**
+                 * Swap in completed uploads, refresh the budget and start this frame's
+                 * loads and evictions. Call once per frame before recording; frame_number
+                 * is the frame about to be recorded.
+                 */
+                void update(uint64_t frame_number);
+
+                /**
+                 * Copies the levels kept by this frame's residency changes from the
+                 * current images into the pending ones. Call once per frame after
+                 * update(), outside of a render pass, in the frame's graphics command
+                 * buffer: later frames are ordered after the copies by the queue.
+                 */
+                void record_copies(VkCommandBuffer command_buffer);
+
+                bool is_ready(StreamedTexture texture) const { return textures[texture].current.view != VK_NULL_HANDLE; }
+
+                VkImageView get_view(StreamedTexture texture) const { return textures[texture].current.view; }
+
+                uint32_t get_bindless_index(StreamedTexture texture) const { return textures[texture].bindless_index; }
+
+                /**
+                 * Finest level the device image currently holds.
+                 */
+                uint32_t get_resident_mip(StreamedTexture texture) const { return textures[texture].current.base_mip; }
+
+                VkSampler get_sampler() const { return sampler; }
+
+                const TextureResidency& get_residency() const { return residency; }
+
+                const Statistics& get_statistics() const { return statistics; }
+
+                void print_statistics(std::ostream& out) const;
+
+            private:
+                void refresh_budget();
+
+                void build_version(StreamedTexture texture, uint32_t base_mip);
+
+                void swap_completed(uint64_t frame_number);
+
+                void retire(Version& version, const Texture& texture, uint64_t frame_number);
+
+                VkDeviceSize get_version_bytes(const Version& version, const Texture& texture) const;
+
+                /**
+                 * Charges version's levels to the residency as retiring, once.
+                 */
+                void charge_retiring(Version& version, const Texture& texture);
+
+                void destroy_version(Version& version);
+        };
+    };
+};
@@ -0,0 +1,506 @@
+#include "uploader.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace VulkanGameEngine
+{
+    namespace Graphics
+    {
+        /**
+         * Stages and accesses that may consume uploaded data on the graphics queue.
+         */
+        static const VkPipelineStageFlags consumer_stages =
+            VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+        static const VkAccessFlags consumer_access =
+            VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT |
+            VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+
+        void Uploader::init(
+            VkDevice device,
+            const Utils::DeviceCapabilities& capabilities,
+            Memory::MemoryAllocator& allocator,
+            VkQueue transfer_queue,
+            uint32_t transfer_family,
+            uint32_t graphics_family,
+            VkDeviceSize staging_size)
+        {
+            this->device = device;
+            this->allocator = &allocator;
+            this->transfer_queue = transfer_queue;
+            this->transfer_family = transfer_family;
+            this->graphics_family = graphics_family;
+
+            copy_alignment = std::max<VkDeviceSize>(16, capabilities.properties.limits.optimalBufferCopyOffsetAlignment);
+            staging_capacity = Utils::align_up(staging_size, copy_alignment);
+            batch_flush_threshold = staging_capacity / 4;
+
+            // Host visible memory is persistently mapped by the allocator.
+            staging_allocation = allocator.create_buffer(
+                staging_capacity, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                staging_buffer);
+
+            if (!staging_allocation.mapped)
+                throw std::runtime_error("\nFailed to map staging buffer.");
+            staging_data = static_cast<uint8_t*>(staging_allocation.mapped);
+            ring.init(staging_capacity, copy_alignment);
+        }
+
+        void Uploader::cleanup()
+        {
+            if (device == VK_NULL_HANDLE)
+                return;
+
+            if (recording)
+            {
+                vkEndCommandBuffer(recording->command_buffer);
+                destroy_batch(*recording);
+                recording.reset();
+            }
+
+            for (auto& batch : in_flight)
+            {
+                vkWaitForFences(device, 1, &batch->fence, VK_TRUE, UINT64_MAX);
+                destroy_batch(*batch);
+            }
+            in_flight.clear();
+
+            for (auto& batch : free_batches)
+                destroy_batch(*batch);
+            free_batches.clear();
+
+            allocator->destroy_buffer(staging_buffer, staging_allocation);
+
+            staging_data = nullptr;
+            device = VK_NULL_HANDLE;
+        }
+
+        void Uploader::destroy_batch(Batch& batch)
+        {
+            vkDestroySemaphore(device, batch.semaphore, nullptr);
+            vkDestroyFence(device, batch.fence, nullptr);
+            vkDestroyCommandPool(device, batch.command_pool, nullptr);
+        }
+
+        UploadTicket Uploader::upload_buffer(VkBuffer buffer, VkDeviceSize offset, const void* data, VkDeviceSize size)
+        {
+            const uint8_t* bytes = static_cast<const uint8_t*>(data);
+
+            return upload_buffer(buffer, offset, size, [bytes](uint8_t* destination, VkDeviceSize source_offset, VkDeviceSize chunk) {
+                memcpy(destination, bytes + source_offset, chunk);
+            });
+        }
+
+        UploadTicket Uploader::upload_buffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size, const FillFunction& fill)
+        {
+            // Large uploads are split so they never need the whole ring at once.
+            VkDeviceSize max_chunk = staging_capacity / 2;
+            UploadTicket ticket = 0;
+
+            for (VkDeviceSize done = 0; done < size;)
+            {
+                VkDeviceSize chunk = std::min(size - done, max_chunk);
+                VkDeviceSize staging_offset = allocate_staging(chunk);
+
+                fill(staging_data + staging_offset, done, chunk);
+
+                Batch& batch = begin_batch();
+
+                VkBufferCopy region{};
+                region.srcOffset = staging_offset;
+                region.dstOffset = offset + done;
+                region.size = chunk;
+                vkCmdCopyBuffer(batch.command_buffer, staging_buffer, buffer, 1, &region);
+
+                batch.buffers.push_back({buffer, offset + done, chunk});
+                batch.bytes += chunk;
+                batch.ring_end = ring.get_head();
+                ticket = batch.ticket;
+
+                statistics.copies++;
+                statistics.bytes_uploaded += chunk;
+                done += chunk;
+
+                if (batch.bytes >= batch_flush_threshold)
+                    flush();
+            }
+
+            return ticket;
+        }
+
+        UploadTicket Uploader::upload_image(
+            VkImage image,
+            VkExtent3D extent,
+            uint32_t mip_level,
+            uint32_t array_layer,
+            const void* data,
+            VkDeviceSize size,
+            VkImageLayout final_layout)
+        {
+            const uint8_t* bytes = static_cast<const uint8_t*>(data);
+
+            return upload_image(image, extent, mip_level, array_layer, size, [bytes](uint8_t* destination, VkDeviceSize source_offset, VkDeviceSize chunk) {
+                memcpy(destination, bytes + source_offset, chunk);
+            }, final_layout);
+        }
+
+        UploadTicket Uploader::upload_image(
+            VkImage image,
+            VkExtent3D extent,
+            uint32_t mip_level,
+            uint32_t array_layer,
+            VkDeviceSize size,
+            const FillFunction& fill,
+            VkImageLayout final_layout)
+        {
+            if (size > staging_capacity)
+                throw std::runtime_error("\nImage upload is larger than the staging ring.");
+
+            VkDeviceSize staging_offset = allocate_staging(size);
+            fill(staging_data + staging_offset, 0, size);
+
+            Batch& batch = begin_batch();
+
+            VkImageSubresourceRange range{VK_IMAGE_ASPECT_COLOR_BIT, mip_level, 1, array_layer, 1};
+
+            VkImageMemoryBarrier barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            barrier.srcAccessMask = 0;
+            barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.image = image;
+            barrier.subresourceRange = range;
+
+            vkCmdPipelineBarrier(
+                batch.command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                0, nullptr, 0, nullptr, 1, &barrier);
+
+            VkBufferImageCopy region{};
+            region.bufferOffset = staging_offset;
+            region.bufferRowLength = 0;
+            region.bufferImageHeight = 0;
+            region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, mip_level, array_layer, 1};
+            region.imageOffset = {0, 0, 0};
+            region.imageExtent = extent;
+
+            vkCmdCopyBufferToImage(batch.command_buffer, staging_buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+            batch.images.push_back({image, range, final_layout});
+            batch.bytes += size;
+            batch.ring_end = ring.get_head();
+
+            statistics.copies++;
+            statistics.bytes_uploaded += size;
+
+            UploadTicket ticket = batch.ticket;
+            if (batch.bytes >= batch_flush_threshold)
+                flush();
+
+            return ticket;
+        }
+
+        UploadTicket Uploader::flush()
+        {
+            if (!recording)
+                return next_ticket - 1;
+
+            Batch& batch = *recording;
+            bool transfer_ownership = needs_ownership_transfer();
+
+            std::vector<VkBufferMemoryBarrier> buffer_barriers;
+            for (const auto& copy : batch.buffers)
+            {
+                VkBufferMemoryBarrier barrier{};
+                barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+                barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+                barrier.dstAccessMask = transfer_ownership ? 0 : consumer_access;
+                barrier.srcQueueFamilyIndex = transfer_ownership ? transfer_family : VK_QUEUE_FAMILY_IGNORED;
+                barrier.dstQueueFamilyIndex = transfer_ownership ? graphics_family : VK_QUEUE_FAMILY_IGNORED;
+                barrier.buffer = copy.buffer;
+                barrier.offset = copy.offset;
+                barrier.size = copy.size;
+                buffer_barriers.push_back(barrier);
+            }
+
+            std::vector<VkImageMemoryBarrier> image_barriers;
+            for (const auto& copy : batch.images)
+            {
+                VkImageMemoryBarrier barrier{};
+                barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+                barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+                barrier.dstAccessMask = transfer_ownership ? 0 : consumer_access;
+                barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+                barrier.newLayout = copy.final_layout;
+                barrier.srcQueueFamilyIndex = transfer_ownership ? transfer_family : VK_QUEUE_FAMILY_IGNORED;
+                barrier.dstQueueFamilyIndex = transfer_ownership ? graphics_family : VK_QUEUE_FAMILY_IGNORED;
+                barrier.image = copy.image;
+                barrier.subresourceRange = copy.range;
+                image_barriers.push_back(barrier);
+            }
+
+            // Release barriers: with an ownership transfer the destination stage is irrelevant,
+            // the semaphore carries the dependency to the graphics queue.
+            vkCmdPipelineBarrier(
+                batch.command_buffer,
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                transfer_ownership ? static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT) : consumer_stages,
+                0,
+                0, nullptr,
+                static_cast<uint32_t>(buffer_barriers.size()), buffer_barriers.data(),
+                static_cast<uint32_t>(image_barriers.size()), image_barriers.data());
+
+            if (vkEndCommandBuffer(batch.command_buffer) != VK_SUCCESS)
+                throw std::runtime_error("\nFailed to record upload command buffer.");
+
+            VkSubmitInfo submit_info{};
+            submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+            submit_info.commandBufferCount = 1;
+            submit_info.pCommandBuffers = &batch.command_buffer;
+            if (transfer_ownership)
+            {
+                submit_info.signalSemaphoreCount = 1;
+                submit_info.pSignalSemaphores = &batch.semaphore;
+            }
+
+            if (vkQueueSubmit(transfer_queue, 1, &submit_info, batch.fence) != VK_SUCCESS)
+                throw std::runtime_error("\nFailed to submit upload batch.");
+
+            statistics.submissions++;
+
+            UploadTicket ticket = batch.ticket;
+            in_flight.push_back(std::move(recording));
+            return ticket;
+        }
+
+        bool Uploader::is_complete(UploadTicket ticket)
+        {
+            poll_completed();
+            return ticket <= completed_ticket;
+        }
+
+        void Uploader::wait(UploadTicket ticket)
+        {
+            if (recording && ticket >= recording->ticket)
+                flush();
+
+            poll_completed();
+            while (ticket > completed_ticket && !in_flight.empty())
+                wait_oldest();
+        }
+
+        void Uploader::record_acquire_barriers(
+            VkCommandBuffer command_buffer,
+            uint64_t frame_number,
+            std::vector<VkSemaphore>& wait_semaphores,
+            std::vector<VkPipelineStageFlags>& wait_stages)
+        {
+            if (!needs_ownership_transfer())
+                return;
+
+            std::vector<VkBufferMemoryBarrier> buffer_barriers;
+            std::vector<VkImageMemoryBarrier> image_barriers;
+
+            for (auto& batch : in_flight)
+            {
+                if (batch->acquired)
+                    continue;
+
+                // Acquire barriers must mirror the release barriers exactly.
+                for (const auto& copy : batch->buffers)
+                {
+                    VkBufferMemoryBarrier barrier{};
+                    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+                    barrier.srcAccessMask = 0;
+                    barrier.dstAccessMask = consumer_access;
+                    barrier.srcQueueFamilyIndex = transfer_family;
+                    barrier.dstQueueFamilyIndex = graphics_family;
+                    barrier.buffer = copy.buffer;
+                    barrier.offset = copy.offset;
+                    barrier.size = copy.size;
+                    buffer_barriers.push_back(barrier);
+                }
+
+                for (const auto& copy : batch->images)
+                {
+                    VkImageMemoryBarrier barrier{};
+                    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+                    barrier.srcAccessMask = 0;
+                    barrier.dstAccessMask = consumer_access;
+                    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+                    barrier.newLayout = copy.final_layout;
+                    barrier.srcQueueFamilyIndex = transfer_family;
+                    barrier.dstQueueFamilyIndex = graphics_family;
+                    barrier.image = copy.image;
+                    barrier.subresourceRange = copy.range;
+                    image_barriers.push_back(barrier);
+                }
+
+                wait_semaphores.push_back(batch->semaphore);
+                wait_stages.push_back(consumer_stages);
+
+                batch->acquired = true;
+                batch->acquire_frame = frame_number;
+            }
+
+            if (buffer_barriers.empty() && image_barriers.empty())
+                return;
+
+            vkCmdPipelineBarrier(
+                command_buffer, consumer_stages, consumer_stages, 0,
+                0, nullptr,
+                static_cast<uint32_t>(buffer_barriers.size()), buffer_barriers.data(),
+                static_cast<uint32_t>(image_barriers.size()), image_barriers.data());
+        }
+
+        void Uploader::retire_frames(uint64_t completed_frame)
+        {
+            poll_completed();
+            recycle_batches(completed_frame);
+        }
+
+        VkDeviceSize Uploader::allocate_staging(VkDeviceSize size)
+        {
+            if (size > staging_capacity)
+                throw std::runtime_error("\nUpload is larger than the staging ring.");
+
+            for (;;)
+            {
+                if (ring.fits(size))
+                    return ring.allocate(size);
+
+                // Out of space: submit what we have and wait for the oldest batch to retire.
+                statistics.ring_stalls++;
+
+                if (recording && recording->bytes > 0)
+                    flush();
+
+                poll_completed();
+                if (!ring.fits(size))
+                    wait_oldest();
+            }
+        }
+
+        Uploader::Batch& Uploader::begin_batch()
+        {
+            if (recording)
+                return *recording;
+
+            if (!free_batches.empty())
+            {
+                recording = std::move(free_batches.back());
+                free_batches.pop_back();
+
+                vkResetFences(device, 1, &recording->fence);
+                vkResetCommandPool(device, recording->command_pool, 0);
+            }
+            else
+            {
+                recording = std::make_unique<Batch>();
+
+                VkCommandPoolCreateInfo pool_info{};
+                pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+                pool_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+                pool_info.queueFamilyIndex = transfer_family;
+
+                if (vkCreateCommandPool(device, &pool_info, nullptr, &recording->command_pool) != VK_SUCCESS)
+                    throw std::runtime_error("\nFailed to create upload command pool.");
+
+                VkCommandBufferAllocateInfo allocate_info{};
+                allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+                allocate_info.commandPool = recording->command_pool;
+                allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+                allocate_info.commandBufferCount = 1;
+
+                if (vkAllocateCommandBuffers(device, &allocate_info, &recording->command_buffer) != VK_SUCCESS)
+                    throw std::runtime_error("\nFailed to allocate upload command buffer.");
+
+                VkFenceCreateInfo fence_info{};
+                fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+                VkSemaphoreCreateInfo semaphore_info{};
+                semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+                if (vkCreateFence(device, &fence_info, nullptr, &recording->fence) != VK_SUCCESS ||
+                    vkCreateSemaphore(device, &semaphore_info, nullptr, &recording->semaphore) != VK_SUCCESS)
+                    throw std::runtime_error("\nFailed to create upload synchronization objects.");
+            }
+
+            recording->ticket = next_ticket++;
+            recording->ring_end = ring.get_head();
+            recording->bytes = 0;
+            recording->complete = false;
+            recording->acquired = false;
+            recording->acquire_frame = 0;
+            recording->buffers.clear();
+            recording->images.clear();
+
+            VkCommandBufferBeginInfo begin_info{};
+            begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+            begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+            if (vkBeginCommandBuffer(recording->command_buffer, &begin_info) != VK_SUCCESS)
+                throw std::runtime_error("\nFailed to begin upload command buffer.");
+
+            return *recording;
+        }
+
+        void Uploader::poll_completed()
+        {
+            // Batches complete in submission order on the transfer queue.
+            for (auto& batch : in_flight)
+            {
+                if (batch->complete)
+                    continue;
+                if (vkGetFenceStatus(device, batch->fence) != VK_SUCCESS)
+                    break;
+
+                batch->complete = true;
+                completed_ticket = batch->ticket;
+                ring.release(batch->ring_end);
+            }
+
+            if (!recording && (in_flight.empty() || in_flight.back()->complete))
+                ring.release_all();
+        }
+
+        void Uploader::wait_oldest()
+        {
+            for (auto& batch : in_flight)
+            {
+                if (batch->complete)
+                    continue;
+
+                vkWaitForFences(device, 1, &batch->fence, VK_TRUE, UINT64_MAX);
+                poll_completed();
+                return;
+            }
+
+            throw std::runtime_error("\nStaging ring exhausted with no upload in flight.");
+        }
+
+        void Uploader::recycle_batches(uint64_t completed_frame)
+        {
+            bool transfer_ownership = needs_ownership_transfer();
+
+            while (!in_flight.empty())
+            {
+                Batch& batch = *in_flight.front();
+                if (!batch.complete)
+                    break;
+
+                // The semaphore can only be signalled again once the graphics frame that waited on it is done.
+                if (transfer_ownership && (!batch.acquired || batch.acquire_frame > completed_frame))
+                    break;
+
+                free_batches.push_back(std::move(in_flight.front()));
+                in_flight.pop_front();
+            }
+        }
+    };
+};
@@ -0,0 +1,284 @@
+#pragma once
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-09-25
+ *
+ */
+
+#include <iostream>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+
+#include "../utils/platform.hpp"
+#include "../utils/buffer.hpp"
+#include "../memory/allocator.hpp"
+
+namespace VulkanGameEngine
+{
+    namespace Graphics
+    {
+        /**
+         * Timeline value of an upload batch. Batches complete in submission order,
+         * so every ticket lower than a completed one is complete too.
+         * 0 means "nothing to wait for".
+         */
+        typedef uint64_t UploadTicket;
+
+        /**
+         * Space accounting of the staging ring. Positions are monotonic; the
+         * buffer offset of a position is position % capacity. An allocation
+         * never straddles the end of the buffer: it skips to the start instead.
+         * An empty ring always starts over at offset 0, so it can hand out its
+         * whole capacity.
+         */
+        class StagingRing
+        {
+            private:
+                uint64_t capacity = 0;
+                uint64_t alignment = 1;
+                uint64_t head = 0;
+                uint64_t tail = 0;
+
+                uint64_t place(uint64_t size) const
+                {
+                    uint64_t start = Utils::align_up(head, alignment);
+                    uint64_t offset = start % capacity;
+                    if (offset + size > capacity)
+                        start += capacity - offset;
+                    return start;
+                }
+
+            public:
+                void init(uint64_t capacity, uint64_t alignment)
+                {
+                    this->capacity = capacity;
+                    this->alignment = alignment;
+                    head = 0;
+                    tail = 0;
+                }
+
+                bool fits(uint64_t size) const { return size <= capacity && (head == tail || place(size) + size - tail <= capacity); }
+
+                /**
+                 * Buffer offset of size bytes; fits(size) must hold.
+                 */
+                uint64_t allocate(uint64_t size)
+                {
+                    if (head == tail)
+                    {
+                        head = (head + capacity - 1) / capacity * capacity;
+                        tail = head;
+                    }
+
+                    uint64_t start = place(size);
+                    head = start + size;
+                    return start % capacity;
+                }
+
+                /**
+                 * Everything allocated before position may be reused. Positions from
+                 * before the empty ring started over are already free.
+                 */
+                void release(uint64_t position) { tail = std::max(tail, position); }
+
+                void release_all() { tail = head; }
+
+                uint64_t get_head() const { return head; }
+
+                uint64_t get_used() const { return head - tail; }
+        };
+
+        /**
+         * Streams buffer and image data to the device through a persistently
+         * mapped staging ring buffer.
+         *
+         * Copies are batched into a single submission on the transfer queue.
+         * When the transfer queue belongs to another family than the graphics
+         * queue, ownership of the destination resources is released on the
+         * transfer queue and acquired on the graphics queue through
+         * record_acquire_barriers().
+         */
+        class Uploader
+        {
+            public:
+                struct Statistics
+                {
+                    uint64_t bytes_uploaded = 0;
+                    uint64_t copies = 0;
+                    uint64_t submissions = 0;
+                    uint64_t ring_stalls = 0;
+                };
+
+            private:
+                struct BufferCopy
+                {
+                    VkBuffer buffer;
+                    VkDeviceSize offset;
+                    VkDeviceSize size;
+                };
+
+                struct ImageCopy
+                {
+                    VkImage image;
+                    VkImageSubresourceRange range;
+                    VkImageLayout final_layout;
+                };
+
+                struct Batch
+                {
+                    VkCommandPool command_pool = VK_NULL_HANDLE;
+                    VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+                    VkFence fence = VK_NULL_HANDLE;
+                    VkSemaphore semaphore = VK_NULL_HANDLE;
+
+                    UploadTicket ticket = 0;
+                    uint64_t ring_end = 0;
+                    VkDeviceSize bytes = 0;
+                    bool complete = false;
+
+                    std::vector<BufferCopy> buffers;
+                    std::vector<ImageCopy> images;
+
+                    bool acquired = false;
+                    uint64_t acquire_frame = 0;
+                };
+
+                VkDevice device = VK_NULL_HANDLE;
+                Memory::MemoryAllocator* allocator = nullptr;
+                VkQueue transfer_queue = VK_NULL_HANDLE;
+                uint32_t transfer_family = 0;
+                uint32_t graphics_family = 0;
+
+                VkBuffer staging_buffer = VK_NULL_HANDLE;
+                Memory::Allocation staging_allocation;
+                uint8_t* staging_data = nullptr;
+                VkDeviceSize staging_capacity = 0;
+                VkDeviceSize copy_alignment = 16;
+
+                StagingRing ring;
+
+                // Submitted batches in submission order. A batch is recycled once its
+                // fence signalled and, with an ownership transfer, the graphics frame
+                // that waited on its semaphore has completed.
+                std::unique_ptr<Batch> recording;
+                std::deque<std::unique_ptr<Batch>> in_flight;
+                std::vector<std::unique_ptr<Batch>> free_batches;
+
+                UploadTicket next_ticket = 1;
+                UploadTicket completed_ticket = 0;
+
+                // Submit automatically once this many bytes are pending.
+                VkDeviceSize batch_flush_threshold = 0;
+
+                Statistics statistics;
+
+            public:
+                void init(
+                    VkDevice device,
+                    const Utils::DeviceCapabilities& capabilities,
+                    Memory::MemoryAllocator& allocator,
+                    VkQueue transfer_queue,
+                    uint32_t transfer_family,
+                    uint32_t graphics_family,
+                    VkDeviceSize staging_size = 64ull << 20);
+
+                void cleanup();
+
+                /**
+                 * Copy data into a buffer. The data is copied into the staging ring
+                 * immediately, so the caller may free it on return.
+                 */
+                UploadTicket upload_buffer(VkBuffer buffer, VkDeviceSize offset, const void* data, VkDeviceSize size);
+
+                /**
+                 * Writes bytes [source_offset, source_offset + size) of the upload
+                 * straight into mapped staging memory.
+                 */
+                typedef std::function<void(uint8_t* destination, VkDeviceSize source_offset, VkDeviceSize size)> FillFunction;
+
+                /**
+                 * Same as above, but the caller produces the bytes in place, e.g. by
+                 * decompressing into the ring. fill may be called several times
+                 * for large uploads.
+                 */
+                UploadTicket upload_buffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size, const FillFunction& fill);
+
+                /**
+                 * Copy tightly packed texels into one mip level / layer of an image.
+                 * The image is left in final_layout.
+                 */
+                UploadTicket upload_image(
+                    VkImage image,
+                    VkExtent3D extent,
+                    uint32_t mip_level,
+                    uint32_t array_layer,
+                    const void* data,
+                    VkDeviceSize size,
+                    VkImageLayout final_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+                /**
+                 * Same as above, with the texels written in place by fill, in one call.
+                 */
+                UploadTicket upload_image(
+                    VkImage image,
+                    VkExtent3D extent,
+                    uint32_t mip_level,
+                    uint32_t array_layer,
+                    VkDeviceSize size,
+                    const FillFunction& fill,
+                    VkImageLayout final_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+                /**
+                 * Submit everything queued so far. Returns the ticket of the submission.
+                 */
+                UploadTicket flush();
+
+                bool is_complete(UploadTicket ticket);
+
+                void wait(UploadTicket ticket);
+
+                /**
+                 * Ticket that is currently being recorded, i.e. the one returned by the next flush().
+                 */
+                UploadTicket pending_ticket() const { return recording ? recording->ticket : 0; }
+
+                /**
+                 * Record the queue family acquire barriers of every submitted batch not acquired yet,
+                 * and return the semaphores the graphics submission must wait on.
+                 * frame_number is the frame the graphics command buffer belongs to.
+                 */
+                void record_acquire_barriers(
+                    VkCommandBuffer command_buffer,
+                    uint64_t frame_number,
+                    std::vector<VkSemaphore>& wait_semaphores,
+                    std::vector<VkPipelineStageFlags>& wait_stages);
+
+                /**
+                 * Recycle batches whose acquiring graphics frame has completed.
+                 */
+                void retire_frames(uint64_t completed_frame);
+
+                bool needs_ownership_transfer() const { return transfer_family != graphics_family; }
+
+                const Statistics& get_statistics() const { return statistics; }
+
+            private:
+                VkDeviceSize allocate_staging(VkDeviceSize size);
+
+                Batch& begin_batch();
+
+                void poll_completed();
+
+                void wait_oldest();
+
+                void recycle_batches(uint64_t completed_frame);
+
+                void destroy_batch(Batch& batch);
+        };
+    };
+};
@@ -0,0 +1,358 @@
+#include "visibility.hpp"
+#include "../jobs/job_system.hpp"
+#include "../utils/cpu_features.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define VGE_CULL_SSE 1
+#endif
+
+namespace VulkanGameEngine
+{
+    namespace Graphics
+    {
+        // Objects per job of a parallel cull; a multiple of every kernel width.
+        static const uint32_t cull_chunk_size = 16 * 1024;
+
+        const uint32_t VisibilitySystem::invalid_slot;
+        const uint32_t VisibilitySystem::padding;
+
+        Frustum extract_frustum(const float* m)
+        {
+            // Row r of the column-major matrix is m[r], m[4 + r], m[8 + r], m[12 + r].
+            auto row = [m](int r, int column) { return m[column * 4 + r]; };
+
+            Frustum frustum;
+            for (int column = 0; column < 4; column++)
+            {
+                frustum.planes[0][column] = row(3, column) + row(0, column);   // left
+                frustum.planes[1][column] = row(3, column) - row(0, column);   // right
+                frustum.planes[2][column] = row(3, column) + row(1, column);   // bottom
+                frustum.planes[3][column] = row(3, column) - row(1, column);   // top
+                frustum.planes[4][column] = row(2, column);                    // near, z >= 0
+                frustum.planes[5][column] = row(3, column) - row(2, column);   // far
+            }
+
+            for (auto& plane : frustum.planes)
+            {
+                float length = std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+                if (length > 0.0f)
+                    for (int i = 0; i < 4; i++)
+                        plane[i] /= length;
+            }
+            return frustum;
+        }
+
+        const char* cull_kernel_name(CullKernel kernel)
+        {
+            switch (kernel)
+            {
+                case CullKernel::Auto: return "auto";
+                case CullKernel::Scalar: return "scalar";
+                case CullKernel::SSE: return "sse";
+                case CullKernel::AVX2: return "avx2";
+            }
+            return "unknown";
+        }
+
+        uint32_t cull_spheres_scalar(const float* x, const float* y, const float* z, const float* r, uint32_t first, uint32_t last, const Frustum& frustum, uint32_t* visible)
+        {
+            uint32_t written = 0;
+            for (uint32_t i = first; i < last; i++)
+            {
+                float negative_radius = -r[i];
+                bool inside = true;
+                // Summed in the same order as the SIMD kernels, so they agree on
+                // spheres exactly touching a plane.
+                for (const auto& plane : frustum.planes)
+                    inside &= (plane[0] * x[i] + plane[1] * y[i]) + (plane[2] * z[i] + plane[3]) >= negative_radius;
+
+                // Branchless compaction: always store, only advance when visible.
+                visible[written] = i;
+                written += inside;
+            }
+            return written;
+        }
+
+        uint32_t cull_spheres_sse(const float* x, const float* y, const float* z, const float* r, uint32_t first, uint32_t last, const Frustum& frustum, uint32_t* visible)
+        {
+            #ifdef VGE_CULL_SSE
+                __m128 planes[6][4];
+                for (int p = 0; p < 6; p++)
+                    for (int c = 0; c < 4; c++)
+                        planes[p][c] = _mm_set1_ps(frustum.planes[p][c]);
+
+                uint32_t written = 0;
+                for (uint32_t i = first; i < last; i += 4)
+                {
+                    __m128 px = _mm_loadu_ps(x + i);
+                    __m128 py = _mm_loadu_ps(y + i);
+                    __m128 pz = _mm_loadu_ps(z + i);
+                    __m128 negative_radius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(r + i));
+
+                    __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+                    for (int p = 0; p < 6; p++)
+                    {
+                        __m128 distance = _mm_add_ps(
+                            _mm_add_ps(_mm_mul_ps(planes[p][0], px), _mm_mul_ps(planes[p][1], py)),
+                            _mm_add_ps(_mm_mul_ps(planes[p][2], pz), planes[p][3]));
+                        inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negative_radius));
+                    }
+
+                    uint32_t mask = static_cast<uint32_t>(_mm_movemask_ps(inside));
+                    visible[written] = i;
+                    written += mask & 1;
+                    visible[written] = i + 1;
+                    written += (mask >> 1) & 1;
+                    visible[written] = i + 2;
+                    written += (mask >> 2) & 1;
+                    visible[written] = i + 3;
+                    written += (mask >> 3) & 1;
+                }
+                return written;
+            #else
+                return cull_spheres_scalar(x, y, z, r, first, last, frustum, visible);
+            #endif
+        }
+
+        VisibilitySystem::VisibilitySystem()
+        {
+            resize_arrays(0);
+            set_kernel(CullKernel::Auto);
+        }
+
+        bool VisibilitySystem::is_kernel_supported(CullKernel kernel)
+        {
+            const Utils::CpuFeatures& features = Utils::get_cpu_features();
+            switch (kernel)
+            {
+                case CullKernel::Auto:
+                case CullKernel::Scalar:
+                    return true;
+                case CullKernel::SSE:
+                    #ifdef VGE_CULL_SSE
+                        return features.sse2;
+                    #else
+                        return false;
+                    #endif
+                case CullKernel::AVX2:
+                    return cull_spheres_avx2_compiled() && features.avx2;
+            }
+            return false;
+        }
+
+        CullKernel VisibilitySystem::set_kernel(CullKernel requested)
+        {
+            if (requested == CullKernel::Auto)
+                requested = CullKernel::AVX2;
+
+            // Narrower kernels are always available when a wider one is not.
+            if (requested == CullKernel::AVX2 && !is_kernel_supported(CullKernel::AVX2))
+                requested = CullKernel::SSE;
+            if (requested == CullKernel::SSE && !is_kernel_supported(CullKernel::SSE))
+                requested = CullKernel::Scalar;
+
+            kernel = requested;
+            return kernel;
+        }
+
+        void VisibilitySystem::resize_arrays(uint32_t slots)
+        {
+            // Padding spheres have a radius of -infinity, which no distance beats.
+            uint32_t padded = (slots + padding - 1) / padding * padding + padding;
+            center_x.resize(padded, 0.0f);
+            center_y.resize(padded, 0.0f);
+            center_z.resize(padded, 0.0f);
+            radius.resize(padded, -INFINITY);
+            draws.resize(slots);
+            slot_objects.resize(slots);
+        }
+
+        VisibilityObject VisibilitySystem::add(const float* center, float sphere_radius, const VkDrawIndexedIndirectCommand& draw)
+        {
+            if (!(sphere_radius >= 0.0f))
+                throw std::runtime_error("\nA bounding sphere needs a non-negative radius.");
+
+            VisibilityObject object;
+            if (!free_objects.empty())
+            {
+                object = free_objects.back();
+                free_objects.pop_back();
+            }
+            else
+            {
+                object = static_cast<VisibilityObject>(object_slots.size());
+                object_slots.push_back(invalid_slot);
+            }
+
+            uint32_t slot = count++;
+            resize_arrays(count);
+            object_slots[object] = slot;
+            slot_objects[slot] = object;
+            center_x[slot] = center[0];
+            center_y[slot] = center[1];
+            center_z[slot] = center[2];
+            radius[slot] = sphere_radius;
+            draws[slot] = draw;
+            return object;
+        }
+
+        void VisibilitySystem::remove(VisibilityObject object)
+        {
+            if (object >= object_slots.size() || object_slots[object] == invalid_slot)
+                throw std::runtime_error("\nRemoving an unknown visibility object.");
+
+            uint32_t slot = object_slots[object];
+            uint32_t last = --count;
+            if (slot != last)
+            {
+                center_x[slot] = center_x[last];
+                center_y[slot] = center_y[last];
+                center_z[slot] = center_z[last];
+                radius[slot] = radius[last];
+                draws[slot] = draws[last];
+                slot_objects[slot] = slot_objects[last];
+                object_slots[slot_objects[slot]] = slot;
+            }
+
+            center_x[last] = center_y[last] = center_z[last] = 0.0f;
+            radius[last] = -INFINITY;
+            resize_arrays(count);
+
+            object_slots[object] = invalid_slot;
+            free_objects.push_back(object);
+        }
+
+        void VisibilitySystem::set_bounds(VisibilityObject object, const float* center, float sphere_radius)
+        {
+            if (!(sphere_radius >= 0.0f))
+                throw std::runtime_error("\nA bounding sphere needs a non-negative radius.");
+
+            uint32_t slot = object_slots[object];
+            center_x[slot] = center[0];
+            center_y[slot] = center[1];
+            center_z[slot] = center[2];
+            radius[slot] = sphere_radius;
+        }
+
+        void VisibilitySystem::set_draw(VisibilityObject object, const VkDrawIndexedIndirectCommand& draw)
+        {
+            draws[object_slots[object]] = draw;
+        }
+
+        void VisibilitySystem::clear()
+        {
+            count = 0;
+            center_x.clear();
+            center_y.clear();
+            center_z.clear();
+            radius.clear();
+            object_slots.clear();
+            free_objects.clear();
+            resize_arrays(0);
+        }
+
+        uint32_t VisibilitySystem::cull_range(const Frustum& frustum, uint32_t first, uint32_t last, uint32_t* visible) const
+        {
+            const float* x = center_x.data();
+            const float* y = center_y.data();
+            const float* z = center_z.data();
+            const float* r = radius.data();
+
+            switch (kernel)
+            {
+                case CullKernel::AVX2:
+                    return cull_spheres_avx2(x, y, z, r, first, last, frustum, visible);
+                case CullKernel::SSE:
+                    return cull_spheres_sse(x, y, z, r, first, last, frustum, visible);
+                default:
+                    return cull_spheres_scalar(x, y, z, r, first, last, frustum, visible);
+            }
+        }
+
+        void VisibilitySystem::cull(const Frustum& frustum, std::vector<uint32_t>& visible, Jobs::JobSystem* jobs)
+        {
+            uint32_t padded_count = (count + padding - 1) / padding * padding;
+
+            if (!jobs || padded_count <= cull_chunk_size)
+            {
+                visible.resize(padded_count + padding);
+                uint32_t written = cull_range(frustum, 0, padded_count, visible.data());
+                visible.resize(written);
+            }
+            else
+            {
+                // Each chunk writes into its own stretch of scratch, then the
+                // stretches are packed in order.
+                uint32_t chunk_count = (padded_count + cull_chunk_size - 1) / cull_chunk_size;
+                chunk_scratch.resize(static_cast<size_t>(chunk_count) * (cull_chunk_size + padding));
+                chunk_counts.resize(chunk_count);
+
+                jobs->parallel_for(chunk_count, 1, [&](uint32_t first_chunk, uint32_t last_chunk) {
+                    for (uint32_t chunk = first_chunk; chunk < last_chunk; chunk++)
+                    {
+                        uint32_t first = chunk * cull_chunk_size;
+                        uint32_t last = std::min(first + cull_chunk_size, padded_count);
+                        uint32_t* output = chunk_scratch.data() + static_cast<size_t>(chunk) * (cull_chunk_size + padding);
+                        chunk_counts[chunk] = cull_range(frustum, first, last, output);
+                    }
+                });
+
+                size_t total = 0;
+                for (uint32_t written : chunk_counts)
+                    total += written;
+
+                visible.resize(total);
+                size_t offset = 0;
+                for (uint32_t chunk = 0; chunk < chunk_count; chunk++)
+                {
+                    const uint32_t* output = chunk_scratch.data() + static_cast<size_t>(chunk) * (cull_chunk_size + padding);
+                    if (chunk_counts[chunk])
+                        std::memcpy(visible.data() + offset, output, chunk_counts[chunk] * sizeof(uint32_t));
+                    offset += chunk_counts[chunk];
+                }
+            }
+
+            statistics.culls++;
+            statistics.objects_tested += count;
+            statistics.objects_visible += visible.size();
+        }
+
+        void VisibilitySystem::write_draws(const std::vector<uint32_t>& visible, VkDrawIndexedIndirectCommand* commands) const
+        {
+            const VkDrawIndexedIndirectCommand* source = draws.data();
+            for (size_t i = 0; i < visible.size(); i++)
+                commands[i] = source[visible[i]];
+        }
+
+        uint32_t VisibilitySystem::build_draws(
+            const Frustum& frustum,
+            VkDrawIndexedIndirectCommand* commands,
+            uint32_t max_commands,
+            std::vector<uint32_t>& visible,
+            Jobs::JobSystem* jobs)
+        {
+            cull(frustum, visible, jobs);
+            if (visible.size() > max_commands)
+                visible.resize(max_commands);
+            write_draws(visible, commands);
+            return static_cast<uint32_t>(visible.size());
+        }
+
+        void VisibilitySystem::print_statistics(std::ostream& out) const
+        {
+            char line[256];
+            snprintf(line, sizeof(line), "\nVisibility (%s kernel): %u objects, %llu culls, %.1f%% visible on average\n",
+                cull_kernel_name(kernel),
+                count,
+                static_cast<unsigned long long>(statistics.culls),
+                statistics.objects_tested ? 100.0 * statistics.objects_visible / statistics.objects_tested : 0.0);
+            out << line;
+        }
+    };
+};
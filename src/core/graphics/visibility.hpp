@@ -0,0 +1,174 @@
+#pragma once
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-10
+ *
+ */
+
+#include <iostream>
+#include <vector>
+#include <cstdint>
+#include <stdexcept>
+
+#include "../utils/platform.hpp"
+
+namespace VulkanGameEngine
+{
+    namespace Jobs
+    {
+        class JobSystem;
+    };
+
+    namespace Graphics
+    {
+        /**
+         * Planes point inwards: a point p is inside when
+         * dot(plane.xyz, p) + plane.w >= 0 for all six. Normals are unit length,
+         * so the same expression is a signed distance.
+         */
+        struct Frustum
+        {
+            float planes[6][4];
+        };
+
+        /**
+         * Gribb-Hartmann extraction from a column-major view-projection matrix
+         * with Vulkan clip space (0 <= z <= w).
+         */
+        Frustum extract_frustum(const float* view_projection);
+
+        enum class CullKernel
+        {
+            Auto = 0,
+            Scalar = 1,
+            SSE = 2,
+            AVX2 = 3
+        };
+
+        const char* cull_kernel_name(CullKernel kernel);
+
+        typedef uint32_t VisibilityObject;
+
+        /**
+         * Bounding spheres of every drawable object, stored as separate x, y, z
+         * and radius arrays so the cull kernels test 4 (SSE) or 8 (AVX2) objects
+         * per instruction, plus the draw each visible object emits.
+         *
+         * Objects are kept dense: removing one moves the last object into its
+         * slot, so handles go through an indirection table and culling reports
+         * slots. The arrays are padded to 8 with spheres that are never visible.
+         */
+        class VisibilitySystem
+        {
+            public:
+                struct Statistics
+                {
+                    uint64_t culls = 0;
+                    uint64_t objects_tested = 0;
+                    uint64_t objects_visible = 0;
+                };
+
+            private:
+                std::vector<float> center_x;
+                std::vector<float> center_y;
+                std::vector<float> center_z;
+                std::vector<float> radius;
+                std::vector<VkDrawIndexedIndirectCommand> draws;
+                std::vector<VisibilityObject> slot_objects;
+
+                std::vector<uint32_t> object_slots;
+                std::vector<VisibilityObject> free_objects;
+                uint32_t count = 0;
+
+                CullKernel kernel = CullKernel::Scalar;
+
+                // Per chunk results of a parallel cull.
+                std::vector<uint32_t> chunk_scratch;
+                std::vector<uint32_t> chunk_counts;
+
+                Statistics statistics;
+
+                static const uint32_t invalid_slot = ~0u;
+                static const uint32_t padding = 8;
+
+            public:
+                VisibilitySystem();
+
+                /**
+                 * draw is emitted as is for every frame the object is visible; its
+                 * firstInstance is the natural place for the object's data index.
+                 */
+                VisibilityObject add(const float* center, float radius, const VkDrawIndexedIndirectCommand& draw);
+
+                void remove(VisibilityObject object);
+
+                void set_bounds(VisibilityObject object, const float* center, float radius);
+
+                void set_draw(VisibilityObject object, const VkDrawIndexedIndirectCommand& draw);
+
+                void clear();
+
+                uint32_t size() const { return count; }
+
+                /**
+                 * Auto picks the widest kernel the CPU supports. Returns the kernel
+                 * actually used, which falls back when the requested one is not available.
+                 */
+                CullKernel set_kernel(CullKernel kernel);
+
+                CullKernel get_kernel() const { return kernel; }
+
+                static bool is_kernel_supported(CullKernel kernel);
+
+                /**
+                 * Slots of the objects intersecting the frustum, in slot order.
+                 * With a job system, chunks of objects are culled in parallel.
+                 */
+                void cull(const Frustum& frustum, std::vector<uint32_t>& visible, Jobs::JobSystem* jobs = nullptr);
+
+                /**
+                 * Copies the draws of the given slots into commands, which holds at
+                 * least visible.size() entries (a mapped indirect buffer).
+                 */
+                void write_draws(const std::vector<uint32_t>& visible, VkDrawIndexedIndirectCommand* commands) const;
+
+                /**
+                 * cull() then write_draws(), at most max_commands. Returns the draw count.
+                 */
+                uint32_t build_draws(
+                    const Frustum& frustum,
+                    VkDrawIndexedIndirectCommand* commands,
+                    uint32_t max_commands,
+                    std::vector<uint32_t>& visible,
+                    Jobs::JobSystem* jobs = nullptr);
+
+                VisibilityObject get_object(uint32_t slot) const { return slot_objects[slot]; }
+
+                const Statistics& get_statistics() const { return statistics; }
+
+                void print_statistics(std::ostream& out) const;
+
+            private:
+                uint32_t cull_range(const Frustum& frustum, uint32_t first, uint32_t last, uint32_t* visible) const;
+
+                void resize_arrays(uint32_t slots);
+        };
+
+        /**
+         * Visibility kernels over slots [first, last), first a multiple of 8 and
+         * last padded to 8. visible needs room for last - first + 8 entries;
+         * the SIMD kernels store whole vectors past the returned count.
+         */
+        uint32_t cull_spheres_scalar(const float* x, const float* y, const float* z, const float* r, uint32_t first, uint32_t last, const Frustum& frustum, uint32_t* visible);
+
+        uint32_t cull_spheres_sse(const float* x, const float* y, const float* z, const float* r, uint32_t first, uint32_t last, const Frustum& frustum, uint32_t* visible);
+
+        uint32_t cull_spheres_avx2(const float* x, const float* y, const float* z, const float* r, uint32_t first, uint32_t last, const Frustum& frustum, uint32_t* visible);
+
+        /**
+         * Whether the AVX2 kernel was compiled with AVX2 enabled; it falls back
+         * to the SSE kernel otherwise.
+         */
+        bool cull_spheres_avx2_compiled();
+    };
+};
@@ -0,0 +1,103 @@
+/**
+ * The AVX2 cull kernel lives in its own translation unit, the only one built
+ * with AVX2 enabled (see CMakeLists.txt), so nothing else picks up AVX2
+ * instructions. It only runs after the CPU has been checked for AVX2.
+ */
+
+#include "visibility.hpp"
+
+#include <cstring>
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+    #define VGE_CULL_AVX2 1
+#endif
+
+namespace VulkanGameEngine
+{
+    namespace Graphics
+    {
+        bool cull_spheres_avx2_compiled()
+        {
+            #ifdef VGE_CULL_AVX2
+                return true;
+            #else
+                return false;
+            #endif
+        }
+
+        #ifdef VGE_CULL_AVX2
+            /**
+             * For every 8 bit visibility mask, the lanes of its set bits packed one
+             * nibble each, lowest first. Built at compile time: a dynamic initializer
+             * in this translation unit would be compiled to AVX2 and run at load,
+             * before the CPU check.
+             */
+            struct CompactionTable
+            {
+                uint32_t lanes[256] = {};
+
+                constexpr CompactionTable()
+                {
+                    for (uint32_t mask = 0; mask < 256; mask++)
+                    {
+                        uint32_t packed = 0;
+                        uint32_t written = 0;
+                        for (uint32_t lane = 0; lane < 8; lane++)
+                            if (mask & (1u << lane))
+                                packed |= lane << (4 * written++);
+                        lanes[mask] = packed;
+                    }
+                }
+            };
+
+            static constexpr CompactionTable compaction_table;
+        #endif
+
+        uint32_t cull_spheres_avx2(const float* x, const float* y, const float* z, const float* r, uint32_t first, uint32_t last, const Frustum& frustum, uint32_t* visible)
+        {
+            #ifdef VGE_CULL_AVX2
+                __m256 planes[6][4];
+                for (int p = 0; p < 6; p++)
+                    for (int c = 0; c < 4; c++)
+                        planes[p][c] = _mm256_set1_ps(frustum.planes[p][c]);
+
+                const __m256i nibble_shifts = _mm256_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28);
+                const __m256i nibble_mask = _mm256_set1_epi32(0xf);
+
+                uint32_t written = 0;
+                for (uint32_t i = first; i < last; i += 8)
+                {
+                    __m256 px = _mm256_loadu_ps(x + i);
+                    __m256 py = _mm256_loadu_ps(y + i);
+                    __m256 pz = _mm256_loadu_ps(z + i);
+                    __m256 negative_radius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(r + i));
+
+                    // Plain multiplies and adds, no FMA, so every kernel agrees on
+                    // spheres exactly touching a plane.
+                    __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+                    for (int p = 0; p < 6; p++)
+                    {
+                        __m256 distance = _mm256_add_ps(
+                            _mm256_add_ps(_mm256_mul_ps(planes[p][0], px), _mm256_mul_ps(planes[p][1], py)),
+                            _mm256_add_ps(_mm256_mul_ps(planes[p][2], pz), planes[p][3]));
+                        inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, negative_radius, _CMP_GE_OQ));
+                    }
+
+                    // Expand the packed lanes of the mask and store all 8; only the
+                    // visible ones are kept by advancing the count.
+                    uint32_t mask = static_cast<uint32_t>(_mm256_movemask_ps(inside));
+                    __m256i lanes = _mm256_and_si256(
+                        _mm256_srlv_epi32(_mm256_set1_epi32(static_cast<int>(compaction_table.lanes[mask])), nibble_shifts),
+                        nibble_mask);
+                    __m256i slots = _mm256_add_epi32(lanes, _mm256_set1_epi32(static_cast<int>(i)));
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(visible + written), slots);
+                    written += static_cast<uint32_t>(_mm_popcnt_u32(mask));
+                }
+                return written;
+            #else
+                return cull_spheres_sse(x, y, z, r, first, last, frustum, visible);
+            #endif
+        }
+    };
+};
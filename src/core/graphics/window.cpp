@@ -1,392 +1,1802 @@
-#include "window.hpp"
-/**
- * @author Simon Brisebois-Therrien 
- * @since 2021-09-20 
- * 
- * 
- */
-
-namespace VulkanGameEngine
-{
-    namespace Graphics
-    {
-        Window::Window(std::string window_title, uint32_t width, uint32_t height)
-        {
-            this->window_title = window_title;
-            this->w_Width = width;
-            this->w_Height = height;
-
-            this->init_Window();
-            this->init_vulkan();
-            this->main_loop();
-            this->cleanup();
-            
-        }
-
-        void Window::init_Window()
-        {
-            if(!glfwInit())
-                throw std::runtime_error("\nFailed to init glfw.");
-            
-            glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-            window = glfwCreateWindow(w_Width, w_Height, window_title.c_str(), nullptr, nullptr);
-
-            uint32_t extensionCount = 0;
-            vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, nullptr);
-
-            printf("Supported extensions: %i", extensionCount);
-        }
-
-        void Window::init_vulkan()
-        {
-            this->create_instance();
-            this->setup_debug_messenger();
-            this->create_surface();
-            this->pick_physical_device();
-            this->create_logical_device();
-            this->create_swap_chain();
-            this->create_image_views();
-        }
-
-        void Window::main_loop()
-        {
-            while (!glfwWindowShouldClose(window))
-            {
-                glfwPollEvents();
-            }
-        }
-
-        void Window::cleanup()
-        {
-            for (auto imageView : swapchain_image_views)
-                vkDestroyImageView(device, imageView, nullptr);
-
-            vkDestroySwapchainKHR(device, swapchain, nullptr);
-
-            vkDestroyDevice(device, nullptr);
-
-            if (enable_validation_layers)
-                destroy_debug_messenger(instance, debug_messenger, nullptr);
-
-            vkDestroySurfaceKHR(instance, surface, nullptr);
-            vkDestroyInstance(instance, nullptr);
-
-            glfwDestroyWindow(window);
-
-            glfwTerminate();
-        }
-
-        void Window::create_instance()
-        {
-            if (enable_validation_layers && !check_validation_layer_support())
-                throw std::runtime_error("\nValidation layers requested, but not available!");
-
-            VkApplicationInfo app_info{};
-            app_info.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
-            app_info.pApplicationName = "Default Application name.";
-            app_info.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
-            app_info.pEngineName = "VulkanGameEngine";
-            app_info.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-            app_info.apiVersion = VK_API_VERSION_1_0;
-
-            VkInstanceCreateInfo create_info{};
-            create_info.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
-            create_info.pApplicationInfo = &app_info;
-
-
-            uint32_t glfwExtensionCount = 0;
-            
-            auto extensions = get_required_extensions();
-            create_info.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
-            create_info.ppEnabledExtensionNames = extensions.data();
-
-            VkDebugUtilsMessengerCreateInfoEXT debug_create_info{};
-            if (enable_validation_layers)
-            {
-                create_info.enabledLayerCount = static_cast<uint32_t>(validation_layers.size());
-                create_info.ppEnabledLayerNames = validation_layers.data();
-
-                populate_debug_messenger_create_info(debug_create_info);
-                create_info.pNext = (VkDebugUtilsMessengerCreateInfoEXT*) &debug_create_info;
-            }
-            else
-            {
-                create_info.enabledLayerCount = 0;
-                create_info.pNext = nullptr;
-            }
-
-            if (vkCreateInstance(&create_info, nullptr, &instance) != VK_SUCCESS)
-                throw std::runtime_error("\nFailed to create instance.");
-        }
-
-        void Window::create_surface()
-        {
-            if (glfwCreateWindowSurface(instance, window, nullptr, &surface) != VK_SUCCESS)
-                throw std::runtime_error("\nFailed to create window surface.");
-            
-        }
-
-        void Window::create_swap_chain()
-        {
-            Utils::SwapChainSupportDetails swap_chain_support = Utils::query_swap_chain_support(physical_device, surface);
-
-            VkSurfaceFormatKHR surface_format = Utils::choose_swap_surface_format(swap_chain_support.formats);
-            VkPresentModeKHR present_mode = Utils::choose_swap_present_mode(swap_chain_support.present_modes);
-            VkExtent2D extent = Utils::choose_swap_extent(swap_chain_support.capabilities, window);
-
-            int extra_image = 1;
-            uint32_t image_count = swap_chain_support.capabilities.minImageCount + extra_image;
-
-            if (swap_chain_support.capabilities.maxImageCount > 0 && image_count > swap_chain_support.capabilities.maxImageCount)
-                image_count = swap_chain_support.capabilities.maxImageCount;
-
-            VkSwapchainCreateInfoKHR create_info{};
-            create_info.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
-            create_info.surface = surface;
-
-            create_info.minImageCount = image_count;
-            create_info.imageFormat = surface_format.format;
-            create_info.imageColorSpace = surface_format.colorSpace;
-            create_info.imageExtent = extent;
-            create_info.imageArrayLayers = 1;
-            create_info.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
-
-            Utils::QueueFamilyIndices indices = Utils::find_queue_families(physical_device, surface);
-            uint32_t queue_family_indices[] = {indices.graphics_family.value(), indices.present_family.value()};
-
-            if (indices.graphics_family != indices.present_family)
-            {
-                create_info.imageSharingMode = VK_SHARING_MODE_CONCURRENT;
-                create_info.queueFamilyIndexCount = 2;
-                create_info.pQueueFamilyIndices = queue_family_indices;
-            }
-            else
-            {
-                create_info.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
-                create_info.queueFamilyIndexCount = 0;
-                create_info.pQueueFamilyIndices = nullptr;
-            }
-
-            create_info.preTransform = swap_chain_support.capabilities.currentTransform;
-            create_info.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
-            create_info.presentMode = present_mode;
-            create_info.clipped = VK_TRUE;
-            create_info.oldSwapchain = VK_NULL_HANDLE;
-
-            if (vkCreateSwapchainKHR(device, &create_info, nullptr, &swapchain))
-                throw std::runtime_error("Failed to create swap chain.");
-
-            vkGetSwapchainImagesKHR(device, swapchain, &image_count, nullptr);
-            swapchain_images.resize(image_count);
-            vkGetSwapchainImagesKHR(device, swapchain, &image_count, swapchain_images.data());
-
-            swapchain_image_format = surface_format.format;
-            swapchain_extent = extent;
-        }
-
-        void Window::create_image_views()
-        {
-            swapchain_image_views.resize(swapchain_images.size());
-
-            for (size_t i = 0; i < swapchain_images.size(); i++)
-            {
-                VkImageViewCreateInfo create_info{};
-                create_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-                create_info.image = swapchain_images[i];
-                create_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
-                create_info.format = swapchain_image_format;
-
-                create_info.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
-                create_info.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
-                create_info.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
-                create_info.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
-
-                create_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-                create_info.subresourceRange.baseMipLevel = 0;
-                create_info.subresourceRange.levelCount = 1;
-                create_info.subresourceRange.baseArrayLayer = 0;
-                create_info.subresourceRange.layerCount = 1;
-
-                if (vkCreateImageView(device, &create_info, nullptr, &swapchain_image_views[i]) != VK_SUCCESS)
-                    throw std::runtime_error("\nFailed to create image views.");
-            }
-        }
-
-        void Window::pick_physical_device()
-        {
-
-            uint32_t device_count = 0;
-            vkEnumeratePhysicalDevices(instance, &device_count, nullptr);
-
-            if (device_count == 0)
-                throw std::runtime_error("\nFailed to find GPUs with Vulkan support!");
-
-            std::vector<VkPhysicalDevice> devices(device_count);
-            vkEnumeratePhysicalDevices(instance, &device_count, devices.data());
-
-            for (const auto& device : devices) 
-            {
-                if (is_device_suitable(device))
-                {
-                    physical_device = device;
-                    break;
-                }
-            }
-
-            if (physical_device == VK_NULL_HANDLE)
-                throw std::runtime_error("\nFailed to find a suitable GPU!");
-        }
-
-        bool Window::is_device_suitable(VkPhysicalDevice device)
-        {
-            VkPhysicalDeviceProperties device_properties;
-            VkPhysicalDeviceFeatures device_features;
-
-            vkGetPhysicalDeviceProperties(device, &device_properties);
-            vkGetPhysicalDeviceFeatures(device, &device_features);
-
-            return device_properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU &&
-                device_features.geometryShader;
-        }
-
-        void Window::create_logical_device()
-        {
-            Utils::QueueFamilyIndices indices = Utils::find_queue_families(physical_device, surface);
-
-            std::vector<VkDeviceQueueCreateInfo> queue_create_infos;
-            std::set<uint32_t> unique_queue_families = {indices.graphics_family.value(), indices.present_family.value()};
-
-            float queue_priority = 1.0f;
-            for (uint32_t queue_family : unique_queue_families)
-            {
-                VkDeviceQueueCreateInfo queue_create_info{};
-                queue_create_info.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-                queue_create_info.queueFamilyIndex = queue_family;
-                queue_create_info.queueCount = 1;
-                queue_create_info.pQueuePriorities = &queue_priority;
-                queue_create_infos.push_back(queue_create_info);
-            }
-
-            VkPhysicalDeviceFeatures device_features{};
-            
-            VkDeviceCreateInfo create_info{};
-            create_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-
-            create_info.queueCreateInfoCount = static_cast<uint32_t>(queue_create_infos.size());
-            create_info.pQueueCreateInfos = queue_create_infos.data();
-            
-            create_info.pEnabledFeatures = &device_features;
-            
-            create_info.enabledExtensionCount = static_cast<uint32_t>(Utils::device_extensions.size());
-            create_info.ppEnabledExtensionNames = Utils::device_extensions.data();
-
-            if (enable_validation_layers)
-            {
-                create_info.enabledLayerCount = static_cast<uint32_t>(validation_layers.size());
-                create_info.ppEnabledLayerNames = validation_layers.data();
-            }
-            else
-            {
-                create_info.enabledLayerCount = 0;
-            }
-
-            if (vkCreateDevice(physical_device, &create_info, nullptr, &device))
-                throw std::runtime_error("\nFailed to create logical device.");
-
-            vkGetDeviceQueue(device, indices.graphics_family.value(), 0, &graphics_queue);
-            vkGetDeviceQueue(device, indices.present_family.value(), 0, &present_queue);
-        }
-
-        bool Window::check_validation_layer_support()
-        {
-            uint32_t layer_count;
-            vkEnumerateInstanceLayerProperties(&layer_count, nullptr);
-
-            std::vector<VkLayerProperties> available_layers;
-            vkEnumerateInstanceLayerProperties(&layer_count, available_layers.data());
-
-            for (const char* layer_name : validation_layers)
-            {
-                bool layer_found;
-                for (const auto& layer_properties : available_layers)
-                    if (strcmp(layer_name, layer_properties.layerName) == 0)
-                    {
-                        layer_found = true;
-                        break;
-                    }
-                if (!layer_found)
-                    return false;
-            }
-            return true;
-        }
-
-        std::vector<const char*> Window::get_required_extensions()
-        {
-            uint32_t glfwExtensionCount = 0;
-            const char** glfwExtensions;
-
-            glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-
-            std::vector<const char*> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
-
-            if (enable_validation_layers)
-                extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
-
-            return extensions;
-        }
-
-        void Window::setup_debug_messenger()
-        {
-            if (!enable_validation_layers) return;
-
-            VkDebugUtilsMessengerCreateInfoEXT create_info{};
-            populate_debug_messenger_create_info(create_info);
-
-            if (create_debug_utils_messenger_ext(instance, &create_info, nullptr, &debug_messenger) != VK_SUCCESS)
-                throw std::runtime_error("\nFailed to setup debug messenger.");
-        }
-
-        void Window::populate_debug_messenger_create_info(VkDebugUtilsMessengerCreateInfoEXT& create_info)
-        {
-            create_info = {};
-            create_info.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT;
-            create_info.messageSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
-            create_info.messageType = VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT;
-            create_info.pfnUserCallback = debug_callback;
-        }
-
-        void Window::destroy_debug_messenger(
-                    VkInstance instance,
-                    VkDebugUtilsMessengerEXT debug_messenger,
-                    const VkAllocationCallbacks* p_allocator)
-        {
-            auto func = (PFN_vkDestroyDebugUtilsMessengerEXT) vkGetInstanceProcAddr(instance, "vkDestroyDebugMessengerEXT");
-            if (func != nullptr)
-                func (instance, debug_messenger, p_allocator);
-        }
-
-        VkResult Window::create_debug_utils_messenger_ext(
-                    VkInstance instance, 
-                    const VkDebugUtilsMessengerCreateInfoEXT* p_create_info,
-                    const VkAllocationCallbacks* p_allocator,
-                    VkDebugUtilsMessengerEXT* p_debug_messenger)
-        {
-            auto func = (PFN_vkCreateDebugUtilsMessengerEXT) vkGetInstanceProcAddr(instance, "vkCreateDebugUtilsMessengerEXT");
-            if (func != nullptr)
-                return func(instance, p_create_info, p_allocator, p_debug_messenger);
-            else
-                return VK_ERROR_EXTENSION_NOT_PRESENT;
-        }
-
-        VKAPI_ATTR VkBool32 VKAPI_CALL Window::debug_callback(
-                    VkDebugUtilsMessageSeverityFlagBitsEXT message_severity,
-                    VkDebugUtilsMessageTypeFlagsEXT message_type,
-                    const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData,
-                    void* pUserData)
-        {
-            std::cerr << "Validation layer: " << pCallbackData->pMessage << std::endl;
-
-            return VK_FALSE;
-        }  
-    };
+#include "window.hpp"
+/**
+ * @author Simon Brisebois-Therrien 
+ * @since 2021-09-20 
+ * 
+ * 
+ */
+
+namespace VulkanGameEngine
+{
+    namespace Graphics
+    {
+        static WindowSettings make_window_settings(const std::string& title, uint32_t width, uint32_t height)
+        {
+            WindowSettings settings;
+            settings.title = title;
+            settings.width = width;
+            settings.height = height;
+            return settings;
+        }
+
+        Window::Window(std::string window_title, uint32_t width, uint32_t height)
+            : Window(make_window_settings(window_title, width, height))
+        {
+        }
+
+        Window::Window(const WindowSettings& settings)
+        {
+            this->window_title = settings.title;
+            this->w_Width = settings.width;
+            this->w_Height = settings.height;
+            this->headless = settings.headless;
+            this->headless_frame_count = settings.headless_frame_count;
+            this->frames_in_flight = std::max(1u, settings.frames_in_flight);
+            this->present_policy = settings.present_policy;
+            this->worker_threads = settings.worker_threads;
+            this->parallel_recording = settings.parallel_recording;
+            this->preferred_device = settings.preferred_device;
+            this->pipeline_cache_path = settings.pipeline_cache_path;
+            this->startup_report_path = settings.startup_report_path;
+            this->trace_path = settings.trace_path;
+            this->shader_hot_reload = settings.shader_hot_reload;
+            this->texture_budget_mb = settings.texture_budget_mb;
+            this->streaming_test_textures = settings.streaming_test_textures;
+            this->mesh_path = settings.mesh_path;
+            this->mesh_pack_path = settings.mesh_pack_path;
+            this->scene_test_entities = settings.scene_test_entities;
+            this->particle_count = settings.particle_count;
+            this->verify_particles = settings.verify_particles;
+            this->capture_settings = settings.capture;
+
+            if (settings.target_fps > 0.0)
+                frame_pacer.set_target_fps(settings.target_fps);
+            else if (present_policy == Utils::PresentPolicy::PowerSaving)
+                frame_pacer.set_target_fps(30.0);
+
+            #ifdef VGE_HEADLESS_ONLY
+                this->headless = true;
+            #endif
+
+            VGE_PROFILE_THREAD("Main thread");
+
+            if (enable_validation_layers)
+            {
+                debug_sink.set_minimum_severity(settings.debug_severity);
+                for (int32_t id : settings.debug_muted_ids)
+                    debug_sink.mute(id);
+                debug_sink.start();
+            }
+
+            startup_report.begin();
+            startup_report.measure("init_jobs", [&]() { jobs.init(worker_threads); });
+            startup_report.set_attribute("worker_threads", std::to_string(jobs.get_worker_count()));
+            if (!headless)
+                startup_report.measure("init_window", [&]() { this->init_Window(); });
+            this->init_vulkan();
+            this->write_startup_report();
+
+            this->main_loop();
+            this->cleanup();
+
+            if (particle_verification_failed)
+                throw std::runtime_error("\nParticle simulation does not match the CPU reference.");
+            if (capture_failed)
+                throw std::runtime_error("\nCaptured frames do not match their golden images.");
+            
+        }
+
+        void Window::init_Window()
+        {
+            #ifndef VGE_HEADLESS_ONLY
+                if(!glfwInit())
+                    throw std::runtime_error("\nFailed to init glfw.");
+                
+                glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+                window = glfwCreateWindow(w_Width, w_Height, window_title.c_str(), nullptr, nullptr);
+
+                glfwSetWindowUserPointer(window, this);
+                glfwSetFramebufferSizeCallback(window, framebuffer_resize_callback);
+
+                uint32_t extensionCount = 0;
+                vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, nullptr);
+
+                printf("Supported extensions: %i", extensionCount);
+            #endif
+        }
+
+        void Window::init_vulkan()
+        {
+            startup_report.measure("create_instance", [&]() { this->create_instance(); });
+            startup_report.measure("setup_debug_messenger", [&]() { this->setup_debug_messenger(); });
+            if (!headless)
+                startup_report.measure("create_surface", [&]() { this->create_surface(); });
+            startup_report.measure("pick_physical_device", [&]() { this->pick_physical_device(); });
+            startup_report.measure("create_logical_device", [&]() { this->create_logical_device(); });
+            #ifdef VGE_ENABLE_PROFILING
+                startup_report.measure("init_profiler", [&]() {
+                    gpu_profiler.init(device, device_capabilities, queue_topology.graphics_family.value(), frames_in_flight);
+                });
+            #endif
+            startup_report.measure("init_pipeline_cache", [&]() {
+                pipeline_cache.init(device, device_capabilities, pipeline_cache_path);
+            });
+            startup_report.measure("init_memory", [&]() {
+                allocator.init(device, device_capabilities);
+                uploader.init(
+                    device, device_capabilities, allocator, transfer_queue,
+                    queue_topology.transfer_family.value(), queue_topology.graphics_family.value());
+            });
+            if (headless)
+                startup_report.measure("create_offscreen_targets", [&]() { this->create_offscreen_targets(); });
+            else
+            {
+                startup_report.measure("create_swap_chain", [&]() { this->create_swap_chain(); });
+                startup_report.measure("create_image_views", [&]() { this->create_image_views(); });
+            }
+            startup_report.measure("create_depth_resources", [&]() { this->create_depth_resources(); });
+            startup_report.measure("create_render_pass", [&]() { this->create_render_pass(); });
+            startup_report.measure("init_descriptors", [&]() {
+                descriptor_layouts.init(device);
+                if (device_capabilities.supports_bindless())
+                    bindless.init(device, device_capabilities, descriptor_layouts);
+            });
+            // The mesh pipeline's vertex input depends on the mesh's vertex format.
+            if (!mesh_path.empty())
+                startup_report.measure("load_mesh", [&]() { this->load_mesh(); });
+            startup_report.measure("create_pipelines", [&]() { this->create_pipelines(); });
+            startup_report.measure("create_framebuffers", [&]() { this->create_framebuffers(); });
+            startup_report.measure("init_texture_streaming", [&]() { this->init_texture_streaming(); });
+            if (scene_test_entities > 0)
+                startup_report.measure("create_scene_test", [&]() { this->create_scene_test(); });
+            if (mesh_pipeline != ShaderReloader::invalid_handle)
+                startup_report.measure("create_mesh_instances", [&]() { this->create_mesh_instances(); });
+            startup_report.measure("create_frame_resources", [&]() { this->create_frame_resources(); });
+            if (capture_settings.is_enabled())
+                startup_report.measure("init_frame_capture", [&]() { this->init_frame_capture(); });
+            startup_report.measure("build_render_graph", [&]() { this->build_render_graph(); });
+            if (parallel_recording)
+                startup_report.measure("init_recorder", [&]() {
+                    recorder.init(device, queue_topology.graphics_family.value(), frames_in_flight, jobs);
+                });
+        }
+
+        #ifdef VGE_ENABLE_PROFILING
+            void Window::update_profiler_overlay()
+            {
+                #ifndef VGE_HEADLESS_ONLY
+                    // No text rendering yet: the summary goes to the window title, twice a second.
+                    auto now = std::chrono::steady_clock::now();
+                    if (now - last_overlay_update < std::chrono::milliseconds(500))
+                        return;
+                    last_overlay_update = now;
+
+                    const Profiling::GpuProfiler::RegionStatistics* gpu_frame = gpu_profiler.find_region("frame");
+
+                    char title[256];
+                    snprintf(title, sizeof(title), "%s | cpu %.2f ms (wait %.2f ms) | gpu %.2f ms",
+                        window_title.c_str(),
+                        frame_metrics.average_frame_time_ms(),
+                        frame_metrics.average_fence_wait_ms(),
+                        gpu_frame ? gpu_frame->last_ms : 0.0);
+                    glfwSetWindowTitle(window, title);
+                #endif
+            }
+        #endif
+
+        void Window::write_startup_report()
+        {
+            startup_report.set_attribute("mode", headless ? "headless" : "windowed");
+            startup_report.set_attribute("device", device_capabilities.properties.deviceName);
+            startup_report.set_attribute("pipeline_cache", pipeline_cache.get_statistics().warm_start ? "warm" : "cold");
+
+            startup_report.print(std::cout);
+
+            if (!startup_report_path.empty() && !startup_report.write_json(startup_report_path))
+                std::cerr << "\nFailed to write startup report to " << startup_report_path << ".";
+        }
+
+        void Window::print_descriptor_statistics()
+        {
+            DescriptorAllocator::Statistics sets;
+            for (const auto& frame : frames)
+            {
+                const DescriptorAllocator::Statistics& statistics = frame.descriptors.get_statistics();
+                sets.sets_allocated += statistics.sets_allocated;
+                sets.pools_created += statistics.pools_created;
+            }
+            const DescriptorLayoutCache::Statistics& layouts = descriptor_layouts.get_statistics();
+
+            printf("Descriptors: %llu sets from %u pools, %zu layouts (%llu cache hits), bindless %s",
+                static_cast<unsigned long long>(sets.sets_allocated), sets.pools_created,
+                descriptor_layouts.size(), static_cast<unsigned long long>(layouts.hits),
+                bindless.is_initialized() ? "on" : "off");
+            if (bindless.is_initialized())
+                printf(" (%u textures, %u buffers)", bindless.get_texture_capacity(), bindless.get_buffer_capacity());
+            printf("\n");
+        }
+
+        void Window::init_texture_streaming()
+        {
+            TextureStreamer::Settings settings;
+            settings.budget = static_cast<VkDeviceSize>(texture_budget_mb) << 20;
+            texture_streamer.init(device, device_capabilities, allocator, uploader, deletion_queue, &bindless, settings);
+
+            // Procedural 1024x1024 textures, every level a flat color unique to the
+            // texture and level, so a wrong level is easy to spot in a capture.
+            for (uint32_t i = 0; i < streaming_test_textures; i++)
+            {
+                streaming_test_set.push_back(texture_streamer.create_texture(1024, 1024, VK_FORMAT_R8G8B8A8_UNORM, 0,
+                    [i](uint32_t mip, uint8_t* destination, VkDeviceSize size) {
+                        uint32_t color = ((i * 2654435761u) ^ (mip * 0x00204080u)) | 0xff000000u;
+                        for (VkDeviceSize offset = 0; offset + 4 <= size; offset += 4)
+                            memcpy(destination + offset, &color, 4);
+                    }));
+            }
+        }
+
+        void Window::request_streaming_test_textures()
+        {
+            // Textures sit one unit apart on a line; the camera moves a quarter unit per frame,
+            // wraps around, and sees 16 textures on either side, smaller with distance.
+            double camera = std::fmod(frame_number * 0.25, static_cast<double>(streaming_test_set.size()));
+            for (size_t i = 0; i < streaming_test_set.size(); i++)
+            {
+                double distance = std::abs(static_cast<double>(i) - camera);
+                if (distance <= 16.0)
+                    texture_streamer.request_screen_space(streaming_test_set[i], static_cast<float>(swapchain_extent.width / (1.0 + distance)), frame_number);
+            }
+        }
+
+        void Window::load_mesh()
+        {
+            if (!mesh_pack_path.empty())
+            {
+                Assets::AssetPack pack;
+                pack.open(mesh_pack_path);
+                const Assets::PackEntry* entry = pack.find(mesh_path);
+                if (!entry)
+                    throw std::runtime_error("\nThe pack " + mesh_pack_path + " has no asset " + mesh_path + ".");
+
+                // Decompressed by the workers straight into the staging ring.
+                mesh = Mesh::create_gpu_mesh(pack, *entry, allocator, uploader, &jobs);
+            }
+            else
+            {
+                Mesh::ProcessedMesh processed;
+                std::string extension = mesh_path.size() >= 4 ? mesh_path.substr(mesh_path.size() - 4) : "";
+                if (extension == ".obj" || extension == ".OBJ")
+                    processed = Mesh::process_mesh(Mesh::load_obj(mesh_path), Mesh::ProcessOptions{});
+                else
+                    processed = Mesh::read_mesh_file(mesh_path);
+
+                mesh = Mesh::create_gpu_mesh(processed, allocator, uploader);
+            }
+            uploader.flush();
+
+            printf("Mesh %s: %u vertices (%s), %u triangles, %u meshlets\n",
+                mesh_path.c_str(),
+                mesh.vertex_count,
+                mesh.quantized ? "quantized" : "float",
+                mesh.index_count / 3,
+                mesh.meshlet_count);
+        }
+
+        void Window::create_scene_test()
+        {
+            // Trees of 1 + 4 + 16 + 64 entities, children offset from their parent
+            // and turned a little per level; every 64th tree's root is animated.
+            const uint32_t tree_size = 85;
+            Scene::LocalTransform local;
+            for (uint32_t created = 0; created < scene_test_entities; )
+            {
+                local.position[0] = static_cast<float>(created / tree_size % 256) * 4.0f;
+                local.position[2] = static_cast<float>(created / tree_size / 256) * 4.0f;
+                Scene::Entity root = transforms.create(scene, local);
+                if ((created / tree_size) % 64 == 0)
+                    scene_test_roots.push_back(root);
+                created++;
+
+                std::vector<Scene::Entity> level = {root};
+                for (uint32_t depth = 1; depth < 4 && created < scene_test_entities; depth++)
+                {
+                    std::vector<Scene::Entity> next;
+                    for (Scene::Entity parent : level)
+                        for (uint32_t child = 0; child < 4 && created < scene_test_entities; child++, created++)
+                        {
+                            Scene::LocalTransform offset;
+                            offset.position[0] = (child & 1) ? 0.5f : -0.5f;
+                            offset.position[1] = 0.5f;
+                            offset.position[2] = (child & 2) ? 0.5f : -0.5f;
+                            offset.rotation[1] = std::sin(0.1f);
+                            offset.rotation[3] = std::cos(0.1f);
+                            offset.scale[0] = offset.scale[1] = offset.scale[2] = 0.5f;
+                            next.push_back(transforms.create(scene, offset, parent));
+                        }
+                    level = std::move(next);
+                }
+            }
+
+            transforms.update(scene, &jobs);
+            scene.print_statistics(std::cout);
+        }
+
+        void Window::animate_scene_test()
+        {
+            float angle = static_cast<float>(frame_number) * 0.01f;
+            for (Scene::Entity root : scene_test_roots)
+            {
+                Scene::LocalTransform local = *scene.get<Scene::LocalTransform>(root);
+                local.rotation[1] = std::sin(angle * 0.5f);
+                local.rotation[3] = std::cos(angle * 0.5f);
+                transforms.set_local(scene, root, local);
+            }
+        }
+
+        void Window::create_mesh_instances()
+        {
+            // Without a scene the mesh is drawn once, at the origin.
+            if (scene.size() == 0)
+            {
+                transforms.create(scene);
+                transforms.update(scene, &jobs);
+            }
+
+            scene.for_each_chunk(Scene::TransformSystem::get_mask(), 0, [&](Scene::ChunkView& chunk) {
+                mesh_instances.insert(mesh_instances.end(), chunk.get_entities(), chunk.get_entities() + chunk.size());
+            });
+            uint32_t count = static_cast<uint32_t>(mesh_instances.size());
+
+            Math::Aabb mesh_box{
+                Math::Vec3(mesh.bounds_min[0], mesh.bounds_min[1], mesh.bounds_min[2]),
+                Math::Vec3(mesh.bounds_max[0], mesh.bounds_max[1], mesh.bounds_max[2])};
+            Math::Sphere mesh_sphere{mesh_box.center(), Math::length(mesh_box.max - mesh_box.min) * 0.5f};
+
+            mesh_instance_matrices.resize(count);
+            mesh_local_bounds.assign(count, mesh_sphere);
+            mesh_world_bounds.resize(count);
+
+            // Every instance draws the whole mesh; firstInstance is its matrix's index.
+            Math::Aabb scene_box{Math::Vec3(FLT_MAX, FLT_MAX, FLT_MAX), Math::Vec3(-FLT_MAX, -FLT_MAX, -FLT_MAX)};
+            for (uint32_t i = 0; i < count; i++)
+            {
+                memcpy(mesh_instance_matrices[i].m, transforms.get_world_matrix(scene, mesh_instances[i]), sizeof(Math::Mat4));
+                Math::Vec3 center = Math::transform_point(mesh_instance_matrices[i], mesh_sphere.center);
+                scene_box.min = Math::min(scene_box.min, center);
+                scene_box.max = Math::max(scene_box.max, center);
+
+                VkDrawIndexedIndirectCommand draw{mesh.index_count, 1, 0, 0, i};
+                mesh_objects.push_back(visibility.add(&center.x, mesh_sphere.radius, draw));
+            }
+            mesh_view_bounds = Math::Sphere{scene_box.center(), Math::length(scene_box.max - scene_box.min) * 0.5f + mesh_sphere.radius};
+
+            indirect_draws.init(allocator, device_capabilities, frames_in_flight, count);
+
+            mesh_instance_buffers.assign(frames_in_flight, VK_NULL_HANDLE);
+            mesh_instance_allocations.resize(frames_in_flight);
+            for (uint32_t i = 0; i < frames_in_flight; i++)
+            {
+                // The camera's view projection, then one world matrix per instance.
+                mesh_instance_allocations[i] = allocator.create_buffer(
+                    static_cast<VkDeviceSize>(count + 1) * sizeof(Math::Mat4),
+                    VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                    mesh_instance_buffers[i]);
+
+                if (!mesh_instance_allocations[i].mapped)
+                    throw std::runtime_error("\nFailed to map a mesh instance buffer.");
+            }
+        }
+
+        void Window::prepare_mesh_draws(FrameResources& frame)
+        {
+            mesh_draw_count = 0;
+            mesh_instance_set = VK_NULL_HANDLE;
+            if (mesh_instances.empty() || !uploader.is_complete(mesh.ticket))
+                return;
+
+            // A slow orbit around the instances, so that most frames cull something.
+            float angle = static_cast<float>(frame_number) * 0.002f;
+            float distance = std::max(mesh_view_bounds.radius, 1.0f);
+            Math::Vec3 eye = mesh_view_bounds.center + Math::Vec3(std::cos(angle), 0.5f, std::sin(angle)) * distance;
+            float aspect = static_cast<float>(swapchain_extent.width) / static_cast<float>(std::max(1u, swapchain_extent.height));
+            Math::Mat4 view_projection =
+                Math::perspective(1.0f, aspect, distance * 0.001f, distance * 4.0f) *
+                Math::look_at(eye, mesh_view_bounds.center, Math::Vec3(0.0f, 1.0f, 0.0f));
+
+            uint32_t count = static_cast<uint32_t>(mesh_instances.size());
+            for (uint32_t i = 0; i < count; i++)
+                memcpy(mesh_instance_matrices[i].m, transforms.get_world_matrix(scene, mesh_instances[i]), sizeof(Math::Mat4));
+            Math::transform_spheres(mesh_instance_matrices.data(), mesh_local_bounds.data(), mesh_world_bounds.data(), count);
+            for (uint32_t i = 0; i < count; i++)
+                visibility.set_bounds(mesh_objects[i], &mesh_world_bounds[i].center.x, mesh_world_bounds[i].radius);
+
+            Math::Mat4* instances = static_cast<Math::Mat4*>(mesh_instance_allocations[current_frame].mapped);
+            instances[0] = view_projection;
+            memcpy(instances + 1, mesh_instance_matrices.data(), count * sizeof(Math::Mat4));
+
+            mesh_draw_count = visibility.build_draws(
+                extract_frustum(view_projection.m),
+                indirect_draws.get_commands(current_frame),
+                indirect_draws.get_capacity(),
+                mesh_visible,
+                &jobs);
+
+            // Rewritten every frame, so it lives as long as the frame's other transient sets.
+            mesh_instance_set = frame.descriptors.allocate(mesh_set_layout);
+
+            VkDescriptorBufferInfo buffer_info{mesh_instance_buffers[current_frame], 0, VK_WHOLE_SIZE};
+            VkWriteDescriptorSet write{};
+            write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            write.dstSet = mesh_instance_set;
+            write.dstBinding = 0;
+            write.descriptorCount = 1;
+            write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            write.pBufferInfo = &buffer_info;
+            vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+        }
+
+        void Window::record_mesh_draws(VkCommandBuffer command_buffer)
+        {
+            VkPipeline pipeline = shader_reloader.get_pipeline(mesh_pipeline);
+            if (mesh_draw_count == 0 || pipeline == VK_NULL_HANDLE)
+                return;
+
+            MeshConstants constants{};
+            constants.quantized = mesh.quantized ? 1 : 0;
+            constants.texture_index = BindlessTable::invalid_index;
+            memcpy(constants.uv_offset, mesh.uv_transform.offset, sizeof(constants.uv_offset));
+            memcpy(constants.uv_scale, mesh.uv_transform.scale, sizeof(constants.uv_scale));
+
+            vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+            vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mesh_layout, 0, 1, &mesh_instance_set, 0, nullptr);
+            if (bindless.is_initialized())
+            {
+                // The table is update-after-bind: textures swapped in this frame are already written.
+                bindless.bind(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mesh_layout, 1);
+                if (!streaming_test_set.empty())
+                    constants.texture_index = texture_streamer.get_bindless_index(streaming_test_set[0]);
+            }
+            vkCmdPushConstants(command_buffer, mesh_layout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(constants), &constants);
+            Mesh::bind_gpu_mesh(command_buffer, mesh);
+            indirect_draws.record(command_buffer, current_frame, mesh_draw_count);
+        }
+
+        void Window::queue_draws()
+        {
+            draw_queue.begin_frame();
+            draw_queue.set_pipeline(background_draw_pipeline, shader_reloader.get_pipeline(background_pipeline));
+
+            // Fullscreen triangle behind everything else; same color cycle as the clear.
+            float t = static_cast<float>(frame_number % 256) / 255.0f;
+            DrawCommand background;
+            background.count = 3;
+            background.push_stages = VK_SHADER_STAGE_FRAGMENT_BIT;
+            background.push_size = sizeof(float);
+            memcpy(background.push_constants, &t, sizeof(float));
+
+            DrawState state;
+            state.pipeline = background_draw_pipeline;
+            state.depth = 1.0f;
+            draw_queue.submit(state, background);
+
+            if (particles.is_initialized())
+            {
+                draw_queue.set_pipeline(particle_draw_pipeline, shader_reloader.get_pipeline(particle_render_pipeline));
+
+                DrawCommand points;
+                points.vertex_buffer = particles.get_next_buffer();
+                points.count = particles.get_count();
+
+                DrawState particle_state;
+                particle_state.layer = 1;
+                particle_state.pipeline = particle_draw_pipeline;
+                draw_queue.submit(particle_state, points);
+            }
+
+            draw_queue.sort(&jobs);
+        }
+
+        void Window::main_loop()
+        {
+            auto start = std::chrono::steady_clock::now();
+            last_frame_start = start;
+
+            if (headless)
+            {
+                for (uint32_t i = 0; i < headless_frame_count; i++)
+                {
+                    this->pace_frame();
+                    jobs.pump_main_thread();
+                    this->draw_frame();
+                }
+            }
+            else
+            {
+                #ifndef VGE_HEADLESS_ONLY
+                    while (!glfwWindowShouldClose(window))
+                    {
+                        this->pace_frame();
+                        glfwPollEvents();
+                        jobs.pump_main_thread();
+                        this->draw_frame();
+
+                        #ifdef VGE_ENABLE_PROFILING
+                            this->update_profiler_overlay();
+                        #endif
+                    }
+                #endif
+            }
+
+            vkDeviceWaitIdle(device);
+
+            // The last frames' copies are written before the statistics are printed.
+            frame_capture.flush();
+
+            double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            double frames_per_second = elapsed_ms > 0.0 ? frame_number * 1000.0 / elapsed_ms : 0.0;
+
+            printf("\n%s run: %llu frames in %.2f ms (%.1f frames/s, %ux%u, %u frames in flight)\n",
+                headless ? "Headless" : "Windowed",
+                static_cast<unsigned long long>(frame_number), elapsed_ms, frames_per_second,
+                swapchain_extent.width, swapchain_extent.height, frames_in_flight);
+            printf("Present policy: %s (%s, %zu images)\n",
+                Utils::present_policy_name(present_policy),
+                headless ? "offscreen" : Utils::present_mode_name(present_mode),
+                swapchain_images.size());
+            frame_metrics.print_summary(std::cout);
+            frame_pacer.print_summary(std::cout);
+
+            const Uploader::Statistics& uploads = uploader.get_statistics();
+            printf("Uploads: %llu bytes in %llu copies, %llu submissions, %llu staging ring stalls\n",
+                static_cast<unsigned long long>(uploads.bytes_uploaded),
+                static_cast<unsigned long long>(uploads.copies),
+                static_cast<unsigned long long>(uploads.submissions),
+                static_cast<unsigned long long>(uploads.ring_stalls));
+            allocator.print_statistics(std::cout);
+            pipeline_cache.print_report(std::cout);
+            render_graph.print_report(std::cout);
+            draw_queue.print_statistics(std::cout);
+            this->print_descriptor_statistics();
+            texture_streamer.print_statistics(std::cout);
+            if (scene.size() > 0)
+                transforms.print_statistics(std::cout);
+            if (!mesh_instances.empty())
+                visibility.print_statistics(std::cout);
+            if (particles.is_initialized())
+            {
+                particles.print_statistics(std::cout);
+                if (verify_particles)
+                {
+                    ParticleComparison comparison = particles.verify(&jobs);
+                    printf("Particle verification: %s, %u of %u particles differ from the CPU reference (max error: position %g, velocity %g, life %g)\n",
+                        comparison.passed() ? "passed" : "FAILED",
+                        comparison.mismatches, comparison.count,
+                        comparison.max_position_error, comparison.max_velocity_error, comparison.max_life_error);
+                    particle_verification_failed = !comparison.passed();
+                }
+            }
+            if (frame_capture.is_initialized())
+            {
+                frame_capture.print_statistics(std::cout);
+                capture_failed = !frame_capture.passed();
+            }
+            jobs.print_statistics(std::cout);
+
+            #ifdef VGE_ENABLE_PROFILING
+                gpu_profiler.print_summary(std::cout);
+
+                if (!trace_path.empty())
+                {
+                    if (Profiling::write_chrome_trace(trace_path, Profiling::collect_cpu_events(), gpu_profiler.get_events()))
+                        printf("Trace written to %s\n", trace_path.c_str());
+                    else
+                        std::cerr << "\nFailed to write trace to " << trace_path << ".";
+                }
+            #endif
+        }
+
+        void Window::pace_frame()
+        {
+            VGE_PROFILE_SCOPE("pace_frame");
+
+            frame_pacer.wait();
+
+            // Input sampled after this point is shown by the next frame at the latest:
+            // the CPU does not queue frames ahead of the GPU.
+            if (present_policy == Utils::PresentPolicy::LowLatency && frame_number > 0)
+            {
+                uint32_t previous_frame = (current_frame + frames_in_flight - 1) % frames_in_flight;
+                vkWaitForFences(device, 1, &frames[previous_frame].in_flight_fence, VK_TRUE, UINT64_MAX);
+            }
+        }
+
+        void Window::cleanup()
+        {
+            vkDeviceWaitIdle(device);
+
+            deletion_queue.flush_all();
+            frame_capture.cleanup();
+            uploader.cleanup();
+            recorder.cleanup();
+
+            for (auto& frame : frames)
+                frame.destroy(device);
+
+            for (auto framebuffer : swapchain_framebuffers)
+                vkDestroyFramebuffer(device, framebuffer, nullptr);
+
+            vkDestroyRenderPass(device, render_pass, nullptr);
+
+            vkDestroyImageView(device, depth_image_view, nullptr);
+            allocator.destroy_image(depth_image, depth_image_allocation);
+
+            for (auto imageView : swapchain_image_views)
+                vkDestroyImageView(device, imageView, nullptr);
+
+            if (headless)
+            {
+                // Offscreen color images are owned by us, not by a swapchain.
+                for (size_t i = 0; i < swapchain_images.size(); i++)
+                    allocator.destroy_image(swapchain_images[i], offscreen_image_allocations[i]);
+            }
+            else
+                vkDestroySwapchainKHR(device, swapchain, nullptr);
+
+            texture_streamer.cleanup();
+            particles.cleanup();
+            indirect_draws.cleanup();
+            for (size_t i = 0; i < mesh_instance_buffers.size(); i++)
+                allocator.destroy_buffer(mesh_instance_buffers[i], mesh_instance_allocations[i]);
+            Mesh::destroy_gpu_mesh(mesh, allocator);
+            scene.clear();
+            render_graph.cleanup();
+            capture_render_graph.cleanup();
+            bindless.cleanup();
+            descriptor_layouts.cleanup();
+            allocator.cleanup();
+            shader_reloader.cleanup();
+            vkDestroyPipelineLayout(device, background_layout, nullptr);
+            vkDestroyPipelineLayout(device, particle_layout, nullptr);
+            vkDestroyPipelineLayout(device, mesh_layout, nullptr);
+            pipeline_cache.cleanup();
+            #ifdef VGE_ENABLE_PROFILING
+                gpu_profiler.cleanup();
+            #endif
+
+            vkDestroyDevice(device, nullptr);
+
+            if (enable_validation_layers)
+                destroy_debug_messenger(instance, debug_messenger, nullptr);
+
+            if (!headless)
+                vkDestroySurfaceKHR(instance, surface, nullptr);
+            vkDestroyInstance(instance, nullptr);
+
+            debug_sink.stop();
+
+            #ifndef VGE_HEADLESS_ONLY
+                if (!headless)
+                {
+                    glfwDestroyWindow(window);
+
+                    glfwTerminate();
+                }
+            #endif
+
+            jobs.cleanup();
+        }
+
+        void Window::create_instance()
+        {
+            if (enable_validation_layers && !check_validation_layer_support())
+                throw std::runtime_error("\nValidation layers requested, but not available!");
+
+            VkApplicationInfo app_info{};
+            app_info.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+            app_info.pApplicationName = "Default Application name.";
+            app_info.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
+            app_info.pEngineName = "VulkanGameEngine";
+            app_info.engineVersion = VK_MAKE_VERSION(1, 0, 0);
+            // 1.1 for vkGetPhysicalDeviceFeatures2 (descriptor indexing); 1.0 devices still work.
+            app_info.apiVersion = VK_API_VERSION_1_1;
+
+            VkInstanceCreateInfo create_info{};
+            create_info.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+            create_info.pApplicationInfo = &app_info;
+
+            auto extensions = get_required_extensions();
+            create_info.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+            create_info.ppEnabledExtensionNames = extensions.data();
+
+            VkDebugUtilsMessengerCreateInfoEXT debug_create_info{};
+            if (enable_validation_layers)
+            {
+                create_info.enabledLayerCount = static_cast<uint32_t>(validation_layers.size());
+                create_info.ppEnabledLayerNames = validation_layers.data();
+
+                populate_debug_messenger_create_info(debug_create_info);
+                create_info.pNext = (VkDebugUtilsMessengerCreateInfoEXT*) &debug_create_info;
+            }
+            else
+            {
+                create_info.enabledLayerCount = 0;
+                create_info.pNext = nullptr;
+            }
+
+            if (vkCreateInstance(&create_info, nullptr, &instance) != VK_SUCCESS)
+                throw std::runtime_error("\nFailed to create instance.");
+        }
+
+        void Window::create_surface()
+        {
+            #ifndef VGE_HEADLESS_ONLY
+                if (glfwCreateWindowSurface(instance, window, nullptr, &surface) != VK_SUCCESS)
+                    throw std::runtime_error("\nFailed to create window surface.");
+            #endif
+        }
+
+        void Window::create_swap_chain()
+        {
+            // Formats and present modes come from the device snapshot; only the
+            // surface capabilities (current extent) change between recreations.
+            Utils::SwapChainSupportDetails swap_chain_support;
+            swap_chain_support.formats = device_capabilities.surface_formats;
+            swap_chain_support.present_modes = device_capabilities.present_modes;
+            vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physical_device, surface, &swap_chain_support.capabilities);
+
+            VkSurfaceFormatKHR surface_format = Utils::choose_swap_surface_format(swap_chain_support.formats);
+            Utils::PresentConfiguration present_configuration = Utils::choose_present_configuration(
+                present_policy, swap_chain_support.capabilities, swap_chain_support.present_modes);
+            VkExtent2D extent = Utils::choose_swap_extent(swap_chain_support.capabilities, window);
+
+            present_mode = present_configuration.present_mode;
+            uint32_t image_count = present_configuration.image_count;
+
+            VkSwapchainCreateInfoKHR create_info{};
+            create_info.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
+            create_info.surface = surface;
+
+            create_info.minImageCount = image_count;
+            create_info.imageFormat = surface_format.format;
+            create_info.imageColorSpace = surface_format.colorSpace;
+            create_info.imageExtent = extent;
+            create_info.imageArrayLayers = 1;
+            create_info.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+            if (capture_settings.is_enabled() && (swap_chain_support.capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT))
+                create_info.imageUsage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+
+            uint32_t queue_family_indices[] = {queue_topology.graphics_family.value(), queue_topology.present_family.value()};
+
+            if (queue_topology.graphics_family != queue_topology.present_family)
+            {
+                create_info.imageSharingMode = VK_SHARING_MODE_CONCURRENT;
+                create_info.queueFamilyIndexCount = 2;
+                create_info.pQueueFamilyIndices = queue_family_indices;
+            }
+            else
+            {
+                create_info.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+                create_info.queueFamilyIndexCount = 0;
+                create_info.pQueueFamilyIndices = nullptr;
+            }
+
+            create_info.preTransform = swap_chain_support.capabilities.currentTransform;
+            create_info.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+            create_info.presentMode = present_mode;
+            create_info.clipped = VK_TRUE;
+            // Handing over the old swapchain lets the driver recycle its images.
+            create_info.oldSwapchain = swapchain;
+
+            VkSwapchainKHR old_swapchain = swapchain;
+
+            if (vkCreateSwapchainKHR(device, &create_info, nullptr, &swapchain))
+                throw std::runtime_error("Failed to create swap chain.");
+
+            if (old_swapchain != VK_NULL_HANDLE)
+            {
+                VkDevice device = this->device;
+                deletion_queue.push(frame_number, [device, old_swapchain]() {
+                    vkDestroySwapchainKHR(device, old_swapchain, nullptr);
+                });
+            }
+
+            vkGetSwapchainImagesKHR(device, swapchain, &image_count, nullptr);
+            swapchain_images.resize(image_count);
+            vkGetSwapchainImagesKHR(device, swapchain, &image_count, swapchain_images.data());
+
+            swapchain_image_format = surface_format.format;
+            swapchain_extent = extent;
+        }
+
+        void Window::create_image_views()
+        {
+            swapchain_image_views.resize(swapchain_images.size());
+
+            for (size_t i = 0; i < swapchain_images.size(); i++)
+            {
+                VkImageViewCreateInfo create_info{};
+                create_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+                create_info.image = swapchain_images[i];
+                create_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+                create_info.format = swapchain_image_format;
+
+                create_info.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+                create_info.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+                create_info.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+                create_info.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+
+                create_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+                create_info.subresourceRange.baseMipLevel = 0;
+                create_info.subresourceRange.levelCount = 1;
+                create_info.subresourceRange.baseArrayLayer = 0;
+                create_info.subresourceRange.layerCount = 1;
+
+                if (vkCreateImageView(device, &create_info, nullptr, &swapchain_image_views[i]) != VK_SUCCESS)
+                    throw std::runtime_error("\nFailed to create image views.");
+            }
+        }
+
+        void Window::recreate_swap_chain()
+        {
+            #ifndef VGE_HEADLESS_ONLY
+                // A minimized window has a zero sized framebuffer; wait until it is restored.
+                int width = 0, height = 0;
+                glfwGetFramebufferSize(window, &width, &height);
+                while (width == 0 || height == 0)
+                {
+                    if (glfwWindowShouldClose(window))
+                        return;
+                    glfwWaitEvents();
+                    glfwGetFramebufferSize(window, &width, &height);
+                }
+            #endif
+
+            // No vkDeviceWaitIdle: frames in flight keep using the old objects
+            // until they retire through the deletion queue.
+            this->retire_swap_chain_resources();
+
+            this->create_swap_chain();
+            this->create_image_views();
+            this->create_depth_resources();
+            this->create_framebuffers();
+
+            images_in_flight.assign(swapchain_images.size(), VK_NULL_HANDLE);
+            framebuffer_resized = false;
+
+            // Time spent minimized or resizing is not a missed frame.
+            frame_pacer.reset();
+        }
+
+        void Window::retire_swap_chain_resources()
+        {
+            VkDevice device = this->device;
+
+            std::vector<VkFramebuffer> framebuffers = std::move(swapchain_framebuffers);
+            std::vector<VkImageView> image_views = std::move(swapchain_image_views);
+            VkImageView old_depth_view = depth_image_view;
+            VkImage old_depth_image = depth_image;
+            Memory::Allocation old_depth_allocation = depth_image_allocation;
+            Memory::MemoryAllocator* allocator = &this->allocator;
+
+            deletion_queue.push(frame_number, [=]() {
+                for (auto framebuffer : framebuffers)
+                    vkDestroyFramebuffer(device, framebuffer, nullptr);
+                for (auto image_view : image_views)
+                    vkDestroyImageView(device, image_view, nullptr);
+
+                vkDestroyImageView(device, old_depth_view, nullptr);
+                allocator->destroy_image(old_depth_image, old_depth_allocation);
+            });
+
+            swapchain_framebuffers.clear();
+            swapchain_image_views.clear();
+            depth_image_view = VK_NULL_HANDLE;
+            depth_image = VK_NULL_HANDLE;
+            depth_image_allocation = Memory::Allocation{};
+        }
+
+        void Window::create_offscreen_targets()
+        {
+            swapchain_image_format = VK_FORMAT_R8G8B8A8_UNORM;
+            swapchain_extent = {w_Width, w_Height};
+
+            // One more image than frames in flight, like a mailbox swapchain.
+            uint32_t image_count = frames_in_flight + 1;
+
+            swapchain_images.resize(image_count);
+            offscreen_image_allocations.resize(image_count);
+            swapchain_image_views.resize(image_count);
+
+            for (uint32_t i = 0; i < image_count; i++)
+            {
+                // Render targets get dedicated allocations so they never pin a shared block.
+                offscreen_image_allocations[i] = allocator.create_image(
+                    swapchain_extent, swapchain_image_format, VK_IMAGE_TILING_OPTIMAL,
+                    VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, swapchain_images[i], true);
+
+                swapchain_image_views[i] = Utils::create_image_view(device, swapchain_images[i], swapchain_image_format, VK_IMAGE_ASPECT_COLOR_BIT);
+            }
+        }
+
+        void Window::create_depth_resources()
+        {
+            depth_format = Utils::find_depth_format(physical_device);
+
+            depth_image_allocation = allocator.create_image(
+                swapchain_extent, depth_format, VK_IMAGE_TILING_OPTIMAL,
+                VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, depth_image, true);
+
+            depth_image_view = Utils::create_image_view(device, depth_image, depth_format, VK_IMAGE_ASPECT_DEPTH_BIT);
+        }
+
+        void Window::create_render_pass()
+        {
+            VkAttachmentDescription color_attachment{};
+            color_attachment.format = swapchain_image_format;
+            color_attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+            color_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+            color_attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+            color_attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            color_attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            // The render graph owns every layout transition and barrier around the pass.
+            color_attachment.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+            color_attachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+            VkAttachmentDescription depth_attachment{};
+            depth_attachment.format = depth_format;
+            depth_attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+            depth_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+            depth_attachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            depth_attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            depth_attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            depth_attachment.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+            depth_attachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+            VkAttachmentReference color_attachment_ref{0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+            VkAttachmentReference depth_attachment_ref{1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL};
+
+            VkSubpassDescription subpass{};
+            subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+            subpass.colorAttachmentCount = 1;
+            subpass.pColorAttachments = &color_attachment_ref;
+            subpass.pDepthStencilAttachment = &depth_attachment_ref;
+
+            VkAttachmentDescription attachments[] = {color_attachment, depth_attachment};
+
+            VkRenderPassCreateInfo create_info{};
+            create_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+            create_info.attachmentCount = 2;
+            create_info.pAttachments = attachments;
+            create_info.subpassCount = 1;
+            create_info.pSubpasses = &subpass;
+
+            if (vkCreateRenderPass(device, &create_info, nullptr, &render_pass) != VK_SUCCESS)
+                throw std::runtime_error("\nFailed to create render pass.");
+        }
+
+        // Set by the build; without it, SPIR-V is looked up next to the working directory
+        // and hot reload can only pick up rebuilt SPIR-V.
+        #ifndef VGE_SHADER_DIR
+            #define VGE_SHADER_DIR "shaders"
+        #endif
+        #ifndef VGE_SHADER_SOURCE_DIR
+            #define VGE_SHADER_SOURCE_DIR ""
+        #endif
+        #ifndef VGE_GLSLC
+            #define VGE_GLSLC ""
+        #endif
+
+        void Window::create_pipelines()
+        {
+            shader_reloader.init(device, VGE_GLSLC);
+
+            VkPushConstantRange push_constant{VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(float)};
+
+            VkPipelineLayoutCreateInfo layout_info{};
+            layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+            layout_info.pushConstantRangeCount = 1;
+            layout_info.pPushConstantRanges = &push_constant;
+
+            if (vkCreatePipelineLayout(device, &layout_info, nullptr, &background_layout) != VK_SUCCESS)
+                throw std::runtime_error("\nFailed to create pipeline layout.");
+            // The handle is filled in every frame: hot reload may replace it.
+            background_draw_pipeline = draw_queue.add_pipeline(VK_NULL_HANDLE, background_layout);
+
+            std::string spirv_dir = VGE_SHADER_DIR;
+            std::string source_dir = VGE_SHADER_SOURCE_DIR;
+
+            // Built without glslc: the frame is only cleared.
+            if (!std::filesystem::exists(spirv_dir + "/background.vert.spv"))
+            {
+                std::cerr << "\nNo compiled shaders in " << spirv_dir << ", skipping the background pass.\n";
+                return;
+            }
+
+            auto source = [&](const char* name) { return source_dir.empty() ? std::string() : source_dir + "/" + name; };
+
+            ShaderReloader::ShaderHandle vertex = shader_reloader.add_shader(source("background.vert"), spirv_dir + "/background.vert.spv");
+            ShaderReloader::ShaderHandle fragment = shader_reloader.add_shader(source("background.frag"), spirv_dir + "/background.frag.spv");
+
+            background_pipeline = shader_reloader.add_pipeline({vertex, fragment}, [this](const std::vector<std::vector<uint32_t>>& code) {
+                VkPipelineVertexInputStateCreateInfo vertex_input{};
+                vertex_input.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+                return this->build_graphics_pipeline(code, background_layout, VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, vertex_input);
+            });
+
+            if (particle_count > 0)
+                this->create_particle_pipelines(spirv_dir, source_dir);
+
+            // Instances index their world matrix with the indirect draws' firstInstance.
+            if (mesh.is_valid() && device_capabilities.features.drawIndirectFirstInstance)
+                this->create_mesh_pipeline(spirv_dir, source_dir);
+            else if (mesh.is_valid())
+                std::cerr << "\nThe device lacks drawIndirectFirstInstance, the mesh is not drawn.\n";
+
+            // Rebuilds reuse the modules of the shaders that did not change; without
+            // them the modules are only needed until the pipelines exist.
+            if (shader_hot_reload)
+                shader_reloader.start_watching();
+            else
+                pipeline_cache.clear_shader_modules();
+        }
+
+        void Window::create_particle_pipelines(const std::string& spirv_dir, const std::string& source_dir)
+        {
+            ParticleSettings settings;
+            settings.count = particle_count;
+            particles.init(
+                device, allocator, descriptor_layouts, compute_queue,
+                queue_topology.compute_family.value(), queue_topology.graphics_family.value(),
+                queue_topology.has_separate_compute_queue(), frames_in_flight, settings);
+
+            VkPipelineLayoutCreateInfo layout_info{};
+            layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+
+            if (vkCreatePipelineLayout(device, &layout_info, nullptr, &particle_layout) != VK_SUCCESS)
+                throw std::runtime_error("\nFailed to create pipeline layout.");
+            particle_draw_pipeline = draw_queue.add_pipeline(VK_NULL_HANDLE, particle_layout);
+
+            auto source = [&](const char* name) { return source_dir.empty() ? std::string() : source_dir + "/" + name; };
+
+            ShaderReloader::ShaderHandle compute = shader_reloader.add_shader(source("particles.comp"), spirv_dir + "/particles.comp.spv");
+            ShaderReloader::ShaderHandle vertex = shader_reloader.add_shader(source("particles.vert"), spirv_dir + "/particles.vert.spv");
+            ShaderReloader::ShaderHandle fragment = shader_reloader.add_shader(source("particles.frag"), spirv_dir + "/particles.frag.spv");
+
+            particle_compute_pipeline = shader_reloader.add_pipeline({compute}, [this](const std::vector<std::vector<uint32_t>>& code) {
+                return particles.build_pipeline(code[0], pipeline_cache);
+            });
+
+            particle_render_pipeline = shader_reloader.add_pipeline({vertex, fragment}, [this](const std::vector<std::vector<uint32_t>>& code) {
+                // Position and life of each Particle, straight from the simulation's buffer.
+                VkVertexInputBindingDescription binding{0, sizeof(Particle), VK_VERTEX_INPUT_RATE_VERTEX};
+                VkVertexInputAttributeDescription attribute{0, 0, VK_FORMAT_R32G32B32A32_SFLOAT, 0};
+
+                VkPipelineVertexInputStateCreateInfo vertex_input{};
+                vertex_input.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+                vertex_input.vertexBindingDescriptionCount = 1;
+                vertex_input.pVertexBindingDescriptions = &binding;
+                vertex_input.vertexAttributeDescriptionCount = 1;
+                vertex_input.pVertexAttributeDescriptions = &attribute;
+
+                return this->build_graphics_pipeline(code, particle_layout, VK_PRIMITIVE_TOPOLOGY_POINT_LIST, vertex_input);
+            });
+        }
+
+        void Window::create_mesh_pipeline(const std::string& spirv_dir, const std::string& source_dir)
+        {
+            VkDescriptorSetLayoutBinding instances{0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_VERTEX_BIT, nullptr};
+            mesh_set_layout = descriptor_layouts.get_layout({instances});
+
+            VkPushConstantRange push_constant{VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(MeshConstants)};
+
+            std::vector<VkDescriptorSetLayout> set_layouts = {mesh_set_layout};
+            if (bindless.is_initialized())
+                set_layouts.push_back(bindless.get_layout());
+
+            VkPipelineLayoutCreateInfo layout_info{};
+            layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+            layout_info.setLayoutCount = static_cast<uint32_t>(set_layouts.size());
+            layout_info.pSetLayouts = set_layouts.data();
+            layout_info.pushConstantRangeCount = 1;
+            layout_info.pPushConstantRanges = &push_constant;
+
+            if (vkCreatePipelineLayout(device, &layout_info, nullptr, &mesh_layout) != VK_SUCCESS)
+                throw std::runtime_error("\nFailed to create pipeline layout.");
+
+            auto source = [&](const char* name) { return source_dir.empty() ? std::string() : source_dir + "/" + name; };
+
+            ShaderReloader::ShaderHandle vertex = shader_reloader.add_shader(source("mesh.vert"), spirv_dir + "/mesh.vert.spv");
+            const char* fragment_name = bindless.is_initialized() ? "mesh_textured.frag" : "mesh.frag";
+            ShaderReloader::ShaderHandle fragment = shader_reloader.add_shader(source(fragment_name), spirv_dir + "/" + fragment_name + ".spv");
+
+            mesh_pipeline = shader_reloader.add_pipeline({vertex, fragment}, [this](const std::vector<std::vector<uint32_t>>& code) {
+                Mesh::VertexInputDescription description = Mesh::get_vertex_input_description(mesh.quantized);
+
+                VkPipelineVertexInputStateCreateInfo vertex_input{};
+                vertex_input.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+                vertex_input.vertexBindingDescriptionCount = 1;
+                vertex_input.pVertexBindingDescriptions = &description.binding;
+                vertex_input.vertexAttributeDescriptionCount = static_cast<uint32_t>(description.attributes.size());
+                vertex_input.pVertexAttributeDescriptions = description.attributes.data();
+
+                return this->build_graphics_pipeline(code, mesh_layout, VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, vertex_input, true);
+            });
+        }
+
+        VkPipeline Window::build_graphics_pipeline(
+            const std::vector<std::vector<uint32_t>>& code,
+            VkPipelineLayout layout,
+            VkPrimitiveTopology topology,
+            const VkPipelineVertexInputStateCreateInfo& vertex_input,
+            bool depth)
+        {
+            // Runs on the shader watcher thread after a reload: the pipeline cache is thread-safe.
+            VkPipelineShaderStageCreateInfo stages[2]{};
+            stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+            stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+            stages[0].module = pipeline_cache.get_shader_module(code[0]);
+            stages[0].pName = "main";
+            stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+            stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+            stages[1].module = pipeline_cache.get_shader_module(code[1]);
+            stages[1].pName = "main";
+
+            VkPipelineInputAssemblyStateCreateInfo input_assembly{};
+            input_assembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+            input_assembly.topology = topology;
+
+            // Viewport and scissor are dynamic so a resize does not rebuild the pipeline.
+            VkPipelineViewportStateCreateInfo viewport_state{};
+            viewport_state.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+            viewport_state.viewportCount = 1;
+            viewport_state.scissorCount = 1;
+
+            VkDynamicState dynamic_states[] = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+            VkPipelineDynamicStateCreateInfo dynamic_state{};
+            dynamic_state.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+            dynamic_state.dynamicStateCount = 2;
+            dynamic_state.pDynamicStates = dynamic_states;
+
+            VkPipelineRasterizationStateCreateInfo rasterizer{};
+            rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+            rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+            rasterizer.cullMode = VK_CULL_MODE_NONE;
+            rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+            rasterizer.lineWidth = 1.0f;
+
+            VkPipelineMultisampleStateCreateInfo multisampling{};
+            multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+            multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+            // Without depth the background is drawn behind everything and particles over it.
+            VkPipelineDepthStencilStateCreateInfo depth_stencil{};
+            depth_stencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+            depth_stencil.depthTestEnable = depth ? VK_TRUE : VK_FALSE;
+            depth_stencil.depthWriteEnable = depth ? VK_TRUE : VK_FALSE;
+            depth_stencil.depthCompareOp = VK_COMPARE_OP_LESS;
+
+            VkPipelineColorBlendAttachmentState blend_attachment{};
+            blend_attachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+
+            VkPipelineColorBlendStateCreateInfo color_blend{};
+            color_blend.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+            color_blend.attachmentCount = 1;
+            color_blend.pAttachments = &blend_attachment;
+
+            VkGraphicsPipelineCreateInfo create_info{};
+            create_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+            create_info.stageCount = 2;
+            create_info.pStages = stages;
+            create_info.pVertexInputState = &vertex_input;
+            create_info.pInputAssemblyState = &input_assembly;
+            create_info.pViewportState = &viewport_state;
+            create_info.pRasterizationState = &rasterizer;
+            create_info.pMultisampleState = &multisampling;
+            create_info.pDepthStencilState = &depth_stencil;
+            create_info.pColorBlendState = &color_blend;
+            create_info.pDynamicState = &dynamic_state;
+            create_info.layout = layout;
+            create_info.renderPass = render_pass;
+            create_info.subpass = 0;
+
+            return pipeline_cache.create_graphics_pipeline(create_info);
+        }
+
+        void Window::init_frame_capture()
+        {
+            // Swapchains only allow copies out of their images when the surface supports it.
+            if (!headless)
+            {
+                VkSurfaceCapabilitiesKHR capabilities;
+                vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physical_device, surface, &capabilities);
+                if (!(capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT))
+                {
+                    std::cerr << "\nThe surface does not support transfers from swapchain images; frame capture is disabled.";
+                    return;
+                }
+            }
+
+            if (!FrameCapture::is_supported_format(swapchain_image_format))
+            {
+                std::cerr << "\nFrame capture does not support the backbuffer format " << swapchain_image_format << "; it is disabled.";
+                return;
+            }
+
+            frame_capture.init(device, allocator, capture_settings, frames_in_flight);
+        }
+
+        void Window::build_render_graph()
+        {
+            // Frames that are not captured skip the capture pass and its round trip
+            // of the backbuffer through TRANSFER_SRC.
+            this->build_render_graph(render_graph, false);
+            if (frame_capture.is_initialized())
+                this->build_render_graph(capture_render_graph, true);
+        }
+
+        void Window::build_render_graph(RenderGraph& graph, bool capture)
+        {
+            graph.init(device, allocator, frames_in_flight);
+
+            // The acquire semaphore is waited on at COLOR_ATTACHMENT_OUTPUT. Offscreen
+            // targets are left ready to be read back.
+            Graphics::ResourceState backbuffer_initial{VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0};
+            Graphics::ResourceState backbuffer_final = headless
+                ? Graphics::ResourceState{VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT}
+                : Graphics::ResourceState{VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0};
+            backbuffer_resource = graph.import_image("backbuffer", VK_IMAGE_ASPECT_COLOR_BIT, backbuffer_initial, backbuffer_final);
+
+            // The depth image is shared by every frame in flight, so the previous
+            // frame's depth writes must finish before this frame clears it.
+            Graphics::ResourceState depth_initial{VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT};
+            VkImageAspectFlags depth_aspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+            if (Utils::has_stencil_component(depth_format))
+                depth_aspect |= VK_IMAGE_ASPECT_STENCIL_BIT;
+            depth_resource = graph.import_image("depth", depth_aspect, depth_initial);
+
+            graph.add_pass("main_pass", [this](VkCommandBuffer command_buffer, const RenderGraph&) {
+                    // Cycle the clear color so consecutive frames are distinguishable in captures.
+                    float t = static_cast<float>(frame_number % 256) / 255.0f;
+
+                    VkClearValue clear_values[2]{};
+                    clear_values[0].color = {{t, 0.1f, 1.0f - t, 1.0f}};
+                    clear_values[1].depthStencil = {1.0f, 0};
+
+                    VkRenderPassBeginInfo render_pass_info{};
+                    render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+                    render_pass_info.renderPass = render_pass;
+                    render_pass_info.framebuffer = swapchain_framebuffers[current_image_index];
+                    render_pass_info.renderArea.offset = {0, 0};
+                    render_pass_info.renderArea.extent = swapchain_extent;
+                    render_pass_info.clearValueCount = 2;
+                    render_pass_info.pClearValues = clear_values;
+
+                    VkViewport viewport{0.0f, 0.0f, static_cast<float>(swapchain_extent.width), static_cast<float>(swapchain_extent.height), 0.0f, 1.0f};
+                    VkRect2D scissor{{0, 0}, swapchain_extent};
+
+                    VGE_PROFILE_GPU_SCOPE(gpu_profiler, command_buffer, "main_pass");
+
+                    // Secondaries inherit neither viewport nor scissor: every chunk sets its own.
+                    // The mesh instances follow the queued draws in a secondary of their own.
+                    if (recorder.is_initialized() && (draw_queue.size() > 0 || mesh_draw_count > 0))
+                    {
+                        VkCommandBufferInheritanceInfo inheritance{};
+                        inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+                        inheritance.renderPass = render_pass;
+                        inheritance.subpass = 0;
+                        inheritance.framebuffer = render_pass_info.framebuffer;
+
+                        std::vector<VkCommandBuffer> secondaries = recorder.record(current_frame, inheritance, static_cast<uint32_t>(draw_queue.size()),
+                            [&](VkCommandBuffer secondary, uint32_t first, uint32_t count) {
+                                vkCmdSetViewport(secondary, 0, 1, &viewport);
+                                vkCmdSetScissor(secondary, 0, 1, &scissor);
+                                draw_queue.record(secondary, first, count);
+                            });
+
+                        std::vector<VkCommandBuffer> mesh_secondaries = recorder.record(current_frame, inheritance, mesh_draw_count > 0 ? 1 : 0,
+                            [&](VkCommandBuffer secondary, uint32_t, uint32_t) {
+                                vkCmdSetViewport(secondary, 0, 1, &viewport);
+                                vkCmdSetScissor(secondary, 0, 1, &scissor);
+                                this->record_mesh_draws(secondary);
+                            }, 1);
+                        secondaries.insert(secondaries.end(), mesh_secondaries.begin(), mesh_secondaries.end());
+
+                        vkCmdBeginRenderPass(command_buffer, &render_pass_info, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+                        ParallelRecorder::execute(command_buffer, secondaries);
+                        vkCmdEndRenderPass(command_buffer);
+                        return;
+                    }
+
+                    vkCmdBeginRenderPass(command_buffer, &render_pass_info, VK_SUBPASS_CONTENTS_INLINE);
+
+                    if (draw_queue.size() > 0 || mesh_draw_count > 0)
+                    {
+                        vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+                        vkCmdSetScissor(command_buffer, 0, 1, &scissor);
+                        draw_queue.record(command_buffer);
+                        this->record_mesh_draws(command_buffer);
+                    }
+
+                    vkCmdEndRenderPass(command_buffer);
+                })
+                .write(backbuffer_resource, ResourceUsage::ColorAttachment)
+                .write(depth_resource, ResourceUsage::DepthStencilAttachment);
+
+            if (capture)
+                graph.add_pass("capture", [this](VkCommandBuffer command_buffer, const RenderGraph&) {
+                        VGE_PROFILE_GPU_SCOPE(gpu_profiler, command_buffer, "capture");
+                        frame_capture.record(command_buffer, swapchain_images[current_image_index], swapchain_extent, swapchain_image_format, frame_number);
+                    })
+                    .read(backbuffer_resource, ResourceUsage::TransferSource)
+                    .side_effect();
+
+            graph.compile();
+        }
+
+        void Window::create_framebuffers()
+        {
+            swapchain_framebuffers.resize(swapchain_image_views.size());
+
+            for (size_t i = 0; i < swapchain_image_views.size(); i++)
+            {
+                VkImageView attachments[] = {swapchain_image_views[i], depth_image_view};
+
+                VkFramebufferCreateInfo create_info{};
+                create_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+                create_info.renderPass = render_pass;
+                create_info.attachmentCount = 2;
+                create_info.pAttachments = attachments;
+                create_info.width = swapchain_extent.width;
+                create_info.height = swapchain_extent.height;
+                create_info.layers = 1;
+
+                if (vkCreateFramebuffer(device, &create_info, nullptr, &swapchain_framebuffers[i]) != VK_SUCCESS)
+                    throw std::runtime_error("\nFailed to create framebuffer.");
+            }
+        }
+
+        void Window::create_frame_resources()
+        {
+            frames.resize(frames_in_flight);
+            for (auto& frame : frames)
+                frame.create(device, queue_topology.graphics_family.value());
+
+            images_in_flight.assign(swapchain_images.size(), VK_NULL_HANDLE);
+        }
+
+        void Window::draw_frame()
+        {
+            VGE_PROFILE_SCOPE("draw_frame");
+
+            FrameResources& frame = frames[current_frame];
+
+            auto frame_start = std::chrono::steady_clock::now();
+            double frame_time_ms = std::chrono::duration<double, std::milli>(frame_start - last_frame_start).count();
+            last_frame_start = frame_start;
+
+            // Only the time blocked on fences counts: the CPU work of the frame
+            // in between is not waiting on the GPU.
+            double fence_wait_ms = 0.0;
+            {
+                VGE_PROFILE_SCOPE("wait_frame_fence");
+                vkWaitForFences(device, 1, &frame.in_flight_fence, VK_TRUE, UINT64_MAX);
+                fence_wait_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frame_start).count();
+            }
+
+            recorder.begin_frame(current_frame);
+
+            // Every frame up to the one that last used this slot has now completed.
+            if (frame_number >= frames_in_flight)
+            {
+                deletion_queue.flush(frame_number - frames_in_flight);
+                frame_capture.collect(frame_number - frames_in_flight);
+                uploader.retire_frames(frame_number - frames_in_flight);
+                bindless.retire_frames(frame_number - frames_in_flight);
+            }
+
+            // Pipelines rebuilt by the shader watcher are swapped in between frames; frames
+            // still in flight keep the old ones until they retire.
+            if (shader_hot_reload)
+            {
+                VkDevice device = this->device;
+                shader_reloader.apply([&](VkPipeline retired) {
+                    deletion_queue.push(frame_number, [device, retired]() { vkDestroyPipeline(device, retired, nullptr); });
+                });
+            }
+
+            // Completed mip uploads are swapped in before recording, and the demand
+            // gathered so far turns into this frame's loads and evictions.
+            if (!streaming_test_set.empty())
+                this->request_streaming_test_textures();
+            texture_streamer.update(frame_number);
+
+            // World matrices are final before anything reads them for this frame.
+            if (!scene_test_roots.empty())
+                this->animate_scene_test();
+            {
+                VGE_PROFILE_SCOPE("update_transforms");
+                transforms.update(scene, &jobs);
+            }
+
+            {
+                VGE_PROFILE_SCOPE("queue_draws");
+                this->queue_draws();
+            }
+
+            // Every set allocated the last time this slot was recorded is free again.
+            frame.descriptors.reset();
+            bindless.flush_updates();
+
+            {
+                VGE_PROFILE_SCOPE("prepare_mesh_draws");
+                this->prepare_mesh_draws(frame);
+            }
+
+            uint32_t image_index;
+            if (headless)
+                image_index = static_cast<uint32_t>(frame_number % swapchain_images.size());
+            else
+            {
+                VGE_PROFILE_SCOPE("acquire_image");
+                VkResult result = vkAcquireNextImageKHR(device, swapchain, UINT64_MAX, frame.image_available, VK_NULL_HANDLE, &image_index);
+
+                if (result == VK_ERROR_OUT_OF_DATE_KHR)
+                {
+                    this->recreate_swap_chain();
+                    return;
+                }
+                else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
+                    throw std::runtime_error("\nFailed to acquire swap chain image.");
+            }
+
+            // The image may still be used by an older frame when there are more frames in flight than images.
+            if (images_in_flight[image_index] != VK_NULL_HANDLE)
+            {
+                auto image_wait_start = std::chrono::steady_clock::now();
+                vkWaitForFences(device, 1, &images_in_flight[image_index], VK_TRUE, UINT64_MAX);
+                fence_wait_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - image_wait_start).count();
+            }
+            images_in_flight[image_index] = frame.in_flight_fence;
+
+            if (frame_number > 0)
+                frame_metrics.record(frame_number, fence_wait_ms, frame_time_ms);
+
+            vkResetFences(device, 1, &frame.in_flight_fence);
+
+            std::vector<VkSemaphore> wait_semaphores;
+            std::vector<VkPipelineStageFlags> wait_stages;
+            if (!headless)
+            {
+                wait_semaphores.push_back(frame.image_available);
+                wait_stages.push_back(VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+            }
+
+            std::vector<VkSemaphore> signal_semaphores;
+            if (!headless)
+                signal_semaphores.push_back(frame.render_finished);
+
+            // Uploads queued since the last frame go out before this frame's submission.
+            uploader.flush();
+
+            // The step runs on the compute queue while the previous frame is still drawing.
+            if (particles.is_initialized())
+            {
+                VGE_PROFILE_SCOPE("simulate_particles");
+                particles.simulate(shader_reloader.get_pipeline(particle_compute_pipeline), frame_number, wait_semaphores, wait_stages, signal_semaphores);
+            }
+
+            vkResetCommandPool(device, frame.command_pool, 0);
+            this->record_command_buffer(frame.command_buffer, image_index, wait_semaphores, wait_stages);
+
+            VkSubmitInfo submit_info{};
+            submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+            submit_info.commandBufferCount = 1;
+            submit_info.pCommandBuffers = &frame.command_buffer;
+            submit_info.waitSemaphoreCount = static_cast<uint32_t>(wait_semaphores.size());
+            submit_info.pWaitSemaphores = wait_semaphores.data();
+            submit_info.pWaitDstStageMask = wait_stages.data();
+
+            submit_info.signalSemaphoreCount = static_cast<uint32_t>(signal_semaphores.size());
+            submit_info.pSignalSemaphores = signal_semaphores.data();
+
+            {
+                VGE_PROFILE_SCOPE("submit");
+                if (vkQueueSubmit(graphics_queue, 1, &submit_info, frame.in_flight_fence) != VK_SUCCESS)
+                    throw std::runtime_error("\nFailed to submit draw command buffer.");
+            }
+
+            #ifdef VGE_ENABLE_PROFILING
+                gpu_profiler.end_frame();
+            #endif
+
+            bool swap_chain_stale = false;
+            if (!headless)
+            {
+                VGE_PROFILE_SCOPE("present");
+                VkPresentInfoKHR present_info{};
+                present_info.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+                present_info.waitSemaphoreCount = 1;
+                present_info.pWaitSemaphores = &frame.render_finished;
+                present_info.swapchainCount = 1;
+                present_info.pSwapchains = &swapchain;
+                present_info.pImageIndices = &image_index;
+
+                VkResult result = vkQueuePresentKHR(present_queue, &present_info);
+
+                if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || framebuffer_resized)
+                    swap_chain_stale = true;
+                else if (result != VK_SUCCESS)
+                    throw std::runtime_error("\nFailed to present swap chain image.");
+            }
+
+            current_frame = (current_frame + 1) % frames_in_flight;
+            frame_number++;
+
+            if (swap_chain_stale)
+                this->recreate_swap_chain();
+        }
+
+        void Window::record_command_buffer(
+            VkCommandBuffer command_buffer,
+            uint32_t image_index,
+            std::vector<VkSemaphore>& wait_semaphores,
+            std::vector<VkPipelineStageFlags>& wait_stages)
+        {
+            VGE_PROFILE_SCOPE("record_command_buffer");
+
+            VkCommandBufferBeginInfo begin_info{};
+            begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+            begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+            if (vkBeginCommandBuffer(command_buffer, &begin_info) != VK_SUCCESS)
+                throw std::runtime_error("\nFailed to begin recording command buffer.");
+
+            #ifdef VGE_ENABLE_PROFILING
+                gpu_profiler.begin_frame(command_buffer, current_frame, frame_number);
+                gpu_profiler.begin_region(command_buffer, "frame");
+            #endif
+
+            uploader.record_acquire_barriers(command_buffer, frame_number, wait_semaphores, wait_stages);
+            texture_streamer.record_copies(command_buffer);
+
+            current_image_index = image_index;
+            RenderGraph& graph = frame_capture.is_initialized() && frame_capture.should_capture(frame_number) ? capture_render_graph : render_graph;
+            graph.set_image(backbuffer_resource, swapchain_images[image_index], swapchain_image_views[image_index]);
+            graph.set_image(depth_resource, depth_image, depth_image_view);
+            graph.execute(command_buffer, current_frame);
+
+            #ifdef VGE_ENABLE_PROFILING
+                gpu_profiler.end_region(command_buffer);
+            #endif
+
+            if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS)
+                throw std::runtime_error("\nFailed to record command buffer.");
+        }
+
+        void Window::framebuffer_resize_callback(GLFWwindow* window, int /*width*/, int /*height*/)
+        {
+            #ifndef VGE_HEADLESS_ONLY
+                auto app = reinterpret_cast<Window*>(glfwGetWindowUserPointer(window));
+                app->framebuffer_resized = true;
+            #else
+                (void)window;
+            #endif
+        }
+
+        void Window::pick_physical_device()
+        {
+            Utils::DeviceRequirements requirements;
+            requirements.require_surface = !headless;
+            // Headless runs target render farm and CI nodes, which usually only
+            // expose a software rasterizer (lavapipe, SwiftShader).
+            requirements.allow_cpu = headless;
+            requirements.extensions = get_required_device_extensions();
+
+            Utils::DeviceCandidate selected = Utils::select_physical_device(instance, surface, requirements, preferred_device);
+
+            physical_device = selected.device;
+            queue_topology = selected.queues;
+            device_capabilities = selected.capabilities;
+
+            printf("\nSelected device '%s' (%s), queue families: graphics %u, present %s, compute %u%s, transfer %u%s\n",
+                selected.name.c_str(),
+                Utils::device_type_name(selected.type),
+                queue_topology.graphics_family.value(),
+                queue_topology.present_family.has_value() ? std::to_string(queue_topology.present_family.value()).c_str() : "none",
+                queue_topology.compute_family.value(),
+                queue_topology.has_async_compute() ? " (async)" : queue_topology.compute_queue_index > 0 ? " (second queue)" : "",
+                queue_topology.transfer_family.value(),
+                queue_topology.has_dedicated_transfer() ? " (dedicated)" : "");
+        }
+
+        void Window::create_logical_device()
+        {
+            std::vector<VkDeviceQueueCreateInfo> queue_create_infos;
+            std::vector<uint32_t> unique_queue_families = queue_topology.unique_families();
+
+            float queue_priorities[2] = {1.0f, 1.0f};
+            for (uint32_t queue_family : unique_queue_families)
+            {
+                // Compute without a family of its own gets a second queue of the graphics family when there is one.
+                bool second_queue = queue_family == queue_topology.compute_family && queue_topology.compute_queue_index > 0;
+
+                VkDeviceQueueCreateInfo queue_create_info{};
+                queue_create_info.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+                queue_create_info.queueFamilyIndex = queue_family;
+                queue_create_info.queueCount = second_queue ? 2 : 1;
+                queue_create_info.pQueuePriorities = queue_priorities;
+                queue_create_infos.push_back(queue_create_info);
+            }
+
+            VkPhysicalDeviceFeatures device_features{};
+
+            // GPU-driven draws: one indirect call for every visible object, each
+            // carrying its object index in firstInstance.
+            device_features.multiDrawIndirect = device_capabilities.features.multiDrawIndirect;
+            device_features.drawIndirectFirstInstance = device_capabilities.features.drawIndirectFirstInstance;
+
+            // Only the features the bindless table relies on.
+            VkPhysicalDeviceDescriptorIndexingFeaturesEXT indexing_features{};
+            indexing_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+            indexing_features.runtimeDescriptorArray = VK_TRUE;
+            indexing_features.descriptorBindingPartiallyBound = VK_TRUE;
+            indexing_features.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+            indexing_features.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+            indexing_features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+            indexing_features.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+            
+            VkDeviceCreateInfo create_info{};
+            create_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+            if (device_capabilities.supports_bindless())
+                create_info.pNext = &indexing_features;
+
+            create_info.queueCreateInfoCount = static_cast<uint32_t>(queue_create_infos.size());
+            create_info.pQueueCreateInfos = queue_create_infos.data();
+            
+            create_info.pEnabledFeatures = &device_features;
+            
+            auto extensions = get_required_device_extensions();
+            if (device_capabilities.supports_bindless())
+                extensions.push_back(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+            if (device_capabilities.memory_budget)
+                extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+            create_info.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+            create_info.ppEnabledExtensionNames = extensions.data();
+
+            if (enable_validation_layers)
+            {
+                create_info.enabledLayerCount = static_cast<uint32_t>(validation_layers.size());
+                create_info.ppEnabledLayerNames = validation_layers.data();
+            }
+            else
+            {
+                create_info.enabledLayerCount = 0;
+            }
+
+            if (vkCreateDevice(physical_device, &create_info, nullptr, &device))
+                throw std::runtime_error("\nFailed to create logical device.");
+
+            vkGetDeviceQueue(device, queue_topology.graphics_family.value(), 0, &graphics_queue);
+            vkGetDeviceQueue(device, queue_topology.compute_family.value(), queue_topology.compute_queue_index, &compute_queue);
+            vkGetDeviceQueue(device, queue_topology.transfer_family.value(), 0, &transfer_queue);
+            if (headless)
+                present_queue = graphics_queue;
+            else
+                vkGetDeviceQueue(device, queue_topology.present_family.value(), 0, &present_queue);
+        }
+
+        bool Window::check_validation_layer_support()
+        {
+            uint32_t layer_count;
+            vkEnumerateInstanceLayerProperties(&layer_count, nullptr);
+
+            std::vector<VkLayerProperties> available_layers(layer_count);
+            vkEnumerateInstanceLayerProperties(&layer_count, available_layers.data());
+
+            for (const char* layer_name : validation_layers)
+            {
+                bool layer_found = false;
+                for (const auto& layer_properties : available_layers)
+                    if (strcmp(layer_name, layer_properties.layerName) == 0)
+                    {
+                        layer_found = true;
+                        break;
+                    }
+                if (!layer_found)
+                    return false;
+            }
+            return true;
+        }
+
+        std::vector<const char*> Window::get_required_extensions()
+        {
+            std::vector<const char*> extensions;
+
+            #ifndef VGE_HEADLESS_ONLY
+                if (!headless)
+                {
+                    uint32_t glfwExtensionCount = 0;
+                    const char** glfwExtensions;
+
+                    glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+
+                    extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+                }
+            #endif
+
+            if (enable_validation_layers)
+                extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+
+            return extensions;
+        }
+
+        std::vector<const char*> Window::get_required_device_extensions()
+        {
+            // Offscreen rendering does not need VK_KHR_swapchain.
+            if (headless)
+                return {};
+
+            return Utils::device_extensions;
+        }
+
+        void Window::setup_debug_messenger()
+        {
+            if (!enable_validation_layers) return;
+
+            VkDebugUtilsMessengerCreateInfoEXT create_info{};
+            populate_debug_messenger_create_info(create_info);
+
+            if (create_debug_utils_messenger_ext(instance, &create_info, nullptr, &debug_messenger) != VK_SUCCESS)
+                throw std::runtime_error("\nFailed to setup debug messenger.");
+        }
+
+        void Window::populate_debug_messenger_create_info(VkDebugUtilsMessengerCreateInfoEXT& create_info)
+        {
+            create_info = {};
+            create_info.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT;
+            // Every severity is delivered; the sink filters at runtime before copying anything.
+            create_info.messageSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
+            create_info.messageType = VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT;
+            create_info.pfnUserCallback = debug_callback;
+            create_info.pUserData = &debug_sink;
+        }
+
+        void Window::destroy_debug_messenger(
+                    VkInstance instance,
+                    VkDebugUtilsMessengerEXT debug_messenger,
+                    const VkAllocationCallbacks* p_allocator)
+        {
+            auto func = (PFN_vkDestroyDebugUtilsMessengerEXT) vkGetInstanceProcAddr(instance, "vkDestroyDebugUtilsMessengerEXT");
+            if (func != nullptr)
+                func (instance, debug_messenger, p_allocator);
+        }
+
+        VkResult Window::create_debug_utils_messenger_ext(
+                    VkInstance instance, 
+                    const VkDebugUtilsMessengerCreateInfoEXT* p_create_info,
+                    const VkAllocationCallbacks* p_allocator,
+                    VkDebugUtilsMessengerEXT* p_debug_messenger)
+        {
+            auto func = (PFN_vkCreateDebugUtilsMessengerEXT) vkGetInstanceProcAddr(instance, "vkCreateDebugUtilsMessengerEXT");
+            if (func != nullptr)
+                return func(instance, p_create_info, p_allocator, p_debug_messenger);
+            else
+                return VK_ERROR_EXTENSION_NOT_PRESENT;
+        }
+
+        VKAPI_ATTR VkBool32 VKAPI_CALL Window::debug_callback(
+                    VkDebugUtilsMessageSeverityFlagBitsEXT message_severity,
+                    VkDebugUtilsMessageTypeFlagsEXT message_type,
+                    const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData,
+                    void* pUserData)
+        {
+            // Called on whichever thread made the Vulkan call: hand the message off and return.
+            static_cast<Utils::DebugMessageSink*>(pUserData)->submit(message_severity, message_type, pCallbackData);
+
+            return VK_FALSE;
+        }  
+    };
 }
\ No newline at end of file
@@ -1,136 +1,514 @@
-#pragma once
-/**
- * @author Simon Brisebois-Therrien
- * @since 2021-09-20 
- * 
- * 
- */
-
-#include <iostream>
-#include <string>
-#include <vector>
-#include <map>
-#include <set>
-
-#define VK_USE_PLATFORM_WIN32_KHR
-#define GLFW_INCLUDE_VULKAN
-#include <GLFW/glfw3.h>
-#define GLFW_EXPOSE_NATIVE_WIN32
-#include <GLFW/glfw3native.h>
-
-#include "../utils/queuefamily.hpp"
-#include "../utils/swapchain.hpp"
-
-
-
-namespace VulkanGameEngine 
-{
-    namespace Graphics
-    {
-        class Window
-        {
-            private:
-                /**
-                 * Class members.
-                 */
-                GLFWwindow* window;
-
-                VkInstance instance;
-
-                VkDebugUtilsMessengerEXT debug_messenger;
-
-                VkDevice device;
-
-                VkPhysicalDevice physical_device = VK_NULL_HANDLE;
-
-                VkQueue graphics_queue;
-                VkQueue present_queue;
-
-                VkSurfaceKHR surface;
-
-                VkSwapchainKHR swapchain;
-                std::vector<VkImage> swapchain_images;
-                VkFormat swapchain_image_format;
-                VkExtent2D swapchain_extent;
-                std::vector<VkImageView> swapchain_image_views;
-
-                /**
-                 * GLFW window properties.
-                 */
-                std::string window_title;
-                uint32_t w_Height;
-                uint32_t w_Width;
-
-                const std::vector<const char*> validation_layers = {
-                    "VK_LAYER_KHRONOS_validation"
-                };
-
-                #ifdef NDEBUG
-                    const bool enable_validation_layers = false;
-                #else
-                    const bool enable_validation_layers = true;
-                #endif
-
-                
-
-
-            public:
-                /**
-                 * Public methods.
-                 */
-                Window(std::string window_title = "Default window name.", uint32_t width = 800, uint32_t height = 600);
-
-            private:
-                /**
-                 * Private methods.
-                 */
-                void init_Window();
-
-                void init_vulkan();
-
-                void main_loop();
-
-                void cleanup();
-
-                void create_instance();
-
-                void create_surface();
-
-                void create_swap_chain();
-
-                void create_image_views();
-
-                void pick_physical_device();
-
-                bool is_device_suitable(VkPhysicalDevice device);
-
-                void create_logical_device();
-
-                bool check_validation_layer_support();
-
-                std::vector<const char*> get_required_extensions();
-
-                void setup_debug_messenger();
-
-                void populate_debug_messenger_create_info(VkDebugUtilsMessengerCreateInfoEXT& create_info);
-
-                void destroy_debug_messenger(
-                    VkInstance instance,
-                    VkDebugUtilsMessengerEXT debug_messenger,
-                    const VkAllocationCallbacks* p_allocator);
-
-                VkResult create_debug_utils_messenger_ext(
-                    VkInstance instance, 
-                    const VkDebugUtilsMessengerCreateInfoEXT* p_create_info,
-                    const VkAllocationCallbacks* p_allocator,
-                    VkDebugUtilsMessengerEXT* p_debug_messenger);
-
-                static VKAPI_ATTR VkBool32 VKAPI_CALL debug_callback(
-                    VkDebugUtilsMessageSeverityFlagBitsEXT message_severity,
-                    VkDebugUtilsMessageTypeFlagsEXT message_type,
-                    const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData,
-                    void* pUserData);
-
-        };
-    }
+#pragma once
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-09-20 
+ * 
+ * 
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <chrono>
+#include <cmath>
+#include <cfloat>
+#include <cstring>
+
+#include "../utils/platform.hpp"
+
+#include "../utils/queuefamily.hpp"
+#include "../utils/swapchain.hpp"
+#include "../utils/image.hpp"
+#include "../utils/device_selector.hpp"
+#include "../utils/device_capabilities.hpp"
+#include "../utils/startup_report.hpp"
+#include "../utils/debug_sink.hpp"
+#include "../memory/allocator.hpp"
+
+#include "frame.hpp"
+#include "frame_pacer.hpp"
+#include "deletion_queue.hpp"
+#include "uploader.hpp"
+#include "pipeline_cache.hpp"
+#include "parallel_recorder.hpp"
+#include "render_graph.hpp"
+#include "descriptors.hpp"
+#include "shader_reloader.hpp"
+#include "texture_streamer.hpp"
+#include "draw_queue.hpp"
+#include "particle_simulation.hpp"
+#include "frame_capture.hpp"
+#include "visibility.hpp"
+#include "indirect_draw_buffer.hpp"
+#include "../mesh/gpu_mesh.hpp"
+#include "../mesh/obj_loader.hpp"
+#include "../scene/world.hpp"
+#include "../scene/transform.hpp"
+#include "../math/batch.hpp"
+#include "../profiling/gpu_profiler.hpp"
+
+
+
+namespace VulkanGameEngine 
+{
+    namespace Graphics
+    {
+        /**
+         * Construction parameters of a Window.
+         * In headless mode no GLFW window, surface or swapchain is created;
+         * frames are rendered into offscreen images for a fixed number of frames.
+         */
+        struct WindowSettings
+        {
+            std::string title = "Default window name.";
+            uint32_t width = 800;
+            uint32_t height = 600;
+
+            bool headless = false;
+            uint32_t headless_frame_count = 1000;
+
+            uint32_t frames_in_flight = 2;
+
+            // Present mode, swapchain image count and CPU pacing.
+            Utils::PresentPolicy present_policy = Utils::PresentPolicy::MaxThroughput;
+
+            // Frame rate cap; 0 is uncapped, except power-saving which then caps at 30.
+            double target_fps = 0.0;
+
+            // Job system workers, the main thread included; 0 uses every hardware thread.
+            uint32_t worker_threads = 0;
+
+            // Record the main pass draws into secondary command buffers across the job system workers.
+            bool parallel_recording = false;
+
+            // Device index or name substring; the VGE_DEVICE environment variable overrides it.
+            std::string preferred_device;
+
+            // Empty disables the on-disk pipeline cache.
+            std::string pipeline_cache_path = "pipeline_cache.bin";
+
+            // JSON startup report; empty only prints it.
+            std::string startup_report_path;
+
+            // Chrome trace written at exit when profiling is compiled in; empty disables it.
+            std::string trace_path;
+
+            // Recompile edited shaders in the background and swap their pipelines in.
+            bool shader_hot_reload = false;
+
+            // Streamed texture budget; 0 uses half of the device local heap.
+            uint32_t texture_budget_mb = 0;
+
+            // Synthetic streaming workload: this many procedural textures requested
+            // by a camera sweeping over them.
+            uint32_t streaming_test_textures = 0;
+
+            // Mesh uploaded at startup: a .vgem file, or an .obj processed on load.
+            std::string mesh_path;
+            // When set, mesh_path is the path of a .vgem asset in this pack.
+            std::string mesh_pack_path;
+
+            // Synthetic scene: this many transform entities in a forest of small
+            // hierarchies, a few of whose roots move every frame.
+            uint32_t scene_test_entities = 0;
+
+            // GPU particle simulation on the compute queue; 0 disables it.
+            uint32_t particle_count = 0;
+
+            // Compare the particles with the CPU reference after the run; a mismatch fails it.
+            bool verify_particles = false;
+
+            // Readback of the rendered frames to PNG or Y4M files, and comparison with
+            // golden images; a golden mismatch fails the run.
+            CaptureSettings capture;
+
+            // Validation messages below this severity, or with one of these IDs, are ignored.
+            VkDebugUtilsMessageSeverityFlagBitsEXT debug_severity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT;
+            std::vector<int32_t> debug_muted_ids;
+        };
+
+        class Window
+        {
+            private:
+                /**
+                 * Class members.
+                 */
+                GLFWwindow* window;
+
+                VkInstance instance;
+
+                VkDebugUtilsMessengerEXT debug_messenger;
+                Utils::DebugMessageSink debug_sink;
+
+                VkDevice device;
+
+                VkPhysicalDevice physical_device = VK_NULL_HANDLE;
+
+                VkQueue graphics_queue;
+                VkQueue present_queue;
+                VkQueue compute_queue;
+                VkQueue transfer_queue;
+
+                Utils::QueueTopology queue_topology;
+                Utils::DeviceCapabilities device_capabilities;
+                std::string preferred_device;
+                std::string pipeline_cache_path;
+
+                Jobs::JobSystem jobs;
+                uint32_t worker_threads;
+
+                Utils::StartupReport startup_report;
+                std::string startup_report_path;
+
+                VkSurfaceKHR surface = VK_NULL_HANDLE;
+
+                VkSwapchainKHR swapchain = VK_NULL_HANDLE;
+                std::vector<VkImage> swapchain_images;
+                VkFormat swapchain_image_format;
+                VkExtent2D swapchain_extent;
+                std::vector<VkImageView> swapchain_image_views;
+
+                /**
+                 * Headless offscreen targets.
+                 * The color images are stored in swapchain_images so the rest
+                 * of the renderer does not care which backend is in use.
+                 */
+                std::vector<Memory::Allocation> offscreen_image_allocations;
+
+                VkImage depth_image = VK_NULL_HANDLE;
+                Memory::Allocation depth_image_allocation;
+                VkImageView depth_image_view = VK_NULL_HANDLE;
+                VkFormat depth_format;
+
+                VkRenderPass render_pass;
+                std::vector<VkFramebuffer> swapchain_framebuffers;
+
+                /**
+                 * Frame render graph. The swapchain (or offscreen) image and the depth
+                 * image are imported and rebound every frame. The capture graph adds
+                 * the capture pass and replaces it on the frames frame_capture copies;
+                 * both import the same resources in the same order.
+                 */
+                RenderGraph render_graph;
+                RenderGraph capture_render_graph;
+                RenderResource backbuffer_resource = invalid_render_resource;
+                RenderResource depth_resource = invalid_render_resource;
+                uint32_t current_image_index = 0;
+
+                /**
+                 * Frames in flight.
+                 * images_in_flight holds the fence of the frame currently using each image.
+                 */
+                uint32_t frames_in_flight;
+                std::vector<FrameResources> frames;
+                std::vector<VkFence> images_in_flight;
+                uint32_t current_frame = 0;
+                uint64_t frame_number = 0;
+
+                bool parallel_recording;
+                ParallelRecorder recorder;
+
+                FrameMetrics frame_metrics;
+
+                Utils::PresentPolicy present_policy;
+                VkPresentModeKHR present_mode = VK_PRESENT_MODE_FIFO_KHR;
+                FramePacer frame_pacer;
+                std::chrono::steady_clock::time_point last_frame_start;
+
+                /**
+                 * Objects retired by swapchain recreation, destroyed once
+                 * the frames using them have completed.
+                 */
+                DeletionQueue deletion_queue;
+                bool framebuffer_resized = false;
+
+                /**
+                 * Device memory sub-allocator, and staging uploads on the transfer queue.
+                 */
+                Memory::MemoryAllocator allocator;
+                Uploader uploader;
+
+                PipelineCache pipeline_cache;
+
+                /**
+                 * Pipelines built from the SPIR-V compiled by the build, rebuilt on
+                 * shader edits when hot reload is on.
+                 */
+                ShaderReloader shader_reloader;
+                bool shader_hot_reload;
+                VkPipelineLayout background_layout = VK_NULL_HANDLE;
+                ShaderReloader::PipelineHandle background_pipeline = ShaderReloader::invalid_handle;
+
+                /**
+                 * Draws of the main pass, sorted by state before recording.
+                 */
+                DrawQueue draw_queue;
+                uint32_t background_draw_pipeline = 0;
+
+                /**
+                 * Particles simulated on the compute queue, overlapped with the graphics
+                 * work of the previous frame, and drawn as points.
+                 */
+                ParticleSimulation particles;
+                uint32_t particle_count;
+                bool verify_particles;
+                bool particle_verification_failed = false;
+                ShaderReloader::PipelineHandle particle_compute_pipeline = ShaderReloader::invalid_handle;
+                ShaderReloader::PipelineHandle particle_render_pipeline = ShaderReloader::invalid_handle;
+                VkPipelineLayout particle_layout = VK_NULL_HANDLE;
+                uint32_t particle_draw_pipeline = 0;
+
+                /**
+                 * Frames copied back to the host and written or compared on a writer thread.
+                 */
+                FrameCapture frame_capture;
+                CaptureSettings capture_settings;
+                bool capture_failed = false;
+
+                /**
+                 * Shared descriptor set layouts, and the bindless table when the device
+                 * supports descriptor indexing. Per-frame sets come from FrameResources.
+                 */
+                DescriptorLayoutCache descriptor_layouts;
+                BindlessTable bindless;
+
+                /**
+                 * Mip streaming under a VRAM budget, and the synthetic workload driving it.
+                 */
+                TextureStreamer texture_streamer;
+                uint32_t texture_budget_mb;
+                uint32_t streaming_test_textures;
+                std::vector<StreamedTexture> streaming_test_set;
+
+                /**
+                 * Optimized mesh in device local vertex, index and meshlet buffers.
+                 */
+                std::string mesh_path;
+                std::string mesh_pack_path;
+                Mesh::GpuMesh mesh;
+
+                /**
+                 * One instance of the mesh per transform entity, culled against the
+                 * camera frustum every frame; the visible ones are drawn from the
+                 * frame's indirect buffer. The camera and the world matrices are in a
+                 * storage buffer per frame in flight, bound through a set allocated
+                 * from the frame's descriptor allocator. With a bindless table, the
+                 * table is bound at set 1 and the mesh samples a streamed texture.
+                 */
+                struct MeshConstants
+                {
+                    uint32_t quantized;
+                    uint32_t texture_index;
+                    float uv_offset[2];
+                    float uv_scale[2];
+                };
+
+                VkDescriptorSetLayout mesh_set_layout = VK_NULL_HANDLE;
+                VkPipelineLayout mesh_layout = VK_NULL_HANDLE;
+                ShaderReloader::PipelineHandle mesh_pipeline = ShaderReloader::invalid_handle;
+                VisibilitySystem visibility;
+                IndirectDrawBuffer indirect_draws;
+                std::vector<Scene::Entity> mesh_instances;
+                std::vector<VisibilityObject> mesh_objects;
+                std::vector<Math::Mat4> mesh_instance_matrices;
+                std::vector<Math::Sphere> mesh_local_bounds;
+                std::vector<Math::Sphere> mesh_world_bounds;
+                std::vector<uint32_t> mesh_visible;
+                std::vector<VkBuffer> mesh_instance_buffers;
+                std::vector<Memory::Allocation> mesh_instance_allocations;
+                VkDescriptorSet mesh_instance_set = VK_NULL_HANDLE;
+                uint32_t mesh_draw_count = 0;
+                // The camera orbits this sphere around the instances.
+                Math::Sphere mesh_view_bounds;
+
+                /**
+                 * Entities and their transform hierarchy, propagated every frame.
+                 */
+                Scene::World scene;
+                Scene::TransformSystem transforms;
+                uint32_t scene_test_entities;
+                std::vector<Scene::Entity> scene_test_roots;
+
+                #ifdef VGE_ENABLE_PROFILING
+                    Profiling::GpuProfiler gpu_profiler;
+                    std::chrono::steady_clock::time_point last_overlay_update;
+                #endif
+                std::string trace_path;
+
+                /**
+                 * GLFW window properties.
+                 */
+                std::string window_title;
+                uint32_t w_Height;
+                uint32_t w_Width;
+
+                bool headless;
+                uint32_t headless_frame_count;
+
+                const std::vector<const char*> validation_layers = {
+                    "VK_LAYER_KHRONOS_validation"
+                };
+
+                #ifdef NDEBUG
+                    const bool enable_validation_layers = false;
+                #else
+                    const bool enable_validation_layers = true;
+                #endif
+
+                
+
+
+            public:
+                /**
+                 * Public methods.
+                 */
+                Window(std::string window_title = "Default window name.", uint32_t width = 800, uint32_t height = 600);
+
+                Window(const WindowSettings& settings);
+
+                const FrameMetrics& get_frame_metrics() const { return frame_metrics; }
+
+                Uploader& get_uploader() { return uploader; }
+
+            private:
+                /**
+                 * Private methods.
+                 */
+                void init_Window();
+
+                void init_vulkan();
+
+                void write_startup_report();
+
+                void print_descriptor_statistics();
+
+                void init_texture_streaming();
+
+                void request_streaming_test_textures();
+
+                void load_mesh();
+
+                void create_scene_test();
+
+                void create_mesh_instances();
+
+                /**
+                 * Culls the mesh instances for this frame and fills the frame's
+                 * indirect and instance buffers. After the frame's descriptors are reset.
+                 */
+                void prepare_mesh_draws(FrameResources& frame);
+
+                /**
+                 * Inside the main pass, viewport and scissor set.
+                 */
+                void record_mesh_draws(VkCommandBuffer command_buffer);
+
+                void queue_draws();
+
+                void animate_scene_test();
+
+                #ifdef VGE_ENABLE_PROFILING
+                    void update_profiler_overlay();
+                #endif
+
+                void main_loop();
+
+                /**
+                 * Called before input is polled: frame rate cap, and with the low-latency
+                 * policy, wait for the GPU to finish the previous frame.
+                 */
+                void pace_frame();
+
+                void cleanup();
+
+                void create_instance();
+
+                void create_surface();
+
+                void create_swap_chain();
+
+                void create_image_views();
+
+                void recreate_swap_chain();
+
+                void retire_swap_chain_resources();
+
+                void create_offscreen_targets();
+
+                void create_depth_resources();
+
+                void create_render_pass();
+
+                void create_pipelines();
+
+                void create_particle_pipelines(const std::string& spirv_dir, const std::string& source_dir);
+
+                void create_mesh_pipeline(const std::string& spirv_dir, const std::string& source_dir);
+
+                /**
+                 * Vertex and fragment shaders drawn into the main pass, depth tested
+                 * and written when depth is set.
+                 */
+                VkPipeline build_graphics_pipeline(
+                    const std::vector<std::vector<uint32_t>>& code,
+                    VkPipelineLayout layout,
+                    VkPrimitiveTopology topology,
+                    const VkPipelineVertexInputStateCreateInfo& vertex_input,
+                    bool depth = false);
+
+                void create_framebuffers();
+
+                void create_frame_resources();
+
+                void init_frame_capture();
+
+                void build_render_graph();
+
+                void build_render_graph(RenderGraph& graph, bool capture);
+
+                void draw_frame();
+
+                void record_command_buffer(
+                    VkCommandBuffer command_buffer,
+                    uint32_t image_index,
+                    std::vector<VkSemaphore>& wait_semaphores,
+                    std::vector<VkPipelineStageFlags>& wait_stages);
+
+                static void framebuffer_resize_callback(GLFWwindow* window, int width, int height);
+
+                void pick_physical_device();
+
+                void create_logical_device();
+
+                bool check_validation_layer_support();
+
+                std::vector<const char*> get_required_extensions();
+
+                std::vector<const char*> get_required_device_extensions();
+
+                void setup_debug_messenger();
+
+                void populate_debug_messenger_create_info(VkDebugUtilsMessengerCreateInfoEXT& create_info);
+
+                void destroy_debug_messenger(
+                    VkInstance instance,
+                    VkDebugUtilsMessengerEXT debug_messenger,
+                    const VkAllocationCallbacks* p_allocator);
+
+                VkResult create_debug_utils_messenger_ext(
+                    VkInstance instance, 
+                    const VkDebugUtilsMessengerCreateInfoEXT* p_create_info,
+                    const VkAllocationCallbacks* p_allocator,
+                    VkDebugUtilsMessengerEXT* p_debug_messenger);
+
+                static VKAPI_ATTR VkBool32 VKAPI_CALL debug_callback(
+                    VkDebugUtilsMessageSeverityFlagBitsEXT message_severity,
+                    VkDebugUtilsMessageTypeFlagsEXT message_type,
+                    const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData,
+                    void* pUserData);
+
+        };
+    }
 }
\ No newline at end of file
@@ -0,0 +1,479 @@
+#include "job_system.hpp"
+#include "../profiling/profiler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <cstdio>
+
+namespace VulkanGameEngine
+{
+    namespace Jobs
+    {
+        static thread_local const JobSystem* current_system = nullptr;
+        static thread_local int32_t current_index = -1;
+
+        static uint64_t clock_ns()
+        {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+        }
+
+        static uint32_t next_random(uint32_t& state)
+        {
+            // xorshift32
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            return state;
+        }
+
+        void JobSystem::init(uint32_t worker_count)
+        {
+            if (worker_count == 0)
+                worker_count = std::max(1u, std::thread::hardware_concurrency());
+
+            stopping.store(false);
+            main_thread_id = std::this_thread::get_id();
+
+            workers.clear();
+            for (uint32_t i = 0; i < worker_count; i++)
+            {
+                workers.emplace_back(new Worker());
+                workers.back()->random_state = i * 2654435761u + 1u;
+            }
+
+            current_system = this;
+            current_index = 0;
+
+            for (uint32_t i = 1; i < worker_count; i++)
+                threads.emplace_back(&JobSystem::worker_loop, this, i);
+        }
+
+        void JobSystem::cleanup()
+        {
+            if (workers.empty())
+                return;
+
+            {
+                std::lock_guard<std::mutex> lock(sleep_mutex);
+                stopping.store(true);
+            }
+            wake_condition.notify_all();
+
+            for (auto& thread : threads)
+                thread.join();
+            threads.clear();
+
+            // Nothing runs anymore: drop whatever is left.
+            for (auto& worker : workers)
+            {
+                Job* job;
+                while (worker->deque.pop(job))
+                    delete job;
+            }
+            for (Job* job : injection_queue)
+                delete job;
+            for (Job* job : main_thread_queue)
+                delete job;
+            injection_queue.clear();
+            main_thread_queue.clear();
+            injection_size.store(0);
+            queued_jobs.store(0);
+
+            workers.clear();
+
+            if (current_system == this)
+            {
+                current_system = nullptr;
+                current_index = -1;
+            }
+        }
+
+        int32_t JobSystem::current_worker() const
+        {
+            return current_system == this ? current_index : -1;
+        }
+
+        void JobSystem::run(JobFunction function, JobCounter* counter)
+        {
+            if (counter)
+                counter->value.fetch_add(1, std::memory_order_relaxed);
+
+            schedule(make_job(std::move(function), counter));
+        }
+
+        void JobSystem::run_after(JobCounter& dependency, JobFunction function, JobCounter* counter)
+        {
+            if (counter)
+                counter->value.fetch_add(1, std::memory_order_relaxed);
+
+            Job* job = make_job(std::move(function), counter);
+            {
+                std::lock_guard<std::mutex> lock(dependency.mutex);
+                if (!dependency.is_done())
+                {
+                    dependency.continuations.push_back(job);
+                    return;
+                }
+            }
+
+            schedule(job);
+        }
+
+        void JobSystem::run_on_main_thread(JobFunction function, JobCounter* counter)
+        {
+            if (counter)
+                counter->value.fetch_add(1, std::memory_order_relaxed);
+
+            std::lock_guard<std::mutex> lock(main_thread_mutex);
+            main_thread_queue.push_back(make_job(std::move(function), counter));
+        }
+
+        void JobSystem::wait(JobCounter& counter)
+        {
+            int32_t index = current_worker();
+            bool main_thread = is_main_thread();
+
+            uint32_t spins = 0;
+            while (!counter.is_done() || counter.finishing.load(std::memory_order_acquire) != 0)
+            {
+                Job* job = main_thread ? pop_main_thread_job() : nullptr;
+                if (!job)
+                    job = find_job(index);
+
+                if (job)
+                {
+                    execute(job, index);
+                    spins = 0;
+                }
+                else if (++spins > spin_count)
+                    std::this_thread::yield();
+            }
+
+            std::exception_ptr error;
+            {
+                std::lock_guard<std::mutex> lock(counter.mutex);
+                std::swap(error, counter.error);
+            }
+
+            if (error)
+                std::rethrow_exception(error);
+        }
+
+        void JobSystem::pump_main_thread()
+        {
+            int32_t index = current_worker();
+            while (Job* job = pop_main_thread_job())
+                execute(job, index);
+        }
+
+        void JobSystem::parallel_for(uint32_t count, uint32_t grain, const RangeFunction& function)
+        {
+            if (count == 0)
+                return;
+
+            grain = std::max(1u, grain);
+
+            // A few chunks per worker leave room for stealing to even out uneven items.
+            uint32_t chunk_count = (count + grain - 1) / grain;
+            chunk_count = std::min(chunk_count, std::max(1u, get_worker_count()) * 4);
+
+            if (chunk_count == 1)
+            {
+                function(0, count);
+                return;
+            }
+
+            JobCounter counter;
+            for (uint32_t chunk = 1; chunk < chunk_count; chunk++)
+            {
+                uint32_t first = static_cast<uint32_t>(static_cast<uint64_t>(count) * chunk / chunk_count);
+                uint32_t last = static_cast<uint32_t>(static_cast<uint64_t>(count) * (chunk + 1) / chunk_count);
+                run([&function, first, last]() { function(first, last); }, &counter);
+            }
+
+            // The chunks reference function: always wait for them before leaving.
+            std::exception_ptr error;
+            try
+            {
+                function(0, static_cast<uint32_t>(static_cast<uint64_t>(count) / chunk_count));
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+
+            try
+            {
+                wait(counter);
+            }
+            catch (...)
+            {
+                if (!error)
+                    error = std::current_exception();
+            }
+
+            if (error)
+                std::rethrow_exception(error);
+        }
+
+        std::vector<JobSystem::WorkerStatistics> JobSystem::get_statistics() const
+        {
+            std::vector<WorkerStatistics> statistics;
+            for (auto& worker : workers)
+            {
+                WorkerStatistics entry;
+                entry.jobs_executed = worker->jobs_executed.load(std::memory_order_relaxed);
+                entry.steals = worker->steals.load(std::memory_order_relaxed);
+                entry.steal_attempts = worker->steal_attempts.load(std::memory_order_relaxed);
+                entry.busy_ms = worker->busy_ns.load(std::memory_order_relaxed) / 1e6;
+                entry.idle_ms = worker->idle_ns.load(std::memory_order_relaxed) / 1e6;
+                statistics.push_back(entry);
+            }
+            return statistics;
+        }
+
+        void JobSystem::reset_statistics()
+        {
+            for (auto& worker : workers)
+            {
+                worker->jobs_executed.store(0, std::memory_order_relaxed);
+                worker->steals.store(0, std::memory_order_relaxed);
+                worker->steal_attempts.store(0, std::memory_order_relaxed);
+                worker->busy_ns.store(0, std::memory_order_relaxed);
+                worker->idle_ns.store(0, std::memory_order_relaxed);
+            }
+        }
+
+        void JobSystem::print_statistics(std::ostream& out) const
+        {
+            std::vector<WorkerStatistics> statistics = get_statistics();
+
+            out << "Job system: " << statistics.size() << " workers\n";
+            for (size_t i = 0; i < statistics.size(); i++)
+            {
+                const WorkerStatistics& entry = statistics[i];
+
+                char line[256];
+                snprintf(line, sizeof(line),
+                    "  worker %2zu%s: %10llu jobs, steals %llu / %llu attempts, busy %.1f ms, idle %.1f ms\n",
+                    i,
+                    i == 0 ? " (main)" : "       ",
+                    static_cast<unsigned long long>(entry.jobs_executed),
+                    static_cast<unsigned long long>(entry.steals),
+                    static_cast<unsigned long long>(entry.steal_attempts),
+                    entry.busy_ms,
+                    entry.idle_ms);
+                out << line;
+            }
+        }
+
+        void JobSystem::worker_loop(uint32_t index)
+        {
+            VGE_PROFILE_THREAD("Worker " + std::to_string(index));
+
+            current_system = this;
+            current_index = static_cast<int32_t>(index);
+
+            Worker& worker = *workers[index];
+            uint64_t idle_start = clock_ns();
+            uint32_t spins = 0;
+
+            while (!stopping.load(std::memory_order_acquire))
+            {
+                if (Job* job = find_job(static_cast<int32_t>(index)))
+                {
+                    uint64_t start = clock_ns();
+                    worker.idle_ns.fetch_add(start - idle_start, std::memory_order_relaxed);
+
+                    execute(job, static_cast<int32_t>(index));
+
+                    idle_start = clock_ns();
+                    worker.busy_ns.fetch_add(idle_start - start, std::memory_order_relaxed);
+                    spins = 0;
+                    continue;
+                }
+
+                if (++spins < spin_count)
+                {
+                    std::this_thread::yield();
+                    continue;
+                }
+                spins = 0;
+
+                std::unique_lock<std::mutex> lock(sleep_mutex);
+                sleeping_workers.fetch_add(1);
+                wake_condition.wait(lock, [this]() { return stopping.load() || queued_jobs.load() > 0; });
+                sleeping_workers.fetch_sub(1);
+            }
+
+            worker.idle_ns.fetch_add(clock_ns() - idle_start, std::memory_order_relaxed);
+
+            current_system = nullptr;
+            current_index = -1;
+        }
+
+        void JobSystem::schedule(Job* job)
+        {
+            int32_t index = current_worker();
+            if (index >= 0)
+                workers[index]->deque.push(job);
+            else
+            {
+                std::lock_guard<std::mutex> lock(injection_mutex);
+                injection_queue.push_back(job);
+                injection_size.fetch_add(1, std::memory_order_release);
+            }
+
+            // Counted after the push: a worker woken by the count must be able to find the job.
+            queued_jobs.fetch_add(1);
+            wake_workers();
+        }
+
+        Job* JobSystem::find_job(int32_t index)
+        {
+            Job* job = nullptr;
+
+            if (index >= 0 && workers[index]->deque.pop(job))
+            {
+                queued_jobs.fetch_sub(1);
+                return job;
+            }
+
+            if (injection_size.load(std::memory_order_acquire) > 0)
+            {
+                std::lock_guard<std::mutex> lock(injection_mutex);
+                if (!injection_queue.empty())
+                {
+                    job = injection_queue.front();
+                    injection_queue.pop_front();
+                    injection_size.fetch_sub(1, std::memory_order_relaxed);
+                    queued_jobs.fetch_sub(1);
+                    return job;
+                }
+            }
+
+            return steal_job(index);
+        }
+
+        Job* JobSystem::steal_job(int32_t thief)
+        {
+            uint32_t count = static_cast<uint32_t>(workers.size());
+            uint32_t start = thief >= 0 ? next_random(workers[thief]->random_state) % count : 0;
+
+            for (uint32_t i = 0; i < count; i++)
+            {
+                uint32_t victim = (start + i) % count;
+                if (static_cast<int32_t>(victim) == thief || workers[victim]->deque.empty())
+                    continue;
+
+                Job* job;
+                bool stolen = workers[victim]->deque.steal(job);
+
+                if (thief >= 0)
+                {
+                    workers[thief]->steal_attempts.fetch_add(1, std::memory_order_relaxed);
+                    if (stolen)
+                        workers[thief]->steals.fetch_add(1, std::memory_order_relaxed);
+                }
+
+                if (stolen)
+                {
+                    queued_jobs.fetch_sub(1);
+                    return job;
+                }
+            }
+
+            return nullptr;
+        }
+
+        Job* JobSystem::pop_main_thread_job()
+        {
+            std::lock_guard<std::mutex> lock(main_thread_mutex);
+            if (main_thread_queue.empty())
+                return nullptr;
+
+            Job* job = main_thread_queue.front();
+            main_thread_queue.pop_front();
+            return job;
+        }
+
+        void JobSystem::execute(Job* job, int32_t index)
+        {
+            try
+            {
+                job->function();
+            }
+            catch (...)
+            {
+                if (job->counter)
+                {
+                    std::lock_guard<std::mutex> lock(job->counter->mutex);
+                    if (!job->counter->error)
+                        job->counter->error = std::current_exception();
+                }
+                else
+                {
+                    try
+                    {
+                        throw;
+                    }
+                    catch (const std::exception& e)
+                    {
+                        std::cerr << "\nUnhandled exception in job: " << e.what() << '\n';
+                    }
+                    catch (...)
+                    {
+                        std::cerr << "\nUnhandled exception in job.\n";
+                    }
+                }
+            }
+
+            if (job->counter)
+                finish(*job->counter);
+            delete job;
+
+            if (index >= 0)
+                workers[index]->jobs_executed.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void JobSystem::finish(JobCounter& counter)
+        {
+            // wait() returns only once finishing is back to zero, so the counter
+            // outlives everything below even when its owner is about to destroy it.
+            counter.finishing.fetch_add(1, std::memory_order_acq_rel);
+
+            std::vector<Job*> ready;
+            if (counter.value.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                std::lock_guard<std::mutex> lock(counter.mutex);
+                ready.swap(counter.continuations);
+            }
+
+            counter.finishing.fetch_sub(1, std::memory_order_release);
+
+            for (Job* job : ready)
+                schedule(job);
+        }
+
+        void JobSystem::wake_workers()
+        {
+            if (sleeping_workers.load() == 0)
+                return;
+
+            {
+                std::lock_guard<std::mutex> lock(sleep_mutex);
+            }
+            wake_condition.notify_one();
+        }
+
+        Job* JobSystem::make_job(JobFunction function, JobCounter* counter)
+        {
+            Job* job = new Job();
+            job->function = std::move(function);
+            job->counter = counter;
+            return job;
+        }
+    };
+};
@@ -0,0 +1,214 @@
+#pragma once
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-01
+ *
+ */
+
+#include <iostream>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+#include <cstdint>
+#include <stdexcept>
+
+#include "work_stealing_deque.hpp"
+
+namespace VulkanGameEngine
+{
+    namespace Jobs
+    {
+        typedef std::function<void()> JobFunction;
+
+        /**
+         * Items [first, last) of a parallel_for.
+         */
+        typedef std::function<void(uint32_t first, uint32_t last)> RangeFunction;
+
+        struct Job;
+
+        /**
+         * Number of unfinished jobs attached to it. Every run() taking the counter
+         * increments it, and it is decremented when the job returns.
+         *
+         * The first exception thrown by one of its jobs is rethrown by JobSystem::wait().
+         * Do not reuse a counter that still has run_after() continuations before it
+         * has reached zero.
+         */
+        class JobCounter
+        {
+            friend class JobSystem;
+
+            private:
+                std::atomic<uint32_t> value{0};
+                // Jobs currently inside JobSystem::finish() for this counter.
+                std::atomic<uint32_t> finishing{0};
+
+                std::mutex mutex;
+                std::vector<Job*> continuations;
+                std::exception_ptr error;
+
+            public:
+                JobCounter() = default;
+                JobCounter(const JobCounter&) = delete;
+                JobCounter& operator=(const JobCounter&) = delete;
+
+                uint32_t get() const { return value.load(std::memory_order_acquire); }
+
+                bool is_done() const { return get() == 0; }
+        };
+
+        struct Job
+        {
+            JobFunction function;
+            JobCounter* counter = nullptr;
+        };
+
+        /**
+         * Work-stealing job scheduler.
+         *
+         * Every worker owns a Chase-Lev deque: it pushes and pops its own jobs at the
+         * bottom and steals from the top of a random victim when it runs dry. Jobs
+         * submitted from a thread that is not a worker go through a shared
+         * injection queue.
+         *
+         * The thread calling init() is worker 0 (the main thread). It does not loop
+         * like the others: it runs jobs while it waits on a counter, and it is the
+         * only thread running main-thread jobs (GLFW calls), in pump_main_thread()
+         * and wait().
+         */
+        class JobSystem
+        {
+            public:
+                struct WorkerStatistics
+                {
+                    uint64_t jobs_executed = 0;
+                    uint64_t steals = 0;
+                    uint64_t steal_attempts = 0;
+                    double busy_ms = 0.0;
+                    double idle_ms = 0.0;
+                };
+
+            private:
+                struct alignas(64) Worker
+                {
+                    WorkStealingDeque<Job*> deque;
+                    uint32_t random_state = 1;
+
+                    std::atomic<uint64_t> jobs_executed{0};
+                    std::atomic<uint64_t> steals{0};
+                    std::atomic<uint64_t> steal_attempts{0};
+                    std::atomic<uint64_t> busy_ns{0};
+                    std::atomic<uint64_t> idle_ns{0};
+                };
+
+                std::vector<std::unique_ptr<Worker>> workers;
+                std::vector<std::thread> threads;
+                std::thread::id main_thread_id;
+
+                // Jobs pushed by threads that are not workers.
+                std::mutex injection_mutex;
+                std::deque<Job*> injection_queue;
+                std::atomic<uint32_t> injection_size{0};
+
+                std::mutex main_thread_mutex;
+                std::deque<Job*> main_thread_queue;
+
+                // Jobs sitting in a deque or the injection queue; sleeping workers wake up when non zero.
+                std::atomic<int64_t> queued_jobs{0};
+                std::atomic<uint32_t> sleeping_workers{0};
+                std::mutex sleep_mutex;
+                std::condition_variable wake_condition;
+                std::atomic<bool> stopping{false};
+
+            public:
+                // Spins before a worker with nothing to do goes to sleep.
+                uint32_t spin_count = 64;
+
+                JobSystem() = default;
+                JobSystem(const JobSystem&) = delete;
+                JobSystem& operator=(const JobSystem&) = delete;
+
+                ~JobSystem() { cleanup(); }
+
+                /**
+                 * worker_count includes the calling thread; 0 uses every hardware thread.
+                 */
+                void init(uint32_t worker_count = 0);
+
+                /**
+                 * Waits for the workers to finish their current job. Queued jobs are dropped.
+                 */
+                void cleanup();
+
+                uint32_t get_worker_count() const { return static_cast<uint32_t>(workers.size()); }
+
+                /**
+                 * Index of the calling worker in this system, -1 for any other thread.
+                 */
+                int32_t current_worker() const;
+
+                bool is_main_thread() const { return std::this_thread::get_id() == main_thread_id; }
+
+                void run(JobFunction function, JobCounter* counter = nullptr);
+
+                /**
+                 * Schedule function once dependency reaches zero. counter is incremented now.
+                 */
+                void run_after(JobCounter& dependency, JobFunction function, JobCounter* counter = nullptr);
+
+                /**
+                 * Queue a job only the main thread may run.
+                 */
+                void run_on_main_thread(JobFunction function, JobCounter* counter = nullptr);
+
+                /**
+                 * Run jobs until counter reaches zero, then rethrow the first exception
+                 * of its jobs, if any.
+                 */
+                void wait(JobCounter& counter);
+
+                /**
+                 * Run the queued main-thread jobs. Main thread only.
+                 */
+                void pump_main_thread();
+
+                /**
+                 * Split [0, count) in chunks of at least grain items, run them across the
+                 * workers and wait for them.
+                 */
+                void parallel_for(uint32_t count, uint32_t grain, const RangeFunction& function);
+
+                std::vector<WorkerStatistics> get_statistics() const;
+
+                void reset_statistics();
+
+                void print_statistics(std::ostream& out) const;
+
+            private:
+                void worker_loop(uint32_t index);
+
+                void schedule(Job* job);
+
+                Job* find_job(int32_t index);
+
+                Job* steal_job(int32_t thief);
+
+                Job* pop_main_thread_job();
+
+                void execute(Job* job, int32_t index);
+
+                void finish(JobCounter& counter);
+
+                void wake_workers();
+
+                static Job* make_job(JobFunction function, JobCounter* counter);
+        };
+    };
+};
@@ -0,0 +1,164 @@
+#pragma once
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-01
+ *
+ */
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <type_traits>
+
+namespace VulkanGameEngine
+{
+    namespace Jobs
+    {
+        /**
+         * Chase-Lev work-stealing deque (Lê et al., "Correct and Efficient
+         * Work-Stealing for Weak Memory Models", 2013).
+         *
+         * The owning thread pushes and pops at the bottom (LIFO, cache friendly);
+         * any other thread steals from the top (FIFO, oldest and usually largest work).
+         * Only the owner may call push() and pop().
+         *
+         * Arrays replaced by a grow are kept until destruction, since a thief may
+         * still be reading from them.
+         */
+        template<typename T>
+        class WorkStealingDeque
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "WorkStealingDeque elements must be trivially copyable.");
+
+            private:
+                struct Array
+                {
+                    int64_t capacity;
+                    int64_t mask;
+                    std::unique_ptr<std::atomic<T>[]> slots;
+
+                    explicit Array(int64_t capacity)
+                        : capacity(capacity), mask(capacity - 1), slots(new std::atomic<T>[capacity])
+                    {
+                    }
+
+                    T get(int64_t index) const { return slots[index & mask].load(std::memory_order_relaxed); }
+
+                    void put(int64_t index, T value) { slots[index & mask].store(value, std::memory_order_relaxed); }
+                };
+
+                // top and bottom on their own cache lines: thieves hammer top, the owner bottom.
+                alignas(64) std::atomic<int64_t> top{0};
+                alignas(64) std::atomic<int64_t> bottom{0};
+                alignas(64) std::atomic<Array*> array;
+
+                std::vector<std::unique_ptr<Array>> arrays;
+
+            public:
+                /**
+                 * capacity is rounded up to a power of two.
+                 */
+                explicit WorkStealingDeque(int64_t capacity = 1024)
+                {
+                    int64_t rounded = 1;
+                    while (rounded < capacity)
+                        rounded <<= 1;
+
+                    arrays.emplace_back(new Array(rounded));
+                    array.store(arrays.back().get(), std::memory_order_relaxed);
+                }
+
+                WorkStealingDeque(const WorkStealingDeque&) = delete;
+                WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+                /**
+                 * Owner only.
+                 */
+                void push(T value)
+                {
+                    int64_t b = bottom.load(std::memory_order_relaxed);
+                    int64_t t = top.load(std::memory_order_acquire);
+                    Array* a = array.load(std::memory_order_relaxed);
+
+                    if (b - t > a->capacity - 1)
+                        a = grow(a, t, b);
+
+                    a->put(b, value);
+                    // Publishes the slot to thieves that acquire-load bottom.
+                    bottom.store(b + 1, std::memory_order_release);
+                }
+
+                /**
+                 * Owner only. Returns false when the deque is empty.
+                 */
+                bool pop(T& value)
+                {
+                    int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+                    Array* a = array.load(std::memory_order_relaxed);
+                    bottom.store(b, std::memory_order_relaxed);
+                    std::atomic_thread_fence(std::memory_order_seq_cst);
+                    int64_t t = top.load(std::memory_order_relaxed);
+
+                    if (t > b)
+                    {
+                        bottom.store(b + 1, std::memory_order_relaxed);
+                        return false;
+                    }
+
+                    value = a->get(b);
+                    if (t == b)
+                    {
+                        // Last element: race the thieves for it.
+                        bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+                        bottom.store(b + 1, std::memory_order_relaxed);
+                        return won;
+                    }
+
+                    return true;
+                }
+
+                /**
+                 * Any thread. Returns false when the deque is empty or another thread
+                 * won the race for the top element.
+                 */
+                bool steal(T& value)
+                {
+                    int64_t t = top.load(std::memory_order_acquire);
+                    std::atomic_thread_fence(std::memory_order_seq_cst);
+                    int64_t b = bottom.load(std::memory_order_acquire);
+
+                    if (t >= b)
+                        return false;
+
+                    Array* a = array.load(std::memory_order_acquire);
+                    value = a->get(t);
+                    return top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+                }
+
+                /**
+                 * Approximate when called from a thief.
+                 */
+                int64_t size() const
+                {
+                    int64_t b = bottom.load(std::memory_order_relaxed);
+                    int64_t t = top.load(std::memory_order_relaxed);
+                    return b > t ? b - t : 0;
+                }
+
+                bool empty() const { return size() == 0; }
+
+            private:
+                Array* grow(Array* old_array, int64_t t, int64_t b)
+                {
+                    Array* new_array = new Array(old_array->capacity * 2);
+                    for (int64_t i = t; i < b; i++)
+                        new_array->put(i, old_array->get(i));
+
+                    arrays.emplace_back(new_array);
+                    array.store(new_array, std::memory_order_release);
+                    return new_array;
+                }
+        };
+    };
+};
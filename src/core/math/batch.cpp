@@ -0,0 +1,282 @@
+#include "batch.hpp"
+#include "../utils/cpu_features.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace VulkanGameEngine
+{
+    namespace Math
+    {
+        /**
+         * Column b of a * b, a given by its columns.
+         */
+        static inline Float4 multiply_column(Float4 a0, Float4 a1, Float4 a2, Float4 a3, Float4 b)
+        {
+            Float4 sum = mul(a0, splat_lane<0>(b));
+            sum = madd(a1, splat_lane<1>(b), sum);
+            sum = madd(a2, splat_lane<2>(b), sum);
+            return madd(a3, splat_lane<3>(b), sum);
+        }
+
+        const char* batch_kernel_name(BatchKernel kernel)
+        {
+            switch (kernel)
+            {
+                case BatchKernel::Auto: return "auto";
+                case BatchKernel::Scalar: return "scalar";
+                case BatchKernel::SIMD: return float4_isa();
+                case BatchKernel::AVX2: return "avx2";
+            }
+            return "unknown";
+        }
+
+        bool is_batch_kernel_supported(BatchKernel kernel)
+        {
+            switch (kernel)
+            {
+                case BatchKernel::Auto:
+                case BatchKernel::Scalar:
+                    return true;
+                case BatchKernel::SIMD:
+                    #if defined(VGE_MATH_SSE) || defined(VGE_MATH_NEON)
+                        return true;
+                    #else
+                        return false;
+                    #endif
+                case BatchKernel::AVX2:
+                {
+                    const Utils::CpuFeatures& features = Utils::get_cpu_features();
+                    return avx2_kernels_compiled() && features.avx2 && features.fma;
+                }
+            }
+            return false;
+        }
+
+        BatchKernel resolve_batch_kernel(BatchKernel requested)
+        {
+            if (requested == BatchKernel::Auto)
+                requested = BatchKernel::AVX2;
+
+            // Checked once: the answers never change while running.
+            static const bool avx2 = is_batch_kernel_supported(BatchKernel::AVX2);
+            static const bool simd = is_batch_kernel_supported(BatchKernel::SIMD);
+            if (requested == BatchKernel::AVX2 && !avx2)
+                requested = BatchKernel::SIMD;
+            if (requested == BatchKernel::SIMD && !simd)
+                requested = BatchKernel::Scalar;
+            return requested;
+        }
+
+        void multiply_matrices(const Mat4* a, const Mat4* b, Mat4* out, size_t count, BatchKernel kernel)
+        {
+            switch (resolve_batch_kernel(kernel))
+            {
+                case BatchKernel::AVX2:
+                    multiply_matrices_avx2(a, b, out, count);
+                    break;
+                case BatchKernel::SIMD:
+                    for (size_t i = 0; i < count; i++)
+                    {
+                        // Both inputs are read whole before out[i] is written, in case they alias.
+                        Float4 a0 = load4(a[i].m), a1 = load4(a[i].m + 4), a2 = load4(a[i].m + 8), a3 = load4(a[i].m + 12);
+                        Float4 columns[4];
+                        for (int column = 0; column < 4; column++)
+                            columns[column] = load4(b[i].m + column * 4);
+                        for (int column = 0; column < 4; column++)
+                            store4(out[i].m + column * 4, multiply_column(a0, a1, a2, a3, columns[column]));
+                    }
+                    break;
+                default:
+                    for (size_t i = 0; i < count; i++)
+                        out[i] = Scalar::multiply(a[i], b[i]);
+                    break;
+            }
+        }
+
+        void multiply_matrices(const Mat4& a, const Mat4* b, Mat4* out, size_t count, BatchKernel kernel)
+        {
+            switch (resolve_batch_kernel(kernel))
+            {
+                case BatchKernel::AVX2:
+                    multiply_matrices_avx2(a, b, out, count);
+                    break;
+                case BatchKernel::SIMD:
+                {
+                    Float4 a0 = load4(a.m), a1 = load4(a.m + 4), a2 = load4(a.m + 8), a3 = load4(a.m + 12);
+                    for (size_t i = 0; i < count; i++)
+                    {
+                        // b[i] is read whole before out[i] is written, in case they alias.
+                        Float4 columns[4];
+                        for (int column = 0; column < 4; column++)
+                            columns[column] = load4(b[i].m + column * 4);
+                        for (int column = 0; column < 4; column++)
+                            store4(out[i].m + column * 4, multiply_column(a0, a1, a2, a3, columns[column]));
+                    }
+                    break;
+                }
+                default:
+                {
+                    Mat4 left = a;
+                    for (size_t i = 0; i < count; i++)
+                        out[i] = Scalar::multiply(left, b[i]);
+                    break;
+                }
+            }
+        }
+
+        void transform_aabbs(const Mat4* matrices, const Aabb* boxes, Aabb* out, size_t count, BatchKernel kernel)
+        {
+            switch (resolve_batch_kernel(kernel))
+            {
+                case BatchKernel::AVX2:
+                    transform_aabbs_avx2(matrices, boxes, out, count);
+                    break;
+                case BatchKernel::SIMD:
+                    // Arvo: the new center is the transformed center, the new extent
+                    // the extent through the absolute values of the 3x3.
+                    for (size_t i = 0; i < count; i++)
+                    {
+                        const float* m = matrices[i].m;
+                        Float4 minimum = load3(boxes[i].min.data());
+                        Float4 maximum = load3(boxes[i].max.data());
+                        Float4 half = splat(0.5f);
+                        Float4 c = mul(add(minimum, maximum), half);
+                        Float4 e = mul(sub(maximum, minimum), half);
+
+                        Float4 m0 = load4(m), m1 = load4(m + 4), m2 = load4(m + 8);
+                        Float4 center = madd(m0, splat_lane<0>(c), load4(m + 12));
+                        center = madd(m1, splat_lane<1>(c), center);
+                        center = madd(m2, splat_lane<2>(c), center);
+                        Float4 extent = mul(abs(m0), splat_lane<0>(e));
+                        extent = madd(abs(m1), splat_lane<1>(e), extent);
+                        extent = madd(abs(m2), splat_lane<2>(e), extent);
+
+                        store3(out[i].min.data(), sub(center, extent));
+                        store3(out[i].max.data(), add(center, extent));
+                    }
+                    break;
+                default:
+                    for (size_t i = 0; i < count; i++)
+                    {
+                        const Mat4& m = matrices[i];
+                        Vec3 c = boxes[i].center();
+                        Vec3 e = boxes[i].extent();
+                        Vec3 center = Scalar::transform_point(m, c);
+                        Vec3 extent(
+                            std::fabs(m.m[0]) * e.x + std::fabs(m.m[4]) * e.y + std::fabs(m.m[8]) * e.z,
+                            std::fabs(m.m[1]) * e.x + std::fabs(m.m[5]) * e.y + std::fabs(m.m[9]) * e.z,
+                            std::fabs(m.m[2]) * e.x + std::fabs(m.m[6]) * e.y + std::fabs(m.m[10]) * e.z);
+                        out[i].min = center - extent;
+                        out[i].max = center + extent;
+                    }
+                    break;
+            }
+        }
+
+        void transform_spheres(const Mat4* matrices, const Sphere* spheres, Sphere* out, size_t count, BatchKernel kernel)
+        {
+            if (resolve_batch_kernel(kernel) == BatchKernel::Scalar)
+            {
+                for (size_t i = 0; i < count; i++)
+                {
+                    const Mat4& m = matrices[i];
+                    float scale = std::max(
+                        length_squared(m.column(0).xyz()),
+                        std::max(length_squared(m.column(1).xyz()), length_squared(m.column(2).xyz())));
+                    float radius = spheres[i].radius * std::sqrt(scale);
+                    out[i].center = Scalar::transform_point(m, spheres[i].center);
+                    out[i].radius = radius;
+                }
+                return;
+            }
+
+            for (size_t i = 0; i < count; i++)
+            {
+                const float* m = matrices[i].m;
+                Float4 m0 = load4(m), m1 = load4(m + 4), m2 = load4(m + 8);
+                Float4 c = load3(spheres[i].center.data());
+                float radius = spheres[i].radius;
+
+                Float4 center = madd(m0, splat_lane<0>(c), load4(m + 12));
+                center = madd(m1, splat_lane<1>(c), center);
+                center = madd(m2, splat_lane<2>(c), center);
+
+                // Squared column lengths in lanes 0..2: square, transpose, sum the rows.
+                Float4 s0 = mul(m0, m0), s1 = mul(m1, m1), s2 = mul(m2, m2), s3 = splat(0.0f);
+                transpose4(s0, s1, s2, s3);
+                Float4 scale = add(add(s0, s1), s2);
+
+                store3(out[i].center.data(), center);
+                out[i].radius = radius * std::sqrt(horizontal_max(scale));
+            }
+        }
+
+        Aabb compute_aabb(const Vec3* points, size_t count, BatchKernel kernel)
+        {
+            Aabb box;
+            if (count == 0)
+                return box;
+
+            box.min = box.max = points[0];
+            size_t i = 0;
+            if (resolve_batch_kernel(kernel) != BatchKernel::Scalar && count >= 4)
+            {
+                Float4 min_x = splat(points[0].x), min_y = splat(points[0].y), min_z = splat(points[0].z);
+                Float4 max_x = min_x, max_y = min_y, max_z = min_z;
+                for (; i + 4 <= count; i += 4)
+                {
+                    Float4 x, y, z;
+                    load_deinterleave3(points[i].data(), x, y, z);
+                    min_x = min(min_x, x);
+                    min_y = min(min_y, y);
+                    min_z = min(min_z, z);
+                    max_x = max(max_x, x);
+                    max_y = max(max_y, y);
+                    max_z = max(max_z, z);
+                }
+                box.min = Vec3(horizontal_min(min_x), horizontal_min(min_y), horizontal_min(min_z));
+                box.max = Vec3(horizontal_max(max_x), horizontal_max(max_y), horizontal_max(max_z));
+            }
+
+            for (; i < count; i++)
+            {
+                box.min = Math::min(box.min, points[i]);
+                box.max = Math::max(box.max, points[i]);
+            }
+            return box;
+        }
+
+        Sphere compute_bounding_sphere(const Vec3* points, size_t count, BatchKernel kernel)
+        {
+            Sphere sphere;
+            if (count == 0)
+                return sphere;
+
+            sphere.center = compute_aabb(points, count, kernel).center();
+            const Vec3 c = sphere.center;
+
+            float farthest = 0.0f;
+            size_t i = 0;
+            if (resolve_batch_kernel(kernel) != BatchKernel::Scalar)
+            {
+                Float4 cx = splat(c.x), cy = splat(c.y), cz = splat(c.z);
+                Float4 distances = splat(0.0f);
+                for (; i + 4 <= count; i += 4)
+                {
+                    Float4 x, y, z;
+                    load_deinterleave3(points[i].data(), x, y, z);
+                    Float4 dx = sub(x, cx), dy = sub(y, cy), dz = sub(z, cz);
+                    distances = max(distances, madd(dz, dz, madd(dy, dy, mul(dx, dx))));
+                }
+                farthest = horizontal_max(distances);
+            }
+
+            for (; i < count; i++)
+                farthest = std::max(farthest, length_squared(points[i] - c));
+
+            sphere.radius = std::sqrt(farthest);
+            return sphere;
+        }
+    };
+};
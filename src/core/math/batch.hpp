@@ -0,0 +1,84 @@
+#pragma once
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-12
+ *
+ */
+
+#include <cstddef>
+#include <cstdint>
+
+#include "matrix.hpp"
+#include "bounds.hpp"
+
+namespace VulkanGameEngine
+{
+    namespace Math
+    {
+        /**
+         * SIMD is the 128-bit Float4 path (SSE2 or NEON). AVX2 covers the matrix
+         * and box kernels; the others run their SIMD version under it.
+         */
+        enum class BatchKernel
+        {
+            Auto = 0,
+            Scalar = 1,
+            SIMD = 2,
+            AVX2 = 3
+        };
+
+        const char* batch_kernel_name(BatchKernel kernel);
+
+        bool is_batch_kernel_supported(BatchKernel kernel);
+
+        /**
+         * The widest supported kernel no wider than requested; Auto is the widest overall.
+         */
+        BatchKernel resolve_batch_kernel(BatchKernel requested);
+
+        /**
+         * out[i] = a[i] * b[i]. out may alias a or b.
+         */
+        void multiply_matrices(const Mat4* a, const Mat4* b, Mat4* out, size_t count, BatchKernel kernel = BatchKernel::Auto);
+
+        /**
+         * out[i] = a * b[i], e.g. a view-projection applied to every model matrix.
+         * out may alias b.
+         */
+        void multiply_matrices(const Mat4& a, const Mat4* b, Mat4* out, size_t count, BatchKernel kernel = BatchKernel::Auto);
+
+        /**
+         * World space boxes enclosing boxes[i] transformed by matrices[i] (affine).
+         * out may alias boxes.
+         */
+        void transform_aabbs(const Mat4* matrices, const Aabb* boxes, Aabb* out, size_t count, BatchKernel kernel = BatchKernel::Auto);
+
+        /**
+         * spheres[i] transformed by matrices[i] (affine); the radius grows by the
+         * largest axis scale, so non uniform scales stay conservative.
+         */
+        void transform_spheres(const Mat4* matrices, const Sphere* spheres, Sphere* out, size_t count, BatchKernel kernel = BatchKernel::Auto);
+
+        /**
+         * Bounds of a point set; an empty box at the origin when count is 0.
+         */
+        Aabb compute_aabb(const Vec3* points, size_t count, BatchKernel kernel = BatchKernel::Auto);
+
+        /**
+         * Sphere around the points' bounding box center: a little looser than the
+         * minimal sphere, but two linear passes that vectorize.
+         */
+        Sphere compute_bounding_sphere(const Vec3* points, size_t count, BatchKernel kernel = BatchKernel::Auto);
+
+        /**
+         * AVX2 kernels, only valid when avx2_kernels_compiled() and the CPU has AVX2 and FMA.
+         */
+        bool avx2_kernels_compiled();
+
+        void multiply_matrices_avx2(const Mat4* a, const Mat4* b, Mat4* out, size_t count);
+
+        void multiply_matrices_avx2(const Mat4& a, const Mat4* b, Mat4* out, size_t count);
+
+        void transform_aabbs_avx2(const Mat4* matrices, const Aabb* boxes, Aabb* out, size_t count);
+    };
+};
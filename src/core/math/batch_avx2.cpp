@@ -0,0 +1,139 @@
+/**
+ * The AVX2 batch kernels live in their own translation unit, the only math
+ * one built with AVX2 and FMA enabled (see CMakeLists.txt). They only run
+ * after the CPU has been checked for both.
+ */
+
+#include "batch.hpp"
+
+// MSVC has no __FMA__; /arch:AVX2 enables FMA along with AVX2.
+#if defined(__AVX2__) && (defined(__FMA__) || defined(_MSC_VER))
+    #include <immintrin.h>
+    #define VGE_MATH_AVX2 1
+#endif
+
+namespace VulkanGameEngine
+{
+    namespace Math
+    {
+        bool avx2_kernels_compiled()
+        {
+            #ifdef VGE_MATH_AVX2
+                return true;
+            #else
+                return false;
+            #endif
+        }
+
+        #ifdef VGE_MATH_AVX2
+            /**
+             * The 4 float column in both halves.
+             */
+            static inline __m256 broadcast_column(const float* column)
+            {
+                return _mm256_broadcast_ps(reinterpret_cast<const __m128*>(column));
+            }
+
+            /**
+             * Columns c and c + 1 of a * b, with a's columns broadcast to both halves:
+             * every half multiplies a by its own column of b.
+             */
+            static inline __m256 multiply_column_pair(__m256 a0, __m256 a1, __m256 a2, __m256 a3, __m256 b)
+            {
+                __m256 sum = _mm256_mul_ps(a0, _mm256_shuffle_ps(b, b, 0x00));
+                sum = _mm256_fmadd_ps(a1, _mm256_shuffle_ps(b, b, 0x55), sum);
+                sum = _mm256_fmadd_ps(a2, _mm256_shuffle_ps(b, b, 0xaa), sum);
+                return _mm256_fmadd_ps(a3, _mm256_shuffle_ps(b, b, 0xff), sum);
+            }
+
+            void multiply_matrices_avx2(const Mat4* a, const Mat4* b, Mat4* out, size_t count)
+            {
+                for (size_t i = 0; i < count; i++)
+                {
+                    __m256 a0 = broadcast_column(a[i].m);
+                    __m256 a1 = broadcast_column(a[i].m + 4);
+                    __m256 a2 = broadcast_column(a[i].m + 8);
+                    __m256 a3 = broadcast_column(a[i].m + 12);
+                    __m256 b01 = _mm256_loadu_ps(b[i].m);
+                    __m256 b23 = _mm256_loadu_ps(b[i].m + 8);
+                    _mm256_storeu_ps(out[i].m, multiply_column_pair(a0, a1, a2, a3, b01));
+                    _mm256_storeu_ps(out[i].m + 8, multiply_column_pair(a0, a1, a2, a3, b23));
+                }
+            }
+
+            void multiply_matrices_avx2(const Mat4& a, const Mat4* b, Mat4* out, size_t count)
+            {
+                __m256 a0 = broadcast_column(a.m);
+                __m256 a1 = broadcast_column(a.m + 4);
+                __m256 a2 = broadcast_column(a.m + 8);
+                __m256 a3 = broadcast_column(a.m + 12);
+                for (size_t i = 0; i < count; i++)
+                {
+                    __m256 b01 = _mm256_loadu_ps(b[i].m);
+                    __m256 b23 = _mm256_loadu_ps(b[i].m + 8);
+                    _mm256_storeu_ps(out[i].m, multiply_column_pair(a0, a1, a2, a3, b01));
+                    _mm256_storeu_ps(out[i].m + 8, multiply_column_pair(a0, a1, a2, a3, b23));
+                }
+            }
+
+            void transform_aabbs_avx2(const Mat4* matrices, const Aabb* boxes, Aabb* out, size_t count)
+            {
+                // Center in the low half, extent in the high half: one pass of
+                // multiply-adds over [column | |column|] yields both.
+                const __m256 sign = _mm256_set1_ps(-0.0f);
+                const __m256 low_only = _mm256_castsi256_ps(_mm256_setr_epi32(-1, -1, -1, -1, 0, 0, 0, 0));
+                const __m256 half = _mm256_set1_ps(0.5f);
+                // Sign bits of the high half: clearing them takes the absolute value there only.
+                const __m256 high_sign = _mm256_andnot_ps(low_only, sign);
+                for (size_t i = 0; i < count; i++)
+                {
+                    const float* m = matrices[i].m;
+                    __m256 c0 = broadcast_column(m);
+                    __m256 c1 = broadcast_column(m + 4);
+                    __m256 c2 = broadcast_column(m + 8);
+                    c0 = _mm256_andnot_ps(high_sign, c0);
+                    c1 = _mm256_andnot_ps(high_sign, c1);
+                    c2 = _mm256_andnot_ps(high_sign, c2);
+                    __m256 translation = _mm256_and_ps(low_only, broadcast_column(m + 12));
+
+                    const float* minimum = boxes[i].min.data();
+                    const float* maximum = boxes[i].max.data();
+                    // [min.x | min.x] ... with the extent sign folded in: (max + min) / 2 low, (max - min) / 2 high.
+                    __m256 mx = _mm256_set_m128(_mm_set1_ps(-minimum[0]), _mm_set1_ps(minimum[0]));
+                    __m256 my = _mm256_set_m128(_mm_set1_ps(-minimum[1]), _mm_set1_ps(minimum[1]));
+                    __m256 mz = _mm256_set_m128(_mm_set1_ps(-minimum[2]), _mm_set1_ps(minimum[2]));
+                    __m256 vx = _mm256_mul_ps(_mm256_add_ps(_mm256_set1_ps(maximum[0]), mx), half);
+                    __m256 vy = _mm256_mul_ps(_mm256_add_ps(_mm256_set1_ps(maximum[1]), my), half);
+                    __m256 vz = _mm256_mul_ps(_mm256_add_ps(_mm256_set1_ps(maximum[2]), mz), half);
+
+                    __m256 r = _mm256_fmadd_ps(c0, vx, translation);
+                    r = _mm256_fmadd_ps(c1, vy, r);
+                    r = _mm256_fmadd_ps(c2, vz, r);
+
+                    __m128 center = _mm256_castps256_ps128(r);
+                    __m128 extent = _mm256_extractf128_ps(r, 1);
+                    float low[4], high[4];
+                    _mm_storeu_ps(low, _mm_sub_ps(center, extent));
+                    _mm_storeu_ps(high, _mm_add_ps(center, extent));
+                    out[i].min = Vec3(low[0], low[1], low[2]);
+                    out[i].max = Vec3(high[0], high[1], high[2]);
+                }
+            }
+        #else
+            void multiply_matrices_avx2(const Mat4* a, const Mat4* b, Mat4* out, size_t count)
+            {
+                multiply_matrices(a, b, out, count, BatchKernel::SIMD);
+            }
+
+            void multiply_matrices_avx2(const Mat4& a, const Mat4* b, Mat4* out, size_t count)
+            {
+                multiply_matrices(a, b, out, count, BatchKernel::SIMD);
+            }
+
+            void transform_aabbs_avx2(const Mat4* matrices, const Aabb* boxes, Aabb* out, size_t count)
+            {
+                transform_aabbs(matrices, boxes, out, count, BatchKernel::SIMD);
+            }
+        #endif
+    };
+};
@@ -0,0 +1,30 @@
+#pragma once
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-12
+ *
+ */
+
+#include "vector.hpp"
+
+namespace VulkanGameEngine
+{
+    namespace Math
+    {
+        struct Aabb
+        {
+            Vec3 min;
+            Vec3 max;
+
+            constexpr Vec3 center() const { return (min + max) * 0.5f; }
+
+            constexpr Vec3 extent() const { return (max - min) * 0.5f; }
+        };
+
+        struct Sphere
+        {
+            Vec3 center;
+            float radius = 0.0f;
+        };
+    };
+};
@@ -0,0 +1,248 @@
+#pragma once
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-12
+ *
+ */
+
+#include "simd.hpp"
+#include "vector.hpp"
+#include "quaternion.hpp"
+
+namespace VulkanGameEngine
+{
+    namespace Math
+    {
+        /**
+         * Column-major 4x4 matrix, element (row r, column c) at m[c * 4 + r], the
+         * layout GLSL expects. An aggregate: default initialization leaves it
+         * uninitialized, so large arrays of them cost nothing to allocate.
+         */
+        struct Mat4
+        {
+            float m[16];
+
+            static constexpr Mat4 identity()
+            {
+                return Mat4{{
+                    1.0f, 0.0f, 0.0f, 0.0f,
+                    0.0f, 1.0f, 0.0f, 0.0f,
+                    0.0f, 0.0f, 1.0f, 0.0f,
+                    0.0f, 0.0f, 0.0f, 1.0f}};
+            }
+
+            static constexpr Mat4 translation(const Vec3& t)
+            {
+                return Mat4{{
+                    1.0f, 0.0f, 0.0f, 0.0f,
+                    0.0f, 1.0f, 0.0f, 0.0f,
+                    0.0f, 0.0f, 1.0f, 0.0f,
+                    t.x, t.y, t.z, 1.0f}};
+            }
+
+            static constexpr Mat4 scaling(const Vec3& s)
+            {
+                return Mat4{{
+                    s.x, 0.0f, 0.0f, 0.0f,
+                    0.0f, s.y, 0.0f, 0.0f,
+                    0.0f, 0.0f, s.z, 0.0f,
+                    0.0f, 0.0f, 0.0f, 1.0f}};
+            }
+
+            /**
+             * translation * rotation * scale, rotation a unit quaternion.
+             */
+            static constexpr Mat4 compose(const Vec3& t, const Quat& r, const Vec3& s)
+            {
+                float xx = r.x * r.x, yy = r.y * r.y, zz = r.z * r.z;
+                float xy = r.x * r.y, xz = r.x * r.z, yz = r.y * r.z;
+                float wx = r.w * r.x, wy = r.w * r.y, wz = r.w * r.z;
+                return Mat4{{
+                    (1.0f - 2.0f * (yy + zz)) * s.x, 2.0f * (xy + wz) * s.x, 2.0f * (xz - wy) * s.x, 0.0f,
+                    2.0f * (xy - wz) * s.y, (1.0f - 2.0f * (xx + zz)) * s.y, 2.0f * (yz + wx) * s.y, 0.0f,
+                    2.0f * (xz + wy) * s.z, 2.0f * (yz - wx) * s.z, (1.0f - 2.0f * (xx + yy)) * s.z, 0.0f,
+                    t.x, t.y, t.z, 1.0f}};
+            }
+
+            constexpr float operator()(int row, int column) const { return m[column * 4 + row]; }
+
+            constexpr Vec4 column(int c) const { return Vec4(m[c * 4], m[c * 4 + 1], m[c * 4 + 2], m[c * 4 + 3]); }
+
+            const float* data() const { return m; }
+            float* data() { return m; }
+        };
+
+        static_assert(sizeof(Mat4) == 16 * sizeof(float), "Mat4 arrays are read as packed floats");
+
+        /**
+         * Reference implementations, usable in constant expressions. The SIMD
+         * versions below must agree with them to rounding.
+         */
+        namespace Scalar
+        {
+            constexpr Mat4 multiply(const Mat4& a, const Mat4& b)
+            {
+                Mat4 r{};
+                for (int column = 0; column < 4; column++)
+                    for (int row = 0; row < 4; row++)
+                        r.m[column * 4 + row] =
+                            a.m[row] * b.m[column * 4] +
+                            a.m[4 + row] * b.m[column * 4 + 1] +
+                            a.m[8 + row] * b.m[column * 4 + 2] +
+                            a.m[12 + row] * b.m[column * 4 + 3];
+                return r;
+            }
+
+            constexpr Vec3 transform_point(const Mat4& a, const Vec3& p)
+            {
+                return Vec3(
+                    a.m[0] * p.x + a.m[4] * p.y + a.m[8] * p.z + a.m[12],
+                    a.m[1] * p.x + a.m[5] * p.y + a.m[9] * p.z + a.m[13],
+                    a.m[2] * p.x + a.m[6] * p.y + a.m[10] * p.z + a.m[14]);
+            }
+
+            constexpr Vec3 transform_vector(const Mat4& a, const Vec3& v)
+            {
+                return Vec3(
+                    a.m[0] * v.x + a.m[4] * v.y + a.m[8] * v.z,
+                    a.m[1] * v.x + a.m[5] * v.y + a.m[9] * v.z,
+                    a.m[2] * v.x + a.m[6] * v.y + a.m[10] * v.z);
+            }
+        };
+
+        constexpr Mat4 transpose(const Mat4& a)
+        {
+            Mat4 r{};
+            for (int column = 0; column < 4; column++)
+                for (int row = 0; row < 4; row++)
+                    r.m[row * 4 + column] = a.m[column * 4 + row];
+            return r;
+        }
+
+        /**
+         * a * b.
+         */
+        inline Mat4 multiply(const Mat4& a, const Mat4& b)
+        {
+            Float4 a0 = load4(a.m), a1 = load4(a.m + 4), a2 = load4(a.m + 8), a3 = load4(a.m + 12);
+            Mat4 r;
+            for (int column = 0; column < 4; column++)
+            {
+                Float4 bc = load4(b.m + column * 4);
+                Float4 sum = mul(a0, splat_lane<0>(bc));
+                sum = madd(a1, splat_lane<1>(bc), sum);
+                sum = madd(a2, splat_lane<2>(bc), sum);
+                sum = madd(a3, splat_lane<3>(bc), sum);
+                store4(r.m + column * 4, sum);
+            }
+            return r;
+        }
+
+        /**
+         * a * b where b's bottom row is (0, 0, 0, 1), one multiply per column less.
+         * The result keeps a's bottom row.
+         */
+        inline Mat4 multiply_affine(const Mat4& a, const Mat4& b)
+        {
+            Float4 a0 = load4(a.m), a1 = load4(a.m + 4), a2 = load4(a.m + 8), a3 = load4(a.m + 12);
+            Mat4 r;
+            for (int column = 0; column < 3; column++)
+            {
+                Float4 bc = load4(b.m + column * 4);
+                Float4 sum = mul(a0, splat_lane<0>(bc));
+                sum = madd(a1, splat_lane<1>(bc), sum);
+                sum = madd(a2, splat_lane<2>(bc), sum);
+                store4(r.m + column * 4, sum);
+            }
+            Float4 t = load4(b.m + 12);
+            Float4 sum = madd(a0, splat_lane<0>(t), a3);
+            sum = madd(a1, splat_lane<1>(t), sum);
+            sum = madd(a2, splat_lane<2>(t), sum);
+            store4(r.m + 12, sum);
+            return r;
+        }
+
+        inline Mat4 operator*(const Mat4& a, const Mat4& b) { return multiply(a, b); }
+
+        inline Vec3 transform_point(const Mat4& a, const Vec3& p)
+        {
+            Float4 r = madd(load4(a.m), splat(p.x), load4(a.m + 12));
+            r = madd(load4(a.m + 4), splat(p.y), r);
+            r = madd(load4(a.m + 8), splat(p.z), r);
+            Vec3 out;
+            store3(out.data(), r);
+            return out;
+        }
+
+        inline Vec3 transform_vector(const Mat4& a, const Vec3& v)
+        {
+            Float4 r = mul(load4(a.m), splat(v.x));
+            r = madd(load4(a.m + 4), splat(v.y), r);
+            r = madd(load4(a.m + 8), splat(v.z), r);
+            Vec3 out;
+            store3(out.data(), r);
+            return out;
+        }
+
+        /**
+         * Inverse of an affine matrix (bottom row 0, 0, 0, 1) with an invertible
+         * upper 3x3; the identity when it is singular.
+         */
+        inline Mat4 inverse_affine(const Mat4& a)
+        {
+            Vec3 c0(a.m[0], a.m[1], a.m[2]);
+            Vec3 c1(a.m[4], a.m[5], a.m[6]);
+            Vec3 c2(a.m[8], a.m[9], a.m[10]);
+
+            // Rows of the inverse 3x3 are the cross products of the columns over the determinant.
+            Vec3 r0 = cross(c1, c2);
+            Vec3 r1 = cross(c2, c0);
+            Vec3 r2 = cross(c0, c1);
+            float determinant = dot(c0, r0);
+            if (determinant == 0.0f)
+                return Mat4::identity();
+
+            float s = 1.0f / determinant;
+            r0 = r0 * s;
+            r1 = r1 * s;
+            r2 = r2 * s;
+
+            Vec3 t(a.m[12], a.m[13], a.m[14]);
+            return Mat4{{
+                r0.x, r1.x, r2.x, 0.0f,
+                r0.y, r1.y, r2.y, 0.0f,
+                r0.z, r1.z, r2.z, 0.0f,
+                -dot(r0, t), -dot(r1, t), -dot(r2, t), 1.0f}};
+        }
+
+        /**
+         * Right-handed view matrix from eye towards target; the camera looks down -z.
+         */
+        inline Mat4 look_at(const Vec3& eye, const Vec3& target, const Vec3& up)
+        {
+            Vec3 f = normalize(target - eye);
+            Vec3 s = normalize(cross(f, up));
+            Vec3 u = cross(s, f);
+            return Mat4{{
+                s.x, u.x, -f.x, 0.0f,
+                s.y, u.y, -f.y, 0.0f,
+                s.z, u.z, -f.z, 0.0f,
+                -dot(s, eye), -dot(u, eye), dot(f, eye), 1.0f}};
+        }
+
+        /**
+         * Perspective projection to Vulkan clip space: y down, depth 0 at
+         * near_plane and 1 at far_plane. vertical_fov in radians.
+         */
+        inline Mat4 perspective(float vertical_fov, float aspect, float near_plane, float far_plane)
+        {
+            float f = 1.0f / std::tan(vertical_fov * 0.5f);
+            float depth = 1.0f / (near_plane - far_plane);
+            return Mat4{{
+                f / aspect, 0.0f, 0.0f, 0.0f,
+                0.0f, -f, 0.0f, 0.0f,
+                0.0f, 0.0f, far_plane * depth, -1.0f,
+                0.0f, 0.0f, near_plane * far_plane * depth, 0.0f}};
+        }
+    };
+};
@@ -0,0 +1,91 @@
+#pragma once
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-12
+ *
+ */
+
+#include <cmath>
+
+#include "vector.hpp"
+
+namespace VulkanGameEngine
+{
+    namespace Math
+    {
+        /**
+         * Rotation quaternion (x, y, z, w), w the real part. Rotations are only
+         * meaningful on unit quaternions; nothing here normalizes implicitly.
+         */
+        struct Quat
+        {
+            float x = 0.0f;
+            float y = 0.0f;
+            float z = 0.0f;
+            float w = 1.0f;
+
+            constexpr Quat() = default;
+            constexpr Quat(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {}
+
+            static constexpr Quat identity() { return Quat(); }
+
+            const float* data() const { return &x; }
+        };
+
+        /**
+         * a * b rotates by b first, then by a.
+         */
+        constexpr Quat operator*(const Quat& a, const Quat& b)
+        {
+            return Quat(
+                a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+                a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+                a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+                a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z);
+        }
+
+        constexpr Quat conjugate(const Quat& q) { return Quat(-q.x, -q.y, -q.z, q.w); }
+
+        constexpr float dot(const Quat& a, const Quat& b) { return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w; }
+
+        /**
+         * v rotated by the unit quaternion q.
+         */
+        constexpr Vec3 rotate(const Quat& q, const Vec3& v)
+        {
+            // v + 2w (u x v) + 2 u x (u x v), u the vector part.
+            Vec3 u(q.x, q.y, q.z);
+            Vec3 t = cross(u, v) * 2.0f;
+            return v + t * q.w + cross(u, t);
+        }
+
+        inline Quat normalize(const Quat& q)
+        {
+            float l = std::sqrt(dot(q, q));
+            return l > 0.0f ? Quat(q.x / l, q.y / l, q.z / l, q.w / l) : Quat();
+        }
+
+        /**
+         * axis must be unit length; angle in radians.
+         */
+        inline Quat from_axis_angle(const Vec3& axis, float angle)
+        {
+            float s = std::sin(angle * 0.5f);
+            return Quat(axis.x * s, axis.y * s, axis.z * s, std::cos(angle * 0.5f));
+        }
+
+        /**
+         * Shortest path interpolation, normalized.
+         */
+        inline Quat nlerp(const Quat& a, const Quat& b, float t)
+        {
+            float sign = dot(a, b) < 0.0f ? -1.0f : 1.0f;
+            float u = 1.0f - t;
+            return normalize(Quat(
+                a.x * u + b.x * t * sign,
+                a.y * u + b.y * t * sign,
+                a.z * u + b.z * t * sign,
+                a.w * u + b.w * t * sign));
+        }
+    };
+};
@@ -0,0 +1,302 @@
+#pragma once
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-12
+ *
+ */
+
+#include <cstdint>
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+// VGE_MATH_SCALAR forces the portable path, to compare against or to debug a SIMD one.
+#if !defined(VGE_MATH_SCALAR)
+    #if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+        #include <emmintrin.h>
+        #define VGE_MATH_SSE 1
+    #elif defined(__ARM_NEON) || defined(_M_ARM64)
+        #include <arm_neon.h>
+        #define VGE_MATH_NEON 1
+    #endif
+#endif
+
+namespace VulkanGameEngine
+{
+    namespace Math
+    {
+        /**
+         * Four floats in one 128-bit register: SSE2 on x86, NEON on ARM, a plain
+         * array elsewhere. Everything above this header is written once against
+         * these functions. Loads and stores are unaligned.
+         */
+        struct Float4
+        {
+            #if defined(VGE_MATH_SSE)
+                __m128 v;
+            #elif defined(VGE_MATH_NEON)
+                float32x4_t v;
+            #else
+                float v[4];
+            #endif
+        };
+
+        /**
+         * Name of the instruction set Float4 compiles to.
+         */
+        inline const char* float4_isa()
+        {
+            #if defined(VGE_MATH_SSE)
+                return "sse2";
+            #elif defined(VGE_MATH_NEON)
+                return "neon";
+            #else
+                return "scalar";
+            #endif
+        }
+
+        inline Float4 load4(const float* p)
+        {
+            Float4 r;
+            #if defined(VGE_MATH_SSE)
+                r.v = _mm_loadu_ps(p);
+            #elif defined(VGE_MATH_NEON)
+                r.v = vld1q_f32(p);
+            #else
+                for (int i = 0; i < 4; i++)
+                    r.v[i] = p[i];
+            #endif
+            return r;
+        }
+
+        inline void store4(float* p, Float4 a)
+        {
+            #if defined(VGE_MATH_SSE)
+                _mm_storeu_ps(p, a.v);
+            #elif defined(VGE_MATH_NEON)
+                vst1q_f32(p, a.v);
+            #else
+                for (int i = 0; i < 4; i++)
+                    p[i] = a.v[i];
+            #endif
+        }
+
+        /**
+         * x, y, z from p and w = 0, without reading p[3].
+         */
+        inline Float4 load3(const float* p)
+        {
+            #if defined(VGE_MATH_SSE)
+                Float4 r;
+                __m128 xy = _mm_castsi128_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)));
+                r.v = _mm_movelh_ps(xy, _mm_load_ss(p + 2));
+                return r;
+            #elif defined(VGE_MATH_NEON)
+                Float4 r;
+                r.v = vcombine_f32(vld1_f32(p), vld1_lane_f32(p + 2, vdup_n_f32(0.0f), 0));
+                return r;
+            #else
+                float values[4] = {p[0], p[1], p[2], 0.0f};
+                return load4(values);
+            #endif
+        }
+
+        /**
+         * x, y, z of a to p, without writing p[3].
+         */
+        inline void store3(float* p, Float4 a)
+        {
+            #if defined(VGE_MATH_SSE)
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(p), _mm_castps_si128(a.v));
+                _mm_store_ss(p + 2, _mm_movehl_ps(a.v, a.v));
+            #elif defined(VGE_MATH_NEON)
+                vst1_f32(p, vget_low_f32(a.v));
+                vst1q_lane_f32(p + 2, a.v, 2);
+            #else
+                for (int i = 0; i < 3; i++)
+                    p[i] = a.v[i];
+            #endif
+        }
+
+        inline Float4 set4(float x, float y, float z, float w)
+        {
+            Float4 r;
+            #if defined(VGE_MATH_SSE)
+                r.v = _mm_setr_ps(x, y, z, w);
+            #else
+                float values[4] = {x, y, z, w};
+                r = load4(values);
+            #endif
+            return r;
+        }
+
+        inline Float4 splat(float s)
+        {
+            Float4 r;
+            #if defined(VGE_MATH_SSE)
+                r.v = _mm_set1_ps(s);
+            #elif defined(VGE_MATH_NEON)
+                r.v = vdupq_n_f32(s);
+            #else
+                for (int i = 0; i < 4; i++)
+                    r.v[i] = s;
+            #endif
+            return r;
+        }
+
+        /**
+         * Lane i of a in every lane.
+         */
+        template <int i>
+        inline Float4 splat_lane(Float4 a)
+        {
+            Float4 r;
+            #if defined(VGE_MATH_SSE)
+                r.v = _mm_shuffle_ps(a.v, a.v, _MM_SHUFFLE(i, i, i, i));
+            #elif defined(VGE_MATH_NEON)
+                r.v = vdupq_n_f32(vgetq_lane_f32(a.v, i));
+            #else
+                for (int k = 0; k < 4; k++)
+                    r.v[k] = a.v[i];
+            #endif
+            return r;
+        }
+
+        template <int i>
+        inline float get_lane(Float4 a)
+        {
+            #if defined(VGE_MATH_SSE)
+                return _mm_cvtss_f32(_mm_shuffle_ps(a.v, a.v, _MM_SHUFFLE(i, i, i, i)));
+            #elif defined(VGE_MATH_NEON)
+                return vgetq_lane_f32(a.v, i);
+            #else
+                return a.v[i];
+            #endif
+        }
+
+        #if defined(VGE_MATH_SSE)
+            #define VGE_FLOAT4_BINARY(name, sse, neon, scalar) \
+                inline Float4 name(Float4 a, Float4 b) { Float4 r; r.v = sse(a.v, b.v); return r; }
+        #elif defined(VGE_MATH_NEON)
+            #define VGE_FLOAT4_BINARY(name, sse, neon, scalar) \
+                inline Float4 name(Float4 a, Float4 b) { Float4 r; r.v = neon(a.v, b.v); return r; }
+        #else
+            #define VGE_FLOAT4_BINARY(name, sse, neon, scalar) \
+                inline Float4 name(Float4 a, Float4 b) { Float4 r; for (int i = 0; i < 4; i++) r.v[i] = scalar(a.v[i], b.v[i]); return r; }
+        #endif
+
+        namespace Detail
+        {
+            inline float add(float a, float b) { return a + b; }
+            inline float sub(float a, float b) { return a - b; }
+            inline float mul(float a, float b) { return a * b; }
+            inline float min(float a, float b) { return b < a ? b : a; }
+            inline float max(float a, float b) { return a < b ? b : a; }
+        };
+
+        VGE_FLOAT4_BINARY(add, _mm_add_ps, vaddq_f32, Detail::add)
+        VGE_FLOAT4_BINARY(sub, _mm_sub_ps, vsubq_f32, Detail::sub)
+        VGE_FLOAT4_BINARY(mul, _mm_mul_ps, vmulq_f32, Detail::mul)
+        VGE_FLOAT4_BINARY(min, _mm_min_ps, vminq_f32, Detail::min)
+        VGE_FLOAT4_BINARY(max, _mm_max_ps, vmaxq_f32, Detail::max)
+
+        #undef VGE_FLOAT4_BINARY
+
+        /**
+         * a * b + c. Fused on NEON, two instructions on SSE2.
+         */
+        inline Float4 madd(Float4 a, Float4 b, Float4 c)
+        {
+            #if defined(VGE_MATH_NEON)
+                Float4 r;
+                r.v = vmlaq_f32(c.v, a.v, b.v);
+                return r;
+            #else
+                return add(mul(a, b), c);
+            #endif
+        }
+
+        inline Float4 abs(Float4 a)
+        {
+            Float4 r;
+            #if defined(VGE_MATH_SSE)
+                r.v = _mm_andnot_ps(_mm_set1_ps(-0.0f), a.v);
+            #elif defined(VGE_MATH_NEON)
+                r.v = vabsq_f32(a.v);
+            #else
+                for (int i = 0; i < 4; i++)
+                    r.v[i] = std::fabs(a.v[i]);
+            #endif
+            return r;
+        }
+
+        /**
+         * Largest of the four lanes.
+         */
+        inline float horizontal_max(Float4 a)
+        {
+            Float4 m = max(a, max(splat_lane<1>(a), max(splat_lane<2>(a), splat_lane<3>(a))));
+            return get_lane<0>(m);
+        }
+
+        inline float horizontal_min(Float4 a)
+        {
+            Float4 m = min(a, min(splat_lane<1>(a), min(splat_lane<2>(a), splat_lane<3>(a))));
+            return get_lane<0>(m);
+        }
+
+        /**
+         * Rows to columns: lane j of a becomes lane 0 of the j-th register.
+         */
+        inline void transpose4(Float4& a, Float4& b, Float4& c, Float4& d)
+        {
+            #if defined(VGE_MATH_SSE)
+                _MM_TRANSPOSE4_PS(a.v, b.v, c.v, d.v);
+            #elif defined(VGE_MATH_NEON)
+                float32x4x2_t ab = vtrnq_f32(a.v, b.v);
+                float32x4x2_t cd = vtrnq_f32(c.v, d.v);
+                a.v = vcombine_f32(vget_low_f32(ab.val[0]), vget_low_f32(cd.val[0]));
+                b.v = vcombine_f32(vget_low_f32(ab.val[1]), vget_low_f32(cd.val[1]));
+                c.v = vcombine_f32(vget_high_f32(ab.val[0]), vget_high_f32(cd.val[0]));
+                d.v = vcombine_f32(vget_high_f32(ab.val[1]), vget_high_f32(cd.val[1]));
+            #else
+                Float4* rows[4] = {&a, &b, &c, &d};
+                for (int i = 0; i < 4; i++)
+                    for (int j = i + 1; j < 4; j++)
+                        std::swap(rows[i]->v[j], rows[j]->v[i]);
+            #endif
+        }
+
+        /**
+         * Four packed xyz points (12 floats) into one register per component.
+         */
+        inline void load_deinterleave3(const float* p, Float4& x, Float4& y, Float4& z)
+        {
+            #if defined(VGE_MATH_SSE)
+                // a = x0 y0 z0 x1, b = y1 z1 x2 y2, c = z2 x3 y3 z3
+                __m128 a = _mm_loadu_ps(p);
+                __m128 b = _mm_loadu_ps(p + 4);
+                __m128 c = _mm_loadu_ps(p + 8);
+                __m128 t = _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 0, 0, 2));             // x2 y1 z2 x3
+                x.v = _mm_shuffle_ps(a, t, _MM_SHUFFLE(3, 0, 3, 0));
+                t = _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 0, 3, 0));                    // y1 y2 z2 y3
+                __m128 u = _mm_shuffle_ps(a, t, _MM_SHUFFLE(0, 0, 1, 1));             // y0 y0 y1 y1
+                y.v = _mm_shuffle_ps(u, t, _MM_SHUFFLE(3, 1, 2, 0));
+                u = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2));                    // z0 z0 z1 z1
+                z.v = _mm_shuffle_ps(u, c, _MM_SHUFFLE(3, 0, 2, 0));
+            #elif defined(VGE_MATH_NEON)
+                float32x4x3_t v = vld3q_f32(p);
+                x.v = v.val[0];
+                y.v = v.val[1];
+                z.v = v.val[2];
+            #else
+                for (int i = 0; i < 4; i++)
+                {
+                    x.v[i] = p[i * 3 + 0];
+                    y.v[i] = p[i * 3 + 1];
+                    z.v[i] = p[i * 3 + 2];
+                }
+            #endif
+        }
+    };
+};
@@ -0,0 +1,96 @@
+#pragma once
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-12
+ *
+ */
+
+#include <cmath>
+
+namespace VulkanGameEngine
+{
+    namespace Math
+    {
+        /**
+         * Tightly packed, so arrays of them can be handed to the GPU or to the
+         * batch kernels as they are. Everything but length() is constexpr.
+         */
+        struct Vec3
+        {
+            float x = 0.0f;
+            float y = 0.0f;
+            float z = 0.0f;
+
+            constexpr Vec3() = default;
+            constexpr Vec3(float x, float y, float z) : x(x), y(y), z(z) {}
+            constexpr explicit Vec3(float s) : x(s), y(s), z(s) {}
+
+            const float* data() const { return &x; }
+            float* data() { return &x; }
+        };
+
+        static_assert(sizeof(Vec3) == 3 * sizeof(float), "Vec3 arrays are read as packed floats");
+
+        struct Vec4
+        {
+            float x = 0.0f;
+            float y = 0.0f;
+            float z = 0.0f;
+            float w = 0.0f;
+
+            constexpr Vec4() = default;
+            constexpr Vec4(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {}
+            constexpr Vec4(const Vec3& v, float w) : x(v.x), y(v.y), z(v.z), w(w) {}
+
+            constexpr Vec3 xyz() const { return Vec3(x, y, z); }
+
+            const float* data() const { return &x; }
+            float* data() { return &x; }
+        };
+
+        constexpr Vec3 operator+(const Vec3& a, const Vec3& b) { return Vec3(a.x + b.x, a.y + b.y, a.z + b.z); }
+        constexpr Vec3 operator-(const Vec3& a, const Vec3& b) { return Vec3(a.x - b.x, a.y - b.y, a.z - b.z); }
+        constexpr Vec3 operator*(const Vec3& a, const Vec3& b) { return Vec3(a.x * b.x, a.y * b.y, a.z * b.z); }
+        constexpr Vec3 operator*(const Vec3& a, float s) { return Vec3(a.x * s, a.y * s, a.z * s); }
+        constexpr Vec3 operator*(float s, const Vec3& a) { return a * s; }
+        constexpr Vec3 operator-(const Vec3& a) { return Vec3(-a.x, -a.y, -a.z); }
+
+        constexpr Vec4 operator+(const Vec4& a, const Vec4& b) { return Vec4(a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w); }
+        constexpr Vec4 operator-(const Vec4& a, const Vec4& b) { return Vec4(a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w); }
+        constexpr Vec4 operator*(const Vec4& a, float s) { return Vec4(a.x * s, a.y * s, a.z * s, a.w * s); }
+
+        constexpr bool operator==(const Vec3& a, const Vec3& b) { return a.x == b.x && a.y == b.y && a.z == b.z; }
+        constexpr bool operator!=(const Vec3& a, const Vec3& b) { return !(a == b); }
+
+        constexpr float dot(const Vec3& a, const Vec3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+        constexpr float dot(const Vec4& a, const Vec4& b) { return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w; }
+
+        constexpr Vec3 cross(const Vec3& a, const Vec3& b)
+        {
+            return Vec3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+        }
+
+        constexpr Vec3 min(const Vec3& a, const Vec3& b)
+        {
+            return Vec3(b.x < a.x ? b.x : a.x, b.y < a.y ? b.y : a.y, b.z < a.z ? b.z : a.z);
+        }
+
+        constexpr Vec3 max(const Vec3& a, const Vec3& b)
+        {
+            return Vec3(a.x < b.x ? b.x : a.x, a.y < b.y ? b.y : a.y, a.z < b.z ? b.z : a.z);
+        }
+
+        constexpr float length_squared(const Vec3& v) { return dot(v, v); }
+
+        inline float length(const Vec3& v) { return std::sqrt(dot(v, v)); }
+
+        /**
+         * v unchanged when it has no length.
+         */
+        inline Vec3 normalize(const Vec3& v)
+        {
+            float l = length(v);
+            return l > 0.0f ? v * (1.0f / l) : v;
+        }
+    };
+};
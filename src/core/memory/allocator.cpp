@@ -0,0 +1,406 @@
+#include "allocator.hpp"
+#include "../utils/image.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace VulkanGameEngine
+{
+    namespace Memory
+    {
+        void MemoryAllocator::init(VkDevice device, const Utils::DeviceCapabilities& capabilities, VkDeviceSize preferred_block_size)
+        {
+            this->device = device;
+
+            memory_properties = capabilities.memory_properties;
+            buffer_image_granularity = capabilities.properties.limits.bufferImageGranularity;
+            max_allocation_count = capabilities.properties.limits.maxMemoryAllocationCount;
+
+            preferred_block_size = next_power_of_two(preferred_block_size);
+
+            // Small heaps (e.g. the 256 MiB host visible BAR) get proportionally smaller blocks.
+            for (uint32_t i = 0; i < memory_properties.memoryTypeCount; i++)
+            {
+                VkDeviceSize heap_size = memory_properties.memoryHeaps[memory_properties.memoryTypes[i].heapIndex].size;
+                VkDeviceSize block_size = preferred_block_size;
+                while (block_size > (1ull << 20) && block_size > heap_size / 8)
+                    block_size >>= 1;
+                block_sizes[i] = block_size;
+            }
+        }
+
+        void MemoryAllocator::cleanup()
+        {
+            if (device == VK_NULL_HANDLE)
+                return;
+
+            for (auto& memory_type_pools : pools)
+                for (auto& pool : memory_type_pools)
+                {
+                    for (auto& block : pool)
+                    {
+                        if (!block->buddy.empty())
+                            std::cerr << "\nMemory block released with " << block->buddy.get_statistics().allocation_count << " live allocations.";
+                        free_device_memory(block->memory);
+                    }
+                    pool.clear();
+                }
+
+            for (auto& record : dedicated_allocations)
+                free_device_memory(record.memory);
+            dedicated_allocations.clear();
+
+            device = VK_NULL_HANDLE;
+        }
+
+        Allocation MemoryAllocator::allocate(
+            const VkMemoryRequirements& requirements,
+            VkMemoryPropertyFlags properties,
+            ResourceKind kind,
+            bool dedicated)
+        {
+            uint32_t memory_type = Utils::find_memory_type(memory_properties, requirements.memoryTypeBits, properties);
+
+            VkDeviceSize block_size = block_sizes[memory_type];
+            if (dedicated || requirements.size > block_size / 2)
+                return allocate_dedicated(memory_type, requirements.size, kind);
+
+            auto& pool = get_pool(memory_type, kind);
+            for (auto& block : pool)
+            {
+                Allocation allocation = allocate_from_block(*block, requirements.size, requirements.alignment);
+                if (allocation.is_valid())
+                    return allocation;
+            }
+
+            MemoryBlock* block = create_block(memory_type, kind);
+            Allocation allocation = allocate_from_block(*block, requirements.size, requirements.alignment);
+            if (!allocation.is_valid())
+                throw std::runtime_error("\nFailed to sub-allocate from a new memory block.");
+
+            return allocation;
+        }
+
+        void MemoryAllocator::free(const Allocation& allocation)
+        {
+            if (!allocation.is_valid())
+                return;
+
+            if (allocation.is_dedicated())
+            {
+                auto it = std::find_if(dedicated_allocations.begin(), dedicated_allocations.end(),
+                    [&](const DedicatedRecord& record) { return record.memory == allocation.memory; });
+                if (it == dedicated_allocations.end())
+                    throw std::runtime_error("\nFreed an unknown dedicated allocation.");
+
+                dedicated_allocations.erase(it);
+                free_device_memory(allocation.memory);
+                return;
+            }
+
+            MemoryBlock* block = allocation.block;
+            block->buddy.free(allocation.offset);
+            block->requested_bytes -= allocation.size;
+
+            if (!block->buddy.empty())
+                return;
+
+            // Keep a single empty block around so alloc / free cycles do not hit vkAllocateMemory.
+            auto& pool = get_pool(block->memory_type, block->kind);
+            size_t empty_blocks = std::count_if(pool.begin(), pool.end(),
+                [](const std::unique_ptr<MemoryBlock>& b) { return b->buddy.empty(); });
+
+            if (empty_blocks > 1)
+            {
+                auto it = std::find_if(pool.begin(), pool.end(),
+                    [&](const std::unique_ptr<MemoryBlock>& b) { return b.get() == block; });
+                free_device_memory(block->memory);
+                pool.erase(it);
+            }
+        }
+
+        Allocation MemoryAllocator::create_buffer(
+            VkDeviceSize size,
+            VkBufferUsageFlags usage,
+            VkMemoryPropertyFlags properties,
+            VkBuffer& buffer)
+        {
+            VkBufferCreateInfo create_info{};
+            create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+            create_info.size = size;
+            create_info.usage = usage;
+            create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+            if (vkCreateBuffer(device, &create_info, nullptr, &buffer) != VK_SUCCESS)
+                throw std::runtime_error("\nFailed to create buffer.");
+
+            VkMemoryRequirements memory_requirements;
+            vkGetBufferMemoryRequirements(device, buffer, &memory_requirements);
+
+            Allocation allocation = allocate(memory_requirements, properties, ResourceKind::Linear);
+            vkBindBufferMemory(device, buffer, allocation.memory, allocation.offset);
+
+            return allocation;
+        }
+
+        Allocation MemoryAllocator::create_image(
+            VkExtent2D extent,
+            VkFormat format,
+            VkImageTiling tiling,
+            VkImageUsageFlags usage,
+            VkMemoryPropertyFlags properties,
+            VkImage& image,
+            bool dedicated,
+            uint32_t mip_levels)
+        {
+            VkImageCreateInfo create_info{};
+            create_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+            create_info.imageType = VK_IMAGE_TYPE_2D;
+            create_info.extent.width = extent.width;
+            create_info.extent.height = extent.height;
+            create_info.extent.depth = 1;
+            create_info.mipLevels = mip_levels;
+            create_info.arrayLayers = 1;
+            create_info.format = format;
+            create_info.tiling = tiling;
+            create_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            create_info.usage = usage;
+            create_info.samples = VK_SAMPLE_COUNT_1_BIT;
+            create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+            if (vkCreateImage(device, &create_info, nullptr, &image) != VK_SUCCESS)
+                throw std::runtime_error("\nFailed to create image.");
+
+            VkMemoryRequirements memory_requirements;
+            vkGetImageMemoryRequirements(device, image, &memory_requirements);
+
+            ResourceKind kind = tiling == VK_IMAGE_TILING_OPTIMAL ? ResourceKind::Optimal : ResourceKind::Linear;
+            Allocation allocation = allocate(memory_requirements, properties, kind, dedicated);
+            vkBindImageMemory(device, image, allocation.memory, allocation.offset);
+
+            return allocation;
+        }
+
+        void MemoryAllocator::destroy_buffer(VkBuffer buffer, const Allocation& allocation)
+        {
+            vkDestroyBuffer(device, buffer, nullptr);
+            this->free(allocation);
+        }
+
+        void MemoryAllocator::destroy_image(VkImage image, const Allocation& allocation)
+        {
+            vkDestroyImage(device, image, nullptr);
+            this->free(allocation);
+        }
+
+        std::vector<DefragmentationMove> MemoryAllocator::plan_defragmentation(
+            const std::vector<Allocation>& movable,
+            VkDeviceSize max_bytes)
+        {
+            std::vector<DefragmentationMove> moves;
+            VkDeviceSize moved_bytes = 0;
+
+            // Move out of the sparsest blocks first, into the densest ones.
+            std::vector<Allocation> candidates;
+            for (const auto& allocation : movable)
+                if (allocation.is_valid() && !allocation.is_dedicated())
+                    candidates.push_back(allocation);
+
+            std::sort(candidates.begin(), candidates.end(), [](const Allocation& a, const Allocation& b) {
+                return a.block->buddy.get_used_bytes() < b.block->buddy.get_used_bytes();
+            });
+
+            for (const auto& source : candidates)
+            {
+                if (moved_bytes + source.size > max_bytes)
+                    break;
+
+                auto& pool = get_pool(source.memory_type, source.kind);
+
+                std::vector<MemoryBlock*> targets;
+                for (auto& block : pool)
+                    if (block.get() != source.block && block->buddy.get_used_bytes() > source.block->buddy.get_used_bytes())
+                        targets.push_back(block.get());
+
+                std::sort(targets.begin(), targets.end(), [](const MemoryBlock* a, const MemoryBlock* b) {
+                    return a->buddy.get_used_bytes() > b->buddy.get_used_bytes();
+                });
+
+                // The source block size is at least the original alignment, so reuse it.
+                VkDeviceSize alignment = source.block->buddy.allocation_size(source.offset);
+
+                for (MemoryBlock* target : targets)
+                {
+                    Allocation destination = allocate_from_block(*target, source.size, alignment);
+                    if (destination.is_valid())
+                    {
+                        moves.push_back({source, destination});
+                        moved_bytes += source.size;
+                        break;
+                    }
+                }
+            }
+
+            return moves;
+        }
+
+        void MemoryAllocator::release_empty_blocks()
+        {
+            for (auto& memory_type_pools : pools)
+                for (auto& pool : memory_type_pools)
+                {
+                    auto it = std::remove_if(pool.begin(), pool.end(), [this](const std::unique_ptr<MemoryBlock>& block) {
+                        if (!block->buddy.empty())
+                            return false;
+                        free_device_memory(block->memory);
+                        return true;
+                    });
+                    pool.erase(it, pool.end());
+                }
+        }
+
+        std::vector<HeapStatistics> MemoryAllocator::get_statistics() const
+        {
+            std::vector<HeapStatistics> heaps(memory_properties.memoryHeapCount);
+            for (uint32_t i = 0; i < memory_properties.memoryHeapCount; i++)
+            {
+                heaps[i].heap_index = i;
+                heaps[i].heap_size = memory_properties.memoryHeaps[i].size;
+                heaps[i].flags = memory_properties.memoryHeaps[i].flags;
+            }
+
+            for (uint32_t type = 0; type < memory_properties.memoryTypeCount; type++)
+            {
+                HeapStatistics& heap = heaps[memory_properties.memoryTypes[type].heapIndex];
+
+                for (const auto& pool : pools[type])
+                    for (const auto& block : pool)
+                    {
+                        BuddyAllocator::Statistics statistics = block->buddy.get_statistics();
+
+                        heap.block_count++;
+                        heap.allocation_count += statistics.allocation_count;
+                        heap.reserved_bytes += statistics.size;
+                        heap.used_bytes += statistics.used_bytes;
+                        heap.requested_bytes += block->requested_bytes;
+                        heap.free_bytes += statistics.free_bytes;
+                        heap.largest_free_block = std::max(heap.largest_free_block, statistics.largest_free_block);
+                    }
+            }
+
+            for (const auto& record : dedicated_allocations)
+            {
+                HeapStatistics& heap = heaps[memory_properties.memoryTypes[record.memory_type].heapIndex];
+                heap.dedicated_count++;
+                heap.allocation_count++;
+                heap.reserved_bytes += record.size;
+                heap.used_bytes += record.size;
+                heap.requested_bytes += record.size;
+            }
+
+            return heaps;
+        }
+
+        void MemoryAllocator::print_statistics(std::ostream& out) const
+        {
+            char line[256];
+            for (const auto& heap : get_statistics())
+            {
+                if (heap.reserved_bytes == 0)
+                    continue;
+
+                snprintf(line, sizeof(line),
+                    "Heap %u%s: %u blocks, %u dedicated, %u allocations, reserved %.1f MiB, used %.1f MiB (requested %.1f MiB), free %.1f MiB, fragmentation %.1f%%\n",
+                    heap.heap_index,
+                    (heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) ? " (device local)" : "",
+                    heap.block_count, heap.dedicated_count, heap.allocation_count,
+                    heap.reserved_bytes / 1048576.0, heap.used_bytes / 1048576.0, heap.requested_bytes / 1048576.0,
+                    heap.free_bytes / 1048576.0, heap.fragmentation() * 100.0);
+                out << line;
+            }
+        }
+
+        VkDeviceMemory MemoryAllocator::allocate_device_memory(uint32_t memory_type, VkDeviceSize size)
+        {
+            if (max_allocation_count && device_allocation_count >= max_allocation_count)
+                throw std::runtime_error("\nmaxMemoryAllocationCount reached.");
+
+            VkMemoryAllocateInfo allocate_info{};
+            allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+            allocate_info.allocationSize = size;
+            allocate_info.memoryTypeIndex = memory_type;
+
+            VkDeviceMemory memory;
+            if (vkAllocateMemory(device, &allocate_info, nullptr, &memory) != VK_SUCCESS)
+                throw std::runtime_error("\nFailed to allocate device memory.");
+
+            device_allocation_count++;
+            return memory;
+        }
+
+        void MemoryAllocator::free_device_memory(VkDeviceMemory memory)
+        {
+            // Freeing memory implicitly unmaps it.
+            vkFreeMemory(device, memory, nullptr);
+            device_allocation_count--;
+        }
+
+        MemoryBlock* MemoryAllocator::create_block(uint32_t memory_type, ResourceKind kind)
+        {
+            auto block = std::make_unique<MemoryBlock>();
+            block->memory_type = memory_type;
+            block->kind = kind;
+            block->buddy.init(block_sizes[memory_type], min_block_size);
+            block->memory = allocate_device_memory(memory_type, block_sizes[memory_type]);
+
+            if (is_host_visible(memory_type))
+            {
+                void* mapped = nullptr;
+                if (vkMapMemory(device, block->memory, 0, VK_WHOLE_SIZE, 0, &mapped) != VK_SUCCESS)
+                    throw std::runtime_error("\nFailed to map memory block.");
+                block->mapped = static_cast<uint8_t*>(mapped);
+            }
+
+            auto& pool = get_pool(memory_type, kind);
+            pool.push_back(std::move(block));
+            return pool.back().get();
+        }
+
+        Allocation MemoryAllocator::allocate_from_block(MemoryBlock& block, VkDeviceSize size, VkDeviceSize alignment)
+        {
+            uint64_t offset = block.buddy.allocate(size, alignment);
+            if (offset == BuddyAllocator::invalid_offset)
+                return Allocation{};
+
+            block.requested_bytes += size;
+
+            Allocation allocation;
+            allocation.memory = block.memory;
+            allocation.offset = offset;
+            allocation.size = size;
+            allocation.memory_type = block.memory_type;
+            allocation.kind = block.kind;
+            allocation.block = &block;
+            allocation.mapped = block.mapped ? block.mapped + offset : nullptr;
+            return allocation;
+        }
+
+        Allocation MemoryAllocator::allocate_dedicated(uint32_t memory_type, VkDeviceSize size, ResourceKind kind)
+        {
+            Allocation allocation;
+            allocation.memory = allocate_device_memory(memory_type, size);
+            allocation.size = size;
+            allocation.memory_type = memory_type;
+            allocation.kind = kind;
+
+            if (is_host_visible(memory_type))
+            {
+                if (vkMapMemory(device, allocation.memory, 0, VK_WHOLE_SIZE, 0, &allocation.mapped) != VK_SUCCESS)
+                    throw std::runtime_error("\nFailed to map dedicated allocation.");
+            }
+
+            dedicated_allocations.push_back({allocation.memory, memory_type, size});
+            return allocation;
+        }
+    };
+};
@@ -0,0 +1,209 @@
+#pragma once
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-09-26
+ *
+ */
+
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <stdexcept>
+
+#include "../utils/platform.hpp"
+#include "../utils/device_capabilities.hpp"
+#include "buddy.hpp"
+
+namespace VulkanGameEngine
+{
+    namespace Memory
+    {
+        /**
+         * Buffers and linear images never share a block with optimal images,
+         * which keeps bufferImageGranularity out of the sub-allocator entirely.
+         */
+        enum class ResourceKind
+        {
+            Linear = 0,
+            Optimal = 1
+        };
+
+        struct MemoryBlock
+        {
+            VkDeviceMemory memory = VK_NULL_HANDLE;
+            uint32_t memory_type = 0;
+            ResourceKind kind = ResourceKind::Linear;
+            BuddyAllocator buddy;
+            uint8_t* mapped = nullptr;
+            VkDeviceSize requested_bytes = 0;
+        };
+
+        struct Allocation
+        {
+            VkDeviceMemory memory = VK_NULL_HANDLE;
+            VkDeviceSize offset = 0;
+            VkDeviceSize size = 0;
+            uint32_t memory_type = 0;
+            ResourceKind kind = ResourceKind::Linear;
+
+            // nullptr for dedicated allocations.
+            MemoryBlock* block = nullptr;
+
+            // Set when the memory type is host visible; memory is mapped for its whole lifetime.
+            void* mapped = nullptr;
+
+            bool is_valid() const { return memory != VK_NULL_HANDLE; }
+
+            bool is_dedicated() const { return memory != VK_NULL_HANDLE && block == nullptr; }
+        };
+
+        struct HeapStatistics
+        {
+            uint32_t heap_index = 0;
+            VkDeviceSize heap_size = 0;
+            VkMemoryHeapFlags flags = 0;
+
+            uint32_t block_count = 0;
+            uint32_t dedicated_count = 0;
+            uint32_t allocation_count = 0;
+
+            // Bytes obtained from vkAllocateMemory, blocks and dedicated allocations together.
+            VkDeviceSize reserved_bytes = 0;
+            // Bytes handed out, rounded to buddy block sizes.
+            VkDeviceSize used_bytes = 0;
+            // Bytes the callers asked for.
+            VkDeviceSize requested_bytes = 0;
+            VkDeviceSize free_bytes = 0;
+            VkDeviceSize largest_free_block = 0;
+
+            /**
+             * 0 when all free memory is one contiguous range, close to 1 when it is scattered.
+             */
+            double fragmentation() const
+            {
+                return free_bytes ? 1.0 - static_cast<double>(largest_free_block) / free_bytes : 0.0;
+            }
+        };
+
+        /**
+         * One step of a defragmentation pass. destination is already reserved;
+         * the caller creates a new resource bound to it, copies the contents,
+         * and frees source once the copy has completed.
+         */
+        struct DefragmentationMove
+        {
+            Allocation source;
+            Allocation destination;
+        };
+
+        /**
+         * Sub-allocates resources from large VkDeviceMemory blocks, one set of
+         * blocks per memory type and resource kind, using a buddy allocator
+         * per block. Large resources and render targets get dedicated allocations.
+         */
+        class MemoryAllocator
+        {
+            private:
+                struct DedicatedRecord
+                {
+                    VkDeviceMemory memory;
+                    uint32_t memory_type;
+                    VkDeviceSize size;
+                };
+
+                VkDevice device = VK_NULL_HANDLE;
+
+                VkPhysicalDeviceMemoryProperties memory_properties{};
+                VkDeviceSize buffer_image_granularity = 1;
+                uint32_t max_allocation_count = 0;
+
+                VkDeviceSize block_sizes[VK_MAX_MEMORY_TYPES]{};
+                std::vector<std::unique_ptr<MemoryBlock>> pools[VK_MAX_MEMORY_TYPES][2];
+                std::vector<DedicatedRecord> dedicated_allocations;
+
+                uint32_t device_allocation_count = 0;
+
+                static const VkDeviceSize min_block_size = 256;
+
+            public:
+                void init(VkDevice device, const Utils::DeviceCapabilities& capabilities, VkDeviceSize preferred_block_size = 256ull << 20);
+
+                void cleanup();
+
+                /**
+                 * Allocations larger than half a block are always dedicated.
+                 */
+                Allocation allocate(
+                    const VkMemoryRequirements& requirements,
+                    VkMemoryPropertyFlags properties,
+                    ResourceKind kind,
+                    bool dedicated = false);
+
+                void free(const Allocation& allocation);
+
+                Allocation create_buffer(
+                    VkDeviceSize size,
+                    VkBufferUsageFlags usage,
+                    VkMemoryPropertyFlags properties,
+                    VkBuffer& buffer);
+
+                Allocation create_image(
+                    VkExtent2D extent,
+                    VkFormat format,
+                    VkImageTiling tiling,
+                    VkImageUsageFlags usage,
+                    VkMemoryPropertyFlags properties,
+                    VkImage& image,
+                    bool dedicated = false,
+                    uint32_t mip_levels = 1);
+
+                void destroy_buffer(VkBuffer buffer, const Allocation& allocation);
+
+                void destroy_image(VkImage image, const Allocation& allocation);
+
+                /**
+                 * Reserve new locations for the given allocations so the sparsest blocks
+                 * can be emptied. Only block allocations are moved, into blocks that are
+                 * denser than their current one. Stops after max_bytes.
+                 * Call release_empty_blocks() once the sources have been freed.
+                 */
+                std::vector<DefragmentationMove> plan_defragmentation(
+                    const std::vector<Allocation>& movable,
+                    VkDeviceSize max_bytes = ~0ull);
+
+                void release_empty_blocks();
+
+                std::vector<HeapStatistics> get_statistics() const;
+
+                void print_statistics(std::ostream& out) const;
+
+                uint32_t get_device_allocation_count() const { return device_allocation_count; }
+
+                VkDeviceSize get_buffer_image_granularity() const { return buffer_image_granularity; }
+
+                const VkPhysicalDeviceMemoryProperties& get_memory_properties() const { return memory_properties; }
+
+            private:
+                std::vector<std::unique_ptr<MemoryBlock>>& get_pool(uint32_t memory_type, ResourceKind kind)
+                {
+                    return pools[memory_type][static_cast<int>(kind)];
+                }
+
+                VkDeviceMemory allocate_device_memory(uint32_t memory_type, VkDeviceSize size);
+
+                void free_device_memory(VkDeviceMemory memory);
+
+                MemoryBlock* create_block(uint32_t memory_type, ResourceKind kind);
+
+                Allocation allocate_from_block(MemoryBlock& block, VkDeviceSize size, VkDeviceSize alignment);
+
+                Allocation allocate_dedicated(uint32_t memory_type, VkDeviceSize size, ResourceKind kind);
+
+                bool is_host_visible(uint32_t memory_type) const
+                {
+                    return memory_properties.memoryTypes[memory_type].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+                }
+        };
+    };
+};
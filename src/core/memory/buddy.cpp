@@ -0,0 +1,189 @@
+#include "buddy.hpp"
+
+#include <algorithm>
+
+namespace VulkanGameEngine
+{
+    namespace Memory
+    {
+        static const uint8_t no_allocation = 0xFF;
+
+        void BuddyAllocator::init(uint64_t size, uint64_t min_block_size)
+        {
+            if (!is_power_of_two(size) || !is_power_of_two(min_block_size) || min_block_size > size)
+                throw std::runtime_error("\nBuddy allocator sizes must be powers of two.");
+
+            this->size = size;
+            this->min_block_size = min_block_size;
+
+            min_block_shift = 0;
+            while ((1ull << min_block_shift) < min_block_size)
+                min_block_shift++;
+
+            level_count = 1;
+            while ((size >> (level_count - 1)) > min_block_size)
+                level_count++;
+
+            uint64_t node_count = (1ull << level_count) - 1;
+            free_bits.assign((node_count + 63) / 64, 0);
+            free_lists.assign(level_count, {});
+            free_counts.assign(level_count, 0);
+            allocation_levels.assign(size / min_block_size, no_allocation);
+
+            used_bytes = 0;
+            allocation_count = 0;
+
+            push_free(0, 0);
+        }
+
+        uint64_t BuddyAllocator::allocate(uint64_t size, uint64_t alignment)
+        {
+            uint64_t block_size = next_power_of_two(std::max(std::max(size, alignment), min_block_size));
+            if (size == 0 || block_size > this->size)
+                return invalid_offset;
+
+            uint32_t level = 0;
+            while ((this->size >> level) > block_size)
+                level++;
+
+            // Smallest free block that fits, walking up towards the root.
+            int32_t found = static_cast<int32_t>(level);
+            while (found >= 0 && free_counts[found] == 0)
+                found--;
+            if (found < 0)
+                return invalid_offset;
+
+            uint64_t index = pop_free(static_cast<uint32_t>(found));
+
+            // Split down, keeping the left half and freeing the right one.
+            for (uint32_t l = static_cast<uint32_t>(found); l < level; l++)
+            {
+                index <<= 1;
+                push_free(l + 1, index + 1);
+            }
+
+            uint64_t offset = index * block_size;
+            allocation_levels[offset >> min_block_shift] = static_cast<uint8_t>(level);
+
+            used_bytes += block_size;
+            allocation_count++;
+
+            return offset;
+        }
+
+        void BuddyAllocator::free(uint64_t offset)
+        {
+            if (offset >= size || allocation_levels[offset >> min_block_shift] == no_allocation)
+                throw std::runtime_error("\nBuddy allocator freed an unknown offset.");
+
+            uint32_t level = allocation_levels[offset >> min_block_shift];
+            allocation_levels[offset >> min_block_shift] = no_allocation;
+
+            uint64_t block_size = this->size >> level;
+            uint64_t index = offset / block_size;
+
+            used_bytes -= block_size;
+            allocation_count--;
+
+            // Merge with the buddy for as long as it is free.
+            while (level > 0 && is_free(level, index ^ 1))
+            {
+                set_free(level, index ^ 1, false);
+                free_counts[level]--;
+                index >>= 1;
+                level--;
+            }
+
+            push_free(level, index);
+        }
+
+        uint64_t BuddyAllocator::allocation_size(uint64_t offset) const
+        {
+            if (offset >= size || allocation_levels[offset >> min_block_shift] == no_allocation)
+                return 0;
+
+            return size >> allocation_levels[offset >> min_block_shift];
+        }
+
+        uint64_t BuddyAllocator::largest_free_block() const
+        {
+            for (uint32_t level = 0; level < level_count; level++)
+                if (free_counts[level] > 0)
+                    return size >> level;
+            return 0;
+        }
+
+        BuddyAllocator::Statistics BuddyAllocator::get_statistics() const
+        {
+            Statistics statistics;
+            statistics.size = size;
+            statistics.used_bytes = used_bytes;
+            statistics.free_bytes = size - used_bytes;
+            statistics.largest_free_block = largest_free_block();
+            statistics.allocation_count = allocation_count;
+            return statistics;
+        }
+
+        bool BuddyAllocator::is_free(uint32_t level, uint64_t index) const
+        {
+            uint64_t node = node_index(level, index);
+            return (free_bits[node >> 6] >> (node & 63)) & 1;
+        }
+
+        void BuddyAllocator::set_free(uint32_t level, uint64_t index, bool free)
+        {
+            uint64_t node = node_index(level, index);
+            if (free)
+                free_bits[node >> 6] |= 1ull << (node & 63);
+            else
+                free_bits[node >> 6] &= ~(1ull << (node & 63));
+        }
+
+        void BuddyAllocator::push_free(uint32_t level, uint64_t index)
+        {
+            std::vector<uint64_t>& list = free_lists[level];
+
+            // Drop stale entries before the list grows out of proportion.
+            if (list.size() > 2 * free_counts[level] + 64)
+            {
+                size_t kept = 0;
+                for (size_t i = 0; i < list.size(); i++)
+                {
+                    // Clear the bit while compacting so duplicates of the same node are dropped.
+                    if (is_free(level, list[i]))
+                    {
+                        set_free(level, list[i], false);
+                        list[kept++] = list[i];
+                    }
+                }
+                list.resize(kept);
+                for (size_t i = 0; i < kept; i++)
+                    set_free(level, list[i], true);
+            }
+
+            set_free(level, index, true);
+            list.push_back(index);
+            free_counts[level]++;
+        }
+
+        uint64_t BuddyAllocator::pop_free(uint32_t level)
+        {
+            std::vector<uint64_t>& list = free_lists[level];
+
+            while (!list.empty())
+            {
+                uint64_t index = list.back();
+                list.pop_back();
+
+                if (is_free(level, index))
+                {
+                    set_free(level, index, false);
+                    free_counts[level]--;
+                    return index;
+                }
+            }
+
+            throw std::runtime_error("\nBuddy allocator free list is out of sync.");
+        }
+    };
+};
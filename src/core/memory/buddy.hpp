@@ -0,0 +1,116 @@
+#pragma once
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-09-26
+ *
+ */
+
+#include <iostream>
+#include <vector>
+#include <cstdint>
+#include <stdexcept>
+
+namespace VulkanGameEngine
+{
+    namespace Memory
+    {
+        /**
+         * Binary buddy allocator over an abstract range [0, size).
+         * It only hands out offsets, so it is independent of Vulkan and can be
+         * benchmarked on the CPU.
+         *
+         * Every block is aligned to its own size, so any alignment up to the
+         * rounded allocation size comes for free.
+         */
+        class BuddyAllocator
+        {
+            public:
+                static const uint64_t invalid_offset = ~0ull;
+
+                struct Statistics
+                {
+                    uint64_t size = 0;
+                    uint64_t used_bytes = 0;
+                    uint64_t free_bytes = 0;
+                    uint64_t largest_free_block = 0;
+                    uint32_t allocation_count = 0;
+                };
+
+            private:
+                uint64_t size = 0;
+                uint64_t min_block_size = 0;
+                uint32_t level_count = 0;
+                uint32_t min_block_shift = 0;
+
+                // One bit per node of the tree, level by level; set when the node is a free block.
+                std::vector<uint64_t> free_bits;
+
+                // Free lists per level. Entries are removed lazily: a node is only
+                // handed out if its free bit is still set when it is popped.
+                std::vector<std::vector<uint64_t>> free_lists;
+                std::vector<uint64_t> free_counts;
+
+                // Level of the allocation starting at each min sized block, 0xFF if none.
+                std::vector<uint8_t> allocation_levels;
+
+                uint64_t used_bytes = 0;
+                uint32_t allocation_count = 0;
+
+            public:
+                BuddyAllocator() = default;
+
+                BuddyAllocator(uint64_t size, uint64_t min_block_size) { init(size, min_block_size); }
+
+                /**
+                 * size and min_block_size must be powers of two.
+                 */
+                void init(uint64_t size, uint64_t min_block_size);
+
+                /**
+                 * Returns invalid_offset when no block is large enough.
+                 */
+                uint64_t allocate(uint64_t size, uint64_t alignment = 1);
+
+                void free(uint64_t offset);
+
+                /**
+                 * Size of the block backing the allocation at offset.
+                 */
+                uint64_t allocation_size(uint64_t offset) const;
+
+                bool empty() const { return allocation_count == 0; }
+
+                uint64_t get_size() const { return size; }
+
+                uint64_t get_used_bytes() const { return used_bytes; }
+
+                uint64_t largest_free_block() const;
+
+                Statistics get_statistics() const;
+
+            private:
+                uint64_t node_index(uint32_t level, uint64_t index) const { return (1ull << level) - 1 + index; }
+
+                bool is_free(uint32_t level, uint64_t index) const;
+
+                void set_free(uint32_t level, uint64_t index, bool free);
+
+                void push_free(uint32_t level, uint64_t index);
+
+                uint64_t pop_free(uint32_t level);
+        };
+
+        inline bool is_power_of_two(uint64_t value)
+        {
+            return value && !(value & (value - 1));
+        }
+
+        inline uint64_t next_power_of_two(uint64_t value)
+        {
+            uint64_t result = 1;
+            while (result < value)
+                result <<= 1;
+            return result;
+        }
+    };
+};
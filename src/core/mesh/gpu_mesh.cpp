@@ -0,0 +1,261 @@
+#include "gpu_mesh.hpp"
+#include "../assets/asset_upload.hpp"
+#include "../utils/buffer.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <cstddef>
+
+namespace VulkanGameEngine
+{
+    namespace Mesh
+    {
+        // Covers minStorageBufferOffsetAlignment on every device.
+        static const VkDeviceSize meshlet_section_alignment = 256;
+
+        /**
+         * Places the meshlet vertices and triangles after the descriptors and
+         * returns the size of the meshlet buffer.
+         */
+        static VkDeviceSize place_meshlet_sections(GpuMesh& mesh, uint64_t meshlet_vertex_count, uint64_t meshlet_triangle_bytes)
+        {
+            mesh.meshlet_vertices_offset = Utils::align_up(mesh.meshlet_count * sizeof(Meshlet), meshlet_section_alignment);
+            mesh.meshlet_triangles_offset = Utils::align_up(mesh.meshlet_vertices_offset + meshlet_vertex_count * sizeof(uint32_t), meshlet_section_alignment);
+            return Utils::align_up(mesh.meshlet_triangles_offset + meshlet_triangle_bytes, 4);
+        }
+
+        VertexInputDescription get_vertex_input_description(bool quantized)
+        {
+            VertexInputDescription description;
+            description.binding.binding = 0;
+            description.binding.stride = quantized ? sizeof(QuantizedVertex) : sizeof(Vertex);
+            description.binding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+            VkVertexInputAttributeDescription position{};
+            position.location = 0;
+            VkVertexInputAttributeDescription normal{};
+            normal.location = 1;
+            VkVertexInputAttributeDescription uv{};
+            uv.location = 2;
+
+            if (quantized)
+            {
+                position.format = VK_FORMAT_R16G16B16A16_SFLOAT;
+                position.offset = offsetof(QuantizedVertex, position);
+                normal.format = VK_FORMAT_R16G16_SNORM;
+                normal.offset = offsetof(QuantizedVertex, normal);
+                uv.format = VK_FORMAT_R16G16_UNORM;
+                uv.offset = offsetof(QuantizedVertex, uv);
+            }
+            else
+            {
+                position.format = VK_FORMAT_R32G32B32_SFLOAT;
+                position.offset = offsetof(Vertex, position);
+                normal.format = VK_FORMAT_R32G32B32_SFLOAT;
+                normal.offset = offsetof(Vertex, normal);
+                uv.format = VK_FORMAT_R32G32_SFLOAT;
+                uv.offset = offsetof(Vertex, uv);
+            }
+
+            description.attributes = {position, normal, uv};
+            return description;
+        }
+
+        GpuMesh create_gpu_mesh(const ProcessedMesh& mesh, Memory::MemoryAllocator& allocator, Graphics::Uploader& uploader)
+        {
+            if (mesh.vertex_data.empty() || mesh.indices.empty())
+                throw std::runtime_error("\nCannot upload an empty mesh.");
+
+            GpuMesh result;
+            result.vertex_count = mesh.vertex_count;
+            result.quantized = mesh.quantized;
+            result.index_count = static_cast<uint32_t>(mesh.indices.size());
+            std::memcpy(result.bounds_min, mesh.bounds_min, sizeof(result.bounds_min));
+            std::memcpy(result.bounds_max, mesh.bounds_max, sizeof(result.bounds_max));
+            result.uv_transform = mesh.uv_transform;
+
+            result.vertex_allocation = allocator.create_buffer(
+                mesh.vertex_data.size(),
+                VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                result.vertex_buffer);
+            result.ticket = uploader.upload_buffer(result.vertex_buffer, 0, mesh.vertex_data.data(), mesh.vertex_data.size());
+
+            // 16 bit indices are narrowed straight into the staging ring.
+            bool narrow = mesh.uses_16bit_indices();
+            result.index_type = narrow ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+            VkDeviceSize index_bytes = mesh.indices.size() * (narrow ? sizeof(uint16_t) : sizeof(uint32_t));
+            result.index_allocation = allocator.create_buffer(
+                index_bytes,
+                VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                result.index_buffer);
+            if (narrow)
+            {
+                const std::vector<uint32_t>& indices = mesh.indices;
+                result.ticket = uploader.upload_buffer(result.index_buffer, 0, index_bytes,
+                    [&indices](uint8_t* destination, VkDeviceSize source_offset, VkDeviceSize size) {
+                        // Slices are half the staging ring, so they always split between indices.
+                        size_t first = static_cast<size_t>(source_offset / sizeof(uint16_t));
+                        size_t count = static_cast<size_t>(size / sizeof(uint16_t));
+                        for (size_t i = 0; i < count; i++)
+                        {
+                            uint16_t index = static_cast<uint16_t>(indices[first + i]);
+                            std::memcpy(destination + i * sizeof(uint16_t), &index, sizeof(index));
+                        }
+                    });
+            }
+            else
+                result.ticket = uploader.upload_buffer(result.index_buffer, 0, mesh.indices.data(), index_bytes);
+
+            const MeshletData& meshlets = mesh.meshlets;
+            result.meshlet_count = static_cast<uint32_t>(meshlets.meshlets.size());
+            if (meshlets.meshlets.empty())
+                return result;
+
+            VkDeviceSize meshlet_bytes = place_meshlet_sections(result, meshlets.vertices.size(), meshlets.triangles.size());
+
+            std::vector<uint8_t> packed(static_cast<size_t>(meshlet_bytes), 0);
+            std::memcpy(packed.data(), meshlets.meshlets.data(), meshlets.meshlets.size() * sizeof(Meshlet));
+            std::memcpy(packed.data() + result.meshlet_vertices_offset, meshlets.vertices.data(), meshlets.vertices.size() * sizeof(uint32_t));
+            std::memcpy(packed.data() + result.meshlet_triangles_offset, meshlets.triangles.data(), meshlets.triangles.size());
+
+            result.meshlet_allocation = allocator.create_buffer(
+                meshlet_bytes,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                result.meshlet_buffer);
+            result.ticket = uploader.upload_buffer(result.meshlet_buffer, 0, packed.data(), meshlet_bytes);
+            return result;
+        }
+
+        GpuMesh create_gpu_mesh(
+            const Assets::AssetPack& pack,
+            const Assets::PackEntry& entry,
+            Memory::MemoryAllocator& allocator,
+            Graphics::Uploader& uploader,
+            Jobs::JobSystem* jobs)
+        {
+            std::string name = pack.get_name(entry);
+            auto fail = [&](const char* reason) {
+                throw std::runtime_error("\nInvalid mesh file " + name + ": " + reason + ".");
+            };
+
+            if (entry.size < sizeof(MeshFileHeader))
+                fail("truncated header");
+
+            MeshFileHeader header;
+            pack.read(entry, 0, sizeof(header), reinterpret_cast<uint8_t*>(&header));
+            MeshFileLayout layout = get_mesh_file_layout(header, entry.size, name);
+            if (header.vertex_count == 0 || header.index_count == 0)
+                throw std::runtime_error("\nCannot upload an empty mesh.");
+
+            pack.prefetch(entry);
+
+            GpuMesh result;
+            result.vertex_count = header.vertex_count;
+            result.quantized = (header.flags & mesh_file_quantized) != 0;
+            result.index_count = header.index_count;
+            std::memcpy(result.bounds_min, header.bounds_min, sizeof(result.bounds_min));
+            std::memcpy(result.bounds_max, header.bounds_max, sizeof(result.bounds_max));
+            std::memcpy(result.uv_transform.offset, header.uv_offset, sizeof(result.uv_transform.offset));
+            std::memcpy(result.uv_transform.scale, header.uv_scale, sizeof(result.uv_transform.scale));
+
+            VkDeviceSize vertex_bytes = layout.indices - layout.vertices;
+            result.vertex_allocation = allocator.create_buffer(
+                vertex_bytes,
+                VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                result.vertex_buffer);
+            result.ticket = Assets::upload_asset_range(pack, entry, layout.vertices, vertex_bytes, uploader, result.vertex_buffer, 0, jobs);
+
+            // The file already holds 16 bit indices whenever they fit.
+            uint32_t index_size = header.index_size;
+            uint32_t vertex_count = header.vertex_count;
+            result.index_type = index_size == 2 ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+            VkDeviceSize index_bytes = static_cast<VkDeviceSize>(header.index_count) * index_size;
+            result.index_allocation = allocator.create_buffer(
+                index_bytes,
+                VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                result.index_buffer);
+            result.ticket = Assets::upload_asset_range(pack, entry, layout.indices, index_bytes, uploader, result.index_buffer, 0, jobs,
+                [&](uint8_t* staged, VkDeviceSize, VkDeviceSize size) {
+                    // Slices are half the staging ring, so they always split between indices.
+                    for (VkDeviceSize i = 0; i < size; i += index_size)
+                    {
+                        uint32_t index;
+                        if (index_size == 2)
+                        {
+                            uint16_t narrow;
+                            std::memcpy(&narrow, staged + i, sizeof(narrow));
+                            index = narrow;
+                        }
+                        else
+                            std::memcpy(&index, staged + i, sizeof(index));
+
+                        if (index >= vertex_count)
+                            fail("index out of range");
+                    }
+                });
+
+            result.meshlet_count = header.meshlet_count;
+            if (header.meshlet_count == 0)
+                return result;
+
+            // The descriptors are small and checked against the other sections on the host.
+            std::vector<Meshlet> meshlets(header.meshlet_count);
+            pack.read(entry, layout.meshlets, meshlets.size() * sizeof(Meshlet), reinterpret_cast<uint8_t*>(meshlets.data()), jobs);
+            for (const Meshlet& meshlet : meshlets)
+            {
+                if (static_cast<uint64_t>(meshlet.vertex_offset) + meshlet.vertex_count > header.meshlet_vertex_count ||
+                    static_cast<uint64_t>(meshlet.triangle_offset) + meshlet.triangle_count * 3ull > header.meshlet_triangle_bytes)
+                    fail("meshlet out of range");
+            }
+
+            VkDeviceSize meshlet_bytes = place_meshlet_sections(result, header.meshlet_vertex_count, header.meshlet_triangle_bytes);
+            result.meshlet_allocation = allocator.create_buffer(
+                meshlet_bytes,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                result.meshlet_buffer);
+            result.ticket = uploader.upload_buffer(result.meshlet_buffer, 0, meshlets.data(), meshlets.size() * sizeof(Meshlet));
+
+            if (header.meshlet_vertex_count > 0)
+                result.ticket = Assets::upload_asset_range(pack, entry, layout.meshlet_vertices, header.meshlet_vertex_count * sizeof(uint32_t),
+                    uploader, result.meshlet_buffer, result.meshlet_vertices_offset, jobs,
+                    [&](uint8_t* staged, VkDeviceSize, VkDeviceSize size) {
+                        for (VkDeviceSize i = 0; i < size; i += sizeof(uint32_t))
+                        {
+                            uint32_t vertex;
+                            std::memcpy(&vertex, staged + i, sizeof(vertex));
+                            if (vertex >= vertex_count)
+                                fail("meshlet vertex out of range");
+                        }
+                    });
+
+            if (header.meshlet_triangle_bytes > 0)
+                result.ticket = Assets::upload_asset_range(pack, entry, layout.meshlet_triangles, header.meshlet_triangle_bytes,
+                    uploader, result.meshlet_buffer, result.meshlet_triangles_offset, jobs);
+            return result;
+        }
+
+        void destroy_gpu_mesh(GpuMesh& mesh, Memory::MemoryAllocator& allocator)
+        {
+            if (mesh.vertex_buffer != VK_NULL_HANDLE)
+                allocator.destroy_buffer(mesh.vertex_buffer, mesh.vertex_allocation);
+            if (mesh.index_buffer != VK_NULL_HANDLE)
+                allocator.destroy_buffer(mesh.index_buffer, mesh.index_allocation);
+            if (mesh.meshlet_buffer != VK_NULL_HANDLE)
+                allocator.destroy_buffer(mesh.meshlet_buffer, mesh.meshlet_allocation);
+            mesh = GpuMesh{};
+        }
+
+        void bind_gpu_mesh(VkCommandBuffer command_buffer, const GpuMesh& mesh)
+        {
+            VkDeviceSize offset = 0;
+            vkCmdBindVertexBuffers(command_buffer, 0, 1, &mesh.vertex_buffer, &offset);
+            vkCmdBindIndexBuffer(command_buffer, mesh.index_buffer, 0, mesh.index_type);
+        }
+    };
+};
@@ -0,0 +1,91 @@
+#pragma once
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-09
+ *
+ */
+
+#include <vector>
+#include <cstdint>
+
+#include "../utils/platform.hpp"
+#include "../memory/allocator.hpp"
+#include "../graphics/uploader.hpp"
+#include "../assets/asset_pack.hpp"
+#include "processed_mesh.hpp"
+
+namespace VulkanGameEngine
+{
+    namespace Mesh
+    {
+        /**
+         * Device local buffers of a processed mesh. The meshlet buffer holds the
+         * Meshlet array, then the meshlet vertex indices and the local triangles,
+         * each at its own offset, for binding as storage buffers.
+         */
+        struct GpuMesh
+        {
+            VkBuffer vertex_buffer = VK_NULL_HANDLE;
+            Memory::Allocation vertex_allocation;
+            uint32_t vertex_count = 0;
+            bool quantized = false;
+
+            VkBuffer index_buffer = VK_NULL_HANDLE;
+            Memory::Allocation index_allocation;
+            VkIndexType index_type = VK_INDEX_TYPE_UINT32;
+            uint32_t index_count = 0;
+
+            VkBuffer meshlet_buffer = VK_NULL_HANDLE;
+            Memory::Allocation meshlet_allocation;
+            uint32_t meshlet_count = 0;
+            VkDeviceSize meshlet_vertices_offset = 0;
+            VkDeviceSize meshlet_triangles_offset = 0;
+
+            float bounds_min[3] = {0.0f, 0.0f, 0.0f};
+            float bounds_max[3] = {0.0f, 0.0f, 0.0f};
+            UvTransform uv_transform;
+
+            // The buffers may be used once this upload has completed.
+            Graphics::UploadTicket ticket = 0;
+
+            bool is_valid() const { return vertex_buffer != VK_NULL_HANDLE; }
+        };
+
+        struct VertexInputDescription
+        {
+            VkVertexInputBindingDescription binding{};
+            std::vector<VkVertexInputAttributeDescription> attributes;
+        };
+
+        /**
+         * Binding 0, locations 0 to 2: position, normal, uv. Quantized normals are
+         * octahedral and need decoding in the vertex shader; quantized uvs need
+         * the mesh's uv transform.
+         */
+        VertexInputDescription get_vertex_input_description(bool quantized);
+
+        /**
+         * Creates the buffers and queues their uploads; the caller flushes the uploader.
+         */
+        GpuMesh create_gpu_mesh(const ProcessedMesh& mesh, Memory::MemoryAllocator& allocator, Graphics::Uploader& uploader);
+
+        /**
+         * Same as above from a mesh file stored in a pack. The sections are read,
+         * or decompressed on the job system, straight into the staging ring and
+         * validated there; only the meshlet descriptors go through host memory.
+         */
+        GpuMesh create_gpu_mesh(
+            const Assets::AssetPack& pack,
+            const Assets::PackEntry& entry,
+            Memory::MemoryAllocator& allocator,
+            Graphics::Uploader& uploader,
+            Jobs::JobSystem* jobs = nullptr);
+
+        /**
+         * Destroys the buffers immediately; the device must no longer use them.
+         */
+        void destroy_gpu_mesh(GpuMesh& mesh, Memory::MemoryAllocator& allocator);
+
+        void bind_gpu_mesh(VkCommandBuffer command_buffer, const GpuMesh& mesh);
+    };
+};
@@ -0,0 +1,34 @@
+#pragma once
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-09
+ *
+ */
+
+#include <vector>
+#include <cstdint>
+
+namespace VulkanGameEngine
+{
+    namespace Mesh
+    {
+        /**
+         * Full precision vertex, as loaded from source assets.
+         */
+        struct Vertex
+        {
+            float position[3];
+            float normal[3];
+            float uv[2];
+        };
+
+        /**
+         * Indexed triangle list.
+         */
+        struct MeshData
+        {
+            std::vector<Vertex> vertices;
+            std::vector<uint32_t> indices;
+        };
+    };
+};
@@ -0,0 +1,511 @@
+#include "mesh_optimizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+#include <stdexcept>
+
+namespace VulkanGameEngine
+{
+    namespace Mesh
+    {
+        namespace
+        {
+            const uint32_t invalid_index = ~0u;
+
+            /**
+             * Triangles using each vertex, as a compressed table.
+             */
+            struct Adjacency
+            {
+                std::vector<uint32_t> offsets;
+                std::vector<uint32_t> triangles;
+            };
+
+            void build_adjacency(Adjacency& adjacency, const std::vector<uint32_t>& indices, size_t vertex_count)
+            {
+                adjacency.offsets.assign(vertex_count + 1, 0);
+                for (uint32_t index : indices)
+                {
+                    if (index >= vertex_count)
+                        throw std::runtime_error("\nMesh index out of range.");
+                    adjacency.offsets[index + 1]++;
+                }
+                for (size_t i = 0; i < vertex_count; i++)
+                    adjacency.offsets[i + 1] += adjacency.offsets[i];
+
+                adjacency.triangles.resize(indices.size());
+                std::vector<uint32_t> fill(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+                for (size_t i = 0; i < indices.size(); i++)
+                    adjacency.triangles[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+            }
+
+            /**
+             * FIFO cache simulation; returns whether index missed.
+             */
+            struct FifoCache
+            {
+                std::vector<uint32_t> timestamps;
+                uint32_t time = 0;
+                uint32_t size = 0;
+
+                void reset(size_t vertex_count, uint32_t cache_size)
+                {
+                    size = cache_size;
+                    // Start far enough ahead that every vertex misses once.
+                    time = cache_size + 1;
+                    timestamps.assign(vertex_count, 0);
+                }
+
+                void flush() { time += size + 1; }
+
+                bool access(uint32_t index)
+                {
+                    if (time - timestamps[index] > size)
+                    {
+                        timestamps[index] = time++;
+                        return true;
+                    }
+                    return false;
+                }
+            };
+
+            void sub(float* out, const float* a, const float* b)
+            {
+                out[0] = a[0] - b[0];
+                out[1] = a[1] - b[1];
+                out[2] = a[2] - b[2];
+            }
+
+            void cross(float* out, const float* a, const float* b)
+            {
+                out[0] = a[1] * b[2] - a[2] * b[1];
+                out[1] = a[2] * b[0] - a[0] * b[2];
+                out[2] = a[0] * b[1] - a[1] * b[0];
+            }
+        };
+
+        void optimize_vertex_cache(std::vector<uint32_t>& indices, size_t vertex_count, uint32_t cache_size)
+        {
+            if (indices.size() % 3 != 0)
+                throw std::runtime_error("\nIndex count is not a multiple of 3.");
+
+            size_t triangle_count = indices.size() / 3;
+            if (triangle_count == 0)
+                return;
+
+            Adjacency adjacency;
+            build_adjacency(adjacency, indices, vertex_count);
+
+            std::vector<uint32_t> live_triangles(vertex_count);
+            for (size_t i = 0; i < vertex_count; i++)
+                live_triangles[i] = adjacency.offsets[i + 1] - adjacency.offsets[i];
+
+            std::vector<uint32_t> timestamps(vertex_count, 0);
+            std::vector<bool> emitted(triangle_count, false);
+            std::vector<uint32_t> dead_end;
+            std::vector<uint32_t> candidates;
+            std::vector<uint32_t> result;
+            result.reserve(indices.size());
+
+            uint32_t time = cache_size + 1;
+            uint32_t cursor = 0;
+            uint32_t fanning = indices[0];
+
+            while (fanning != invalid_index)
+            {
+                candidates.clear();
+
+                for (uint32_t i = adjacency.offsets[fanning]; i < adjacency.offsets[fanning + 1]; i++)
+                {
+                    uint32_t triangle = adjacency.triangles[i];
+                    if (emitted[triangle])
+                        continue;
+
+                    for (uint32_t k = 0; k < 3; k++)
+                    {
+                        uint32_t vertex = indices[triangle * 3 + k];
+                        result.push_back(vertex);
+                        dead_end.push_back(vertex);
+                        candidates.push_back(vertex);
+                        live_triangles[vertex]--;
+
+                        if (time - timestamps[vertex] > cache_size)
+                            timestamps[vertex] = time++;
+                    }
+                    emitted[triangle] = true;
+                }
+
+                // Prefer the candidate that has been in the cache longest and will
+                // still be there after its remaining triangles are emitted.
+                uint32_t best = invalid_index;
+                int best_priority = -1;
+                for (uint32_t vertex : candidates)
+                {
+                    if (live_triangles[vertex] == 0)
+                        continue;
+
+                    int priority = 0;
+                    if (time - timestamps[vertex] + 2 * live_triangles[vertex] <= cache_size)
+                        priority = static_cast<int>(time - timestamps[vertex]);
+
+                    if (priority > best_priority)
+                    {
+                        best_priority = priority;
+                        best = vertex;
+                    }
+                }
+
+                if (best == invalid_index)
+                {
+                    while (!dead_end.empty())
+                    {
+                        uint32_t vertex = dead_end.back();
+                        dead_end.pop_back();
+                        if (live_triangles[vertex] > 0)
+                        {
+                            best = vertex;
+                            break;
+                        }
+                    }
+                }
+
+                if (best == invalid_index)
+                {
+                    while (cursor < vertex_count && live_triangles[cursor] == 0)
+                        cursor++;
+                    if (cursor < vertex_count)
+                        best = cursor;
+                }
+
+                fanning = best;
+            }
+
+            indices.swap(result);
+        }
+
+        void optimize_overdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, float threshold, uint32_t cache_size)
+        {
+            if (indices.size() % 3 != 0)
+                throw std::runtime_error("\nIndex count is not a multiple of 3.");
+
+            size_t triangle_count = indices.size() / 3;
+            if (triangle_count == 0)
+                return;
+
+            for (uint32_t index : indices)
+                if (index >= vertices.size())
+                    throw std::runtime_error("\nMesh index out of range.");
+
+            // Hard boundaries: triangles missing on all three vertices, where the
+            // cache optimizer restarted somewhere else.
+            std::vector<uint32_t> hard_clusters;
+            FifoCache cache;
+            cache.reset(vertices.size(), cache_size);
+            for (size_t t = 0; t < triangle_count; t++)
+            {
+                uint32_t misses = 0;
+                for (uint32_t k = 0; k < 3; k++)
+                    misses += cache.access(indices[t * 3 + k]);
+                if (misses == 3 || t == 0)
+                    hard_clusters.push_back(static_cast<uint32_t>(t));
+            }
+            hard_clusters.push_back(static_cast<uint32_t>(triangle_count));
+
+            // Soft boundaries: inside a hard cluster, cut wherever the cost so far
+            // from a cold cache is already close to the cluster's own cost.
+            std::vector<uint32_t> clusters;
+            for (size_t c = 0; c + 1 < hard_clusters.size(); c++)
+            {
+                uint32_t begin = hard_clusters[c];
+                uint32_t end = hard_clusters[c + 1];
+
+                cache.flush();
+                uint32_t cluster_misses = 0;
+                for (uint32_t t = begin; t < end; t++)
+                    for (uint32_t k = 0; k < 3; k++)
+                        cluster_misses += cache.access(indices[t * 3 + k]);
+                float cluster_acmr = static_cast<float>(cluster_misses) / (end - begin);
+
+                cache.flush();
+                clusters.push_back(begin);
+                uint32_t start = begin;
+                uint32_t misses = 0;
+                for (uint32_t t = begin; t < end; t++)
+                {
+                    for (uint32_t k = 0; k < 3; k++)
+                        misses += cache.access(indices[t * 3 + k]);
+
+                    uint32_t count = t + 1 - start;
+                    if (t + 1 < end && static_cast<float>(misses) / count <= threshold * cluster_acmr)
+                    {
+                        clusters.push_back(t + 1);
+                        start = t + 1;
+                        misses = 0;
+                        cache.flush();
+                    }
+                }
+            }
+            clusters.push_back(static_cast<uint32_t>(triangle_count));
+
+            size_t cluster_count = clusters.size() - 1;
+            std::vector<float> centroids(cluster_count * 3, 0.0f);
+            std::vector<float> normals(cluster_count * 3, 0.0f);
+            float mesh_centroid[3] = {0.0f, 0.0f, 0.0f};
+            float mesh_area = 0.0f;
+
+            for (size_t c = 0; c < cluster_count; c++)
+            {
+                float area_sum = 0.0f;
+                float* centroid = &centroids[c * 3];
+                float* normal = &normals[c * 3];
+
+                for (uint32_t t = clusters[c]; t < clusters[c + 1]; t++)
+                {
+                    const float* p0 = vertices[indices[t * 3 + 0]].position;
+                    const float* p1 = vertices[indices[t * 3 + 1]].position;
+                    const float* p2 = vertices[indices[t * 3 + 2]].position;
+
+                    float e1[3], e2[3], n[3];
+                    sub(e1, p1, p0);
+                    sub(e2, p2, p0);
+                    cross(n, e1, e2);
+                    float area = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+                    for (int i = 0; i < 3; i++)
+                    {
+                        centroid[i] += (p0[i] + p1[i] + p2[i]) / 3.0f * area;
+                        normal[i] += n[i];
+                    }
+                    area_sum += area;
+                }
+
+                for (int i = 0; i < 3; i++)
+                {
+                    mesh_centroid[i] += centroid[i];
+                    centroid[i] = area_sum > 0.0f ? centroid[i] / area_sum : 0.0f;
+                }
+                mesh_area += area_sum;
+
+                float length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+                if (length > 0.0f)
+                    for (int i = 0; i < 3; i++)
+                        normal[i] /= length;
+            }
+
+            for (int i = 0; i < 3; i++)
+                mesh_centroid[i] = mesh_area > 0.0f ? mesh_centroid[i] / mesh_area : 0.0f;
+
+            // Clusters facing away from the centre occlude the rest from most directions.
+            std::vector<float> sort_keys(cluster_count);
+            for (size_t c = 0; c < cluster_count; c++)
+            {
+                float offset[3];
+                sub(offset, &centroids[c * 3], mesh_centroid);
+                sort_keys[c] = offset[0] * normals[c * 3 + 0] + offset[1] * normals[c * 3 + 1] + offset[2] * normals[c * 3 + 2];
+            }
+
+            std::vector<uint32_t> order(cluster_count);
+            for (size_t c = 0; c < cluster_count; c++)
+                order[c] = static_cast<uint32_t>(c);
+            std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return sort_keys[a] > sort_keys[b]; });
+
+            std::vector<uint32_t> result;
+            result.reserve(indices.size());
+            for (uint32_t c : order)
+                result.insert(result.end(), indices.begin() + clusters[c] * 3, indices.begin() + clusters[c + 1] * 3);
+
+            indices.swap(result);
+        }
+
+        std::vector<uint32_t> build_vertex_fetch_remap(const std::vector<uint32_t>& indices, size_t vertex_count)
+        {
+            std::vector<uint32_t> remap(vertex_count, invalid_index);
+            uint32_t next = 0;
+            for (uint32_t index : indices)
+            {
+                if (index >= vertex_count)
+                    throw std::runtime_error("\nMesh index out of range.");
+                if (remap[index] == invalid_index)
+                    remap[index] = next++;
+            }
+            return remap;
+        }
+
+        void optimize_vertex_fetch(MeshData& mesh)
+        {
+            std::vector<uint32_t> remap = build_vertex_fetch_remap(mesh.indices, mesh.vertices.size());
+
+            size_t used = 0;
+            for (uint32_t target : remap)
+                used += target != invalid_index;
+
+            std::vector<Vertex> vertices(used);
+            for (size_t i = 0; i < remap.size(); i++)
+                if (remap[i] != invalid_index)
+                    vertices[remap[i]] = mesh.vertices[i];
+
+            for (uint32_t& index : mesh.indices)
+                index = remap[index];
+
+            mesh.vertices.swap(vertices);
+        }
+
+        VertexCacheStatistics analyze_vertex_cache(const std::vector<uint32_t>& indices, size_t vertex_count, uint32_t cache_size)
+        {
+            VertexCacheStatistics result;
+            if (indices.empty())
+                return result;
+
+            FifoCache cache;
+            cache.reset(vertex_count, cache_size);
+            std::vector<bool> used(vertex_count, false);
+            size_t used_count = 0;
+
+            for (uint32_t index : indices)
+            {
+                if (index >= vertex_count)
+                    throw std::runtime_error("\nMesh index out of range.");
+                result.misses += cache.access(index);
+                if (!used[index])
+                {
+                    used[index] = true;
+                    used_count++;
+                }
+            }
+
+            result.acmr = static_cast<float>(result.misses) / (indices.size() / 3);
+            result.atvr = static_cast<float>(result.misses) / used_count;
+            return result;
+        }
+
+        OverdrawStatistics analyze_overdraw(const std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices)
+        {
+            const int resolution = 256;
+
+            OverdrawStatistics result;
+            if (indices.empty())
+                return result;
+
+            float minimum[3] = {FLT_MAX, FLT_MAX, FLT_MAX};
+            float maximum[3] = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+            for (uint32_t index : indices)
+            {
+                if (index >= vertices.size())
+                    throw std::runtime_error("\nMesh index out of range.");
+                for (int i = 0; i < 3; i++)
+                {
+                    minimum[i] = std::min(minimum[i], vertices[index].position[i]);
+                    maximum[i] = std::max(maximum[i], vertices[index].position[i]);
+                }
+            }
+            float extent = std::max(maximum[0] - minimum[0], std::max(maximum[1] - minimum[1], maximum[2] - minimum[2]));
+            float scale = extent > 0.0f ? 1.0f / extent : 0.0f;
+
+            std::vector<float> depth(resolution * resolution);
+
+            // Looking down each axis from both sides. Negating the view axis and
+            // one screen axis keeps the winding, so one backface test fits all six.
+            for (int view = 0; view < 6; view++)
+            {
+                int axis = view / 2;
+                float sign = (view & 1) ? -1.0f : 1.0f;
+                std::fill(depth.begin(), depth.end(), -FLT_MAX);
+
+                for (size_t t = 0; t < indices.size(); t += 3)
+                {
+                    float x[3], y[3], z[3];
+                    for (int k = 0; k < 3; k++)
+                    {
+                        const float* p = vertices[indices[t + k]].position;
+                        float u = (p[(axis + 1) % 3] - minimum[(axis + 1) % 3]) * scale;
+                        float v = (p[(axis + 2) % 3] - minimum[(axis + 2) % 3]) * scale;
+                        if (sign < 0.0f)
+                            u = 1.0f - u;
+                        x[k] = u * resolution;
+                        y[k] = v * resolution;
+                        z[k] = sign * (p[axis] - minimum[axis]) * scale;
+                    }
+
+                    float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+                    if (area <= 0.0f)
+                        continue;
+
+                    int min_x = std::max(0, static_cast<int>(std::floor(std::min(x[0], std::min(x[1], x[2])))));
+                    int max_x = std::min(resolution - 1, static_cast<int>(std::ceil(std::max(x[0], std::max(x[1], x[2])))));
+                    int min_y = std::max(0, static_cast<int>(std::floor(std::min(y[0], std::min(y[1], y[2])))));
+                    int max_y = std::min(resolution - 1, static_cast<int>(std::ceil(std::max(y[0], std::max(y[1], y[2])))));
+
+                    for (int py = min_y; py <= max_y; py++)
+                    {
+                        for (int px = min_x; px <= max_x; px++)
+                        {
+                            float cx = px + 0.5f;
+                            float cy = py + 0.5f;
+                            float w0 = (x[2] - x[1]) * (cy - y[1]) - (y[2] - y[1]) * (cx - x[1]);
+                            float w1 = (x[0] - x[2]) * (cy - y[2]) - (y[0] - y[2]) * (cx - x[2]);
+                            float w2 = (x[1] - x[0]) * (cy - y[0]) - (y[1] - y[0]) * (cx - x[0]);
+                            if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f)
+                                continue;
+
+                            float fragment = (w0 * z[0] + w1 * z[1] + w2 * z[2]) / area;
+                            float& stored = depth[py * resolution + px];
+                            if (fragment > stored)
+                            {
+                                stored = fragment;
+                                result.pixels_shaded++;
+                            }
+                        }
+                    }
+                }
+
+                for (float value : depth)
+                    result.pixels_covered += value != -FLT_MAX;
+            }
+
+            result.overdraw = result.pixels_covered ? static_cast<float>(result.pixels_shaded) / result.pixels_covered : 0.0f;
+            return result;
+        }
+
+        VertexFetchStatistics analyze_vertex_fetch(const std::vector<uint32_t>& indices, size_t vertex_count, size_t vertex_size)
+        {
+            const size_t line_size = 64;
+            const size_t line_count = 64;
+
+            VertexFetchStatistics result;
+            if (indices.empty() || vertex_size == 0)
+                return result;
+
+            // Fully associative FIFO of cache lines.
+            std::vector<size_t> lines(line_count, ~size_t(0));
+            size_t next_line = 0;
+            std::vector<bool> used(vertex_count, false);
+            size_t used_count = 0;
+
+            for (uint32_t index : indices)
+            {
+                if (index >= vertex_count)
+                    throw std::runtime_error("\nMesh index out of range.");
+                if (!used[index])
+                {
+                    used[index] = true;
+                    used_count++;
+                }
+
+                size_t first = index * vertex_size / line_size;
+                size_t last = ((index + 1) * vertex_size - 1) / line_size;
+                for (size_t line = first; line <= last; line++)
+                {
+                    if (std::find(lines.begin(), lines.end(), line) != lines.end())
+                        continue;
+                    lines[next_line] = line;
+                    next_line = (next_line + 1) % line_count;
+                    result.bytes_fetched += line_size;
+                }
+            }
+
+            result.overfetch = static_cast<float>(result.bytes_fetched) / (used_count * vertex_size);
+            return result;
+        }
+    };
+};
@@ -0,0 +1,84 @@
+#pragma once
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-09
+ *
+ */
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "mesh.hpp"
+
+namespace VulkanGameEngine
+{
+    namespace Mesh
+    {
+        struct VertexCacheStatistics
+        {
+            uint64_t misses = 0;
+            // Average cache misses per triangle: 3 worst, 0.5 best for a regular grid.
+            float acmr = 0.0f;
+            // Average transformations per vertex: 1 is optimal.
+            float atvr = 0.0f;
+        };
+
+        struct OverdrawStatistics
+        {
+            uint64_t pixels_covered = 0;
+            uint64_t pixels_shaded = 0;
+            // Shaded over covered: 1 means every pixel is shaded once.
+            float overdraw = 0.0f;
+        };
+
+        struct VertexFetchStatistics
+        {
+            uint64_t bytes_fetched = 0;
+            // Bytes fetched over vertex buffer size: 1 means every byte is read once.
+            float overfetch = 0.0f;
+        };
+
+        /**
+         * Reorders triangles for a FIFO post-transform cache of cache_size entries
+         * (Tipsify, Sander et al. 2007). Linear in the triangle count.
+         */
+        void optimize_vertex_cache(std::vector<uint32_t>& indices, size_t vertex_count, uint32_t cache_size = 16);
+
+        /**
+         * Reorders clusters of an already cache-optimized index buffer so that
+         * outward facing clusters come first, which front-loads occluders from
+         * most view directions. Clusters are split wherever the cache restarts,
+         * and further wherever their running ACMR comes within threshold of the
+         * cluster's, so threshold bounds the vertex cache cost (1.05 = 5% worse at most).
+         */
+        void optimize_overdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, float threshold = 1.05f, uint32_t cache_size = 16);
+
+        /**
+         * Remap table putting vertices in first-use order: remap[old] is the new
+         * index, or UINT32_MAX for vertices no triangle uses.
+         */
+        std::vector<uint32_t> build_vertex_fetch_remap(const std::vector<uint32_t>& indices, size_t vertex_count);
+
+        /**
+         * Reorders the vertices for fetch locality and drops unused ones.
+         */
+        void optimize_vertex_fetch(MeshData& mesh);
+
+        /**
+         * Simulates a FIFO post-transform cache.
+         */
+        VertexCacheStatistics analyze_vertex_cache(const std::vector<uint32_t>& indices, size_t vertex_count, uint32_t cache_size = 16);
+
+        /**
+         * Rasterizes the mesh from the six axis directions in software and counts
+         * depth-tested fragments.
+         */
+        OverdrawStatistics analyze_overdraw(const std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices);
+
+        /**
+         * Simulates a small cache of 64 byte lines in front of the vertex buffer.
+         */
+        VertexFetchStatistics analyze_vertex_fetch(const std::vector<uint32_t>& indices, size_t vertex_count, size_t vertex_size);
+    };
+};
@@ -0,0 +1,190 @@
+#include "meshlets.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+#include <stdexcept>
+
+namespace VulkanGameEngine
+{
+    namespace Mesh
+    {
+        MeshletData build_meshlets(
+            const std::vector<uint32_t>& indices,
+            const std::vector<Vertex>& vertices,
+            uint32_t max_vertices,
+            uint32_t max_triangles)
+        {
+            if (indices.size() % 3 != 0)
+                throw std::runtime_error("\nIndex count is not a multiple of 3.");
+            if (max_vertices < 3 || max_vertices > 256 || max_triangles < 1 || max_triangles > 512)
+                throw std::runtime_error("\nInvalid meshlet limits.");
+
+            MeshletData data;
+
+            // Local index of each mesh vertex in the meshlet being built, 0xff..ff when absent.
+            std::vector<uint32_t> local(vertices.size(), ~0u);
+            Meshlet current;
+
+            auto finish = [&]()
+            {
+                if (current.triangle_count == 0)
+                    return;
+                for (uint32_t i = 0; i < current.vertex_count; i++)
+                    local[data.vertices[current.vertex_offset + i]] = ~0u;
+                data.meshlets.push_back(current);
+
+                current = Meshlet{};
+                current.vertex_offset = static_cast<uint32_t>(data.vertices.size());
+                current.triangle_offset = static_cast<uint32_t>(data.triangles.size());
+            };
+
+            for (size_t t = 0; t < indices.size(); t += 3)
+            {
+                uint32_t a = indices[t + 0];
+                uint32_t b = indices[t + 1];
+                uint32_t c = indices[t + 2];
+                if (a >= vertices.size() || b >= vertices.size() || c >= vertices.size())
+                    throw std::runtime_error("\nMesh index out of range.");
+
+                uint32_t new_vertices = (local[a] == ~0u) + (local[b] == ~0u) + (local[c] == ~0u);
+                if (local[b] == ~0u && b == a)
+                    new_vertices--;
+                if (local[c] == ~0u && (c == a || c == b))
+                    new_vertices--;
+
+                if (current.vertex_count + new_vertices > max_vertices || current.triangle_count + 1 > max_triangles)
+                    finish();
+
+                for (uint32_t vertex : {a, b, c})
+                {
+                    if (local[vertex] == ~0u)
+                    {
+                        local[vertex] = current.vertex_count++;
+                        data.vertices.push_back(vertex);
+                    }
+                    data.triangles.push_back(static_cast<uint8_t>(local[vertex]));
+                }
+                current.triangle_count++;
+            }
+            finish();
+
+            for (Meshlet& meshlet : data.meshlets)
+                compute_meshlet_bounds(meshlet, data, vertices);
+
+            return data;
+        }
+
+        void compute_meshlet_bounds(Meshlet& meshlet, const MeshletData& data, const std::vector<Vertex>& vertices)
+        {
+            const uint32_t* meshlet_vertices = &data.vertices[meshlet.vertex_offset];
+            const uint8_t* triangles = &data.triangles[meshlet.triangle_offset];
+
+            // Bounding sphere around the box centre; loose but cheap and stable.
+            float minimum[3] = {FLT_MAX, FLT_MAX, FLT_MAX};
+            float maximum[3] = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+            for (uint32_t i = 0; i < meshlet.vertex_count; i++)
+            {
+                const float* p = vertices[meshlet_vertices[i]].position;
+                for (int k = 0; k < 3; k++)
+                {
+                    minimum[k] = std::min(minimum[k], p[k]);
+                    maximum[k] = std::max(maximum[k], p[k]);
+                }
+            }
+            for (int k = 0; k < 3; k++)
+                meshlet.center[k] = (minimum[k] + maximum[k]) * 0.5f;
+
+            float radius_squared = 0.0f;
+            for (uint32_t i = 0; i < meshlet.vertex_count; i++)
+            {
+                const float* p = vertices[meshlet_vertices[i]].position;
+                float dx = p[0] - meshlet.center[0];
+                float dy = p[1] - meshlet.center[1];
+                float dz = p[2] - meshlet.center[2];
+                radius_squared = std::max(radius_squared, dx * dx + dy * dy + dz * dz);
+            }
+            meshlet.radius = std::sqrt(radius_squared);
+
+            // Normal cone: the axis is the average face normal, the spread is set
+            // by the face normal furthest from it.
+            std::vector<float> normals(meshlet.triangle_count * 3, 0.0f);
+            std::vector<bool> degenerate(meshlet.triangle_count, false);
+            float axis[3] = {0.0f, 0.0f, 0.0f};
+            for (uint32_t t = 0; t < meshlet.triangle_count; t++)
+            {
+                const float* p0 = vertices[meshlet_vertices[triangles[t * 3 + 0]]].position;
+                const float* p1 = vertices[meshlet_vertices[triangles[t * 3 + 1]]].position;
+                const float* p2 = vertices[meshlet_vertices[triangles[t * 3 + 2]]].position;
+
+                float e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+                float e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+                float* n = &normals[t * 3];
+                n[0] = e1[1] * e2[2] - e1[2] * e2[1];
+                n[1] = e1[2] * e2[0] - e1[0] * e2[2];
+                n[2] = e1[0] * e2[1] - e1[1] * e2[0];
+
+                float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+                if (length == 0.0f)
+                {
+                    degenerate[t] = true;
+                    continue;
+                }
+                for (int k = 0; k < 3; k++)
+                {
+                    n[k] /= length;
+                    axis[k] += n[k];
+                }
+            }
+
+            meshlet.cone_cutoff = 1.0f;
+            for (int k = 0; k < 3; k++)
+            {
+                meshlet.cone_apex[k] = meshlet.center[k];
+                meshlet.cone_axis[k] = 0.0f;
+            }
+
+            float axis_length = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+            if (axis_length == 0.0f)
+                return;
+            for (int k = 0; k < 3; k++)
+                axis[k] /= axis_length;
+
+            float min_dot = 1.0f;
+            for (uint32_t t = 0; t < meshlet.triangle_count; t++)
+            {
+                if (degenerate[t])
+                    continue;
+                const float* n = &normals[t * 3];
+                min_dot = std::min(min_dot, n[0] * axis[0] + n[1] * axis[1] + n[2] * axis[2]);
+            }
+
+            for (int k = 0; k < 3; k++)
+                meshlet.cone_axis[k] = axis[k];
+
+            // Normals spread over a hemisphere or more: no view is backfacing for all.
+            if (min_dot <= 0.0f)
+                return;
+
+            // Move the apex back along the axis until every triangle's plane is
+            // in front of it, so the test from the apex is conservative.
+            float max_t = 0.0f;
+            for (uint32_t t = 0; t < meshlet.triangle_count; t++)
+            {
+                if (degenerate[t])
+                    continue;
+                const float* n = &normals[t * 3];
+                const float* p0 = vertices[meshlet_vertices[triangles[t * 3 + 0]]].position;
+
+                float distance = (p0[0] - meshlet.center[0]) * n[0] + (p0[1] - meshlet.center[1]) * n[1] + (p0[2] - meshlet.center[2]) * n[2];
+                float denominator = axis[0] * n[0] + axis[1] * n[1] + axis[2] * n[2];
+                max_t = std::max(max_t, -distance / denominator);
+            }
+
+            for (int k = 0; k < 3; k++)
+                meshlet.cone_apex[k] = meshlet.center[k] - axis[k] * max_t;
+
+            meshlet.cone_cutoff = std::sqrt(1.0f - min_dot * min_dot);
+        }
+    };
+};
@@ -0,0 +1,74 @@
+#pragma once
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-09
+ *
+ */
+
+#include <vector>
+#include <cstdint>
+
+#include "mesh.hpp"
+
+namespace VulkanGameEngine
+{
+    namespace Mesh
+    {
+        /**
+         * A small cluster of triangles with its own local vertex list, sized for
+         * one mesh shader workgroup. Bounds are in mesh space.
+         */
+        struct Meshlet
+        {
+            // Into MeshletData::vertices and MeshletData::triangles (3 bytes per triangle).
+            uint32_t vertex_offset = 0;
+            uint32_t triangle_offset = 0;
+            uint32_t vertex_count = 0;
+            uint32_t triangle_count = 0;
+
+            float center[3] = {0.0f, 0.0f, 0.0f};
+            float radius = 0.0f;
+
+            /**
+             * The meshlet is entirely backfacing, and can be culled, when
+             * dot(normalize(apex - camera), axis) >= cutoff. cutoff is 1 for
+             * meshlets that can never be culled that way.
+             */
+            float cone_apex[3] = {0.0f, 0.0f, 0.0f};
+            float cone_axis[3] = {0.0f, 0.0f, 0.0f};
+            float cone_cutoff = 1.0f;
+        };
+
+        struct MeshletData
+        {
+            std::vector<Meshlet> meshlets;
+            // Mesh vertex indices, meshlet by meshlet.
+            std::vector<uint32_t> vertices;
+            // Indices into the meshlet's vertex range, three per triangle.
+            std::vector<uint8_t> triangles;
+        };
+
+        /**
+         * Most hardware prefers 64 vertices and 124 triangles (a 128 entry
+         * primitive limit keeps one spare warp lane per 4 triangles).
+         */
+        const uint32_t default_meshlet_vertices = 64;
+        const uint32_t default_meshlet_triangles = 124;
+
+        /**
+         * Splits the index buffer into meshlets in triangle order, so a cache
+         * optimized index buffer gives meshlets with good vertex reuse.
+         * max_vertices must be at most 256, max_triangles at most 512.
+         */
+        MeshletData build_meshlets(
+            const std::vector<uint32_t>& indices,
+            const std::vector<Vertex>& vertices,
+            uint32_t max_vertices = default_meshlet_vertices,
+            uint32_t max_triangles = default_meshlet_triangles);
+
+        /**
+         * Fills in the bounding sphere and normal cone of meshlet.
+         */
+        void compute_meshlet_bounds(Meshlet& meshlet, const MeshletData& data, const std::vector<Vertex>& vertices);
+    };
+};
@@ -0,0 +1,206 @@
+#include "obj_loader.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <vector>
+#include <unordered_map>
+
+namespace VulkanGameEngine
+{
+    namespace Mesh
+    {
+        namespace
+        {
+            struct Corner
+            {
+                int position;
+                int uv;
+                int normal;
+            };
+
+            struct CornerHash
+            {
+                size_t operator()(const Corner& corner) const
+                {
+                    size_t hash = static_cast<uint32_t>(corner.position);
+                    hash = hash * 0x9e3779b1u ^ static_cast<uint32_t>(corner.uv);
+                    hash = hash * 0x9e3779b1u ^ static_cast<uint32_t>(corner.normal);
+                    return hash;
+                }
+            };
+
+            bool operator==(const Corner& a, const Corner& b)
+            {
+                return a.position == b.position && a.uv == b.uv && a.normal == b.normal;
+            }
+
+            /**
+             * OBJ indices are 1-based, negative ones count back from the end.
+             * Returns -1 for a missing index.
+             */
+            int resolve_index(const char*& cursor, size_t count, size_t line_number)
+            {
+                char* end;
+                long value = std::strtol(cursor, &end, 10);
+                if (end == cursor)
+                    return -1;
+                cursor = end;
+
+                long resolved = value < 0 ? static_cast<long>(count) + value : value - 1;
+                if (value == 0 || resolved < 0 || resolved >= static_cast<long>(count))
+                    throw std::runtime_error("\nOBJ index out of range on line " + std::to_string(line_number) + ".");
+                return static_cast<int>(resolved);
+            }
+
+            void compute_normals(MeshData& mesh)
+            {
+                for (Vertex& vertex : mesh.vertices)
+                    vertex.normal[0] = vertex.normal[1] = vertex.normal[2] = 0.0f;
+
+                // The cross product length is twice the area, which weights for free.
+                for (size_t t = 0; t < mesh.indices.size(); t += 3)
+                {
+                    const float* p0 = mesh.vertices[mesh.indices[t + 0]].position;
+                    const float* p1 = mesh.vertices[mesh.indices[t + 1]].position;
+                    const float* p2 = mesh.vertices[mesh.indices[t + 2]].position;
+
+                    float e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+                    float e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+                    float n[3] = {
+                        e1[1] * e2[2] - e1[2] * e2[1],
+                        e1[2] * e2[0] - e1[0] * e2[2],
+                        e1[0] * e2[1] - e1[1] * e2[0]};
+
+                    for (int k = 0; k < 3; k++)
+                        for (int i = 0; i < 3; i++)
+                            mesh.vertices[mesh.indices[t + k]].normal[i] += n[i];
+                }
+
+                for (Vertex& vertex : mesh.vertices)
+                {
+                    float* n = vertex.normal;
+                    float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+                    if (length > 0.0f)
+                    {
+                        n[0] /= length;
+                        n[1] /= length;
+                        n[2] /= length;
+                    }
+                    else
+                        n[2] = 1.0f;
+                }
+            }
+        };
+
+        MeshData load_obj(const std::string& path)
+        {
+            FILE* file = std::fopen(path.c_str(), "rb");
+            if (!file)
+                throw std::runtime_error("\nFailed to open " + path + ".");
+
+            std::vector<float> positions;
+            std::vector<float> uvs;
+            std::vector<float> normals;
+
+            MeshData mesh;
+            std::unordered_map<Corner, uint32_t, CornerHash> corner_vertices;
+            std::vector<uint32_t> polygon;
+            bool missing_normals = false;
+
+            char line[4096];
+            size_t line_number = 0;
+            while (std::fgets(line, sizeof(line), file))
+            {
+                line_number++;
+                const char* cursor = line;
+                while (*cursor == ' ' || *cursor == '\t')
+                    cursor++;
+
+                if (cursor[0] == 'v' && (cursor[1] == ' ' || cursor[1] == '\t'))
+                {
+                    float x = 0.0f, y = 0.0f, z = 0.0f;
+                    std::sscanf(cursor + 2, "%f %f %f", &x, &y, &z);
+                    positions.insert(positions.end(), {x, y, z});
+                }
+                else if (cursor[0] == 'v' && cursor[1] == 't')
+                {
+                    float u = 0.0f, v = 0.0f;
+                    std::sscanf(cursor + 2, "%f %f", &u, &v);
+                    // OBJ puts v = 0 at the bottom, Vulkan samples top down.
+                    uvs.insert(uvs.end(), {u, 1.0f - v});
+                }
+                else if (cursor[0] == 'v' && cursor[1] == 'n')
+                {
+                    float x = 0.0f, y = 0.0f, z = 0.0f;
+                    std::sscanf(cursor + 2, "%f %f %f", &x, &y, &z);
+                    normals.insert(normals.end(), {x, y, z});
+                }
+                else if (cursor[0] == 'f' && (cursor[1] == ' ' || cursor[1] == '\t'))
+                {
+                    cursor++;
+                    polygon.clear();
+
+                    for (;;)
+                    {
+                        while (*cursor == ' ' || *cursor == '\t')
+                            cursor++;
+                        if (*cursor == '\0' || *cursor == '\r' || *cursor == '\n' || *cursor == '#')
+                            break;
+
+                        Corner corner{-1, -1, -1};
+                        corner.position = resolve_index(cursor, positions.size() / 3, line_number);
+                        if (corner.position < 0)
+                            throw std::runtime_error("\nMalformed OBJ face on line " + std::to_string(line_number) + ".");
+                        if (*cursor == '/')
+                        {
+                            cursor++;
+                            if (*cursor != '/')
+                                corner.uv = resolve_index(cursor, uvs.size() / 2, line_number);
+                            if (*cursor == '/')
+                            {
+                                cursor++;
+                                corner.normal = resolve_index(cursor, normals.size() / 3, line_number);
+                            }
+                        }
+                        while (*cursor && *cursor != ' ' && *cursor != '\t' && *cursor != '\r' && *cursor != '\n')
+                            cursor++;
+
+                        auto found = corner_vertices.find(corner);
+                        if (found == corner_vertices.end())
+                        {
+                            Vertex vertex{};
+                            std::memcpy(vertex.position, &positions[corner.position * 3], sizeof(vertex.position));
+                            if (corner.uv >= 0)
+                                std::memcpy(vertex.uv, &uvs[corner.uv * 2], sizeof(vertex.uv));
+                            if (corner.normal >= 0)
+                                std::memcpy(vertex.normal, &normals[corner.normal * 3], sizeof(vertex.normal));
+                            else
+                                missing_normals = true;
+
+                            found = corner_vertices.emplace(corner, static_cast<uint32_t>(mesh.vertices.size())).first;
+                            mesh.vertices.push_back(vertex);
+                        }
+                        polygon.push_back(found->second);
+                    }
+
+                    for (size_t i = 2; i < polygon.size(); i++)
+                        mesh.indices.insert(mesh.indices.end(), {polygon[0], polygon[i - 1], polygon[i]});
+                }
+            }
+
+            bool failed = std::ferror(file) != 0;
+            std::fclose(file);
+            if (failed)
+                throw std::runtime_error("\nFailed to read " + path + ".");
+            if (mesh.indices.empty())
+                throw std::runtime_error("\n" + path + " has no faces.");
+
+            if (missing_normals)
+                compute_normals(mesh);
+
+            return mesh;
+        }
+    };
+};
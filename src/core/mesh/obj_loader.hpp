@@ -0,0 +1,26 @@
+#pragma once
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-09
+ *
+ */
+
+#include <string>
+#include <stdexcept>
+
+#include "mesh.hpp"
+
+namespace VulkanGameEngine
+{
+    namespace Mesh
+    {
+        /**
+         * Loads the geometry of a Wavefront OBJ file: positions, texture
+         * coordinates and normals, polygons triangulated as fans, all groups
+         * merged. Identical position/uv/normal triplets share a vertex. When any
+         * face has no normals, all normals are recomputed as area weighted
+         * smooth normals.
+         */
+        MeshData load_obj(const std::string& path);
+    };
+};
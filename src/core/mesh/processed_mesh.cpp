@@ -0,0 +1,243 @@
+#include "processed_mesh.hpp"
+#include "mesh_optimizer.hpp"
+#include "../utils/mapped_file.hpp"
+
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include <cfloat>
+#include <cstring>
+
+namespace VulkanGameEngine
+{
+    namespace Mesh
+    {
+        static const char mesh_magic[4] = {'V', 'G', 'E', 'M'};
+        static const uint32_t mesh_version = 1;
+
+        ProcessedMesh process_mesh(MeshData mesh, const ProcessOptions& options)
+        {
+            if (mesh.indices.empty() || mesh.indices.size() % 3 != 0)
+                throw std::runtime_error("\nA mesh needs a non-empty triangle list.");
+
+            optimize_vertex_cache(mesh.indices, mesh.vertices.size(), options.cache_size);
+            if (options.overdraw_threshold > 0.0f)
+                optimize_overdraw(mesh.indices, mesh.vertices, options.overdraw_threshold, options.cache_size);
+            optimize_vertex_fetch(mesh);
+
+            ProcessedMesh result;
+            result.vertex_count = static_cast<uint32_t>(mesh.vertices.size());
+            result.indices = mesh.indices;
+
+            for (int k = 0; k < 3; k++)
+            {
+                result.bounds_min[k] = FLT_MAX;
+                result.bounds_max[k] = -FLT_MAX;
+            }
+            for (const Vertex& vertex : mesh.vertices)
+            {
+                for (int k = 0; k < 3; k++)
+                {
+                    result.bounds_min[k] = std::min(result.bounds_min[k], vertex.position[k]);
+                    result.bounds_max[k] = std::max(result.bounds_max[k], vertex.position[k]);
+                }
+            }
+
+            if (options.quantize)
+            {
+                result.quantized = true;
+                result.uv_transform = compute_uv_transform(mesh.vertices);
+                std::vector<QuantizedVertex> quantized = quantize_vertices(mesh.vertices, result.uv_transform);
+
+                result.vertex_stride = sizeof(QuantizedVertex);
+                result.vertex_data.resize(quantized.size() * sizeof(QuantizedVertex));
+                std::memcpy(result.vertex_data.data(), quantized.data(), result.vertex_data.size());
+            }
+            else
+            {
+                result.vertex_stride = sizeof(Vertex);
+                result.vertex_data.resize(mesh.vertices.size() * sizeof(Vertex));
+                std::memcpy(result.vertex_data.data(), mesh.vertices.data(), result.vertex_data.size());
+            }
+
+            // Bounds and cones from the positions the GPU will actually read.
+            if (options.build_meshlets)
+                result.meshlets = build_meshlets(result.indices, unpack_vertices(result), options.meshlet_vertices, options.meshlet_triangles);
+
+            return result;
+        }
+
+        std::vector<Vertex> unpack_vertices(const ProcessedMesh& mesh)
+        {
+            std::vector<Vertex> vertices(mesh.vertex_count);
+            for (uint32_t i = 0; i < mesh.vertex_count; i++)
+            {
+                const uint8_t* source = mesh.vertex_data.data() + static_cast<size_t>(i) * mesh.vertex_stride;
+                if (mesh.quantized)
+                {
+                    QuantizedVertex quantized;
+                    std::memcpy(&quantized, source, sizeof(quantized));
+                    vertices[i] = dequantize_vertex(quantized, mesh.uv_transform);
+                }
+                else
+                    std::memcpy(&vertices[i], source, sizeof(Vertex));
+            }
+            return vertices;
+        }
+
+        void write_mesh_file(const std::string& path, const ProcessedMesh& mesh)
+        {
+            MeshFileHeader header{};
+            std::memcpy(header.magic, mesh_magic, sizeof(mesh_magic));
+            header.version = mesh_version;
+            header.flags = mesh.quantized ? mesh_file_quantized : 0;
+            header.vertex_stride = mesh.vertex_stride;
+            header.vertex_count = mesh.vertex_count;
+            header.index_count = static_cast<uint32_t>(mesh.indices.size());
+            header.index_size = mesh.uses_16bit_indices() ? 2 : 4;
+            header.meshlet_count = static_cast<uint32_t>(mesh.meshlets.meshlets.size());
+            header.meshlet_vertex_count = static_cast<uint32_t>(mesh.meshlets.vertices.size());
+            header.meshlet_triangle_bytes = static_cast<uint32_t>(mesh.meshlets.triangles.size());
+            std::memcpy(header.bounds_min, mesh.bounds_min, sizeof(header.bounds_min));
+            std::memcpy(header.bounds_max, mesh.bounds_max, sizeof(header.bounds_max));
+            std::memcpy(header.uv_offset, mesh.uv_transform.offset, sizeof(header.uv_offset));
+            std::memcpy(header.uv_scale, mesh.uv_transform.scale, sizeof(header.uv_scale));
+
+            std::string temporary_path = path + ".tmp";
+            std::ofstream output(temporary_path, std::ios::binary | std::ios::trunc);
+            if (!output.is_open())
+                throw std::runtime_error("\nFailed to create " + temporary_path + ".");
+
+            output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            output.write(reinterpret_cast<const char*>(mesh.vertex_data.data()), mesh.vertex_data.size());
+
+            if (header.index_size == 2)
+            {
+                std::vector<uint16_t> indices(mesh.indices.begin(), mesh.indices.end());
+                if (indices.size() % 2 != 0)
+                    indices.push_back(0);
+                output.write(reinterpret_cast<const char*>(indices.data()), indices.size() * sizeof(uint16_t));
+            }
+            else
+                output.write(reinterpret_cast<const char*>(mesh.indices.data()), mesh.indices.size() * sizeof(uint32_t));
+
+            output.write(reinterpret_cast<const char*>(mesh.meshlets.meshlets.data()), mesh.meshlets.meshlets.size() * sizeof(Meshlet));
+            output.write(reinterpret_cast<const char*>(mesh.meshlets.vertices.data()), mesh.meshlets.vertices.size() * sizeof(uint32_t));
+            output.write(reinterpret_cast<const char*>(mesh.meshlets.triangles.data()), mesh.meshlets.triangles.size());
+            output.close();
+
+            if (!output)
+                throw std::runtime_error("\nFailed to write " + temporary_path + ".");
+
+            std::error_code error;
+            std::filesystem::rename(temporary_path, path, error);
+            if (error)
+            {
+                std::filesystem::remove(temporary_path, error);
+                throw std::runtime_error("\nFailed to replace " + path + ".");
+            }
+        }
+
+        MeshFileLayout get_mesh_file_layout(const MeshFileHeader& header, uint64_t file_size, const std::string& name)
+        {
+            auto fail = [&](const char* reason) {
+                throw std::runtime_error("\nInvalid mesh file " + name + ": " + reason + ".");
+            };
+
+            if (std::memcmp(header.magic, mesh_magic, sizeof(mesh_magic)) != 0)
+                fail("bad magic");
+            if (header.version != mesh_version)
+                fail("unsupported version");
+
+            bool quantized = (header.flags & mesh_file_quantized) != 0;
+            if (header.vertex_stride != (quantized ? sizeof(QuantizedVertex) : sizeof(Vertex)))
+                fail("bad vertex stride");
+            if (header.index_size != 2 && header.index_size != 4)
+                fail("bad index size");
+
+            MeshFileLayout layout;
+            layout.vertices = sizeof(MeshFileHeader);
+            layout.indices = layout.vertices + static_cast<uint64_t>(header.vertex_count) * header.vertex_stride;
+            layout.meshlets = layout.indices + ((static_cast<uint64_t>(header.index_count) * header.index_size + 3) & ~3ull);
+            layout.meshlet_vertices = layout.meshlets + static_cast<uint64_t>(header.meshlet_count) * sizeof(Meshlet);
+            layout.meshlet_triangles = layout.meshlet_vertices + static_cast<uint64_t>(header.meshlet_vertex_count) * sizeof(uint32_t);
+            layout.size = layout.meshlet_triangles + header.meshlet_triangle_bytes;
+            if (layout.size != file_size)
+                fail("size mismatch");
+            return layout;
+        }
+
+        ProcessedMesh read_mesh_file(const std::string& path)
+        {
+            Utils::MappedFile file;
+            file.open(path);
+
+            const uint8_t* data = file.get_data();
+            uint64_t size = file.get_size();
+
+            auto fail = [&](const char* reason) {
+                throw std::runtime_error("\nInvalid mesh file " + path + ": " + reason + ".");
+            };
+
+            if (size < sizeof(MeshFileHeader))
+                fail("truncated header");
+
+            MeshFileHeader header;
+            std::memcpy(&header, data, sizeof(header));
+            MeshFileLayout layout = get_mesh_file_layout(header, size, path);
+            bool quantized = (header.flags & mesh_file_quantized) != 0;
+
+            ProcessedMesh mesh;
+            mesh.vertex_stride = header.vertex_stride;
+            mesh.vertex_count = header.vertex_count;
+            mesh.quantized = quantized;
+            std::memcpy(mesh.bounds_min, header.bounds_min, sizeof(mesh.bounds_min));
+            std::memcpy(mesh.bounds_max, header.bounds_max, sizeof(mesh.bounds_max));
+            std::memcpy(mesh.uv_transform.offset, header.uv_offset, sizeof(header.uv_offset));
+            std::memcpy(mesh.uv_transform.scale, header.uv_scale, sizeof(header.uv_scale));
+
+            const uint8_t* cursor = data + sizeof(MeshFileHeader);
+            mesh.vertex_data.assign(cursor, cursor + static_cast<size_t>(header.vertex_count) * header.vertex_stride);
+            cursor += mesh.vertex_data.size();
+
+            mesh.indices.resize(header.index_count);
+            for (uint32_t i = 0; i < header.index_count; i++)
+            {
+                if (header.index_size == 2)
+                {
+                    uint16_t index;
+                    std::memcpy(&index, cursor + i * 2, sizeof(index));
+                    mesh.indices[i] = index;
+                }
+                else
+                    std::memcpy(&mesh.indices[i], cursor + i * 4, sizeof(uint32_t));
+
+                if (mesh.indices[i] >= header.vertex_count)
+                    fail("index out of range");
+            }
+            cursor = data + layout.meshlets;
+
+            mesh.meshlets.meshlets.resize(header.meshlet_count);
+            std::memcpy(mesh.meshlets.meshlets.data(), cursor, header.meshlet_count * sizeof(Meshlet));
+            cursor += header.meshlet_count * sizeof(Meshlet);
+
+            mesh.meshlets.vertices.resize(header.meshlet_vertex_count);
+            std::memcpy(mesh.meshlets.vertices.data(), cursor, header.meshlet_vertex_count * sizeof(uint32_t));
+            cursor += header.meshlet_vertex_count * sizeof(uint32_t);
+
+            mesh.meshlets.triangles.assign(cursor, cursor + header.meshlet_triangle_bytes);
+
+            for (const Meshlet& meshlet : mesh.meshlets.meshlets)
+            {
+                if (static_cast<uint64_t>(meshlet.vertex_offset) + meshlet.vertex_count > header.meshlet_vertex_count ||
+                    static_cast<uint64_t>(meshlet.triangle_offset) + meshlet.triangle_count * 3ull > header.meshlet_triangle_bytes)
+                    fail("meshlet out of range");
+            }
+            for (uint32_t vertex : mesh.meshlets.vertices)
+                if (vertex >= header.vertex_count)
+                    fail("meshlet vertex out of range");
+
+            return mesh;
+        }
+    };
+};
@@ -0,0 +1,123 @@
+#pragma once
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-09
+ *
+ */
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <stdexcept>
+
+#include "mesh.hpp"
+#include "meshlets.hpp"
+#include "quantization.hpp"
+
+namespace VulkanGameEngine
+{
+    namespace Mesh
+    {
+        /**
+         * On-disk layout of a .vgem file, little endian:
+         *
+         *   MeshFileHeader
+         *   vertex data           vertex_count * vertex_stride bytes
+         *   index data            index_count * index_size bytes, padded to 4
+         *   Meshlet[meshlet_count]
+         *   uint32_t[meshlet_vertex_count]
+         *   uint8_t[meshlet_triangle_bytes]
+         */
+        struct MeshFileHeader
+        {
+            char magic[4];
+            uint32_t version;
+            uint32_t flags;
+            uint32_t vertex_stride;
+            uint32_t vertex_count;
+            uint32_t index_count;
+            uint32_t index_size;
+            uint32_t meshlet_count;
+            uint32_t meshlet_vertex_count;
+            uint32_t meshlet_triangle_bytes;
+            float bounds_min[3];
+            float bounds_max[3];
+            float uv_offset[2];
+            float uv_scale[2];
+        };
+
+        const uint32_t mesh_file_quantized = 1;
+
+        /**
+         * Byte offsets of the sections of a mesh file, and its total size.
+         */
+        struct MeshFileLayout
+        {
+            uint64_t vertices = 0;
+            uint64_t indices = 0;
+            uint64_t meshlets = 0;
+            uint64_t meshlet_vertices = 0;
+            uint64_t meshlet_triangles = 0;
+            uint64_t size = 0;
+        };
+
+        /**
+         * GPU ready mesh: vertex bytes in either Vertex or QuantizedVertex layout,
+         * indices in optimized order, and meshlets over the same vertices.
+         */
+        struct ProcessedMesh
+        {
+            std::vector<uint8_t> vertex_data;
+            uint32_t vertex_stride = 0;
+            uint32_t vertex_count = 0;
+            bool quantized = false;
+
+            std::vector<uint32_t> indices;
+            MeshletData meshlets;
+
+            float bounds_min[3] = {0.0f, 0.0f, 0.0f};
+            float bounds_max[3] = {0.0f, 0.0f, 0.0f};
+            UvTransform uv_transform;
+
+            /**
+             * Index buffers use 16 bit indices whenever the vertex count allows.
+             */
+            bool uses_16bit_indices() const { return vertex_count <= 65536; }
+        };
+
+        struct ProcessOptions
+        {
+            uint32_t cache_size = 16;
+            // Vertex cache cost optimize_overdraw may trade for less overdraw; 0 skips it.
+            float overdraw_threshold = 1.05f;
+            bool quantize = true;
+            bool build_meshlets = true;
+            uint32_t meshlet_vertices = default_meshlet_vertices;
+            uint32_t meshlet_triangles = default_meshlet_triangles;
+        };
+
+        /**
+         * Vertex cache, overdraw and vertex fetch optimization, then meshlets
+         * and quantization.
+         */
+        ProcessedMesh process_mesh(MeshData mesh, const ProcessOptions& options);
+
+        /**
+         * Full precision vertices back from vertex_data, dequantized if needed.
+         */
+        std::vector<Vertex> unpack_vertices(const ProcessedMesh& mesh);
+
+        void write_mesh_file(const std::string& path, const ProcessedMesh& mesh);
+
+        /**
+         * Throws unless header is valid and describes exactly file_size bytes.
+         * name only appears in the error.
+         */
+        MeshFileLayout get_mesh_file_layout(const MeshFileHeader& header, uint64_t file_size, const std::string& name);
+
+        /**
+         * Throws if the file is not a valid mesh file.
+         */
+        ProcessedMesh read_mesh_file(const std::string& path);
+    };
+};
@@ -0,0 +1,187 @@
+#include "quantization.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+#include <cstring>
+
+namespace VulkanGameEngine
+{
+    namespace Mesh
+    {
+        namespace
+        {
+            int16_t to_snorm16(float value)
+            {
+                value = std::max(-1.0f, std::min(1.0f, value));
+                return static_cast<int16_t>(std::lround(value * 32767.0f));
+            }
+
+            float from_snorm16(int16_t value)
+            {
+                return std::max(-1.0f, value / 32767.0f);
+            }
+
+            uint16_t to_unorm16(float value)
+            {
+                value = std::max(0.0f, std::min(1.0f, value));
+                return static_cast<uint16_t>(std::lround(value * 65535.0f));
+            }
+
+            float sign_not_zero(float value)
+            {
+                return value >= 0.0f ? 1.0f : -1.0f;
+            }
+        };
+
+        uint16_t float_to_half(float value)
+        {
+            uint32_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+
+            uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+            uint32_t magnitude = bits & 0x7fffffff;
+
+            // NaN keeps a quiet payload bit, infinity stays infinity.
+            if (magnitude > 0x7f800000)
+                return sign | 0x7e00;
+            if (magnitude >= 0x477ff000)
+                return sign | 0x7c00;
+
+            // Below the smallest normal half: let the FPU round the subnormal.
+            if (magnitude < 0x38800000)
+            {
+                float absolute;
+                std::memcpy(&absolute, &magnitude, sizeof(absolute));
+                // 2^-24 is the subnormal half step; the scaling is exact and nearbyint rounds to even.
+                float scaled = absolute * 16777216.0f;
+                return sign | static_cast<uint16_t>(std::nearbyint(scaled));
+            }
+
+            // Rebias the exponent and round the mantissa to nearest even.
+            uint32_t rounded = magnitude - 0x38000000;
+            rounded += 0x0fff + ((rounded >> 13) & 1);
+            return sign | static_cast<uint16_t>(rounded >> 13);
+        }
+
+        float half_to_float(uint16_t value)
+        {
+            uint32_t sign = static_cast<uint32_t>(value & 0x8000) << 16;
+            uint32_t exponent = (value >> 10) & 0x1f;
+            uint32_t mantissa = value & 0x3ff;
+
+            uint32_t bits;
+            if (exponent == 0)
+            {
+                float magnitude = mantissa / 16777216.0f;
+                std::memcpy(&bits, &magnitude, sizeof(bits));
+                bits |= sign;
+            }
+            else if (exponent == 31)
+                bits = sign | 0x7f800000 | (mantissa << 13);
+            else
+                bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+
+            float result;
+            std::memcpy(&result, &bits, sizeof(result));
+            return result;
+        }
+
+        void encode_octahedral(const float* normal, int16_t* encoded)
+        {
+            float length = std::fabs(normal[0]) + std::fabs(normal[1]) + std::fabs(normal[2]);
+            if (length == 0.0f)
+            {
+                encoded[0] = 0;
+                encoded[1] = 0;
+                return;
+            }
+
+            float x = normal[0] / length;
+            float y = normal[1] / length;
+            if (normal[2] < 0.0f)
+            {
+                float folded_x = (1.0f - std::fabs(y)) * sign_not_zero(x);
+                float folded_y = (1.0f - std::fabs(x)) * sign_not_zero(y);
+                x = folded_x;
+                y = folded_y;
+            }
+
+            encoded[0] = to_snorm16(x);
+            encoded[1] = to_snorm16(y);
+        }
+
+        void decode_octahedral(const int16_t* encoded, float* normal)
+        {
+            float x = from_snorm16(encoded[0]);
+            float y = from_snorm16(encoded[1]);
+            float z = 1.0f - std::fabs(x) - std::fabs(y);
+
+            // Unfolding the lower hemisphere, as in the shaders.
+            float t = std::max(-z, 0.0f);
+            x += x >= 0.0f ? -t : t;
+            y += y >= 0.0f ? -t : t;
+
+            float length = std::sqrt(x * x + y * y + z * z);
+            normal[0] = x / length;
+            normal[1] = y / length;
+            normal[2] = z / length;
+        }
+
+        UvTransform compute_uv_transform(const std::vector<Vertex>& vertices)
+        {
+            UvTransform transform;
+            if (vertices.empty())
+                return transform;
+
+            float minimum[2] = {FLT_MAX, FLT_MAX};
+            float maximum[2] = {-FLT_MAX, -FLT_MAX};
+            for (const Vertex& vertex : vertices)
+            {
+                for (int i = 0; i < 2; i++)
+                {
+                    minimum[i] = std::min(minimum[i], vertex.uv[i]);
+                    maximum[i] = std::max(maximum[i], vertex.uv[i]);
+                }
+            }
+
+            for (int i = 0; i < 2; i++)
+            {
+                transform.offset[i] = minimum[i];
+                transform.scale[i] = maximum[i] > minimum[i] ? maximum[i] - minimum[i] : 1.0f;
+            }
+            return transform;
+        }
+
+        std::vector<QuantizedVertex> quantize_vertices(const std::vector<Vertex>& vertices, const UvTransform& uv_transform)
+        {
+            std::vector<QuantizedVertex> result(vertices.size());
+            for (size_t i = 0; i < vertices.size(); i++)
+            {
+                const Vertex& source = vertices[i];
+                QuantizedVertex& target = result[i];
+
+                for (int k = 0; k < 3; k++)
+                    target.position[k] = float_to_half(source.position[k]);
+                target.position[3] = float_to_half(1.0f);
+
+                encode_octahedral(source.normal, target.normal);
+
+                for (int k = 0; k < 2; k++)
+                    target.uv[k] = to_unorm16((source.uv[k] - uv_transform.offset[k]) / uv_transform.scale[k]);
+            }
+            return result;
+        }
+
+        Vertex dequantize_vertex(const QuantizedVertex& vertex, const UvTransform& uv_transform)
+        {
+            Vertex result;
+            for (int k = 0; k < 3; k++)
+                result.position[k] = half_to_float(vertex.position[k]);
+            decode_octahedral(vertex.normal, result.normal);
+            for (int k = 0; k < 2; k++)
+                result.uv[k] = uv_transform.offset[k] + vertex.uv[k] / 65535.0f * uv_transform.scale[k];
+            return result;
+        }
+    };
+};
@@ -0,0 +1,59 @@
+#pragma once
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-09
+ *
+ */
+
+#include <vector>
+#include <cstdint>
+
+#include "mesh.hpp"
+
+namespace VulkanGameEngine
+{
+    namespace Mesh
+    {
+        /**
+         * 16 byte vertex: half float position (w is padding, always 1),
+         * octahedral normal in snorm16, uv in unorm16 over the mesh's uv bounds.
+         * Matches R16G16B16A16_SFLOAT, R16G16_SNORM and R16G16_UNORM attributes.
+         */
+        struct QuantizedVertex
+        {
+            uint16_t position[4];
+            int16_t normal[2];
+            uint16_t uv[2];
+        };
+
+        /**
+         * uv = uv_offset + unorm * uv_scale undoes the uv quantization.
+         */
+        struct UvTransform
+        {
+            float offset[2] = {0.0f, 0.0f};
+            float scale[2] = {1.0f, 1.0f};
+        };
+
+        /**
+         * IEEE 754 binary16, rounding to nearest even. Overflows to infinity,
+         * keeps NaNs and subnormals.
+         */
+        uint16_t float_to_half(float value);
+
+        float half_to_float(uint16_t value);
+
+        /**
+         * Octahedral mapping of a unit vector (Meyer et al. 2010).
+         */
+        void encode_octahedral(const float* normal, int16_t* encoded);
+
+        void decode_octahedral(const int16_t* encoded, float* normal);
+
+        UvTransform compute_uv_transform(const std::vector<Vertex>& vertices);
+
+        std::vector<QuantizedVertex> quantize_vertices(const std::vector<Vertex>& vertices, const UvTransform& uv_transform);
+
+        Vertex dequantize_vertex(const QuantizedVertex& vertex, const UvTransform& uv_transform);
+    };
+};
@@ -0,0 +1,211 @@
+#include "gpu_profiler.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+namespace VulkanGameEngine
+{
+    namespace Profiling
+    {
+        void GpuProfiler::init(
+            VkDevice device,
+            const Utils::DeviceCapabilities& capabilities,
+            uint32_t queue_family,
+            uint32_t frames_in_flight,
+            uint32_t queries_per_frame)
+        {
+            this->device = device;
+            this->queries_per_frame = queries_per_frame;
+
+            uint32_t valid_bits = capabilities.queue_families[queue_family].timestampValidBits;
+            timestamp_period = capabilities.properties.limits.timestampPeriod;
+
+            supported = valid_bits != 0 && timestamp_period > 0.0;
+            if (!supported)
+                return;
+
+            timestamp_mask = valid_bits >= 64 ? ~0ull : (1ull << valid_bits) - 1;
+
+            VkQueryPoolCreateInfo create_info{};
+            create_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+            create_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+            create_info.queryCount = queries_per_frame * frames_in_flight;
+
+            if (vkCreateQueryPool(device, &create_info, nullptr, &query_pool) != VK_SUCCESS)
+                throw std::runtime_error("\nFailed to create timestamp query pool.");
+
+            slots.assign(frames_in_flight, FrameSlot{});
+        }
+
+        void GpuProfiler::cleanup()
+        {
+            if (query_pool != VK_NULL_HANDLE)
+                vkDestroyQueryPool(device, query_pool, nullptr);
+
+            query_pool = VK_NULL_HANDLE;
+            supported = false;
+            slots.clear();
+        }
+
+        void GpuProfiler::begin_frame(VkCommandBuffer command_buffer, uint32_t slot_index, uint64_t frame_number)
+        {
+            if (!supported)
+                return;
+
+            FrameSlot& slot = slots[slot_index];
+            if (slot.pending)
+                read_back(slot, slot_index);
+
+            slot.regions.clear();
+            slot.query_count = 0;
+            slot.frame_number = frame_number;
+            slot.pending = false;
+
+            current_slot = slot_index;
+            recording = true;
+            open_regions.clear();
+
+            vkCmdResetQueryPool(command_buffer, query_pool, slot_index * queries_per_frame, queries_per_frame);
+        }
+
+        void GpuProfiler::begin_region(VkCommandBuffer command_buffer, const char* name)
+        {
+            if (!supported || !recording)
+                return;
+
+            FrameSlot& slot = slots[current_slot];
+
+            // Out of queries: the region is silently dropped, and so is its end.
+            if (slot.query_count + 2 > queries_per_frame)
+            {
+                open_regions.push_back(~0u);
+                return;
+            }
+
+            uint32_t first_query = current_slot * queries_per_frame;
+            Region region{name, first_query + slot.query_count, first_query + slot.query_count + 1, static_cast<uint32_t>(open_regions.size())};
+            slot.query_count += 2;
+
+            vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, query_pool, region.begin_query);
+
+            open_regions.push_back(static_cast<uint32_t>(slot.regions.size()));
+            slot.regions.push_back(region);
+        }
+
+        void GpuProfiler::end_region(VkCommandBuffer command_buffer)
+        {
+            if (!supported || !recording || open_regions.empty())
+                return;
+
+            uint32_t index = open_regions.back();
+            open_regions.pop_back();
+            if (index == ~0u)
+                return;
+
+            vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, query_pool, slots[current_slot].regions[index].end_query);
+        }
+
+        void GpuProfiler::end_frame()
+        {
+            if (!supported || !recording)
+                return;
+
+            FrameSlot& slot = slots[current_slot];
+            slot.submit_ns = now_ns();
+            slot.pending = !slot.regions.empty();
+            recording = false;
+
+            // Regions still open never wrote their end timestamp; read_back skips them.
+            open_regions.clear();
+        }
+
+        const GpuProfiler::RegionStatistics* GpuProfiler::find_region(const char* name) const
+        {
+            for (const auto& region : statistics)
+                if (strcmp(region.name, name) == 0)
+                    return &region;
+            return nullptr;
+        }
+
+        void GpuProfiler::print_summary(std::ostream& out) const
+        {
+            if (!supported)
+            {
+                out << "GPU timings: timestamps not supported on the graphics queue\n";
+                return;
+            }
+
+            char line[256];
+            for (const auto& region : statistics)
+            {
+                snprintf(line, sizeof(line), "GPU %-24s avg %8.3f ms, last %8.3f ms (%llu samples)\n",
+                    region.name, region.average_ms, region.last_ms, static_cast<unsigned long long>(region.samples));
+                out << line;
+            }
+        }
+
+        void GpuProfiler::read_back(FrameSlot& slot, uint32_t slot_index)
+        {
+            // A value and an availability word per query: a region left open when the
+            // frame ended has an unwritten end query, which would otherwise make the
+            // whole range unreadable.
+            std::vector<uint64_t> results(slot.query_count * 2);
+            VkResult result = vkGetQueryPoolResults(
+                device, query_pool, slot_index * queries_per_frame, slot.query_count,
+                results.size() * sizeof(uint64_t), results.data(), 2 * sizeof(uint64_t),
+                VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+
+            if (result != VK_SUCCESS && result != VK_NOT_READY)
+                return;
+
+            uint32_t first_query = slot_index * queries_per_frame;
+            auto available = [&](uint32_t query) { return results[(query - first_query) * 2 + 1] != 0; };
+            auto timestamp = [&](uint32_t query) { return results[(query - first_query) * 2] & timestamp_mask; };
+
+            if (!available(slot.regions.front().begin_query))
+                return;
+            uint64_t frame_begin = timestamp(slot.regions.front().begin_query);
+
+            for (const auto& region : slot.regions)
+            {
+                if (!available(region.begin_query) || !available(region.end_query))
+                    continue;
+
+                uint64_t begin = timestamp(region.begin_query);
+                uint64_t end = timestamp(region.end_query);
+                if (end < begin || begin < frame_begin)
+                    continue;
+
+                uint64_t start_ns = slot.submit_ns + static_cast<uint64_t>((begin - frame_begin) * timestamp_period);
+                uint64_t duration_ns = static_cast<uint64_t>((end - begin) * timestamp_period);
+
+                history.push_back({region.name, slot.frame_number, start_ns, start_ns + duration_ns, region.depth});
+                if (history.size() > history_limit)
+                    history.pop_front();
+
+                record_statistics(region.name, duration_ns / 1e6);
+            }
+        }
+
+        void GpuProfiler::record_statistics(const char* name, double duration_ms)
+        {
+            RegionStatistics* region = nullptr;
+            for (auto& candidate : statistics)
+                if (candidate.name == name || strcmp(candidate.name, name) == 0)
+                {
+                    region = &candidate;
+                    break;
+                }
+
+            if (!region)
+            {
+                statistics.push_back(RegionStatistics{name});
+                region = &statistics.back();
+            }
+
+            region->samples++;
+            region->last_ms = duration_ms;
+            region->average_ms += (duration_ms - region->average_ms) / region->samples;
+        }
+    };
+};
@@ -0,0 +1,144 @@
+#pragma once
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-09-29
+ *
+ */
+
+#include <iostream>
+#include <vector>
+#include <deque>
+#include <cstdint>
+#include <stdexcept>
+
+#include "../utils/platform.hpp"
+#include "../utils/device_capabilities.hpp"
+#include "profiler.hpp"
+
+#ifdef VGE_ENABLE_PROFILING
+    #define VGE_PROFILE_GPU_SCOPE(profiler, command_buffer, name) \
+        ::VulkanGameEngine::Profiling::GpuScope VGE_PROFILE_CONCAT(vge_profile_gpu_scope_, __LINE__)(profiler, command_buffer, name)
+#else
+    #define VGE_PROFILE_GPU_SCOPE(profiler, command_buffer, name) do {} while (0)
+#endif
+
+namespace VulkanGameEngine
+{
+    namespace Profiling
+    {
+        /**
+         * GPU regions measured with timestamp queries, one query range per frame in flight.
+         * Results of a frame are read back when its slot is reused, after its fence
+         * has been waited on, so reading never stalls.
+         *
+         * Vulkan 1.0 has no way to correlate the two clocks, so each GPU frame is
+         * placed on the CPU timeline at the time its command buffer was submitted.
+         */
+        class GpuProfiler
+        {
+            public:
+                struct RegionStatistics
+                {
+                    const char* name;
+                    double last_ms = 0.0;
+                    double average_ms = 0.0;
+                    uint64_t samples = 0;
+                };
+
+                static const size_t history_limit = 1 << 16;
+
+            private:
+                struct Region
+                {
+                    const char* name;
+                    uint32_t begin_query;
+                    uint32_t end_query;
+                    uint32_t depth;
+                };
+
+                struct FrameSlot
+                {
+                    std::vector<Region> regions;
+                    uint32_t query_count = 0;
+                    uint64_t frame_number = 0;
+                    uint64_t submit_ns = 0;
+                    bool pending = false;
+                };
+
+                VkDevice device = VK_NULL_HANDLE;
+                VkQueryPool query_pool = VK_NULL_HANDLE;
+                bool supported = false;
+
+                double timestamp_period = 1.0;
+                uint64_t timestamp_mask = ~0ull;
+                uint32_t queries_per_frame = 0;
+
+                std::vector<FrameSlot> slots;
+                uint32_t current_slot = 0;
+                bool recording = false;
+                std::vector<uint32_t> open_regions;
+
+                std::deque<GpuEvent> history;
+                std::vector<RegionStatistics> statistics;
+
+            public:
+                void init(
+                    VkDevice device,
+                    const Utils::DeviceCapabilities& capabilities,
+                    uint32_t queue_family,
+                    uint32_t frames_in_flight,
+                    uint32_t queries_per_frame = 128);
+
+                void cleanup();
+
+                bool is_supported() const { return supported; }
+
+                /**
+                 * Start of a frame's command buffer. The slot's fence must have been waited on.
+                 */
+                void begin_frame(VkCommandBuffer command_buffer, uint32_t slot, uint64_t frame_number);
+
+                void begin_region(VkCommandBuffer command_buffer, const char* name);
+
+                void end_region(VkCommandBuffer command_buffer);
+
+                /**
+                 * Right after the frame's command buffer was submitted. Regions still
+                 * open are dropped from the frame's results.
+                 */
+                void end_frame();
+
+                const std::vector<RegionStatistics>& get_region_statistics() const { return statistics; }
+
+                const RegionStatistics* find_region(const char* name) const;
+
+                std::vector<GpuEvent> get_events() const { return std::vector<GpuEvent>(history.begin(), history.end()); }
+
+                void print_summary(std::ostream& out) const;
+
+            private:
+                void read_back(FrameSlot& slot, uint32_t slot_index);
+
+                void record_statistics(const char* name, double duration_ms);
+        };
+
+        class GpuScope
+        {
+            private:
+                GpuProfiler& profiler;
+                VkCommandBuffer command_buffer;
+
+            public:
+                GpuScope(GpuProfiler& profiler, VkCommandBuffer command_buffer, const char* name)
+                    : profiler(profiler), command_buffer(command_buffer)
+                {
+                    profiler.begin_region(command_buffer, name);
+                }
+
+                ~GpuScope() { profiler.end_region(command_buffer); }
+
+                GpuScope(const GpuScope&) = delete;
+                GpuScope& operator=(const GpuScope&) = delete;
+        };
+    };
+};
@@ -0,0 +1,133 @@
+#include "profiler.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+
+namespace VulkanGameEngine
+{
+    namespace Profiling
+    {
+        static const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+        /**
+         * Buffers are never freed, so events of finished threads can still be exported.
+         */
+        static std::mutex registry_mutex;
+        static std::vector<std::unique_ptr<ThreadBuffer>> registry;
+
+        uint64_t now_ns()
+        {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count());
+        }
+
+        ThreadBuffer& thread_buffer()
+        {
+            thread_local ThreadBuffer* buffer = nullptr;
+            if (buffer)
+                return *buffer;
+
+            std::lock_guard<std::mutex> lock(registry_mutex);
+            registry.push_back(std::make_unique<ThreadBuffer>());
+            buffer = registry.back().get();
+            buffer->thread_id = static_cast<uint32_t>(registry.size() - 1);
+            buffer->thread_name = "Thread " + std::to_string(buffer->thread_id);
+            return *buffer;
+        }
+
+        void set_thread_name(const std::string& name)
+        {
+            ThreadBuffer& buffer = thread_buffer();
+            std::lock_guard<std::mutex> lock(registry_mutex);
+            buffer.thread_name = name;
+        }
+
+        void ThreadBuffer::collect(std::vector<CpuEvent>& out) const
+        {
+            uint64_t end = write_index.load(std::memory_order_acquire);
+            uint64_t begin = end > capacity ? end - capacity : 0;
+
+            size_t first = out.size();
+            for (uint64_t i = begin; i < end; i++)
+                out.push_back(events[i & (capacity - 1)]);
+
+            // Anything the writer lapped while we were copying is garbage.
+            uint64_t new_end = write_index.load(std::memory_order_acquire);
+            uint64_t valid_begin = new_end > capacity ? new_end - capacity : 0;
+            if (valid_begin > begin)
+            {
+                size_t dropped = static_cast<size_t>(std::min(valid_begin - begin, end - begin));
+                out.erase(out.begin() + first, out.begin() + first + dropped);
+            }
+        }
+
+        std::vector<ThreadEvents> collect_cpu_events()
+        {
+            std::lock_guard<std::mutex> lock(registry_mutex);
+
+            std::vector<ThreadEvents> threads;
+            for (const auto& buffer : registry)
+            {
+                ThreadEvents thread;
+                thread.thread_id = buffer->thread_id;
+                thread.thread_name = buffer->thread_name;
+                buffer->collect(thread.events);
+                threads.push_back(std::move(thread));
+            }
+            return threads;
+        }
+
+        static void write_event(std::ostream& out, bool& first, const char* name, uint32_t pid, uint32_t tid, uint64_t start_ns, uint64_t end_ns)
+        {
+            char line[256];
+            snprintf(line, sizeof(line),
+                "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%u,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                first ? "" : ",", name, pid, tid, start_ns / 1000.0, (end_ns - start_ns) / 1000.0);
+            out << line;
+            first = false;
+        }
+
+        static void write_metadata(std::ostream& out, bool& first, const char* kind, uint32_t pid, uint32_t tid, const std::string& name)
+        {
+            out << (first ? "" : ",") << "\n{\"name\":\"" << kind << "\",\"ph\":\"M\",\"pid\":" << pid
+                << ",\"tid\":" << tid << ",\"args\":{\"name\":\"" << name << "\"}}";
+            first = false;
+        }
+
+        void write_chrome_trace(std::ostream& out, const std::vector<ThreadEvents>& cpu_events, const std::vector<GpuEvent>& gpu_events)
+        {
+            const uint32_t cpu_pid = 1;
+            const uint32_t gpu_pid = 2;
+
+            bool first = true;
+            out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+            write_metadata(out, first, "process_name", cpu_pid, 0, "CPU");
+            for (const auto& thread : cpu_events)
+            {
+                write_metadata(out, first, "thread_name", cpu_pid, thread.thread_id, thread.thread_name);
+                for (const auto& event : thread.events)
+                    write_event(out, first, event.name, cpu_pid, thread.thread_id, event.start_ns, event.end_ns);
+            }
+
+            write_metadata(out, first, "process_name", gpu_pid, 0, "GPU");
+            write_metadata(out, first, "thread_name", gpu_pid, 0, "Graphics queue");
+            for (const auto& event : gpu_events)
+                write_event(out, first, event.name, gpu_pid, 0, event.start_ns, event.end_ns);
+
+            out << "\n]}\n";
+        }
+
+        bool write_chrome_trace(const std::string& path, const std::vector<ThreadEvents>& cpu_events, const std::vector<GpuEvent>& gpu_events)
+        {
+            std::ofstream file(path, std::ios::trunc);
+            if (!file.is_open())
+                return false;
+
+            write_chrome_trace(file, cpu_events, gpu_events);
+            return static_cast<bool>(file);
+        }
+    };
+};
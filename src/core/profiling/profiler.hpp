@@ -0,0 +1,147 @@
+#pragma once
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-09-29
+ *
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <cstdint>
+
+/**
+ * Instrumentation macros. They compile to nothing unless the build enables
+ * VGE_ENABLE_PROFILING (CMake option of the same name), so they can stay in
+ * hot paths of release builds.
+ *
+ * Names must be string literals: only the pointer is recorded.
+ */
+#define VGE_PROFILE_CONCAT_INNER(a, b) a##b
+#define VGE_PROFILE_CONCAT(a, b) VGE_PROFILE_CONCAT_INNER(a, b)
+
+#ifdef VGE_ENABLE_PROFILING
+    #define VGE_PROFILE_SCOPE(name) ::VulkanGameEngine::Profiling::CpuScope VGE_PROFILE_CONCAT(vge_profile_scope_, __LINE__)(name)
+    #define VGE_PROFILE_THREAD(name) ::VulkanGameEngine::Profiling::set_thread_name(name)
+#else
+    #define VGE_PROFILE_SCOPE(name) do {} while (0)
+    #define VGE_PROFILE_THREAD(name) do {} while (0)
+#endif
+
+namespace VulkanGameEngine
+{
+    namespace Profiling
+    {
+        struct CpuEvent
+        {
+            const char* name;
+            uint64_t start_ns;
+            uint64_t end_ns;
+            uint32_t depth;
+        };
+
+        /**
+         * Events of one thread, oldest first.
+         */
+        struct ThreadEvents
+        {
+            uint32_t thread_id;
+            std::string thread_name;
+            std::vector<CpuEvent> events;
+        };
+
+        /**
+         * GPU regions, placed on the CPU timeline (see GpuProfiler).
+         */
+        struct GpuEvent
+        {
+            const char* name;
+            uint64_t frame_number;
+            uint64_t start_ns;
+            uint64_t end_ns;
+            uint32_t depth;
+        };
+
+        /**
+         * Single producer ring buffer owned by one thread.
+         * The owning thread writes without locks; the collector copies the
+         * current window and drops whatever was overwritten meanwhile.
+         */
+        class ThreadBuffer
+        {
+            public:
+                static const size_t capacity = 1 << 14;
+
+                uint32_t thread_id = 0;
+                std::string thread_name;
+
+                // Nesting depth of the open scopes, only touched by the owning thread.
+                uint32_t depth = 0;
+
+            private:
+                std::vector<CpuEvent> events;
+                std::atomic<uint64_t> write_index{0};
+
+            public:
+                ThreadBuffer() : events(capacity) {}
+
+                void push(const CpuEvent& event)
+                {
+                    uint64_t index = write_index.load(std::memory_order_relaxed);
+                    events[index & (capacity - 1)] = event;
+                    write_index.store(index + 1, std::memory_order_release);
+                }
+
+                void collect(std::vector<CpuEvent>& out) const;
+        };
+
+        /**
+         * Nanoseconds since the profiler epoch (first use in the process).
+         */
+        uint64_t now_ns();
+
+        /**
+         * Buffer of the calling thread, registered on first use.
+         */
+        ThreadBuffer& thread_buffer();
+
+        void set_thread_name(const std::string& name);
+
+        /**
+         * Copy of what every thread's ring buffer currently holds.
+         */
+        std::vector<ThreadEvents> collect_cpu_events();
+
+        class CpuScope
+        {
+            private:
+                ThreadBuffer& buffer;
+                const char* name;
+                uint64_t start_ns;
+
+            public:
+                CpuScope(const char* name) : buffer(thread_buffer()), name(name), start_ns(now_ns())
+                {
+                    buffer.depth++;
+                }
+
+                ~CpuScope()
+                {
+                    buffer.depth--;
+                    buffer.push({name, start_ns, now_ns(), buffer.depth});
+                }
+
+                CpuScope(const CpuScope&) = delete;
+                CpuScope& operator=(const CpuScope&) = delete;
+        };
+
+        /**
+         * Chrome trace event format; opens in chrome://tracing and ui.perfetto.dev.
+         * CPU threads are listed under one process, the GPU queue under another.
+         */
+        void write_chrome_trace(std::ostream& out, const std::vector<ThreadEvents>& cpu_events, const std::vector<GpuEvent>& gpu_events);
+
+        bool write_chrome_trace(const std::string& path, const std::vector<ThreadEvents>& cpu_events, const std::vector<GpuEvent>& gpu_events);
+    };
+};
@@ -0,0 +1,267 @@
+#include "transform.hpp"
+#include "../jobs/job_system.hpp"
+#include "../math/batch.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+namespace VulkanGameEngine
+{
+    namespace Scene
+    {
+        Entity TransformSystem::create(World& world, const LocalTransform& local, Entity parent)
+        {
+            Entity entity = world.create_entity(0);
+            world.add<LocalTransform>(entity, local);
+            world.add<WorldTransform>(entity);
+            world.add<Hierarchy>(entity);
+            world.add<TransformState>(entity);
+
+            if (!parent.is_null())
+                set_parent(world, entity, parent);
+            return entity;
+        }
+
+        void TransformSystem::unlink(World& world, Entity entity)
+        {
+            Hierarchy hierarchy = *world.get<Hierarchy>(entity);
+            if (hierarchy.parent.is_null())
+                return;
+
+            if (!hierarchy.previous_sibling.is_null())
+                world.get_mut<Hierarchy>(hierarchy.previous_sibling)->next_sibling = hierarchy.next_sibling;
+            else
+                world.get_mut<Hierarchy>(hierarchy.parent)->first_child = hierarchy.next_sibling;
+
+            if (!hierarchy.next_sibling.is_null())
+                world.get_mut<Hierarchy>(hierarchy.next_sibling)->previous_sibling = hierarchy.previous_sibling;
+
+            Hierarchy* own = world.get_mut<Hierarchy>(entity);
+            own->parent = Entity{};
+            own->next_sibling = Entity{};
+            own->previous_sibling = Entity{};
+        }
+
+        void TransformSystem::set_depth(World& world, Entity root, uint32_t depth)
+        {
+            std::vector<std::pair<Entity, uint32_t>> stack = {{root, depth}};
+            while (!stack.empty())
+            {
+                Entity entity = stack.back().first;
+                uint32_t entity_depth = stack.back().second;
+                stack.pop_back();
+
+                // Moving to the level's group invalidates component pointers: fetch after.
+                world.set_group(entity, entity_depth);
+                Hierarchy* hierarchy = world.get_mut<Hierarchy>(entity);
+                hierarchy->depth = entity_depth;
+                world.get_mut<TransformState>(entity)->dirty = 1;
+
+                for (Entity child = hierarchy->first_child; !child.is_null(); child = world.get<Hierarchy>(child)->next_sibling)
+                    stack.push_back({child, entity_depth + 1});
+            }
+        }
+
+        void TransformSystem::set_parent(World& world, Entity entity, Entity parent)
+        {
+            if (!world.has<Hierarchy>(entity) || (!parent.is_null() && !world.has<Hierarchy>(parent)))
+                throw std::runtime_error("\nParenting an entity without a transform.");
+
+            for (Entity ancestor = parent; !ancestor.is_null(); ancestor = world.get<Hierarchy>(ancestor)->parent)
+                if (ancestor == entity)
+                    throw std::runtime_error("\nParenting an entity under its own subtree.");
+
+            unlink(world, entity);
+
+            uint32_t depth = 0;
+            if (!parent.is_null())
+            {
+                Hierarchy* parent_hierarchy = world.get_mut<Hierarchy>(parent);
+                Hierarchy* hierarchy = world.get_mut<Hierarchy>(entity);
+                hierarchy->parent = parent;
+                hierarchy->next_sibling = parent_hierarchy->first_child;
+                if (!parent_hierarchy->first_child.is_null())
+                    world.get_mut<Hierarchy>(parent_hierarchy->first_child)->previous_sibling = entity;
+                parent_hierarchy->first_child = entity;
+                depth = parent_hierarchy->depth + 1;
+            }
+
+            set_depth(world, entity, depth);
+        }
+
+        void TransformSystem::destroy(World& world, Entity entity)
+        {
+            if (!world.has<Hierarchy>(entity))
+                throw std::runtime_error("\nDestroying an entity without a transform.");
+
+            unlink(world, entity);
+
+            std::vector<Entity> subtree = {entity};
+            for (size_t i = 0; i < subtree.size(); i++)
+                for (Entity child = world.get<Hierarchy>(subtree[i])->first_child; !child.is_null(); child = world.get<Hierarchy>(child)->next_sibling)
+                    subtree.push_back(child);
+
+            for (Entity member : subtree)
+                world.destroy_entity(member);
+        }
+
+        void TransformSystem::set_local(World& world, Entity entity, const LocalTransform& local)
+        {
+            LocalTransform* target = world.get_mut<LocalTransform>(entity);
+            if (!target)
+                throw std::runtime_error("\nSetting the transform of an entity without one.");
+            *target = local;
+            world.get_mut<TransformState>(entity)->dirty = 1;
+        }
+
+        const float* TransformSystem::get_world_matrix(const World& world, Entity entity) const
+        {
+            const WorldTransform* transform = world.get<WorldTransform>(entity);
+            return transform ? transform->matrix.m : nullptr;
+        }
+
+        void TransformSystem::update(World& world, Jobs::JobSystem* jobs)
+        {
+            // Per chunk outcome of a level.
+            const uint8_t unchanged = 0, changed = 1, skipped = 2;
+            const uint32_t batch_size = 32;
+            auto start = std::chrono::steady_clock::now();
+
+            pass++;
+            // Writes since the last pass are consumed by this one. The pass writes at
+            // its own version, which the next pass ignores, and writes made after it
+            // get a newer one again.
+            uint64_t since = last_version;
+            last_version = world.advance_version();
+
+            ComponentMask mask = get_mask();
+            uint32_t levels = world.get_max_group(mask) + 1;
+            bool previous_level_changed = false;
+
+            ComponentType local_type = component_type<LocalTransform>();
+            ComponentType world_type = component_type<WorldTransform>();
+            ComponentType hierarchy_type = component_type<Hierarchy>();
+            ComponentType state_type = component_type<TransformState>();
+
+            for (uint32_t level = 0; level < levels; level++)
+            {
+                level_chunks.clear();
+                world.collect_chunks(mask, 0, level_chunks, level, level);
+                chunk_changed.assign(level_chunks.size(), unchanged);
+                chunk_recomputed.assign(level_chunks.size(), 0);
+
+                bool parents_changed = previous_level_changed;
+                uint64_t current_pass = pass;
+                const World& parents = world;
+
+                auto process = [&](uint32_t first, uint32_t last) {
+                    for (uint32_t c = first; c < last; c++)
+                    {
+                        // Reparenting without a depth change only marks TransformState dirty,
+                        // so both columns decide whether the chunk can be skipped.
+                        ChunkView view(level_chunks[c], world.get_version());
+                        if (!parents_changed && view.column_version(local_type) <= since && view.column_version(state_type) <= since)
+                        {
+                            chunk_changed[c] = skipped;
+                            continue;
+                        }
+
+                        const LocalTransform* locals = static_cast<const LocalTransform*>(view.column(local_type));
+                        const Hierarchy* hierarchies = static_cast<const Hierarchy*>(view.column(hierarchy_type));
+                        WorldTransform* transforms = static_cast<WorldTransform*>(view.column(world_type));
+                        TransformState* states = static_cast<TransformState*>(view.column(state_type));
+
+                        // Children are gathered with their parent's matrix and multiplied
+                        // a batch at a time by the widest matrix kernel.
+                        Math::Mat4 parent_matrices[batch_size];
+                        Math::Mat4 local_matrices[batch_size];
+                        uint32_t batch_entities[batch_size];
+                        uint32_t batched = 0;
+
+                        auto flush = [&]() {
+                            Math::multiply_matrices(parent_matrices, local_matrices, local_matrices, batched);
+                            for (uint32_t b = 0; b < batched; b++)
+                                transforms[batch_entities[b]].matrix = local_matrices[b];
+                            batched = 0;
+                        };
+
+                        uint32_t recomputed = 0;
+                        for (uint32_t i = 0; i < view.size(); i++)
+                        {
+                            bool parent_moved = false;
+                            if (level > 0 && parents_changed)
+                            {
+                                Entity parent = hierarchies[i].parent;
+                                parent_moved = parents.get<TransformState>(parent)->changed_pass == current_pass;
+                            }
+                            if (!states[i].dirty && !parent_moved)
+                                continue;
+
+                            if (level == 0)
+                                transforms[i].matrix = compose_matrix(locals[i]);
+                            else
+                            {
+                                parent_matrices[batched] = parents.get<WorldTransform>(hierarchies[i].parent)->matrix;
+                                local_matrices[batched] = compose_matrix(locals[i]);
+                                batch_entities[batched++] = i;
+                                if (batched == batch_size)
+                                    flush();
+                            }
+                            states[i].dirty = 0;
+                            states[i].changed_pass = current_pass;
+                            recomputed++;
+                        }
+                        if (batched)
+                            flush();
+
+                        if (recomputed)
+                        {
+                            view.mark_changed(world_type);
+                            view.mark_changed(state_type);
+                            chunk_changed[c] = changed;
+                        }
+                        chunk_recomputed[c] = recomputed;
+                    }
+                };
+
+                uint32_t chunk_count = static_cast<uint32_t>(level_chunks.size());
+                if (jobs && chunk_count > 1)
+                    jobs->parallel_for(chunk_count, 1, process);
+                else
+                    process(0, chunk_count);
+
+                previous_level_changed = false;
+                for (uint32_t c = 0; c < chunk_count; c++)
+                {
+                    previous_level_changed |= chunk_changed[c] == changed;
+                    if (chunk_changed[c] == skipped)
+                        statistics.chunks_skipped++;
+                    else
+                        statistics.chunks_visited++;
+                    statistics.entities_recomputed += chunk_recomputed[c];
+                }
+            }
+
+            world.advance_version();
+
+            statistics.updates++;
+            statistics.levels = levels;
+            statistics.last_update_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        void TransformSystem::print_statistics(std::ostream& out) const
+        {
+            char line[256];
+            double updates = statistics.updates ? static_cast<double>(statistics.updates) : 1.0;
+            snprintf(line, sizeof(line), "\nTransforms: %llu updates over %u levels, per update %.1f entities recomputed, %.1f chunks visited, %.1f skipped (last %.3f ms)\n",
+                static_cast<unsigned long long>(statistics.updates),
+                statistics.levels,
+                statistics.entities_recomputed / updates,
+                statistics.chunks_visited / updates,
+                statistics.chunks_skipped / updates,
+                statistics.last_update_ms);
+            out << line;
+        }
+    };
+};
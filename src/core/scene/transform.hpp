@@ -0,0 +1,147 @@
+#pragma once
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-11
+ *
+ */
+
+#include <iostream>
+#include <vector>
+#include <cstdint>
+
+#include "world.hpp"
+#include "../math/matrix.hpp"
+
+namespace VulkanGameEngine
+{
+    namespace Scene
+    {
+        /**
+         * Relative to the parent; rotation is a unit quaternion (x, y, z, w).
+         */
+        struct LocalTransform
+        {
+            float position[3] = {0.0f, 0.0f, 0.0f};
+            float rotation[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+            float scale[3] = {1.0f, 1.0f, 1.0f};
+        };
+
+        /**
+         * Local to world matrix, written by TransformSystem::update().
+         */
+        struct WorldTransform
+        {
+            Math::Mat4 matrix = Math::Mat4::identity();
+        };
+
+        /**
+         * Intrusive child list. Only structural edits walk it; the per-frame
+         * update only follows parent.
+         */
+        struct Hierarchy
+        {
+            Entity parent;
+            Entity first_child;
+            Entity next_sibling;
+            Entity previous_sibling;
+            uint32_t depth = 0;
+        };
+
+        struct TransformState
+        {
+            // Last update pass that recomputed the world matrix.
+            uint64_t changed_pass = 0;
+            // The local transform changed since that pass.
+            uint32_t dirty = 1;
+        };
+
+        /**
+         * Propagates local transforms down the hierarchy.
+         *
+         * Transform entities live in the World group equal to their depth, so
+         * the update walks the hierarchy breadth first, one level at a time,
+         * with the chunks of a level spread over the job system: every parent is
+         * final before any of its children is read.
+         *
+         * An entity is recomputed when its local transform is dirty or its
+         * parent was recomputed in the same pass. Whole chunks are skipped,
+         * without touching their entities, when none of their local transforms
+         * or states was written (a reparent only dirties the state) and nothing
+         * on the level above changed, so static subtrees cost close to nothing.
+         */
+        class TransformSystem
+        {
+            public:
+                struct Statistics
+                {
+                    uint64_t updates = 0;
+                    uint64_t chunks_visited = 0;
+                    uint64_t chunks_skipped = 0;
+                    uint64_t entities_recomputed = 0;
+                    uint32_t levels = 0;
+                    double last_update_ms = 0.0;
+                };
+
+            private:
+                uint64_t pass = 0;
+                uint64_t last_version = 0;
+
+                std::vector<Chunk*> level_chunks;
+                std::vector<uint8_t> chunk_changed;
+                std::vector<uint32_t> chunk_recomputed;
+
+                Statistics statistics;
+
+            public:
+                static ComponentMask get_mask() { return component_mask<LocalTransform, WorldTransform, Hierarchy, TransformState>(); }
+
+                /**
+                 * A transform entity under parent, or a root when parent is null.
+                 */
+                Entity create(World& world, const LocalTransform& local = LocalTransform{}, Entity parent = Entity{});
+
+                /**
+                 * Destroys the entity and its whole subtree.
+                 */
+                void destroy(World& world, Entity entity);
+
+                /**
+                 * Moves entity and its subtree under parent (a root when null).
+                 * Throws when parent is inside the subtree.
+                 */
+                void set_parent(World& world, Entity entity, Entity parent);
+
+                void set_local(World& world, Entity entity, const LocalTransform& local);
+
+                /**
+                 * As of the last update().
+                 */
+                const float* get_world_matrix(const World& world, Entity entity) const;
+
+                /**
+                 * Recompute the world matrices of everything that moved.
+                 */
+                void update(World& world, Jobs::JobSystem* jobs = nullptr);
+
+                const Statistics& get_statistics() const { return statistics; }
+
+                void print_statistics(std::ostream& out) const;
+
+            private:
+                void set_depth(World& world, Entity root, uint32_t depth);
+
+                void unlink(World& world, Entity entity);
+        };
+
+        /**
+         * translation * rotation * scale.
+         */
+        inline Math::Mat4 compose_matrix(const LocalTransform& local)
+        {
+            return Math::Mat4::compose(
+                Math::Vec3(local.position[0], local.position[1], local.position[2]),
+                Math::Quat(local.rotation[0], local.rotation[1], local.rotation[2], local.rotation[3]),
+                Math::Vec3(local.scale[0], local.scale[1], local.scale[2]));
+        }
+    };
+};
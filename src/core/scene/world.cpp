@@ -0,0 +1,461 @@
+#include "world.hpp"
+#include "../jobs/job_system.hpp"
+
+#include <algorithm>
+#include <mutex>
+#include <new>
+#include <cstdio>
+#include <cstring>
+
+namespace VulkanGameEngine
+{
+    namespace Scene
+    {
+        struct ComponentInfo
+        {
+            size_t size;
+            size_t alignment;
+            const char* name;
+        };
+
+        static std::mutex& registry_mutex()
+        {
+            static std::mutex mutex;
+            return mutex;
+        }
+
+        static std::vector<ComponentInfo>& registry()
+        {
+            static std::vector<ComponentInfo> infos;
+            return infos;
+        }
+
+        const uint32_t World::chunk_size;
+        const uint32_t World::cache_line;
+
+        ComponentType register_component_type(size_t size, size_t alignment, const char* name)
+        {
+            std::lock_guard<std::mutex> lock(registry_mutex());
+            std::vector<ComponentInfo>& infos = registry();
+
+            if (infos.size() >= max_component_types)
+                throw std::runtime_error("\nToo many component types.");
+            if (alignment > 64)
+                throw std::runtime_error(std::string("\nComponent ") + name + " needs more than cache line alignment.");
+
+            infos.push_back({size, alignment, name});
+            return static_cast<ComponentType>(infos.size() - 1);
+        }
+
+        size_t get_component_size(ComponentType type)
+        {
+            std::lock_guard<std::mutex> lock(registry_mutex());
+            return registry().at(type).size;
+        }
+
+        const char* get_component_name(ComponentType type)
+        {
+            std::lock_guard<std::mutex> lock(registry_mutex());
+            return registry().at(type).name;
+        }
+
+        static uint32_t align_up(uint32_t value, uint32_t alignment)
+        {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+
+        Entity* Chunk::get_entities() const
+        {
+            return reinterpret_cast<Entity*>(data + archetype->entity_offset);
+        }
+
+        uint32_t ChunkView::get_group() const
+        {
+            return chunk->archetype->group;
+        }
+
+        bool ChunkView::has(ComponentType type) const
+        {
+            return chunk->archetype->columns[type] >= 0;
+        }
+
+        void* ChunkView::column(ComponentType type) const
+        {
+            int column = chunk->archetype->columns[type];
+            return column >= 0 ? chunk->data + chunk->archetype->column_offsets[column] : nullptr;
+        }
+
+        uint64_t ChunkView::column_version(ComponentType type) const
+        {
+            int column = chunk->archetype->columns[type];
+            return column >= 0 ? chunk->column_versions[column] : 0;
+        }
+
+        void ChunkView::mark_changed(ComponentType type)
+        {
+            int column = chunk->archetype->columns[type];
+            if (column >= 0)
+                chunk->column_versions[column] = version;
+        }
+
+        void World::clear()
+        {
+            for (auto& archetype : archetypes)
+                for (Chunk* chunk : archetype->chunks)
+                    free_chunk(chunk);
+            archetypes.clear();
+            archetype_lookup.clear();
+
+            // Keep the generations, so handles from before the clear stay dead.
+            free_indices.clear();
+            for (size_t i = records.size(); i-- > 0;)
+            {
+                if (records[i].chunk)
+                {
+                    records[i].chunk = nullptr;
+                    records[i].generation = records[i].generation + 1 ? records[i].generation + 1 : 1;
+                }
+                free_indices.push_back(static_cast<uint32_t>(i));
+            }
+            entity_count = 0;
+        }
+
+        Archetype* World::get_archetype(ComponentMask mask, uint32_t group)
+        {
+            auto found = archetype_lookup.find({mask, group});
+            if (found != archetype_lookup.end())
+                return found->second;
+
+            std::unique_ptr<Archetype> archetype(new Archetype());
+            archetype->mask = mask;
+            archetype->group = group;
+            std::fill(std::begin(archetype->columns), std::end(archetype->columns), static_cast<int8_t>(-1));
+
+            for (ComponentType type = 0; type < max_component_types; type++)
+            {
+                if (!(mask & (ComponentMask(1) << type)))
+                    continue;
+                archetype->columns[type] = static_cast<int8_t>(archetype->types.size());
+                archetype->types.push_back(type);
+                archetype->column_sizes.push_back(static_cast<uint32_t>(get_component_size(type)));
+            }
+
+            // Entity array first, then one cache line aligned array per component.
+            auto layout_bytes = [&](uint32_t capacity) {
+                uint32_t bytes = align_up(capacity * static_cast<uint32_t>(sizeof(Entity)), cache_line);
+                for (uint32_t size : archetype->column_sizes)
+                    bytes += align_up(capacity * size, cache_line);
+                return bytes;
+            };
+
+            uint32_t row_bytes = sizeof(Entity);
+            for (uint32_t size : archetype->column_sizes)
+                row_bytes += size;
+
+            uint32_t capacity = chunk_size / row_bytes;
+            while (capacity > 0 && layout_bytes(capacity) > chunk_size)
+                capacity--;
+            // Rows too large for a chunk get chunks of one row.
+            capacity = std::max(1u, capacity);
+
+            archetype->chunk_capacity = capacity;
+            archetype->chunk_bytes = std::max(chunk_size, layout_bytes(capacity));
+            archetype->entity_offset = 0;
+
+            uint32_t offset = align_up(capacity * static_cast<uint32_t>(sizeof(Entity)), cache_line);
+            for (uint32_t size : archetype->column_sizes)
+            {
+                archetype->column_offsets.push_back(offset);
+                offset += align_up(capacity * size, cache_line);
+            }
+
+            Archetype* result = archetype.get();
+            archetypes.push_back(std::move(archetype));
+            archetype_lookup[{mask, group}] = result;
+            return result;
+        }
+
+        Chunk* World::acquire_chunk(Archetype& archetype)
+        {
+            if (!archetype.open_chunks.empty())
+                return archetype.open_chunks.back();
+
+            Chunk* chunk = new Chunk();
+            chunk->archetype = &archetype;
+            chunk->capacity = archetype.chunk_capacity;
+            chunk->data = static_cast<uint8_t*>(::operator new(archetype.chunk_bytes, std::align_val_t(cache_line)));
+            chunk->column_versions.assign(archetype.types.size(), version);
+
+            archetype.chunks.push_back(chunk);
+            archetype.open_chunks.push_back(chunk);
+            return chunk;
+        }
+
+        void World::free_chunk(Chunk* chunk)
+        {
+            ::operator delete(chunk->data, std::align_val_t(cache_line));
+            delete chunk;
+        }
+
+        uint32_t World::push_row(Archetype& archetype, Entity entity, Chunk*& chunk)
+        {
+            chunk = acquire_chunk(archetype);
+            uint32_t row = chunk->count++;
+            chunk->get_entities()[row] = entity;
+            if (chunk->count == chunk->capacity)
+                archetype.open_chunks.pop_back();
+
+            archetype.entity_count++;
+            return row;
+        }
+
+        void World::remove_row(Chunk* chunk, uint32_t row)
+        {
+            Archetype& archetype = *chunk->archetype;
+            bool was_full = chunk->count == chunk->capacity;
+
+            uint32_t last = chunk->count - 1;
+            if (row != last)
+            {
+                Entity* entities = chunk->get_entities();
+                entities[row] = entities[last];
+                records[entities[row].index].row = row;
+
+                for (size_t column = 0; column < archetype.types.size(); column++)
+                {
+                    uint8_t* base = chunk->data + archetype.column_offsets[column];
+                    uint32_t size = archetype.column_sizes[column];
+                    std::memcpy(base + static_cast<size_t>(row) * size, base + static_cast<size_t>(last) * size, size);
+                }
+            }
+            chunk->count--;
+            archetype.entity_count--;
+
+            if (chunk->count == 0)
+            {
+                archetype.chunks.erase(std::find(archetype.chunks.begin(), archetype.chunks.end(), chunk));
+                if (!was_full)
+                    archetype.open_chunks.erase(std::find(archetype.open_chunks.begin(), archetype.open_chunks.end(), chunk));
+                free_chunk(chunk);
+            }
+            else if (was_full)
+                archetype.open_chunks.push_back(chunk);
+        }
+
+        void World::move_entity(Entity entity, Archetype& target)
+        {
+            EntityRecord& record = records[entity.index];
+            Chunk* source = record.chunk;
+            uint32_t source_row = record.row;
+            Archetype& source_archetype = *source->archetype;
+
+            Chunk* chunk;
+            uint32_t row = push_row(target, entity, chunk);
+
+            for (size_t column = 0; column < target.types.size(); column++)
+            {
+                // Moved values count as written: change detection must see them in their new chunk.
+                chunk->column_versions[column] = version;
+
+                int source_column = source_archetype.columns[target.types[column]];
+                if (source_column < 0)
+                    continue;
+                uint32_t size = target.column_sizes[column];
+                std::memcpy(
+                    chunk->data + target.column_offsets[column] + static_cast<size_t>(row) * size,
+                    source->data + source_archetype.column_offsets[source_column] + static_cast<size_t>(source_row) * size,
+                    size);
+            }
+
+            remove_row(source, source_row);
+            record.chunk = chunk;
+            record.row = row;
+            structural_moves++;
+        }
+
+        Entity World::create_entity(uint32_t group)
+        {
+            uint32_t index;
+            if (!free_indices.empty())
+            {
+                index = free_indices.back();
+                free_indices.pop_back();
+            }
+            else
+            {
+                index = static_cast<uint32_t>(records.size());
+                records.push_back(EntityRecord{});
+                records.back().generation = 1;
+            }
+
+            Entity entity{index, records[index].generation};
+            Chunk* chunk;
+            uint32_t row = push_row(*get_archetype(0, group), entity, chunk);
+            records[index].chunk = chunk;
+            records[index].row = row;
+            entity_count++;
+            return entity;
+        }
+
+        void World::destroy_entity(Entity entity)
+        {
+            if (!is_alive(entity))
+                throw std::runtime_error("\nDestroying a dead entity.");
+
+            EntityRecord& record = records[entity.index];
+            remove_row(record.chunk, record.row);
+            record.chunk = nullptr;
+            record.generation = record.generation + 1 ? record.generation + 1 : 1;
+            free_indices.push_back(entity.index);
+            entity_count--;
+        }
+
+        void* World::add_component(Entity entity, ComponentType type)
+        {
+            if (!is_alive(entity))
+                throw std::runtime_error("\nAdding a component to a dead entity.");
+
+            EntityRecord& record = records[entity.index];
+            Archetype& archetype = *record.chunk->archetype;
+            if (!(archetype.mask & (ComponentMask(1) << type)))
+                move_entity(entity, *get_archetype(archetype.mask | (ComponentMask(1) << type), archetype.group));
+
+            return get_component_mut(entity, type);
+        }
+
+        void World::remove_component(Entity entity, ComponentType type)
+        {
+            if (!is_alive(entity))
+                throw std::runtime_error("\nRemoving a component from a dead entity.");
+
+            Archetype& archetype = *records[entity.index].chunk->archetype;
+            if (archetype.mask & (ComponentMask(1) << type))
+                move_entity(entity, *get_archetype(archetype.mask & ~(ComponentMask(1) << type), archetype.group));
+        }
+
+        const void* World::get_component(Entity entity, ComponentType type) const
+        {
+            if (!is_alive(entity))
+                return nullptr;
+
+            const EntityRecord& record = records[entity.index];
+            const Archetype& archetype = *record.chunk->archetype;
+            int column = archetype.columns[type];
+            if (column < 0)
+                return nullptr;
+            return record.chunk->data + archetype.column_offsets[column] + static_cast<size_t>(record.row) * archetype.column_sizes[column];
+        }
+
+        void* World::get_component_mut(Entity entity, ComponentType type)
+        {
+            void* component = const_cast<void*>(get_component(entity, type));
+            if (component)
+            {
+                Chunk* chunk = records[entity.index].chunk;
+                chunk->column_versions[chunk->archetype->columns[type]] = version;
+            }
+            return component;
+        }
+
+        uint32_t World::get_group(Entity entity) const
+        {
+            if (!is_alive(entity))
+                throw std::runtime_error("\nQuerying the group of a dead entity.");
+            return records[entity.index].chunk->archetype->group;
+        }
+
+        void World::set_group(Entity entity, uint32_t group)
+        {
+            if (!is_alive(entity))
+                throw std::runtime_error("\nChanging the group of a dead entity.");
+
+            Archetype& archetype = *records[entity.index].chunk->archetype;
+            if (archetype.group != group)
+                move_entity(entity, *get_archetype(archetype.mask, group));
+        }
+
+        void World::collect_chunks(ComponentMask all, ComponentMask none, std::vector<Chunk*>& chunks, uint32_t first_group, uint32_t last_group) const
+        {
+            for (const auto& archetype : archetypes)
+            {
+                if ((archetype->mask & all) != all || (archetype->mask & none) != 0)
+                    continue;
+                if (archetype->group < first_group || archetype->group > last_group)
+                    continue;
+                chunks.insert(chunks.end(), archetype->chunks.begin(), archetype->chunks.end());
+            }
+        }
+
+        void World::for_each_chunk(ComponentMask all, ComponentMask none, const ChunkFunction& function, uint32_t first_group, uint32_t last_group)
+        {
+            for (const auto& archetype : archetypes)
+            {
+                if ((archetype->mask & all) != all || (archetype->mask & none) != 0)
+                    continue;
+                if (archetype->group < first_group || archetype->group > last_group)
+                    continue;
+                for (Chunk* chunk : archetype->chunks)
+                {
+                    ChunkView view(chunk, version);
+                    function(view);
+                }
+            }
+        }
+
+        void World::for_each_chunk_parallel(Jobs::JobSystem& jobs, ComponentMask all, ComponentMask none, const ChunkFunction& function, uint32_t first_group, uint32_t last_group)
+        {
+            std::vector<Chunk*> chunks;
+            collect_chunks(all, none, chunks, first_group, last_group);
+
+            jobs.parallel_for(static_cast<uint32_t>(chunks.size()), 1, [&](uint32_t first, uint32_t last) {
+                for (uint32_t i = first; i < last; i++)
+                {
+                    ChunkView view(chunks[i], version);
+                    function(view);
+                }
+            });
+        }
+
+        uint32_t World::get_max_group(ComponentMask all) const
+        {
+            uint32_t result = 0;
+            for (const auto& archetype : archetypes)
+                if ((archetype->mask & all) == all && archetype->entity_count > 0)
+                    result = std::max(result, archetype->group);
+            return result;
+        }
+
+        World::Statistics World::get_statistics() const
+        {
+            Statistics statistics;
+            statistics.entities = entity_count;
+            statistics.structural_moves = structural_moves;
+
+            uint64_t capacity = 0;
+            for (const auto& archetype : archetypes)
+            {
+                if (archetype->entity_count == 0)
+                    continue;
+                statistics.archetypes++;
+                statistics.chunks += static_cast<uint32_t>(archetype->chunks.size());
+                capacity += static_cast<uint64_t>(archetype->chunks.size()) * archetype->chunk_capacity;
+            }
+            statistics.occupancy = capacity ? static_cast<double>(entity_count) / capacity : 0.0;
+            return statistics;
+        }
+
+        void World::print_statistics(std::ostream& out) const
+        {
+            Statistics statistics = get_statistics();
+
+            char line[256];
+            snprintf(line, sizeof(line), "\nScene: %u entities in %u archetypes, %u chunks (%.1f%% occupied), %llu structural moves\n",
+                statistics.entities,
+                statistics.archetypes,
+                statistics.chunks,
+                100.0 * statistics.occupancy,
+                static_cast<unsigned long long>(statistics.structural_moves));
+            out << line;
+        }
+    };
+};
@@ -0,0 +1,330 @@
+#pragma once
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-11
+ *
+ */
+
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <type_traits>
+#include <typeinfo>
+#include <map>
+#include <cstdint>
+#include <cstddef>
+#include <stdexcept>
+
+namespace VulkanGameEngine
+{
+    namespace Jobs
+    {
+        class JobSystem;
+    };
+
+    namespace Scene
+    {
+        /**
+         * Index into the entity table and the generation of that slot; a handle to
+         * a destroyed entity stops resolving as soon as its slot is reused.
+         * Generation 0 is never used, so a default Entity is null.
+         */
+        struct Entity
+        {
+            uint32_t index = 0;
+            uint32_t generation = 0;
+
+            bool is_null() const { return generation == 0; }
+
+            bool operator==(const Entity& other) const { return index == other.index && generation == other.generation; }
+
+            bool operator!=(const Entity& other) const { return !(*this == other); }
+        };
+
+        typedef uint32_t ComponentType;
+        typedef uint64_t ComponentMask;
+
+        const uint32_t max_component_types = 64;
+
+        /**
+         * Components are plain data: they are moved between chunks with memcpy
+         * and never constructed or destroyed in place.
+         */
+        ComponentType register_component_type(size_t size, size_t alignment, const char* name);
+
+        size_t get_component_size(ComponentType type);
+
+        const char* get_component_name(ComponentType type);
+
+        template <typename T>
+        ComponentType component_type()
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "Components must be trivially copyable.");
+            static const ComponentType type = register_component_type(sizeof(T), alignof(T), typeid(T).name());
+            return type;
+        }
+
+        template <typename... T>
+        ComponentMask component_mask()
+        {
+            return (ComponentMask(0) | ... | (ComponentMask(1) << component_type<T>()));
+        }
+
+        struct Archetype;
+
+        /**
+         * A fixed size block holding up to capacity entities of one archetype,
+         * one array per component (SoA), every array starting on a cache line.
+         * Rows [0, count) are live; removing a row moves the last one into it.
+         *
+         * Every column records the world version of its last write access, which
+         * lets systems skip chunks nothing has touched.
+         */
+        struct Chunk
+        {
+            Archetype* archetype = nullptr;
+            uint8_t* data = nullptr;
+            uint32_t count = 0;
+            uint32_t capacity = 0;
+            std::vector<uint64_t> column_versions;
+
+            Entity* get_entities() const;
+        };
+
+        /**
+         * Every entity with exactly the component set mask and the same group.
+         * The group is a small integer that splits otherwise identical entities
+         * into separate chunks, e.g. by hierarchy depth, so a system can walk one
+         * group at a time.
+         */
+        struct Archetype
+        {
+            ComponentMask mask = 0;
+            uint32_t group = 0;
+
+            std::vector<ComponentType> types;
+            // Column of each component type, -1 when absent.
+            int8_t columns[max_component_types];
+            std::vector<uint32_t> column_offsets;
+            std::vector<uint32_t> column_sizes;
+            uint32_t entity_offset = 0;
+
+            uint32_t chunk_bytes = 0;
+            uint32_t chunk_capacity = 0;
+            std::vector<Chunk*> chunks;
+            // Chunks with free rows, the last one first.
+            std::vector<Chunk*> open_chunks;
+
+            uint32_t entity_count = 0;
+        };
+
+        /**
+         * One chunk of a query, with typed access to its columns.
+         */
+        class ChunkView
+        {
+            private:
+                Chunk* chunk;
+                uint64_t version;
+
+            public:
+                ChunkView(Chunk* chunk, uint64_t version) : chunk(chunk), version(version) {}
+
+                uint32_t size() const { return chunk->count; }
+
+                uint32_t get_group() const;
+
+                const Entity* get_entities() const { return chunk->get_entities(); }
+
+                bool has(ComponentType type) const;
+
+                /**
+                 * Read access; nullptr when the chunk does not have T.
+                 */
+                template <typename T>
+                const T* read() const { return static_cast<const T*>(column(component_type<T>())); }
+
+                /**
+                 * Write access; stamps the column with the current world version.
+                 */
+                template <typename T>
+                T* write()
+                {
+                    ComponentType type = component_type<T>();
+                    mark_changed(type);
+                    return static_cast<T*>(column(type));
+                }
+
+                /**
+                 * Whether T was written to after version.
+                 */
+                template <typename T>
+                bool changed_since(uint64_t since) const { return column_version(component_type<T>()) > since; }
+
+                void* column(ComponentType type) const;
+
+                uint64_t column_version(ComponentType type) const;
+
+                void mark_changed(ComponentType type);
+
+                Chunk* get_chunk() const { return chunk; }
+        };
+
+        /**
+         * Archetype-chunked entity storage.
+         *
+         * Entities with the same component set live together in 16 KiB chunks, so
+         * iterating a query walks contiguous arrays instead of chasing pointers.
+         * Adding or removing a component moves the entity to another archetype;
+         * structural changes are not allowed while a query runs.
+         */
+        class World
+        {
+            public:
+                typedef std::function<void(ChunkView& chunk)> ChunkFunction;
+
+                struct Statistics
+                {
+                    uint32_t entities = 0;
+                    uint32_t archetypes = 0;
+                    uint32_t chunks = 0;
+                    // Live rows over chunk capacity.
+                    double occupancy = 0.0;
+                    uint64_t structural_moves = 0;
+                };
+
+            private:
+                struct EntityRecord
+                {
+                    Chunk* chunk = nullptr;
+                    uint32_t row = 0;
+                    uint32_t generation = 0;
+                };
+
+                std::vector<EntityRecord> records;
+                std::vector<uint32_t> free_indices;
+                uint32_t entity_count = 0;
+
+                std::vector<std::unique_ptr<Archetype>> archetypes;
+                std::map<std::pair<ComponentMask, uint32_t>, Archetype*> archetype_lookup;
+                uint64_t version = 1;
+                uint64_t structural_moves = 0;
+
+                static const uint32_t chunk_size = 16 * 1024;
+                static const uint32_t cache_line = 64;
+
+            public:
+                World() = default;
+                World(const World&) = delete;
+                World& operator=(const World&) = delete;
+
+                ~World() { clear(); }
+
+                void clear();
+
+                Entity create_entity(uint32_t group = 0);
+
+                void destroy_entity(Entity entity);
+
+                bool is_alive(Entity entity) const
+                {
+                    return entity.index < records.size() && records[entity.index].generation == entity.generation && entity.generation != 0;
+                }
+
+                uint32_t size() const { return entity_count; }
+
+                /**
+                 * Adds the component, or overwrites it when the entity already has it.
+                 */
+                template <typename T>
+                T& add(Entity entity, const T& value = T{})
+                {
+                    ComponentType type = component_type<T>();
+                    void* destination = add_component(entity, type);
+                    *static_cast<T*>(destination) = value;
+                    return *static_cast<T*>(destination);
+                }
+
+                template <typename T>
+                void remove(Entity entity) { remove_component(entity, component_type<T>()); }
+
+                template <typename T>
+                bool has(Entity entity) const { return get_component(entity, component_type<T>()) != nullptr; }
+
+                /**
+                 * nullptr when the entity does not have T.
+                 */
+                template <typename T>
+                const T* get(Entity entity) const { return static_cast<const T*>(get_component(entity, component_type<T>())); }
+
+                /**
+                 * Write access; stamps the entity's chunk column with the current version.
+                 */
+                template <typename T>
+                T* get_mut(Entity entity) { return static_cast<T*>(get_component_mut(entity, component_type<T>())); }
+
+                void* add_component(Entity entity, ComponentType type);
+
+                void remove_component(Entity entity, ComponentType type);
+
+                const void* get_component(Entity entity, ComponentType type) const;
+
+                void* get_component_mut(Entity entity, ComponentType type);
+
+                uint32_t get_group(Entity entity) const;
+
+                /**
+                 * Moves the entity to the archetype with the same components in group.
+                 */
+                void set_group(Entity entity, uint32_t group);
+
+                /**
+                 * Chunks with every component of all and none of none, in archetype
+                 * then chunk order. Only groups in [first_group, last_group] match.
+                 */
+                void for_each_chunk(ComponentMask all, ComponentMask none, const ChunkFunction& function, uint32_t first_group = 0, uint32_t last_group = ~0u);
+
+                /**
+                 * Same, with chunks spread over the job system. The function runs
+                 * concurrently on different chunks.
+                 */
+                void for_each_chunk_parallel(Jobs::JobSystem& jobs, ComponentMask all, ComponentMask none, const ChunkFunction& function, uint32_t first_group = 0, uint32_t last_group = ~0u);
+
+                /**
+                 * Chunks matching a query, for callers scheduling them themselves.
+                 */
+                void collect_chunks(ComponentMask all, ComponentMask none, std::vector<Chunk*>& chunks, uint32_t first_group = 0, uint32_t last_group = ~0u) const;
+
+                /**
+                 * Largest group of any non-empty archetype matching all.
+                 */
+                uint32_t get_max_group(ComponentMask all) const;
+
+                /**
+                 * Writes from now on are stamped with a new version; returns it.
+                 * Systems remember the version they last ran at.
+                 */
+                uint64_t advance_version() { return ++version; }
+
+                uint64_t get_version() const { return version; }
+
+                Statistics get_statistics() const;
+
+                void print_statistics(std::ostream& out) const;
+
+            private:
+                Archetype* get_archetype(ComponentMask mask, uint32_t group);
+
+                Chunk* acquire_chunk(Archetype& archetype);
+
+                uint32_t push_row(Archetype& archetype, Entity entity, Chunk*& chunk);
+
+                void remove_row(Chunk* chunk, uint32_t row);
+
+                void move_entity(Entity entity, Archetype& target);
+
+                void free_chunk(Chunk* chunk);
+        };
+    };
+};
@@ -0,0 +1,40 @@
+#include "buffer.hpp"
+#include "image.hpp"
+
+namespace VulkanGameEngine
+{
+    namespace Utils
+    {
+        void create_buffer(
+            VkDevice device,
+            VkPhysicalDevice physical_device,
+            VkDeviceSize size,
+            VkBufferUsageFlags usage,
+            VkMemoryPropertyFlags properties,
+            VkBuffer& buffer,
+            VkDeviceMemory& buffer_memory)
+        {
+            VkBufferCreateInfo create_info{};
+            create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+            create_info.size = size;
+            create_info.usage = usage;
+            create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+            if (vkCreateBuffer(device, &create_info, nullptr, &buffer) != VK_SUCCESS)
+                throw std::runtime_error("\nFailed to create buffer.");
+
+            VkMemoryRequirements memory_requirements;
+            vkGetBufferMemoryRequirements(device, buffer, &memory_requirements);
+
+            VkMemoryAllocateInfo allocate_info{};
+            allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+            allocate_info.allocationSize = memory_requirements.size;
+            allocate_info.memoryTypeIndex = find_memory_type(physical_device, memory_requirements.memoryTypeBits, properties);
+
+            if (vkAllocateMemory(device, &allocate_info, nullptr, &buffer_memory) != VK_SUCCESS)
+                throw std::runtime_error("\nFailed to allocate buffer memory.");
+
+            vkBindBufferMemory(device, buffer, buffer_memory, 0);
+        }
+    };
+};
@@ -0,0 +1,32 @@
+#pragma once
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-09-25
+ *
+ */
+
+#include <iostream>
+#include <stdexcept>
+
+#include "platform.hpp"
+
+namespace VulkanGameEngine
+{
+    namespace Utils
+    {
+        void create_buffer(
+            VkDevice device,
+            VkPhysicalDevice physical_device,
+            VkDeviceSize size,
+            VkBufferUsageFlags usage,
+            VkMemoryPropertyFlags properties,
+            VkBuffer& buffer,
+            VkDeviceMemory& buffer_memory);
+
+        inline VkDeviceSize align_up(VkDeviceSize value, VkDeviceSize alignment)
+        {
+            return alignment > 1 ? (value + alignment - 1) / alignment * alignment : value;
+        }
+
+    };
+};
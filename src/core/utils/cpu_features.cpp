@@ -0,0 +1,80 @@
+#include "cpu_features.hpp"
+
+#include <cstdint>
+
+#if defined(_M_X64) || defined(_M_IX86)
+    #include <intrin.h>
+    #include <immintrin.h>
+    #define VGE_X86 1
+#elif defined(__x86_64__) || defined(__i386__)
+    #include <cpuid.h>
+    #define VGE_X86 1
+#endif
+
+namespace VulkanGameEngine
+{
+    namespace Utils
+    {
+        #ifdef VGE_X86
+            static void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t registers[4])
+            {
+                #ifdef _MSC_VER
+                    int values[4];
+                    __cpuidex(values, static_cast<int>(leaf), static_cast<int>(subleaf));
+                    for (int i = 0; i < 4; i++)
+                        registers[i] = static_cast<uint32_t>(values[i]);
+                #else
+                    __cpuid_count(leaf, subleaf, registers[0], registers[1], registers[2], registers[3]);
+                #endif
+            }
+
+            static uint64_t read_xcr0()
+            {
+                #ifdef _MSC_VER
+                    return _xgetbv(0);
+                #else
+                    uint32_t low, high;
+                    __asm__ volatile("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+                    return (static_cast<uint64_t>(high) << 32) | low;
+                #endif
+            }
+        #endif
+
+        static CpuFeatures detect_cpu_features()
+        {
+            CpuFeatures features;
+
+            #ifdef VGE_X86
+                uint32_t registers[4];
+                cpuid(0, 0, registers);
+                uint32_t max_leaf = registers[0];
+                if (max_leaf < 1)
+                    return features;
+
+                cpuid(1, 0, registers);
+                features.sse2 = (registers[3] & (1u << 26)) != 0;
+                features.sse41 = (registers[2] & (1u << 19)) != 0;
+
+                // AVX registers are only usable if the OS saves them on context switches.
+                bool osxsave = (registers[2] & (1u << 27)) != 0;
+                bool ymm_enabled = osxsave && (read_xcr0() & 0x6) == 0x6;
+                features.avx = ymm_enabled && (registers[2] & (1u << 28)) != 0;
+                features.fma = features.avx && (registers[2] & (1u << 12)) != 0;
+
+                if (max_leaf >= 7)
+                {
+                    cpuid(7, 0, registers);
+                    features.avx2 = features.avx && (registers[1] & (1u << 5)) != 0;
+                }
+            #endif
+
+            return features;
+        }
+
+        const CpuFeatures& get_cpu_features()
+        {
+            static const CpuFeatures features = detect_cpu_features();
+            return features;
+        }
+    };
+};
@@ -0,0 +1,31 @@
+#pragma once
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-10
+ *
+ */
+
+namespace VulkanGameEngine
+{
+    namespace Utils
+    {
+        /**
+         * Instruction set extensions of the CPU we run on, with OS support for
+         * the wider registers checked (XGETBV), so a true flag is safe to use.
+         * Always false on non-x86 targets.
+         */
+        struct CpuFeatures
+        {
+            bool sse2 = false;
+            bool sse41 = false;
+            bool avx = false;
+            bool avx2 = false;
+            bool fma = false;
+        };
+
+        /**
+         * Queried once, on first call.
+         */
+        const CpuFeatures& get_cpu_features();
+    };
+};
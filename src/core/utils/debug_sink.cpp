@@ -0,0 +1,344 @@
+#include "debug_sink.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <climits>
+#include <algorithm>
+#include <chrono>
+
+namespace VulkanGameEngine
+{
+    namespace Utils
+    {
+        static const int64_t no_muted_id = INT64_MIN;
+
+        static const char* severity_names[DebugMessageSink::SeverityCount] = {"verbose", "info", "warning", "error"};
+        static const char* type_names[DebugMessageSink::MessageTypeCount] = {"general", "validation", "performance"};
+
+        static void copy_truncated(char* destination, size_t capacity, const char* source)
+        {
+            if (source == nullptr)
+            {
+                destination[0] = '\0';
+                return;
+            }
+
+            size_t length = strnlen(source, capacity - 1);
+            memcpy(destination, source, length);
+            destination[length] = '\0';
+        }
+
+        DebugMessageSink::DebugMessageSink()
+        {
+            set_minimum_severity(VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT);
+            type_mask.store(UINT32_MAX, std::memory_order_relaxed);
+            for (auto& id : muted_ids)
+                id.store(no_muted_id, std::memory_order_relaxed);
+        }
+
+        DebugMessageSink::~DebugMessageSink()
+        {
+            stop();
+        }
+
+        void DebugMessageSink::start(size_t ring_capacity, std::ostream& out)
+        {
+            if (running.load())
+                return;
+
+            size_t capacity = 1;
+            while (capacity < ring_capacity)
+                capacity <<= 1;
+
+            slots.reset(new Slot[capacity]);
+            for (size_t i = 0; i < capacity; i++)
+                slots[i].sequence.store(i, std::memory_order_relaxed);
+            mask = capacity - 1;
+            tail.store(0, std::memory_order_relaxed);
+            head = 0;
+
+            this->out = &out;
+
+            running.store(true);
+            drain_thread = std::thread(&DebugMessageSink::drain_loop, this);
+        }
+
+        void DebugMessageSink::stop()
+        {
+            if (!running.exchange(false))
+                return;
+
+            wake.notify_one();
+            drain_thread.join();
+
+            // Messages submitted while the thread was exiting.
+            drain();
+
+            print_statistics(*out);
+            out->flush();
+        }
+
+        bool DebugMessageSink::submit(
+            VkDebugUtilsMessageSeverityFlagBitsEXT severity,
+            VkDebugUtilsMessageTypeFlagsEXT type,
+            const VkDebugUtilsMessengerCallbackDataEXT* data)
+        {
+            if (!(severity & severity_mask.load(std::memory_order_relaxed)) ||
+                !(type & type_mask.load(std::memory_order_relaxed)) ||
+                is_muted(data->messageIdNumber))
+            {
+                filtered.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+
+            if (!slots)
+            {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+
+            // Claim a position; give up instead of waiting when the ring is full.
+            Slot* slot;
+            uint64_t position = tail.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                slot = &slots[position & mask];
+                uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+                int64_t difference = static_cast<int64_t>(sequence - position);
+
+                if (difference == 0)
+                {
+                    if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                        break;
+                }
+                else if (difference < 0)
+                {
+                    dropped.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+                else
+                    position = tail.load(std::memory_order_relaxed);
+            }
+
+            Message& message = slot->message;
+            message.severity = severity;
+            message.type = type;
+            message.id_number = data->messageIdNumber;
+            copy_truncated(message.id_name, id_name_capacity, data->pMessageIdName);
+            copy_truncated(message.text, text_capacity, data->pMessage);
+
+            slot->sequence.store(position + 1, std::memory_order_release);
+
+            // Errors are worth printing now; everything else waits for the next poll.
+            if (severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT)
+                wake.notify_one();
+
+            return true;
+        }
+
+        void DebugMessageSink::set_minimum_severity(VkDebugUtilsMessageSeverityFlagBitsEXT minimum)
+        {
+            // Severity bits grow with severity, so everything from minimum up is kept.
+            uint32_t mask = ~(static_cast<uint32_t>(minimum) - 1);
+            severity_mask.store(mask, std::memory_order_relaxed);
+        }
+
+        void DebugMessageSink::set_type_mask(VkDebugUtilsMessageTypeFlagsEXT types)
+        {
+            type_mask.store(types, std::memory_order_relaxed);
+        }
+
+        bool DebugMessageSink::mute(int32_t id_number)
+        {
+            std::lock_guard<std::mutex> lock(mute_mutex);
+
+            if (is_muted(id_number))
+                return true;
+
+            for (auto& id : muted_ids)
+            {
+                if (id.load(std::memory_order_relaxed) == no_muted_id)
+                {
+                    id.store(id_number, std::memory_order_relaxed);
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        void DebugMessageSink::unmute(int32_t id_number)
+        {
+            std::lock_guard<std::mutex> lock(mute_mutex);
+
+            for (auto& id : muted_ids)
+                if (id.load(std::memory_order_relaxed) == id_number)
+                    id.store(no_muted_id, std::memory_order_relaxed);
+        }
+
+        bool DebugMessageSink::is_muted(int32_t id_number) const
+        {
+            for (const auto& id : muted_ids)
+                if (id.load(std::memory_order_relaxed) == id_number)
+                    return true;
+            return false;
+        }
+
+        DebugMessageSink::Statistics DebugMessageSink::get_statistics() const
+        {
+            Statistics result;
+            {
+                std::lock_guard<std::mutex> lock(state_mutex);
+                result = statistics;
+            }
+            result.filtered = filtered.load(std::memory_order_relaxed);
+            result.dropped = dropped.load(std::memory_order_relaxed);
+            return result;
+        }
+
+        void DebugMessageSink::print_statistics(std::ostream& out) const
+        {
+            Statistics current = get_statistics();
+
+            char line[256];
+            snprintf(line, sizeof(line), "\nDebug messages: %llu received, %llu printed, %llu suppressed, %llu filtered, %llu dropped\n",
+                static_cast<unsigned long long>(current.received),
+                static_cast<unsigned long long>(current.printed),
+                static_cast<unsigned long long>(current.suppressed),
+                static_cast<unsigned long long>(current.filtered),
+                static_cast<unsigned long long>(current.dropped));
+            out << line;
+
+            for (int type = 0; type < MessageTypeCount; type++)
+            {
+                const uint64_t* counts = current.by_type[type];
+                if (!counts[Verbose] && !counts[Info] && !counts[Warning] && !counts[Error])
+                    continue;
+
+                snprintf(line, sizeof(line), "  %-12s verbose %llu, info %llu, warning %llu, error %llu\n",
+                    type_names[type],
+                    static_cast<unsigned long long>(counts[Verbose]),
+                    static_cast<unsigned long long>(counts[Info]),
+                    static_cast<unsigned long long>(counts[Warning]),
+                    static_cast<unsigned long long>(counts[Error]));
+                out << line;
+            }
+
+            uint32_t repeats = max_repeats.load(std::memory_order_relaxed);
+            std::vector<Entry> repeated;
+            {
+                std::lock_guard<std::mutex> lock(state_mutex);
+                for (const auto& entry : entries)
+                    if (entry.second.count > repeats)
+                        repeated.push_back(entry.second);
+            }
+            std::sort(repeated.begin(), repeated.end(), [](const Entry& a, const Entry& b) { return a.count > b.count; });
+
+            for (const auto& entry : repeated)
+            {
+                snprintf(line, sizeof(line), "  %8llu x %s (0x%08x)\n",
+                    static_cast<unsigned long long>(entry.count),
+                    entry.id_name.empty() ? "<unnamed>" : entry.id_name.c_str(),
+                    static_cast<uint32_t>(entry.id_number));
+                out << line;
+            }
+        }
+
+        bool DebugMessageSink::drain()
+        {
+            bool drained = false;
+
+            for (;;)
+            {
+                Slot& slot = slots[head & mask];
+                if (slot.sequence.load(std::memory_order_acquire) != head + 1)
+                    break;
+
+                handle(slot.message);
+
+                slot.sequence.store(head + mask + 1, std::memory_order_release);
+                head++;
+                drained = true;
+            }
+
+            if (drained)
+                out->flush();
+            return drained;
+        }
+
+        void DebugMessageSink::handle(const Message& message)
+        {
+            // Loader and driver messages often have no ID: tell them apart by name, then text.
+            uint64_t key;
+            if (message.id_number != 0)
+                key = static_cast<uint32_t>(message.id_number);
+            else
+            {
+                key = 14695981039346656037ull;
+                for (const char* c = message.id_name[0] ? message.id_name : message.text; *c; c++)
+                {
+                    key ^= static_cast<unsigned char>(*c);
+                    key *= 1099511628211ull;
+                }
+                key |= 1ull << 63;
+            }
+
+            int type = (message.type & VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT) ? Validation
+                : (message.type & VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT) ? Performance
+                : General;
+            Severity severity = severity_index(message.severity);
+            uint32_t repeats = max_repeats.load(std::memory_order_relaxed);
+
+            uint64_t count;
+            {
+                std::lock_guard<std::mutex> lock(state_mutex);
+
+                Entry& entry = entries[key];
+                if (entry.count == 0)
+                {
+                    entry.id_name = message.id_name;
+                    entry.id_number = message.id_number;
+                }
+                count = ++entry.count;
+
+                statistics.received++;
+                statistics.by_type[type][severity]++;
+                if (count <= repeats)
+                    statistics.printed++;
+                else
+                    statistics.suppressed++;
+            }
+
+            if (count > repeats)
+                return;
+
+            *out << "[" << severity_names[severity] << "][" << type_names[type] << "] " << message.text;
+            if (count == repeats)
+                *out << " (further repeats counted only)";
+            *out << '\n';
+        }
+
+        void DebugMessageSink::drain_loop()
+        {
+            while (running.load())
+            {
+                if (drain())
+                    continue;
+
+                std::unique_lock<std::mutex> lock(wake_mutex);
+                wake.wait_for(lock, std::chrono::milliseconds(10));
+            }
+        }
+
+        DebugMessageSink::Severity DebugMessageSink::severity_index(VkDebugUtilsMessageSeverityFlagBitsEXT severity)
+        {
+            if (severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT)
+                return Error;
+            if (severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT)
+                return Warning;
+            if (severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT)
+                return Info;
+            return Verbose;
+        }
+    };
+};
@@ -0,0 +1,189 @@
+#pragma once
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-04
+ *
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+#include "platform.hpp"
+
+namespace VulkanGameEngine
+{
+    namespace Utils
+    {
+        /**
+         * Validation and debug messages, printed from a background thread.
+         *
+         * submit() is called from the driver's thread (often the render thread) and
+         * never blocks: it checks the filters, copies the message into a lock-free
+         * ring and returns. When the ring is full the message is dropped and counted.
+         *
+         * The drain thread keeps per message type statistics, prints the first
+         * max_repeats occurrences of each message ID and only counts the others;
+         * the counts are printed by stop().
+         */
+        class DebugMessageSink
+        {
+            public:
+                static const size_t id_name_capacity = 64;
+                static const size_t text_capacity = 1024;
+                static const uint32_t max_muted_ids = 32;
+
+                enum MessageType
+                {
+                    General = 0,
+                    Validation,
+                    Performance,
+                    MessageTypeCount
+                };
+
+                enum Severity
+                {
+                    Verbose = 0,
+                    Info,
+                    Warning,
+                    Error,
+                    SeverityCount
+                };
+
+                struct Statistics
+                {
+                    uint64_t received = 0;
+                    uint64_t filtered = 0;
+                    uint64_t dropped = 0;
+                    uint64_t printed = 0;
+                    uint64_t suppressed = 0;
+                    uint64_t by_type[MessageTypeCount][SeverityCount] = {};
+                };
+
+            private:
+                struct Message
+                {
+                    VkDebugUtilsMessageSeverityFlagBitsEXT severity;
+                    VkDebugUtilsMessageTypeFlagsEXT type;
+                    int32_t id_number;
+                    char id_name[id_name_capacity];
+                    char text[text_capacity];
+                };
+
+                /**
+                 * Ring slot. sequence == position: free for the producer claiming position;
+                 * sequence == position + 1: holds the message written at position.
+                 */
+                struct Slot
+                {
+                    std::atomic<uint64_t> sequence;
+                    Message message;
+                };
+
+                struct Entry
+                {
+                    std::string id_name;
+                    int32_t id_number = 0;
+                    uint64_t count = 0;
+                };
+
+                std::unique_ptr<Slot[]> slots;
+                uint64_t mask = 0;
+                alignas(64) std::atomic<uint64_t> tail{0};
+                alignas(64) uint64_t head = 0;
+
+                // Runtime filters, read by submit().
+                std::atomic<uint32_t> severity_mask;
+                std::atomic<uint32_t> type_mask;
+                std::atomic<int64_t> muted_ids[max_muted_ids];
+                std::mutex mute_mutex;
+                // Read by the drain thread.
+                std::atomic<uint32_t> max_repeats{3};
+
+                std::atomic<uint64_t> filtered{0};
+                std::atomic<uint64_t> dropped{0};
+
+                std::thread drain_thread;
+                std::atomic<bool> running{false};
+                std::mutex wake_mutex;
+                std::condition_variable wake;
+
+                // Owned by the drain thread; guarded for get_statistics().
+                mutable std::mutex state_mutex;
+                std::unordered_map<uint64_t, Entry> entries;
+                Statistics statistics;
+
+                std::ostream* out = &std::cerr;
+
+            public:
+                DebugMessageSink();
+
+                ~DebugMessageSink();
+
+                DebugMessageSink(const DebugMessageSink&) = delete;
+                DebugMessageSink& operator=(const DebugMessageSink&) = delete;
+
+                /**
+                 * ring_capacity is rounded up to a power of two.
+                 */
+                void start(size_t ring_capacity = 1024, std::ostream& out = std::cerr);
+
+                /**
+                 * Prints what is left in the ring and the suppressed message counts.
+                 */
+                void stop();
+
+                bool is_running() const { return running.load(std::memory_order_relaxed); }
+
+                /**
+                 * Never blocks. Returns false if the message was filtered out or dropped.
+                 */
+                bool submit(
+                    VkDebugUtilsMessageSeverityFlagBitsEXT severity,
+                    VkDebugUtilsMessageTypeFlagsEXT type,
+                    const VkDebugUtilsMessengerCallbackDataEXT* data);
+
+                /**
+                 * Messages below minimum are ignored.
+                 */
+                void set_minimum_severity(VkDebugUtilsMessageSeverityFlagBitsEXT minimum);
+
+                void set_type_mask(VkDebugUtilsMessageTypeFlagsEXT types);
+
+                /**
+                 * Ignore every message with this messageIdNumber. Returns false when
+                 * max_muted_ids IDs are already muted.
+                 */
+                bool mute(int32_t id_number);
+
+                void unmute(int32_t id_number);
+
+                /**
+                 * Full copies of each message ID printed before it is only counted.
+                 */
+                void set_max_repeats(uint32_t repeats) { max_repeats.store(repeats, std::memory_order_relaxed); }
+
+                Statistics get_statistics() const;
+
+                void print_statistics(std::ostream& out) const;
+
+            private:
+                bool is_muted(int32_t id_number) const;
+
+                bool drain();
+
+                void handle(const Message& message);
+
+                void drain_loop();
+
+                static Severity severity_index(VkDebugUtilsMessageSeverityFlagBitsEXT severity);
+        };
+    };
+};
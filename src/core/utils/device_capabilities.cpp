@@ -0,0 +1,133 @@
+#include "device_capabilities.hpp"
+
+#include <cstring>
+
+namespace VulkanGameEngine
+{
+    namespace Utils
+    {
+        bool DeviceCapabilities::supports_extension(const char* name) const
+        {
+            for (const auto& extension : extensions)
+                if (strcmp(extension.extensionName, name) == 0)
+                    return true;
+            return false;
+        }
+
+        bool DeviceCapabilities::supports_extensions(const std::vector<const char*>& names) const
+        {
+            for (const char* name : names)
+                if (!supports_extension(name))
+                    return false;
+            return true;
+        }
+
+        VkDeviceSize DeviceCapabilities::device_local_bytes() const
+        {
+            VkDeviceSize total = 0;
+            for (uint32_t i = 0; i < memory_properties.memoryHeapCount; i++)
+                if (memory_properties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+                    total += memory_properties.memoryHeaps[i].size;
+            return total;
+        }
+
+        bool DeviceCapabilities::supports_bindless() const
+        {
+            const VkPhysicalDeviceDescriptorIndexingFeaturesEXT& features = descriptor_indexing_features;
+
+            return descriptor_indexing &&
+                features.runtimeDescriptorArray &&
+                features.descriptorBindingPartiallyBound &&
+                features.descriptorBindingUpdateUnusedWhilePending &&
+                features.shaderSampledImageArrayNonUniformIndexing &&
+                features.descriptorBindingSampledImageUpdateAfterBind &&
+                features.descriptorBindingStorageBufferUpdateAfterBind;
+        }
+
+        DeviceCapabilities query_device_capabilities(VkPhysicalDevice device, VkSurfaceKHR surface)
+        {
+            DeviceCapabilities capabilities;
+            capabilities.physical_device = device;
+
+            vkGetPhysicalDeviceProperties(device, &capabilities.properties);
+            vkGetPhysicalDeviceFeatures(device, &capabilities.features);
+            vkGetPhysicalDeviceMemoryProperties(device, &capabilities.memory_properties);
+
+            uint32_t queue_family_count = 0;
+            vkGetPhysicalDeviceQueueFamilyProperties(device, &queue_family_count, nullptr);
+            capabilities.queue_families.resize(queue_family_count);
+            vkGetPhysicalDeviceQueueFamilyProperties(device, &queue_family_count, capabilities.queue_families.data());
+
+            uint32_t extension_count = 0;
+            vkEnumerateDeviceExtensionProperties(device, nullptr, &extension_count, nullptr);
+            capabilities.extensions.resize(extension_count);
+            vkEnumerateDeviceExtensionProperties(device, nullptr, &extension_count, capabilities.extensions.data());
+
+            if (capabilities.properties.apiVersion >= VK_API_VERSION_1_1 &&
+                capabilities.supports_extension(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME))
+            {
+                capabilities.descriptor_indexing = true;
+
+                capabilities.descriptor_indexing_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+                VkPhysicalDeviceFeatures2 features{};
+                features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+                features.pNext = &capabilities.descriptor_indexing_features;
+                vkGetPhysicalDeviceFeatures2(device, &features);
+
+                capabilities.descriptor_indexing_properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES_EXT;
+                VkPhysicalDeviceProperties2 properties{};
+                properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+                properties.pNext = &capabilities.descriptor_indexing_properties;
+                vkGetPhysicalDeviceProperties2(device, &properties);
+
+                // The capabilities are copied around; never leave pointers into a temporary.
+                capabilities.descriptor_indexing_features.pNext = nullptr;
+                capabilities.descriptor_indexing_properties.pNext = nullptr;
+            }
+
+            capabilities.memory_budget =
+                capabilities.properties.apiVersion >= VK_API_VERSION_1_1 &&
+                capabilities.supports_extension(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+
+            if (surface == VK_NULL_HANDLE)
+                return capabilities;
+
+            capabilities.surface_queried = true;
+
+            capabilities.present_support.resize(queue_family_count, VK_FALSE);
+            for (uint32_t i = 0; i < queue_family_count; i++)
+                vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &capabilities.present_support[i]);
+
+            uint32_t format_count = 0;
+            vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &format_count, nullptr);
+            capabilities.surface_formats.resize(format_count);
+            if (format_count != 0)
+                vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &format_count, capabilities.surface_formats.data());
+
+            uint32_t present_mode_count = 0;
+            vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &present_mode_count, nullptr);
+            capabilities.present_modes.resize(present_mode_count);
+            if (present_mode_count != 0)
+                vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &present_mode_count, capabilities.present_modes.data());
+
+            return capabilities;
+        }
+
+        bool query_memory_budget(const DeviceCapabilities& capabilities, VkPhysicalDeviceMemoryBudgetPropertiesEXT& budget)
+        {
+            if (!capabilities.memory_budget)
+                return false;
+
+            budget = VkPhysicalDeviceMemoryBudgetPropertiesEXT{};
+            budget.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+            VkPhysicalDeviceMemoryProperties2 properties{};
+            properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+            properties.pNext = &budget;
+            vkGetPhysicalDeviceMemoryProperties2(capabilities.physical_device, &properties);
+
+            budget.pNext = nullptr;
+            return true;
+        }
+    };
+};
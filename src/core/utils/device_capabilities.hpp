@@ -0,0 +1,88 @@
+#pragma once
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-09-28
+ *
+ */
+
+#include <iostream>
+#include <vector>
+#include <cstdint>
+
+#include "platform.hpp"
+
+namespace VulkanGameEngine
+{
+    namespace Utils
+    {
+        /**
+         * Everything the engine needs to know about a physical device, queried
+         * once when devices are ranked and reused for the rest of startup.
+         * None of it changes for the lifetime of the instance, except the
+         * surface capabilities (current extent), which are not part of it.
+         */
+        struct DeviceCapabilities
+        {
+            VkPhysicalDevice physical_device = VK_NULL_HANDLE;
+
+            VkPhysicalDeviceProperties properties{};
+            VkPhysicalDeviceFeatures features{};
+            VkPhysicalDeviceMemoryProperties memory_properties{};
+
+            std::vector<VkQueueFamilyProperties> queue_families;
+            std::vector<VkExtensionProperties> extensions;
+
+            /**
+             * VK_EXT_descriptor_indexing, only queried on Vulkan 1.1 devices
+             * (it needs vkGetPhysicalDeviceFeatures2). pNext is always null.
+             */
+            bool descriptor_indexing = false;
+            VkPhysicalDeviceDescriptorIndexingFeaturesEXT descriptor_indexing_features{};
+            VkPhysicalDeviceDescriptorIndexingPropertiesEXT descriptor_indexing_properties{};
+
+            /**
+             * VK_EXT_memory_budget: current per-heap budget and usage of the whole
+             * process, queried with query_memory_budget().
+             */
+            bool memory_budget = false;
+
+            /**
+             * Surface support, only filled in when queried with a surface.
+             */
+            bool surface_queried = false;
+            std::vector<VkBool32> present_support;
+            std::vector<VkSurfaceFormatKHR> surface_formats;
+            std::vector<VkPresentModeKHR> present_modes;
+
+            bool supports_present(uint32_t queue_family) const
+            {
+                return queue_family < present_support.size() && present_support[queue_family];
+            }
+
+            bool supports_extension(const char* name) const;
+
+            bool supports_extensions(const std::vector<const char*>& names) const;
+
+            VkDeviceSize device_local_bytes() const;
+
+            /**
+             * Everything a bindless descriptor table needs: partially bound,
+             * update-after-bind arrays indexed non-uniformly.
+             */
+            bool supports_bindless() const;
+        };
+
+        /**
+         * surface may be VK_NULL_HANDLE, in which case surface support is skipped.
+         */
+        DeviceCapabilities query_device_capabilities(VkPhysicalDevice device, VkSurfaceKHR surface);
+
+        /**
+         * Fills budget with the current heap budgets and usage. Returns false, leaving
+         * budget untouched, when the device does not support VK_EXT_memory_budget.
+         * The extension must be enabled on the logical device.
+         */
+        bool query_memory_budget(const DeviceCapabilities& capabilities, VkPhysicalDeviceMemoryBudgetPropertiesEXT& budget);
+
+    };
+};
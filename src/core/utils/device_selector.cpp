@@ -0,0 +1,208 @@
+#include "device_selector.hpp"
+#include "swapchain.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+
+namespace VulkanGameEngine
+{
+    namespace Utils
+    {
+        static std::string to_lower(std::string value)
+        {
+            std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+            return value;
+        }
+
+        static int64_t device_type_score(VkPhysicalDeviceType type)
+        {
+            switch (type)
+            {
+                case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:   return 100000;
+                case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU: return 50000;
+                case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:    return 20000;
+                case VK_PHYSICAL_DEVICE_TYPE_CPU:            return 1000;
+                default:                                     return 0;
+            }
+        }
+
+        const char* device_type_name(VkPhysicalDeviceType type)
+        {
+            switch (type)
+            {
+                case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:   return "discrete";
+                case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU: return "integrated";
+                case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:    return "virtual";
+                case VK_PHYSICAL_DEVICE_TYPE_CPU:            return "cpu";
+                default:                                     return "other";
+            }
+        }
+
+        DeviceCandidate evaluate_device(VkPhysicalDevice device, VkSurfaceKHR& surface, const DeviceRequirements& requirements)
+        {
+            DeviceCandidate candidate;
+            candidate.device = device;
+
+            // The only driver round trips for this device; everything below works off the snapshot.
+            candidate.capabilities = query_device_capabilities(device, requirements.require_surface ? surface : VK_NULL_HANDLE);
+
+            const VkPhysicalDeviceProperties& properties = candidate.capabilities.properties;
+            const VkPhysicalDeviceFeatures& features = candidate.capabilities.features;
+
+            candidate.name = properties.deviceName;
+            candidate.type = properties.deviceType;
+            candidate.device_local_bytes = candidate.capabilities.device_local_bytes();
+
+            candidate.queues = find_queue_topology(candidate.capabilities);
+
+            /**
+             * Hard requirements.
+             */
+            if (properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_CPU && !requirements.allow_cpu)
+            {
+                candidate.rejection_reason = "software device not allowed";
+                return candidate;
+            }
+
+            if (!candidate.queues.graphics_family.has_value())
+            {
+                candidate.rejection_reason = "no graphics queue";
+                return candidate;
+            }
+
+            if (!candidate.capabilities.supports_extensions(requirements.extensions))
+            {
+                candidate.rejection_reason = "missing required extensions";
+                return candidate;
+            }
+
+            if (requirements.require_surface)
+            {
+                if (!is_device_suitable(candidate.capabilities))
+                {
+                    candidate.rejection_reason = "cannot present to the surface";
+                    return candidate;
+                }
+            }
+
+            candidate.suitable = true;
+
+            /**
+             * Soft preferences.
+             */
+            int64_t score = device_type_score(properties.deviceType);
+
+            // 1 point per 16 MiB of VRAM: 8 GiB is worth 512.
+            score += static_cast<int64_t>(candidate.device_local_bytes / (16ull << 20));
+
+            score += properties.limits.maxImageDimension2D / 256;
+            score += properties.limits.maxComputeWorkGroupInvocations / 64;
+            score += std::min<uint32_t>(properties.limits.maxMemoryAllocationCount, 1u << 20) / 4096;
+
+            if (features.geometryShader)
+                score += 100;
+            if (features.samplerAnisotropy)
+                score += 50;
+            if (features.multiDrawIndirect)
+                score += 50;
+
+            // Separate families let uploads and compute overlap with graphics.
+            if (candidate.queues.has_async_compute())
+                score += 250;
+            if (candidate.queues.has_dedicated_transfer())
+                score += 250;
+
+            candidate.score = score;
+            return candidate;
+        }
+
+        std::vector<DeviceCandidate> rank_physical_devices(VkInstance instance, VkSurfaceKHR& surface, const DeviceRequirements& requirements)
+        {
+            uint32_t device_count = 0;
+            vkEnumeratePhysicalDevices(instance, &device_count, nullptr);
+
+            std::vector<VkPhysicalDevice> devices(device_count);
+            vkEnumeratePhysicalDevices(instance, &device_count, devices.data());
+
+            std::vector<DeviceCandidate> candidates;
+            for (const auto& device : devices)
+                candidates.push_back(evaluate_device(device, surface, requirements));
+
+            // stable_sort keeps enumeration order between equally scored devices.
+            std::stable_sort(candidates.begin(), candidates.end(), [](const DeviceCandidate& a, const DeviceCandidate& b) {
+                if (a.suitable != b.suitable)
+                    return a.suitable;
+                return a.score > b.score;
+            });
+
+            return candidates;
+        }
+
+        DeviceCandidate select_physical_device(
+            VkInstance instance,
+            VkSurfaceKHR& surface,
+            const DeviceRequirements& requirements,
+            const std::string& preferred)
+        {
+            uint32_t device_count = 0;
+            vkEnumeratePhysicalDevices(instance, &device_count, nullptr);
+
+            if (device_count == 0)
+                throw std::runtime_error("\nFailed to find GPUs with Vulkan support!");
+
+            std::vector<DeviceCandidate> candidates = rank_physical_devices(instance, surface, requirements);
+
+            for (const auto& candidate : candidates)
+            {
+                printf("\nDevice '%s' (%s): ", candidate.name.c_str(), device_type_name(candidate.type));
+                if (candidate.suitable)
+                    printf("score %lld", static_cast<long long>(candidate.score));
+                else
+                    printf("rejected, %s", candidate.rejection_reason.c_str());
+            }
+
+            std::string override_name = preferred;
+            if (const char* env = std::getenv(device_override_env))
+                override_name = env;
+
+            if (!override_name.empty())
+            {
+                // The override is matched against enumeration order, not rank order.
+                uint32_t index = 0;
+                bool is_index = std::all_of(override_name.begin(), override_name.end(), [](unsigned char c) { return std::isdigit(c) != 0; });
+                if (is_index)
+                    index = static_cast<uint32_t>(std::stoul(override_name));
+
+                std::vector<VkPhysicalDevice> devices(device_count);
+                vkEnumeratePhysicalDevices(instance, &device_count, devices.data());
+
+                for (const auto& candidate : candidates)
+                {
+                    uint32_t enumeration_index = static_cast<uint32_t>(
+                        std::find(devices.begin(), devices.end(), candidate.device) - devices.begin());
+
+                    bool matches = is_index
+                        ? enumeration_index == index
+                        : to_lower(candidate.name).find(to_lower(override_name)) != std::string::npos;
+
+                    if (!matches)
+                        continue;
+
+                    if (candidate.suitable)
+                        return candidate;
+
+                    printf("\nRequested device '%s' is not suitable (%s), falling back to the best device.",
+                        candidate.name.c_str(), candidate.rejection_reason.c_str());
+                    break;
+                }
+            }
+
+            if (candidates.empty() || !candidates.front().suitable)
+                throw std::runtime_error("\nFailed to find a suitable GPU!");
+
+            return candidates.front();
+        }
+
+    };
+};
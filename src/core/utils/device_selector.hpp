@@ -0,0 +1,76 @@
+#pragma once
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-09-24
+ *
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "platform.hpp"
+#include "queuefamily.hpp"
+#include "device_capabilities.hpp"
+
+namespace VulkanGameEngine
+{
+    namespace Utils
+    {
+        /**
+         * Hard requirements a physical device has to meet to be considered at all.
+         */
+        struct DeviceRequirements
+        {
+            // Present support on the surface and an adequate swapchain.
+            bool require_surface = true;
+
+            // Accept software rasterizers (lavapipe, SwiftShader).
+            bool allow_cpu = false;
+
+            std::vector<const char*> extensions;
+        };
+
+        struct DeviceCandidate
+        {
+            VkPhysicalDevice device = VK_NULL_HANDLE;
+            std::string name;
+            VkPhysicalDeviceType type = VK_PHYSICAL_DEVICE_TYPE_OTHER;
+            uint64_t device_local_bytes = 0;
+
+            bool suitable = false;
+            std::string rejection_reason;
+
+            int64_t score = 0;
+            QueueTopology queues;
+
+            DeviceCapabilities capabilities;
+        };
+
+        /**
+         * Environment variable overriding the device choice.
+         * Either a device index or a case insensitive substring of the device name.
+         */
+        const inline char* device_override_env = "VGE_DEVICE";
+
+        DeviceCandidate evaluate_device(VkPhysicalDevice device, VkSurfaceKHR& surface, const DeviceRequirements& requirements);
+
+        /**
+         * Every physical device, best first. Unsuitable devices are listed last with a rejection reason.
+         */
+        std::vector<DeviceCandidate> rank_physical_devices(VkInstance instance, VkSurfaceKHR& surface, const DeviceRequirements& requirements);
+
+        /**
+         * Best suitable device, unless preferred (or VGE_DEVICE, which wins) names a suitable one.
+         */
+        DeviceCandidate select_physical_device(
+            VkInstance instance,
+            VkSurfaceKHR& surface,
+            const DeviceRequirements& requirements,
+            const std::string& preferred = "");
+
+        const char* device_type_name(VkPhysicalDeviceType type);
+
+    };
+};
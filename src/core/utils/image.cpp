@@ -0,0 +1,127 @@
+#include "image.hpp"
+
+namespace VulkanGameEngine
+{
+    namespace Utils
+    {
+        uint32_t find_memory_type(VkPhysicalDevice physical_device, uint32_t type_filter, VkMemoryPropertyFlags properties)
+        {
+            VkPhysicalDeviceMemoryProperties memory_properties;
+            vkGetPhysicalDeviceMemoryProperties(physical_device, &memory_properties);
+
+            return find_memory_type(memory_properties, type_filter, properties);
+        }
+
+        uint32_t find_memory_type(const VkPhysicalDeviceMemoryProperties& memory_properties, uint32_t type_filter, VkMemoryPropertyFlags properties)
+        {
+            for (uint32_t i = 0; i < memory_properties.memoryTypeCount; i++)
+                if ((type_filter & (1 << i)) && (memory_properties.memoryTypes[i].propertyFlags & properties) == properties)
+                    return i;
+
+            throw std::runtime_error("\nFailed to find suitable memory type.");
+        }
+
+        VkFormat find_supported_format(
+            VkPhysicalDevice physical_device,
+            const std::vector<VkFormat>& candidates,
+            VkImageTiling tiling,
+            VkFormatFeatureFlags features)
+        {
+            for (VkFormat format : candidates)
+            {
+                VkFormatProperties properties;
+                vkGetPhysicalDeviceFormatProperties(physical_device, format, &properties);
+
+                if (tiling == VK_IMAGE_TILING_LINEAR && (properties.linearTilingFeatures & features) == features)
+                    return format;
+                if (tiling == VK_IMAGE_TILING_OPTIMAL && (properties.optimalTilingFeatures & features) == features)
+                    return format;
+            }
+
+            throw std::runtime_error("\nFailed to find supported format.");
+        }
+
+        VkFormat find_depth_format(VkPhysicalDevice physical_device)
+        {
+            return find_supported_format(
+                physical_device,
+                {VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT},
+                VK_IMAGE_TILING_OPTIMAL,
+                VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
+        }
+
+        bool has_stencil_component(VkFormat format)
+        {
+            return format == VK_FORMAT_D32_SFLOAT_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT;
+        }
+
+        void create_image(
+            VkDevice device,
+            VkPhysicalDevice physical_device,
+            VkExtent2D extent,
+            VkFormat format,
+            VkImageTiling tiling,
+            VkImageUsageFlags usage,
+            VkMemoryPropertyFlags properties,
+            VkImage& image,
+            VkDeviceMemory& image_memory)
+        {
+            VkImageCreateInfo create_info{};
+            create_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+            create_info.imageType = VK_IMAGE_TYPE_2D;
+            create_info.extent.width = extent.width;
+            create_info.extent.height = extent.height;
+            create_info.extent.depth = 1;
+            create_info.mipLevels = 1;
+            create_info.arrayLayers = 1;
+            create_info.format = format;
+            create_info.tiling = tiling;
+            create_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            create_info.usage = usage;
+            create_info.samples = VK_SAMPLE_COUNT_1_BIT;
+            create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+            if (vkCreateImage(device, &create_info, nullptr, &image) != VK_SUCCESS)
+                throw std::runtime_error("\nFailed to create image.");
+
+            VkMemoryRequirements memory_requirements;
+            vkGetImageMemoryRequirements(device, image, &memory_requirements);
+
+            VkMemoryAllocateInfo allocate_info{};
+            allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+            allocate_info.allocationSize = memory_requirements.size;
+            allocate_info.memoryTypeIndex = find_memory_type(physical_device, memory_requirements.memoryTypeBits, properties);
+
+            if (vkAllocateMemory(device, &allocate_info, nullptr, &image_memory) != VK_SUCCESS)
+                throw std::runtime_error("\nFailed to allocate image memory.");
+
+            vkBindImageMemory(device, image, image_memory, 0);
+        }
+
+        VkImageView create_image_view(VkDevice device, VkImage image, VkFormat format, VkImageAspectFlags aspect_flags)
+        {
+            VkImageViewCreateInfo create_info{};
+            create_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+            create_info.image = image;
+            create_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+            create_info.format = format;
+
+            create_info.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+            create_info.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+            create_info.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+            create_info.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+
+            create_info.subresourceRange.aspectMask = aspect_flags;
+            create_info.subresourceRange.baseMipLevel = 0;
+            create_info.subresourceRange.levelCount = 1;
+            create_info.subresourceRange.baseArrayLayer = 0;
+            create_info.subresourceRange.layerCount = 1;
+
+            VkImageView image_view;
+            if (vkCreateImageView(device, &create_info, nullptr, &image_view) != VK_SUCCESS)
+                throw std::runtime_error("\nFailed to create image view.");
+
+            return image_view;
+        }
+    };
+};
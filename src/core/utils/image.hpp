@@ -0,0 +1,46 @@
+#pragma once
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-09-21
+ *
+ */
+
+#include <iostream>
+#include <vector>
+#include <stdexcept>
+
+#include "platform.hpp"
+
+namespace VulkanGameEngine
+{
+    namespace Utils
+    {
+        uint32_t find_memory_type(VkPhysicalDevice physical_device, uint32_t type_filter, VkMemoryPropertyFlags properties);
+
+        uint32_t find_memory_type(const VkPhysicalDeviceMemoryProperties& memory_properties, uint32_t type_filter, VkMemoryPropertyFlags properties);
+
+        VkFormat find_supported_format(
+            VkPhysicalDevice physical_device,
+            const std::vector<VkFormat>& candidates,
+            VkImageTiling tiling,
+            VkFormatFeatureFlags features);
+
+        VkFormat find_depth_format(VkPhysicalDevice physical_device);
+
+        bool has_stencil_component(VkFormat format);
+
+        void create_image(
+            VkDevice device,
+            VkPhysicalDevice physical_device,
+            VkExtent2D extent,
+            VkFormat format,
+            VkImageTiling tiling,
+            VkImageUsageFlags usage,
+            VkMemoryPropertyFlags properties,
+            VkImage& image,
+            VkDeviceMemory& image_memory);
+
+        VkImageView create_image_view(VkDevice device, VkImage image, VkFormat format, VkImageAspectFlags aspect_flags);
+
+    };
+};
@@ -0,0 +1,768 @@
+#include "image_file.hpp"
+
+#include <cstring>
+#include <cstdio>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+namespace VulkanGameEngine
+{
+    namespace Utils
+    {
+        namespace
+        {
+            const uint8_t png_signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+
+            /**
+             * Slicing-by-8 tables of the reflected CRC-32 (polynomial 0xedb88320).
+             */
+            struct Crc32Tables
+            {
+                uint32_t table[8][256];
+
+                Crc32Tables()
+                {
+                    for (uint32_t i = 0; i < 256; i++)
+                    {
+                        uint32_t crc = i;
+                        for (int bit = 0; bit < 8; bit++)
+                            crc = (crc >> 1) ^ (0xedb88320u & (0u - (crc & 1u)));
+                        table[0][i] = crc;
+                    }
+                    for (uint32_t i = 0; i < 256; i++)
+                        for (int slice = 1; slice < 8; slice++)
+                            table[slice][i] = (table[slice - 1][i] >> 8) ^ table[0][table[slice - 1][i] & 0xff];
+                }
+            };
+
+            const Crc32Tables& crc32_tables()
+            {
+                static const Crc32Tables tables;
+                return tables;
+            }
+
+            void put_u32(std::vector<uint8_t>& out, uint32_t value)
+            {
+                out.push_back(static_cast<uint8_t>(value >> 24));
+                out.push_back(static_cast<uint8_t>(value >> 16));
+                out.push_back(static_cast<uint8_t>(value >> 8));
+                out.push_back(static_cast<uint8_t>(value));
+            }
+
+            uint32_t get_u32(const uint8_t* data)
+            {
+                return (static_cast<uint32_t>(data[0]) << 24) | (static_cast<uint32_t>(data[1]) << 16) | (static_cast<uint32_t>(data[2]) << 8) | data[3];
+            }
+
+            /**
+             * Chunk length, type and data, then the CRC of type and data.
+             */
+            void put_chunk(std::vector<uint8_t>& out, const char* type, const uint8_t* data, size_t size)
+            {
+                put_u32(out, static_cast<uint32_t>(size));
+                size_t type_offset = out.size();
+                out.insert(out.end(), type, type + 4);
+                out.insert(out.end(), data, data + size);
+                put_u32(out, crc32(out.data() + type_offset, size + 4));
+            }
+
+            /**
+             * LSB first bit reader over a deflate stream. Reading past the end sets
+             * overflow and returns zeros, checked once per block.
+             */
+            struct BitReader
+            {
+                const uint8_t* data;
+                size_t size;
+                size_t position = 0;
+                uint32_t bit_buffer = 0;
+                uint32_t bit_count = 0;
+                bool overflow = false;
+
+                uint32_t bits(uint32_t count)
+                {
+                    while (bit_count < count)
+                    {
+                        if (position >= size)
+                        {
+                            overflow = true;
+                            return 0;
+                        }
+                        bit_buffer |= static_cast<uint32_t>(data[position++]) << bit_count;
+                        bit_count += 8;
+                    }
+                    uint32_t value = bit_buffer & ((1u << count) - 1);
+                    bit_buffer >>= count;
+                    bit_count -= count;
+                    return value;
+                }
+
+                // Fewer than 8 bits are ever buffered, so aligning drops them all.
+                void align()
+                {
+                    bit_buffer = 0;
+                    bit_count = 0;
+                }
+            };
+
+            /**
+             * Canonical Huffman code: the number of codes of each length and the
+             * symbols sorted by code. Decoded a bit at a time (as in zlib's puff):
+             * golden images are read once per comparison, this is not a hot path.
+             */
+            struct Huffman
+            {
+                uint16_t counts[16];
+                uint16_t symbols[288];
+            };
+
+            bool build_huffman(Huffman& huffman, const uint8_t* lengths, uint32_t count)
+            {
+                memset(huffman.counts, 0, sizeof(huffman.counts));
+                for (uint32_t i = 0; i < count; i++)
+                    huffman.counts[lengths[i]]++;
+                huffman.counts[0] = 0;
+
+                // Over-subscribed codes are corrupt; incomplete ones are allowed (single distance codes).
+                int32_t left = 1;
+                for (int length = 1; length < 16; length++)
+                {
+                    left <<= 1;
+                    left -= huffman.counts[length];
+                    if (left < 0)
+                        return false;
+                }
+
+                uint16_t offsets[16];
+                offsets[1] = 0;
+                for (int length = 1; length < 15; length++)
+                    offsets[length + 1] = offsets[length] + huffman.counts[length];
+
+                for (uint32_t symbol = 0; symbol < count; symbol++)
+                    if (lengths[symbol] != 0)
+                        huffman.symbols[offsets[lengths[symbol]]++] = static_cast<uint16_t>(symbol);
+
+                return true;
+            }
+
+            int32_t decode_symbol(BitReader& reader, const Huffman& huffman)
+            {
+                int32_t code = 0;
+                int32_t first = 0;
+                int32_t index = 0;
+                for (int length = 1; length < 16; length++)
+                {
+                    code |= static_cast<int32_t>(reader.bits(1));
+                    int32_t count = huffman.counts[length];
+                    if (code - count < first)
+                        return huffman.symbols[index + (code - first)];
+                    index += count;
+                    first = (first + count) << 1;
+                    code <<= 1;
+                }
+                return -1;
+            }
+
+            const uint16_t length_base[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+            const uint8_t length_extra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+            const uint16_t distance_base[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+            const uint8_t distance_extra[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+            bool inflate_codes(BitReader& reader, const Huffman& literals, const Huffman& distances, std::vector<uint8_t>& output)
+            {
+                for (;;)
+                {
+                    int32_t symbol = decode_symbol(reader, literals);
+                    if (symbol < 0 || reader.overflow)
+                        return false;
+
+                    if (symbol < 256)
+                        output.push_back(static_cast<uint8_t>(symbol));
+                    else if (symbol == 256)
+                        return true;
+                    else
+                    {
+                        symbol -= 257;
+                        if (symbol >= 29)
+                            return false;
+                        uint32_t length = length_base[symbol] + reader.bits(length_extra[symbol]);
+
+                        int32_t distance_symbol = decode_symbol(reader, distances);
+                        if (distance_symbol < 0 || distance_symbol >= 30)
+                            return false;
+                        size_t distance = distance_base[distance_symbol] + reader.bits(distance_extra[distance_symbol]);
+
+                        if (reader.overflow || distance > output.size())
+                            return false;
+
+                        // Byte by byte: the copy may overlap what it produces.
+                        size_t from = output.size() - distance;
+                        for (uint32_t i = 0; i < length; i++)
+                            output.push_back(output[from + i]);
+                    }
+                }
+            }
+
+            bool inflate_dynamic(BitReader& reader, std::vector<uint8_t>& output)
+            {
+                static const uint8_t order[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+                uint32_t literal_count = reader.bits(5) + 257;
+                uint32_t distance_count = reader.bits(5) + 1;
+                uint32_t code_length_count = reader.bits(4) + 4;
+                if (literal_count > 286 || distance_count > 30)
+                    return false;
+
+                uint8_t lengths[286 + 30];
+                memset(lengths, 0, sizeof(lengths));
+                for (uint32_t i = 0; i < code_length_count; i++)
+                    lengths[order[i]] = static_cast<uint8_t>(reader.bits(3));
+
+                Huffman code_lengths;
+                if (!build_huffman(code_lengths, lengths, 19))
+                    return false;
+
+                uint32_t total = literal_count + distance_count;
+                for (uint32_t index = 0; index < total; )
+                {
+                    int32_t symbol = decode_symbol(reader, code_lengths);
+                    if (symbol < 0 || reader.overflow)
+                        return false;
+
+                    if (symbol < 16)
+                    {
+                        lengths[index++] = static_cast<uint8_t>(symbol);
+                        continue;
+                    }
+
+                    uint8_t value = 0;
+                    uint32_t repeat;
+                    if (symbol == 16)
+                    {
+                        if (index == 0)
+                            return false;
+                        value = lengths[index - 1];
+                        repeat = 3 + reader.bits(2);
+                    }
+                    else if (symbol == 17)
+                        repeat = 3 + reader.bits(3);
+                    else
+                        repeat = 11 + reader.bits(7);
+
+                    if (index + repeat > total)
+                        return false;
+                    while (repeat--)
+                        lengths[index++] = value;
+                }
+
+                // Without an end of block code the block can never finish.
+                if (lengths[256] == 0)
+                    return false;
+
+                Huffman literals;
+                Huffman distances;
+                if (!build_huffman(literals, lengths, literal_count) || !build_huffman(distances, lengths + literal_count, distance_count))
+                    return false;
+
+                return inflate_codes(reader, literals, distances, output);
+            }
+
+            bool inflate_fixed(BitReader& reader, std::vector<uint8_t>& output)
+            {
+                static Huffman literals;
+                static Huffman distances;
+                static bool built = [] {
+                    uint8_t lengths[288];
+                    uint32_t symbol = 0;
+                    for (; symbol < 144; symbol++) lengths[symbol] = 8;
+                    for (; symbol < 256; symbol++) lengths[symbol] = 9;
+                    for (; symbol < 280; symbol++) lengths[symbol] = 7;
+                    for (; symbol < 288; symbol++) lengths[symbol] = 8;
+                    build_huffman(literals, lengths, 288);
+
+                    memset(lengths, 5, 30);
+                    build_huffman(distances, lengths, 30);
+                    return true;
+                }();
+                (void)built;
+
+                return inflate_codes(reader, literals, distances, output);
+            }
+
+            uint8_t paeth(int32_t a, int32_t b, int32_t c)
+            {
+                int32_t p = a + b - c;
+                int32_t pa = std::abs(p - a);
+                int32_t pb = std::abs(p - b);
+                int32_t pc = std::abs(p - c);
+                if (pa <= pb && pa <= pc)
+                    return static_cast<uint8_t>(a);
+                return static_cast<uint8_t>(pb <= pc ? b : c);
+            }
+
+            bool read_file(const std::string& path, std::vector<uint8_t>& data)
+            {
+                std::ifstream file(path, std::ios::binary | std::ios::ate);
+                if (!file.is_open())
+                    return false;
+
+                std::streamsize size = file.tellg();
+                if (size < 0)
+                    return false;
+                file.seekg(0);
+
+                data.resize(static_cast<size_t>(size));
+                return static_cast<bool>(file.read(reinterpret_cast<char*>(data.data()), size));
+            }
+        };
+
+        uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc)
+        {
+            const Crc32Tables& tables = crc32_tables();
+            crc = ~crc;
+
+            for (; size >= 8; size -= 8, data += 8)
+            {
+                crc ^= static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8) | (static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[3]) << 24);
+                crc = tables.table[7][crc & 0xff] ^ tables.table[6][(crc >> 8) & 0xff] ^ tables.table[5][(crc >> 16) & 0xff] ^ tables.table[4][crc >> 24]
+                    ^ tables.table[3][data[4]] ^ tables.table[2][data[5]] ^ tables.table[1][data[6]] ^ tables.table[0][data[7]];
+            }
+            for (; size > 0; size--, data++)
+                crc = (crc >> 8) ^ tables.table[0][(crc ^ *data) & 0xff];
+
+            return ~crc;
+        }
+
+        uint32_t adler32(const uint8_t* data, size_t size, uint32_t adler)
+        {
+            uint32_t a = adler & 0xffff;
+            uint32_t b = adler >> 16;
+
+            // 5552 is the most bytes before b can overflow 32 bits.
+            while (size > 0)
+            {
+                size_t block = std::min<size_t>(size, 5552);
+                size -= block;
+
+                // 32 bytes at a time: b gains 32 times a plus the bytes weighted by how
+                // many sums they are part of, which vectorizes unlike the serial form.
+                for (; block >= 32; block -= 32, data += 32)
+                {
+                    uint32_t sum = 0;
+                    uint32_t weighted = 0;
+                    for (uint32_t i = 0; i < 32; i++)
+                    {
+                        sum += data[i];
+                        weighted += (32 - i) * data[i];
+                    }
+                    b += a * 32 + weighted;
+                    a += sum;
+                }
+                for (; block > 0; block--)
+                {
+                    a += *data++;
+                    b += a;
+                }
+                a %= 65521;
+                b %= 65521;
+            }
+
+            return (b << 16) | a;
+        }
+
+        std::vector<uint8_t> encode_png(const ImageData& image, bool alpha)
+        {
+            uint32_t channels = alpha ? 4 : 3;
+            size_t row_size = 1 + static_cast<size_t>(image.width) * channels;
+            size_t raw_size = row_size * image.height;
+
+            const size_t max_block = 65535;
+            size_t block_count = std::max<size_t>(1, (raw_size + max_block - 1) / max_block);
+            size_t zlib_size = 2 + raw_size + block_count * 5 + 4;
+
+            std::vector<uint8_t> header;
+            put_u32(header, image.width);
+            put_u32(header, image.height);
+            header.push_back(8);
+            header.push_back(alpha ? 6 : 2);
+            header.push_back(0);
+            header.push_back(0);
+            header.push_back(0);
+
+            std::vector<uint8_t> png(png_signature, png_signature + 8);
+            png.reserve(8 + 25 + 12 + zlib_size + 12);
+            put_chunk(png, "IHDR", header.data(), header.size());
+
+            put_u32(png, static_cast<uint32_t>(zlib_size));
+            size_t idat_offset = png.size();
+            png.insert(png.end(), {'I', 'D', 'A', 'T', 0x78, 0x01});
+
+            // Scanlines with filter type 0 go straight into the zlib stream's stored
+            // blocks, a block header every 65535 bytes, whatever the rows.
+            size_t block_left = 0;
+            size_t raw_left = raw_size;
+            uint32_t adler = 1;
+            auto emit = [&](const uint8_t* data, size_t size) {
+                adler = adler32(data, size, adler);
+                while (size > 0)
+                {
+                    if (block_left == 0)
+                    {
+                        uint16_t length = static_cast<uint16_t>(std::min(max_block, raw_left));
+                        raw_left -= length;
+                        block_left = length;
+                        png.insert(png.end(), {
+                            static_cast<uint8_t>(raw_left == 0 ? 1 : 0),
+                            static_cast<uint8_t>(length), static_cast<uint8_t>(length >> 8),
+                            static_cast<uint8_t>(~length), static_cast<uint8_t>(~length >> 8)});
+                    }
+                    size_t count = std::min(size, block_left);
+                    png.insert(png.end(), data, data + count);
+                    data += count;
+                    size -= count;
+                    block_left -= count;
+                }
+            };
+
+            std::vector<uint8_t> row(row_size);
+            row[0] = 0;
+            for (uint32_t y = 0; y < image.height; y++)
+            {
+                const uint8_t* source = image.pixels.data() + static_cast<size_t>(y) * image.width * 4;
+                if (alpha)
+                    memcpy(row.data() + 1, source, static_cast<size_t>(image.width) * 4);
+                else
+                    for (uint32_t x = 0; x < image.width; x++)
+                    {
+                        row[1 + x * 3] = source[x * 4];
+                        row[2 + x * 3] = source[x * 4 + 1];
+                        row[3 + x * 3] = source[x * 4 + 2];
+                    }
+                emit(row.data(), row_size);
+            }
+
+            // An empty image still needs its final block.
+            if (raw_size == 0)
+                png.insert(png.end(), {1, 0, 0, 0xff, 0xff});
+
+            put_u32(png, adler);
+            put_u32(png, crc32(png.data() + idat_offset, png.size() - idat_offset));
+            put_chunk(png, "IEND", nullptr, 0);
+
+            return png;
+        }
+
+        bool write_png(const std::string& path, const ImageData& image, bool alpha)
+        {
+            std::vector<uint8_t> png = encode_png(image, alpha);
+
+            std::ofstream file(path, std::ios::binary | std::ios::trunc);
+            if (!file.is_open())
+                return false;
+
+            file.write(reinterpret_cast<const char*>(png.data()), png.size());
+            return static_cast<bool>(file);
+        }
+
+        bool zlib_inflate(const uint8_t* data, size_t size, std::vector<uint8_t>& output)
+        {
+            if (size < 2 || (data[0] & 0x0f) != 8 || ((data[0] << 8) | data[1]) % 31 != 0 || (data[1] & 0x20))
+                return false;
+
+            BitReader reader{data + 2, size - 2};
+
+            bool last = false;
+            while (!last)
+            {
+                last = reader.bits(1) != 0;
+                uint32_t type = reader.bits(2);
+
+                bool ok;
+                if (type == 0)
+                {
+                    reader.align();
+                    if (reader.position + 4 > reader.size)
+                        return false;
+
+                    const uint8_t* header = reader.data + reader.position;
+                    uint32_t length = header[0] | (header[1] << 8);
+                    uint32_t complement = header[2] | (header[3] << 8);
+                    reader.position += 4;
+
+                    if ((length ^ 0xffff) != complement || reader.position + length > reader.size)
+                        return false;
+
+                    output.insert(output.end(), reader.data + reader.position, reader.data + reader.position + length);
+                    reader.position += length;
+                    ok = true;
+                }
+                else if (type == 1)
+                    ok = inflate_fixed(reader, output);
+                else if (type == 2)
+                    ok = inflate_dynamic(reader, output);
+                else
+                    ok = false;
+
+                if (!ok || reader.overflow)
+                    return false;
+            }
+
+            // The Adler-32 trailer is optional for readers, but checked when present.
+            reader.align();
+            if (reader.position + 4 <= reader.size)
+                return get_u32(reader.data + reader.position) == adler32(output.data(), output.size());
+
+            return true;
+        }
+
+        bool decode_png(const uint8_t* data, size_t size, ImageData& image)
+        {
+            if (size < 8 || memcmp(data, png_signature, 8) != 0)
+                return false;
+
+            uint32_t width = 0;
+            uint32_t height = 0;
+            uint8_t color_type = 0;
+            std::vector<uint8_t> palette;
+            std::vector<uint8_t> palette_alpha;
+            std::vector<uint8_t> compressed;
+
+            bool header_seen = false;
+            size_t offset = 8;
+            for (;;)
+            {
+                if (offset + 12 > size)
+                    return false;
+
+                uint32_t length = get_u32(data + offset);
+                const uint8_t* type = data + offset + 4;
+                const uint8_t* chunk = data + offset + 8;
+                if (length > size - offset - 12)
+                    return false;
+                if (get_u32(chunk + length) != crc32(type, length + 4))
+                    return false;
+                offset += 12 + length;
+
+                if (!memcmp(type, "IHDR", 4))
+                {
+                    if (length != 13)
+                        return false;
+                    width = get_u32(chunk);
+                    height = get_u32(chunk + 4);
+                    color_type = chunk[9];
+
+                    // 8 bits per channel, no interlacing: what captures and most tools write.
+                    bool supported_type = color_type == 0 || color_type == 2 || color_type == 3 || color_type == 4 || color_type == 6;
+                    if (chunk[8] != 8 || !supported_type || chunk[12] != 0 || width == 0 || height == 0)
+                        return false;
+                    header_seen = true;
+                }
+                else if (!memcmp(type, "PLTE", 4))
+                    palette.assign(chunk, chunk + length);
+                else if (!memcmp(type, "tRNS", 4))
+                    palette_alpha.assign(chunk, chunk + length);
+                else if (!memcmp(type, "IDAT", 4))
+                    compressed.insert(compressed.end(), chunk, chunk + length);
+                else if (!memcmp(type, "IEND", 4))
+                    break;
+            }
+
+            if (!header_seen || (color_type == 3 && palette.empty()))
+                return false;
+
+            static const uint32_t channel_counts[7] = {1, 0, 3, 1, 2, 0, 4};
+            uint32_t channels = channel_counts[color_type];
+            size_t stride = static_cast<size_t>(width) * channels;
+
+            std::vector<uint8_t> raw;
+            raw.reserve((stride + 1) * height);
+            if (!zlib_inflate(compressed.data(), compressed.size(), raw) || raw.size() < (stride + 1) * height)
+                return false;
+
+            // Undo the per-row filters; each row is preceded by its filter type. The
+            // row above the first one is zeros, and so are the bytes left of each row.
+            std::vector<uint8_t> pixels(stride * height);
+            std::vector<uint8_t> zeros(stride, 0);
+            for (uint32_t y = 0; y < height; y++)
+            {
+                uint8_t filter = raw[y * (stride + 1)];
+                const uint8_t* source = raw.data() + y * (stride + 1) + 1;
+                uint8_t* row = pixels.data() + y * stride;
+                const uint8_t* up = y > 0 ? row - stride : zeros.data();
+                size_t first = std::min<size_t>(channels, stride);
+
+                switch (filter)
+                {
+                    case 0:
+                        memcpy(row, source, stride);
+                        break;
+                    case 1:
+                        memcpy(row, source, first);
+                        for (size_t i = first; i < stride; i++)
+                            row[i] = static_cast<uint8_t>(source[i] + row[i - channels]);
+                        break;
+                    case 2:
+                        for (size_t i = 0; i < stride; i++)
+                            row[i] = static_cast<uint8_t>(source[i] + up[i]);
+                        break;
+                    case 3:
+                        for (size_t i = 0; i < first; i++)
+                            row[i] = static_cast<uint8_t>(source[i] + (up[i] >> 1));
+                        for (size_t i = first; i < stride; i++)
+                            row[i] = static_cast<uint8_t>(source[i] + ((row[i - channels] + up[i]) >> 1));
+                        break;
+                    case 4:
+                        for (size_t i = 0; i < first; i++)
+                            row[i] = static_cast<uint8_t>(source[i] + up[i]);
+                        for (size_t i = first; i < stride; i++)
+                            row[i] = static_cast<uint8_t>(source[i] + paeth(row[i - channels], up[i], up[i - channels]));
+                        break;
+                    default:
+                        return false;
+                }
+            }
+
+            image.resize(width, height);
+            uint8_t* out = image.pixels.data();
+            for (size_t i = 0; i < static_cast<size_t>(width) * height; i++, out += 4)
+            {
+                const uint8_t* pixel = pixels.data() + i * channels;
+                switch (color_type)
+                {
+                    case 0:
+                        out[0] = out[1] = out[2] = pixel[0];
+                        out[3] = 255;
+                        break;
+                    case 2:
+                        out[0] = pixel[0]; out[1] = pixel[1]; out[2] = pixel[2];
+                        out[3] = 255;
+                        break;
+                    case 3:
+                        if (static_cast<size_t>(pixel[0]) * 3 + 3 > palette.size())
+                            return false;
+                        out[0] = palette[pixel[0] * 3];
+                        out[1] = palette[pixel[0] * 3 + 1];
+                        out[2] = palette[pixel[0] * 3 + 2];
+                        out[3] = pixel[0] < palette_alpha.size() ? palette_alpha[pixel[0]] : 255;
+                        break;
+                    case 4:
+                        out[0] = out[1] = out[2] = pixel[0];
+                        out[3] = pixel[1];
+                        break;
+                    default:
+                        memcpy(out, pixel, 4);
+                        break;
+                }
+            }
+
+            return true;
+        }
+
+        bool read_png(const std::string& path, ImageData& image)
+        {
+            std::vector<uint8_t> data;
+            return read_file(path, data) && decode_png(data.data(), data.size(), image);
+        }
+
+        ImageComparison compare_images(const ImageData& expected, const ImageData& actual, uint32_t tolerance)
+        {
+            ImageComparison comparison;
+            comparison.pixels = static_cast<uint64_t>(expected.width) * expected.height;
+
+            if (expected.width != actual.width || expected.height != actual.height)
+            {
+                comparison.size_mismatch = true;
+                comparison.mismatched_pixels = comparison.pixels;
+                comparison.max_difference = 255;
+                return comparison;
+            }
+
+            uint64_t squared_error = 0;
+            for (uint64_t i = 0; i < comparison.pixels; i++)
+            {
+                const uint8_t* a = expected.pixels.data() + i * 4;
+                const uint8_t* b = actual.pixels.data() + i * 4;
+
+                uint32_t difference = 0;
+                for (int channel = 0; channel < 3; channel++)
+                {
+                    int32_t delta = static_cast<int32_t>(a[channel]) - b[channel];
+                    squared_error += static_cast<uint64_t>(delta * delta);
+                    difference = std::max(difference, static_cast<uint32_t>(std::abs(delta)));
+                }
+
+                comparison.max_difference = std::max(comparison.max_difference, difference);
+                if (difference > tolerance)
+                    comparison.mismatched_pixels++;
+            }
+
+            if (squared_error == 0)
+                comparison.psnr = std::numeric_limits<double>::infinity();
+            else
+            {
+                double mean_squared_error = static_cast<double>(squared_error) / (comparison.pixels * 3);
+                comparison.psnr = 10.0 * std::log10(255.0 * 255.0 / mean_squared_error);
+            }
+
+            return comparison;
+        }
+
+        bool Y4mWriter::open(const std::string& path, uint32_t width, uint32_t height, uint32_t fps_numerator, uint32_t fps_denominator)
+        {
+            this->close();
+
+            file.open(path, std::ios::binary | std::ios::trunc);
+            if (!file.is_open())
+                return false;
+
+            this->width = width;
+            this->height = height;
+            frames = 0;
+            planes.resize(static_cast<size_t>(width) * height * 3);
+
+            char header[128];
+            snprintf(header, sizeof(header), "YUV4MPEG2 W%u H%u F%u:%u Ip A1:1 C444 XCOLORRANGE=FULL\n",
+                width, height, fps_numerator, std::max(1u, fps_denominator));
+            file << header;
+
+            return static_cast<bool>(file);
+        }
+
+        bool Y4mWriter::write_frame(const ImageData& image)
+        {
+            if (!file.is_open() || image.width != width || image.height != height)
+                return false;
+
+            size_t pixel_count = static_cast<size_t>(width) * height;
+            uint8_t* y_plane = planes.data();
+            uint8_t* cb_plane = y_plane + pixel_count;
+            uint8_t* cr_plane = cb_plane + pixel_count;
+
+            // BT.601 full range in 8.8 fixed point; the chroma offsets are folded
+            // in before the shift so every intermediate stays positive.
+            const uint8_t* pixel = image.pixels.data();
+            for (size_t i = 0; i < pixel_count; i++, pixel += 4)
+            {
+                int32_t r = pixel[0];
+                int32_t g = pixel[1];
+                int32_t b = pixel[2];
+                y_plane[i] = static_cast<uint8_t>((77 * r + 150 * g + 29 * b + 128) >> 8);
+                cb_plane[i] = static_cast<uint8_t>(std::min(255, (-43 * r - 85 * g + 128 * b + 32896) >> 8));
+                cr_plane[i] = static_cast<uint8_t>(std::min(255, (128 * r - 107 * g - 21 * b + 32896) >> 8));
+            }
+
+            file << "FRAME\n";
+            file.write(reinterpret_cast<const char*>(planes.data()), planes.size());
+            frames++;
+
+            return static_cast<bool>(file);
+        }
+
+        void Y4mWriter::close()
+        {
+            if (file.is_open())
+                file.close();
+        }
+    };
+};
@@ -0,0 +1,108 @@
+#pragma once
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-15
+ *
+ */
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace VulkanGameEngine
+{
+    namespace Utils
+    {
+        /**
+         * Tightly packed 8-bit RGBA pixels, top row first.
+         */
+        struct ImageData
+        {
+            uint32_t width = 0;
+            uint32_t height = 0;
+            std::vector<uint8_t> pixels;
+
+            void resize(uint32_t width, uint32_t height)
+            {
+                this->width = width;
+                this->height = height;
+                pixels.resize(static_cast<size_t>(width) * height * 4);
+            }
+        };
+
+        /**
+         * PNG of the image, as RGB or RGBA. The zlib stream is made of stored
+         * blocks: captures are written at frame rate, so the encoder spends its
+         * time on checksums only and leaves compression to offline tools.
+         */
+        std::vector<uint8_t> encode_png(const ImageData& image, bool alpha = false);
+
+        bool write_png(const std::string& path, const ImageData& image, bool alpha = false);
+
+        /**
+         * Non interlaced 8-bit PNGs of any color type, from any encoder (full
+         * inflate), expanded to RGBA. Returns false for anything else or corrupt data.
+         */
+        bool decode_png(const uint8_t* data, size_t size, ImageData& image);
+
+        bool read_png(const std::string& path, ImageData& image);
+
+        /**
+         * Raw zlib inflate (RFC 1950/1951). Returns false on corrupt or truncated data.
+         */
+        bool zlib_inflate(const uint8_t* data, size_t size, std::vector<uint8_t>& output);
+
+        uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc = 0);
+
+        uint32_t adler32(const uint8_t* data, size_t size, uint32_t adler = 1);
+
+        struct ImageComparison
+        {
+            uint64_t pixels = 0;
+            // Pixels with a color channel further than the tolerance from the expected one.
+            uint64_t mismatched_pixels = 0;
+            uint32_t max_difference = 0;
+            // Over the color channels; infinite for identical images.
+            double psnr = 0.0;
+            bool size_mismatch = false;
+
+            double mismatch_fraction() const { return pixels ? static_cast<double>(mismatched_pixels) / pixels : 0.0; }
+        };
+
+        /**
+         * Compares the color channels; alpha is ignored, swapchain alpha means nothing.
+         */
+        ImageComparison compare_images(const ImageData& expected, const ImageData& actual, uint32_t tolerance);
+
+        /**
+         * Raw YUV4MPEG2 video, 4:4:4 BT.601 full range, one frame per write_frame().
+         * Every frame must have the size the stream was opened with.
+         */
+        class Y4mWriter
+        {
+            private:
+                std::ofstream file;
+                uint32_t width = 0;
+                uint32_t height = 0;
+                uint64_t frames = 0;
+                std::vector<uint8_t> planes;
+
+            public:
+                bool open(const std::string& path, uint32_t width, uint32_t height, uint32_t fps_numerator, uint32_t fps_denominator = 1);
+
+                bool write_frame(const ImageData& image);
+
+                void close();
+
+                bool is_open() const { return file.is_open(); }
+
+                uint32_t get_width() const { return width; }
+
+                uint32_t get_height() const { return height; }
+
+                uint64_t get_frame_count() const { return frames; }
+        };
+    };
+};
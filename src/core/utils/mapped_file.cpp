@@ -0,0 +1,113 @@
+#include "mapped_file.hpp"
+
+#include <algorithm>
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <windows.h>
+#else
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+namespace VulkanGameEngine
+{
+    namespace Utils
+    {
+        void MappedFile::open(const std::string& path)
+        {
+            close();
+
+            #ifdef _WIN32
+                HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+                if (file == INVALID_HANDLE_VALUE)
+                    throw std::runtime_error("\nFailed to open " + path + ".");
+
+                LARGE_INTEGER file_size;
+                if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0)
+                {
+                    CloseHandle(file);
+                    throw std::runtime_error("\nFailed to map " + path + ": empty or unreadable.");
+                }
+
+                HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+                void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+                if (view == nullptr)
+                {
+                    if (mapping)
+                        CloseHandle(mapping);
+                    CloseHandle(file);
+                    throw std::runtime_error("\nFailed to map " + path + ".");
+                }
+
+                file_handle = file;
+                mapping_handle = mapping;
+                data = static_cast<const uint8_t*>(view);
+                size = static_cast<size_t>(file_size.QuadPart);
+            #else
+                int descriptor = ::open(path.c_str(), O_RDONLY);
+                if (descriptor < 0)
+                    throw std::runtime_error("\nFailed to open " + path + ".");
+
+                struct stat file_status;
+                if (fstat(descriptor, &file_status) != 0 || file_status.st_size == 0)
+                {
+                    ::close(descriptor);
+                    throw std::runtime_error("\nFailed to map " + path + ": empty or unreadable.");
+                }
+
+                void* view = mmap(nullptr, static_cast<size_t>(file_status.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+                if (view == MAP_FAILED)
+                {
+                    ::close(descriptor);
+                    throw std::runtime_error("\nFailed to map " + path + ".");
+                }
+
+                file_descriptor = descriptor;
+                data = static_cast<const uint8_t*>(view);
+                size = static_cast<size_t>(file_status.st_size);
+            #endif
+        }
+
+        void MappedFile::close()
+        {
+            if (data == nullptr)
+                return;
+
+            #ifdef _WIN32
+                UnmapViewOfFile(data);
+                CloseHandle(mapping_handle);
+                CloseHandle(file_handle);
+                mapping_handle = nullptr;
+                file_handle = nullptr;
+            #else
+                munmap(const_cast<uint8_t*>(data), size);
+                ::close(file_descriptor);
+                file_descriptor = -1;
+            #endif
+
+            data = nullptr;
+            size = 0;
+        }
+
+        void MappedFile::prefetch(size_t offset, size_t length) const
+        {
+            if (data == nullptr || offset >= size)
+                return;
+            length = std::min(length, size - offset);
+
+            #ifdef _WIN32
+                WIN32_MEMORY_RANGE_ENTRY range{const_cast<uint8_t*>(data) + offset, length};
+                PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+            #else
+                // madvise wants a page aligned start.
+                size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+                size_t start = offset / page * page;
+                madvise(const_cast<uint8_t*>(data) + start, length + (offset - start), MADV_WILLNEED);
+            #endif
+        }
+    };
+};
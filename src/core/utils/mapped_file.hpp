@@ -0,0 +1,62 @@
+#pragma once
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-07
+ *
+ */
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <stdexcept>
+
+namespace VulkanGameEngine
+{
+    namespace Utils
+    {
+        /**
+         * Read-only memory mapping of a whole file.
+         * Pages are loaded by the OS on first touch and shared with the file cache,
+         * so reading from the mapping never copies through a user buffer.
+         */
+        class MappedFile
+        {
+            private:
+                const uint8_t* data = nullptr;
+                size_t size = 0;
+
+                #ifdef _WIN32
+                    void* file_handle = nullptr;
+                    void* mapping_handle = nullptr;
+                #else
+                    int file_descriptor = -1;
+                #endif
+
+            public:
+                MappedFile() = default;
+
+                ~MappedFile() { close(); }
+
+                MappedFile(const MappedFile&) = delete;
+                MappedFile& operator=(const MappedFile&) = delete;
+
+                /**
+                 * Throws if the file cannot be opened or mapped.
+                 */
+                void open(const std::string& path);
+
+                void close();
+
+                bool is_open() const { return data != nullptr; }
+
+                const uint8_t* get_data() const { return data; }
+
+                size_t get_size() const { return size; }
+
+                /**
+                 * Hint that [offset, offset + length) will be read soon.
+                 */
+                void prefetch(size_t offset, size_t length) const;
+        };
+    };
+};
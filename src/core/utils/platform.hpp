@@ -0,0 +1,25 @@
+#pragma once
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-09-21
+ *
+ * Platform specific Vulkan/GLFW includes.
+ * When built with VGE_HEADLESS_ONLY the engine does not depend on GLFW at all
+ * and only the headless (offscreen) backend is available.
+ */
+
+#ifdef VGE_HEADLESS_ONLY
+    #include <vulkan/vulkan.h>
+
+    struct GLFWwindow;
+#else
+    #ifdef _WIN32
+        #define VK_USE_PLATFORM_WIN32_KHR
+    #endif
+    #define GLFW_INCLUDE_VULKAN
+    #include <GLFW/glfw3.h>
+    #ifdef _WIN32
+        #define GLFW_EXPOSE_NATIVE_WIN32
+        #include <GLFW/glfw3native.h>
+    #endif
+#endif
@@ -1,80 +1,165 @@
-#include "queuefamily.hpp"
-#include "swapchain.hpp"
-
-namespace VulkanGameEngine
-{
-    namespace Utils
-    {
-
-        bool QueueFamilyIndices::is_complete()
-        {
-            return graphics_family.has_value() && present_family.has_value();
-        }
-
-        QueueFamilyIndices find_queue_families(VkPhysicalDevice device, VkSurfaceKHR& surface)
-        {
-            QueueFamilyIndices indices;
-
-            uint32_t queue_family_count = 0;
-            vkGetPhysicalDeviceQueueFamilyProperties(device, &queue_family_count, nullptr);
-
-            std::vector<VkQueueFamilyProperties> queue_families(queue_family_count);
-            vkGetPhysicalDeviceQueueFamilyProperties(device, &queue_family_count, queue_families.data());
-
-            int i = 0;
-            for (const auto& queue_family : queue_families)
-            {
-                VkBool32 present_support = false;
-                vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &present_support);
-
-                if (present_support)
-                    indices.present_family = i;
-
-                if (queue_family.queueFlags & VK_QUEUE_GRAPHICS_BIT)
-                    indices.graphics_family = i;
-
-                if (indices.is_complete())
-                    break;
-
-                i++;
-            }
-
-            return indices;
-        }
-        
-        bool check_device_extension_support(VkPhysicalDevice device)
-        {
-            uint32_t extension_count;
-            vkEnumerateDeviceExtensionProperties(device, nullptr, &extension_count, nullptr);
-
-            std::vector<VkExtensionProperties> available_extensions(extension_count);
-            vkEnumerateDeviceExtensionProperties(device, nullptr, &extension_count, available_extensions.data());
-
-            std::set<std::string> required_extensions(device_extensions.begin(), device_extensions.end());
-
-            for (const auto& extension : available_extensions)
-            {
-                required_extensions.erase(extension.extensionName);
-            }
-
-            return required_extensions.empty();
-        }
-
-        bool is_device_suitable(VkPhysicalDevice device, VkSurfaceKHR& surface)
-        {
-            QueueFamilyIndices indices = find_queue_families(device, surface);
-            
-            bool extensions_supported = check_device_extension_support(device);
-            bool swap_chain_adequate = false;
-
-            if (extensions_supported)
-            {
-                SwapChainSupportDetails swap_chain_support = query_swap_chain_support(device, surface);
-                swap_chain_adequate = !swap_chain_support.formats.empty() && !swap_chain_support.present_modes.empty();
-            }
-
-            return indices.is_complete() && extensions_supported && swap_chain_adequate;
-        }
-
-    };
+#include "queuefamily.hpp"
+#include "swapchain.hpp"
+
+namespace VulkanGameEngine
+{
+    namespace Utils
+    {
+
+        bool QueueFamilyIndices::is_complete()
+        {
+            return graphics_family.has_value() && present_family.has_value();
+        }
+
+        QueueFamilyIndices find_queue_families(VkPhysicalDevice device, VkSurfaceKHR& surface)
+        {
+            return find_queue_families(query_device_capabilities(device, surface));
+        }
+
+        QueueFamilyIndices find_queue_families(const DeviceCapabilities& capabilities)
+        {
+            QueueFamilyIndices indices;
+
+            const auto& queue_families = capabilities.queue_families;
+            uint32_t queue_family_count = static_cast<uint32_t>(queue_families.size());
+
+            for (uint32_t i = 0; i < queue_family_count; i++)
+            {
+                bool graphics_support = queue_families[i].queueFlags & VK_QUEUE_GRAPHICS_BIT;
+
+                // Headless devices have no surface to present to.
+                bool present_support = capabilities.supports_present(i);
+
+                // A family that can both draw and present avoids an ownership transfer every frame.
+                if (graphics_support && present_support)
+                {
+                    indices.graphics_family = i;
+                    indices.present_family = i;
+                    break;
+                }
+
+                if (graphics_support && !indices.graphics_family.has_value())
+                    indices.graphics_family = i;
+
+                if (present_support && !indices.present_family.has_value())
+                    indices.present_family = i;
+            }
+
+            return indices;
+        }
+
+        std::vector<uint32_t> QueueTopology::unique_families() const
+        {
+            std::set<uint32_t> families;
+            for (const auto& family : {graphics_family, present_family, compute_family, transfer_family})
+                if (family.has_value())
+                    families.insert(family.value());
+
+            return std::vector<uint32_t>(families.begin(), families.end());
+        }
+
+        QueueTopology find_queue_topology(VkPhysicalDevice device, VkSurfaceKHR& surface)
+        {
+            return find_queue_topology(query_device_capabilities(device, surface));
+        }
+
+        QueueTopology find_queue_topology(const DeviceCapabilities& capabilities)
+        {
+            QueueTopology topology;
+
+            QueueFamilyIndices indices = find_queue_families(capabilities);
+            topology.graphics_family = indices.graphics_family;
+            topology.present_family = indices.present_family;
+
+            if (!topology.graphics_family.has_value())
+                return topology;
+
+            const auto& queue_families = capabilities.queue_families;
+            uint32_t queue_family_count = static_cast<uint32_t>(queue_families.size());
+
+            // Async compute: a compute family without graphics runs concurrently with the graphics queue.
+            for (uint32_t i = 0; i < queue_family_count; i++)
+            {
+                VkQueueFlags flags = queue_families[i].queueFlags;
+                if ((flags & VK_QUEUE_COMPUTE_BIT) && !(flags & VK_QUEUE_GRAPHICS_BIT))
+                {
+                    topology.compute_family = i;
+                    break;
+                }
+            }
+
+            // Transfer: prefer a copy-engine family (transfer only), then any other non graphics family.
+            for (uint32_t i = 0; i < queue_family_count; i++)
+            {
+                VkQueueFlags flags = queue_families[i].queueFlags;
+                if ((flags & VK_QUEUE_TRANSFER_BIT) && !(flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)))
+                {
+                    topology.transfer_family = i;
+                    break;
+                }
+            }
+
+            if (!topology.transfer_family.has_value())
+                for (uint32_t i = 0; i < queue_family_count; i++)
+                {
+                    VkQueueFlags flags = queue_families[i].queueFlags;
+                    bool transfer_capable = flags & (VK_QUEUE_TRANSFER_BIT | VK_QUEUE_COMPUTE_BIT);
+                    if (transfer_capable && !(flags & VK_QUEUE_GRAPHICS_BIT) && topology.compute_family != i)
+                    {
+                        topology.transfer_family = i;
+                        break;
+                    }
+                }
+
+            if (!topology.compute_family.has_value())
+            {
+                topology.compute_family = topology.graphics_family;
+                if (queue_families[topology.graphics_family.value()].queueCount > 1)
+                    topology.compute_queue_index = 1;
+            }
+            if (!topology.transfer_family.has_value())
+                topology.transfer_family = topology.graphics_family;
+
+            return topology;
+        }
+        
+        bool check_device_extension_support(VkPhysicalDevice device)
+        {
+            return check_device_extension_support(device, device_extensions);
+        }
+
+        bool check_device_extension_support(VkPhysicalDevice device, const std::vector<const char*>& extensions)
+        {
+            uint32_t extension_count;
+            vkEnumerateDeviceExtensionProperties(device, nullptr, &extension_count, nullptr);
+
+            std::vector<VkExtensionProperties> available_extensions(extension_count);
+            vkEnumerateDeviceExtensionProperties(device, nullptr, &extension_count, available_extensions.data());
+
+            std::set<std::string> required_extensions(extensions.begin(), extensions.end());
+
+            for (const auto& extension : available_extensions)
+            {
+                required_extensions.erase(extension.extensionName);
+            }
+
+            return required_extensions.empty();
+        }
+
+        bool is_device_suitable(VkPhysicalDevice device, VkSurfaceKHR& surface)
+        {
+            return is_device_suitable(query_device_capabilities(device, surface));
+        }
+
+        bool is_device_suitable(const DeviceCapabilities& capabilities)
+        {
+            QueueFamilyIndices indices = find_queue_families(capabilities);
+
+            bool extensions_supported = capabilities.supports_extensions(device_extensions);
+            bool swap_chain_adequate = !capabilities.surface_formats.empty() && !capabilities.present_modes.empty();
+
+            return indices.is_complete() && extensions_supported && swap_chain_adequate;
+        }
+
+    };
 }
\ No newline at end of file
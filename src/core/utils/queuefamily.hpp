@@ -1,43 +1,79 @@
-#pragma once
-/**
- * @author Simon Brisebois-Therrien
- * @since 2021-09-20 
- * 
- * 
- */
-#include <iostream>
-#include <optional>
-#include <vector>
-#include <set>
-
-#define VK_USE_PLATFORM_WIN32_KHR
-#define GLFW_INCLUDE_VULKAN
-#include <GLFW/glfw3.h>
-#define GLFW_EXPOSE_NATIVE_WIN32
-#include <GLFW/glfw3native.h>
-
-
-namespace VulkanGameEngine
-{
-    namespace Utils
-    {
-        const inline std::vector<const char*> device_extensions = {
-            VK_KHR_SWAPCHAIN_EXTENSION_NAME  
-        };
-
-        struct QueueFamilyIndices
-        {
-            std::optional<uint32_t> graphics_family;
-            std::optional<uint32_t> present_family;
-
-            bool is_complete();
-        };
-
-        QueueFamilyIndices find_queue_families(VkPhysicalDevice device, VkSurfaceKHR& surface);
-
-        bool check_device_extension_support(VkPhysicalDevice device);
-
-        bool is_device_suitable(VkPhysicalDevice device, VkSurfaceKHR& surface);
-
-    };
+#pragma once
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-09-20 
+ * 
+ * 
+ */
+#include <iostream>
+#include <optional>
+#include <vector>
+#include <set>
+#include <string>
+
+#include "platform.hpp"
+#include "device_capabilities.hpp"
+
+
+namespace VulkanGameEngine
+{
+    namespace Utils
+    {
+        const inline std::vector<const char*> device_extensions = {
+            VK_KHR_SWAPCHAIN_EXTENSION_NAME  
+        };
+
+        struct QueueFamilyIndices
+        {
+            std::optional<uint32_t> graphics_family;
+            std::optional<uint32_t> present_family;
+
+            bool is_complete();
+        };
+
+        /**
+         * Queue families the engine submits to.
+         * compute_family and transfer_family fall back to the graphics family
+         * when the device has no dedicated family for them.
+         */
+        struct QueueTopology
+        {
+            std::optional<uint32_t> graphics_family;
+            std::optional<uint32_t> present_family;
+            std::optional<uint32_t> compute_family;
+            std::optional<uint32_t> transfer_family;
+
+            // Queue of compute_family to submit compute work to: 1 when it is the graphics
+            // family and that family has a second queue, so compute still overlaps graphics.
+            uint32_t compute_queue_index = 0;
+
+            bool has_async_compute() const { return compute_family.has_value() && compute_family != graphics_family; }
+
+            bool has_separate_compute_queue() const { return has_async_compute() || compute_queue_index > 0; }
+
+            bool has_dedicated_transfer() const
+            {
+                return transfer_family.has_value() && transfer_family != graphics_family && transfer_family != compute_family;
+            }
+
+            std::vector<uint32_t> unique_families() const;
+        };
+
+        QueueFamilyIndices find_queue_families(VkPhysicalDevice device, VkSurfaceKHR& surface);
+
+        QueueFamilyIndices find_queue_families(const DeviceCapabilities& capabilities);
+
+        QueueTopology find_queue_topology(VkPhysicalDevice device, VkSurfaceKHR& surface);
+
+        QueueTopology find_queue_topology(const DeviceCapabilities& capabilities);
+
+        bool check_device_extension_support(VkPhysicalDevice device);
+
+        bool check_device_extension_support(VkPhysicalDevice device, const std::vector<const char*>& extensions);
+
+        bool is_device_suitable(VkPhysicalDevice device, VkSurfaceKHR& surface);
+
+        bool is_device_suitable(const DeviceCapabilities& capabilities);
+
+    };
 };
\ No newline at end of file
@@ -0,0 +1,94 @@
+#include "startup_report.hpp"
+
+#include <cstdio>
+#include <fstream>
+
+namespace VulkanGameEngine
+{
+    namespace Utils
+    {
+        static std::string escape_json(const std::string& value)
+        {
+            std::string escaped;
+            for (char c : value)
+            {
+                switch (c)
+                {
+                    case '"':  escaped += "\\\""; break;
+                    case '\\': escaped += "\\\\"; break;
+                    case '\n': escaped += "\\n"; break;
+                    case '\t': escaped += "\\t"; break;
+                    default:
+                        if (static_cast<unsigned char>(c) < 0x20)
+                        {
+                            char code[8];
+                            snprintf(code, sizeof(code), "\\u%04x", c);
+                            escaped += code;
+                        }
+                        else
+                            escaped += c;
+                }
+            }
+            return escaped;
+        }
+
+        void StartupReport::set_attribute(const std::string& key, const std::string& value)
+        {
+            for (auto& attribute : attributes)
+                if (attribute.first == key)
+                {
+                    attribute.second = value;
+                    return;
+                }
+            attributes.push_back({key, value});
+        }
+
+        double StartupReport::total_ms() const
+        {
+            return std::chrono::duration<double, std::milli>(end - start).count();
+        }
+
+        void StartupReport::print(std::ostream& out) const
+        {
+            char line[256];
+            snprintf(line, sizeof(line), "\nStartup: %.3f ms\n", total_ms());
+            out << line;
+
+            for (const auto& phase : phases)
+            {
+                snprintf(line, sizeof(line), "  %-28s %9.3f ms\n", phase.name.c_str(), phase.duration_ms);
+                out << line;
+            }
+        }
+
+        void StartupReport::write_json(std::ostream& out) const
+        {
+            char number[64];
+
+            out << "{\n";
+            for (const auto& attribute : attributes)
+                out << "  \"" << escape_json(attribute.first) << "\": \"" << escape_json(attribute.second) << "\",\n";
+
+            snprintf(number, sizeof(number), "%.3f", total_ms());
+            out << "  \"total_ms\": " << number << ",\n";
+
+            out << "  \"phases\": [";
+            for (size_t i = 0; i < phases.size(); i++)
+            {
+                snprintf(number, sizeof(number), "%.3f", phases[i].duration_ms);
+                out << (i ? ",\n" : "\n") << "    {\"name\": \"" << escape_json(phases[i].name) << "\", \"ms\": " << number << "}";
+            }
+            out << "\n  ]\n}\n";
+        }
+
+        bool StartupReport::write_json(const std::string& path) const
+        {
+            std::ofstream file(path, std::ios::trunc);
+            if (!file.is_open())
+                return false;
+
+            write_json(file);
+            return static_cast<bool>(file);
+        }
+    };
+};
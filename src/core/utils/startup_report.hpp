@@ -0,0 +1,72 @@
+#pragma once
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-09-28
+ *
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <utility>
+#include <chrono>
+
+namespace VulkanGameEngine
+{
+    namespace Utils
+    {
+        /**
+         * Wall clock time of each startup phase.
+         * Written as JSON so deployments can track cold start times over releases.
+         */
+        class StartupReport
+        {
+            public:
+                struct Phase
+                {
+                    std::string name;
+                    double duration_ms;
+                };
+
+            private:
+                std::chrono::steady_clock::time_point start;
+                // When the last phase finished.
+                std::chrono::steady_clock::time_point end;
+                std::vector<Phase> phases;
+                std::vector<std::pair<std::string, std::string>> attributes;
+
+            public:
+                /**
+                 * Start of the startup sequence; total_ms() is measured from here.
+                 */
+                void begin() { start = end = std::chrono::steady_clock::now(); }
+
+                template <typename Function>
+                void measure(const char* name, Function&& function)
+                {
+                    auto phase_start = std::chrono::steady_clock::now();
+                    function();
+                    end = std::chrono::steady_clock::now();
+                    phases.push_back({name, std::chrono::duration<double, std::milli>(end - phase_start).count()});
+                }
+
+                void set_attribute(const std::string& key, const std::string& value);
+
+                const std::vector<Phase>& get_phases() const { return phases; }
+
+                /**
+                 * From begin() to the end of the last phase, however late it is asked.
+                 */
+                double total_ms() const;
+
+                void print(std::ostream& out) const;
+
+                void write_json(std::ostream& out) const;
+
+                /**
+                 * Returns false if the file could not be written.
+                 */
+                bool write_json(const std::string& path) const;
+        };
+    };
+};
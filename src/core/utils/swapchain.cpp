@@ -1,74 +1,139 @@
-#include "swapchain.hpp"
-
-namespace VulkanGameEngine
-{
-    namespace Utils
-    {
-        SwapChainSupportDetails query_swap_chain_support(VkPhysicalDevice device, VkSurfaceKHR& surface)
-        {
-            SwapChainSupportDetails details;
-
-            vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device, surface, &details.capabilities);
-
-            uint32_t format_count;
-            vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &format_count, nullptr);
-
-            if (format_count != 0)
-            {
-                details.formats.resize(format_count);
-                vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &format_count, details.formats.data());
-            }
-
-            uint32_t present_mode_count;
-            vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &present_mode_count, nullptr);
-
-            if (present_mode_count != 0)
-            {
-                details.present_modes.resize(present_mode_count);
-                vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &present_mode_count, details.present_modes.data());
-            }
-
-            return details;
-        }
-
-        VkSurfaceFormatKHR choose_swap_surface_format(const std::vector<VkSurfaceFormatKHR>& available_formats)
-        {
-            for (const VkSurfaceFormatKHR& available_format : available_formats)
-                if (available_format.format == VK_FORMAT_B8G8R8A8_SRGB 
-                    && available_format.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR)
-                    return available_format;
-
-            return available_formats[0];
-        }
-
-        VkPresentModeKHR choose_swap_present_mode(const std::vector<VkPresentModeKHR>& available_present_modes)
-        {
-            for (const VkPresentModeKHR& available_present_mode : available_present_modes)
-                if (available_present_mode == VK_PRESENT_MODE_MAILBOX_KHR)
-                    return available_present_mode;
-
-            return VK_PRESENT_MODE_FIFO_KHR;
-        }
-
-        VkExtent2D choose_swap_extent(const VkSurfaceCapabilitiesKHR& capabilities, GLFWwindow* window)
-        {
-            if (capabilities.currentExtent.width != UINT32_MAX)
-                return capabilities.currentExtent;
-            else
-            {
-                int width, height;
-                glfwGetFramebufferSize(window, &width, &height);
-
-                VkExtent2D actual_extent = {
-                    static_cast<uint32_t>(width),
-                    static_cast<uint32_t>(height)
-                };
-
-                actual_extent.width = std::clamp(actual_extent.width, capabilities.minImageExtent.width, capabilities.maxImageExtent.width);
-                actual_extent.height = std::clamp(actual_extent.height, capabilities.minImageExtent.height, capabilities.maxImageExtent.height);
-
-                return actual_extent;
-            }
-        }
-    };
+#include "swapchain.hpp"
+
+namespace VulkanGameEngine
+{
+    namespace Utils
+    {
+        SwapChainSupportDetails query_swap_chain_support(VkPhysicalDevice device, VkSurfaceKHR& surface)
+        {
+            SwapChainSupportDetails details;
+
+            vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device, surface, &details.capabilities);
+
+            uint32_t format_count;
+            vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &format_count, nullptr);
+
+            if (format_count != 0)
+            {
+                details.formats.resize(format_count);
+                vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &format_count, details.formats.data());
+            }
+
+            uint32_t present_mode_count;
+            vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &present_mode_count, nullptr);
+
+            if (present_mode_count != 0)
+            {
+                details.present_modes.resize(present_mode_count);
+                vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &present_mode_count, details.present_modes.data());
+            }
+
+            return details;
+        }
+
+        VkSurfaceFormatKHR choose_swap_surface_format(const std::vector<VkSurfaceFormatKHR>& available_formats)
+        {
+            for (const VkSurfaceFormatKHR& available_format : available_formats)
+                if (available_format.format == VK_FORMAT_B8G8R8A8_SRGB 
+                    && available_format.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR)
+                    return available_format;
+
+            return available_formats[0];
+        }
+
+        VkExtent2D choose_swap_extent(const VkSurfaceCapabilitiesKHR& capabilities, GLFWwindow* window)
+        {
+            if (capabilities.currentExtent.width != UINT32_MAX)
+                return capabilities.currentExtent;
+            else
+            {
+                int width = 0, height = 0;
+                #ifndef VGE_HEADLESS_ONLY
+                    glfwGetFramebufferSize(window, &width, &height);
+                #else
+                    (void)window;
+                #endif
+
+                VkExtent2D actual_extent = {
+                    static_cast<uint32_t>(width),
+                    static_cast<uint32_t>(height)
+                };
+
+                actual_extent.width = std::clamp(actual_extent.width, capabilities.minImageExtent.width, capabilities.maxImageExtent.width);
+                actual_extent.height = std::clamp(actual_extent.height, capabilities.minImageExtent.height, capabilities.maxImageExtent.height);
+
+                return actual_extent;
+            }
+        }
+
+        static bool has_present_mode(const std::vector<VkPresentModeKHR>& available_present_modes, VkPresentModeKHR present_mode)
+        {
+            return std::find(available_present_modes.begin(), available_present_modes.end(), present_mode) != available_present_modes.end();
+        }
+
+        PresentConfiguration choose_present_configuration(
+            PresentPolicy policy,
+            const VkSurfaceCapabilitiesKHR& capabilities,
+            const std::vector<VkPresentModeKHR>& available_present_modes)
+        {
+            PresentConfiguration configuration{VK_PRESENT_MODE_FIFO_KHR, capabilities.minImageCount};
+
+            switch (policy)
+            {
+                case PresentPolicy::LowLatency:
+                    // MAILBOX needs a spare image to replace the queued one; FIFO gets the
+                    // shortest queue so a frame waits as little as possible to be shown.
+                    if (has_present_mode(available_present_modes, VK_PRESENT_MODE_MAILBOX_KHR))
+                    {
+                        configuration.present_mode = VK_PRESENT_MODE_MAILBOX_KHR;
+                        configuration.image_count = capabilities.minImageCount + 1;
+                    }
+                    break;
+
+                case PresentPolicy::MaxThroughput:
+                    if (has_present_mode(available_present_modes, VK_PRESENT_MODE_MAILBOX_KHR))
+                        configuration.present_mode = VK_PRESENT_MODE_MAILBOX_KHR;
+                    else if (has_present_mode(available_present_modes, VK_PRESENT_MODE_IMMEDIATE_KHR))
+                        configuration.present_mode = VK_PRESENT_MODE_IMMEDIATE_KHR;
+                    else if (has_present_mode(available_present_modes, VK_PRESENT_MODE_FIFO_RELAXED_KHR))
+                        configuration.present_mode = VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+                    configuration.image_count = capabilities.minImageCount + 2;
+                    break;
+
+                case PresentPolicy::PowerSaving:
+                    // FIFO is always supported and never renders frames that are not shown.
+                    configuration.image_count = capabilities.minImageCount + 1;
+                    break;
+            }
+
+            configuration.image_count = std::max(configuration.image_count, 2u);
+            if (capabilities.maxImageCount > 0 && configuration.image_count > capabilities.maxImageCount)
+                configuration.image_count = capabilities.maxImageCount;
+
+            return configuration;
+        }
+
+        const char* present_policy_name(PresentPolicy policy)
+        {
+            switch (policy)
+            {
+                case PresentPolicy::LowLatency: return "low-latency";
+                case PresentPolicy::MaxThroughput: return "max-throughput";
+                case PresentPolicy::PowerSaving: return "power-saving";
+            }
+            return "unknown";
+        }
+
+        const char* present_mode_name(VkPresentModeKHR present_mode)
+        {
+            switch (present_mode)
+            {
+                case VK_PRESENT_MODE_IMMEDIATE_KHR: return "immediate";
+                case VK_PRESENT_MODE_MAILBOX_KHR: return "mailbox";
+                case VK_PRESENT_MODE_FIFO_KHR: return "fifo";
+                case VK_PRESENT_MODE_FIFO_RELAXED_KHR: return "fifo-relaxed";
+                default: return "unknown";
+            }
+        }
+    };
 };
\ No newline at end of file
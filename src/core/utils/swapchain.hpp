@@ -1,39 +1,62 @@
-#pragma once
-/**
- * @author Simon Brisebois-Therrien
- * @since 2021-09-20
- * 
- */
-
-#include <iostream>
-#include <vector>
-#include <cstdint>
-#include <algorithm>
-
-#define VK_USE_PLATFORM_WIN32_KHR
-#define GLFW_INCLUDE_VULKAN
-#include <GLFW/glfw3.h>
-#define GLFW_EXPOSE_NATIVE_WIN32
-#include <GLFW/glfw3native.h>
-
-namespace VulkanGameEngine
-{
-    namespace Utils
-    {
-        struct SwapChainSupportDetails
-        {
-            VkSurfaceCapabilitiesKHR capabilities;
-            std::vector<VkSurfaceFormatKHR> formats;
-            std::vector<VkPresentModeKHR> present_modes;
-        };
-
-        SwapChainSupportDetails query_swap_chain_support(VkPhysicalDevice device, VkSurfaceKHR& surface);
-
-        VkSurfaceFormatKHR choose_swap_surface_format(const std::vector<VkSurfaceFormatKHR>& available_formats);
-
-        VkPresentModeKHR choose_swap_present_mode(const std::vector<VkPresentModeKHR>& available_present_modes);
-
-        VkExtent2D choose_swap_extent(const VkSurfaceCapabilitiesKHR& capabilities, GLFWwindow* window);
-
-    };
+#pragma once
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-09-20
+ * 
+ */
+
+#include <iostream>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+#include "platform.hpp"
+
+namespace VulkanGameEngine
+{
+    namespace Utils
+    {
+        struct SwapChainSupportDetails
+        {
+            VkSurfaceCapabilitiesKHR capabilities;
+            std::vector<VkSurfaceFormatKHR> formats;
+            std::vector<VkPresentModeKHR> present_modes;
+        };
+
+        SwapChainSupportDetails query_swap_chain_support(VkPhysicalDevice device, VkSurfaceKHR& surface);
+
+        VkSurfaceFormatKHR choose_swap_surface_format(const std::vector<VkSurfaceFormatKHR>& available_formats);
+
+        VkExtent2D choose_swap_extent(const VkSurfaceCapabilitiesKHR& capabilities, GLFWwindow* window);
+
+        /**
+         * What the swapchain and the frame pacer optimize for.
+         *  - LowLatency: MAILBOX (FIFO otherwise) with the fewest images, and the CPU
+         *    never runs more than one frame ahead of the GPU.
+         *  - MaxThroughput: the least blocking mode available and a deeper image queue.
+         *  - PowerSaving: FIFO and a frame rate cap.
+         */
+        enum class PresentPolicy
+        {
+            LowLatency,
+            MaxThroughput,
+            PowerSaving
+        };
+
+        struct PresentConfiguration
+        {
+            VkPresentModeKHR present_mode;
+            uint32_t image_count;
+        };
+
+        PresentConfiguration choose_present_configuration(
+            PresentPolicy policy,
+            const VkSurfaceCapabilitiesKHR& capabilities,
+            const std::vector<VkPresentModeKHR>& available_present_modes);
+
+        const char* present_policy_name(PresentPolicy policy);
+
+        const char* present_mode_name(VkPresentModeKHR present_mode);
+
+    };
 };
\ No newline at end of file
@@ -0,0 +1,138 @@
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-16
+ */
+
+#include <sstream>
+#include <string>
+#include <cstdint>
+
+#include "test.hpp"
+#include "../src/core/utils/debug_sink.hpp"
+
+using namespace VulkanGameEngine;
+
+static bool submit(Utils::DebugMessageSink& sink, VkDebugUtilsMessageSeverityFlagBitsEXT severity, VkDebugUtilsMessageTypeFlagsEXT type,
+    int32_t id_number, const char* id_name, const char* text)
+{
+    VkDebugUtilsMessengerCallbackDataEXT data{};
+    data.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CALLBACK_DATA_EXT;
+    data.messageIdNumber = id_number;
+    data.pMessageIdName = id_name;
+    data.pMessage = text;
+    return sink.submit(severity, type, &data);
+}
+
+static size_t count_of(const std::string& text, const std::string& pattern)
+{
+    size_t count = 0;
+    for (size_t at = text.find(pattern); at != std::string::npos; at = text.find(pattern, at + 1))
+        count++;
+    return count;
+}
+
+VGE_TEST(debug_sink_filters_before_queueing)
+{
+    std::ostringstream out;
+    Utils::DebugMessageSink sink;
+    sink.start(64, out);
+
+    const VkDebugUtilsMessageTypeFlagsEXT validation = VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT;
+    const VkDebugUtilsMessageTypeFlagsEXT performance = VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT;
+
+    // Warning and up by default.
+    VGE_CHECK(!submit(sink, VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT, validation, 1, "info", "loader info"));
+    VGE_CHECK(submit(sink, VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT, validation, 2, "warning", "layout warning"));
+    VGE_CHECK(submit(sink, VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT, validation, 3, "error", "missing barrier"));
+
+    sink.set_type_mask(validation);
+    VGE_CHECK(!submit(sink, VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT, performance, 4, "perf", "small allocation"));
+
+    VGE_CHECK(sink.mute(2));
+    VGE_CHECK(!submit(sink, VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT, validation, 2, "warning", "layout warning"));
+    sink.unmute(2);
+    VGE_CHECK(submit(sink, VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT, validation, 2, "warning", "layout warning"));
+
+    sink.set_minimum_severity(VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT);
+    VGE_CHECK(!submit(sink, VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT, validation, 5, "warning", "other warning"));
+
+    sink.stop();
+
+    Utils::DebugMessageSink::Statistics statistics = sink.get_statistics();
+    VGE_CHECK(statistics.received == 3);
+    VGE_CHECK(statistics.filtered == 4);
+    VGE_CHECK(statistics.dropped == 0);
+    VGE_CHECK(statistics.by_type[Utils::DebugMessageSink::Validation][Utils::DebugMessageSink::Warning] == 2);
+    VGE_CHECK(statistics.by_type[Utils::DebugMessageSink::Validation][Utils::DebugMessageSink::Error] == 1);
+    VGE_CHECK(out.str().find("[error][validation] missing barrier") != std::string::npos);
+    VGE_CHECK(out.str().find("small allocation") == std::string::npos);
+}
+
+VGE_TEST(debug_sink_prints_repeats_up_to_the_limit)
+{
+    std::ostringstream out;
+    Utils::DebugMessageSink sink;
+    sink.set_max_repeats(2);
+    sink.start(64, out);
+
+    for (int i = 0; i < 10; i++)
+        submit(sink, VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT, VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT,
+            0x1234, "VUID-repeated", "same thing again");
+    submit(sink, VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT, VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT,
+        0x5678, "VUID-once", "only once");
+
+    sink.stop();
+
+    Utils::DebugMessageSink::Statistics statistics = sink.get_statistics();
+    VGE_CHECK(statistics.received == 11);
+    VGE_CHECK(statistics.printed == 3);
+    VGE_CHECK(statistics.suppressed == 8);
+
+    std::string text = out.str();
+    VGE_CHECK(count_of(text, "same thing again") == 2);
+    VGE_CHECK(count_of(text, "(further repeats counted only)") == 1);
+    VGE_CHECK(text.find("10 x VUID-repeated (0x00001234)") != std::string::npos);
+    VGE_CHECK(text.find("VUID-once (") == std::string::npos);
+}
+
+VGE_TEST(debug_sink_tells_unnumbered_messages_apart)
+{
+    std::ostringstream out;
+    Utils::DebugMessageSink sink;
+    sink.set_max_repeats(1);
+    sink.start(64, out);
+
+    // Loader messages without an ID number or name are keyed by their text.
+    for (int i = 0; i < 3; i++)
+    {
+        submit(sink, VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT, VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT, 0, nullptr, "first loader message");
+        submit(sink, VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT, VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT, 0, nullptr, "second loader message");
+    }
+
+    sink.stop();
+
+    std::string text = out.str();
+    VGE_CHECK(count_of(text, "first loader message") == 1);
+    VGE_CHECK(count_of(text, "second loader message") == 1);
+    VGE_CHECK(sink.get_statistics().printed == 2);
+    VGE_CHECK(sink.get_statistics().suppressed == 4);
+}
+
+VGE_TEST(debug_sink_drops_without_a_ring)
+{
+    Utils::DebugMessageSink sink;
+    VGE_CHECK(!submit(sink, VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT, VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT, 1, "error", "lost"));
+    VGE_CHECK(sink.get_statistics().dropped == 1);
+}
+
+VGE_TEST(debug_sink_limits_muted_ids)
+{
+    Utils::DebugMessageSink sink;
+    for (uint32_t i = 0; i < Utils::DebugMessageSink::max_muted_ids; i++)
+        VGE_CHECK(sink.mute(static_cast<int32_t>(i + 1)));
+
+    VGE_CHECK(sink.mute(1));
+    VGE_CHECK(!sink.mute(-1));
+    sink.unmute(5);
+    VGE_CHECK(sink.mute(-1));
+}
@@ -0,0 +1,86 @@
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-16
+ */
+
+#include <vector>
+#include <stdexcept>
+
+#include "test.hpp"
+#include "../src/core/graphics/descriptors.hpp"
+
+using namespace VulkanGameEngine;
+
+static VkDescriptorSetLayoutBinding binding(uint32_t number, VkDescriptorType type, VkShaderStageFlags stages, uint32_t count = 1)
+{
+    VkDescriptorSetLayoutBinding result{};
+    result.binding = number;
+    result.descriptorType = type;
+    result.descriptorCount = count;
+    result.stageFlags = stages;
+    return result;
+}
+
+VGE_TEST(descriptors_layout_key_ignores_declaration_order)
+{
+    VkDescriptorSetLayoutBinding camera = binding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT);
+    VkDescriptorSetLayoutBinding albedo = binding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT);
+    VkDescriptorSetLayoutBinding lights = binding(4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT);
+
+    Graphics::DescriptorLayoutKey a({camera, albedo, lights});
+    Graphics::DescriptorLayoutKey b({lights, camera, albedo});
+    VGE_CHECK(a == b);
+    VGE_CHECK(Graphics::DescriptorLayoutKeyHash()(a) == Graphics::DescriptorLayoutKeyHash()(b));
+    VGE_CHECK(b.bindings[0].binding == 0 && b.bindings[2].binding == 4);
+
+    // Binding flags follow their binding through the sort.
+    Graphics::DescriptorLayoutKey c({camera, albedo}, 0, {0, VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT});
+    Graphics::DescriptorLayoutKey d({albedo, camera}, 0, {VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT, 0});
+    VGE_CHECK(c == d);
+    VGE_CHECK(Graphics::DescriptorLayoutKeyHash()(c) == Graphics::DescriptorLayoutKeyHash()(d));
+}
+
+VGE_TEST(descriptors_layout_key_tells_layouts_apart)
+{
+    Graphics::DescriptorLayoutKeyHash hash;
+    VkDescriptorSetLayoutBinding base = binding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT);
+    Graphics::DescriptorLayoutKey key({base});
+
+    std::vector<Graphics::DescriptorLayoutKey> others = {
+        Graphics::DescriptorLayoutKey({binding(1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT)}),
+        Graphics::DescriptorLayoutKey({binding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT)}),
+        Graphics::DescriptorLayoutKey({binding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)}),
+        Graphics::DescriptorLayoutKey({binding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT, 2)}),
+        Graphics::DescriptorLayoutKey({base}, VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT),
+        Graphics::DescriptorLayoutKey({base}, 0, {VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT}),
+        Graphics::DescriptorLayoutKey({base, binding(1, VK_DESCRIPTOR_TYPE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)}),
+        Graphics::DescriptorLayoutKey(std::vector<VkDescriptorSetLayoutBinding>()),
+    };
+
+    // Immutable samplers are part of the layout.
+    VkSampler sampler = VK_NULL_HANDLE;
+    VkDescriptorSetLayoutBinding immutable = base;
+    immutable.pImmutableSamplers = &sampler;
+    others.push_back(Graphics::DescriptorLayoutKey({immutable}));
+
+    for (const Graphics::DescriptorLayoutKey& other : others)
+    {
+        VGE_CHECK(key != other);
+        VGE_CHECK(hash(key) != hash(other));
+    }
+}
+
+VGE_TEST(descriptors_layout_key_rejects_mismatched_binding_flags)
+{
+    bool thrown = false;
+    try
+    {
+        Graphics::DescriptorLayoutKey key({binding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT)}, 0,
+            {0, VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT});
+    }
+    catch (const std::runtime_error&)
+    {
+        thrown = true;
+    }
+    VGE_CHECK(thrown);
+}
@@ -0,0 +1,142 @@
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-16
+ */
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cmath>
+#include <limits>
+#include <thread>
+
+#include "test.hpp"
+#include "../src/core/graphics/draw_queue.hpp"
+#include "../src/core/jobs/job_system.hpp"
+
+using namespace VulkanGameEngine;
+
+namespace
+{
+    /**
+     * Few distinct keys, so most entries tie; values record submission order.
+     */
+    std::vector<Graphics::SortEntry> make_entries(size_t count)
+    {
+        std::vector<Graphics::SortEntry> entries(count);
+        uint32_t state = 7;
+        for (size_t i = 0; i < count; i++)
+        {
+            state = state * 1664525u + 1013904223u;
+            uint64_t key = (static_cast<uint64_t>(state >> 28) << 52) | ((state >> 8) & 0x3);
+            entries[i] = Graphics::SortEntry{key, static_cast<uint32_t>(i), 0};
+        }
+        return entries;
+    }
+
+    bool sorted_stably(const std::vector<Graphics::SortEntry>& entries)
+    {
+        for (size_t i = 1; i < entries.size(); i++)
+        {
+            if (entries[i - 1].key > entries[i].key)
+                return false;
+            if (entries[i - 1].key == entries[i].key && entries[i - 1].value > entries[i].value)
+                return false;
+        }
+        return true;
+    }
+};
+
+VGE_TEST(draw_queue_radix_sort_is_stable)
+{
+    std::vector<Graphics::SortEntry> entries = make_entries(1000);
+    std::vector<Graphics::SortEntry> expected = entries;
+    std::stable_sort(expected.begin(), expected.end(), [](const Graphics::SortEntry& a, const Graphics::SortEntry& b) { return a.key < b.key; });
+
+    std::vector<Graphics::SortEntry> scratch;
+    Graphics::radix_sort(entries, scratch);
+
+    VGE_CHECK(sorted_stably(entries));
+    bool same = true;
+    for (size_t i = 0; i < entries.size(); i++)
+        same &= entries[i].key == expected[i].key && entries[i].value == expected[i].value;
+    VGE_CHECK(same);
+}
+
+VGE_TEST(draw_queue_radix_sort_parallel_is_stable)
+{
+    // Large enough to be split into blocks across the workers.
+    std::vector<Graphics::SortEntry> serial = make_entries(200000);
+    std::vector<Graphics::SortEntry> parallel = serial;
+    std::vector<Graphics::SortEntry> scratch;
+
+    Jobs::JobSystem jobs;
+    jobs.init(4);
+    Graphics::radix_sort(serial, scratch);
+    Graphics::radix_sort(parallel, scratch, &jobs);
+    jobs.cleanup();
+
+    VGE_CHECK(sorted_stably(parallel));
+    bool same = true;
+    for (size_t i = 0; i < serial.size(); i++)
+        same &= serial[i].key == parallel[i].key && serial[i].value == parallel[i].value;
+    VGE_CHECK(same);
+}
+
+VGE_TEST(draw_queue_key_orders_depth)
+{
+    Graphics::DrawState near_state;
+    near_state.depth = 0.25f;
+    Graphics::DrawState far_state = near_state;
+    far_state.depth = 0.75f;
+
+    VGE_CHECK(Graphics::make_draw_key(near_state, Graphics::DepthOrder::FrontToBack) < Graphics::make_draw_key(far_state, Graphics::DepthOrder::FrontToBack));
+    VGE_CHECK(Graphics::make_draw_key(near_state, Graphics::DepthOrder::BackToFront) > Graphics::make_draw_key(far_state, Graphics::DepthOrder::BackToFront));
+}
+
+VGE_TEST(draw_queue_key_non_finite_depth)
+{
+    Graphics::DrawState far_state;
+    far_state.depth = 1.0f;
+    Graphics::DrawState state = far_state;
+
+    const float depths[] = {std::numeric_limits<float>::quiet_NaN(), std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity()};
+    for (float depth : depths)
+    {
+        state.depth = depth;
+        VGE_CHECK(Graphics::make_draw_key(state, Graphics::DepthOrder::FrontToBack) == Graphics::make_draw_key(far_state, Graphics::DepthOrder::FrontToBack));
+        VGE_CHECK(Graphics::make_draw_key(state, Graphics::DepthOrder::BackToFront) == Graphics::make_draw_key(far_state, Graphics::DepthOrder::BackToFront));
+    }
+}
+
+VGE_TEST(draw_queue_record_ranges_add_up)
+{
+    // Handles are only compared: recording into a null command buffer issues no calls.
+    VkPipeline pipeline = (VkPipeline)(uintptr_t)1;
+    VkPipelineLayout layout = (VkPipelineLayout)(uintptr_t)1;
+
+    Graphics::DrawQueue whole;
+    Graphics::DrawQueue ranged;
+    for (Graphics::DrawQueue* queue : {&whole, &ranged})
+    {
+        Graphics::DrawState state;
+        state.pipeline = queue->add_pipeline(pipeline, layout);
+        queue->begin_frame();
+        for (uint32_t i = 0; i < 200; i++)
+            queue->submit(state, Graphics::DrawCommand{});
+    }
+
+    whole.record(VK_NULL_HANDLE);
+
+    std::thread first([&]() { ranged.record(VK_NULL_HANDLE, 0, 100); });
+    std::thread second([&]() { ranged.record(VK_NULL_HANDLE, 100, 100); });
+    first.join();
+    second.join();
+
+    VGE_CHECK(whole.get_frame_statistics().draws == 200);
+    VGE_CHECK(ranged.get_frame_statistics().draws == 200);
+    // Every range starts from no bound state.
+    VGE_CHECK(whole.get_frame_statistics().pipeline_binds == 1);
+    VGE_CHECK(ranged.get_frame_statistics().pipeline_binds == 2);
+    VGE_CHECK(ranged.get_frame_statistics().binds_eliminated == whole.get_frame_statistics().binds_eliminated - 1);
+}
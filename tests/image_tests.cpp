@@ -0,0 +1,86 @@
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-16
+ */
+
+#include <vector>
+#include <cstdint>
+#include <cmath>
+
+#include "test.hpp"
+#include "../src/core/utils/image_file.hpp"
+
+using namespace VulkanGameEngine;
+
+namespace
+{
+    Utils::ImageData make_gradient(uint32_t width, uint32_t height)
+    {
+        Utils::ImageData image;
+        image.resize(width, height);
+        for (uint32_t y = 0; y < height; y++)
+        {
+            for (uint32_t x = 0; x < width; x++)
+            {
+                uint8_t* pixel = &image.pixels[(static_cast<size_t>(y) * width + x) * 4];
+                pixel[0] = static_cast<uint8_t>(x * 255 / width);
+                pixel[1] = static_cast<uint8_t>(y * 255 / height);
+                pixel[2] = static_cast<uint8_t>((x ^ y) & 0xff);
+                pixel[3] = 255;
+            }
+        }
+        return image;
+    }
+};
+
+VGE_TEST(image_png_round_trip)
+{
+    Utils::ImageData image = make_gradient(67, 45);
+    std::vector<uint8_t> encoded = Utils::encode_png(image);
+
+    Utils::ImageData decoded;
+    VGE_CHECK(Utils::decode_png(encoded.data(), encoded.size(), decoded));
+    VGE_CHECK(decoded.width == image.width && decoded.height == image.height);
+    VGE_CHECK(decoded.pixels == image.pixels);
+
+    VGE_CHECK(!Utils::decode_png(encoded.data(), encoded.size() / 2, decoded));
+}
+
+VGE_TEST(image_compare_identical)
+{
+    Utils::ImageData image = make_gradient(32, 32);
+    Utils::ImageComparison comparison = Utils::compare_images(image, image, 0);
+    VGE_CHECK(!comparison.size_mismatch);
+    VGE_CHECK(comparison.pixels == 32 * 32);
+    VGE_CHECK(comparison.mismatched_pixels == 0);
+    VGE_CHECK(comparison.max_difference == 0);
+    VGE_CHECK(std::isinf(comparison.psnr));
+}
+
+VGE_TEST(image_compare_tolerance)
+{
+    Utils::ImageData expected = make_gradient(32, 32);
+    Utils::ImageData actual = expected;
+
+    // Alpha is ignored.
+    actual.pixels[3] = 0;
+    // One pixel off by 2 on red, another by 10 on blue.
+    actual.pixels[4 * 5 + 0] = static_cast<uint8_t>(actual.pixels[4 * 5 + 0] + 2);
+    actual.pixels[4 * 9 + 2] = static_cast<uint8_t>(actual.pixels[4 * 9 + 2] + 10);
+
+    Utils::ImageComparison strict = Utils::compare_images(expected, actual, 0);
+    VGE_CHECK(strict.mismatched_pixels == 2);
+    VGE_CHECK(strict.max_difference == 10);
+    VGE_CHECK(std::isfinite(strict.psnr) && strict.psnr > 40.0);
+    VGE_CHECK(Tests::near(static_cast<float>(strict.mismatch_fraction()), 2.0f / 1024.0f, 1e-6f));
+
+    Utils::ImageComparison tolerant = Utils::compare_images(expected, actual, 2);
+    VGE_CHECK(tolerant.mismatched_pixels == 1);
+    VGE_CHECK(tolerant.max_difference == 10);
+}
+
+VGE_TEST(image_compare_size_mismatch)
+{
+    Utils::ImageComparison comparison = Utils::compare_images(make_gradient(32, 32), make_gradient(32, 16), 255);
+    VGE_CHECK(comparison.size_mismatch);
+}
@@ -0,0 +1,185 @@
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-16
+ */
+
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <stdexcept>
+#include <cstdint>
+
+#include "test.hpp"
+#include "../src/core/jobs/job_system.hpp"
+#include "../src/core/jobs/work_stealing_deque.hpp"
+
+using namespace VulkanGameEngine;
+
+VGE_TEST(jobs_deque_pops_lifo_and_steals_fifo)
+{
+    Jobs::WorkStealingDeque<uint32_t> deque(2);
+
+    // Past the initial capacity: the deque grows and keeps its order.
+    for (uint32_t i = 0; i < 10; i++)
+        deque.push(i);
+    VGE_CHECK(deque.size() == 10);
+
+    uint32_t value = 0;
+    VGE_CHECK(deque.pop(value) && value == 9);
+    VGE_CHECK(deque.steal(value) && value == 0);
+    VGE_CHECK(deque.steal(value) && value == 1);
+    VGE_CHECK(deque.pop(value) && value == 8);
+    VGE_CHECK(deque.size() == 6);
+
+    while (deque.pop(value))
+        ;
+    VGE_CHECK(deque.empty());
+    VGE_CHECK(!deque.steal(value));
+}
+
+VGE_TEST(jobs_deque_hands_out_every_item_once)
+{
+    const uint32_t count = 200000;
+    Jobs::WorkStealingDeque<uint32_t> deque(64);
+
+    std::vector<std::atomic<uint32_t>> seen(count);
+    std::atomic<bool> done{false};
+
+    std::vector<std::thread> thieves;
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        thieves.emplace_back([&]() {
+            uint32_t value;
+            while (!done.load(std::memory_order_acquire) || !deque.empty())
+                if (deque.steal(value))
+                    seen[value].fetch_add(1, std::memory_order_relaxed);
+        });
+    }
+
+    // The owner interleaves pushes and pops so both ends race for the last items.
+    uint32_t value;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        deque.push(i);
+        if (i % 3 == 0 && deque.pop(value))
+            seen[value].fetch_add(1, std::memory_order_relaxed);
+    }
+    while (deque.pop(value))
+        seen[value].fetch_add(1, std::memory_order_relaxed);
+
+    done.store(true, std::memory_order_release);
+    for (std::thread& thief : thieves)
+        thief.join();
+
+    bool once = true;
+    for (const std::atomic<uint32_t>& hits : seen)
+        once &= hits.load() == 1;
+    VGE_CHECK(once);
+}
+
+VGE_TEST(jobs_parallel_for_covers_every_index_once)
+{
+    Jobs::JobSystem jobs;
+    jobs.init(4);
+
+    for (uint32_t count : {1u, 7u, 1000u, 100003u})
+    {
+        std::vector<std::atomic<uint32_t>> hits(count);
+        jobs.parallel_for(count, 16, [&hits](uint32_t first, uint32_t last) {
+            for (uint32_t i = first; i < last; i++)
+                hits[i].fetch_add(1, std::memory_order_relaxed);
+        });
+
+        bool once = true;
+        for (const std::atomic<uint32_t>& hit : hits)
+            once &= hit.load() == 1;
+        VGE_CHECK(once);
+    }
+
+    jobs.cleanup();
+}
+
+VGE_TEST(jobs_run_after_waits_for_its_dependency)
+{
+    Jobs::JobSystem jobs;
+    jobs.init(4);
+
+    std::atomic<uint32_t> finished{0};
+    std::atomic<bool> ordered{true};
+
+    Jobs::JobCounter first;
+    Jobs::JobCounter second;
+    for (uint32_t i = 0; i < 64; i++)
+        jobs.run([&finished]() { finished.fetch_add(1); }, &first);
+    for (uint32_t i = 0; i < 16; i++)
+        jobs.run_after(first, [&finished, &ordered]() {
+            if (finished.load() < 64)
+                ordered.store(false);
+        }, &second);
+
+    jobs.wait(second);
+    VGE_CHECK(first.is_done());
+    VGE_CHECK(ordered.load());
+
+    jobs.cleanup();
+}
+
+VGE_TEST(jobs_wait_rethrows_job_exceptions)
+{
+    Jobs::JobSystem jobs;
+    jobs.init(4);
+
+    Jobs::JobCounter counter;
+    std::atomic<uint32_t> ran{0};
+    for (uint32_t i = 0; i < 32; i++)
+    {
+        jobs.run([&ran, i]() {
+            ran.fetch_add(1);
+            if (i == 5)
+                throw std::runtime_error("job failed");
+        }, &counter);
+    }
+
+    bool thrown = false;
+    try
+    {
+        jobs.wait(counter);
+    }
+    catch (const std::runtime_error&)
+    {
+        thrown = true;
+    }
+    VGE_CHECK(thrown);
+    VGE_CHECK(ran.load() == 32);
+
+    // The error is consumed by the first wait.
+    jobs.wait(counter);
+
+    jobs.cleanup();
+}
+
+VGE_TEST(jobs_main_thread_jobs_run_on_the_main_thread)
+{
+    Jobs::JobSystem jobs;
+    jobs.init(4);
+
+    std::thread::id main_thread = std::this_thread::get_id();
+    std::atomic<bool> on_main{true};
+
+    Jobs::JobCounter counter;
+    for (uint32_t i = 0; i < 8; i++)
+    {
+        // Posted from workers, as the engine does for GLFW calls.
+        jobs.run([&jobs, &counter, &on_main, main_thread]() {
+            jobs.run_on_main_thread([&on_main, main_thread]() {
+                if (std::this_thread::get_id() != main_thread)
+                    on_main.store(false);
+            }, &counter);
+        }, &counter);
+    }
+
+    jobs.wait(counter);
+    VGE_CHECK(on_main.load());
+
+    jobs.cleanup();
+}
@@ -0,0 +1,76 @@
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-16
+ */
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+
+#include "test.hpp"
+#include "../src/core/assets/lz4.hpp"
+
+using namespace VulkanGameEngine;
+
+namespace
+{
+    bool round_trips(const std::vector<uint8_t>& data)
+    {
+        std::vector<uint8_t> compressed(Assets::lz4_compress_bound(data.size()));
+        size_t compressed_size = Assets::lz4_compress(data.data(), data.size(), compressed.data(), compressed.size());
+        if (compressed_size == 0 && !data.empty())
+            return false;
+
+        std::vector<uint8_t> decompressed(data.size());
+        if (!Assets::lz4_decompress(compressed.data(), compressed_size, decompressed.data(), decompressed.size()))
+            return false;
+        return decompressed == data;
+    }
+};
+
+VGE_TEST(lz4_round_trip)
+{
+    // Literals only, a few bytes, runs, and mixed text.
+    std::vector<uint8_t> noise(100000);
+    uint32_t state = 11;
+    for (uint8_t& byte : noise)
+    {
+        state = state * 1664525u + 1013904223u;
+        byte = static_cast<uint8_t>(state >> 24);
+    }
+    VGE_CHECK(round_trips(noise));
+    VGE_CHECK(round_trips(std::vector<uint8_t>{1, 2, 3}));
+    VGE_CHECK(round_trips(std::vector<uint8_t>(70000, 0x5a)));
+
+    std::vector<uint8_t> text;
+    const char* words[] = {"vertex ", "index ", "texture ", "mesh ", "chunk "};
+    for (uint32_t i = 0; i < 20000; i++)
+    {
+        state = state * 1664525u + 1013904223u;
+        const char* word = words[(state >> 16) % 5];
+        text.insert(text.end(), word, word + std::strlen(word));
+    }
+    VGE_CHECK(round_trips(text));
+}
+
+VGE_TEST(lz4_compresses_repetition)
+{
+    std::vector<uint8_t> data(65536, 7);
+    std::vector<uint8_t> compressed(Assets::lz4_compress_bound(data.size()));
+    size_t compressed_size = Assets::lz4_compress(data.data(), data.size(), compressed.data(), compressed.size());
+    VGE_CHECK(compressed_size > 0 && compressed_size < data.size() / 100);
+}
+
+VGE_TEST(lz4_rejects_truncated_input)
+{
+    std::vector<uint8_t> data(4096);
+    for (size_t i = 0; i < data.size(); i++)
+        data[i] = static_cast<uint8_t>(i * 7 / 3);
+
+    std::vector<uint8_t> compressed(Assets::lz4_compress_bound(data.size()));
+    size_t compressed_size = Assets::lz4_compress(data.data(), data.size(), compressed.data(), compressed.size());
+    std::vector<uint8_t> decompressed(data.size());
+    VGE_CHECK(!Assets::lz4_decompress(compressed.data(), compressed_size / 2, decompressed.data(), decompressed.size()));
+    // The output size must match exactly.
+    VGE_CHECK(!Assets::lz4_decompress(compressed.data(), compressed_size, decompressed.data(), decompressed.size() - 1));
+}
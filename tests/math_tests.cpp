@@ -0,0 +1,181 @@
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-16
+ *
+ * Every batch kernel the CPU supports must agree with the scalar one.
+ */
+
+#include <vector>
+#include <cstdint>
+
+#include "test.hpp"
+#include "../src/core/math/batch.hpp"
+#include "../src/core/math/quaternion.hpp"
+
+using namespace VulkanGameEngine;
+
+namespace
+{
+    const Math::BatchKernel wide_kernels[] = {Math::BatchKernel::SIMD, Math::BatchKernel::AVX2};
+
+    // Deterministic values in [-1, 1).
+    float random_unit(uint32_t& state)
+    {
+        state = state * 1664525u + 1013904223u;
+        return static_cast<float>(state >> 8) / 8388608.0f - 1.0f;
+    }
+
+    std::vector<Math::Mat4> random_affine_matrices(size_t count, uint32_t seed)
+    {
+        std::vector<Math::Mat4> matrices(count);
+        for (Math::Mat4& matrix : matrices)
+        {
+            Math::Vec3 axis(random_unit(seed), random_unit(seed), random_unit(seed) + 2.0f);
+            float length = std::sqrt(axis.x * axis.x + axis.y * axis.y + axis.z * axis.z);
+            Math::Quat rotation = Math::from_axis_angle(Math::Vec3(axis.x / length, axis.y / length, axis.z / length), random_unit(seed) * 3.0f);
+            matrix = Math::Mat4::compose(
+                Math::Vec3(random_unit(seed) * 100.0f, random_unit(seed) * 100.0f, random_unit(seed) * 100.0f),
+                rotation,
+                Math::Vec3(1.5f + random_unit(seed), 1.5f + random_unit(seed), 1.5f + random_unit(seed)));
+        }
+        return matrices;
+    }
+
+    bool matrices_near(const Math::Mat4& a, const Math::Mat4& b)
+    {
+        for (int i = 0; i < 16; i++)
+            if (!Tests::near(a.m[i], b.m[i], 1e-5f))
+                return false;
+        return true;
+    }
+
+    bool vectors_near(const Math::Vec3& a, const Math::Vec3& b)
+    {
+        return Tests::near(a.x, b.x, 1e-5f) && Tests::near(a.y, b.y, 1e-5f) && Tests::near(a.z, b.z, 1e-5f);
+    }
+};
+
+// 37 is not a multiple of any kernel's width, so every tail path runs too.
+static const size_t batch_count = 37;
+
+VGE_TEST(math_batch_multiply_matrices_agree)
+{
+    std::vector<Math::Mat4> a = random_affine_matrices(batch_count, 1);
+    std::vector<Math::Mat4> b = random_affine_matrices(batch_count, 2);
+
+    std::vector<Math::Mat4> expected(batch_count);
+    std::vector<Math::Mat4> expected_shared(batch_count);
+    Math::multiply_matrices(a.data(), b.data(), expected.data(), batch_count, Math::BatchKernel::Scalar);
+    Math::multiply_matrices(a[0], b.data(), expected_shared.data(), batch_count, Math::BatchKernel::Scalar);
+
+    for (Math::BatchKernel kernel : wide_kernels)
+    {
+        if (!Math::is_batch_kernel_supported(kernel))
+            continue;
+
+        std::vector<Math::Mat4> actual(batch_count);
+        Math::multiply_matrices(a.data(), b.data(), actual.data(), batch_count, kernel);
+        for (size_t i = 0; i < batch_count; i++)
+            VGE_CHECK(matrices_near(expected[i], actual[i]));
+
+        Math::multiply_matrices(a[0], b.data(), actual.data(), batch_count, kernel);
+        for (size_t i = 0; i < batch_count; i++)
+            VGE_CHECK(matrices_near(expected_shared[i], actual[i]));
+
+        // In place, out aliasing b.
+        actual = b;
+        Math::multiply_matrices(a.data(), actual.data(), actual.data(), batch_count, kernel);
+        for (size_t i = 0; i < batch_count; i++)
+            VGE_CHECK(matrices_near(expected[i], actual[i]));
+    }
+}
+
+VGE_TEST(math_batch_transform_bounds_agree)
+{
+    std::vector<Math::Mat4> matrices = random_affine_matrices(batch_count, 3);
+    std::vector<Math::Aabb> boxes(batch_count);
+    std::vector<Math::Sphere> spheres(batch_count);
+
+    uint32_t seed = 4;
+    for (size_t i = 0; i < batch_count; i++)
+    {
+        Math::Vec3 center(random_unit(seed) * 10.0f, random_unit(seed) * 10.0f, random_unit(seed) * 10.0f);
+        Math::Vec3 extent(1.0f + random_unit(seed) * 0.5f, 1.0f + random_unit(seed) * 0.5f, 1.0f + random_unit(seed) * 0.5f);
+        boxes[i] = Math::Aabb{center - extent, center + extent};
+        spheres[i] = Math::Sphere{center, 2.0f + random_unit(seed)};
+    }
+
+    std::vector<Math::Aabb> expected_boxes(batch_count);
+    std::vector<Math::Sphere> expected_spheres(batch_count);
+    Math::transform_aabbs(matrices.data(), boxes.data(), expected_boxes.data(), batch_count, Math::BatchKernel::Scalar);
+    Math::transform_spheres(matrices.data(), spheres.data(), expected_spheres.data(), batch_count, Math::BatchKernel::Scalar);
+
+    for (Math::BatchKernel kernel : wide_kernels)
+    {
+        if (!Math::is_batch_kernel_supported(kernel))
+            continue;
+
+        std::vector<Math::Aabb> actual_boxes(batch_count);
+        std::vector<Math::Sphere> actual_spheres(batch_count);
+        Math::transform_aabbs(matrices.data(), boxes.data(), actual_boxes.data(), batch_count, kernel);
+        Math::transform_spheres(matrices.data(), spheres.data(), actual_spheres.data(), batch_count, kernel);
+
+        for (size_t i = 0; i < batch_count; i++)
+        {
+            VGE_CHECK(vectors_near(expected_boxes[i].min, actual_boxes[i].min));
+            VGE_CHECK(vectors_near(expected_boxes[i].max, actual_boxes[i].max));
+            VGE_CHECK(vectors_near(expected_spheres[i].center, actual_spheres[i].center));
+            VGE_CHECK(Tests::near(expected_spheres[i].radius, actual_spheres[i].radius, 1e-5f));
+        }
+    }
+}
+
+VGE_TEST(math_batch_point_bounds_agree)
+{
+    std::vector<Math::Vec3> points(batch_count);
+    uint32_t seed = 5;
+    for (Math::Vec3& point : points)
+        point = Math::Vec3(random_unit(seed) * 50.0f, random_unit(seed) * 50.0f, random_unit(seed) * 50.0f);
+
+    Math::Aabb expected_box = Math::compute_aabb(points.data(), points.size(), Math::BatchKernel::Scalar);
+    Math::Sphere expected_sphere = Math::compute_bounding_sphere(points.data(), points.size(), Math::BatchKernel::Scalar);
+
+    for (Math::BatchKernel kernel : wide_kernels)
+    {
+        if (!Math::is_batch_kernel_supported(kernel))
+            continue;
+
+        Math::Aabb box = Math::compute_aabb(points.data(), points.size(), kernel);
+        Math::Sphere sphere = Math::compute_bounding_sphere(points.data(), points.size(), kernel);
+        VGE_CHECK(box.min == expected_box.min && box.max == expected_box.max);
+        VGE_CHECK(vectors_near(sphere.center, expected_sphere.center));
+        VGE_CHECK(Tests::near(sphere.radius, expected_sphere.radius, 1e-5f));
+    }
+}
+
+VGE_TEST(math_camera_maps_to_vulkan_clip_space)
+{
+    Math::Mat4 view = Math::look_at(Math::Vec3(0.0f, 0.0f, 10.0f), Math::Vec3(0.0f, 0.0f, 0.0f), Math::Vec3(0.0f, 1.0f, 0.0f));
+    Math::Mat4 view_projection = Math::perspective(1.0f, 2.0f, 1.0f, 100.0f) * view;
+
+    auto clip = [&](const Math::Vec3& p, float& x, float& y, float& depth) {
+        const float* m = view_projection.m;
+        float w = m[3] * p.x + m[7] * p.y + m[11] * p.z + m[15];
+        x = (m[0] * p.x + m[4] * p.y + m[8] * p.z + m[12]) / w;
+        y = (m[1] * p.x + m[5] * p.y + m[9] * p.z + m[13]) / w;
+        depth = (m[2] * p.x + m[6] * p.y + m[10] * p.z + m[14]) / w;
+    };
+
+    float x, y, depth;
+    clip(Math::Vec3(0.0f, 0.0f, 0.0f), x, y, depth);
+    VGE_CHECK(Tests::near(x, 0.0f, 1e-6f) && Tests::near(y, 0.0f, 1e-6f) && depth > 0.0f && depth < 1.0f);
+
+    clip(Math::Vec3(0.0f, 0.0f, 9.0f), x, y, depth);
+    VGE_CHECK(Tests::near(depth, 0.0f, 1e-5f));
+    clip(Math::Vec3(0.0f, 0.0f, -90.0f), x, y, depth);
+    VGE_CHECK(Tests::near(depth, 1.0f, 1e-5f));
+
+    // Up and right of the target land above (negative y) and right of the center.
+    clip(Math::Vec3(1.0f, 1.0f, 0.0f), x, y, depth);
+    VGE_CHECK(x > 0.0f && y < 0.0f);
+}
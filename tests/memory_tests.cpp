@@ -0,0 +1,117 @@
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-16
+ */
+
+#include <map>
+#include <vector>
+#include <iterator>
+#include <cstdint>
+
+#include "test.hpp"
+#include "../src/core/memory/buddy.hpp"
+
+using namespace VulkanGameEngine;
+
+VGE_TEST(memory_buddy_rounds_up_to_blocks)
+{
+    Memory::BuddyAllocator buddy(1 << 16, 256);
+
+    uint64_t small = buddy.allocate(1);
+    uint64_t odd = buddy.allocate(300);
+    VGE_CHECK(buddy.allocation_size(small) == 256);
+    VGE_CHECK(buddy.allocation_size(odd) == 512);
+    VGE_CHECK(buddy.get_used_bytes() == 768);
+    VGE_CHECK(odd % 512 == 0);
+}
+
+VGE_TEST(memory_buddy_merges_freed_buddies)
+{
+    const uint64_t size = 1 << 16;
+    Memory::BuddyAllocator buddy(size, 256);
+
+    std::vector<uint64_t> offsets;
+    for (uint64_t offset = buddy.allocate(256); offset != Memory::BuddyAllocator::invalid_offset; offset = buddy.allocate(256))
+        offsets.push_back(offset);
+    VGE_CHECK(offsets.size() == size / 256);
+    VGE_CHECK(buddy.largest_free_block() == 0);
+
+    // Every other block back: nothing can merge yet.
+    for (size_t i = 0; i < offsets.size(); i += 2)
+        buddy.free(offsets[i]);
+    VGE_CHECK(buddy.largest_free_block() == 256);
+    VGE_CHECK(buddy.allocate(512) == Memory::BuddyAllocator::invalid_offset);
+
+    for (size_t i = 1; i < offsets.size(); i += 2)
+        buddy.free(offsets[i]);
+    VGE_CHECK(buddy.empty());
+    VGE_CHECK(buddy.largest_free_block() == size);
+    VGE_CHECK(buddy.allocate(size) == 0);
+}
+
+VGE_TEST(memory_buddy_reports_exhaustion)
+{
+    Memory::BuddyAllocator buddy(1 << 12, 256);
+
+    VGE_CHECK(buddy.allocate((1 << 12) + 1) == Memory::BuddyAllocator::invalid_offset);
+    VGE_CHECK(buddy.allocate(1 << 11) != Memory::BuddyAllocator::invalid_offset);
+    VGE_CHECK(buddy.allocate(1 << 11) != Memory::BuddyAllocator::invalid_offset);
+    VGE_CHECK(buddy.allocate(1) == Memory::BuddyAllocator::invalid_offset);
+}
+
+VGE_TEST(memory_buddy_random_blocks_never_overlap)
+{
+    const uint64_t size = 1 << 20;
+    Memory::BuddyAllocator buddy(size, 256);
+
+    // offset -> block size of every live allocation.
+    std::map<uint64_t, uint64_t> live;
+    uint32_t state = 5;
+    auto next = [&state]() {
+        state = state * 1664525u + 1013904223u;
+        return state >> 8;
+    };
+
+    bool aligned = true;
+    bool disjoint = true;
+    for (uint32_t i = 0; i < 20000; i++)
+    {
+        if (live.empty() || next() % 2)
+        {
+            uint64_t request = 1 + next() % 20000;
+            uint64_t alignment = 1ull << (next() % 10);
+            uint64_t offset = buddy.allocate(request, alignment);
+            if (offset == Memory::BuddyAllocator::invalid_offset)
+                continue;
+
+            uint64_t block = buddy.allocation_size(offset);
+            aligned &= offset % alignment == 0 && block >= request && offset + block <= size;
+
+            auto after = live.lower_bound(offset);
+            if (after != live.end())
+                disjoint &= offset + block <= after->first;
+            if (after != live.begin())
+                disjoint &= std::prev(after)->first + std::prev(after)->second <= offset;
+            live[offset] = block;
+        }
+        else
+        {
+            auto victim = live.begin();
+            std::advance(victim, next() % live.size());
+            buddy.free(victim->first);
+            live.erase(victim);
+        }
+    }
+    VGE_CHECK(aligned);
+    VGE_CHECK(disjoint);
+
+    uint64_t used = 0;
+    for (const auto& allocation : live)
+        used += allocation.second;
+    VGE_CHECK(buddy.get_used_bytes() == used);
+
+    for (const auto& allocation : live)
+        buddy.free(allocation.first);
+    VGE_CHECK(buddy.empty());
+    VGE_CHECK(buddy.largest_free_block() == size);
+}
@@ -0,0 +1,185 @@
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-16
+ */
+
+#include <vector>
+#include <cmath>
+#include <stdexcept>
+#include <cstdint>
+
+#include "test.hpp"
+#include "../src/core/mesh/meshlets.hpp"
+
+using namespace VulkanGameEngine;
+
+/**
+ * Unit sphere of rings x segments quads, counter-clockwise seen from outside.
+ */
+static Mesh::MeshData sphere(uint32_t rings, uint32_t segments)
+{
+    Mesh::MeshData mesh;
+    for (uint32_t i = 0; i <= rings; i++)
+    {
+        float theta = 3.14159265f * i / rings;
+        for (uint32_t j = 0; j <= segments; j++)
+        {
+            float phi = 6.28318531f * j / segments;
+            float p[3] = {std::sin(theta) * std::cos(phi), std::sin(theta) * std::sin(phi), std::cos(theta)};
+            mesh.vertices.push_back({{p[0], p[1], p[2]}, {p[0], p[1], p[2]}, {0.0f, 0.0f}});
+        }
+    }
+
+    for (uint32_t i = 0; i < rings; i++)
+    {
+        for (uint32_t j = 0; j < segments; j++)
+        {
+            uint32_t v = i * (segments + 1) + j;
+            uint32_t below = v + segments + 1;
+            mesh.indices.insert(mesh.indices.end(), {v, below, v + 1, v + 1, below, below + 1});
+        }
+    }
+    return mesh;
+}
+
+static void face_normal(const Mesh::MeshData& mesh, const uint32_t* triangle, float* normal, const float*& p0)
+{
+    p0 = mesh.vertices[triangle[0]].position;
+    const float* p1 = mesh.vertices[triangle[1]].position;
+    const float* p2 = mesh.vertices[triangle[2]].position;
+    float e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+    float e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+    normal[0] = e1[1] * e2[2] - e1[2] * e2[1];
+    normal[1] = e1[2] * e2[0] - e1[0] * e2[2];
+    normal[2] = e1[0] * e2[1] - e1[1] * e2[0];
+}
+
+VGE_TEST(meshlets_respect_limits_and_keep_triangle_order)
+{
+    Mesh::MeshData mesh = sphere(32, 48);
+
+    for (uint32_t max_vertices : {3u, 64u, 256u})
+    {
+        for (uint32_t max_triangles : {1u, 124u, 512u})
+        {
+            Mesh::MeshletData data = Mesh::build_meshlets(mesh.indices, mesh.vertices, max_vertices, max_triangles);
+
+            bool within_limits = true;
+            std::vector<uint32_t> rebuilt;
+            for (const Mesh::Meshlet& meshlet : data.meshlets)
+            {
+                within_limits &= meshlet.vertex_count <= max_vertices && meshlet.triangle_count <= max_triangles;
+                within_limits &= meshlet.triangle_count > 0;
+                for (uint32_t i = 0; i < meshlet.triangle_count * 3; i++)
+                {
+                    uint8_t local = data.triangles[meshlet.triangle_offset + i];
+                    within_limits &= local < meshlet.vertex_count;
+                    rebuilt.push_back(data.vertices[meshlet.vertex_offset + local]);
+                }
+            }
+
+            VGE_CHECK(within_limits);
+            VGE_CHECK(rebuilt == mesh.indices);
+        }
+    }
+
+    bool thrown = false;
+    try { Mesh::build_meshlets(mesh.indices, mesh.vertices, 257, 124); }
+    catch (const std::runtime_error&) { thrown = true; }
+    VGE_CHECK(thrown);
+}
+
+VGE_TEST(meshlets_bounds_contain_their_vertices)
+{
+    Mesh::MeshData mesh = sphere(24, 32);
+    Mesh::MeshletData data = Mesh::build_meshlets(mesh.indices, mesh.vertices);
+
+    bool contained = true;
+    for (const Mesh::Meshlet& meshlet : data.meshlets)
+    {
+        for (uint32_t i = 0; i < meshlet.vertex_count; i++)
+        {
+            const float* p = mesh.vertices[data.vertices[meshlet.vertex_offset + i]].position;
+            float dx = p[0] - meshlet.center[0];
+            float dy = p[1] - meshlet.center[1];
+            float dz = p[2] - meshlet.center[2];
+            contained &= std::sqrt(dx * dx + dy * dy + dz * dz) <= meshlet.radius * 1.0001f;
+        }
+    }
+    VGE_CHECK(contained);
+}
+
+VGE_TEST(meshlets_cones_are_conservative)
+{
+    Mesh::MeshData mesh = sphere(24, 32);
+    Mesh::MeshletData data = Mesh::build_meshlets(mesh.indices, mesh.vertices, 64, 32);
+
+    uint32_t state = 9;
+    auto next = [&state]() {
+        state = state * 1664525u + 1013904223u;
+        return (state >> 8) / 16777216.0f * 2.0f - 1.0f;
+    };
+
+    uint32_t culled = 0;
+    bool conservative = true;
+    for (uint32_t c = 0; c < 200; c++)
+    {
+        // Cameras from just outside the sphere to far away.
+        float camera[3] = {next() * 6.0f, next() * 6.0f, next() * 6.0f};
+        if (camera[0] * camera[0] + camera[1] * camera[1] + camera[2] * camera[2] < 1.2f)
+            continue;
+
+        for (const Mesh::Meshlet& meshlet : data.meshlets)
+        {
+            float view[3] = {meshlet.cone_apex[0] - camera[0], meshlet.cone_apex[1] - camera[1], meshlet.cone_apex[2] - camera[2]};
+            float length = std::sqrt(view[0] * view[0] + view[1] * view[1] + view[2] * view[2]);
+            float dot = (view[0] * meshlet.cone_axis[0] + view[1] * meshlet.cone_axis[1] + view[2] * meshlet.cone_axis[2]) / length;
+            if (dot < meshlet.cone_cutoff)
+                continue;
+
+            // Culled: no triangle of the meshlet may face the camera.
+            culled++;
+            for (uint32_t t = 0; t < meshlet.triangle_count; t++)
+            {
+                uint32_t triangle[3];
+                for (uint32_t k = 0; k < 3; k++)
+                    triangle[k] = data.vertices[meshlet.vertex_offset + data.triangles[meshlet.triangle_offset + t * 3 + k]];
+
+                float normal[3];
+                const float* p0;
+                face_normal(mesh, triangle, normal, p0);
+                float facing = normal[0] * (camera[0] - p0[0]) + normal[1] * (camera[1] - p0[1]) + normal[2] * (camera[2] - p0[2]);
+                conservative &= facing <= 1e-5f;
+            }
+        }
+    }
+
+    VGE_CHECK(conservative);
+    // Roughly half of a sphere's meshlets face away from any outside camera.
+    VGE_CHECK(culled > 200 * data.meshlets.size() / 8);
+}
+
+VGE_TEST(meshlets_flat_patches_have_tight_cones)
+{
+    Mesh::MeshData mesh;
+    for (uint32_t y = 0; y <= 4; y++)
+        for (uint32_t x = 0; x <= 4; x++)
+            mesh.vertices.push_back({{static_cast<float>(x), static_cast<float>(y), 0.0f}, {0.0f, 0.0f, 1.0f}, {0.0f, 0.0f}});
+    for (uint32_t y = 0; y < 4; y++)
+    {
+        for (uint32_t x = 0; x < 4; x++)
+        {
+            uint32_t v = y * 5 + x;
+            mesh.indices.insert(mesh.indices.end(), {v, v + 1, v + 6, v, v + 6, v + 5});
+        }
+    }
+
+    Mesh::MeshletData data = Mesh::build_meshlets(mesh.indices, mesh.vertices);
+    VGE_CHECK(data.meshlets.size() == 1);
+
+    const Mesh::Meshlet& meshlet = data.meshlets[0];
+    VGE_CHECK(Tests::near(meshlet.cone_axis[2], 1.0f, 1e-5f));
+    VGE_CHECK(meshlet.cone_cutoff < 1e-3f);
+    VGE_CHECK(Tests::near(meshlet.center[0], 2.0f, 1e-5f) && Tests::near(meshlet.center[1], 2.0f, 1e-5f));
+    VGE_CHECK(Tests::near(meshlet.radius, std::sqrt(8.0f), 1e-5f));
+}
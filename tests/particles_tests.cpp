@@ -0,0 +1,142 @@
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-16
+ */
+
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <cstdint>
+
+#include "test.hpp"
+#include "../src/core/graphics/particles.hpp"
+#include "../src/core/jobs/job_system.hpp"
+
+using namespace VulkanGameEngine;
+
+VGE_TEST(particles_seed_within_settings)
+{
+    Graphics::ParticleSettings settings;
+    settings.count = 4096;
+    Graphics::ParticleConstants constants = Graphics::make_particle_constants(settings, Graphics::ParticleMode::Seed);
+
+    std::vector<Graphics::Particle> particles(settings.count);
+    Graphics::simulate_particles(constants, nullptr, particles.data(), 0, settings.count);
+
+    bool in_range = true;
+    bool distinct = false;
+    for (const Graphics::Particle& particle : particles)
+    {
+        in_range &= particle.position[0] == 0.0f && particle.position[1] == settings.emitter_height && particle.position[2] == 0.0f;
+        in_range &= std::fabs(particle.velocity[0]) <= settings.spread && std::fabs(particle.velocity[2]) <= settings.spread;
+        in_range &= particle.velocity[1] >= settings.min_speed && particle.velocity[1] <= settings.max_speed;
+        // The first generation is staggered over a whole life.
+        in_range &= particle.life >= 0.0f && particle.life < settings.max_life;
+        in_range &= particle.generation == 0;
+        distinct |= particle.velocity[0] != particles[0].velocity[0];
+    }
+    VGE_CHECK(in_range);
+    VGE_CHECK(distinct);
+
+    // Another seed, another emitter.
+    settings.seed = 2;
+    Graphics::Particle other = Graphics::spawn_particle(Graphics::make_particle_constants(settings, Graphics::ParticleMode::Seed), 0, 0);
+    VGE_CHECK(other.velocity[0] != particles[0].velocity[0]);
+}
+
+VGE_TEST(particles_step_integrates_and_bounces)
+{
+    Graphics::ParticleSettings settings;
+    settings.time_step = 0.5f;
+    settings.gravity = 2.0f;
+    settings.drag = 0.5f;
+    settings.restitution = 0.5f;
+    Graphics::ParticleConstants constants = Graphics::make_particle_constants(settings, Graphics::ParticleMode::Step);
+    VGE_CHECK(constants.gravity_step == 1.0f);
+    VGE_CHECK(constants.drag_factor == 0.75f);
+
+    // Exactly representable values, so the expected results are exact.
+    Graphics::Particle flying = {{1.0f, 4.0f, -2.0f}, 3.0f, {2.0f, 5.0f, -4.0f}, 7};
+    Graphics::Particle falling = {{0.0f, 0.25f, 0.0f}, 3.0f, {0.0f, -1.0f, 0.0f}, 7};
+    Graphics::Particle source[2] = {flying, falling};
+    Graphics::Particle destination[2];
+    Graphics::simulate_particles(constants, source, destination, 0, 2);
+
+    // v = (v - g dt) * drag, p += v dt.
+    const Graphics::Particle& a = destination[0];
+    VGE_CHECK(a.life == 2.5f && a.generation == 7);
+    VGE_CHECK(a.velocity[0] == 1.5f && a.velocity[1] == 3.0f && a.velocity[2] == -3.0f);
+    VGE_CHECK(a.position[0] == 1.75f && a.position[1] == 5.5f && a.position[2] == -3.5f);
+
+    // Falls to -0.5, reflected to 0.5 with half its vertical speed, upwards.
+    const Graphics::Particle& b = destination[1];
+    VGE_CHECK(b.position[1] == 0.5f);
+    VGE_CHECK(b.velocity[1] == 0.75f);
+}
+
+VGE_TEST(particles_respawn_as_next_generation)
+{
+    Graphics::ParticleSettings settings;
+    Graphics::ParticleConstants constants = Graphics::make_particle_constants(settings, Graphics::ParticleMode::Step);
+
+    Graphics::Particle dying = {{3.0f, 1.0f, 3.0f}, settings.time_step * 0.5f, {1.0f, 1.0f, 1.0f}, 4};
+    Graphics::Particle source[6] = {};
+    source[5] = dying;
+    Graphics::Particle destination[6];
+    Graphics::simulate_particles(constants, source, destination, 5, 6);
+
+    Graphics::Particle expected = Graphics::spawn_particle(constants, 5, 5);
+    VGE_CHECK(std::memcmp(&destination[5], &expected, sizeof(expected)) == 0);
+    VGE_CHECK(destination[5].generation == 5);
+    // Later generations live a full life.
+    VGE_CHECK(destination[5].life >= settings.min_life && destination[5].life <= settings.max_life);
+}
+
+VGE_TEST(particles_reference_does_not_depend_on_the_split)
+{
+    Graphics::ParticleSettings settings;
+    settings.count = 20000;
+
+    std::vector<Graphics::Particle> serial = Graphics::run_particle_reference(settings, 400);
+
+    Jobs::JobSystem jobs;
+    jobs.init(4);
+    std::vector<Graphics::Particle> parallel = Graphics::run_particle_reference(settings, 400, &jobs);
+    jobs.cleanup();
+
+    VGE_CHECK(std::memcmp(serial.data(), parallel.data(), serial.size() * sizeof(Graphics::Particle)) == 0);
+
+    // 400 steps is past the longest life: everything respawned at least once and stays above the floor.
+    bool respawned = true;
+    bool above_floor = true;
+    for (const Graphics::Particle& particle : serial)
+    {
+        respawned &= particle.generation > 0;
+        above_floor &= particle.position[1] >= settings.floor_height;
+    }
+    VGE_CHECK(respawned);
+    VGE_CHECK(above_floor);
+
+    Graphics::ParticleComparison comparison = Graphics::compare_particles(serial, parallel, 0.0f);
+    VGE_CHECK(comparison.passed() && comparison.count == settings.count);
+}
+
+VGE_TEST(particles_comparison_reports_mismatches)
+{
+    Graphics::ParticleSettings settings;
+    settings.count = 64;
+    std::vector<Graphics::Particle> expected = Graphics::run_particle_reference(settings, 10);
+    std::vector<Graphics::Particle> actual = expected;
+
+    actual[3].position[0] += 1.0f;
+    actual[10].generation++;
+    actual[20].velocity[1] = std::numeric_limits<float>::quiet_NaN();
+    // Within tolerance.
+    actual[30].life *= 1.00001f;
+
+    Graphics::ParticleComparison comparison = Graphics::compare_particles(expected, actual);
+    VGE_CHECK(comparison.mismatches == 3);
+    VGE_CHECK(!comparison.passed());
+    VGE_CHECK(comparison.max_position_error >= 0.5f);
+}
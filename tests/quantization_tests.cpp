@@ -0,0 +1,67 @@
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-16
+ */
+
+#include <cstdint>
+#include <cmath>
+#include <limits>
+
+#include "test.hpp"
+#include "../src/core/mesh/quantization.hpp"
+
+using namespace VulkanGameEngine;
+
+VGE_TEST(quantization_half_round_trip)
+{
+    // Exactly representable values come back unchanged.
+    const float exact[] = {0.0f, 1.0f, -2.0f, 0.5f, 65504.0f, -0.000061035156f, 1.0f / 1024.0f};
+    for (float value : exact)
+        VGE_CHECK(Mesh::half_to_float(Mesh::float_to_half(value)) == value);
+
+    // Everything else within half precision.
+    for (float value = -1000.0f; value < 1000.0f; value += 0.37f)
+        VGE_CHECK(Tests::near(Mesh::half_to_float(Mesh::float_to_half(value)), value, 1.0f / 1024.0f));
+
+    // Every half survives a trip through float.
+    bool all_halves = true;
+    for (uint32_t bits = 0; bits < 0x10000; bits++)
+    {
+        uint16_t half = static_cast<uint16_t>(bits);
+        bool nan = (half & 0x7c00) == 0x7c00 && (half & 0x03ff);
+        if (nan)
+            all_halves &= std::isnan(Mesh::half_to_float(half));
+        else
+            all_halves &= Mesh::float_to_half(Mesh::half_to_float(half)) == half;
+    }
+    VGE_CHECK(all_halves);
+
+    VGE_CHECK(std::isinf(Mesh::half_to_float(Mesh::float_to_half(1e10f))));
+    VGE_CHECK(std::isnan(Mesh::half_to_float(Mesh::float_to_half(std::numeric_limits<float>::quiet_NaN()))));
+}
+
+VGE_TEST(quantization_octahedral_round_trip)
+{
+    float worst = 1.0f;
+    for (int i = 0; i < 64; i++)
+    {
+        for (int j = 0; j <= 32; j++)
+        {
+            // Covers both hemispheres and the poles.
+            float phi = i * 6.2831853f / 64.0f;
+            float theta = j * 3.1415927f / 32.0f;
+            float normal[3] = {std::sin(theta) * std::cos(phi), std::sin(theta) * std::sin(phi), std::cos(theta)};
+
+            int16_t encoded[2];
+            float decoded[3];
+            Mesh::encode_octahedral(normal, encoded);
+            Mesh::decode_octahedral(encoded, decoded);
+
+            float length = std::sqrt(decoded[0] * decoded[0] + decoded[1] * decoded[1] + decoded[2] * decoded[2]);
+            VGE_CHECK(Tests::near(length, 1.0f, 1e-5f));
+            worst = std::min(worst, normal[0] * decoded[0] + normal[1] * decoded[1] + normal[2] * decoded[2]);
+        }
+    }
+    // snorm16 octahedral keeps normals within a few thousandths of a degree.
+    VGE_CHECK(worst > 0.99999f);
+}
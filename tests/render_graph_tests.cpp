@@ -0,0 +1,170 @@
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-16
+ */
+
+#include <vector>
+#include <stdexcept>
+#include <cstdint>
+
+#include "test.hpp"
+#include "../src/core/graphics/render_graph.hpp"
+
+using namespace VulkanGameEngine;
+
+// Only imported resources survive culling here: transient images need a device.
+VGE_TEST(render_graph_culls_unconsumed_passes)
+{
+    Graphics::RenderGraph graph;
+    Graphics::RenderResource backbuffer = graph.import_image("backbuffer", VK_IMAGE_ASPECT_COLOR_BIT,
+        {VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0},
+        {VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0});
+    Graphics::RenderResource counters = graph.import_buffer("counters");
+    Graphics::RenderResource overlay = graph.create_image("overlay", {{64, 64}, VK_FORMAT_R8G8B8A8_UNORM});
+    Graphics::RenderResource blurred = graph.create_image("blurred", {{64, 64}, VK_FORMAT_R8G8B8A8_UNORM});
+
+    graph.add_pass("overlay", nullptr).write(overlay, Graphics::ResourceUsage::ColorAttachment);
+    graph.add_pass("blur", nullptr)
+        .read(overlay, Graphics::ResourceUsage::SampledFragment)
+        .write(blurred, Graphics::ResourceUsage::ColorAttachment);
+    graph.add_pass("main", nullptr).write(backbuffer, Graphics::ResourceUsage::ColorAttachment);
+    graph.add_pass("readback", nullptr).read(counters, Graphics::ResourceUsage::UniformBuffer).side_effect();
+    graph.compile();
+
+    // Nothing reads blurred, so neither blur nor the overlay it alone consumed survive.
+    VGE_CHECK(graph.is_culled("overlay"));
+    VGE_CHECK(graph.is_culled("blur"));
+    VGE_CHECK(!graph.is_culled("main"));
+    VGE_CHECK(!graph.is_culled("readback"));
+    VGE_CHECK(graph.get_statistics().passes == 4);
+    VGE_CHECK(graph.get_statistics().culled_passes == 2);
+    VGE_CHECK(graph.get_statistics().transient_images == 0);
+}
+
+VGE_TEST(render_graph_batches_barriers_per_pass)
+{
+    Graphics::RenderGraph graph;
+    Graphics::RenderResource backbuffer = graph.import_image("backbuffer", VK_IMAGE_ASPECT_COLOR_BIT,
+        {VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0},
+        {VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0});
+    Graphics::RenderResource gbuffer = graph.import_image("gbuffer", VK_IMAGE_ASPECT_COLOR_BIT, {});
+
+    // UNDEFINED -> COLOR_ATTACHMENT: one barrier.
+    graph.add_pass("gbuffer", nullptr).write(gbuffer, Graphics::ResourceUsage::ColorAttachment);
+    // gbuffer to SHADER_READ and backbuffer to COLOR_ATTACHMENT, in one batch.
+    graph.add_pass("lighting", nullptr)
+        .read(gbuffer, Graphics::ResourceUsage::SampledFragment)
+        .write(backbuffer, Graphics::ResourceUsage::ColorAttachment);
+    // Read after read in the same layout: nothing to wait for.
+    graph.add_pass("preview", nullptr).read(gbuffer, Graphics::ResourceUsage::SampledFragment).side_effect();
+    // Blending over the lighting output: one write-after-write barrier.
+    graph.add_pass("post", nullptr)
+        .read(gbuffer, Graphics::ResourceUsage::SampledFragment)
+        .read_write(backbuffer, Graphics::ResourceUsage::ColorAttachment);
+    graph.compile();
+
+    // Plus the final transition of the backbuffer to PRESENT_SRC.
+    const Graphics::RenderGraph::Statistics& statistics = graph.get_statistics();
+    VGE_CHECK(statistics.culled_passes == 0);
+    VGE_CHECK(statistics.barrier_batches == 4);
+    VGE_CHECK(statistics.image_barriers == 5);
+    VGE_CHECK(statistics.buffer_barriers == 0);
+}
+
+VGE_TEST(render_graph_makes_writes_visible_once_per_stage)
+{
+    Graphics::RenderGraph graph;
+    Graphics::RenderResource commands = graph.import_buffer("commands");
+
+    graph.add_pass("cull", nullptr).write(commands, Graphics::ResourceUsage::StorageCompute);
+    graph.add_pass("draw", nullptr).read(commands, Graphics::ResourceUsage::IndirectBuffer).side_effect();
+    graph.add_pass("draw_again", nullptr).read(commands, Graphics::ResourceUsage::IndirectBuffer).side_effect();
+    graph.add_pass("debug", nullptr).read(commands, Graphics::ResourceUsage::VertexBuffer).side_effect();
+    graph.compile();
+
+    // The first write has nothing to wait on; each new reading stage needs the write made visible once.
+    VGE_CHECK(graph.get_statistics().barrier_batches == 2);
+    VGE_CHECK(graph.get_statistics().buffer_barriers == 2);
+}
+
+VGE_TEST(render_graph_rejects_invalid_usages)
+{
+    Graphics::RenderGraph graph;
+    Graphics::RenderResource image = graph.import_image("image", VK_IMAGE_ASPECT_COLOR_BIT, {});
+    Graphics::RenderResource buffer = graph.import_buffer("buffer");
+
+    bool thrown = false;
+    try { graph.add_pass("sample_write", nullptr).write(image, Graphics::ResourceUsage::SampledFragment); }
+    catch (const std::runtime_error&) { thrown = true; }
+    VGE_CHECK(thrown);
+
+    thrown = false;
+    try { graph.add_pass("buffer_as_image", nullptr).read(buffer, Graphics::ResourceUsage::SampledFragment); }
+    catch (const std::runtime_error&) { thrown = true; }
+    VGE_CHECK(thrown);
+
+    graph.reset();
+    image = graph.import_image("image", VK_IMAGE_ASPECT_COLOR_BIT, {});
+    graph.add_pass("two_layouts", nullptr)
+        .read(image, Graphics::ResourceUsage::SampledFragment)
+        .write(image, Graphics::ResourceUsage::ColorAttachment);
+
+    thrown = false;
+    try { graph.compile(); }
+    catch (const std::runtime_error&) { thrown = true; }
+    VGE_CHECK(thrown);
+}
+
+static VkMemoryRequirements requirements(VkDeviceSize size, uint32_t memory_type_bits = 0xF)
+{
+    VkMemoryRequirements result{};
+    result.size = size;
+    result.alignment = 256;
+    result.memoryTypeBits = memory_type_bits;
+    return result;
+}
+
+VGE_TEST(render_graph_aliases_disjoint_lifetimes)
+{
+    const VkDeviceSize mib = 1024 * 1024;
+    std::vector<Graphics::TransientLifetime> lifetimes = {
+        {0, 1, requirements(8 * mib)},  // depth pre-pass target
+        {2, 3, requirements(8 * mib)},  // bloom, after it
+        {1, 2, requirements(2 * mib)},  // overlaps both
+        {3, 4, requirements(4 * mib)},  // fits after the small one
+    };
+
+    std::vector<Graphics::AliasedMemory> memories = Graphics::alias_transient_memory(lifetimes);
+    VGE_CHECK(memories.size() == 2);
+
+    VkDeviceSize total = 0;
+    std::vector<uint32_t> owner(lifetimes.size(), UINT32_MAX);
+    for (uint32_t m = 0; m < memories.size(); m++)
+    {
+        total += memories[m].size;
+        for (uint32_t image : memories[m].images)
+        {
+            owner[image] = m;
+            VGE_CHECK(lifetimes[image].requirements.size <= memories[m].size);
+        }
+    }
+
+    VGE_CHECK(owner[0] == owner[1]);
+    VGE_CHECK(owner[2] != owner[0]);
+    VGE_CHECK(owner[3] == owner[2]);
+    VGE_CHECK(total == 12 * mib);
+}
+
+VGE_TEST(render_graph_never_aliases_incompatible_memory)
+{
+    std::vector<Graphics::TransientLifetime> lifetimes = {
+        {0, 0, requirements(1024, 0x1)},
+        {1, 1, requirements(1024, 0x2)},
+        {2, 2, requirements(1024, 0x3)},
+    };
+
+    std::vector<Graphics::AliasedMemory> memories = Graphics::alias_transient_memory(lifetimes);
+    VGE_CHECK(memories.size() == 2);
+    for (const Graphics::AliasedMemory& memory : memories)
+        VGE_CHECK(memory.memory_type_bits != 0);
+}
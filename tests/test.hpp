@@ -0,0 +1,47 @@
+#pragma once
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-16
+ *
+ * Minimal test harness: VGE_TEST registers a function, VGE_CHECK records a
+ * failure without stopping the test. vge_tests [prefix] runs the tests whose
+ * name starts with prefix; CTest registers one prefix per module.
+ */
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+namespace VulkanGameEngine
+{
+    namespace Tests
+    {
+        struct TestCase
+        {
+            const char* name;
+            void (*function)();
+        };
+
+        std::vector<TestCase>& test_registry();
+
+        void report_failure(const char* file, int line, const char* expression);
+
+        struct TestRegistration
+        {
+            TestRegistration(const char* name, void (*function)()) { test_registry().push_back({name, function}); }
+        };
+
+        inline bool near(float a, float b, float tolerance)
+        {
+            return std::fabs(a - b) <= tolerance * std::max(1.0f, std::max(std::fabs(a), std::fabs(b)));
+        }
+    };
+};
+
+#define VGE_TEST(name) \
+    static void test_##name(); \
+    static VulkanGameEngine::Tests::TestRegistration registration_##name(#name, test_##name); \
+    static void test_##name()
+
+#define VGE_CHECK(condition) \
+    do { if (!(condition)) VulkanGameEngine::Tests::report_failure(__FILE__, __LINE__, #condition); } while (0)
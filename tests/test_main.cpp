@@ -0,0 +1,70 @@
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-16
+ *
+ * Usage: vge_tests [prefix]
+ */
+
+#include <iostream>
+#include <string>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+
+#include "test.hpp"
+
+namespace VulkanGameEngine
+{
+    namespace Tests
+    {
+        static uint32_t failures = 0;
+
+        std::vector<TestCase>& test_registry()
+        {
+            static std::vector<TestCase> registry;
+            return registry;
+        }
+
+        void report_failure(const char* file, int line, const char* expression)
+        {
+            printf("  %s:%d: check failed: %s\n", file, line, expression);
+            failures++;
+        }
+    };
+};
+
+using namespace VulkanGameEngine;
+
+int main(int argc, char** argv)
+{
+    const char* prefix = argc > 1 ? argv[1] : "";
+
+    std::vector<Tests::TestCase> tests = Tests::test_registry();
+    std::sort(tests.begin(), tests.end(), [](const Tests::TestCase& a, const Tests::TestCase& b) { return strcmp(a.name, b.name) < 0; });
+
+    uint32_t run = 0;
+    uint32_t failed = 0;
+    for (const Tests::TestCase& test : tests)
+    {
+        if (strncmp(test.name, prefix, strlen(prefix)) != 0)
+            continue;
+
+        uint32_t failures_before = Tests::failures;
+        test.function();
+        bool passed = Tests::failures == failures_before;
+
+        printf("%-48s %s\n", test.name, passed ? "passed" : "FAILED");
+        run++;
+        failed += passed ? 0 : 1;
+    }
+
+    if (run == 0)
+    {
+        printf("No test matches '%s'.\n", prefix);
+        return 1;
+    }
+
+    printf("\n%u of %u tests passed\n", run - failed, run);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,271 @@
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-16
+ */
+
+#include <vector>
+#include <cstdint>
+
+#include "test.hpp"
+#include "../src/core/graphics/texture_residency.hpp"
+
+using namespace VulkanGameEngine;
+
+// 64 + 16 + 4 bytes; the 4 byte level is the tail.
+static const std::vector<VkDeviceSize> small_mips = {64, 16, 4};
+
+/**
+ * Applies the changes of an update to a copy of the resident mips, as
+ * TextureStreamer would, and checks they agree with the policy.
+ */
+struct Mirror
+{
+    std::vector<uint32_t> resident;
+    bool consistent = true;
+
+    void apply(const Graphics::TextureResidency& residency, const std::vector<Graphics::TextureResidency::Change>& changes)
+    {
+        for (const auto& change : changes)
+        {
+            consistent &= resident[change.texture] == change.previous_mip;
+            consistent &= change.previous_mip != change.resident_mip;
+            resident[change.texture] = change.resident_mip;
+        }
+        for (uint32_t i = 0; i < resident.size(); i++)
+            consistent &= resident[i] == residency.get_resident_mip(i);
+    }
+};
+
+static void step(Graphics::TextureResidency& residency, Mirror& mirror, uint64_t frame)
+{
+    std::vector<Graphics::TextureResidency::Change> changes;
+    residency.update(frame, changes);
+    mirror.apply(residency, changes);
+}
+
+VGE_TEST(texture_residency_streams_one_level_per_update)
+{
+    Graphics::TextureResidency residency;
+    residency.init({});
+
+    Graphics::StreamedTexture texture = residency.add({256, 64, 16, 4, 1}, 3);
+    VGE_CHECK(residency.get_resident_mip(texture) == 3);
+    VGE_CHECK(residency.get_resident_bytes() == 5);
+
+    Mirror mirror{{3}};
+    for (uint64_t frame = 0; frame < 3; frame++)
+    {
+        residency.request(texture, 0, frame);
+        step(residency, mirror, frame);
+        VGE_CHECK(residency.get_resident_mip(texture) == 2 - frame);
+    }
+    VGE_CHECK(mirror.consistent);
+    VGE_CHECK(residency.get_resident_bytes() == 341);
+    VGE_CHECK(residency.get_statistics().loads == 3);
+
+    // Demand is remembered: without requests nothing is evicted while under budget.
+    step(residency, mirror, 10);
+    VGE_CHECK(residency.get_resident_mip(texture) == 0);
+}
+
+VGE_TEST(texture_residency_evicts_least_recently_requested)
+{
+    Graphics::TextureResidency::Settings settings;
+    settings.budget = 2 * 84 + 4;
+    Graphics::TextureResidency residency;
+    residency.init(settings);
+
+    Graphics::StreamedTexture old_texture = residency.add(small_mips, 2);
+    Graphics::StreamedTexture recent = residency.add(small_mips, 2);
+    Graphics::StreamedTexture incoming = residency.add(small_mips, 2);
+    Mirror mirror{{2, 2, 2}};
+
+    uint64_t frame = 0;
+    for (; frame < 10; frame++)
+    {
+        residency.request(old_texture, 0, frame);
+        residency.request(recent, 0, frame);
+        step(residency, mirror, frame);
+    }
+    for (; frame < 20; frame++)
+    {
+        residency.request(recent, 0, frame);
+        step(residency, mirror, frame);
+    }
+    VGE_CHECK(residency.get_resident_mip(old_texture) == 0);
+    VGE_CHECK(residency.get_resident_mip(recent) == 0);
+    VGE_CHECK(residency.get_resident_bytes() == settings.budget);
+
+    for (; frame < 30; frame++)
+    {
+        residency.request(incoming, 0, frame);
+        step(residency, mirror, frame);
+        VGE_CHECK(residency.get_resident_bytes() <= settings.budget);
+    }
+
+    VGE_CHECK(residency.get_resident_mip(incoming) == 0);
+    VGE_CHECK(residency.get_resident_mip(recent) == 0);
+    VGE_CHECK(residency.get_resident_mip(old_texture) == 2);
+    VGE_CHECK(residency.get_statistics().evictions == 2);
+    VGE_CHECK(mirror.consistent);
+}
+
+VGE_TEST(texture_residency_never_thrashes_recent_requests)
+{
+    Graphics::TextureResidency::Settings settings;
+    settings.budget = 84 + 4;
+    Graphics::TextureResidency residency;
+    residency.init(settings);
+
+    Graphics::StreamedTexture a = residency.add(small_mips, 2);
+    Graphics::StreamedTexture b = residency.add(small_mips, 2);
+    Mirror mirror{{2, 2}};
+
+    // Both in view every frame: whichever loads first keeps its levels.
+    for (uint64_t frame = 0; frame < 50; frame++)
+    {
+        residency.request(a, 0, frame);
+        residency.request(b, 0, frame);
+        step(residency, mirror, frame);
+        VGE_CHECK(residency.get_resident_bytes() <= settings.budget);
+    }
+
+    VGE_CHECK(residency.get_statistics().evictions == 0);
+    VGE_CHECK(residency.get_statistics().budget_misses > 0);
+    VGE_CHECK(residency.get_resident_mip(a) + residency.get_resident_mip(b) < 4);
+    VGE_CHECK(mirror.consistent);
+}
+
+VGE_TEST(texture_residency_drops_unwanted_levels_first)
+{
+    Graphics::TextureResidency::Settings settings;
+    settings.budget = 84 + 84 + 4;
+    Graphics::TextureResidency residency;
+    residency.init(settings);
+
+    Graphics::StreamedTexture far_away = residency.add(small_mips, 2);
+    Graphics::StreamedTexture idle = residency.add(small_mips, 2);
+    Mirror mirror{{2, 2}};
+
+    uint64_t frame = 0;
+    for (; frame < 5; frame++)
+    {
+        residency.request(far_away, 0, frame);
+        residency.request(idle, 0, frame);
+        step(residency, mirror, frame);
+    }
+
+    // far_away now only needs its tail but stays the most recently requested.
+    for (; frame < 10; frame++)
+    {
+        residency.request(far_away, 2, frame);
+        step(residency, mirror, frame);
+    }
+
+    Graphics::StreamedTexture incoming = residency.add(small_mips, 2);
+    mirror.resident.push_back(2);
+    residency.set_budget(settings.budget + 4);
+    for (; frame < 15; frame++)
+    {
+        residency.request(incoming, 0, frame);
+        residency.request(idle, 0, frame);
+        step(residency, mirror, frame);
+    }
+
+    // Its unwanted levels went before anything the others still asked for.
+    VGE_CHECK(residency.get_resident_mip(far_away) == 2);
+    VGE_CHECK(residency.get_resident_mip(idle) == 0);
+    VGE_CHECK(residency.get_resident_mip(incoming) == 0);
+    VGE_CHECK(mirror.consistent);
+}
+
+VGE_TEST(texture_residency_follows_budget_changes)
+{
+    Graphics::TextureResidency residency;
+    residency.init({});
+
+    std::vector<Graphics::StreamedTexture> textures;
+    Mirror mirror;
+    for (uint32_t i = 0; i < 8; i++)
+    {
+        textures.push_back(residency.add(small_mips, 2));
+        mirror.resident.push_back(2);
+    }
+
+    uint64_t frame = 0;
+    for (; frame < 3; frame++)
+    {
+        for (Graphics::StreamedTexture texture : textures)
+            residency.request(texture, 0, frame);
+        step(residency, mirror, frame);
+    }
+    VGE_CHECK(residency.get_resident_bytes() == 8 * 84);
+
+    // Nothing requested lately: the shrink is honoured on the next update.
+    residency.set_budget(4 * 84 + 4 * 4);
+    frame += 10;
+    step(residency, mirror, frame);
+    VGE_CHECK(residency.get_resident_bytes() <= 4 * 84 + 4 * 4);
+    VGE_CHECK(residency.get_resident_mip(textures[0]) == 2);
+    VGE_CHECK(residency.get_resident_mip(textures[7]) == 0);
+
+    // Replaced images still count against loads until they are released.
+    residency.set_budget(8 * 84);
+    residency.charge_retiring(8 * 84);
+    residency.request(textures[0], 0, frame);
+    uint64_t loads = residency.get_statistics().loads;
+    step(residency, mirror, frame);
+    VGE_CHECK(residency.get_statistics().loads == loads);
+
+    residency.release_retiring(8 * 84);
+    residency.request(textures[0], 0, ++frame);
+    step(residency, mirror, frame);
+    VGE_CHECK(residency.get_statistics().loads == loads + 1);
+    VGE_CHECK(mirror.consistent);
+}
+
+VGE_TEST(texture_residency_random_pattern_stays_in_budget)
+{
+    Graphics::TextureResidency::Settings settings;
+    settings.budget = 32 * 1024;
+    settings.max_loads_per_update = 4;
+    Graphics::TextureResidency residency;
+    residency.init(settings);
+
+    const std::vector<VkDeviceSize> mips = {4096, 1024, 256, 64, 16};
+    Mirror mirror;
+    for (uint32_t i = 0; i < 64; i++)
+    {
+        residency.add(mips, 3);
+        mirror.resident.push_back(3);
+    }
+
+    uint32_t state = 11;
+    auto next = [&state]() {
+        state = state * 1664525u + 1013904223u;
+        return state >> 8;
+    };
+
+    bool in_budget = true;
+    for (uint64_t frame = 0; frame < 2000; frame++)
+    {
+        // A moving window of visible textures plus a few random ones.
+        uint32_t first = static_cast<uint32_t>(frame / 50) % 64;
+        for (uint32_t i = 0; i < 6; i++)
+            residency.request((first + i) % 64, next() % 3, frame);
+        residency.request(next() % 64, next() % 5, frame);
+
+        step(residency, mirror, frame);
+        in_budget &= residency.get_resident_bytes() <= settings.budget;
+    }
+
+    VkDeviceSize resident = 0;
+    for (uint32_t i = 0; i < 64; i++)
+        for (uint32_t mip = mirror.resident[i]; mip < mips.size(); mip++)
+            resident += mips[mip];
+
+    VGE_CHECK(in_budget);
+    VGE_CHECK(mirror.consistent);
+    VGE_CHECK(resident == residency.get_resident_bytes());
+    VGE_CHECK(residency.get_statistics().evictions > 0);
+}
@@ -0,0 +1,122 @@
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-16
+ */
+
+#include <cstdint>
+
+#include "test.hpp"
+#include "../src/core/scene/transform.hpp"
+#include "../src/core/jobs/job_system.hpp"
+
+using namespace VulkanGameEngine;
+
+namespace
+{
+    Scene::LocalTransform at(float x)
+    {
+        Scene::LocalTransform local;
+        local.position[0] = x;
+        return local;
+    }
+
+    float world_x(const Scene::TransformSystem& transforms, const Scene::World& world, Scene::Entity entity)
+    {
+        return transforms.get_world_matrix(world, entity)[12];
+    }
+};
+
+VGE_TEST(transform_propagates_to_children)
+{
+    Scene::World world;
+    Scene::TransformSystem transforms;
+    Scene::Entity root = transforms.create(world, at(10.0f));
+    Scene::Entity child = transforms.create(world, at(1.0f), root);
+    Scene::Entity grandchild = transforms.create(world, at(0.5f), child);
+
+    transforms.update(world);
+    VGE_CHECK(world_x(transforms, world, grandchild) == 11.5f);
+
+    transforms.set_local(world, root, at(20.0f));
+    transforms.update(world);
+    VGE_CHECK(world_x(transforms, world, child) == 21.0f);
+    VGE_CHECK(world_x(transforms, world, grandchild) == 21.5f);
+}
+
+VGE_TEST(transform_reparent_at_same_depth)
+{
+    // The entity stays on level 1, in the same chunk: only its TransformState
+    // says it moved, which must be enough to revisit the chunk.
+    Scene::World world;
+    Scene::TransformSystem transforms;
+    Scene::Entity a = transforms.create(world, at(10.0f));
+    Scene::Entity b = transforms.create(world, at(100.0f));
+    Scene::Entity child = transforms.create(world, at(1.0f), a);
+
+    transforms.update(world);
+    VGE_CHECK(world_x(transforms, world, child) == 11.0f);
+
+    transforms.set_parent(world, child, b);
+    transforms.update(world);
+    VGE_CHECK(world_x(transforms, world, child) == 101.0f);
+
+    // And back, after a pass with nothing to do.
+    transforms.update(world);
+    transforms.set_parent(world, child, a);
+    transforms.update(world);
+    VGE_CHECK(world_x(transforms, world, child) == 11.0f);
+}
+
+VGE_TEST(transform_static_chunks_are_skipped)
+{
+    Scene::World world;
+    Scene::TransformSystem transforms;
+    Scene::Entity root = transforms.create(world, at(1.0f));
+    for (int i = 0; i < 100; i++)
+        transforms.create(world, at(static_cast<float>(i)), root);
+
+    transforms.update(world);
+    uint64_t skipped = transforms.get_statistics().chunks_skipped;
+    uint64_t recomputed = transforms.get_statistics().entities_recomputed;
+
+    transforms.update(world);
+    VGE_CHECK(transforms.get_statistics().chunks_skipped > skipped);
+    VGE_CHECK(transforms.get_statistics().entities_recomputed == recomputed);
+}
+
+VGE_TEST(transform_parallel_matches_serial)
+{
+    Jobs::JobSystem jobs;
+    jobs.init(4);
+
+    Scene::World serial_world, parallel_world;
+    Scene::TransformSystem serial, parallel;
+    Scene::Entity serial_parents[64], parallel_parents[64];
+    Scene::Entity serial_leaves[4096], parallel_leaves[4096];
+    for (int i = 0; i < 64; i++)
+    {
+        serial_parents[i] = serial.create(serial_world, at(static_cast<float>(i)));
+        parallel_parents[i] = parallel.create(parallel_world, at(static_cast<float>(i)));
+    }
+    for (int i = 0; i < 4096; i++)
+    {
+        serial_leaves[i] = serial.create(serial_world, at(0.25f * i), serial_parents[i % 64]);
+        parallel_leaves[i] = parallel.create(parallel_world, at(0.25f * i), parallel_parents[i % 64]);
+    }
+
+    serial.update(serial_world);
+    parallel.update(parallel_world, &jobs);
+    for (int i = 0; i < 64; i += 3)
+    {
+        serial.set_local(serial_world, serial_parents[i], at(-1.0f * i));
+        parallel.set_local(parallel_world, parallel_parents[i], at(-1.0f * i));
+    }
+    serial.update(serial_world);
+    parallel.update(parallel_world, &jobs);
+    jobs.cleanup();
+
+    bool same = true;
+    for (int i = 0; i < 4096; i++)
+        same &= world_x(serial, serial_world, serial_leaves[i]) == world_x(parallel, parallel_world, parallel_leaves[i]);
+    VGE_CHECK(same);
+}
@@ -0,0 +1,91 @@
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-16
+ */
+
+#include <cstdint>
+
+#include "test.hpp"
+#include "../src/core/graphics/uploader.hpp"
+
+using namespace VulkanGameEngine;
+
+VGE_TEST(uploader_ring_aligns_allocations)
+{
+    Graphics::StagingRing ring;
+    ring.init(1024, 16);
+
+    VGE_CHECK(ring.allocate(10) == 0);
+    VGE_CHECK(ring.allocate(10) == 16);
+    VGE_CHECK(ring.allocate(32) == 32);
+    VGE_CHECK(ring.get_used() == 64);
+}
+
+VGE_TEST(uploader_ring_never_straddles_the_end)
+{
+    Graphics::StagingRing ring;
+    ring.init(256, 16);
+
+    VGE_CHECK(ring.allocate(100) == 0);
+    uint64_t first_end = ring.get_head();
+    VGE_CHECK(ring.allocate(100) == 112);
+    ring.release(first_end);
+
+    // 224 + 100 would run past the end: the allocation skips to offset 0.
+    VGE_CHECK(ring.fits(100));
+    VGE_CHECK(ring.allocate(100) == 0);
+    VGE_CHECK(ring.get_head() == 356);
+    VGE_CHECK(!ring.fits(1));
+}
+
+VGE_TEST(uploader_ring_empty_ring_starts_over)
+{
+    Graphics::StagingRing ring;
+    ring.init(256, 16);
+
+    ring.allocate(100);
+    ring.release_all();
+
+    // Mid-buffer but empty: the whole capacity is still available.
+    VGE_CHECK(ring.fits(256));
+    VGE_CHECK(ring.allocate(256) == 0);
+    VGE_CHECK(!ring.fits(1));
+}
+
+VGE_TEST(uploader_ring_reports_full)
+{
+    Graphics::StagingRing ring;
+    ring.init(256, 16);
+
+    VGE_CHECK(!ring.fits(257));
+    VGE_CHECK(ring.allocate(128) == 0);
+    VGE_CHECK(ring.allocate(128) == 128);
+    VGE_CHECK(!ring.fits(1));
+
+    // The skipped tail of the buffer counts as used until released.
+    ring.release_all();
+    VGE_CHECK(ring.allocate(200) == 0);
+    VGE_CHECK(!ring.fits(64));
+}
+
+VGE_TEST(uploader_ring_release_follows_batches)
+{
+    Graphics::StagingRing ring;
+    ring.init(1024, 16);
+
+    // Each batch records the head once its copies are staged; completing it
+    // frees exactly what it and the batches before it allocated.
+    ring.allocate(300);
+    uint64_t first_batch_end = ring.get_head();
+    ring.allocate(500);
+    uint64_t second_batch_end = ring.get_head();
+
+    VGE_CHECK(!ring.fits(300));
+    ring.release(first_batch_end);
+    VGE_CHECK(ring.get_used() == second_batch_end - first_batch_end);
+    VGE_CHECK(ring.fits(300));
+
+    ring.release(second_batch_end);
+    VGE_CHECK(ring.get_used() == 0);
+    VGE_CHECK(ring.fits(1024));
+}
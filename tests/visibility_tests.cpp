@@ -0,0 +1,164 @@
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-16
+ */
+
+#include <vector>
+#include <cmath>
+#include <cstdint>
+
+#include "test.hpp"
+#include "../src/core/graphics/visibility.hpp"
+#include "../src/core/jobs/job_system.hpp"
+#include "../src/core/math/matrix.hpp"
+
+using namespace VulkanGameEngine;
+
+static Graphics::Frustum test_frustum()
+{
+    Math::Mat4 view_projection = Math::perspective(1.2f, 16.0f / 9.0f, 0.1f, 200.0f) *
+        Math::look_at(Math::Vec3(3.0f, 2.0f, 10.0f), Math::Vec3(0.0f, 0.0f, 0.0f), Math::Vec3(0.0f, 1.0f, 0.0f));
+    return Graphics::extract_frustum(view_projection.data());
+}
+
+/**
+ * Random spheres around the frustum, a third of them touching one of its
+ * planes from outside: those only stay visible if every kernel computes the
+ * plane distance with the same rounding.
+ */
+struct Spheres
+{
+    std::vector<float> x, y, z, r;
+
+    Spheres(const Graphics::Frustum& frustum, uint32_t count)
+    {
+        uint32_t state = 17;
+        auto next = [&state]() {
+            state = state * 1664525u + 1013904223u;
+            return (state >> 8) / 16777216.0f;
+        };
+
+        for (uint32_t i = 0; i < count; i++)
+        {
+            float cx = (next() * 2.0f - 1.0f) * 120.0f;
+            float cy = (next() * 2.0f - 1.0f) * 60.0f;
+            float cz = (next() * 2.0f - 1.0f) * 120.0f;
+            float radius = next() * 8.0f;
+
+            if (i % 3 == 0)
+            {
+                const float* plane = frustum.planes[i / 3 % 6];
+                float distance = (plane[0] * cx + plane[1] * cy) + (plane[2] * cz + plane[3]);
+                if (distance < 0.0f)
+                    radius = -distance;
+            }
+
+            x.push_back(cx);
+            y.push_back(cy);
+            z.push_back(cz);
+            r.push_back(radius);
+        }
+
+        // Padding that is never visible, as VisibilitySystem keeps it.
+        while (x.size() % 8 != 0 || x.size() < count + 8)
+        {
+            x.push_back(0.0f);
+            y.push_back(0.0f);
+            z.push_back(0.0f);
+            r.push_back(-INFINITY);
+        }
+    }
+};
+
+typedef uint32_t (*CullFunction)(const float*, const float*, const float*, const float*, uint32_t, uint32_t, const Graphics::Frustum&, uint32_t*);
+
+static std::vector<uint32_t> run(CullFunction kernel, const Spheres& spheres, const Graphics::Frustum& frustum, uint32_t first, uint32_t last)
+{
+    std::vector<uint32_t> visible(last - first + 8);
+    uint32_t count = kernel(spheres.x.data(), spheres.y.data(), spheres.z.data(), spheres.r.data(), first, last, frustum, visible.data());
+    visible.resize(count);
+    return visible;
+}
+
+VGE_TEST(visibility_kernels_agree)
+{
+    Graphics::Frustum frustum = test_frustum();
+    Spheres spheres(frustum, 10001);
+    uint32_t padded = 10008;
+
+    bool avx2 = Graphics::VisibilitySystem::is_kernel_supported(Graphics::CullKernel::AVX2);
+
+    std::vector<uint32_t> reference;
+    for (uint32_t i = 0; i < padded; i++)
+    {
+        bool inside = true;
+        for (const auto& plane : frustum.planes)
+            inside &= (plane[0] * spheres.x[i] + plane[1] * spheres.y[i]) + (plane[2] * spheres.z[i] + plane[3]) >= -spheres.r[i];
+        if (inside)
+            reference.push_back(i);
+    }
+    // Not a trivial frustum: some in, most out.
+    VGE_CHECK(reference.size() > 100 && reference.size() < 9000);
+
+    const uint32_t ranges[][2] = {{0, padded}, {0, 8}, {8, 4096}, {4096, padded}, {16, 16}};
+    for (const auto& range : ranges)
+    {
+        std::vector<uint32_t> expected;
+        for (uint32_t slot : reference)
+            if (slot >= range[0] && slot < range[1])
+                expected.push_back(slot);
+
+        VGE_CHECK(run(Graphics::cull_spheres_scalar, spheres, frustum, range[0], range[1]) == expected);
+        VGE_CHECK(run(Graphics::cull_spheres_sse, spheres, frustum, range[0], range[1]) == expected);
+        if (avx2)
+            VGE_CHECK(run(Graphics::cull_spheres_avx2, spheres, frustum, range[0], range[1]) == expected);
+    }
+}
+
+VGE_TEST(visibility_system_kernels_agree)
+{
+    Graphics::Frustum frustum = test_frustum();
+    Spheres spheres(frustum, 5000);
+
+    Graphics::VisibilitySystem system;
+    for (uint32_t i = 0; i < 5000; i++)
+    {
+        float center[3] = {spheres.x[i], spheres.y[i], spheres.z[i]};
+        VkDrawIndexedIndirectCommand draw{36, 1, 0, 0, i};
+        system.add(center, spheres.r[i], draw);
+    }
+    // Holes filled by moving the last objects in.
+    for (uint32_t i = 0; i < 5000; i += 7)
+        system.remove(i);
+
+    Jobs::JobSystem jobs;
+    jobs.init(4);
+
+    std::vector<uint32_t> reference;
+    VGE_CHECK(system.set_kernel(Graphics::CullKernel::Scalar) == Graphics::CullKernel::Scalar);
+    system.cull(frustum, reference);
+
+    for (Graphics::CullKernel kernel : {Graphics::CullKernel::Scalar, Graphics::CullKernel::SSE, Graphics::CullKernel::AVX2})
+    {
+        if (!Graphics::VisibilitySystem::is_kernel_supported(kernel))
+            continue;
+        VGE_CHECK(system.set_kernel(kernel) == kernel);
+
+        std::vector<uint32_t> visible;
+        system.cull(frustum, visible);
+        VGE_CHECK(visible == reference);
+
+        system.cull(frustum, visible, &jobs);
+        VGE_CHECK(visible == reference);
+
+        // Every draw written belongs to a visible, live object.
+        std::vector<VkDrawIndexedIndirectCommand> commands(system.size());
+        uint32_t draws = system.build_draws(frustum, commands.data(), static_cast<uint32_t>(commands.size()), visible, &jobs);
+        bool live = draws == reference.size();
+        for (uint32_t i = 0; i < draws; i++)
+            live &= commands[i].firstInstance % 7 != 0;
+        VGE_CHECK(live);
+    }
+
+    jobs.cleanup();
+}
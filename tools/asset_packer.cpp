@@ -0,0 +1,143 @@
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-07
+ *
+ * Packs every file under a directory into a single asset pack, keyed by the
+ * path relative to that directory ("textures/stone.ktx").
+ *
+ * Usage: asset_packer <directory> <output.vgep> [--codec none|lz4|zstd] [--chunk-size N] [--alignment N]
+ *        asset_packer --list <pack.vgep>
+ */
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <filesystem>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+
+#include "../src/core/assets/asset_pack.hpp"
+
+using namespace VulkanGameEngine;
+
+static void print_usage()
+{
+    printf("Usage: asset_packer <directory> <output.vgep> [--codec none|lz4|zstd] [--chunk-size N] [--alignment N]\n");
+    printf("       asset_packer --list <pack.vgep>\n");
+}
+
+static int list_pack(const std::string& path)
+{
+    Assets::AssetPack pack;
+    pack.open(path);
+
+    const Assets::PackHeader& header = pack.get_header();
+    printf("%s: %llu entries, chunk size %u, alignment %u, %llu bytes\n\n",
+        path.c_str(),
+        static_cast<unsigned long long>(header.entry_count),
+        header.chunk_size,
+        header.alignment,
+        static_cast<unsigned long long>(header.file_size));
+    printf("            size      stored  chunks  hash              name\n");
+
+    for (size_t i = 0; i < pack.entry_count(); i++)
+    {
+        const Assets::PackEntry& entry = pack.get_entry(i);
+        printf("%16llu %11llu  %6u  %016llx  %s\n",
+            static_cast<unsigned long long>(entry.size),
+            static_cast<unsigned long long>(entry.stored_size),
+            entry.chunk_count,
+            static_cast<unsigned long long>(entry.path_hash),
+            pack.get_name(entry).c_str());
+    }
+
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<std::string> positional;
+    Assets::Codec codec = Assets::Codec::LZ4;
+    uint32_t chunk_size = 64 * 1024;
+    uint32_t alignment = 4096;
+    bool list = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--codec") && i + 1 < argc)
+        {
+            std::string name = argv[++i];
+            if (name == "none")
+                codec = Assets::Codec::None;
+            else if (name == "lz4")
+                codec = Assets::Codec::LZ4;
+            else if (name == "zstd")
+                codec = Assets::Codec::Zstd;
+            else
+            {
+                print_usage();
+                return 1;
+            }
+        }
+        else if (!strcmp(argv[i], "--chunk-size") && i + 1 < argc)
+            chunk_size = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        else if (!strcmp(argv[i], "--alignment") && i + 1 < argc)
+            alignment = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        else if (!strcmp(argv[i], "--list"))
+            list = true;
+        else
+            positional.push_back(argv[i]);
+    }
+
+    try
+    {
+        if (list && positional.size() == 1)
+            return list_pack(positional[0]);
+
+        if (list || positional.size() != 2)
+        {
+            print_usage();
+            return 1;
+        }
+
+        std::filesystem::path root(positional[0]);
+        std::vector<std::filesystem::path> files;
+        for (const auto& item : std::filesystem::recursive_directory_iterator(root))
+            if (item.is_regular_file())
+                files.push_back(item.path());
+
+        // Sorted so the same directory always produces the same pack.
+        std::sort(files.begin(), files.end());
+
+        auto start = std::chrono::steady_clock::now();
+
+        Assets::AssetPackWriter writer;
+        for (const auto& file : files)
+            writer.add_file(file.lexically_relative(root).generic_string(), file.string());
+
+        writer.write(positional[1], codec, chunk_size, alignment);
+
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        const auto& statistics = writer.get_statistics();
+
+        printf("%llu files, %.2f MiB -> %.2f MiB (%s, %.1f%%), %llu chunks (%llu stored raw), %.1f ms\n",
+            static_cast<unsigned long long>(statistics.entries),
+            statistics.bytes / (1024.0 * 1024.0),
+            statistics.stored_bytes / (1024.0 * 1024.0),
+            Assets::codec_name(codec),
+            statistics.bytes ? 100.0 * statistics.stored_bytes / statistics.bytes : 100.0,
+            static_cast<unsigned long long>(statistics.chunks),
+            static_cast<unsigned long long>(statistics.raw_chunks),
+            ms);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
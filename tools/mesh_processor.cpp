@@ -0,0 +1,146 @@
+/**
+ * @author Simon Brisebois-Therrien
+ * @since 2021-10-09
+ *
+ * Optimizes a Wavefront OBJ mesh for the GPU and writes it as a .vgem file:
+ * triangles reordered for the post-transform cache and overdraw, vertices for
+ * fetch locality, attributes quantized, and meshlets with bounding cones.
+ * Prints the vertex cache, overdraw and fetch statistics before and after.
+ *
+ * Usage: mesh_processor <input.obj> <output.vgem> [--no-quantize] [--no-overdraw] [--cache-size N]
+ *                       [--meshlet-vertices N] [--meshlet-triangles N]
+ */
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+
+#include "../src/core/mesh/obj_loader.hpp"
+#include "../src/core/mesh/mesh_optimizer.hpp"
+#include "../src/core/mesh/processed_mesh.hpp"
+
+using namespace VulkanGameEngine;
+
+static void print_usage()
+{
+    printf("Usage: mesh_processor <input.obj> <output.vgem> [--no-quantize] [--no-overdraw] [--cache-size N]\n");
+    printf("                      [--meshlet-vertices N] [--meshlet-triangles N]\n");
+}
+
+static void print_statistics(const char* label, const std::vector<uint32_t>& indices, const std::vector<Mesh::Vertex>& vertices, size_t vertex_size, size_t index_size, uint32_t cache_size)
+{
+    Mesh::VertexCacheStatistics cache = Mesh::analyze_vertex_cache(indices, vertices.size(), cache_size);
+    Mesh::OverdrawStatistics overdraw = Mesh::analyze_overdraw(indices, vertices);
+    Mesh::VertexFetchStatistics fetch = Mesh::analyze_vertex_fetch(indices, vertices.size(), vertex_size);
+
+    printf("%-8s  %6.3f  %6.3f  %8.3f  %9.3f  %10.2f\n",
+        label,
+        cache.acmr,
+        cache.atvr,
+        overdraw.overdraw,
+        fetch.overfetch,
+        (vertices.size() * vertex_size + indices.size() * index_size) / 1024.0);
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<std::string> positional;
+    Mesh::ProcessOptions options;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--no-quantize"))
+            options.quantize = false;
+        else if (!strcmp(argv[i], "--no-overdraw"))
+            options.overdraw_threshold = 0.0f;
+        else if (!strcmp(argv[i], "--cache-size") && i + 1 < argc)
+            options.cache_size = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        else if (!strcmp(argv[i], "--meshlet-vertices") && i + 1 < argc)
+            options.meshlet_vertices = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        else if (!strcmp(argv[i], "--meshlet-triangles") && i + 1 < argc)
+            options.meshlet_triangles = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        else
+            positional.push_back(argv[i]);
+    }
+
+    if (positional.size() != 2 || options.cache_size == 0)
+    {
+        print_usage();
+        return 1;
+    }
+
+    try
+    {
+        Mesh::MeshData source = Mesh::load_obj(positional[0]);
+        printf("%s: %zu vertices, %zu triangles\n\n", positional[0].c_str(), source.vertices.size(), source.indices.size() / 3);
+
+        auto start = std::chrono::steady_clock::now();
+        Mesh::ProcessedMesh processed = Mesh::process_mesh(source, options);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        std::vector<Mesh::Vertex> unpacked = Mesh::unpack_vertices(processed);
+
+        printf("          ACMR    ATVR    overdraw  overfetch  size (KiB)\n");
+        print_statistics("input", source.indices, source.vertices, sizeof(Mesh::Vertex), sizeof(uint32_t), options.cache_size);
+        print_statistics("output", processed.indices, unpacked, processed.vertex_stride, processed.uses_16bit_indices() ? 2 : 4, options.cache_size);
+        printf("\n");
+
+        if (processed.quantized)
+        {
+            // The largest error each attribute picks up in the round trip.
+            std::vector<Mesh::QuantizedVertex> quantized = Mesh::quantize_vertices(source.vertices, processed.uv_transform);
+            double position_error = 0.0;
+            double normal_error = 0.0;
+            double uv_error = 0.0;
+            for (size_t i = 0; i < quantized.size(); i++)
+            {
+                const Mesh::Vertex& vertex = source.vertices[i];
+                Mesh::Vertex decoded = Mesh::dequantize_vertex(quantized[i], processed.uv_transform);
+                for (int k = 0; k < 3; k++)
+                    position_error = std::max(position_error, static_cast<double>(std::fabs(decoded.position[k] - vertex.position[k])));
+                for (int k = 0; k < 2; k++)
+                    uv_error = std::max(uv_error, static_cast<double>(std::fabs(decoded.uv[k] - vertex.uv[k])));
+                double dot = decoded.normal[0] * vertex.normal[0] + decoded.normal[1] * vertex.normal[1] + decoded.normal[2] * vertex.normal[2];
+                normal_error = std::max(normal_error, std::acos(std::max(-1.0, std::min(1.0, dot))) * 180.0 / 3.14159265358979);
+            }
+            printf("quantized to %u byte vertices (%.0f%% of float), max error: position %.3g, normal %.3g deg, uv %.3g\n",
+                processed.vertex_stride,
+                100.0 * processed.vertex_stride / sizeof(Mesh::Vertex),
+                position_error,
+                normal_error,
+                uv_error);
+        }
+
+        const Mesh::MeshletData& meshlets = processed.meshlets;
+        if (!meshlets.meshlets.empty())
+        {
+            size_t cullable = 0;
+            for (const Mesh::Meshlet& meshlet : meshlets.meshlets)
+                cullable += meshlet.cone_cutoff < 1.0f;
+
+            printf("%zu meshlets (max %u vertices, %u triangles): %.1f vertices, %.1f triangles on average, %zu with a usable cone\n",
+                meshlets.meshlets.size(),
+                options.meshlet_vertices,
+                options.meshlet_triangles,
+                static_cast<double>(meshlets.vertices.size()) / meshlets.meshlets.size(),
+                static_cast<double>(meshlets.triangles.size() / 3) / meshlets.meshlets.size(),
+                cullable);
+        }
+
+        Mesh::write_mesh_file(positional[1], processed);
+        printf("wrote %s (%s indices) in %.1f ms\n", positional[1].c_str(), processed.uses_16bit_indices() ? "16 bit" : "32 bit", ms);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}